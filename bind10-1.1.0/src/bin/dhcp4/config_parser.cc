@@ -15,11 +15,13 @@
 #include <config/ccsession.h>
 #include <dhcp4/config_parser.h>
 #include <dhcp4/dhcp4_log.h>
+#include <dhcp4/dhcp4_srv.h>
 #include <dhcp/libdhcp++.h>
 #include <dhcp/option_definition.h>
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dbaccess_parser.h>
 #include <dhcpsrv/dhcp_config_parser.h>
+#include <dhcpsrv/load_balancer.h>
 #include <dhcpsrv/option_space_container.h>
 #include <util/encode/hex.h>
 #include <util/strutil.h>
@@ -83,6 +85,32 @@ OptionStorage option_defaults;
 /// @brief Global storage for option definitions.
 OptionDefStorage option_def_intermediate;
 
+/// @brief Load balancing parameters, see LoadBalancingParser.
+struct LoadBalancingConfig {
+    /// @brief Constructor, the load balancing is disabled.
+    LoadBalancingConfig()
+        : enabled_(false), role_(LoadBalancer::PRIMARY),
+          local_addr_("0.0.0.0"), local_port_(0), peer_addr_("0.0.0.0"),
+          peer_port_(0) {
+    }
+
+    /// Is the server one of a load balancing pair.
+    bool enabled_;
+    /// Role of the server in the pair.
+    LoadBalancer::Role role_;
+    /// Address the peer connects to.
+    IOAddress local_addr_;
+    /// Port the peer connects to.
+    uint16_t local_port_;
+    /// Address of the peer.
+    IOAddress peer_addr_;
+    /// Port of the peer.
+    uint16_t peer_port_;
+};
+
+/// @brief Global load balancing parameters.
+LoadBalancingConfig load_balancing;
+
 /// @brief a dummy configuration parser
 ///
 /// It is a debugging parser. It does not configure anything,
@@ -442,6 +470,106 @@ private:
     vector<string> interfaces_;
 };
 
+/// @brief parser for the load balancing parameters
+///
+/// This parser handles the "load-balancing" map: the role of the server
+/// in the pair ("primary" or "secondary", empty to disable the load
+/// balancing) and the addresses and ports used to exchange the lease
+/// changes. The parameters are stored in load_balancing and passed to
+/// the server once the whole configuration has been parsed, as the lease
+/// database must be set up first.
+class LoadBalancingParser : public DhcpConfigParser {
+public:
+
+    /// @brief constructor
+    ///
+    /// @param param_name name of the configuration parameter being parsed
+    /// @throw BadValue if supplied parameter name is not "load-balancing"
+    LoadBalancingParser(const std::string& param_name) {
+        if (param_name != "load-balancing") {
+            isc_throw(isc::BadValue, "Internal error. Load balancing "
+                      "configuration parser called for the wrong parameter: "
+                      << param_name);
+        }
+    }
+
+    /// @brief parses the load balancing parameters
+    ///
+    /// @param value pointer to the content of parsed values
+    /// @throw DhcpConfigError if a parameter is missing or invalid
+    virtual void build(ConstElementPtr value) {
+        const std::string role = getString(value, "role");
+        if (role.empty()) {
+            config_ = LoadBalancingConfig();
+            return;
+        }
+        try {
+            config_.role_ = LoadBalancer::roleFromText(role);
+        } catch (const isc::BadValue& ex) {
+            isc_throw(DhcpConfigError, ex.what());
+        }
+        config_.local_addr_ = getAddress(value, "local-address");
+        config_.local_port_ = getPort(value, "local-port");
+        config_.peer_addr_ = getAddress(value, "peer-address");
+        config_.peer_port_ = getPort(value, "peer-port");
+        if ((config_.local_addr_ == config_.peer_addr_) &&
+            (config_.local_port_ == config_.peer_port_)) {
+            isc_throw(DhcpConfigError, "load balancing peer address and port"
+                      " must differ from the local ones");
+        }
+        config_.enabled_ = true;
+    }
+
+    /// @brief stores the load balancing parameters
+    virtual void commit() {
+        load_balancing = config_;
+    }
+
+    /// @brief factory that constructs LoadBalancingParser objects
+    ///
+    /// @param param_name name of the parameter to be parsed
+    static DhcpConfigParser* factory(const std::string& param_name) {
+        return (new LoadBalancingParser(param_name));
+    }
+
+private:
+    /// @brief returns a string parameter, empty if it is not set
+    static std::string getString(ConstElementPtr value,
+                                 const std::string& name) {
+        ConstElementPtr param = value->get(name);
+        return (param ? param->stringValue() : std::string());
+    }
+
+    /// @brief returns an IPv4 address parameter
+    static IOAddress getAddress(ConstElementPtr value,
+                                const std::string& name) {
+        const std::string text = getString(value, name);
+        try {
+            IOAddress addr(text);
+            if (addr.isV4()) {
+                return (addr);
+            }
+        } catch (const isc::Exception&) {
+        }
+        isc_throw(DhcpConfigError, "invalid load balancing " << name
+                  << " '" << text << "', expected an IPv4 address");
+    }
+
+    /// @brief returns a port parameter
+    static uint16_t getPort(ConstElementPtr value, const std::string& name) {
+        ConstElementPtr param = value->get(name);
+        const int64_t port = param ? param->intValue() : 0;
+        if ((port <= 0) || (port > 65535)) {
+            isc_throw(DhcpConfigError, "invalid load balancing " << name
+                      << " " << port);
+        }
+        return (static_cast<uint16_t>(port));
+    }
+
+    /// parsed parameters
+    LoadBalancingConfig config_;
+};
+
 /// @brief parser for pool definition
 ///
 /// This parser handles pool definitions, i.e. a list of entries of one
@@ -860,8 +988,10 @@ private:
             // an instance of our option.
             try {
                 OptionPtr option = csv_format ?
-                    def->optionFactory(Option::V4, option_code, data_tokens) :
-                    def->optionFactory(Option::V4, option_code, binary);
+                    def->optionFactory(Option::V4, option_code, data_tokens,
+                                      option_space) :
+                    def->optionFactory(Option::V4, option_code, binary,
+                                      option_space);
                 Subnet::OptionDescriptor desc(option, false);
                 option_descriptor_.option = option;
                 option_descriptor_.persistent = false;
@@ -1252,11 +1382,22 @@ class Subnet4ConfigParser : public DhcpConfigParser {
 public:
 
     /// @brief constructor
-    Subnet4ConfigParser(const std::string& ) {
+    Subnet4ConfigParser(const std::string& )
+        : storage_(NULL) {
         // The parameter should always be "subnet", but we don't check here
         // against it in case someone wants to reuse this parser somewhere.
     }
 
+    /// @brief Sets the storage for the created subnet.
+    ///
+    /// If the storage is set, the subnet is committed to it rather than
+    /// added to the CfgMgr.
+    ///
+    /// @param storage pointer to the storage for the subnet.
+    void setStorage(Subnet4Collection* storage) {
+        storage_ = storage;
+    }
+
     /// @brief parses parameter value
     ///
     /// @param subnet pointer to the content of subnet definition
@@ -1309,11 +1450,16 @@ public:
     /// This method does most of the configuration. Many other parsers are just
     /// storing the values that are actually consumed here. Pool definitions
     /// created in other parsers are used here and added to newly created Subnet4
-    /// objects. Subnet4 are then added to DHCP CfgMgr.
+    /// objects. Subnet4 are then added to the storage, if set, or to DHCP
+    /// CfgMgr.
     /// @throw DhcpConfigError if there are any issues encountered during commit
     void commit() {
         if (subnet_) {
-            CfgMgr::instance().addSubnet4(subnet_);
+            if (storage_) {
+                storage_->push_back(subnet_);
+            } else {
+                CfgMgr::instance().addSubnet4(subnet_);
+            }
         }
     }
 
@@ -1599,6 +1745,9 @@ private:
 
     /// @brief Pointer to the created subnet object.
     isc::dhcp::Subnet4Ptr subnet_;
+
+    /// @brief Storage for the created subnet, if not the CfgMgr.
+    Subnet4Collection* storage_;
 };
 
 /// @brief this class parses list of subnets
@@ -1627,28 +1776,29 @@ public:
         // used: Subnet4ConfigParser
 
         BOOST_FOREACH(ConstElementPtr subnet, subnets_list->listValue()) {
-            ParserPtr parser(new Subnet4ConfigParser("subnet"));
+            boost::shared_ptr<Subnet4ConfigParser>
+                parser(new Subnet4ConfigParser("subnet"));
+            parser->setStorage(&subnets_storage_);
             parser->build(subnet);
             subnets_.push_back(parser);
         }
 
+        // The subnet parsers write into the storage of this parser only,
+        // so the new subnets are collected here, and the commit has only
+        // to install them.
+        BOOST_FOREACH(ParserPtr parser, subnets_) {
+            parser->commit();
+        }
+        new_subnets_ = CfgMgr::instance().buildSubnets4(subnets_storage_);
     }
 
     /// @brief commits subnets definitions.
     ///
-    /// Iterates over all Subnet4 parsers. Each parser contains definitions
-    /// of a single subnet and its parameters and commits each subnet separately.
+    /// Installs the subnets built by @ref build in the CfgMgr at once. The
+    /// subnets which have not changed keep their IDs and the leases
+    /// allocated in them.
     void commit() {
-        // @todo: Implement more subtle reconfiguration than toss
-        // the old one and replace with the new one.
-
-        // remove old subnets
-        CfgMgr::instance().deleteSubnets4();
-
-        BOOST_FOREACH(ParserPtr subnet, subnets_) {
-            subnet->commit();
-        }
-
+        CfgMgr::instance().replaceSubnets4(new_subnets_);
     }
 
     /// @brief Returns Subnet4ListConfigParser object
@@ -1661,6 +1811,11 @@ public:
     /// @brief collection of subnet parsers.
     ParserCollection subnets_;
 
+    /// @brief subnets created by the subnet parsers.
+    Subnet4Collection subnets_storage_;
+
+    /// @brief subnets to be installed by the commit.
+    ConstSubnet4CollectionPtr new_subnets_;
 };
 
 } // anonymous namespace
@@ -1682,12 +1837,17 @@ DhcpConfigParser* createGlobalDhcp4ConfigParser(const std::string& config_id) {
     factories["valid-lifetime"] = Uint32Parser::factory;
     factories["renew-timer"] = Uint32Parser::factory;
     factories["rebind-timer"] = Uint32Parser::factory;
+    factories["response-cache-window"] = Uint32Parser::factory;
+    factories["rate-limit"] = Uint32Parser::factory;
+    factories["rate-limit-burst"] = Uint32Parser::factory;
+    factories["shed-delay"] = Uint32Parser::factory;
     factories["interface"] = InterfaceListConfigParser::factory;
     factories["subnet4"] = Subnets4ListConfigParser::factory;
     factories["option-data"] = OptionDataListParser::factory;
     factories["option-def"] = OptionDefListParser::factory;
     factories["version"] = StringParser::factory;
     factories["lease-database"] = DbAccessParser::factory;
+    factories["load-balancing"] = LoadBalancingParser::factory;
 
     FactoryMap::iterator f = factories.find(config_id);
     if (f == factories.end()) {
@@ -1702,7 +1862,7 @@ DhcpConfigParser* createGlobalDhcp4ConfigParser(const std::string& config_id) {
 }
 
 isc::data::ConstElementPtr
-configureDhcp4Server(Dhcpv4Srv&, ConstElementPtr config_set) {
+configureDhcp4Server(Dhcpv4Srv& server, ConstElementPtr config_set) {
     if (!config_set) {
         ConstElementPtr answer = isc::config::createAnswer(1,
                                  string("Can't parse NULL config"));
@@ -1736,6 +1896,7 @@ configureDhcp4Server(Dhcpv4Srv&, ConstElementPtr config_set) {
     StringStorage string_local(string_defaults);
     OptionStorage option_local(option_defaults);
     OptionDefStorage option_def_local(option_def_intermediate);
+    LoadBalancingConfig load_balancing_local(load_balancing);
 
     // answer will hold the result.
     ConstElementPtr answer;
@@ -1838,9 +1999,54 @@ configureDhcp4Server(Dhcpv4Srv&, ConstElementPtr config_set) {
         std::swap(string_defaults, string_local);
         std::swap(option_defaults, option_local);
         std::swap(option_def_intermediate, option_def_local);
+        std::swap(load_balancing, load_balancing_local);
         return (answer);
     }
 
+    // The response cache is owned by the server, not the CfgMgr. It is
+    // disabled when the window is no longer configured and, like the
+    // lease database, emptied by every reconfiguration.
+    server.setResponseCacheWindow(config_set->contains("response-cache-window") ?
+                                  uint32_defaults.
+                                  getParam("response-cache-window") : 0);
+
+    // And so is the dropping of queries when the server is overloaded.
+    if (config_set->contains("rate-limit") ||
+        config_set->contains("rate-limit-burst")) {
+        const uint32_t rate = config_set->contains("rate-limit") ?
+            uint32_defaults.getParam("rate-limit") : 0;
+        const uint32_t burst = config_set->contains("rate-limit-burst") ?
+            uint32_defaults.getParam("rate-limit-burst") : 0;
+        server.getRateLimiter().setRate(rate, burst);
+    }
+    if (config_set->contains("shed-delay")) {
+        server.getRateLimiter().setShedDelay(uint32_defaults.
+                                             getParam("shed-delay"));
+    }
+
+    // The changes of the peer are applied to the lease database, so the
+    // lease synchronization is restarted when the database is replaced.
+    if (config_set->contains("load-balancing") ||
+        (config_set->contains("lease-database") && load_balancing.enabled_)) {
+        if (!load_balancing.enabled_) {
+            server.disableLoadBalancing();
+        } else {
+            try {
+                server.configureLoadBalancing(load_balancing.role_,
+                                              load_balancing.local_addr_,
+                                              load_balancing.local_port_,
+                                              load_balancing.peer_addr_,
+                                              load_balancing.peer_port_);
+            } catch (const isc::Exception& ex) {
+                LOG_ERROR(dhcp4_logger, DHCP4_PARSER_COMMIT_FAIL)
+                    .arg(ex.what());
+                return (isc::config::createAnswer(2,
+                            string("Load balancing setup failed: ") +
+                            ex.what()));
+            }
+        }
+    }
+
     LOG_INFO(dhcp4_logger, DHCP4_CONFIG_COMPLETE).arg(config_details);
 
     // Everything was fine. Configuration is successful.
@@ -1848,6 +2054,94 @@ configureDhcp4Server(Dhcpv4Srv&, ConstElementPtr config_set) {
     return (answer);
 }
 
+ConstElementPtr
+configureDhcp4Subnet(const std::string& command, ConstElementPtr args) {
+    LOG_DEBUG(dhcp4_logger, DBG_DHCP4_COMMAND, DHCP4_CONFIG_SUBNET_START)
+        .arg(command).arg(args ? args->str() : "");
+
+    std::string subnet_txt;
+    try {
+        if (!args || (args->getType() != Element::map) ||
+            !args->contains("subnet")) {
+            isc_throw(DhcpConfigError, "mandatory subnet argument missing");
+        }
+        ConstElementPtr subnet_config = args->get("subnet");
+
+        if (command == "subnet4-del") {
+            subnet_txt = subnet_config->stringValue();
+            boost::erase_all(subnet_txt, " ");
+            boost::erase_all(subnet_txt, "\t");
+            size_t pos = subnet_txt.find("/");
+            if (pos == string::npos) {
+                isc_throw(DhcpConfigError, "Invalid subnet syntax"
+                          " (prefix/len expected):" << subnet_txt);
+            }
+            IOAddress addr(subnet_txt.substr(0, pos));
+            const unsigned int len =
+                boost::lexical_cast<unsigned int>(subnet_txt.substr(pos + 1));
+            if (len > 32) {
+                isc_throw(DhcpConfigError, "Invalid prefix length " << len
+                          << " of subnet " << subnet_txt);
+            }
+            if (!CfgMgr::instance().deleteSubnet4(addr, len)) {
+                isc_throw(DhcpConfigError, "subnet " << subnet_txt
+                          << " does not exist");
+            }
+
+        } else if ((command == "subnet4-add") ||
+                   (command == "subnet4-update")) {
+            // The parser stores the subnet in a local collection, so
+            // nothing is changed if the definition is invalid.
+            Subnet4Collection subnets;
+            Subnet4ConfigParser parser("subnet");
+            parser.setStorage(&subnets);
+            parser.build(subnet_config);
+            parser.commit();
+            if (subnets.empty()) {
+                isc_throw(DhcpConfigError, "no subnet defined");
+            }
+            const Subnet4Ptr& subnet = subnets.front();
+            subnet_txt = subnet->toText();
+
+            if (command == "subnet4-update") {
+                if (!CfgMgr::instance().updateSubnet4(subnet)) {
+                    isc_throw(DhcpConfigError, "subnet " << subnet_txt
+                              << " does not exist");
+                }
+            } else {
+                const std::pair<IOAddress, uint8_t> prefix = subnet->get();
+                if (CfgMgr::instance().getSubnet4ByPrefix(prefix.first,
+                                                         prefix.second)) {
+                    isc_throw(DhcpConfigError, "subnet " << subnet_txt
+                              << " already exists");
+                }
+                CfgMgr::instance().addSubnet4(subnet);
+            }
+
+        } else {
+            isc_throw(DhcpConfigError, "unrecognized command");
+        }
+
+    } catch (const isc::Exception& ex) {
+        LOG_ERROR(dhcp4_logger, DHCP4_CONFIG_SUBNET_FAIL)
+            .arg(command).arg(ex.what());
+        return (isc::config::createAnswer(1, string("Subnet ") + command +
+                                          " failed: " + ex.what()));
+
+    } catch (...) {
+        // for things like bad_cast in boost::lexical_cast
+        LOG_ERROR(dhcp4_logger, DHCP4_CONFIG_SUBNET_FAIL)
+            .arg(command).arg("invalid value");
+        return (isc::config::createAnswer(1, string("Subnet ") + command +
+                                          " failed"));
+    }
+
+    LOG_INFO(dhcp4_logger, DHCP4_CONFIG_SUBNET_COMPLETE)
+        .arg(command).arg(subnet_txt);
+    return (isc::config::createAnswer(0, "Subnet " + subnet_txt +
+                                      " changed."));
+}
+
 const Uint32Storage& getUint32Defaults() {
     return (uint32_defaults);
 }
@@ -60,6 +60,33 @@ configureDhcp4Server(Dhcpv4Srv&,
                      isc::data::ConstElementPtr config_set);
 
 
+/// @brief Adds, updates or removes a single DHCPv4 subnet.
+///
+/// This function handles the subnet4-add, subnet4-update and
+/// subnet4-del commands, which change one subnet of the running server
+/// without resubmitting the whole subnet4 list. The subnet4-add and
+/// subnet4-update commands take the definition of the subnet, in the
+/// format of an element of the subnet4 list, as the "subnet" argument.
+/// The parameters not specified in the definition are taken from the
+/// current global configuration. An updated subnet keeps its ID and its
+/// address allocation state. The subnet4-del command takes the prefix of
+/// the subnet (e.g. "192.0.2.0/24") as the "subnet" argument.
+///
+/// The changes are only applied to the @c CfgMgr. They are not stored in
+/// the configuration of the server, so the next commit of the subnet4
+/// list replaces them.
+///
+/// This function does not throw. It returns the following response codes:
+/// 0 - the subnet has been changed
+/// 1 - the command failed and the subnets are intact
+///
+/// @param command name of the command.
+/// @param args arguments of the command.
+/// @return answer that contains the result of the command
+isc::data::ConstElementPtr
+configureDhcp4Subnet(const std::string& command,
+                     isc::data::ConstElementPtr args);
+
 /// @brief Returns the global uint32_t values storage.
 ///
 /// This function must be only used by unit tests that need
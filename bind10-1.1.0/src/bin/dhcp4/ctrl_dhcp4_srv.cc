@@ -19,6 +19,7 @@
 #include <cc/session.h>
 #include <config/ccsession.h>
 #include <dhcp/iface_mgr.h>
+#include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dhcp_config_parser.h>
 #include <dhcp4/ctrl_dhcp4_srv.h>
 #include <dhcp4/dhcp4_log.h>
@@ -123,6 +124,49 @@ ControlledDhcpv4Srv::dhcp4CommandHandler(const string& command, ConstElementPtr
         return (answer);
     }
 
+    if ((command == "getstats") || (command.find("stage-timing-") == 0)) {
+        if (!ControlledDhcpv4Srv::server_) {
+            LOG_WARN(dhcp4_logger, DHCP4_NOT_RUNNING);
+            return (isc::config::createAnswer(1, "Server is not running."));
+        }
+        StageProfiler& profiler =
+            ControlledDhcpv4Srv::server_->getStageProfiler();
+        if (command == "stage-timing-start") {
+            profiler.reset();
+            profiler.setEnabled(true);
+            return (isc::config::createAnswer(0, "Stage timing started."));
+        } else if (command == "stage-timing-stop") {
+            profiler.setEnabled(false);
+            return (isc::config::createAnswer(0, "Stage timing stopped."));
+        } else if ((command == "getstats") ||
+                   (command == "stage-timing-dump")) {
+            ElementPtr stats = Element::createMap();
+            if (command == "getstats") {
+                // Counters and pool sizes are reported to b10-stats only.
+                stats = ControlledDhcpv4Srv::server_->getServerCounters().
+                    toElement(&Dhcpv4Srv::serverReceivedPacketName);
+                const ConstSubnet4CollectionPtr subnets =
+                    CfgMgr::instance().getSubnets4();
+                for (Subnet4Collection::const_iterator subnet =
+                         subnets->begin(); subnet != subnets->end();
+                     ++subnet) {
+                    ServerCounters::addPoolUsage(stats, **subnet);
+                }
+            }
+            stats->set("stage-timing", profiler.toElement(&Dhcpv4Srv::serverReceivedPacketName));
+            if (args && (args->getType() == Element::map) &&
+                args->contains("reset") && args->get("reset")->boolValue()) {
+                profiler.reset();
+            }
+            return (isc::config::createAnswer(0, stats));
+        }
+    }
+
+    if ((command == "subnet4-add") || (command == "subnet4-update") ||
+        (command == "subnet4-del")) {
+        return (configureDhcp4Subnet(command, args));
+    }
+
     ConstElementPtr answer = isc::config::createAnswer(1,
                              "Unrecognized command.");
 
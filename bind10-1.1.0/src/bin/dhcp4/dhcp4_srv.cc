@@ -16,6 +16,7 @@
 #include <dhcp/dhcp4.h>
 #include <dhcp/iface_mgr.h>
 #include <dhcp/option4_addrlst.h>
+#include <dhcp/option_fixed.h>
 #include <dhcp/option_int.h>
 #include <dhcp/option_int_array.h>
 #include <dhcp/pkt4.h>
@@ -33,6 +34,7 @@
 
 #include <boost/algorithm/string/erase.hpp>
 
+#include <algorithm>
 #include <iomanip>
 #include <fstream>
 
@@ -54,6 +56,31 @@ namespace dhcp {
 /// first run and then use it afterwards.
 static const char* SERVER_ID_FILE = "b10-dhcp4-serverid";
 
+/// @brief Logs the interface changes found by IfaceMgr.
+///
+/// @param name name of the interface.
+/// @param change what happened to the interface.
+/// @param error why the sockets couldn't be opened, empty if they could.
+static void
+logIfaceChange(const string& name, IfaceMgr::IfaceChange change,
+               const string& error) {
+    if (!error.empty()) {
+        LOG_WARN(dhcp4_logger, DHCP4_IFACE_SOCKETS_FAIL).arg(name).arg(error);
+        return;
+    }
+    switch (change) {
+    case IfaceMgr::IFACE_ADDED:
+        LOG_INFO(dhcp4_logger, DHCP4_IFACE_ADDED).arg(name);
+        break;
+    case IfaceMgr::IFACE_CHANGED:
+        LOG_INFO(dhcp4_logger, DHCP4_IFACE_CHANGED).arg(name);
+        break;
+    case IfaceMgr::IFACE_REMOVED:
+        LOG_INFO(dhcp4_logger, DHCP4_IFACE_REMOVED).arg(name);
+        break;
+    }
+}
+
 // These are hardcoded parameters. Currently this is a skeleton server that only
 // grants those options and a single, fixed, hardcoded lease.
 
@@ -68,6 +95,15 @@ Dhcpv4Srv::Dhcpv4Srv(uint16_t port, const char* dbconfig, const bool use_bcast)
             // open sockets only if port is non-zero. Port 0 is used
             // for non-socket related testing.
             IfaceMgr::instance().openSockets4(port, use_bcast);
+
+            // Follow the interfaces coming and going, the server runs
+            // without it if the system doesn't tell.
+            try {
+                IfaceMgr::instance().startIfaceTracking(logIfaceChange);
+            } catch (const std::exception& ex) {
+                LOG_WARN(dhcp4_logger, DHCP4_IFACE_TRACKING_FAIL)
+                    .arg(ex.what());
+            }
         }
 
         string srvid_file = CfgMgr::instance().getDataDir() + "/" + string(SERVER_ID_FILE);
@@ -104,9 +140,11 @@ Dhcpv4Srv::Dhcpv4Srv(uint16_t port, const char* dbconfig, const bool use_bcast)
     }
 
     shutdown_ = false;
+    next_query_ = 0;
 }
 
 Dhcpv4Srv::~Dhcpv4Srv() {
+    IfaceMgr::instance().stopIfaceTracking();
     IfaceMgr::instance().closeSockets();
 }
 
@@ -116,23 +154,109 @@ Dhcpv4Srv::shutdown() {
     shutdown_ = true;
 }
 
+Pkt4Ptr
+Dhcpv4Srv::receivePacket(int timeout) {
+    if (next_query_ == queries_.size()) {
+        queries_.clear();
+        next_query_ = 0;
+        if (IfaceMgr::instance().receiveBatch4(queries_, timeout) == 0) {
+            return (Pkt4Ptr());
+        }
+    }
+    Pkt4Ptr query = queries_[next_query_];
+    queries_[next_query_++].reset();
+    return (query);
+}
+
+void
+Dhcpv4Srv::sendPackets(const Pkt4Collection& packets, size_t& sent) {
+    IfaceMgr::instance().sendBatch(packets, sent);
+}
+
+void
+Dhcpv4Srv::sendResponses() {
+    if (responses_.empty()) {
+        return;
+    }
+
+    {
+        // A batch mixes the message types: its sending time is recorded
+        // with the type 0.
+        StageProfiler::Timer timer(profiler_, 0, StageProfiler::SEND);
+        while (!responses_.empty()) {
+            size_t sent = 0;
+            size_t dropped = 0;
+            try {
+                sendPackets(responses_, sent);
+            } catch (const std::exception& e) {
+                LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL).arg(e.what());
+                counters_.inc(ServerCounters::SEND_FAILED);
+                dropped = 1;
+            }
+            sent = std::min(sent, responses_.size());
+            for (size_t i = 0; i < sent; ++i) {
+                counters_.incSent(responses_[i]->getType());
+            }
+            dropped = std::min(dropped, responses_.size() - sent);
+            if (sent + dropped == 0) {
+                break;
+            }
+            removeResponses(sent, dropped);
+        }
+        removeResponses(0, responses_.size());
+    }
+
+    for (Pkt4Collection::const_iterator rsp = pooled_responses_.begin();
+         rsp != pooled_responses_.end(); ++rsp) {
+        buffer_pool_.release(**rsp);
+    }
+    pooled_responses_.clear();
+}
+
+void
+Dhcpv4Srv::removeResponses(size_t sent, size_t dropped) {
+    for (size_t i = 0; i < sent + dropped; ++i) {
+        const Pkt4Ptr& query = response_queries_[i];
+        // Only the responses which have reached the client are cached:
+        // a retransmission of the query must be processed again if the
+        // response was lost here. A cached response keeps its buffer
+        // until it expires.
+        if (query && ((i >= sent) ||
+                      !response_cache_.insert(*query, responses_[i]))) {
+            pooled_responses_.push_back(responses_[i]);
+        }
+    }
+    responses_.erase(responses_.begin(), responses_.begin() + sent + dropped);
+    response_queries_.erase(response_queries_.begin(),
+                            response_queries_.begin() + sent + dropped);
+}
+
 bool
 Dhcpv4Srv::run() {
     while (!shutdown_) {
-        /// @todo: calculate actual timeout once we have lease database
+        // The interface manager ends the wait earlier when one of its
+        // timers is due (see IfaceMgr::getTimerMgr).
         int timeout = 1000;
 
         // client's message and server's response
         Pkt4Ptr query;
         Pkt4Ptr rsp;
 
+        // The responses to the queries received together are sent
+        // together, before waiting for more queries.
+        if (next_query_ == queries_.size()) {
+            sendResponses();
+        }
+
+        const StageProfiler::Mark wait_mark = profiler_.mark();
         try {
-            query = IfaceMgr::instance().receive4(timeout);
+            query = receivePacket(timeout);
         } catch (const std::exception& e) {
             LOG_ERROR(dhcp4_logger, DHCP4_PACKET_RECEIVE_FAIL).arg(e.what());
         }
 
         if (query) {
+            const StageProfiler::Mark unpack_mark = profiler_.mark();
             try {
                 query->unpack();
 
@@ -140,8 +264,14 @@ Dhcpv4Srv::run() {
                 // Failed to parse the packet.
                 LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
                           DHCP4_PACKET_PARSE_FAIL).arg(e.what());
+                counters_.inc(ServerCounters::PARSE_FAILED);
                 continue;
             }
+            const uint8_t msg_type = query->getType();
+            counters_.incReceived(msg_type);
+            profiler_.record(msg_type, StageProfiler::RECEIVE_WAIT, wait_mark,
+                             unpack_mark);
+            profiler_.record(msg_type, StageProfiler::UNPACK, unpack_mark);
             LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_PACKET_RECEIVED)
                       .arg(serverReceivedPacketName(query->getType()))
                       .arg(query->getType())
@@ -149,8 +279,36 @@ Dhcpv4Srv::run() {
             LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA, DHCP4_QUERY_DATA)
                       .arg(query->toText());
 
+            // If this is a retransmission of a query which has been
+            // answered recently, send the same response again.
+            Pkt4Ptr cached = response_cache_.lookup(*query);
+            if (cached) {
+                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
+                          DHCP4_RESPONSE_CACHE_HIT)
+                          .arg(serverReceivedPacketName(query->getType()))
+                          .arg(query->getTransid())
+                          .arg(query->getIface());
+                responses_.push_back(cached);
+                response_queries_.push_back(Pkt4Ptr());
+                continue;
+            }
+
+            if (!inLoadBalancingScope(*query)) {
+                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
+                          DHCP4_LOAD_BALANCING_SKIP)
+                          .arg(serverReceivedPacketName(msg_type))
+                          .arg(query->getTransid())
+                          .arg(query->getIface());
+                counters_.inc(ServerCounters::LB_NOT_IN_SCOPE);
+                continue;
+            }
+
+            if (!admitQuery(query)) {
+                continue;
+            }
+
             try {
-                switch (query->getType()) {
+                switch (msg_type) {
                 case DHCPDISCOVER:
                     rsp = processDiscover(query);
                     break;
@@ -186,6 +344,7 @@ Dhcpv4Srv::run() {
                 // as a debug message because debug is disabled by default -
                 // it prevents a DDOS attack based on the sending of problem
                 // packets.)
+                counters_.inc(ServerCounters::PROCESS_FAILED);
                 if (dhcp4_logger.isDebugEnabled(DBG_DHCP4_BASIC)) {
                     std::string source = "unknown";
                     HWAddrPtr hwptr = query->getHWAddr();
@@ -220,19 +379,25 @@ Dhcpv4Srv::run() {
                           DHCP4_RESPONSE_DATA)
                           .arg(rsp->getType()).arg(rsp->toText());
 
-                if (rsp->pack()) {
-                    try {
-                        IfaceMgr::instance().send(rsp);
-                    } catch (const std::exception& e) {
-                        LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL).arg(e.what());
-                    }
+                // Pack the response into a pre-allocated buffer and give
+                // the buffer back to the pool once the response is sent.
+                buffer_pool_.acquire(*rsp);
+                const StageProfiler::Mark pack_mark = profiler_.mark();
+                const bool packed = rsp->pack();
+                profiler_.record(msg_type, StageProfiler::PACK, pack_mark);
+                if (packed) {
+                    responses_.push_back(rsp);
+                    response_queries_.push_back(query);
                 } else {
                     LOG_ERROR(dhcp4_logger, DHCP4_PACK_FAIL);
+                    buffer_pool_.release(*rsp);
                 }
             }
         }
     }
 
+    sendResponses();
+
     return (true);
 }
 
@@ -474,6 +639,7 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
         LOG_ERROR(dhcp4_logger, DHCP4_SUBNET_SELECTION_FAILED)
             .arg(question->getRemoteAddr().toText())
             .arg(serverReceivedPacketName(question->getType()));
+        counters_.inc(ServerCounters::NO_SUBNET);
         answer->setType(DHCPNAK);
         answer->setYiaddr(IOAddress("0.0.0.0"));
         return;
@@ -481,6 +647,7 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
 
     LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA, DHCP4_SUBNET_SELECTED)
         .arg(subnet->toText());
+    counters_.incSubnet(subnet->getID(), ServerCounters::SUBNET_RECEIVED);
 
     // Get client-id option
     ClientIdPtr client_id;
@@ -506,8 +673,11 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
     // will try to honour the hint, but it is just a hint - some other address
     // may be used instead. If fake_allocation is set to false, the lease will
     // be inserted into the LeaseMgr as well.
+    const StageProfiler::Mark lease_mark = profiler_.mark();
     Lease4Ptr lease = alloc_engine_->allocateAddress4(subnet, client_id, hwaddr,
                                                       hint, fake_allocation);
+    profiler_.record(fake_allocation ? DHCPDISCOVER : DHCPREQUEST,
+                     StageProfiler::LEASE_BACKEND, lease_mark);
 
     if (lease) {
         // We have a lease! Let's set it in the packet and send it back to
@@ -517,6 +687,13 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
             .arg(lease->addr_.toText())
             .arg(client_id?client_id->toText():"(no client-id)")
             .arg(hwaddr?hwaddr->toText():"(no hwaddr info)");
+        if (!fake_allocation) {
+            counters_.incSubnet(subnet->getID(),
+                                ServerCounters::SUBNET_ALLOCATED);
+            if (lease_sync_) {
+                lease_sync_->leaseUpdated(*lease);
+            }
+        }
 
         answer->setYiaddr(lease->addr_);
 
@@ -543,8 +720,7 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
         }
 
         // IP Address Lease time (type 51)
-        opt = OptionPtr(new Option(Option::V4, DHO_DHCP_LEASE_TIME));
-        opt->setUint32(lease->valid_lft_);
+        opt = OptionPtr(new Option4LeaseTime(lease->valid_lft_));
         answer->addOption(opt);
 
         // Router (type 3)
@@ -570,6 +746,9 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
             .arg(client_id?client_id->toText():"(no client-id)")
             .arg(hwaddr?hwaddr->toText():"(no hwaddr info)")
             .arg(hint.toText());
+        counters_.inc(ServerCounters::ALLOC_FAILED);
+        counters_.incSubnet(subnet->getID(),
+                            ServerCounters::SUBNET_ALLOC_FAILED);
 
         answer->setType(DHCPNAK);
         answer->setYiaddr(IOAddress("0.0.0.0"));
@@ -580,8 +759,7 @@ OptionPtr
 Dhcpv4Srv::getNetmaskOption(const Subnet4Ptr& subnet) {
     uint32_t netmask = getNetmask4(subnet->get().second);
 
-    OptionPtr opt(new OptionInt<uint32_t>(Option::V4,
-                  DHO_SUBNET_MASK, netmask));
+    OptionPtr opt(new Option4SubnetMask(netmask));
 
     return (opt);
 }
@@ -636,7 +814,10 @@ Dhcpv4Srv::processRelease(Pkt4Ptr& release) {
 
     try {
         // Do we have a lease for that particular address?
+        const StageProfiler::Mark lease_mark = profiler_.mark();
         Lease4Ptr lease = LeaseMgrFactory::instance().getLease4(release->getYiaddr());
+        profiler_.record(DHCPRELEASE, StageProfiler::LEASE_BACKEND,
+                         lease_mark);
 
         if (!lease) {
             // No such lease - bogus release
@@ -669,13 +850,23 @@ Dhcpv4Srv::processRelease(Pkt4Ptr& release) {
         }
 
         // Ok, hw and client-id match - let's release the lease.
-        if (LeaseMgrFactory::instance().deleteLease(lease->addr_)) {
+        const StageProfiler::Mark delete_mark = profiler_.mark();
+        const bool deleted =
+            LeaseMgrFactory::instance().deleteLease(lease->addr_);
+        profiler_.record(DHCPRELEASE, StageProfiler::LEASE_BACKEND,
+                         delete_mark);
+        if (deleted) {
 
             // Release successful - we're done here
             LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_RELEASE)
                 .arg(lease->addr_.toText())
                 .arg(client_id ? client_id->toText() : "(no client-id)")
                 .arg(release->getHWAddr()->toText());
+            counters_.incSubnet(lease->subnet_id_,
+                                ServerCounters::SUBNET_RELEASED);
+            if (lease_sync_) {
+                lease_sync_->leaseDeleted(lease->addr_);
+            }
         } else {
 
             // Release failed -
@@ -704,6 +895,78 @@ Dhcpv4Srv::processInform(Pkt4Ptr& inform) {
     return (inform);
 }
 
+void
+Dhcpv4Srv::configureLoadBalancing(LoadBalancer::Role role,
+                                  const IOAddress& local_addr,
+                                  uint16_t local_port,
+                                  const IOAddress& peer_addr,
+                                  uint16_t peer_port) {
+    // The previous synchronization releases its port first.
+    load_balancer_.reset();
+    lease_sync_.reset();
+    lease_sync_.reset(new LeaseSync(LeaseMgrFactory::instance(), local_addr,
+                                    local_port, peer_addr, peer_port));
+    load_balancer_.reset(new LoadBalancer(role));
+    LOG_INFO(dhcp4_logger, DHCP4_LOAD_BALANCING_ENABLED)
+        .arg(role == LoadBalancer::PRIMARY ? "primary" : "secondary")
+        .arg(peer_addr.toText()).arg(peer_port);
+}
+
+void
+Dhcpv4Srv::disableLoadBalancing() {
+    if (load_balancer_) {
+        LOG_INFO(dhcp4_logger, DHCP4_LOAD_BALANCING_DISABLED);
+    }
+    load_balancer_.reset();
+    lease_sync_.reset();
+}
+
+bool
+Dhcpv4Srv::inLoadBalancingScope(const Pkt4& query) const {
+    return (!load_balancer_ ||
+            load_balancer_->inScope(query, lease_sync_->isPeerUp()));
+}
+
+bool
+Dhcpv4Srv::admitQuery(const Pkt4Ptr& query) {
+    if (!rate_limiter_.isEnabled()) {
+        return (true);
+    }
+
+    Subnet4Ptr subnet = selectSubnet(query);
+    const SubnetID subnet_id = subnet ? subnet->getID() : 0;
+    const boost::posix_time::ptime now =
+        boost::posix_time::microsec_clock::universal_time();
+    switch (rate_limiter_.check(subnet_id, RateLimiter::getPriority(*query),
+                                query->getTimestamp(), now)) {
+    case RateLimiter::ACCEPT:
+        return (true);
+
+    case RateLimiter::RATE_LIMITED:
+        counters_.inc(ServerCounters::RATE_LIMITED);
+        if (subnet) {
+            counters_.incSubnet(subnet_id,
+                                ServerCounters::SUBNET_RATE_LIMITED);
+        }
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_QUERY_RATE_LIMITED)
+                  .arg(serverReceivedPacketName(query->getType()))
+                  .arg(query->getTransid())
+                  .arg(subnet ? subnet->toText() : "(none)");
+        break;
+
+    case RateLimiter::SHED:
+        counters_.inc(ServerCounters::OVERLOAD_SHED);
+        if (subnet) {
+            counters_.incSubnet(subnet_id, ServerCounters::SUBNET_SHED);
+        }
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_QUERY_SHED)
+                  .arg(serverReceivedPacketName(query->getType()))
+                  .arg(query->getTransid());
+        break;
+    }
+    return (false);
+}
+
 const char*
 Dhcpv4Srv::serverReceivedPacketName(uint8_t type) {
     static const char* DISCOVER = "DISCOVER";
@@ -737,18 +1000,26 @@ Dhcpv4Srv::serverReceivedPacketName(uint8_t type) {
 
 Subnet4Ptr
 Dhcpv4Srv::selectSubnet(const Pkt4Ptr& question) {
+    const StageProfiler::Mark mark = profiler_.mark();
+    Subnet4Ptr subnet;
 
     // Is this relayed message?
     IOAddress relay = question->getGiaddr();
     if (relay.toText() == "0.0.0.0") {
 
         // Yes: Use relay address to select subnet
-        return (CfgMgr::instance().getSubnet4(relay));
+        subnet = CfgMgr::instance().getSubnet4(relay);
     } else {
 
         // No: Use client's address to select subnet
-        return (CfgMgr::instance().getSubnet4(question->getRemoteAddr()));
+        subnet = CfgMgr::instance().getSubnet4(question->getRemoteAddr());
+    }
+
+    if (mark.time_) {
+        profiler_.record(question->getType(), StageProfiler::SUBNET_SELECTION,
+                         mark);
     }
+    return (subnet);
 }
 
 void
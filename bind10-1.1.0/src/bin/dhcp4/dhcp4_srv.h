@@ -17,11 +17,19 @@
 
 #include <dhcp/dhcp4.h>
 #include <dhcp/pkt4.h>
+#include <dhcp/pkt_buffer_pool.h>
+#include <dhcp/response_cache.h>
 #include <dhcp/option.h>
+#include <dhcpsrv/lease_sync.h>
+#include <dhcpsrv/load_balancer.h>
+#include <dhcpsrv/rate_limiter.h>
+#include <dhcpsrv/server_counters.h>
+#include <dhcpsrv/stage_profiler.h>
 #include <dhcpsrv/subnet.h>
 #include <dhcpsrv/alloc_engine.h>
 
 #include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <iostream>
 
@@ -72,7 +80,7 @@ class Dhcpv4Srv : public boost::noncopyable {
               const bool use_bcast = true);
 
     /// @brief Destructor. Used during DHCPv4 service shutdown.
-    ~Dhcpv4Srv();
+    virtual ~Dhcpv4Srv();
 
     /// @brief Main server processing loop.
     ///
@@ -106,8 +114,123 @@ class Dhcpv4Srv : public boost::noncopyable {
     ///         be freed by the caller.
     static const char* serverReceivedPacketName(uint8_t type);
 
+    /// @brief Sets the time for which responses are cached.
+    ///
+    /// Queries retransmitted by clients within this time are answered
+    /// with the response sent to the original query, without processing
+    /// them again.
+    ///
+    /// @param window time in milliseconds, 0 disables the cache.
+    void setResponseCacheWindow(uint32_t window) {
+        response_cache_.setWindow(window);
+    }
+
+    /// @brief Returns the cache of sent responses.
+    const ResponseCache4& getResponseCache() const {
+        return (response_cache_);
+    }
+
+    /// @brief Returns the profiler of the message processing stages.
+    StageProfiler& getStageProfiler() {
+        return (profiler_);
+    }
+
+    /// @brief Returns the statistics counters.
+    ServerCounters& getServerCounters() {
+        return (counters_);
+    }
+
+    /// @brief Returns the limits of the queries processed when overloaded.
+    RateLimiter& getRateLimiter() {
+        return (rate_limiter_);
+    }
+
+    /// @brief Makes the server one of an active-active pair.
+    ///
+    /// The server answers the clients of its half of the buckets, or all
+    /// clients while the peer is down (see @ref LoadBalancer), and its
+    /// lease changes are streamed to the peer (see @ref LeaseSync). The
+    /// changes of the peer are applied to the current lease database, so
+    /// this must be called again when the lease database changes.
+    ///
+    /// @param role role of this server.
+    /// @param local_addr IPv4 address the peer connects to.
+    /// @param local_port port the peer connects to.
+    /// @param peer_addr IPv4 address of the peer.
+    /// @param peer_port port of the peer.
+    /// @throw LeaseSyncError if the port can't be opened, the load
+    /// balancing is then disabled.
+    void configureLoadBalancing(LoadBalancer::Role role,
+                                const isc::asiolink::IOAddress& local_addr,
+                                uint16_t local_port,
+                                const isc::asiolink::IOAddress& peer_addr,
+                                uint16_t peer_port);
+
+    /// @brief Makes the server answer all clients alone.
+    void disableLoadBalancing();
+
+    /// @brief Returns the lease synchronization, NULL if the server is not
+    /// part of a pair.
+    const LeaseSync* getLeaseSync() const {
+        return (lease_sync_.get());
+    }
+
 protected:
 
+    /// @brief Checks if the server answers a query.
+    ///
+    /// @param query DHCPv4 query.
+    /// @return false if the query is left to the load balancing peer.
+    bool inLoadBalancingScope(const Pkt4& query) const;
+
+    /// @brief Checks if a query is processed, see @ref RateLimiter.
+    ///
+    /// The dropped queries are counted and logged.
+    ///
+    /// @param query parsed DHCPv4 query.
+    /// @return false if the query is dropped.
+    bool admitQuery(const Pkt4Ptr& query);
+
+    /// @brief Receives a packet from the clients or the DHCPv6 server.
+    ///
+    /// The packets are received through the IfaceMgr, all the packets
+    /// waiting on a socket together (see IfaceMgr::receiveBatch4): the
+    /// next calls return the other packets of the batch without waiting.
+    /// Derived classes may feed the server from elsewhere, e.g. to replay
+    /// captured traffic without sockets.
+    ///
+    /// @param timeout timeout in seconds
+    /// @return received packet or NULL if none was received in time
+    virtual Pkt4Ptr receivePacket(int timeout);
+
+    /// @brief Sends responses.
+    ///
+    /// The responses are sent in order through the IfaceMgr (see
+    /// IfaceMgr::sendBatch).
+    ///
+    /// @param packets packed responses
+    /// @param [out] sent number of responses sent. If an exception is
+    /// thrown, the response which couldn't be sent is packets[sent].
+    /// @throw isc::Exception if a response couldn't be sent
+    virtual void sendPackets(const Pkt4Collection& packets, size_t& sent);
+
+    /// @brief Sends the responses to the queries processed so far.
+    ///
+    /// The server calls it when all the queries received together are
+    /// processed, before waiting for more queries. A response which
+    /// can't be sent is logged and dropped, the next ones being sent.
+    void sendResponses();
+
+    /// @brief Removes the handled responses from the queue.
+    ///
+    /// The responses which have been sent are stored in the response
+    /// cache. The buffers of the other responses go back to the pool.
+    ///
+    /// @param sent number of responses sent, from the front of the queue.
+    /// @param dropped number of responses which couldn't be sent,
+    /// following the sent ones.
+    void removeResponses(size_t sent, size_t dropped);
+
     /// @brief verifies if specified packet meets RFC requirements
     ///
     /// Checks if mandatory option is really there, that forbidden option
@@ -286,6 +409,43 @@ protected:
     /// during normal operation (e.g. to use different allocators)
     boost::shared_ptr<AllocEngine> alloc_engine_;
 
+    /// @brief Pool of output buffers used to pack responses.
+    PktBufferPool buffer_pool_;
+
+    /// @brief Queries received together, see receivePacket().
+    Pkt4Collection queries_;
+
+    /// @brief Index of the next query of queries_ to be processed.
+    size_t next_query_;
+
+    /// @brief Responses waiting to be sent, see sendResponses().
+    Pkt4Collection responses_;
+
+    /// @brief Queries answered by responses_, in the same order.
+    ///
+    /// The query is NULL for a response taken from the response cache.
+    Pkt4Collection response_queries_;
+
+    /// @brief Responses which buffers go back to the pool once sent.
+    Pkt4Collection pooled_responses_;
+
+    /// @brief Responses sent recently, used to answer retransmissions.
+    ResponseCache4 response_cache_;
+
+    /// @brief Processing time of the message handling stages.
+    StageProfiler profiler_;
+
+    /// @brief Statistics counters reported to b10-stats.
+    ServerCounters counters_;
+
+    /// @brief Drops queries when the server is overloaded.
+    RateLimiter rate_limiter_;
+
+    /// @brief Split of the clients with the peer, NULL without peer.
+    boost::scoped_ptr<LoadBalancer> load_balancer_;
+
+    /// @brief Lease changes exchanged with the peer, NULL without peer.
+    boost::scoped_ptr<LeaseSync> lease_sync_;
 };
 
 }; // namespace isc::dhcp
@@ -16,9 +16,14 @@
 
 #include <dhcp4/ctrl_dhcp4_srv.h>
 #include <dhcp4/dhcp4_log.h>
+#include <dhcp/iface_mgr.h>
 #include <log/logger_support.h>
 #include <log/logger_manager.h>
 
+#ifdef ENABLE_ALLOC_COUNTING
+#include <bench/alloc_counter.h>
+#endif
+
 #include <boost/lexical_cast.hpp>
 
 #include <iostream>
@@ -41,11 +46,16 @@ const char* const DHCP4_NAME = "b10-dhcp4";
 
 void
 usage() {
-    cerr << "Usage: " << DHCP4_NAME << " [-v] [-s] [-p number]" << endl;
+    cerr << "Usage: " << DHCP4_NAME << " [-v] [-s] [-p number] [-u name]"
+         << " [-m dir]" << endl;
     cerr << "  -v: verbose output" << endl;
     cerr << "  -s: stand-alone mode (don't connect to BIND10)" << endl;
     cerr << "  -p number: specify non-standard port number 1-65535 "
          << "(useful for testing only)" << endl;
+    cerr << "  -u name: receive DHCPv4-queries on the 4o6 socket name "
+         << "(default " << FILENAME1 << ")" << endl;
+    cerr << "  -m dir: pass the 4o6 messages through a shared memory "
+         << "channel in dir" << endl;
     exit(EXIT_FAILURE);
 }
 } // end of anonymous namespace
@@ -57,8 +67,10 @@ main(int argc, char* argv[]) {
                                          // useful for testing only.
     bool stand_alone = false;  // Should be connect to BIND10 msgq?
     bool verbose_mode = false; // Should server be verbose?
+    string socket_name;        // 4o6 socket, if not the default one
+    string channel_dir;        // 4o6 shared memory channel directory
 
-    while ((ch = getopt(argc, argv, "vsp:")) != -1) {
+    while ((ch = getopt(argc, argv, "vsp:u:m:")) != -1) {
         switch (ch) {
         case 'v':
             verbose_mode = true;
@@ -83,6 +95,14 @@ main(int argc, char* argv[]) {
             }
             break;
 
+        case 'u':
+            socket_name = optarg;
+            break;
+
+        case 'm':
+            channel_dir = optarg;
+            break;
+
         default:
             usage();
         }
@@ -104,8 +124,25 @@ main(int argc, char* argv[]) {
               .arg(stand_alone ? "yes" : "no" );
 
 
+#ifdef ENABLE_ALLOC_COUNTING
+    // Report the memory allocations in the per-stage timing statistics.
+    isc::dhcp::StageProfiler::setAllocCounter(
+        &isc::bench::AllocCounter::getCount);
+#endif
+
     int ret = EXIT_SUCCESS;
     try {
+        if (!socket_name.empty()) {
+            IfaceMgr::instance().set4o6SocketName(socket_name);
+        }
+        Shm4o6ChannelPtr channel;
+        if (!channel_dir.empty()) {
+            channel = Shm4o6Channel::create(Shm4o6Channel::getPath(
+                channel_dir, IfaceMgr::instance().get4o6SocketName()));
+            IfaceMgr::instance().add4o6Channel(channel);
+            LOG_INFO(dhcp4_logger, DHCP4_4O6_CHANNEL_CREATED)
+                .arg(channel->getPathName());
+        }
         ControlledDhcpv4Srv server(port_number);
         if (!stand_alone) {
             try {
@@ -123,6 +160,10 @@ main(int argc, char* argv[]) {
             LOG_DEBUG(dhcp4_logger, DBG_DHCP4_START, DHCP4_STANDALONE);
         }
         server.run();
+        if (channel) {
+            // The file is removed with the channel.
+            IfaceMgr::instance().remove4o6Channel(channel);
+        }
         LOG_INFO(dhcp4_logger, DHCP4_SHUTDOWN);
 
     } catch (const std::exception& ex) {
@@ -333,6 +333,126 @@ TEST_F(Dhcp4ParserTest, emptySubnet) {
     checkGlobalUint32("valid-lifetime", 4000);
 }
 
+// Checks that the response cache window is passed to the server.
+TEST_F(Dhcp4ParserTest, responseCacheWindow) {
+
+    ConstElementPtr status;
+
+    EXPECT_FALSE(srv_->getResponseCache().isEnabled());
+
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_,
+                    Element::fromJSON("{ \"interface\": [ \"all\" ],"
+                                      "\"rebind-timer\": 2000, "
+                                      "\"renew-timer\": 1000, "
+                                      "\"response-cache-window\": 3000, "
+                                      "\"subnet4\": [  ], "
+                                      "\"valid-lifetime\": 4000 }")));
+
+    // returned value should be 0 (success)
+    checkResult(status, 0);
+
+    checkGlobalUint32("response-cache-window", 3000);
+    EXPECT_TRUE(srv_->getResponseCache().isEnabled());
+    EXPECT_EQ(3000, srv_->getResponseCache().getWindow());
+
+    // Removing the window from the configuration disables the cache.
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_,
+                    Element::fromJSON("{ \"interface\": [ \"all\" ],"
+                                      "\"rebind-timer\": 2000, "
+                                      "\"renew-timer\": 1000, "
+                                      "\"subnet4\": [  ], "
+                                      "\"valid-lifetime\": 4000 }")));
+    checkResult(status, 0);
+
+    EXPECT_FALSE(srv_->getResponseCache().isEnabled());
+    EXPECT_EQ(0, srv_->getResponseCache().getWindow());
+}
+
+// Checks that the rate limiting and the shedding are passed to the server.
+TEST_F(Dhcp4ParserTest, rateLimit) {
+
+    ConstElementPtr status;
+
+    EXPECT_FALSE(srv_->getRateLimiter().isEnabled());
+
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_,
+                    Element::fromJSON("{ \"interface\": [ \"all\" ],"
+                                      "\"rate-limit\": 100, "
+                                      "\"rate-limit-burst\": 300, "
+                                      "\"rebind-timer\": 2000, "
+                                      "\"renew-timer\": 1000, "
+                                      "\"shed-delay\": 250, "
+                                      "\"subnet4\": [  ], "
+                                      "\"valid-lifetime\": 4000 }")));
+
+    // returned value should be 0 (success)
+    checkResult(status, 0);
+
+    EXPECT_EQ(100, srv_->getRateLimiter().getRate());
+    EXPECT_EQ(300, srv_->getRateLimiter().getBurst());
+    EXPECT_EQ(250, srv_->getRateLimiter().getShedDelay());
+}
+
+// Checks that the load balancing is configured, and that invalid
+// parameters are rejected.
+TEST_F(Dhcp4ParserTest, loadBalancing) {
+
+    ConstElementPtr status;
+
+    EXPECT_FALSE(srv_->getLeaseSync());
+
+    const string prefix = "{ \"interface\": [ \"all\" ],"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet4\": [  ], "
+        "\"valid-lifetime\": 4000, "
+        "\"load-balancing\": ";
+
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_,
+                    Element::fromJSON(prefix +
+                                      "{ \"role\": \"secondary\","
+                                      "  \"local-address\": \"127.0.0.1\","
+                                      "  \"local-port\": 54711,"
+                                      "  \"peer-address\": \"127.0.0.1\","
+                                      "  \"peer-port\": 54712 } }")));
+    checkResult(status, 0);
+    ASSERT_TRUE(srv_->getLeaseSync());
+    EXPECT_FALSE(srv_->getLeaseSync()->isPeerUp());
+
+    // Invalid parameters leave the load balancing as it is.
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_,
+                    Element::fromJSON(prefix +
+                                      "{ \"role\": \"backup\","
+                                      "  \"local-address\": \"127.0.0.1\","
+                                      "  \"local-port\": 54711,"
+                                      "  \"peer-address\": \"127.0.0.1\","
+                                      "  \"peer-port\": 54712 } }")));
+    checkResult(status, 1);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_,
+                    Element::fromJSON(prefix +
+                                      "{ \"role\": \"primary\","
+                                      "  \"local-address\": \"::1\","
+                                      "  \"local-port\": 54711,"
+                                      "  \"peer-address\": \"127.0.0.1\","
+                                      "  \"peer-port\": 54712 } }")));
+    checkResult(status, 1);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_,
+                    Element::fromJSON(prefix +
+                                      "{ \"role\": \"primary\","
+                                      "  \"local-address\": \"127.0.0.1\","
+                                      "  \"local-port\": 54711,"
+                                      "  \"peer-address\": \"127.0.0.1\","
+                                      "  \"peer-port\": 54711 } }")));
+    checkResult(status, 1);
+    EXPECT_TRUE(srv_->getLeaseSync());
+
+    // An empty role disables the load balancing.
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_,
+                    Element::fromJSON(prefix + "{ \"role\": \"\" } }")));
+    checkResult(status, 0);
+    EXPECT_FALSE(srv_->getLeaseSync());
+}
+
 /// The goal of this test is to verify if defined subnet uses global
 /// parameter timer definitions.
 TEST_F(Dhcp4ParserTest, subnetGlobalDefaults) {
@@ -363,6 +483,138 @@ TEST_F(Dhcp4ParserTest, subnetGlobalDefaults) {
     EXPECT_EQ(4000, subnet->getValid());
 }
 
+// Checks that a subnet which is kept when the server is reconfigured
+// keeps its ID, and that the removed subnets are removed.
+TEST_F(Dhcp4ParserTest, reconfigureKeepsSubnetId) {
+
+    ConstElementPtr status;
+
+    string config = "{ \"interface\": [ \"all\" ],"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet4\": [ { "
+        "    \"pool\": [ \"192.0.2.1 - 192.0.2.100\" ],"
+        "    \"subnet\": \"192.0.2.0/24\" },"
+        "  { \"pool\": [ \"192.0.3.1 - 192.0.3.100\" ],"
+        "    \"subnet\": \"192.0.3.0/24\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_,
+                                                  Element::fromJSON(config)));
+    checkResult(status, 0);
+    Subnet4Ptr subnet = CfgMgr::instance().getSubnet4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(subnet);
+    const SubnetID id = subnet->getID();
+
+    // Only the first subnet is left, with new timers.
+    config = "{ \"interface\": [ \"all\" ],"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet4\": [ { "
+        "    \"pool\": [ \"192.0.2.1 - 192.0.2.100\" ],"
+        "    \"subnet\": \"192.0.2.0/24\" } ],"
+        "\"valid-lifetime\": 5000 }";
+
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_,
+                                                  Element::fromJSON(config)));
+    checkResult(status, 0);
+    ASSERT_EQ(1, CfgMgr::instance().getSubnets4()->size());
+    subnet = CfgMgr::instance().getSubnets4()->at(0);
+    EXPECT_EQ(id, subnet->getID());
+    EXPECT_EQ(5000, subnet->getValid());
+}
+
+// Checks that single subnets can be added, updated and removed with
+// commands, without affecting the other subnets.
+TEST_F(Dhcp4ParserTest, subnetCommands) {
+
+    ConstElementPtr status;
+
+    string config = "{ \"interface\": [ \"all\" ],"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet4\": [ { "
+        "    \"pool\": [ \"192.0.2.1 - 192.0.2.100\" ],"
+        "    \"subnet\": \"192.0.2.0/24\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_,
+                                                  Element::fromJSON(config)));
+    checkResult(status, 0);
+    Subnet4Ptr subnet1 = CfgMgr::instance().getSubnet4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(subnet1);
+
+    // Add a subnet. The global parameters are taken from the configuration.
+    status = configureDhcp4Subnet("subnet4-add", Element::fromJSON(
+        "{ \"subnet\": { \"pool\": [ \"192.0.3.1 - 192.0.3.100\" ],"
+        "                \"subnet\": \"192.0.3.0/24\" } }"));
+    checkResult(status, 0);
+    ASSERT_EQ(2, CfgMgr::instance().getSubnets4()->size());
+    Subnet4Ptr subnet2 = CfgMgr::instance().getSubnets4()->at(1);
+    EXPECT_EQ("192.0.3.0/24", subnet2->toText());
+    EXPECT_EQ(4000, subnet2->getValid());
+    EXPECT_NE(subnet1->getID(), subnet2->getID());
+    EXPECT_EQ(subnet1, CfgMgr::instance().getSubnets4()->at(0));
+
+    // The same subnet can't be added twice.
+    status = configureDhcp4Subnet("subnet4-add", Element::fromJSON(
+        "{ \"subnet\": { \"pool\": [ \"192.0.3.1 - 192.0.3.10\" ],"
+        "                \"subnet\": \"192.0.3.0/24\" } }"));
+    checkResult(status, 1);
+    EXPECT_EQ(subnet2, CfgMgr::instance().getSubnets4()->at(1));
+
+    // Update the subnet: it keeps its ID.
+    status = configureDhcp4Subnet("subnet4-update", Element::fromJSON(
+        "{ \"subnet\": { \"pool\": [ \"192.0.3.1 - 192.0.3.200\" ],"
+        "                \"subnet\": \"192.0.3.0/24\","
+        "                \"valid-lifetime\": 5000 } }"));
+    checkResult(status, 0);
+    ASSERT_EQ(2, CfgMgr::instance().getSubnets4()->size());
+    Subnet4Ptr subnet = CfgMgr::instance().getSubnets4()->at(1);
+    EXPECT_NE(subnet2, subnet);
+    EXPECT_EQ(subnet2->getID(), subnet->getID());
+    EXPECT_EQ(5000, subnet->getValid());
+    EXPECT_TRUE(subnet->inPool(IOAddress("192.0.3.150")));
+
+    // An unknown subnet can't be updated, and an invalid definition
+    // is rejected.
+    status = configureDhcp4Subnet("subnet4-update", Element::fromJSON(
+        "{ \"subnet\": { \"pool\": [ \"192.0.4.1 - 192.0.4.200\" ],"
+        "                \"subnet\": \"192.0.4.0/24\" } }"));
+    checkResult(status, 1);
+    status = configureDhcp4Subnet("subnet4-update", Element::fromJSON(
+        "{ \"subnet\": { \"pool\": [ \"192.0.4.1 - 192.0.4.200\" ],"
+        "                \"subnet\": \"192.0.3.0/24\" } }"));
+    checkResult(status, 1);
+    status = configureDhcp4Subnet("subnet4-add", Element::fromJSON("{ }"));
+    checkResult(status, 1);
+    EXPECT_EQ(subnet, CfgMgr::instance().getSubnets4()->at(1));
+
+    // Remove the first subnet.
+    status = configureDhcp4Subnet("subnet4-del", Element::fromJSON(
+        "{ \"subnet\": \"192.0.2.0/24\" }"));
+    checkResult(status, 0);
+    ASSERT_EQ(1, CfgMgr::instance().getSubnets4()->size());
+    EXPECT_EQ(subnet, CfgMgr::instance().getSubnets4()->at(0));
+    status = configureDhcp4Subnet("subnet4-del", Element::fromJSON(
+        "{ \"subnet\": \"192.0.2.0/24\" }"));
+    checkResult(status, 1);
+    status = configureDhcp4Subnet("subnet4-del", Element::fromJSON(
+        "{ \"subnet\": \"192.0.3.0\" }"));
+    checkResult(status, 1);
+
+    // A prefix length out of range is rejected, and doesn't wrap around
+    // to the length of the remaining subnet (280 is 24 modulo 256).
+    status = configureDhcp4Subnet("subnet4-del", Element::fromJSON(
+        "{ \"subnet\": \"192.0.3.0/33\" }"));
+    checkResult(status, 1);
+    status = configureDhcp4Subnet("subnet4-del", Element::fromJSON(
+        "{ \"subnet\": \"192.0.3.0/280\" }"));
+    checkResult(status, 1);
+    ASSERT_EQ(1, CfgMgr::instance().getSubnets4()->size());
+    EXPECT_EQ(subnet, CfgMgr::instance().getSubnets4()->at(0));
+}
+
 // This test checks if it is possible to override global values
 // on a per subnet basis.
 TEST_F(Dhcp4ParserTest, subnetLocal) {
@@ -27,13 +27,18 @@
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/lease_mgr.h>
 #include <dhcpsrv/lease_mgr_factory.h>
+#include <dhcpsrv/lease_sync.h>
+#include <dhcpsrv/memfile_lease_mgr.h>
 #include <dhcpsrv/utils.h>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
 #include <gtest/gtest.h>
 
 #include <fstream>
 #include <iostream>
 
 #include <arpa/inet.h>
+#include <time.h>
 
 using namespace std;
 using namespace isc;
@@ -67,6 +72,8 @@ public:
     using Dhcpv4Srv::writeServerID;
     using Dhcpv4Srv::sanityCheck;
     using Dhcpv4Srv::srvidToString;
+    using Dhcpv4Srv::inLoadBalancingScope;
+    using Dhcpv4Srv::admitQuery;
 };
 
 static const char* SRVID_FILE = "server-id-test.txt";
@@ -1319,4 +1326,223 @@ TEST_F(Dhcpv4SrvTest, ServerID) {
     EXPECT_EQ(srvid_text, text);
 }
 
+/// @brief Checks if the server and the test peer see each other up.
+bool
+pairUp(const NakedDhcpv4Srv* srv, const LeaseSync* peer) {
+    return (srv->getLeaseSync()->isPeerUp() && peer->isPeerUp());
+}
+
+/// @brief Checks if the test peer applied a change.
+bool
+peerApplied(const LeaseSync* peer) {
+    return (peer->getApplied() > 0);
+}
+
+/// @brief Runs the packet loop until a condition is true, or for at most
+/// 5 seconds.
+bool
+runUntil(const boost::function<bool ()>& condition) {
+    const time_t end = time(NULL) + 5;
+    while (!condition() && (time(NULL) < end)) {
+        IfaceMgr::instance().receive4(0, 10000);
+    }
+    return (condition());
+}
+
+// Checks that a server of a load balancing pair answers only its own
+// clients while the peer is up, and that it sends its leases to the peer.
+TEST_F(Dhcpv4SrvTest, LoadBalancing) {
+    boost::scoped_ptr<NakedDhcpv4Srv> srv(new NakedDhcpv4Srv(0));
+    ASSERT_NO_THROW(srv->configureLoadBalancing(LoadBalancer::PRIMARY,
+                                                IOAddress("127.0.0.1"), 54721,
+                                                IOAddress("127.0.0.1"),
+                                                54722));
+    ASSERT_TRUE(srv->getLeaseSync());
+
+    std::vector<Pkt4Ptr> discovers;
+    for (uint8_t i = 0; i < 32; ++i) {
+        Pkt4Ptr discover(new Pkt4(DHCPDISCOVER, 1234));
+        const uint8_t mac[] = { 0x00, 0x0c, 0x01, 0x02, 0x03, i };
+        discover->setHWAddr(HTYPE_ETHER, sizeof(mac),
+                            std::vector<uint8_t>(mac, mac + sizeof(mac)));
+        discovers.push_back(discover);
+        // The peer is down: all clients are answered.
+        EXPECT_TRUE(srv->inLoadBalancingScope(*discover));
+    }
+
+    // The peer of the test keeps its leases in its own database.
+    Memfile_LeaseMgr peer_lease_mgr((LeaseMgr::ParameterMap()));
+    LeaseSync peer(peer_lease_mgr, IOAddress("127.0.0.1"), 54722,
+                   IOAddress("127.0.0.1"), 54721);
+    ASSERT_TRUE(runUntil(boost::bind(pairUp, srv.get(), &peer)));
+
+    LoadBalancer primary(LoadBalancer::PRIMARY);
+    size_t answered = 0;
+    for (size_t i = 0; i < discovers.size(); ++i) {
+        const bool own = primary.isOwnBucket(
+            LoadBalancer::getBucket(*discovers[i]));
+        EXPECT_EQ(own, srv->inLoadBalancingScope(*discovers[i]));
+        if (own) {
+            ++answered;
+        }
+    }
+    EXPECT_GT(answered, 0);
+    EXPECT_LT(answered, discovers.size());
+
+    // The lease given to a client is sent to the peer.
+    IOAddress hint("192.0.2.107");
+    Pkt4Ptr req = Pkt4Ptr(new Pkt4(DHCPREQUEST, 1234));
+    req->setRemoteAddr(IOAddress("192.0.2.1"));
+    OptionPtr clientid = generateClientId();
+    req->addOption(clientid);
+    req->setYiaddr(hint);
+    Pkt4Ptr ack = srv->processRequest(req);
+    checkResponse(ack, DHCPACK, 1234);
+    ASSERT_TRUE(runUntil(boost::bind(peerApplied, &peer)));
+    Lease4Ptr lease = peer_lease_mgr.getLease4(hint);
+    ASSERT_TRUE(lease);
+    EXPECT_TRUE(*LeaseMgrFactory::instance().getLease4(hint) == *lease);
+
+    LeaseMgrFactory::instance().deleteLease(hint);
+    srv->disableLoadBalancing();
+    EXPECT_FALSE(srv->getLeaseSync());
+}
+
+// Checks that the queries over the rate of their subnet, and those which
+// waited too long, are dropped and counted.
+TEST_F(Dhcpv4SrvTest, admitQuery) {
+    boost::scoped_ptr<NakedDhcpv4Srv> srv(new NakedDhcpv4Srv(0));
+
+    Pkt4Ptr discover(new Pkt4(DHCPDISCOVER, 1234));
+    discover->setRemoteAddr(IOAddress("192.0.2.1"));
+    discover->updateTimestamp();
+    EXPECT_TRUE(srv->admitQuery(discover));
+
+    srv->getRateLimiter().setRate(1, 2);
+    EXPECT_TRUE(srv->admitQuery(discover));
+    EXPECT_TRUE(srv->admitQuery(discover));
+    EXPECT_FALSE(srv->admitQuery(discover));
+
+    // Renewals get through.
+    Pkt4Ptr renew(new Pkt4(DHCPREQUEST, 1235));
+    renew->setRemoteAddr(IOAddress("192.0.2.1"));
+    renew->setCiaddr(IOAddress("192.0.2.107"));
+    renew->updateTimestamp();
+    EXPECT_TRUE(srv->admitQuery(renew));
+
+    ServerCounters& counters = srv->getServerCounters();
+    EXPECT_EQ(1, counters.get(ServerCounters::RATE_LIMITED));
+    EXPECT_EQ(1, counters.getSubnet(subnet_->getID(),
+                                    ServerCounters::SUBNET_RATE_LIMITED));
+
+    // A DHCPDISCOVER received a second ago is shed.
+    srv->getRateLimiter().setRate(0);
+    srv->getRateLimiter().setShedDelay(500);
+    discover->setTimestamp(discover->getTimestamp() -
+                           boost::posix_time::seconds(1));
+    EXPECT_FALSE(srv->admitQuery(discover));
+    renew->setTimestamp(discover->getTimestamp());
+    EXPECT_TRUE(srv->admitQuery(renew));
+    EXPECT_EQ(1, counters.get(ServerCounters::OVERLOAD_SHED));
+    EXPECT_EQ(1, counters.getSubnet(subnet_->getID(),
+                                    ServerCounters::SUBNET_SHED));
+}
+
+/// @brief Server running its main loop on queries handed by the test.
+///
+/// The responses are not sent to the network: the sending fails or
+/// succeeds as set by the test.
+class LoopDhcpv4Srv : public NakedDhcpv4Srv {
+public:
+
+    /// @brief Constructor.
+    LoopDhcpv4Srv() : send_fails_(false), sent_(0) {
+    }
+
+    /// @brief Runs the main loop for a single query.
+    ///
+    /// @param query query, not unpacked yet.
+    void process(const Pkt4Ptr& query) {
+        query_ = query;
+        shutdown_ = false;
+        run();
+    }
+
+    /// @brief Returns the query set by process(), then stops the loop.
+    virtual Pkt4Ptr receivePacket(int) {
+        Pkt4Ptr query;
+        query.swap(query_);
+        if (!query) {
+            shutdown_ = true;
+        }
+        return (query);
+    }
+
+    /// @brief Counts the responses or fails as if the socket failed.
+    virtual void sendPackets(const Pkt4Collection& packets, size_t& sent) {
+        if (send_fails_) {
+            isc_throw(isc::Unexpected, "send failed");
+        }
+        sent = packets.size();
+        sent_ += sent;
+    }
+
+    /// @brief Makes the sending of the responses fail.
+    bool send_fails_;
+
+    /// @brief Number of responses sent.
+    size_t sent_;
+
+private:
+
+    /// @brief Query to be returned by the next receivePacket() call.
+    Pkt4Ptr query_;
+};
+
+/// @brief Returns a copy of the packed query, as received again.
+///
+/// @param query packed query.
+Pkt4Ptr
+receivedCopy(const Pkt4& query) {
+    Pkt4Ptr copy(new Pkt4(static_cast<const uint8_t*>(query.getBuffer().
+                                                       getData()),
+                          query.getBuffer().getLength()));
+    copy->setRemoteAddr(IOAddress("192.0.2.1"));
+    copy->setIface("eth0");
+    copy->updateTimestamp();
+    return (copy);
+}
+
+// Checks that a response is cached only when it has been sent, so the
+// retransmission of a query which response was lost is processed again.
+TEST_F(Dhcpv4SrvTest, responseCachedOnceSent) {
+    boost::scoped_ptr<LoopDhcpv4Srv> srv(new LoopDhcpv4Srv());
+    srv->setResponseCacheWindow(3000);
+    ServerCounters& counters = srv->getServerCounters();
+
+    Pkt4 dis(DHCPDISCOVER, 1234);
+    dis.setHWAddr(generateHWAddr());
+    dis.addOption(generateClientId());
+    ASSERT_NO_THROW(dis.pack());
+
+    // The response is lost: nothing is cached.
+    srv->send_fails_ = true;
+    srv->process(receivedCopy(dis));
+    EXPECT_EQ(0, srv->sent_);
+    EXPECT_EQ(1, counters.get(ServerCounters::SEND_FAILED));
+    EXPECT_EQ(0, srv->getResponseCache().size());
+
+    // The retransmission is processed again and its response is cached.
+    srv->send_fails_ = false;
+    srv->process(receivedCopy(dis));
+    EXPECT_EQ(1, srv->sent_);
+    EXPECT_EQ(0, srv->getResponseCache().getHits());
+    EXPECT_EQ(1, srv->getResponseCache().size());
+
+    // The next retransmission is answered with the cached response.
+    srv->process(receivedCopy(dis));
+    EXPECT_EQ(2, srv->sent_);
+    EXPECT_EQ(1, srv->getResponseCache().getHits());
+}
+
 } // end of anonymous namespace
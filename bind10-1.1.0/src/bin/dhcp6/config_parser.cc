@@ -18,6 +18,7 @@
 #include <dhcp/libdhcp++.h>
 #include <dhcp6/config_parser.h>
 #include <dhcp6/dhcp6_log.h>
+#include <dhcp6/dhcp6_srv.h>
 #include <dhcp/iface_mgr.h>
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dbaccess_parser.h>
@@ -35,11 +36,13 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <vector>
 
 #include <stdint.h>
+#include <sys/un.h>
 
 using namespace std;
 using namespace isc;
@@ -93,6 +96,9 @@ OptionStorage option_defaults;
 /// @brief Global storage for option definitions.
 OptionDefStorage option_def_intermediate;
 
+/// @brief Names of the sockets of the DHCPv4 servers (4o6).
+std::vector<std::string> dhcp4o6_backends;
+
 /// @brief a dummy configuration parser
 ///
 /// This is a debugging parser. It does not configure anything,
@@ -468,6 +474,67 @@ private:
     vector<string> interfaces_;
 };
 
+/// @brief parser for the list of DHCPv4 servers
+///
+/// 4o6: this parser handles the "dhcp4o6-backends" parameter, i.e. the
+/// names of the sockets of the DHCPv4 servers the DHCPv4-queries are
+/// forwarded to. The list is stored in dhcp4o6_backends and passed to
+/// the server once the whole configuration has been parsed.
+class Dhcp4o6BackendsParser : public DhcpConfigParser {
+public:
+
+    /// @brief constructor
+    ///
+    /// @param param_name name of the configuration parameter being parsed
+    /// @throw BadValue if supplied parameter name is not "dhcp4o6-backends"
+    Dhcp4o6BackendsParser(const std::string& param_name) {
+        if (param_name != "dhcp4o6-backends") {
+            isc_throw(isc::BadValue, "Internal error. DHCPv4 servers "
+                      "configuration parser called for the wrong parameter: "
+                      << param_name);
+        }
+    }
+
+    /// @brief parses the list of socket names
+    ///
+    /// @param value pointer to the content of parsed values
+    /// @throw DhcpConfigError if a name is empty, too long or duplicated
+    virtual void build(ConstElementPtr value) {
+        struct sockaddr_un addr;
+        BOOST_FOREACH(ConstElementPtr backend, value->listValue()) {
+            const std::string name = backend->stringValue();
+            // The names are those of abstract UNIX sockets, without the
+            // leading zero byte.
+            if (name.empty() || (name.size() >= sizeof(addr.sun_path))) {
+                isc_throw(DhcpConfigError, "invalid DHCPv4 server socket"
+                          " name '" << name << "'");
+            }
+            if (std::find(backends_.begin(), backends_.end(), name) !=
+                backends_.end()) {
+                isc_throw(DhcpConfigError, "duplicate DHCPv4 server socket"
+                          " name '" << name << "'");
+            }
+            backends_.push_back(name);
+        }
+    }
+
+    /// @brief stores the list of socket names
+    virtual void commit() {
+        dhcp4o6_backends = backends_;
+    }
+
+    /// @brief factory that constructs Dhcp4o6BackendsParser objects
+    ///
+    /// @param param_name name of the parameter to be parsed
+    static DhcpConfigParser* factory(const std::string& param_name) {
+        return (new Dhcp4o6BackendsParser(param_name));
+    }
+
+private:
+    /// names of the sockets of the DHCPv4 servers
+    vector<string> backends_;
+};
+
 /// @brief parser for pool definition
 ///
 /// This parser handles pool definitions, i.e. a list of entries of one
@@ -889,8 +956,10 @@ private:
             // an instance of our option.
             try {
                 OptionPtr option = csv_format ?
-                    def->optionFactory(Option::V6, option_code, data_tokens) :
-                    def->optionFactory(Option::V6, option_code, binary);
+                    def->optionFactory(Option::V6, option_code, data_tokens,
+                                      option_space) :
+                    def->optionFactory(Option::V6, option_code, binary,
+                                      option_space);
                 Subnet::OptionDescriptor desc(option, false);
                 option_descriptor_.option = option;
                 option_descriptor_.persistent = false;
@@ -1278,11 +1347,22 @@ class Subnet6ConfigParser : public DhcpConfigParser {
 public:
 
     /// @brief constructor
-    Subnet6ConfigParser(const std::string& ) {
+    Subnet6ConfigParser(const std::string& )
+        : storage_(NULL) {
         // The parameter should always be "subnet", but we don't check
         // against that here in case some wants to reuse this parser somewhere.
     }
 
+    /// @brief Sets the storage for the created subnet.
+    ///
+    /// If the storage is set, the subnet is committed to it rather than
+    /// added to the CfgMgr.
+    ///
+    /// @param storage pointer to the storage for the subnet.
+    void setStorage(isc::dhcp::Subnet6Collection* storage) {
+        storage_ = storage;
+    }
+
     /// @brief parses parameter value
     ///
     /// @param subnet pointer to the content of subnet definition
@@ -1333,10 +1413,15 @@ public:
         createSubnet();
     }
 
-    /// @brief Adds the created subnet to a server's configuration.
+    /// @brief Adds the created subnet to the storage, if set, or to a
+    /// server's configuration.
     void commit() {
         if (subnet_) {
-            isc::dhcp::CfgMgr::instance().addSubnet6(subnet_);
+            if (storage_) {
+                storage_->push_back(subnet_);
+            } else {
+                isc::dhcp::CfgMgr::instance().addSubnet6(subnet_);
+            }
         }
     }
 
@@ -1649,6 +1734,9 @@ private:
 
     /// Pointer to the created subnet object.
     isc::dhcp::Subnet6Ptr subnet_;
+
+    /// Storage for the created subnet, if not the CfgMgr.
+    isc::dhcp::Subnet6Collection* storage_;
 };
 
 /// @brief this class parses a list of subnets
@@ -1678,28 +1766,30 @@ public:
 
         BOOST_FOREACH(ConstElementPtr subnet, subnets_list->listValue()) {
 
-            ParserPtr parser(new Subnet6ConfigParser("subnet"));
+            boost::shared_ptr<Subnet6ConfigParser>
+                parser(new Subnet6ConfigParser("subnet"));
+            parser->setStorage(&subnets_storage_);
             parser->build(subnet);
             subnets_.push_back(parser);
         }
 
+        // The subnet parsers write into the storage of this parser only,
+        // so the new subnets are collected here, and the commit has only
+        // to install them.
+        BOOST_FOREACH(ParserPtr parser, subnets_) {
+            parser->commit();
+        }
+        new_subnets_ =
+            isc::dhcp::CfgMgr::instance().buildSubnets6(subnets_storage_);
     }
 
     /// @brief commits subnets definitions.
     ///
-    /// Iterates over all Subnet6 parsers. Each parser contains definitions
-    /// of a single subnet and its parameters and commits each subnet separately.
+    /// Installs the subnets built by @ref build in the CfgMgr at once. The
+    /// subnets which have not changed keep their IDs and the leases
+    /// allocated in them.
     void commit() {
-        // @todo: Implement more subtle reconfiguration than toss
-        // the old one and replace with the new one.
-
-        // remove old subnets
-        isc::dhcp::CfgMgr::instance().deleteSubnets6();
-
-        BOOST_FOREACH(ParserPtr subnet, subnets_) {
-            subnet->commit();
-        }
-
+        isc::dhcp::CfgMgr::instance().replaceSubnets6(new_subnets_);
     }
 
     /// @brief Returns Subnet6ListConfigParser object
@@ -1711,6 +1801,12 @@ public:
 
     /// @brief collection of subnet parsers.
     ParserCollection subnets_;
+
+    /// @brief subnets created by the subnet parsers.
+    isc::dhcp::Subnet6Collection subnets_storage_;
+
+    /// @brief subnets to be installed by the commit.
+    isc::dhcp::ConstSubnet6CollectionPtr new_subnets_;
 };
 
 } // anonymous namespace
@@ -1733,7 +1829,13 @@ DhcpConfigParser* createGlobalDhcpConfigParser(const std::string& config_id) {
     factories["valid-lifetime"] = Uint32Parser::factory;
     factories["renew-timer"] = Uint32Parser::factory;
     factories["rebind-timer"] = Uint32Parser::factory;
+    factories["response-cache-window"] = Uint32Parser::factory;
+    factories["rate-limit"] = Uint32Parser::factory;
+    factories["rate-limit-burst"] = Uint32Parser::factory;
+    factories["shed-delay"] = Uint32Parser::factory;
     factories["interface"] = InterfaceListConfigParser::factory;
+    factories["dhcp4o6-backends"] = Dhcp4o6BackendsParser::factory;
+    factories["dhcp4o6-channel-dir"] = StringParser::factory;
     factories["subnet6"] = Subnets6ListConfigParser::factory;
     factories["option-data"] = OptionDataListParser::factory;
     factories["option-def"] = OptionDefListParser::factory;
@@ -1753,7 +1855,7 @@ DhcpConfigParser* createGlobalDhcpConfigParser(const std::string& config_id) {
 }
 
 ConstElementPtr
-configureDhcp6Server(Dhcpv6Srv&, ConstElementPtr config_set) {
+configureDhcp6Server(Dhcpv6Srv& server, ConstElementPtr config_set) {
     if (!config_set) {
         ConstElementPtr answer = isc::config::createAnswer(1,
                                  string("Can't parse NULL config"));
@@ -1891,6 +1993,36 @@ configureDhcp6Server(Dhcpv6Srv&, ConstElementPtr config_set) {
         return (answer);
     }
 
+    // The response cache is owned by the server, not the CfgMgr. It is
+    // disabled when the window is no longer configured and, like the
+    // lease database, emptied by every reconfiguration.
+    server.setResponseCacheWindow(config_set->contains("response-cache-window") ?
+                                  uint32_defaults.
+                                  getParam("response-cache-window") : 0);
+
+    // And so is the dropping of queries when the server is overloaded.
+    if (config_set->contains("rate-limit") ||
+        config_set->contains("rate-limit-burst")) {
+        const uint32_t rate = config_set->contains("rate-limit") ?
+            uint32_defaults.getParam("rate-limit") : 0;
+        const uint32_t burst = config_set->contains("rate-limit-burst") ?
+            uint32_defaults.getParam("rate-limit-burst") : 0;
+        server.getRateLimiter().setRate(rate, burst);
+    }
+    if (config_set->contains("shed-delay")) {
+        server.getRateLimiter().setShedDelay(uint32_defaults.
+                                             getParam("shed-delay"));
+    }
+
+    // So are the DHCPv4 servers the DHCPv4-queries are forwarded to.
+    if (config_set->contains("dhcp4o6-backends")) {
+        server.setDHCPv4Backends(dhcp4o6_backends);
+    }
+    if (config_set->contains("dhcp4o6-channel-dir")) {
+        server.setDHCPv4ChannelDir(string_defaults.
+                                   getParam("dhcp4o6-channel-dir"));
+    }
+
     LOG_INFO(dhcp6_logger, DHCP6_CONFIG_COMPLETE).arg(config_details);
 
     // Everything was fine. Configuration is successful.
@@ -1898,5 +2030,93 @@ configureDhcp6Server(Dhcpv6Srv&, ConstElementPtr config_set) {
     return (answer);
 }
 
+ConstElementPtr
+configureDhcp6Subnet(const std::string& command, ConstElementPtr args) {
+    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_COMMAND, DHCP6_CONFIG_SUBNET_START)
+        .arg(command).arg(args ? args->str() : "");
+
+    std::string subnet_txt;
+    try {
+        if (!args || (args->getType() != Element::map) ||
+            !args->contains("subnet")) {
+            isc_throw(DhcpConfigError, "mandatory subnet argument missing");
+        }
+        ConstElementPtr subnet_config = args->get("subnet");
+
+        if (command == "subnet6-del") {
+            subnet_txt = subnet_config->stringValue();
+            boost::erase_all(subnet_txt, " ");
+            boost::erase_all(subnet_txt, "\t");
+            size_t pos = subnet_txt.find("/");
+            if (pos == string::npos) {
+                isc_throw(DhcpConfigError, "Invalid subnet syntax"
+                          " (prefix/len expected):" << subnet_txt);
+            }
+            IOAddress addr(subnet_txt.substr(0, pos));
+            const unsigned int len =
+                boost::lexical_cast<unsigned int>(subnet_txt.substr(pos + 1));
+            if (len > 128) {
+                isc_throw(DhcpConfigError, "Invalid prefix length " << len
+                          << " of subnet " << subnet_txt);
+            }
+            if (!CfgMgr::instance().deleteSubnet6(addr, len)) {
+                isc_throw(DhcpConfigError, "subnet " << subnet_txt
+                          << " does not exist");
+            }
+
+        } else if ((command == "subnet6-add") ||
+                   (command == "subnet6-update")) {
+            // The parser stores the subnet in a local collection, so
+            // nothing is changed if the definition is invalid.
+            Subnet6Collection subnets;
+            Subnet6ConfigParser parser("subnet");
+            parser.setStorage(&subnets);
+            parser.build(subnet_config);
+            parser.commit();
+            if (subnets.empty()) {
+                isc_throw(DhcpConfigError, "no subnet defined");
+            }
+            const Subnet6Ptr& subnet = subnets.front();
+            subnet_txt = subnet->toText();
+
+            if (command == "subnet6-update") {
+                if (!CfgMgr::instance().updateSubnet6(subnet)) {
+                    isc_throw(DhcpConfigError, "subnet " << subnet_txt
+                              << " does not exist");
+                }
+            } else {
+                const std::pair<IOAddress, uint8_t> prefix = subnet->get();
+                if (CfgMgr::instance().getSubnet6ByPrefix(prefix.first,
+                                                         prefix.second)) {
+                    isc_throw(DhcpConfigError, "subnet " << subnet_txt
+                              << " already exists");
+                }
+                CfgMgr::instance().addSubnet6(subnet);
+            }
+
+        } else {
+            isc_throw(DhcpConfigError, "unrecognized command");
+        }
+
+    } catch (const isc::Exception& ex) {
+        LOG_ERROR(dhcp6_logger, DHCP6_CONFIG_SUBNET_FAIL)
+            .arg(command).arg(ex.what());
+        return (isc::config::createAnswer(1, string("Subnet ") + command +
+                                          " failed: " + ex.what()));
+
+    } catch (...) {
+        // for things like bad_cast in boost::lexical_cast
+        LOG_ERROR(dhcp6_logger, DHCP6_CONFIG_SUBNET_FAIL)
+            .arg(command).arg("invalid value");
+        return (isc::config::createAnswer(1, string("Subnet ") + command +
+                                          " failed"));
+    }
+
+    LOG_INFO(dhcp6_logger, DHCP6_CONFIG_SUBNET_COMPLETE)
+        .arg(command).arg(subnet_txt);
+    return (isc::config::createAnswer(0, "Subnet " + subnet_txt +
+                                      " changed."));
+}
+
 }; // end of isc::dhcp namespace
 }; // end of isc namespace
@@ -47,6 +47,27 @@ class Dhcpv6Srv;
 isc::data::ConstElementPtr
 configureDhcp6Server(Dhcpv6Srv& server, isc::data::ConstElementPtr config_set);
 
+/// @brief Adds, updates or removes a single DHCPv6 subnet.
+///
+/// This function handles the subnet6-add, subnet6-update and
+/// subnet6-del commands. It is the DHCPv6 counterpart of
+/// configureDhcp4Subnet: the subnet6-add and subnet6-update commands
+/// take the definition of the subnet, in the format of an element of the
+/// subnet6 list, as the "subnet" argument, and the subnet6-del
+/// command takes the prefix of the subnet (e.g. "2001:db8:1::/64"). The changes are
+/// not stored in the configuration of the server.
+///
+/// This function does not throw. It returns the following response codes:
+/// 0 - the subnet has been changed
+/// 1 - the command failed and the subnets are intact
+///
+/// @param command name of the command.
+/// @param args arguments of the command.
+/// @return answer that contains the result of the command.
+isc::data::ConstElementPtr
+configureDhcp6Subnet(const std::string& command,
+                     isc::data::ConstElementPtr args);
+
 }; // end of isc::dhcp namespace
 }; // end of isc namespace
 
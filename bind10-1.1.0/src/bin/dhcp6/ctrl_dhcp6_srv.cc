@@ -19,6 +19,7 @@
 #include <cc/session.h>
 #include <config/ccsession.h>
 #include <dhcp/iface_mgr.h>
+#include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dhcp_config_parser.h>
 #include <dhcp6/config_parser.h>
 #include <dhcp6/ctrl_dhcp6_srv.h>
@@ -122,6 +123,49 @@ ControlledDhcpv6Srv::dhcp6CommandHandler(const string& command, ConstElementPtr
         return (answer);
     }
 
+    if ((command == "getstats") || (command.find("stage-timing-") == 0)) {
+        if (!ControlledDhcpv6Srv::server_) {
+            LOG_WARN(dhcp6_logger, DHCP6_NOT_RUNNING);
+            return (isc::config::createAnswer(1, "Server is not running."));
+        }
+        StageProfiler& profiler =
+            ControlledDhcpv6Srv::server_->getStageProfiler();
+        if (command == "stage-timing-start") {
+            profiler.reset();
+            profiler.setEnabled(true);
+            return (isc::config::createAnswer(0, "Stage timing started."));
+        } else if (command == "stage-timing-stop") {
+            profiler.setEnabled(false);
+            return (isc::config::createAnswer(0, "Stage timing stopped."));
+        } else if ((command == "getstats") ||
+                   (command == "stage-timing-dump")) {
+            ElementPtr stats = Element::createMap();
+            if (command == "getstats") {
+                // Counters and pool sizes are reported to b10-stats only.
+                stats = ControlledDhcpv6Srv::server_->getServerCounters().
+                    toElement(&Pkt6::getName);
+                const ConstSubnet6CollectionPtr subnets =
+                    CfgMgr::instance().getSubnets6();
+                for (Subnet6Collection::const_iterator subnet =
+                         subnets->begin(); subnet != subnets->end();
+                     ++subnet) {
+                    ServerCounters::addPoolUsage(stats, **subnet);
+                }
+            }
+            stats->set("stage-timing", profiler.toElement(&Pkt6::getName));
+            if (args && (args->getType() == Element::map) &&
+                args->contains("reset") && args->get("reset")->boolValue()) {
+                profiler.reset();
+            }
+            return (isc::config::createAnswer(0, stats));
+        }
+    }
+
+    if ((command == "subnet6-add") || (command == "subnet6-update") ||
+        (command == "subnet6-del")) {
+        return (configureDhcp6Subnet(command, args));
+    }
+
     ConstElementPtr answer = isc::config::createAnswer(1,
                              "Unrecognized command.");
 
@@ -40,6 +40,49 @@
         "item_default": 4000
       },
 
+      { "item_name": "response-cache-window",
+        "item_type": "integer",
+        "item_optional": true,
+        "item_default": 0
+      },
+
+      { "item_name": "rate-limit",
+        "item_type": "integer",
+        "item_optional": true,
+        "item_default": 0
+      },
+
+      { "item_name": "rate-limit-burst",
+        "item_type": "integer",
+        "item_optional": true,
+        "item_default": 0
+      },
+
+      { "item_name": "shed-delay",
+        "item_type": "integer",
+        "item_optional": true,
+        "item_default": 0
+      },
+
+      { "item_name": "dhcp4o6-backends",
+        "item_type": "list",
+        "item_optional": true,
+        "item_default": [ "DHCPv4oDHCPv6_1" ],
+        "list_item_spec":
+        {
+          "item_name": "dhcp4o6-backend",
+          "item_type": "string",
+          "item_optional": false,
+          "item_default": ""
+        }
+      },
+
+      { "item_name": "dhcp4o6-channel-dir",
+        "item_type": "string",
+        "item_optional": true,
+        "item_default": ""
+      },
+
       { "item_name": "option-def",
         "item_type": "list",
         "item_optional": false,
@@ -289,6 +332,332 @@
                     "item_optional": true
                 }
             ]
+        },
+        {
+            "command_name": "getstats",
+            "command_description": "Returns the statistics of the DHCPv6 server.",
+            "command_args": []
+        },
+        {
+            "command_name": "stage-timing-start",
+            "command_description": "Resets the per-stage timing data and starts collecting it.",
+            "command_args": []
+        },
+        {
+            "command_name": "stage-timing-stop",
+            "command_description": "Stops collecting the per-stage timing data.",
+            "command_args": []
+        },
+        {
+            "command_name": "stage-timing-dump",
+            "command_description": "Returns the per-stage timing data.",
+            "command_args": [
+                {
+                    "item_name": "reset",
+                    "item_type": "boolean",
+                    "item_optional": true,
+                    "item_default": false
+                }
+            ]
+        },
+        {
+            "command_name": "subnet6-add",
+            "command_description": "Adds a IPv6 subnet, defined as in the subnet6 list, without reconfiguring the other subnets. The change is not stored in the configuration.",
+            "command_args": [
+                {
+                    "item_name": "subnet",
+                    "item_type": "any",
+                    "item_optional": false
+                }
+            ]
+        },
+        {
+            "command_name": "subnet6-update",
+            "command_description": "Replaces the definition of the IPv6 subnet with the same prefix. The subnet keeps its ID and allocation state. The change is not stored in the configuration.",
+            "command_args": [
+                {
+                    "item_name": "subnet",
+                    "item_type": "any",
+                    "item_optional": false
+                }
+            ]
+        },
+        {
+            "command_name": "subnet6-del",
+            "command_description": "Removes the IPv6 subnet with the given prefix. The change is not stored in the configuration.",
+            "command_args": [
+                {
+                    "item_name": "subnet",
+                    "item_type": "string",
+                    "item_optional": false
+                }
+            ]
+        }
+    ],
+    "statistics": [
+        {
+            "item_name": "parse-failed",
+            "item_type": "integer",
+            "item_optional": False,
+            "item_default": 0,
+            "item_title": "Parse failures",
+            "item_description": "Received messages which couldn't be parsed"
+        },
+        {
+            "item_name": "process-failed",
+            "item_type": "integer",
+            "item_optional": False,
+            "item_default": 0,
+            "item_title": "Processing failures",
+            "item_description": "Messages dropped due to processing errors"
+        },
+        {
+            "item_name": "no-subnet",
+            "item_type": "integer",
+            "item_optional": False,
+            "item_default": 0,
+            "item_title": "No subnet",
+            "item_description": "Messages from clients for which no subnet was selected"
+        },
+        {
+            "item_name": "alloc-failed",
+            "item_type": "integer",
+            "item_optional": False,
+            "item_default": 0,
+            "item_title": "Allocation failures",
+            "item_description": "Failed lease allocations"
+        },
+        {
+            "item_name": "send-failed",
+            "item_type": "integer",
+            "item_optional": False,
+            "item_default": 0,
+            "item_title": "Send failures",
+            "item_description": "Responses which couldn't be sent"
+        },
+        {
+            "item_name": "dhcp4o6-forwarded",
+            "item_type": "integer",
+            "item_optional": False,
+            "item_default": 0,
+            "item_title": "DHCPv4-queries forwarded",
+            "item_description": "DHCPv4-queries passed to the DHCPv4 server"
+        },
+        {
+            "item_name": "dhcp4o6-answered",
+            "item_type": "integer",
+            "item_optional": False,
+            "item_default": 0,
+            "item_title": "DHCPv4-queries answered",
+            "item_description": "DHCPv4-queries answered by the DHCPv4 server"
+        },
+        {
+            "item_name": "dhcp4o6-timed-out",
+            "item_type": "integer",
+            "item_optional": False,
+            "item_default": 0,
+            "item_title": "DHCPv4-queries timed out",
+            "item_description": "DHCPv4-queries not answered by the DHCPv4 server in time"
+        },
+        {
+            "item_name": "load-balancing-skipped",
+            "item_type": "integer",
+            "item_optional": False,
+            "item_default": 0,
+            "item_title": "Queries skipped",
+            "item_description": "Queries left to the peer server of the load balancing pair"
+        },
+        {
+            "item_name": "rate-limited",
+            "item_type": "integer",
+            "item_optional": False,
+            "item_default": 0,
+            "item_title": "Queries rate limited",
+            "item_description": "Queries dropped because their subnet exceeded the rate-limit"
+        },
+        {
+            "item_name": "overload-shed",
+            "item_type": "integer",
+            "item_optional": False,
+            "item_default": 0,
+            "item_title": "Queries shed",
+            "item_description": "Queries dropped because they waited longer than the shed-delay"
+        },
+        {
+            "item_name": "received",
+            "item_type": "named_set",
+            "item_optional": False,
+            "item_default": {},
+            "item_title": "Received messages",
+            "item_description": "Number of received messages, per message type",
+            "named_set_item_spec": {
+                "item_name": "message-type",
+                "item_type": "integer",
+                "item_optional": False,
+                "item_default": 0
+            }
+        },
+        {
+            "item_name": "sent",
+            "item_type": "named_set",
+            "item_optional": False,
+            "item_default": {},
+            "item_title": "Sent messages",
+            "item_description": "Number of sent messages, per message type",
+            "named_set_item_spec": {
+                "item_name": "message-type",
+                "item_type": "integer",
+                "item_optional": False,
+                "item_default": 0
+            }
+        },
+        {
+            "item_name": "subnets",
+            "item_type": "named_set",
+            "item_optional": False,
+            "item_default": {},
+            "item_title": "Subnets",
+            "item_description": "Lease counters and pool usage, per subnet identifier",
+            "named_set_item_spec": {
+                "item_name": "subnet-id",
+                "item_type": "map",
+                "item_optional": False,
+                "item_default": {},
+                "map_item_spec": [
+                    {
+                        "item_name": "subnet",
+                        "item_type": "string",
+                        "item_optional": True,
+                        "item_default": "",
+                        "item_title": "Subnet",
+                        "item_description": "Prefix of the subnet"
+                    },
+                    {
+                        "item_name": "received",
+                        "item_type": "integer",
+                        "item_optional": False,
+                        "item_default": 0,
+                        "item_title": "Received",
+                        "item_description": "Messages processed within the subnet"
+                    },
+                    {
+                        "item_name": "allocated",
+                        "item_type": "integer",
+                        "item_optional": False,
+                        "item_default": 0,
+                        "item_title": "Allocated",
+                        "item_description": "Leases assigned or renewed"
+                    },
+                    {
+                        "item_name": "alloc-failed",
+                        "item_type": "integer",
+                        "item_optional": False,
+                        "item_default": 0,
+                        "item_title": "Allocation failures",
+                        "item_description": "Failed lease allocations"
+                    },
+                    {
+                        "item_name": "released",
+                        "item_type": "integer",
+                        "item_optional": False,
+                        "item_default": 0,
+                        "item_title": "Released",
+                        "item_description": "Leases released by the clients"
+                    },
+                    {
+                        "item_name": "rate-limited",
+                        "item_type": "integer",
+                        "item_optional": False,
+                        "item_default": 0,
+                        "item_title": "Rate limited",
+                        "item_description": "Queries dropped because the subnet exceeded the rate-limit"
+                    },
+                    {
+                        "item_name": "shed",
+                        "item_type": "integer",
+                        "item_optional": False,
+                        "item_default": 0,
+                        "item_title": "Shed",
+                        "item_description": "Queries dropped because they waited longer than the shed-delay"
+                    },
+                    {
+                        "item_name": "total-addresses",
+                        "item_type": "integer",
+                        "item_optional": True,
+                        "item_default": 0,
+                        "item_title": "Total addresses",
+                        "item_description": "Number of addresses in the pools"
+                    }
+                ]
+            }
+        },
+        {
+            "item_name": "stage-timing",
+            "item_type": "named_set",
+            "item_optional": false,
+            "item_default": {},
+            "item_title": "Stage timing",
+            "item_description": "Time spent in the stages of the packet processing, per message type",
+            "named_set_item_spec": {
+                "item_name": "message-type",
+                "item_type": "named_set",
+                "item_optional": false,
+                "item_default": {},
+                "named_set_item_spec": {
+                    "item_name": "stage",
+                    "item_type": "map",
+                    "item_optional": false,
+                    "item_default": {},
+                    "map_item_spec": [
+                        {
+                            "item_name": "count",
+                            "item_type": "integer",
+                            "item_optional": false,
+                            "item_default": 0,
+                            "item_title": "Count",
+                            "item_description": "Number of times the stage was executed"
+                        },
+                        {
+                            "item_name": "total-ns",
+                            "item_type": "integer",
+                            "item_optional": false,
+                            "item_default": 0,
+                            "item_title": "Total time",
+                            "item_description": "Total time spent in the stage in nanoseconds"
+                        },
+                        {
+                            "item_name": "max-ns",
+                            "item_type": "integer",
+                            "item_optional": false,
+                            "item_default": 0,
+                            "item_title": "Maximum time",
+                            "item_description": "Longest execution of the stage in nanoseconds"
+                        },
+                        {
+                            "item_name": "allocations",
+                            "item_type": "integer",
+                            "item_optional": false,
+                            "item_default": 0,
+                            "item_title": "Allocations",
+                            "item_description": "Number of memory allocations made in the stage (counted only when built with --enable-alloc-counting)"
+                        },
+                        {
+                            "item_name": "histogram",
+                            "item_type": "list",
+                            "item_optional": false,
+                            "item_default": [],
+                            "item_title": "Histogram",
+                            "item_description": "Number of executions by duration; bucket 0 counts zero durations, bucket N the durations from 2^(N-1) to 2^N - 1 nanoseconds",
+                            "list_item_spec": {
+                                "item_name": "bucket",
+                                "item_type": "integer",
+                                "item_optional": false,
+                                "item_default": 0
+                            }
+                        }
+                    ]
+                }
+            }
         }
     ]
   }
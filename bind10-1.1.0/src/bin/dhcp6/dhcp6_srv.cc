@@ -25,6 +25,8 @@
 #include <dhcp/option6_iaaddr.h>
 #include <dhcp/option_custom.h>
 #include <dhcp/option_int_array.h>
+#include <dhcp/option4_scanner.h>
+#include <dhcp/pkt4.h>
 #include <dhcp/pkt6.h>
 #include <dhcp6/dhcp6_log.h>
 #include <dhcp6/dhcp6_srv.h>
@@ -38,12 +40,19 @@
 #include <util/range_utilities.h>
 #include <util/encode/hex.h>
 
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string/erase.hpp>
 
+#include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <time.h>
+#include <unistd.h>
+#include <algorithm>
 #include <iomanip>
 #include <fstream>
 
@@ -53,6 +62,106 @@ using namespace isc::dhcp;
 using namespace isc::util;
 using namespace std;
 
+namespace {
+
+/// @brief Finds the key identifying the client of a DHCPv4 message.
+///
+/// @param data DHCPv4 message
+/// @param [out] key pointer to the client identifier option data, or to
+/// the hardware address if there is no client identifier, or NULL if
+/// the message is too short
+/// @param [out] key_len length of the key
+void
+getDHCPv4ClientKey(const OptionBuffer& data, const uint8_t*& key,
+                   size_t& key_len) {
+    key = NULL;
+    key_len = 0;
+    // The hardware address follows op, htype, hlen, hops, xid, secs,
+    // flags and four addresses.
+    const size_t chaddr_offset = 28;
+    if (data.size() < Pkt4::DHCPV4_PKT_HDR_LEN) {
+        return;
+    }
+    key = &data[chaddr_offset];
+    key_len = std::min(static_cast<size_t>(data[2]), Pkt4::MAX_CHADDR_LEN);
+
+    // The options follow the magic cookie.
+    const size_t options_offset = Pkt4::DHCPV4_PKT_HDR_LEN + 4;
+    if (data.size() <= options_offset) {
+        return;
+    }
+    Option4LocationCollection options;
+    try {
+        Option4Scanner::scan(&data[options_offset],
+                             data.size() - options_offset, options);
+    } catch (const isc::Exception&) {
+        // The DHCPv4 server drops the message anyway.
+        return;
+    }
+    for (Option4LocationCollection::const_iterator option = options.begin();
+         option != options.end(); ++option) {
+        if ((option->type_ == DHO_DHCP_CLIENT_IDENTIFIER) &&
+            (option->len_ > 0)) {
+            key = &data[options_offset + option->offset_];
+            key_len = option->len_;
+            return;
+        }
+    }
+}
+
+/// @brief Connects to the abstract UNIX socket of a DHCPv4 server.
+///
+/// @param name name of the socket
+/// @return connected socket, or -1 on error
+int
+connectDHCPv4Backend(const std::string& name) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    if (name.empty() || (name.size() >= sizeof(addr.sun_path))) {
+        return (-1);
+    }
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return (-1);
+    }
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, name.c_str());
+    addr.sun_path[0] = 0;
+    const socklen_t len = name.size() + offsetof(struct sockaddr_un, sun_path);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), len) < 0) {
+        close(fd);
+        return (-1);
+    }
+    return (fd);
+}
+
+/// @brief Logs the interface changes found by IfaceMgr.
+///
+/// @param name name of the interface
+/// @param change what happened to the interface
+/// @param error why the sockets couldn't be opened, empty if they could
+void
+logIfaceChange(const std::string& name, IfaceMgr::IfaceChange change,
+               const std::string& error) {
+    if (!error.empty()) {
+        LOG_WARN(dhcp6_logger, DHCP6_IFACE_SOCKETS_FAIL).arg(name).arg(error);
+        return;
+    }
+    switch (change) {
+    case IfaceMgr::IFACE_ADDED:
+        LOG_INFO(dhcp6_logger, DHCP6_IFACE_ADDED).arg(name);
+        break;
+    case IfaceMgr::IFACE_CHANGED:
+        LOG_INFO(dhcp6_logger, DHCP6_IFACE_CHANGED).arg(name);
+        break;
+    case IfaceMgr::IFACE_REMOVED:
+        LOG_INFO(dhcp6_logger, DHCP6_IFACE_REMOVED).arg(name);
+        break;
+    }
+}
+
+}
+
 namespace isc {
 namespace dhcp {
 
@@ -66,8 +175,15 @@ namespace dhcp {
 /// run and then use it afterwards.
 static const char* SERVER_DUID_FILE = "b10-dhcp6-serverid";
 
+const long Dhcpv6Srv::DHCPV4_QUERY_TIMEOUT;
+
 Dhcpv6Srv::Dhcpv6Srv(uint16_t port)
-    : alloc_engine_(), serverid_(), shutdown_(true) {
+    : expiration_timer_(TimerMgr::INVALID_TIMER), next_4o6_expiration_(0),
+      backend_check_timer_(TimerMgr::INVALID_TIMER), shutdown_(true),
+      alloc_engine_(), serverid_() {
+
+    // A single DHCPv4 server, until the configuration says otherwise.
+    dhcp4_backends_.setMembers(std::vector<std::string>(1, FILENAME1));
 
     LOG_DEBUG(dhcp6_logger, DBG_DHCP6_START, DHCP6_OPEN_SOCKET).arg(port);
 
@@ -83,6 +199,15 @@ Dhcpv6Srv::Dhcpv6Srv(uint16_t port)
                 return;
             }
             IfaceMgr::instance().openSockets6(port);
+
+            // Interfaces added later (e.g. a VLAN or a link-local address
+            // which completed DAD) get their sockets while the server runs.
+            try {
+                IfaceMgr::instance().startIfaceTracking(logIfaceChange);
+            } catch (const std::exception& ex) {
+                LOG_WARN(dhcp6_logger, DHCP6_IFACE_TRACKING_FAIL)
+                    .arg(ex.what());
+            }
         }
 
         string duid_file = CfgMgr::instance().getDataDir() + "/" + string(SERVER_DUID_FILE);
@@ -111,11 +236,24 @@ Dhcpv6Srv::Dhcpv6Srv(uint16_t port)
         return;
     }
 
+    // Start checking for the DHCPv4-queries not answered in time.
+    expiration_timer_ = IfaceMgr::instance().getTimerMgr().
+        schedule(DHCPV4_QUERY_EXPIRATION_INTERVAL,
+                 boost::bind(&Dhcpv6Srv::expireDHCPv4Queries, this));
+    backend_check_timer_ = IfaceMgr::instance().getTimerMgr().
+        schedule(DHCPV4_BACKEND_CHECK_INTERVAL,
+                 boost::bind(&Dhcpv6Srv::checkDHCPv4Backends, this));
+
     // All done, so can proceed
     shutdown_ = false;
+    next_query_ = 0;
 }
 
 Dhcpv6Srv::~Dhcpv6Srv() {
+    IfaceMgr::instance().getTimerMgr().cancel(expiration_timer_);
+    IfaceMgr::instance().getTimerMgr().cancel(backend_check_timer_);
+    setDHCPv4ChannelDir("");
+    IfaceMgr::instance().stopIfaceTracking();
     IfaceMgr::instance().closeSockets();
 
     LeaseMgrFactory::destroy();
@@ -126,41 +264,149 @@ void Dhcpv6Srv::shutdown() {
     shutdown_ = true;
 }
 
+Pkt6Ptr Dhcpv6Srv::receivePacket(int timeout) {
+    if (next_query_ == queries_.size()) {
+        queries_.clear();
+        next_query_ = 0;
+        if (IfaceMgr::instance().receiveBatch6(queries_, timeout) == 0) {
+            return (Pkt6Ptr());
+        }
+    }
+    Pkt6Ptr query = queries_[next_query_];
+    queries_[next_query_++].reset();
+    return (query);
+}
+
+void Dhcpv6Srv::sendPackets(const Pkt6Collection& packets, size_t& sent) {
+    IfaceMgr::instance().sendBatch(packets, sent);
+}
+
+void Dhcpv6Srv::sendResponses() {
+    if (responses_.empty()) {
+        return;
+    }
+
+    {
+        // The sending time of a batch is recorded with the type 0, the
+        // batch mixing the message types.
+        StageProfiler::Timer timer(profiler_, 0, StageProfiler::SEND);
+        while (!responses_.empty()) {
+            size_t sent = 0;
+            size_t dropped = 0;
+            try {
+                sendPackets(responses_, sent);
+            } catch (const std::exception& e) {
+                LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL).arg(e.what());
+                counters_.inc(ServerCounters::SEND_FAILED);
+                dropped = 1;
+            }
+            sent = std::min(sent, responses_.size());
+            for (size_t i = 0; i < sent; ++i) {
+                counters_.incSent(responses_[i]->getType());
+            }
+            dropped = std::min(dropped, responses_.size() - sent);
+            if (sent + dropped == 0) {
+                break;
+            }
+            removeResponses(sent, dropped);
+        }
+        removeResponses(0, responses_.size());
+    }
+
+    for (Pkt6Collection::const_iterator rsp = pooled_responses_.begin();
+         rsp != pooled_responses_.end(); ++rsp) {
+        buffer_pool_.release(**rsp);
+    }
+    pooled_responses_.clear();
+}
+
+void Dhcpv6Srv::removeResponses(size_t sent, size_t dropped) {
+    for (size_t i = 0; i < sent + dropped; ++i) {
+        const Pkt6Ptr& query = response_queries_[i];
+        // Only the responses which have reached the client are cached:
+        // a retransmission of the query must be processed again if the
+        // response was lost here. Responses relayed from the DHCPv4
+        // server are not cached here. A cached response keeps its buffer
+        // until it expires.
+        if (query && ((i >= sent) ||
+                      (query->getType() == DHCPV4_RESPONSE) ||
+                      !response_cache_.insert(*query, responses_[i]))) {
+            pooled_responses_.push_back(responses_[i]);
+        }
+    }
+    responses_.erase(responses_.begin(), responses_.begin() + sent + dropped);
+    response_queries_.erase(response_queries_.begin(),
+                            response_queries_.begin() + sent + dropped);
+}
+
 bool Dhcpv6Srv::run() {
     while (!shutdown_) {
-        /// @todo: calculate actual timeout to the next event (e.g. lease
-        /// expiration) once we have lease database. The idea here is that
-        /// it is possible to do everything in a single process/thread.
-        /// For now, we are just calling select for 1000 seconds. There
-        /// were some issues reported on some systems when calling select()
-        /// with too large values. Unfortunately, I don't recall the details.
+        // The periodic tasks are run by the timers of the interface
+        // manager, which ends the wait when the next timer is due. This
+        // timeout only bounds the wait when no timer is scheduled. There
+        // were some issues reported on some systems when calling select()
+        // with too large values.
         int timeout = 1000;
 
         // client's message and server's response
         Pkt6Ptr query;
         Pkt6Ptr rsp;
 
+        // The responses to the queries received together are sent
+        // together, before waiting for more queries.
+        if (next_query_ == queries_.size()) {
+            sendResponses();
+        }
+
+        const StageProfiler::Mark wait_mark = profiler_.mark();
         try {
-            query = IfaceMgr::instance().receive6(timeout);
+            query = receivePacket(timeout);
         } catch (const std::exception& e) {
             LOG_ERROR(dhcp6_logger, DHCP6_PACKET_RECEIVE_FAIL).arg(e.what());
         }
 
         if (query) {
+            const StageProfiler::Mark unpack_mark = profiler_.mark();
             //4o6: DHCPV4_RESPONSE cannot call unpack()...
             if (query->getType() != DHCPV4_RESPONSE) {
             if (!query->unpack()) {
                 LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
                           DHCP6_PACKET_PARSE_FAIL);
+                counters_.inc(ServerCounters::PARSE_FAILED);
                 continue;
             }
+            counters_.incReceived(query->getType());
+            // Responses from the DHCPv4 server are accounted as IPC_WAIT.
+            profiler_.record(query->getType(), StageProfiler::RECEIVE_WAIT,
+                             wait_mark, unpack_mark);
+            profiler_.record(query->getType(), StageProfiler::UNPACK,
+                             unpack_mark);
             LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_PACKET_RECEIVED)
                       .arg(query->getName());
             LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA, DHCP6_QUERY_DATA)
                       .arg(static_cast<int>(query->getType()))
                       .arg(query->getBuffer().getLength())
                       .arg(query->toText());
+
+            // If this is a retransmission of a query which has been
+            // answered recently, send the same response again.
+            Pkt6Ptr cached = response_cache_.lookup(*query);
+            if (cached) {
+                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
+                          DHCP6_RESPONSE_CACHE_HIT)
+                          .arg(query->getName())
+                          .arg(query->getTransid())
+                          .arg(query->getIface());
+                responses_.push_back(cached);
+                response_queries_.push_back(Pkt6Ptr());
+                continue;
+            }
+
+            if (!admitQuery(query)) {
+                continue;
+            }
             }
+            const uint8_t msg_type = query->getType();
             try {
                 switch (query->getType()) {
                 case DHCPV6_SOLICIT:
@@ -212,6 +458,7 @@ bool Dhcpv6Srv::run() {
                 }
 
             } catch (const RFCViolation& e) {
+                counters_.inc(ServerCounters::PROCESS_FAILED);
                 LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_REQUIRED_OPTIONS_CHECK_FAIL)
                     .arg(query->getName())
                     .arg(query->getRemoteAddr())
@@ -226,6 +473,7 @@ bool Dhcpv6Srv::run() {
                 // as a debug message because debug is disabled by default -
                 // it prevents a DDOS attack based on the sending of problem
                 // packets.)
+                counters_.inc(ServerCounters::PROCESS_FAILED);
                 LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_PACKET_PROCESS_FAIL)
                     .arg(query->getName())
                     .arg(query->getRemoteAddr())
@@ -244,19 +492,25 @@ bool Dhcpv6Srv::run() {
                           DHCP6_RESPONSE_DATA)
                     .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
 
-                if (rsp->pack()) {
-                    try {
-                        IfaceMgr::instance().send(rsp);
-                    } catch (const std::exception& e) {
-                        LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL).arg(e.what());
-                    }
+                // Pack the response into a pre-allocated buffer and give
+                // the buffer back to the pool once the response is sent.
+                buffer_pool_.acquire(*rsp);
+                const StageProfiler::Mark pack_mark = profiler_.mark();
+                const bool packed = rsp->pack();
+                profiler_.record(msg_type, StageProfiler::PACK, pack_mark);
+                if (packed) {
+                    responses_.push_back(rsp);
+                    response_queries_.push_back(query);
                 } else {
                     LOG_ERROR(dhcp6_logger, DHCP6_PACK_FAIL);
+                    buffer_pool_.release(*rsp);
                 }
             }
         }
     }
 
+    sendResponses();
+
     return (true);
 }
 
@@ -535,6 +789,9 @@ Dhcpv6Srv::selectSubnet(const Pkt6Ptr& question) {
 
     /// @todo: pass interface information only if received direct (non-relayed) message
 
+    StageProfiler::Timer timer(profiler_, question->getType(),
+                               StageProfiler::SUBNET_SELECTION);
+
     // Try to find a subnet if received packet from a directly connected client
     Subnet6Ptr subnet = CfgMgr::instance().getSubnet6(question->getIface());
     if (subnet) {
@@ -547,6 +804,46 @@ Dhcpv6Srv::selectSubnet(const Pkt6Ptr& question) {
     return (subnet);
 }
 
+bool
+Dhcpv6Srv::admitQuery(const Pkt6Ptr& query) {
+    if (!rate_limiter_.isEnabled()) {
+        return (true);
+    }
+
+    Subnet6Ptr subnet = selectSubnet(query);
+    const SubnetID subnet_id = subnet ? subnet->getID() : 0;
+    const boost::posix_time::ptime now =
+        boost::posix_time::microsec_clock::universal_time();
+    switch (rate_limiter_.check(subnet_id, RateLimiter::getPriority(*query),
+                                query->getTimestamp(), now)) {
+    case RateLimiter::ACCEPT:
+        return (true);
+
+    case RateLimiter::RATE_LIMITED:
+        counters_.inc(ServerCounters::RATE_LIMITED);
+        if (subnet) {
+            counters_.incSubnet(subnet_id,
+                                ServerCounters::SUBNET_RATE_LIMITED);
+        }
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_QUERY_RATE_LIMITED)
+            .arg(query->getName())
+            .arg(query->getTransid())
+            .arg(subnet ? subnet->toText() : "(none)");
+        break;
+
+    case RateLimiter::SHED:
+        counters_.inc(ServerCounters::OVERLOAD_SHED);
+        if (subnet) {
+            counters_.incSubnet(subnet_id, ServerCounters::SUBNET_SHED);
+        }
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_QUERY_SHED)
+            .arg(query->getName())
+            .arg(query->getTransid());
+        break;
+    }
+    return (false);
+}
+
 void
 Dhcpv6Srv::assignLeases(const Pkt6Ptr& question, Pkt6Ptr& answer) {
 
@@ -569,10 +866,12 @@ Dhcpv6Srv::assignLeases(const Pkt6Ptr& question, Pkt6Ptr& answer) {
         LOG_WARN(dhcp6_logger, DHCP6_SUBNET_SELECTION_FAILED)
             .arg(question->getRemoteAddr().toText())
             .arg(question->getName());
+        counters_.inc(ServerCounters::NO_SUBNET);
 
     } else {
         LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA, DHCP6_SUBNET_SELECTED)
             .arg(subnet->toText());
+        counters_.incSubnet(subnet->getID(), ServerCounters::SUBNET_RECEIVED);
     }
 
     // @todo: We should implement Option6Duid some day, but we can do without it
@@ -665,8 +964,11 @@ Dhcpv6Srv::assignIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
     // will try to honour the hint, but it is just a hint - some other address
     // may be used instead. If fake_allocation is set to false, the lease will
     // be inserted into the LeaseMgr as well.
+    const StageProfiler::Mark lease_mark = profiler_.mark();
     Lease6Ptr lease = alloc_engine_->allocateAddress6(subnet, duid, ia->getIAID(),
                                                       hint, fake_allocation);
+    profiler_.record(question->getType(), StageProfiler::LEASE_BACKEND,
+                     lease_mark);
 
     // Create IA_NA that we will put in the response.
     // Do not use OptionDefinition to create option's instance so
@@ -681,6 +983,10 @@ Dhcpv6Srv::assignIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
             .arg(lease->addr_.toText())
             .arg(duid?duid->toText():"(no-duid)")
             .arg(ia->getIAID());
+        if (!fake_allocation) {
+            counters_.incSubnet(subnet->getID(),
+                                ServerCounters::SUBNET_ALLOCATED);
+        }
 
         ia_rsp->setT1(subnet->getT1());
         ia_rsp->setT2(subnet->getT2());
@@ -704,6 +1010,9 @@ Dhcpv6Srv::assignIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
                   DHCP6_LEASE_ADVERT_FAIL : DHCP6_LEASE_ALLOC_FAIL)
             .arg(duid?duid->toText():"(no-duid)")
             .arg(ia->getIAID());
+        counters_.inc(ServerCounters::ALLOC_FAILED);
+        counters_.incSubnet(subnet->getID(),
+                            ServerCounters::SUBNET_ALLOC_FAILED);
 
         ia_rsp->addOption(createStatusCode(STATUS_NoAddrsAvail,
                           "Sorry, no address could be allocated."));
@@ -729,8 +1038,10 @@ Dhcpv6Srv::renewIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
         return (ia_rsp);
     }
 
+    const StageProfiler::Mark lease_mark = profiler_.mark();
     Lease6Ptr lease = LeaseMgrFactory::instance().getLease6(*duid, ia->getIAID(),
                                                             subnet->getID());
+    profiler_.record(DHCPV6_RENEW, StageProfiler::LEASE_BACKEND, lease_mark);
 
     if (!lease) {
         // client renewing a lease that we don't know about.
@@ -756,7 +1067,12 @@ Dhcpv6Srv::renewIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
     lease->t2_ = subnet->getT2();
     lease->cltt_ = time(NULL);
 
-    LeaseMgrFactory::instance().updateLease6(lease);
+    {
+        StageProfiler::Timer timer(profiler_, DHCPV6_RENEW,
+                                   StageProfiler::LEASE_BACKEND);
+        LeaseMgrFactory::instance().updateLease6(lease);
+    }
+    counters_.incSubnet(subnet->getID(), ServerCounters::SUBNET_ALLOCATED);
 
     // Create empty IA_NA option with IAID matching the request.
     boost::shared_ptr<Option6IA> ia_rsp(new Option6IA(D6O_IA_NA, ia->getIAID()));
@@ -793,9 +1109,11 @@ Dhcpv6Srv::renewLeases(const Pkt6Ptr& renew, Pkt6Ptr& reply) {
         LOG_WARN(dhcp6_logger, DHCP6_SUBNET_SELECTION_FAILED)
             .arg(renew->getRemoteAddr().toText())
             .arg(renew->getName());
+        counters_.inc(ServerCounters::NO_SUBNET);
     } else {
         LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA, DHCP6_SUBNET_SELECTED)
             .arg(subnet->toText());
+        counters_.incSubnet(subnet->getID(), ServerCounters::SUBNET_RECEIVED);
     }
 
     // Let's find client's DUID. Client is supposed to include its client-id
@@ -909,7 +1227,9 @@ Dhcpv6Srv::releaseIA_NA(const DuidPtr& duid, Pkt6Ptr /* question */,
         return (ia_rsp);
     }
 
+    const StageProfiler::Mark lease_mark = profiler_.mark();
     Lease6Ptr lease = LeaseMgrFactory::instance().getLease6(release_addr->getAddress());
+    profiler_.record(DHCPV6_RELEASE, StageProfiler::LEASE_BACKEND, lease_mark);
 
     if (!lease) {
         // client releasing a lease that we don't know about.
@@ -972,7 +1292,10 @@ Dhcpv6Srv::releaseIA_NA(const DuidPtr& duid, Pkt6Ptr /* question */,
 
     // Ok, we've passed all checks. Let's release this address.
 
-    if (!LeaseMgrFactory::instance().deleteLease(lease->addr_)) {
+    const StageProfiler::Mark delete_mark = profiler_.mark();
+    const bool deleted = LeaseMgrFactory::instance().deleteLease(lease->addr_);
+    profiler_.record(DHCPV6_RELEASE, StageProfiler::LEASE_BACKEND, delete_mark);
+    if (!deleted) {
         ia_rsp->addOption(createStatusCode(STATUS_UnspecFail,
                           "Server failed to release a lease"));
 
@@ -988,6 +1311,8 @@ Dhcpv6Srv::releaseIA_NA(const DuidPtr& duid, Pkt6Ptr /* question */,
             .arg(lease->addr_.toText())
             .arg(duid->toText())
             .arg(lease->iaid_);
+        counters_.incSubnet(lease->subnet_id_,
+                            ServerCounters::SUBNET_RELEASED);
 
         ia_rsp->addOption(createStatusCode(STATUS_Success,
                           "Lease released. Thank you, please come again."));
@@ -1091,49 +1416,249 @@ Dhcpv6Srv::processInfRequest(const Pkt6Ptr& infRequest) {
 Pkt6Ptr
 Dhcpv6Srv::processDHCPv4Query(const Pkt6Ptr& request) {
     OptionPtr opt = request->getOption(OPTION_DHCPV4_MSG);
-    OptionBuffer data = opt->getData();
-    int fd;
-    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
-        //failed to create socket
+    if (!opt || opt->getData().size() < 8) {
         return Pkt6Ptr();
     }
-    struct sockaddr_un addr;
-    addr.sun_family = AF_UNIX;
-    strcpy(addr.sun_path, FILENAME1);
-    addr.sun_path[0] = 0;
-    int len = strlen(FILENAME1) + offsetof(struct sockaddr_un, sun_path);
-    int result = connect(fd, (struct sockaddr*)&addr, len);
-    if (result < 0) {
-        //failed to connect
+    const OptionBuffer& data = opt->getData();
+    if (!forwardDHCPv4Query(data)) {
         return Pkt6Ptr();
     }
-    int count = write(fd, data.data(), data.size());
-    if (count != data.size()) {
-        //send error
-    }
-    close(fd);
+    counters_.inc(ServerCounters::DHCP4O6_FORWARDED);
     uint32_t identifier = *(uint32_t*)(data.data() + 4);
     map4o6[identifier] = request;
+    const StageProfiler::Mark ipc_mark = profiler_.mark();
+    if (ipc_mark.time_) {
+        ipc_marks_[identifier] = ipc_mark;
+    }
 
     return Pkt6Ptr();
 }
 
+bool
+Dhcpv6Srv::forwardDHCPv4Query(const OptionBuffer& data) {
+    // The client is identified by its client identifier if it has one,
+    // or by its hardware address.
+    const uint8_t* key = NULL;
+    size_t key_len = 0;
+    getDHCPv4ClientKey(data, key, key_len);
+
+    for (;;) {
+        const size_t backend = dhcp4_backends_.select(key, key_len);
+        if (backend == HashRing::NO_MEMBER) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
+                      DHCP6_DHCP4_NO_BACKEND);
+            return (false);
+        }
+        const std::string& name = dhcp4_backends_.getMembers()[backend];
+        if (pushDHCPv4Query(name, data) || sendDHCPv4Query(name, data)) {
+            return (true);
+        }
+        // The clients of this server are spread over the others until
+        // it is back.
+        LOG_WARN(dhcp6_logger, DHCP6_DHCP4_BACKEND_DOWN).arg(name);
+        dhcp4_backends_.setUp(backend, false);
+    }
+}
+
+bool
+Dhcpv6Srv::pushDHCPv4Query(const std::string& backend,
+                           const OptionBuffer& data) {
+    std::map<std::string, Shm4o6ChannelPtr>::const_iterator channel =
+        dhcp4_channels_.find(backend);
+    if (channel == dhcp4_channels_.end()) {
+        return (false);
+    }
+    if (channel->second->isClosed()) {
+        // The DHCPv4 server has stopped; it may be back on the socket.
+        closeDHCPv4Channel(backend);
+        return (false);
+    }
+    ShmRing& ring = channel->second->getOutbound();
+    if (data.empty() || (data.size() > ring.getMaxMessageLen()) ||
+        !ring.push(&data[0], data.size())) {
+        // The ring is full: the socket is used instead.
+        return (false);
+    }
+    // The DHCPv4 server blocked in select() is woken up by a connection
+    // to its socket.
+    if (!ring.isWaiting() || probeDHCPv4Backend(backend)) {
+        return (true);
+    }
+    // The DHCPv4 server is gone without closing the channel.
+    closeDHCPv4Channel(backend);
+    return (false);
+}
+
+bool
+Dhcpv6Srv::sendDHCPv4Query(const std::string& backend,
+                           const OptionBuffer& data) {
+    const int fd = connectDHCPv4Backend(backend);
+    if (fd < 0) {
+        return (false);
+    }
+    const ssize_t count = write(fd, &data[0], data.size());
+    close(fd);
+    return (count == static_cast<ssize_t>(data.size()));
+}
+
+void
+Dhcpv6Srv::setDHCPv4ChannelDir(const std::string& dir) {
+    if (dir != dhcp4_channel_dir_) {
+        while (!dhcp4_channels_.empty()) {
+            closeDHCPv4Channel(dhcp4_channels_.begin()->first);
+        }
+        dhcp4_channel_dir_ = dir;
+    }
+    syncDHCPv4Channels();
+}
+
+void
+Dhcpv6Srv::syncDHCPv4Channels() {
+    const std::vector<std::string>& names = dhcp4_backends_.getMembers();
+    std::vector<std::string> unused;
+    for (std::map<std::string, Shm4o6ChannelPtr>::const_iterator channel =
+             dhcp4_channels_.begin(); channel != dhcp4_channels_.end();
+         ++channel) {
+        if (channel->second->isClosed() ||
+            (std::find(names.begin(), names.end(), channel->first) ==
+             names.end())) {
+            unused.push_back(channel->first);
+        }
+    }
+    for (size_t i = 0; i < unused.size(); ++i) {
+        closeDHCPv4Channel(unused[i]);
+    }
+
+    if (dhcp4_channel_dir_.empty()) {
+        return;
+    }
+    for (size_t backend = 0; backend < names.size(); ++backend) {
+        if (dhcp4_channels_.count(names[backend]) > 0) {
+            continue;
+        }
+        try {
+            Shm4o6ChannelPtr channel = Shm4o6Channel::open(
+                Shm4o6Channel::getPath(dhcp4_channel_dir_, names[backend]));
+            // A channel closed before it was opened is left for the
+            // next check.
+            if (!channel->isClosed()) {
+                dhcp4_channels_[names[backend]] = channel;
+                IfaceMgr::instance().add4o6Channel(channel);
+                LOG_INFO(dhcp6_logger, DHCP6_DHCP4_CHANNEL_OPENED)
+                    .arg(channel->getPathName()).arg(names[backend]);
+            }
+        } catch (const ShmChannelError& ex) {
+            // The DHCPv4 server doesn't use a channel (yet).
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
+                      DHCP6_DHCP4_CHANNEL_UNAVAILABLE)
+                .arg(names[backend]).arg(ex.what());
+        }
+    }
+}
+
+void
+Dhcpv6Srv::closeDHCPv4Channel(const std::string& backend) {
+    std::map<std::string, Shm4o6ChannelPtr>::iterator channel =
+        dhcp4_channels_.find(backend);
+    if (channel == dhcp4_channels_.end()) {
+        return;
+    }
+    LOG_INFO(dhcp6_logger, DHCP6_DHCP4_CHANNEL_CLOSED)
+        .arg(channel->second->getPathName()).arg(backend);
+    IfaceMgr::instance().remove4o6Channel(channel->second);
+    dhcp4_channels_.erase(channel);
+}
+
+bool
+Dhcpv6Srv::probeDHCPv4Backend(const std::string& backend) {
+    const int fd = connectDHCPv4Backend(backend);
+    if (fd < 0) {
+        return (false);
+    }
+    close(fd);
+    return (true);
+}
+
+void
+Dhcpv6Srv::checkDHCPv4Backends() {
+    const std::vector<std::string>& names = dhcp4_backends_.getMembers();
+    for (size_t backend = 0; backend < names.size(); ++backend) {
+        if (!dhcp4_backends_.isUp(backend) &&
+            probeDHCPv4Backend(names[backend])) {
+            LOG_INFO(dhcp6_logger, DHCP6_DHCP4_BACKEND_UP)
+                .arg(names[backend]);
+            dhcp4_backends_.setUp(backend, true);
+        }
+    }
+    syncDHCPv4Channels();
+
+    // The timer is already gone when it has run this, but not when the
+    // check was called directly.
+    TimerMgr& timers = IfaceMgr::instance().getTimerMgr();
+    timers.cancel(backend_check_timer_);
+    backend_check_timer_ = timers.
+        schedule(DHCPV4_BACKEND_CHECK_INTERVAL,
+                 boost::bind(&Dhcpv6Srv::checkDHCPv4Backends, this));
+}
+
+void
+Dhcpv6Srv::expireDHCPv4Queries() {
+    const boost::posix_time::ptime deadline =
+        boost::posix_time::microsec_clock::universal_time() -
+        boost::posix_time::seconds(DHCPV4_QUERY_TIMEOUT);
+    std::map<uint32_t, Pkt6Ptr>::iterator query =
+        map4o6.lower_bound(next_4o6_expiration_);
+    for (size_t checked = 0; (query != map4o6.end()) &&
+             (checked < DHCPV4_QUERY_EXPIRATION_SLICE); ++checked) {
+        if (query->second && (query->second->getTimestamp() >= deadline)) {
+            ++query;
+            continue;
+        }
+        ipc_marks_.erase(query->first);
+        map4o6.erase(query++);
+        counters_.inc(ServerCounters::DHCP4O6_TIMED_OUT);
+    }
+
+    // Continue with the rest of the map as soon as possible, or start
+    // over after the interval.
+    uint32_t delay = DHCPV4_QUERY_EXPIRATION_INTERVAL;
+    if (query != map4o6.end()) {
+        next_4o6_expiration_ = query->first;
+        delay = 0;
+    } else {
+        next_4o6_expiration_ = 0;
+    }
+    expiration_timer_ = IfaceMgr::instance().getTimerMgr().
+        schedule(delay, boost::bind(&Dhcpv6Srv::expireDHCPv4Queries, this));
+}
+
 /* 4o6 */
 Pkt6Ptr
 Dhcpv6Srv::processDHCPv4Response(Pkt6Ptr& request) {
+    if (request->data4o6_.size() < 8) {
+        return Pkt6Ptr();
+    }
     uint32_t identifier = *(uint32_t*)(request->data4o6_.data() + 4);
     if (map4o6.count(identifier) && map4o6[identifier]) {
         Pkt6Ptr reply = request;
         request = map4o6[identifier];
         map4o6.erase(identifier);
+        counters_.inc(ServerCounters::DHCP4O6_ANSWERED);
+
+        std::map<uint32_t, StageProfiler::Mark>::iterator ipc_mark =
+            ipc_marks_.find(identifier);
+        if (ipc_mark != ipc_marks_.end()) {
+            profiler_.record(DHCPV4_QUERY, StageProfiler::IPC_WAIT,
+                             ipc_mark->second);
+            ipc_marks_.erase(ipc_mark);
+        }
         
         copyDefaultOptions(request, reply);
         appendDefaultOptions(request, reply);
         appendRequestedOptions(request, reply);
             
-        //append OPTION_DHCPV4_MSG
-        OptionPtr option(new Option(Option::V6, OPTION_DHCPV4_MSG, reply->data4o6_));
-        reply->addOption(option);
+        // OPTION_DHCPV4_MSG is not added as an Option: Pkt6::pack() writes
+        // the DHCPv4 message held in data4o6_ directly into the response.
         return (reply);
     }
     return Pkt6Ptr();
@@ -21,7 +21,15 @@
 #include <dhcp/option6_ia.h>
 #include <dhcp/option_definition.h>
 #include <dhcp/pkt6.h>
+#include <dhcp/pkt_buffer_pool.h>
+#include <dhcp/response_cache.h>
+#include <dhcp/shm_ring.h>
+#include <dhcp/timer_mgr.h>
 #include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/hash_ring.h>
+#include <dhcpsrv/rate_limiter.h>
+#include <dhcpsrv/server_counters.h>
+#include <dhcpsrv/stage_profiler.h>
 #include <dhcpsrv/subnet.h>
 
 #include <boost/noncopyable.hpp>
@@ -87,8 +95,173 @@ public:
     /// @brief Instructs the server to shut down.
     void shutdown();
 
+    /// @brief Sets the time for which responses are cached.
+    ///
+    /// Queries retransmitted by clients within this time are answered
+    /// with the response sent to the original query, without processing
+    /// them again.
+    ///
+    /// @param window time in milliseconds, 0 disables the cache.
+    void setResponseCacheWindow(uint32_t window) {
+        response_cache_.setWindow(window);
+    }
+
+    /// @brief Returns the cache of sent responses.
+    const ResponseCache6& getResponseCache() const {
+        return (response_cache_);
+    }
+
+    /// @brief Returns the profiler of the message processing stages.
+    StageProfiler& getStageProfiler() {
+        return (profiler_);
+    }
+
+    /// @brief Returns the statistics counters.
+    ServerCounters& getServerCounters() {
+        return (counters_);
+    }
+
+    /// @brief Returns the limits of the queries processed when overloaded.
+    RateLimiter& getRateLimiter() {
+        return (rate_limiter_);
+    }
+
+    /// @brief Sets the DHCPv4 servers the DHCPv4-queries are forwarded to.
+    ///
+    /// 4o6: each DHCPv4 server receives the queries on the abstract UNIX
+    /// socket of the given name (see the -u option of b10-dhcp4). The
+    /// queries are spread over the servers by a consistent hash of the
+    /// DHCPv4 client identifier, or of the hardware address if there is
+    /// none, so all messages of a client go to the same server as long as
+    /// it is up. The servers which are up keep their state.
+    ///
+    /// @param names names of the sockets of the DHCPv4 servers.
+    /// @throw isc::BadValue if a name is given twice.
+    void setDHCPv4Backends(const std::vector<std::string>& names) {
+        dhcp4_backends_.setMembers(names);
+        syncDHCPv4Channels();
+    }
+
+    /// @brief Returns the DHCPv4 servers the DHCPv4-queries are
+    /// forwarded to.
+    const HashRing& getDHCPv4Backends() const {
+        return (dhcp4_backends_);
+    }
+
+    /// @brief Sets the directory of the shared memory channels.
+    ///
+    /// 4o6: the DHCPv4 servers started with the -m option create a shared
+    /// memory channel in the directory (see @ref Shm4o6Channel). The
+    /// DHCPv4-queries to these servers, and their responses, are passed
+    /// through the channels rather than through the UNIX sockets. The
+    /// channels which don't exist yet are opened by
+    /// @ref checkDHCPv4Backends.
+    ///
+    /// @param dir directory of the channels, empty to use the sockets only.
+    void setDHCPv4ChannelDir(const std::string& dir);
+
+    /// @brief Returns the directory of the shared memory channels.
+    const std::string& getDHCPv4ChannelDir() const {
+        return (dhcp4_channel_dir_);
+    }
+
 protected:
 
+    /// @brief Receives a packet from the clients or the DHCPv4 server.
+    ///
+    /// The packets are received through the IfaceMgr, all the packets
+    /// waiting on a socket together (see IfaceMgr::receiveBatch6): the
+    /// next calls return the other packets of the batch without waiting.
+    /// Derived classes may feed the server from elsewhere, e.g. to replay
+    /// captured traffic without sockets.
+    ///
+    /// @param timeout timeout in seconds
+    /// @return received packet or NULL if none was received in time
+    virtual Pkt6Ptr receivePacket(int timeout);
+
+    /// @brief Sends responses.
+    ///
+    /// The responses are sent in order through the IfaceMgr (see
+    /// IfaceMgr::sendBatch).
+    ///
+    /// @param packets packed responses
+    /// @param [out] sent number of responses sent. If an exception is
+    /// thrown, the response which couldn't be sent is packets[sent].
+    /// @throw isc::Exception if a response couldn't be sent
+    virtual void sendPackets(const Pkt6Collection& packets, size_t& sent);
+
+    /// @brief Sends the responses to the queries processed so far.
+    ///
+    /// The server calls it when all the queries received together are
+    /// processed, before waiting for more queries. A response which
+    /// can't be sent is logged and dropped, the next ones being sent.
+    void sendResponses();
+
+    /// @brief Removes the handled responses from the queue.
+    ///
+    /// The responses which have been sent are stored in the response
+    /// cache. The buffers of the other responses go back to the pool.
+    ///
+    /// @param sent number of responses sent, from the front of the queue.
+    /// @param dropped number of responses which couldn't be sent,
+    /// following the sent ones.
+    void removeResponses(size_t sent, size_t dropped);
+
+    /// @brief Passes a DHCPv4 message to a DHCPv4 server.
+    ///
+    /// 4o6: the content of the DHCPv4 Message option of a DHCPv4-query
+    /// is passed to the DHCPv4 server the client is mapped to (see
+    /// @ref setDHCPv4Backends), through its shared memory channel if it
+    /// has one, through its socket otherwise. If the server can't be
+    /// reached, it is marked as down and the message is passed to the
+    /// next server.
+    ///
+    /// @param data DHCPv4 message
+    /// @return true if the message was passed, false otherwise
+    virtual bool forwardDHCPv4Query(const OptionBuffer& data);
+
+    /// @brief Passes a DHCPv4 message through the shared memory channel
+    /// of a DHCPv4 server.
+    ///
+    /// @param backend name of the socket of the DHCPv4 server
+    /// @param data DHCPv4 message
+    /// @return false if there is no usable channel to the DHCPv4 server
+    /// or its ring is full
+    bool pushDHCPv4Query(const std::string& backend,
+                         const OptionBuffer& data);
+
+    /// @brief Writes a DHCPv4 message to the socket of a DHCPv4 server.
+    ///
+    /// @param backend name of the socket of the DHCPv4 server
+    /// @param data DHCPv4 message
+    /// @return false if the DHCPv4 server couldn't be reached
+    virtual bool sendDHCPv4Query(const std::string& backend,
+                                 const OptionBuffer& data);
+
+    /// @brief Checks if a DHCPv4 server accepts connections.
+    ///
+    /// @param backend name of the socket of the DHCPv4 server
+    /// @return true if the connection succeeded
+    virtual bool probeDHCPv4Backend(const std::string& backend);
+
+    /// @brief Brings back the DHCPv4 servers which accept connections again.
+    ///
+    /// The DHCPv4 servers marked as down are probed and the ones which
+    /// accept connections get their clients back. The shared memory
+    /// channels are opened or closed like the DHCPv4 servers. The method
+    /// is run by a timer of the interface manager every
+    /// @ref DHCPV4_BACKEND_CHECK_INTERVAL milliseconds.
+    void checkDHCPv4Backends();
+
+    /// @brief Opens the missing shared memory channels, closes the ones
+    /// which are no longer used.
+    void syncDHCPv4Channels();
+
+    /// @brief Closes the shared memory channel of a DHCPv4 server.
+    ///
+    /// @param backend name of the socket of the DHCPv4 server
+    void closeDHCPv4Channel(const std::string& backend);
+
     /// @brief verifies if specified packet meets RFC requirements
     ///
     /// Checks if mandatory option is really there, that forbidden option
@@ -166,8 +339,56 @@ protected:
     /// 4o6: process DHCPv4-query message
     Pkt6Ptr processDHCPv4Response(Pkt6Ptr& request);
     
+    /// @brief Drops the DHCPv4-queries not answered in time.
+    ///
+    /// The queries forwarded to the DHCPv4 server more than
+    /// @ref DHCPV4_QUERY_TIMEOUT seconds ago are removed from map4o6 and
+    /// counted as timed out. The method is run by a timer of the interface
+    /// manager. It checks at most @ref DHCPV4_QUERY_EXPIRATION_SLICE
+    /// queries at a time and continues with the next ones at the next tick
+    /// of the timers; the whole map is checked once per second.
+    void expireDHCPv4Queries();
+
+    /// @brief Time (in seconds) the DHCPv4 server has to answer a
+    /// DHCPv4-query.
+    static const long DHCPV4_QUERY_TIMEOUT = 10;
+
+    /// @brief Interval (in milliseconds) between the checks of map4o6.
+    static const uint32_t DHCPV4_QUERY_EXPIRATION_INTERVAL = 1000;
+
+    /// @brief Maximum number of DHCPv4-queries checked by a single call
+    /// to @ref expireDHCPv4Queries.
+    static const size_t DHCPV4_QUERY_EXPIRATION_SLICE = 256;
+
+    /// @brief Interval (in milliseconds) between the probes of the DHCPv4
+    /// servers which are down.
+    static const uint32_t DHCPV4_BACKEND_CHECK_INTERVAL = 5000;
+
     /// 4o6: set of received DHCPv4-query packets, indexed by identifiers in the DHCPv4 message
     std::map<uint32_t, Pkt6Ptr> map4o6;
+
+    /// 4o6: timer running @ref expireDHCPv4Queries
+    TimerMgr::TimerId expiration_timer_;
+
+    /// 4o6: identifier of the DHCPv4-query the next check of map4o6
+    /// starts from
+    uint32_t next_4o6_expiration_;
+
+    /// 4o6: times at which the DHCPv4-query packets were forwarded to the
+    /// DHCPv4 server (only when the stage profiler is enabled)
+    std::map<uint32_t, StageProfiler::Mark> ipc_marks_;
+
+    /// 4o6: DHCPv4 servers the DHCPv4-queries are forwarded to
+    HashRing dhcp4_backends_;
+
+    /// 4o6: timer running @ref checkDHCPv4Backends
+    TimerMgr::TimerId backend_check_timer_;
+
+    /// 4o6: directory of the shared memory channels (empty if none)
+    std::string dhcp4_channel_dir_;
+
+    /// 4o6: shared memory channels of the DHCPv4 servers, by socket name
+    std::map<std::string, Shm4o6ChannelPtr> dhcp4_channels_;
     
     /// @brief Creates status-code option.
     ///
@@ -182,6 +403,14 @@ protected:
     /// @return selected subnet (or NULL if no suitable subnet was found)
     isc::dhcp::Subnet6Ptr selectSubnet(const Pkt6Ptr& question);
 
+    /// @brief Checks if a query is processed, see @ref RateLimiter.
+    ///
+    /// The dropped queries are counted and logged.
+    ///
+    /// @param query parsed DHCPv6 query
+    /// @return false if the query is dropped
+    bool admitQuery(const Pkt6Ptr& query);
+
     /// @brief Processes IA_NA option (and assigns addresses if necessary).
     ///
     /// Generates response to IA_NA. This typically includes selecting (and
@@ -330,6 +559,10 @@ protected:
     /// @return string representation
     static std::string duidToString(const OptionPtr& opt);
 
+    /// Indicates if shutdown is in progress. Setting it to true will
+    /// initiate server shutdown procedure.
+    volatile bool shutdown_;
+
 private:
     /// @brief Allocation Engine.
     /// Pointer to the allocation engine that we are currently using
@@ -340,9 +573,36 @@ private:
     /// Server DUID (to be sent in server-identifier option)
     OptionPtr serverid_;
 
-    /// Indicates if shutdown is in progress. Setting it to true will
-    /// initiate server shutdown procedure.
-    volatile bool shutdown_;
+    /// Pool of output buffers used to pack responses.
+    PktBufferPool buffer_pool_;
+
+    /// Queries received together, see receivePacket().
+    Pkt6Collection queries_;
+
+    /// Index of the next query of queries_ to be processed.
+    size_t next_query_;
+
+    /// Responses waiting to be sent, see sendResponses().
+    Pkt6Collection responses_;
+
+    /// Queries answered by responses_, in the same order. The query is
+    /// NULL for a response taken from the response cache.
+    Pkt6Collection response_queries_;
+
+    /// Responses which buffers go back to the pool once sent.
+    Pkt6Collection pooled_responses_;
+
+    /// Responses sent recently, used to answer retransmissions.
+    ResponseCache6 response_cache_;
+
+    /// Processing time of the message handling stages.
+    StageProfiler profiler_;
+
+    /// @brief Statistics counters reported to b10-stats.
+    ServerCounters counters_;
+
+    /// Drops queries when the server is overloaded.
+    RateLimiter rate_limiter_;
 };
 
 }; // namespace isc::dhcp
@@ -19,6 +19,10 @@
 #include <log/logger_support.h>
 #include <log/logger_manager.h>
 
+#ifdef ENABLE_ALLOC_COUNTING
+#include <bench/alloc_counter.h>
+#endif
+
 #include <boost/lexical_cast.hpp>
 
 #include <iostream>
@@ -102,6 +106,12 @@ main(int argc, char* argv[]) {
               .arg(getpid()).arg(port_number).arg(verbose_mode ? "yes" : "no")
               .arg(stand_alone ? "yes" : "no" );
 
+#ifdef ENABLE_ALLOC_COUNTING
+    // Report the memory allocations in the per-stage timing statistics.
+    isc::dhcp::StageProfiler::setAllocCounter(
+        &isc::bench::AllocCounter::getCount);
+#endif
+
     int ret = EXIT_SUCCESS;
     try {
         ControlledDhcpv6Srv server(port_number);
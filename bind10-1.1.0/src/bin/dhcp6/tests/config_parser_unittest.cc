@@ -337,6 +337,74 @@ TEST_F(Dhcp6ParserTest, emptySubnet) {
     EXPECT_EQ(0, rcode_);
 }
 
+// Checks that the response cache window is passed to the server.
+TEST_F(Dhcp6ParserTest, responseCacheWindow) {
+
+    ConstElementPtr status;
+
+    EXPECT_FALSE(srv_.getResponseCache().isEnabled());
+
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                    Element::fromJSON("{ \"interface\": [ \"all\" ],"
+                                      "\"preferred-lifetime\": 3000,"
+                                      "\"rebind-timer\": 2000, "
+                                      "\"renew-timer\": 1000, "
+                                      "\"response-cache-window\": 3000, "
+                                      "\"subnet6\": [  ], "
+                                      "\"valid-lifetime\": 4000 }")));
+
+    // returned value should be 0 (success)
+    ASSERT_TRUE(status);
+    comment_ = parseAnswer(rcode_, status);
+    EXPECT_EQ(0, rcode_);
+
+    EXPECT_TRUE(srv_.getResponseCache().isEnabled());
+    EXPECT_EQ(3000, srv_.getResponseCache().getWindow());
+
+    // Removing the window from the configuration disables the cache.
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                    Element::fromJSON("{ \"interface\": [ \"all\" ],"
+                                      "\"preferred-lifetime\": 3000,"
+                                      "\"rebind-timer\": 2000, "
+                                      "\"renew-timer\": 1000, "
+                                      "\"subnet6\": [  ], "
+                                      "\"valid-lifetime\": 4000 }")));
+    ASSERT_TRUE(status);
+    comment_ = parseAnswer(rcode_, status);
+    EXPECT_EQ(0, rcode_);
+
+    EXPECT_FALSE(srv_.getResponseCache().isEnabled());
+    EXPECT_EQ(0, srv_.getResponseCache().getWindow());
+}
+
+// Checks that the rate limiting and the shedding are passed to the server.
+TEST_F(Dhcp6ParserTest, rateLimit) {
+
+    ConstElementPtr status;
+
+    EXPECT_FALSE(srv_.getRateLimiter().isEnabled());
+
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                    Element::fromJSON("{ \"interface\": [ \"all\" ],"
+                                      "\"preferred-lifetime\": 3000,"
+                                      "\"rate-limit\": 100, "
+                                      "\"rebind-timer\": 2000, "
+                                      "\"renew-timer\": 1000, "
+                                      "\"shed-delay\": 250, "
+                                      "\"subnet6\": [  ], "
+                                      "\"valid-lifetime\": 4000 }")));
+
+    // returned value should be 0 (success)
+    ASSERT_TRUE(status);
+    comment_ = parseAnswer(rcode_, status);
+    EXPECT_EQ(0, rcode_);
+
+    // The burst defaults to one second of queries.
+    EXPECT_EQ(100, srv_.getRateLimiter().getRate());
+    EXPECT_EQ(100, srv_.getRateLimiter().getBurst());
+    EXPECT_EQ(250, srv_.getRateLimiter().getShedDelay());
+}
+
 /// The goal of this test is to verify if defined subnet uses global
 /// parameter timer definitions.
 TEST_F(Dhcp6ParserTest, subnetGlobalDefaults) {
@@ -371,6 +439,120 @@ TEST_F(Dhcp6ParserTest, subnetGlobalDefaults) {
     EXPECT_EQ(4000, subnet->getValid());
 }
 
+// Checks that a subnet which is kept when the server is reconfigured
+// keeps its ID, and that the removed subnets are removed.
+TEST_F(Dhcp6ParserTest, reconfigureKeepsSubnetId) {
+
+    ConstElementPtr status;
+
+    string config = "{ \"interface\": [ \"all\" ],"
+        "\"preferred-lifetime\": 3000,"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet6\": [ { "
+        "    \"pool\": [ \"2001:db8:1::1 - 2001:db8:1::ffff\" ],"
+        "    \"subnet\": \"2001:db8:1::/64\" },"
+        "  { \"pool\": [ \"2001:db8:2::1 - 2001:db8:2::ffff\" ],"
+        "    \"subnet\": \"2001:db8:2::/64\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                                                  Element::fromJSON(config)));
+    ASSERT_TRUE(status);
+    comment_ = parseAnswer(rcode_, status);
+    EXPECT_EQ(0, rcode_);
+    Subnet6Ptr subnet = CfgMgr::instance().getSubnet6(IOAddress("2001:db8:1::5"));
+    ASSERT_TRUE(subnet);
+    const SubnetID id = subnet->getID();
+
+    // Only the first subnet is left, with new timers.
+    config = "{ \"interface\": [ \"all\" ],"
+        "\"preferred-lifetime\": 3000,"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet6\": [ { "
+        "    \"pool\": [ \"2001:db8:1::1 - 2001:db8:1::ffff\" ],"
+        "    \"subnet\": \"2001:db8:1::/64\" } ],"
+        "\"valid-lifetime\": 5000 }";
+
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                                                  Element::fromJSON(config)));
+    ASSERT_TRUE(status);
+    comment_ = parseAnswer(rcode_, status);
+    EXPECT_EQ(0, rcode_);
+    ASSERT_EQ(1, CfgMgr::instance().getSubnets6()->size());
+    subnet = CfgMgr::instance().getSubnets6()->at(0);
+    EXPECT_EQ(id, subnet->getID());
+    EXPECT_EQ(5000, subnet->getValid());
+}
+
+// Checks that single subnets can be added, updated and removed with
+// commands, without affecting the other subnets.
+TEST_F(Dhcp6ParserTest, subnetCommands) {
+
+    ConstElementPtr status;
+
+    string config = "{ \"interface\": [ \"all\" ],"
+        "\"preferred-lifetime\": 3000,"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet6\": [ { "
+        "    \"pool\": [ \"2001:db8:1::1 - 2001:db8:1::ffff\" ],"
+        "    \"subnet\": \"2001:db8:1::/64\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                                                  Element::fromJSON(config)));
+    ASSERT_TRUE(status);
+    comment_ = parseAnswer(rcode_, status);
+    ASSERT_EQ(0, rcode_);
+    Subnet6Ptr subnet1 = CfgMgr::instance().getSubnets6()->at(0);
+
+    status = configureDhcp6Subnet("subnet6-add", Element::fromJSON(
+        "{ \"subnet\": { \"pool\": [ \"2001:db8:2::/80\" ],"
+        "                \"subnet\": \"2001:db8:2::/64\" } }"));
+    comment_ = parseAnswer(rcode_, status);
+    EXPECT_EQ(0, rcode_);
+    ASSERT_EQ(2, CfgMgr::instance().getSubnets6()->size());
+    Subnet6Ptr subnet2 = CfgMgr::instance().getSubnets6()->at(1);
+    EXPECT_EQ(3000, subnet2->getPreferred());
+
+    status = configureDhcp6Subnet("subnet6-update", Element::fromJSON(
+        "{ \"subnet\": { \"pool\": [ \"2001:db8:2::/80\" ],"
+        "                \"subnet\": \"2001:db8:2::/64\","
+        "                \"preferred-lifetime\": 3500 } }"));
+    comment_ = parseAnswer(rcode_, status);
+    EXPECT_EQ(0, rcode_);
+    Subnet6Ptr subnet = CfgMgr::instance().getSubnets6()->at(1);
+    EXPECT_EQ(subnet2->getID(), subnet->getID());
+    EXPECT_EQ(3500, subnet->getPreferred());
+
+    status = configureDhcp6Subnet("subnet6-del", Element::fromJSON(
+        "{ \"subnet\": \"2001:db8:1::/64\" }"));
+    comment_ = parseAnswer(rcode_, status);
+    EXPECT_EQ(0, rcode_);
+    ASSERT_EQ(1, CfgMgr::instance().getSubnets6()->size());
+    EXPECT_EQ(subnet, CfgMgr::instance().getSubnets6()->at(0));
+
+    status = configureDhcp6Subnet("subnet6-del", Element::fromJSON(
+        "{ \"subnet\": \"2001:db8:1::/64\" }"));
+    comment_ = parseAnswer(rcode_, status);
+    EXPECT_EQ(1, rcode_);
+
+    // A prefix length out of range is rejected, and doesn't wrap around
+    // to the length of the remaining subnet (320 is 64 modulo 256).
+    status = configureDhcp6Subnet("subnet6-del", Element::fromJSON(
+        "{ \"subnet\": \"2001:db8:2::/129\" }"));
+    comment_ = parseAnswer(rcode_, status);
+    EXPECT_EQ(1, rcode_);
+    status = configureDhcp6Subnet("subnet6-del", Element::fromJSON(
+        "{ \"subnet\": \"2001:db8:2::/320\" }"));
+    comment_ = parseAnswer(rcode_, status);
+    EXPECT_EQ(1, rcode_);
+    ASSERT_EQ(1, CfgMgr::instance().getSubnets6()->size());
+    EXPECT_EQ(subnet, CfgMgr::instance().getSubnets6()->at(0));
+}
+
 // This test checks if it is possible to override global values
 // on a per subnet basis.
 TEST_F(Dhcp6ParserTest, subnetLocal) {
@@ -18,6 +18,7 @@
 #include <config/ccsession.h>
 #include <dhcp/dhcp6.h>
 #include <dhcp/duid.h>
+#include <dhcp/iface_mgr.h>
 #include <dhcp/option.h>
 #include <dhcp/option_custom.h>
 #include <dhcp/option6_addrlst.h>
@@ -36,8 +37,10 @@
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
 #include <unistd.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <set>
 #include <sstream>
 
 using namespace isc;
@@ -75,6 +78,50 @@ public:
     using Dhcpv6Srv::sanityCheck;
     using Dhcpv6Srv::loadServerID;
     using Dhcpv6Srv::writeServerID;
+    using Dhcpv6Srv::expireDHCPv4Queries;
+    using Dhcpv6Srv::map4o6;
+    using Dhcpv6Srv::expiration_timer_;
+    using Dhcpv6Srv::DHCPV4_QUERY_EXPIRATION_SLICE;
+    using Dhcpv6Srv::forwardDHCPv4Query;
+    using Dhcpv6Srv::checkDHCPv4Backends;
+    using Dhcpv6Srv::backend_check_timer_;
+    using Dhcpv6Srv::dhcp4_channels_;
+};
+
+/// @brief DHCPv6 server passing the DHCPv4-queries to fake DHCPv4 servers.
+class BackendDhcpv6Srv : public NakedDhcpv6Srv {
+public:
+    BackendDhcpv6Srv() : NakedDhcpv6Srv(0) {
+    }
+
+    /// DHCPv4 servers accepting connections.
+    std::set<std::string> reachable_;
+
+    /// DHCPv4 servers the queries were passed to, in order.
+    std::vector<std::string> sent_;
+
+protected:
+    virtual bool sendDHCPv4Query(const std::string& backend,
+                                 const OptionBuffer&) {
+        if (reachable_.count(backend) == 0) {
+            return (false);
+        }
+        sent_.push_back(backend);
+        return (true);
+    }
+
+    virtual bool probeDHCPv4Backend(const std::string& backend) {
+        return (reachable_.count(backend) > 0);
+    }
+};
+
+/// @brief DHCPv6 packet with a timestamp set by the test.
+class TimestampedPkt6 : public Pkt6 {
+public:
+    TimestampedPkt6(uint8_t msg_type, const boost::posix_time::ptime& time)
+        : Pkt6(msg_type, 0) {
+        timestamp_ = time;
+    }
 };
 
 static const char* DUID_FILE = "server-id-test.txt";
@@ -1624,6 +1671,277 @@ TEST_F(Dhcpv6SrvTest, ServerID) {
     EXPECT_EQ(duid1_text, text);
 }
 
+// This test verifies that the DHCPv4-queries not answered in time are
+// dropped by a timer, a bounded number at a time.
+TEST_F(Dhcpv6SrvTest, expireDHCPv4Queries) {
+    using namespace boost::posix_time;
+
+    boost::scoped_ptr<NakedDhcpv6Srv> srv(new NakedDhcpv6Srv(0));
+    TimerMgr& timers = IfaceMgr::instance().getTimerMgr();
+    EXPECT_TRUE(timers.isScheduled(srv->expiration_timer_));
+
+    const size_t slice = NakedDhcpv6Srv::DHCPV4_QUERY_EXPIRATION_SLICE;
+    const ptime now = microsec_clock::universal_time();
+    for (uint32_t id = 0; id < slice + 10; ++id) {
+        srv->map4o6[id] = Pkt6Ptr(new TimestampedPkt6(DHCPV4_QUERY,
+                                                     now - seconds(60)));
+    }
+    // A query waiting for the response.
+    srv->map4o6[slice + 10] = Pkt6Ptr(new TimestampedPkt6(DHCPV4_QUERY, now));
+
+    // The first call checks a slice of the queries and schedules the
+    // next one right away.
+    srv->expireDHCPv4Queries();
+    EXPECT_EQ(11, srv->map4o6.size());
+    EXPECT_EQ(slice, srv->getServerCounters().
+              get(ServerCounters::DHCP4O6_TIMED_OUT));
+    EXPECT_TRUE(timers.isScheduled(srv->expiration_timer_));
+    EXPECT_GT(1000, timers.getTimeout(1000));
+
+    srv->expireDHCPv4Queries();
+    ASSERT_EQ(1, srv->map4o6.size());
+    EXPECT_EQ(1, srv->map4o6.count(slice + 10));
+    EXPECT_EQ(slice + 10, srv->getServerCounters().
+              get(ServerCounters::DHCP4O6_TIMED_OUT));
+
+    // The timer is cancelled together with the server.
+    const TimerMgr::TimerId timer = srv->expiration_timer_;
+    srv.reset();
+    EXPECT_FALSE(timers.isScheduled(timer));
+}
+
+/// @brief Builds a DHCPDISCOVER with the given hardware address and
+/// client identifier (none if 0).
+OptionBuffer
+createDHCPv4Query(uint8_t hwaddr, uint8_t client_id) {
+    OptionBuffer query(240, 0);
+    query[0] = 1; // BOOTREQUEST
+    query[1] = 1; // Ethernet
+    query[2] = 6; // hlen
+    for (int i = 0; i < 6; ++i) {
+        query[28 + i] = hwaddr + i;
+    }
+    query[236] = 0x63;
+    query[237] = 0x82;
+    query[238] = 0x53;
+    query[239] = 0x63;
+    query.push_back(DHO_DHCP_MESSAGE_TYPE);
+    query.push_back(1);
+    query.push_back(DHCPDISCOVER);
+    if (client_id) {
+        query.push_back(DHO_DHCP_CLIENT_IDENTIFIER);
+        query.push_back(3);
+        query.push_back(0);
+        query.push_back(client_id);
+        query.push_back(client_id);
+    }
+    query.push_back(DHO_END);
+    return (query);
+}
+
+// This test verifies that the DHCPv4-queries are spread over the DHCPv4
+// servers by client, and that the clients of an unreachable server are
+// moved to the other servers until it is back.
+TEST_F(Dhcpv6SrvTest, DHCPv4Backends) {
+    boost::scoped_ptr<BackendDhcpv6Srv> srv(new BackendDhcpv6Srv());
+    ASSERT_EQ(1, srv->getDHCPv4Backends().getMembers().size());
+    EXPECT_EQ(FILENAME1, srv->getDHCPv4Backends().getMembers()[0]);
+    EXPECT_TRUE(IfaceMgr::instance().getTimerMgr().
+                isScheduled(srv->backend_check_timer_));
+
+    std::vector<std::string> names;
+    names.push_back("dhcp4-a");
+    names.push_back("dhcp4-b");
+    names.push_back("dhcp4-c");
+    srv->setDHCPv4Backends(names);
+    srv->reachable_.insert(names.begin(), names.end());
+
+    // The clients are spread over the servers, and each client always
+    // goes to the same server.
+    std::set<std::string> used;
+    for (uint8_t client = 1; client < 64; ++client) {
+        ASSERT_TRUE(srv->forwardDHCPv4Query(createDHCPv4Query(client, 0)));
+        ASSERT_TRUE(srv->forwardDHCPv4Query(createDHCPv4Query(client, 0)));
+        EXPECT_EQ(srv->sent_[srv->sent_.size() - 2], srv->sent_.back());
+        used.insert(srv->sent_.back());
+    }
+    EXPECT_EQ(3, used.size());
+
+    // The client identifier takes precedence over the hardware address.
+    ASSERT_TRUE(srv->forwardDHCPv4Query(createDHCPv4Query(1, 7)));
+    const std::string backend = srv->sent_.back();
+    for (uint8_t hwaddr = 2; hwaddr < 16; ++hwaddr) {
+        ASSERT_TRUE(srv->forwardDHCPv4Query(createDHCPv4Query(hwaddr, 7)));
+        EXPECT_EQ(backend, srv->sent_.back());
+    }
+
+    // The server goes away: the client moves to another one.
+    srv->reachable_.erase(backend);
+    ASSERT_TRUE(srv->forwardDHCPv4Query(createDHCPv4Query(1, 7)));
+    EXPECT_NE(backend, srv->sent_.back());
+    const size_t index = std::find(names.begin(), names.end(), backend) -
+        names.begin();
+    EXPECT_FALSE(srv->getDHCPv4Backends().isUp(index));
+
+    // It is still down when the servers are checked.
+    srv->checkDHCPv4Backends();
+    EXPECT_FALSE(srv->getDHCPv4Backends().isUp(index));
+
+    // The client goes back when it is reachable again.
+    srv->reachable_.insert(backend);
+    srv->checkDHCPv4Backends();
+    EXPECT_TRUE(srv->getDHCPv4Backends().isUp(index));
+    ASSERT_TRUE(srv->forwardDHCPv4Query(createDHCPv4Query(1, 7)));
+    EXPECT_EQ(backend, srv->sent_.back());
+
+    // No server is reachable.
+    srv->reachable_.clear();
+    EXPECT_FALSE(srv->forwardDHCPv4Query(createDHCPv4Query(1, 7)));
+    for (size_t i = 0; i < names.size(); ++i) {
+        EXPECT_FALSE(srv->getDHCPv4Backends().isUp(i));
+    }
+
+    // The timer is cancelled together with the server.
+    const TimerMgr::TimerId timer = srv->backend_check_timer_;
+    srv.reset();
+    EXPECT_FALSE(IfaceMgr::instance().getTimerMgr().isScheduled(timer));
+}
+
+// This test verifies that the DHCPv4-queries are passed through the
+// shared memory channels of the DHCPv4 servers which have one.
+TEST_F(Dhcpv6SrvTest, DHCPv4Channels) {
+    boost::scoped_ptr<BackendDhcpv6Srv> srv(new BackendDhcpv6Srv());
+    std::vector<std::string> names(1, "dhcp4-channel-test");
+    srv->setDHCPv4Backends(names);
+    srv->reachable_.insert(names[0]);
+    const std::string path = Shm4o6Channel::getPath(".", names[0]);
+
+    // No channel yet: the socket is used.
+    srv->setDHCPv4ChannelDir(".");
+    EXPECT_TRUE(srv->dhcp4_channels_.empty());
+    ASSERT_TRUE(srv->forwardDHCPv4Query(createDHCPv4Query(1, 0)));
+    EXPECT_EQ(1, srv->sent_.size());
+
+    // The DHCPv4 server creates its channel, found by the next check.
+    Shm4o6ChannelPtr dhcp4 = Shm4o6Channel::create(path, 4096);
+    srv->checkDHCPv4Backends();
+    ASSERT_EQ(1, srv->dhcp4_channels_.size());
+    EXPECT_EQ(1, IfaceMgr::instance().get4o6Channels().size());
+
+    const OptionBuffer query = createDHCPv4Query(2, 0);
+    ASSERT_TRUE(srv->forwardDHCPv4Query(query));
+    EXPECT_EQ(1, srv->sent_.size());
+    size_t len = 0;
+    const uint8_t* data = dhcp4->getInbound().front(len);
+    ASSERT_TRUE(data);
+    EXPECT_TRUE(query == OptionBuffer(data, data + len));
+    dhcp4->getInbound().pop();
+
+    // The DHCPv4 server stops: the socket is used again.
+    dhcp4.reset();
+    ASSERT_TRUE(srv->forwardDHCPv4Query(query));
+    EXPECT_EQ(2, srv->sent_.size());
+    EXPECT_TRUE(srv->dhcp4_channels_.empty());
+    EXPECT_TRUE(IfaceMgr::instance().get4o6Channels().empty());
+
+    // The channels are closed with the server.
+    dhcp4 = Shm4o6Channel::create(path, 4096);
+    srv->checkDHCPv4Backends();
+    EXPECT_EQ(1, IfaceMgr::instance().get4o6Channels().size());
+    srv.reset();
+    EXPECT_TRUE(IfaceMgr::instance().get4o6Channels().empty());
+}
+
+/// @brief Server running its main loop on queries handed by the test.
+///
+/// The responses are not sent to the network: the sending fails or
+/// succeeds as set by the test.
+class LoopDhcpv6Srv : public NakedDhcpv6Srv {
+public:
+    LoopDhcpv6Srv() : NakedDhcpv6Srv(0), send_fails_(false), sent_(0) {
+    }
+
+    /// Runs the main loop for a single query (not unpacked yet).
+    void process(const Pkt6Ptr& query) {
+        query_ = query;
+        shutdown_ = false;
+        run();
+    }
+
+    /// Returns the query set by process(), then stops the loop.
+    virtual Pkt6Ptr receivePacket(int) {
+        Pkt6Ptr query;
+        query.swap(query_);
+        if (!query) {
+            shutdown_ = true;
+        }
+        return (query);
+    }
+
+    /// Counts the responses or fails as if the socket failed.
+    virtual void sendPackets(const Pkt6Collection& packets, size_t& sent) {
+        if (send_fails_) {
+            isc_throw(isc::Unexpected, "send failed");
+        }
+        sent = packets.size();
+        sent_ += sent;
+    }
+
+    /// Makes the sending of the responses fail.
+    bool send_fails_;
+
+    /// Number of responses sent.
+    size_t sent_;
+
+private:
+    /// Query to be returned by the next receivePacket() call.
+    Pkt6Ptr query_;
+};
+
+// Returns a copy of the packed query, as received again.
+Pkt6Ptr
+receivedCopy(const Pkt6& query) {
+    Pkt6Ptr copy(new Pkt6(static_cast<const uint8_t*>(query.getBuffer().
+                                                       getData()),
+                          query.getBuffer().getLength()));
+    copy->setRemoteAddr(IOAddress("fe80::abcd"));
+    copy->setIface("eth0");
+    copy->updateTimestamp();
+    return (copy);
+}
+
+// Checks that a response is cached only when it has been sent, so the
+// retransmission of a query which response was lost is processed again.
+TEST_F(Dhcpv6SrvTest, responseCachedOnceSent) {
+    LoopDhcpv6Srv srv;
+    srv.setResponseCacheWindow(3000);
+    ServerCounters& counters = srv.getServerCounters();
+
+    Pkt6 sol(DHCPV6_SOLICIT, 1234);
+    sol.addOption(generateIA(234, 1500, 3000));
+    sol.addOption(generateClientId());
+    ASSERT_TRUE(sol.pack());
+
+    // The response is lost: nothing is cached.
+    srv.send_fails_ = true;
+    srv.process(receivedCopy(sol));
+    EXPECT_EQ(0, srv.sent_);
+    EXPECT_EQ(1, counters.get(ServerCounters::SEND_FAILED));
+    EXPECT_EQ(0, srv.getResponseCache().size());
+
+    // The retransmission is processed again and its response is cached.
+    srv.send_fails_ = false;
+    srv.process(receivedCopy(sol));
+    EXPECT_EQ(1, srv.sent_);
+    EXPECT_EQ(0, srv.getResponseCache().getHits());
+    EXPECT_EQ(1, srv.getResponseCache().size());
+
+    // The next retransmission is answered with the cached response.
+    srv.process(receivedCopy(sol));
+    EXPECT_EQ(2, srv.sent_);
+    EXPECT_EQ(1, srv.getResponseCache().getHits());
+}
+
 /// @todo: Add more negative tests for processX(), e.g. extend sanityCheck() test
 /// to call processX() methods.
 
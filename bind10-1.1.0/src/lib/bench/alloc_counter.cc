@@ -0,0 +1,66 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/alloc_counter.h>
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+/// Number of allocations since the program start.
+volatile uint64_t alloc_count = 0;
+
+void*
+allocate(size_t size) {
+    __sync_fetch_and_add(&alloc_count, 1);
+    void* ptr = std::malloc(size > 0 ? size : 1);
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+    return (ptr);
+}
+
+}
+
+void*
+operator new(size_t size) throw (std::bad_alloc) {
+    return (allocate(size));
+}
+
+void*
+operator new[](size_t size) throw (std::bad_alloc) {
+    return (allocate(size));
+}
+
+void
+operator delete(void* ptr) throw () {
+    std::free(ptr);
+}
+
+void
+operator delete[](void* ptr) throw () {
+    std::free(ptr);
+}
+
+namespace isc {
+namespace bench {
+
+uint64_t
+AllocCounter::getCount() {
+    return (__sync_fetch_and_add(&alloc_count, 0));
+}
+
+}
+}
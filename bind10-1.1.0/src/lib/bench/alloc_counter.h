@@ -0,0 +1,79 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H 1
+
+#include <bench/benchmark.h>
+
+#include <iostream>
+#include <string>
+
+#include <stdint.h>
+
+namespace isc {
+namespace bench {
+
+/// \brief Counter of memory allocations.
+///
+/// The global operator new is replaced in the programs linked with the
+/// libb10-alloc-counter library, so the number of allocations performed
+/// by the benchmarked code can be reported along with its duration.  The
+/// replacement is not part of libb10-bench: it is linked only into the
+/// programs which count their allocations.  Memory allocation is
+/// often the dominant cost of the packet processing, so the count of
+/// allocations is a more stable indicator of a regression than the time,
+/// which depends on the load of the machine.
+class AllocCounter {
+public:
+    /// \brief Returns the number of allocations since the program start.
+    static uint64_t getCount();
+};
+
+/// \brief Run a benchmark and print the cost of a single operation.
+///
+/// This is a variant of the immediate \c BenchMark for micro benchmarks
+/// of operations taking nanoseconds.  It prints a single line holding
+/// the name of the benchmark, the number of iterations, the average
+/// time of an iteration in nanoseconds and the average number of memory
+/// allocations in an iteration, e.g.
+/// \code Pkt4::unpack: 1000000 iterations, 812.35 ns/op, 9.00 allocs/op
+/// \endcode
+///
+/// \param name Name of the benchmark.
+/// \param iterations The number of iterations.
+/// \param target The object performing the operation (see \c BenchMark).
+template <typename T>
+void
+runBenchMark(const std::string& name, const int iterations, T& target) {
+    BenchMark<T> bench(iterations, target, false);
+    const uint64_t allocs = AllocCounter::getCount();
+    bench.run();
+    const uint64_t total_allocs = AllocCounter::getCount() - allocs;
+
+    std::cout << name << ": " << bench.getIteration() << " iterations";
+    std::cout.precision(2);
+    if (bench.getIteration() > 0) {
+        std::cout << ", " << std::fixed << bench.getAverageTime() * 1e9
+                  << " ns/op, "
+                  << static_cast<double>(total_allocs) / bench.getIteration()
+                  << " allocs/op";
+    }
+    std::cout << std::endl;
+}
+
+}
+}
+
+#endif  // ALLOC_COUNTER_H
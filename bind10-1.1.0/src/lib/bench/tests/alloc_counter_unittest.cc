@@ -0,0 +1,63 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/alloc_counter.h>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace isc::bench;
+
+namespace {
+// The "benchmark" allocates the given number of objects in each iteration.
+class AllocBenchMark {
+public:
+    AllocBenchMark(const int allocs) : allocs_(allocs) {}
+    unsigned int run() {
+        for (int i = 0; i < allocs_; ++i) {
+            delete new int(i);
+        }
+        return (1);
+    }
+    const int allocs_;
+};
+
+TEST(AllocCounterTest, count) {
+    const uint64_t count = AllocCounter::getCount();
+    vector<int>* vec = new vector<int>(10);
+    delete vec;
+    int* array = new int[10];
+    delete[] array;
+    // The vector allocates its own storage.
+    EXPECT_EQ(count + 3, AllocCounter::getCount());
+}
+
+TEST(AllocCounterTest, runBenchMark) {
+    AllocBenchMark target(3);
+    // The result is printed to the standard output.
+    streambuf* saved = cout.rdbuf();
+    ostringstream output;
+    cout.rdbuf(output.rdbuf());
+    runBenchMark("alloc", 100, target);
+    cout.rdbuf(saved);
+
+    const string result = output.str();
+    EXPECT_EQ(0, result.find("alloc: 100 iterations, "));
+    EXPECT_NE(string::npos, result.find(" ns/op, 3.00 allocs/op\n"));
+}
+}
@@ -132,39 +132,14 @@ ConfigurableClientList::configure(const ConstElementPtr& config,
                                                       name));
 
             // If cache is disabled we are done for this data source.
-            // Otherwise load zones into the in-memory cache.
-            if (!cache_conf->isEnabled()) {
+            // Otherwise load zones into the in-memory cache, unless it is
+            // mapped and waits for a segment to be given by
+            // resetMemorySegment().
+            if (!cache_conf->isEnabled() ||
+                !new_data_sources.back().ztable_segment_->isWritable()) {
                 continue;
             }
-            internal::CacheConfig::ConstZoneIterator end_of_zones =
-                cache_conf->end();
-            for (internal::CacheConfig::ConstZoneIterator zone_it =
-                     cache_conf->begin();
-                 zone_it != end_of_zones;
-                 ++zone_it)
-            {
-                const Name& zname = zone_it->first;
-                memory::LoadAction load_action;
-                try {
-                    load_action = cache_conf->getLoadAction(rrclass_, zname);
-                } catch (const DataSourceError&) {
-                    isc_throw(ConfigurationError, "Data source error for "
-                              "loading a zone (possibly non-existent) "
-                              << zname << "/" << rrclass_);
-                }
-                assert(load_action); // in this loop this should be always true
-                boost::scoped_ptr<memory::ZoneWriter> writer;
-                try {
-                    writer.reset(new_data_sources.back().ztable_segment_->
-                                 getZoneWriter(load_action, zname, rrclass_));
-                    writer->load();
-                    writer->install();
-                    writer->cleanup();
-                } catch (const ZoneLoaderException& e) {
-                    LOG_ERROR(logger, DATASRC_LOAD_ZONE_ERROR)
-                        .arg(zname).arg(rrclass_).arg(name).arg(e.what());
-                }
-            }
+            loadCachedZones(new_data_sources.back());
         }
         // If everything is OK up until now, we have the new configuration
         // ready. So just put it there and let the old one die when we exit
@@ -181,6 +156,61 @@ ConfigurableClientList::configure(const ConstElementPtr& config,
     }
 }
 
+void
+ConfigurableClientList::loadCachedZones(const DataSourceInfo& info) {
+    const internal::CacheConfig* cache_conf = info.getCacheConfig();
+    internal::CacheConfig::ConstZoneIterator end_of_zones = cache_conf->end();
+    for (internal::CacheConfig::ConstZoneIterator zone_it =
+             cache_conf->begin();
+         zone_it != end_of_zones;
+         ++zone_it)
+    {
+        const Name& zname = zone_it->first;
+        memory::LoadAction load_action;
+        try {
+            load_action = cache_conf->getLoadAction(rrclass_, zname);
+        } catch (const DataSourceError&) {
+            isc_throw(ConfigurationError, "Data source error for "
+                      "loading a zone (possibly non-existent) "
+                      << zname << "/" << rrclass_);
+        }
+        assert(load_action); // in this loop this should be always true
+        boost::scoped_ptr<memory::ZoneWriter> writer;
+        try {
+            writer.reset(info.ztable_segment_->
+                         getZoneWriter(load_action, zname, rrclass_));
+            writer->load();
+            writer->install();
+            writer->cleanup();
+        } catch (const ZoneLoaderException& e) {
+            LOG_ERROR(logger, DATASRC_LOAD_ZONE_ERROR)
+                .arg(zname).arg(rrclass_).arg(info.name_).arg(e.what());
+        }
+    }
+}
+
+void
+ConfigurableClientList::resetMemorySegment(
+    const std::string& datasrc_name,
+    ZoneTableSegment::MemorySegmentOpenMode mode,
+    ConstElementPtr config_params)
+{
+    BOOST_FOREACH(DataSourceInfo& info, data_sources_) {
+        if (info.name_ == datasrc_name) {
+            if (!info.ztable_segment_) {
+                isc_throw(InvalidParameter, "Data source " << datasrc_name
+                          << " has no in-memory cache");
+            }
+            info.ztable_segment_->reset(mode, config_params);
+            if (mode == ZoneTableSegment::CREATE) {
+                loadCachedZones(info);
+            }
+            return;
+        }
+    }
+    isc_throw(InvalidParameter, "Unknown data source " << datasrc_name);
+}
+
 namespace {
 
 class CacheKeeper : public ClientList::FindResult::LifeKeeper {
@@ -254,6 +284,10 @@ ConfigurableClientList::findInternal(MutableResult& candidate,
                                      bool want_exact_match, bool) const
 {
     BOOST_FOREACH(const DataSourceInfo& info, data_sources_) {
+        // A mapped cache without a segment has nothing to search yet.
+        if (info.ztable_segment_ && !info.ztable_segment_->isUsable()) {
+            continue;
+        }
         DataSourceClient* client(info.cache_ ? info.cache_.get() :
                                  info.data_src_client_);
         const DataSourceClient::FindResult result(client->findZone(name));
@@ -343,7 +377,7 @@ ConfigurableClientList::getCachedZoneWriter(const Name& name) {
     // tests could set it to a bogus value).
     const memory::LoadAction load_action =
         result.info->getCacheConfig()->getLoadAction(rrclass_, name);
-    if (!load_action) {
+    if (!load_action || !result.info->ztable_segment_->isWritable()) {
         return (ZoneWriterPair(ZONE_NOT_CACHED, ZoneWriterPtr()));
     }
     return (ZoneWriterPair(ZONE_SUCCESS,
@@ -373,11 +407,16 @@ vector<DataSourceStatus>
 ConfigurableClientList::getStatus() const {
     vector<DataSourceStatus> result;
     BOOST_FOREACH(const DataSourceInfo& info, data_sources_) {
-        // TODO: Once we support mapped cache, decide when we need the
-        // SEGMENT_WAITING.
-        result.push_back(DataSourceStatus(info.name_, info.cache_ ?
-                                          SEGMENT_INUSE : SEGMENT_UNUSED,
-                                          "local"));
+        if (!info.cache_) {
+            result.push_back(DataSourceStatus(info.name_, SEGMENT_UNUSED,
+                                              ""));
+        } else {
+            result.push_back(DataSourceStatus(
+                                 info.name_,
+                                 info.ztable_segment_->isUsable() ?
+                                 SEGMENT_INUSE : SEGMENT_WAITING,
+                                 info.getCacheConfig()->getSegmentType()));
+        }
     }
     return (result);
 }
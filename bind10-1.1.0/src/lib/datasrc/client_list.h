@@ -394,6 +394,28 @@ public:
     ///      the original data source no longer contains the cached zone.
     ZoneWriterPair getCachedZoneWriter(const dns::Name& zone);
 
+    /// \brief Sets the memory segment of a data source's cache.
+    ///
+    /// A cache whose type is "mapped" has no segment once configured
+    /// (it's in the \c SEGMENT_WAITING state and isn't searched); this
+    /// gives it one, or replaces the current one.  A reader switches to a
+    /// new version of the zones by being reset to the file holding it in
+    /// the \c READ_ONLY mode.  In the \c CREATE mode, all the zones
+    /// configured for the cache are loaded into the new segment.
+    ///
+    /// \param datasrc_name The name of the data source.
+    /// \param mode How the segment is opened.
+    /// \param config_params The parameters of the segment, e.g. its file.
+    /// \throw InvalidParameter if there's no such data source with a cache.
+    /// \throw memory::ResetFailed if the segment can't be set; the current
+    ///     one is then kept.
+    /// \throw ConfigurationError if a zone to load is unknown to the data
+    ///     source.
+    void resetMemorySegment
+        (const std::string& datasrc_name,
+         memory::ZoneTableSegment::MemorySegmentOpenMode mode,
+         isc::data::ConstElementPtr config_params);
+
     /// \brief Implementation of the ClientList::find.
     virtual FindResult find(const dns::Name& zone,
                             bool want_exact_match = false,
@@ -496,6 +518,13 @@ private:
     /// to reuse it.
     void findInternal(MutableResult& result, const dns::Name& name,
                       bool want_exact_match, bool want_finder) const;
+
+    /// \brief Loads all the zones configured for a cache into it.
+    ///
+    /// Errors in the content of a zone are logged and the zone is skipped.
+    ///
+    /// \throw ConfigurationError if a zone is unknown to the data source.
+    void loadCachedZones(const DataSourceInfo& info);
     const isc::dns::RRClass rrclass_;
 
     /// \brief Currently active configuration.
@@ -17,38 +17,61 @@
 
 #include <util/memory_segment.h>
 
+#include <string>
+
 namespace isc {
 namespace datasrc {
 namespace memory {
 namespace detail {
 
+// Returns a name for the named address of a new holder.  The names are
+// distinct as long as a segment is only modified by one thread at a time,
+// which is required anyway.
+std::string getNextHolderName();
+
 // A simple holder to create and use some objects in this implementation
 // in an exception safe manner.   It works like std::auto_ptr but much
 // more simplified.
 // template parameter T is the type of object allocated by mem_sgmt.
 // template parameter ARG_T is the type that will be passed to destroy()
 // (deleter functor, etc).  It must be copyable.
+//
+// The object is kept as a named address of the segment rather than as a
+// plain pointer, so the holder remains valid when a mapped segment grows
+// and is remapped elsewhere (see util::MemorySegmentGrown): get() and
+// release() always return the current address, and the destructor
+// destroys the object where it currently is.  Likewise, the address given
+// to the constructor may be stale once the holder is constructed; use
+// get() instead.
 template <typename T, typename ARG_T>
 class SegmentObjectHolder {
 public:
     SegmentObjectHolder(util::MemorySegment& mem_sgmt, T* obj, ARG_T arg) :
-        mem_sgmt_(mem_sgmt), obj_(obj), arg_(arg)
-    {}
+        mem_sgmt_(mem_sgmt), arg_(arg), name_(getNextHolderName())
+    {
+        // This can grow the segment, which is fine as we don't keep the
+        // raw address.
+        mem_sgmt_.setNamedAddress(name_.c_str(), obj);
+    }
     ~SegmentObjectHolder() {
-        if (obj_ != NULL) {
-            T::destroy(mem_sgmt_, obj_, arg_);
+        T* obj = get();
+        if (obj != NULL) {
+            T::destroy(mem_sgmt_, obj, arg_);
         }
+        mem_sgmt_.clearNamedAddress(name_.c_str());
+    }
+    T* get() {
+        return (static_cast<T*>(mem_sgmt_.getNamedAddress(name_.c_str())));
     }
-    T* get() { return (obj_); }
     T* release() {
-        T* ret = obj_;
-        obj_ = NULL;
+        T* ret = get();
+        mem_sgmt_.setNamedAddress(name_.c_str(), NULL);
         return (ret);
     }
 private:
     util::MemorySegment& mem_sgmt_;
-    T* obj_;
     ARG_T arg_;
+    const std::string name_;
 };
 
 } // detail
@@ -182,8 +182,17 @@ loadZoneDataInternal(util::MemorySegment& mem_sgmt,
                      const Name& zone_name,
                      boost::function<void(LoadCallback)> rrset_installer)
 {
-    SegmentObjectHolder<ZoneData, RRClass> holder(
-        mem_sgmt, ZoneData::create(mem_sgmt, zone_name), rrclass);
+    // If the segment grows, nothing has been allocated, and nothing has
+    // been read from the source yet, so we can simply retry.  Later
+    // growths are handled by the updater.
+    ZoneData* zone_data = NULL;
+    while (zone_data == NULL) {
+        try {
+            zone_data = ZoneData::create(mem_sgmt, zone_name);
+        } catch (const util::MemorySegmentGrown&) {}
+    }
+    SegmentObjectHolder<ZoneData, RRClass> holder(mem_sgmt, zone_data,
+                                                  rrclass);
 
     ZoneDataLoader loader(mem_sgmt, rrclass, zone_name, *holder.get());
     rrset_installer(boost::bind(&ZoneDataLoader::addFromLoad, &loader, _1));
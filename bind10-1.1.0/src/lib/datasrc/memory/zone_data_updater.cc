@@ -16,6 +16,7 @@
 
 #include <datasrc/memory/zone_data_updater.h>
 #include <datasrc/memory/logger.h>
+#include <datasrc/memory/segment_object_holder.h>
 #include <datasrc/memory/util_internal.h>
 #include <datasrc/zone.h>
 
@@ -33,6 +34,27 @@ namespace memory {
 
 using detail::getCoveredType;
 
+ZoneDataUpdater::ZoneDataUpdater(util::MemorySegment& mem_sgmt,
+                                 RRClass rrclass, const Name& zone_name,
+                                 ZoneData& zone_data) :
+    mem_sgmt_(mem_sgmt),
+    rrclass_(rrclass),
+    zone_name_(zone_name),
+    zone_data_name_(detail::getNextHolderName()),
+    zone_data_(&zone_data),
+    hash_(NULL)
+{
+    if (mem_sgmt_.setNamedAddress(zone_data_name_.c_str(), zone_data_)) {
+        zone_data_ = static_cast<ZoneData*>(
+            mem_sgmt_.getNamedAddress(zone_data_name_.c_str()));
+    }
+}
+
+ZoneDataUpdater::~ZoneDataUpdater() {
+    mem_sgmt_.clearNamedAddress(zone_data_name_.c_str());
+    delete hash_;
+}
+
 void
 ZoneDataUpdater::addWildcards(const Name& name) {
     Name wname(name);
@@ -49,14 +71,14 @@ ZoneDataUpdater::addWildcards(const Name& name) {
             // Ensure a separate level exists for the "wildcarding"
             // name, and mark the node as "wild".
             ZoneNode* node;
-            zone_data_.insertName(mem_sgmt_, wname.split(1), &node);
+            zone_data_->insertName(mem_sgmt_, wname.split(1), &node);
             node->setFlag(ZoneData::WILDCARD_NODE);
 
             // Ensure a separate level exists for the wildcard name.
             // Note: for 'name' itself we do this later anyway, but the
             // overhead should be marginal because wildcard names should
             // be rare.
-            zone_data_.insertName(mem_sgmt_, wname, &node);
+            zone_data_->insertName(mem_sgmt_, wname, &node);
         }
     }
 }
@@ -210,7 +232,7 @@ ZoneDataUpdater::validate(const isc::dns::ConstRRsetPtr rrset) const {
 const NSEC3Hash*
 ZoneDataUpdater::getNSEC3Hash() {
     if (hash_ == NULL) {
-        NSEC3Data* nsec3_data = zone_data_.getNSEC3Data();
+        NSEC3Data* nsec3_data = zone_data_->getNSEC3Data();
         // This should never be NULL in this codepath.
         assert(nsec3_data != NULL);
 
@@ -231,11 +253,11 @@ ZoneDataUpdater::setupNSEC3(const ConstRRsetPtr rrset) {
         dynamic_cast<const T&>(
             rrset->getRdataIterator()->getCurrent());
 
-    NSEC3Data* nsec3_data = zone_data_.getNSEC3Data();
+    NSEC3Data* nsec3_data = zone_data_->getNSEC3Data();
     if (nsec3_data == NULL) {
         nsec3_data = NSEC3Data::create(mem_sgmt_, zone_name_, nsec3_rdata);
-        zone_data_.setNSEC3Data(nsec3_data);
-        zone_data_.setSigned(true);
+        zone_data_->setNSEC3Data(nsec3_data);
+        zone_data_->setSigned(true);
     } else {
         const NSEC3Hash* hash = getNSEC3Hash();
         if (!hash->match(nsec3_rdata)) {
@@ -254,7 +276,7 @@ ZoneDataUpdater::addNSEC3(const Name& name, const ConstRRsetPtr rrset,
         setupNSEC3<generic::NSEC3>(rrset);
     }
 
-    NSEC3Data* nsec3_data = zone_data_.getNSEC3Data();
+    NSEC3Data* nsec3_data = zone_data_->getNSEC3Data();
     if (nsec3_data == NULL) {
         // This is some tricky case: an RRSIG for NSEC3 is given without the
         // covered NSEC3, and we don't even know any NSEC3 related data.
@@ -290,7 +312,7 @@ ZoneDataUpdater::addRdataSet(const Name& name, const RRType& rrtype,
         addNSEC3(name, rrset, rrsig);
     } else {
         ZoneNode* node;
-        zone_data_.insertName(mem_sgmt_, name, &node);
+        zone_data_->insertName(mem_sgmt_, name, &node);
 
         RdataSet* rdataset_head = node->getData();
 
@@ -334,7 +356,7 @@ ZoneDataUpdater::addRdataSet(const Name& name, const RRType& rrtype,
         // Ok, we just put it in.
 
         // Convenient (and more efficient) shortcut to check RRsets at origin
-        const bool is_origin = (node == zone_data_.getOriginNode());
+        const bool is_origin = (node == zone_data_->getOriginNode());
 
         // If this RRset creates a zone cut at this node, mark the node
         // indicating the need for callback in find().  Note that we do this
@@ -356,7 +378,7 @@ ZoneDataUpdater::addRdataSet(const Name& name, const RRType& rrtype,
             // (conceptually "signed" is a broader notion but our
             // current zone finder implementation regards "signed" as
             // "NSEC signed")
-            zone_data_.setSigned(true);
+            zone_data_->setSigned(true);
         }
 
         // If we are adding a new SOA at the origin, update zone's min TTL.
@@ -365,7 +387,7 @@ ZoneDataUpdater::addRdataSet(const Name& name, const RRType& rrtype,
         // this should be only once in normal cases) update the TTL.
         if (rrset && rrtype == RRType::SOA() && is_origin) {
             // Our own validation ensures the RRset is not empty.
-            zone_data_.setMinTTL(
+            zone_data_->setMinTTL(
                 dynamic_cast<const generic::SOA&>(
                     rrset->getRdataIterator()->getCurrent()).getMinimum());
         }
@@ -402,11 +424,22 @@ ZoneDataUpdater::add(const ConstRRsetPtr& rrset,
     // Note: this can throw an exception, breaking strong exception
     // guarantee.  (see also the note for the call to contextCheck()
     // above).
-    if (rrtype != RRType::NSEC3()) {
-        addWildcards(name);
+    //
+    // If the segment has grown, the zone data may have been remapped
+    // elsewhere: locate it again and retry.  What was already added is
+    // harmless as duplicate RDATA are ignored.
+    while (true) {
+        try {
+            if (rrtype != RRType::NSEC3()) {
+                addWildcards(name);
+            }
+            addRdataSet(name, rrtype, rrset, sig_rrset);
+            break;
+        } catch (const util::MemorySegmentGrown&) {
+            zone_data_ = static_cast<ZoneData*>(
+                mem_sgmt_.getNamedAddress(zone_data_name_.c_str()));
+        }
     }
-
-    addRdataSet(name, rrtype, rrset, sig_rrset);
 }
 
 } // namespace memory
@@ -26,6 +26,8 @@
 
 #include <boost/noncopyable.hpp>
 
+#include <string>
+
 namespace isc {
 namespace datasrc {
 namespace memory {
@@ -57,29 +59,24 @@ public:
 
     /// The constructor.
     ///
-    /// \throw none
+    /// \throw std::bad_alloc Internal resource allocation fails.
     ///
     /// \param mem_sgmt The memory segment used for the zone data.
     /// \param rrclass The RRclass of the zone data.
     /// \param zone_name The Name of the zone under which records will be
     ///                  added.
     //  \param zone_data The ZoneData object which is populated with
-    //                   record data.
+    //                   record data.  If the segment grows, it's located
+    //                   through a named address of the segment, so the
+    //                   caller should do the same (e.g. by holding it in
+    //                   a \c detail::SegmentObjectHolder).
     ZoneDataUpdater(util::MemorySegment& mem_sgmt,
                     isc::dns::RRClass rrclass,
                     const isc::dns::Name& zone_name,
-                    ZoneData& zone_data) :
-       mem_sgmt_(mem_sgmt),
-       rrclass_(rrclass),
-       zone_name_(zone_name),
-       zone_data_(zone_data),
-       hash_(NULL)
-    {}
+                    ZoneData& zone_data);
 
     /// The destructor.
-    ~ZoneDataUpdater() {
-        delete hash_;
-    }
+    ~ZoneDataUpdater();
 
     //@}
 
@@ -131,6 +128,11 @@ public:
     /// an \c AddError exception.  This will be loosened in Trac
     /// ticket #2441.
     ///
+    /// If the memory segment grows while adding the RRset (see
+    /// \c util::MemorySegmentGrown), the RRset is added again to the
+    /// relocated zone data; the RDATA that were already added are
+    /// ignored as duplicates.
+    ///
     /// \throw NullRRset Both \c rrset and sig_rrset is NULL
     /// \throw AddError any of a variety of validation checks fail for the
     /// \c rrset and its associated \c sig_rrset.
@@ -185,7 +187,8 @@ private:
     util::MemorySegment& mem_sgmt_;
     const isc::dns::RRClass rrclass_;
     const isc::dns::Name& zone_name_;
-    ZoneData& zone_data_;
+    const std::string zone_data_name_;
+    ZoneData* zone_data_;
     RdataEncoder encoder_;
     const isc::dns::NSEC3Hash* hash_;
 };
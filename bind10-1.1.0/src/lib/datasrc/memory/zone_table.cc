@@ -77,8 +77,10 @@ ZoneTable::addZone(util::MemorySegment& mem_sgmt, RRClass zone_class,
     if (content == NULL) {
         isc_throw(isc::BadValue, "Zone content must not be NULL");
     }
-    SegmentObjectHolder<ZoneData, RRClass> holder(mem_sgmt, content,
-                                                  zone_class);
+    if (zone_class != rrclass_) {
+        isc_throw(isc::BadValue, "Zone class " << zone_class <<
+                  " doesn't match the zone table class " << rrclass_);
+    }
     // Get the node where we put the zone
     ZoneTableNode* node(NULL);
     switch (zones_->insert(mem_sgmt, zone_name, &node)) {
@@ -93,8 +95,8 @@ ZoneTable::addZone(util::MemorySegment& mem_sgmt, RRClass zone_class,
     // Can Not Happen
     assert(node != NULL);
 
-    // We can release now, setData never throws
-    ZoneData* old = node->setData(holder.release());
+    // setData never throws, so the zone table owns the content from now on
+    ZoneData* old = node->setData(content);
     if (old != NULL) {
         return (AddResult(result::EXIST, old));
     } else {
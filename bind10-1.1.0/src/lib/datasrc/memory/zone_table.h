@@ -150,15 +150,21 @@ public:
     /// This method adds a given zone data to the internal table.
     ///
     /// \throw std::bad_alloc Internal resource allocation fails.
+    /// \throw util::MemorySegmentGrown The segment has grown.
+    /// \throw isc::BadValue \c content is NULL or \c zone_class is not
+    ///     the class of the zone table.
     ///
     /// \param mem_sgmt The \c MemorySegment to allocate zone data to be
     ///     created.  It must be the same segment that was used to create
     ///     the zone table at the time of create().
     /// \param zone_name The name of the zone to be added.
     /// \param zone_class The RR class of the zone.  It must be the RR class
-    ///     that is supposed to be associated to the zone table.
+    ///     of the zone table, otherwise \c isc::BadValue is thrown.
     /// \param content This one should hold the zone content (the ZoneData).
-    ///     The ownership is passed onto the zone table. Must not be null.
+    ///     The ownership is passed onto the zone table if the zone is
+    ///     added; if an exception is thrown it remains with the caller
+    ///     (so the caller can try again when the segment has grown, see
+    ///     \c util::MemorySegmentGrown). Must not be null.
     ///     Must correspond to the name and class and must be allocated from
     ///     mem_sgmt.
     /// \return \c result::SUCCESS If the zone is successfully
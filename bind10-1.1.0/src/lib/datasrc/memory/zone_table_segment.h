@@ -49,6 +49,18 @@ public:
     {}
 };
 
+/// \brief Exception thrown when a zone table segment can't be reset.
+///
+/// The segment keeps the memory segment it had before the call to
+/// \c ZoneTableSegment::reset(), if any, unless the implementation had to
+/// release it first.
+class ResetFailed : public Exception {
+public:
+    ResetFailed(const char* file, size_t line, const char* what) :
+        Exception(file, line, what)
+    {}
+};
+
 /// \brief Memory-management independent entry point that contains a
 /// pointer to a zone table in memory.
 ///
@@ -70,6 +82,11 @@ public:
     const ZoneTable* getTable() const {
         return (table_.get());
     }
+
+    /// \brief Sets the underlying zone table.
+    void setTable(ZoneTable* table) {
+        table_ = table;
+    }
 private:
     boost::interprocess::offset_ptr<ZoneTable> table_;
 };
@@ -104,6 +121,51 @@ public:
     /// \brief Return the MemorySegment for the zone table segment.
     virtual isc::util::MemorySegment& getMemorySegment() = 0;
 
+    /// \brief Modes in which the memory segment of a segment is opened
+    /// by \c reset().
+    enum MemorySegmentOpenMode {
+        CREATE,     ///< A new and empty segment replaces any existing one.
+        READ_WRITE, ///< An existing segment is opened or a new one created.
+        READ_ONLY   ///< An existing segment is opened for reading only.
+    };
+
+    /// \brief Return true if the segment holds a zone table.
+    ///
+    /// \c getHeader() and \c getMemorySegment() may only be called on a
+    /// usable segment.  A segment which needs \c reset() isn't usable
+    /// until it's called.
+    virtual bool isUsable() const = 0;
+
+    /// \brief Return true if zones can be loaded into the segment.
+    virtual bool isWritable() const = 0;
+
+    /// \brief Open a (new) memory segment for the zone table.
+    ///
+    /// This is used by segment types which share the zone table between
+    /// processes.  \c params identifies the memory segment, its contents
+    /// depending on the type.  If the segment is already usable, the
+    /// current memory segment is kept until the new one is opened, so
+    /// the zone table is switched from one to the other at once, and the
+    /// current memory segment remains if the reset fails.
+    ///
+    /// \throw isc::NotImplemented The segment type has a single memory
+    /// segment, set up at creation.
+    /// \throw isc::InvalidParameter \c params is not valid for the type.
+    /// \throw ResetFailed The memory segment can't be opened.
+    ///
+    /// \param mode How the memory segment is opened.
+    /// \param params Type-specific parameters of the memory segment.
+    virtual void reset(MemorySegmentOpenMode mode,
+                       isc::data::ConstElementPtr params) = 0;
+
+    /// \brief Close the memory segment opened by \c reset().
+    ///
+    /// The segment is not usable anymore until \c reset() is called.
+    ///
+    /// \throw isc::NotImplemented The segment type doesn't support
+    /// \c reset().
+    virtual void clear() = 0;
+
     /// \brief Create an instance depending on the memory segment model
     ///
     /// This is a factory method to create a derived ZoneTableSegment
@@ -111,6 +173,12 @@ public:
     /// dynamically-allocated object. The caller is responsible for
     /// destroying it with \c ZoneTableSegment::destroy().
     ///
+    /// The "local" type keeps the zone table in the memory of the
+    /// process.  The "mapped" type (if built with shared memory support)
+    /// keeps it in a file mapped into memory, which can be shared by
+    /// several processes (see \c ZoneTableSegmentMapped); the segment
+    /// is not usable until \c reset() is called.
+    ///
     /// \throw UnknownSegmentType The memory segment type specified in
     /// \c config is not known or not supported in this implementation.
     ///
@@ -56,6 +56,20 @@ ZoneTableSegmentLocal::getMemorySegment() {
      return (mem_sgmt_);
 }
 
+void
+ZoneTableSegmentLocal::reset(MemorySegmentOpenMode,
+                             isc::data::ConstElementPtr)
+{
+    isc_throw(isc::NotImplemented,
+              "ZoneTableSegmentLocal::reset() is not implemented");
+}
+
+void
+ZoneTableSegmentLocal::clear() {
+    isc_throw(isc::NotImplemented,
+              "ZoneTableSegmentLocal::clear() is not implemented");
+}
+
 ZoneWriter*
 ZoneTableSegmentLocal::getZoneWriter(const LoadAction& load_action,
                                      const dns::Name& name,
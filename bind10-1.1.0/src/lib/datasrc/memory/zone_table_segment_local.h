@@ -53,6 +53,27 @@ public:
     /// implementation (a MemorySegmentLocal instance).
     virtual isc::util::MemorySegment& getMemorySegment();
 
+    /// \brief Return true; the local segment is always usable.
+    virtual bool isUsable() const {
+        return (true);
+    }
+
+    /// \brief Return true; the local segment is always writable.
+    virtual bool isWritable() const {
+        return (true);
+    }
+
+    /// \brief This method is not implemented.
+    ///
+    /// \throw isc::NotImplemented
+    virtual void reset(MemorySegmentOpenMode mode,
+                       isc::data::ConstElementPtr params);
+
+    /// \brief This method is not implemented.
+    ///
+    /// \throw isc::NotImplemented
+    virtual void clear();
+
     /// \brief Concrete implementation of ZoneTableSegment::getZoneWriter
     virtual ZoneWriter* getZoneWriter(const LoadAction& load_action,
                                       const dns::Name& origin,
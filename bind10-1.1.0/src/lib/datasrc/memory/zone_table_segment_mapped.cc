@@ -0,0 +1,214 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/zone_table_segment_mapped.h>
+#include <datasrc/memory/zone_writer_mapped.h>
+
+#include <memory>
+
+using namespace isc::data;
+using namespace isc::dns;
+using namespace isc::util;
+
+namespace isc {
+namespace datasrc {
+namespace memory {
+
+namespace {
+
+// The name of the header in the mapped segment.
+const char* const ZONE_TABLE_HEADER_NAME = "zone_table_header";
+
+// Returns the header of the zone table of a writable segment, creating
+// both if needed.  A segment left without a zone table (e.g. if its writer
+// was killed while creating it) gets a new one.
+ZoneTableHeader*
+openHeader(MemorySegment& segment, const RRClass& rrclass) {
+    if (segment.getNamedAddress(ZONE_TABLE_HEADER_NAME) == NULL) {
+        void* p = NULL;
+        while (p == NULL) {
+            try {
+                p = segment.allocate(sizeof(ZoneTableHeader));
+            } catch (const MemorySegmentGrown&) {
+                // Nothing was allocated, try again in the larger segment.
+            }
+        }
+        // The header is named at once, so it's found again if the
+        // segment grows while the zone table is created.
+        segment.setNamedAddress(ZONE_TABLE_HEADER_NAME,
+                                new(p) ZoneTableHeader(NULL));
+    }
+    ZoneTableHeader* header = static_cast<ZoneTableHeader*>(
+        segment.getNamedAddress(ZONE_TABLE_HEADER_NAME));
+    while (header->getTable() == NULL) {
+        try {
+            ZoneTable* table = ZoneTable::create(segment, rrclass);
+            header->setTable(table);
+        } catch (const MemorySegmentGrown&) {
+            header = static_cast<ZoneTableHeader*>(
+                segment.getNamedAddress(ZONE_TABLE_HEADER_NAME));
+        }
+    }
+    return (header);
+}
+
+}
+
+ZoneTableSegmentMapped::ZoneTableSegmentMapped(const RRClass& rrclass) :
+    ZoneTableSegment(rrclass),
+    rrclass_(rrclass),
+    writable_(false),
+    header_(NULL)
+{
+}
+
+ZoneTableSegmentMapped::~ZoneTableSegmentMapped() {
+    clear();
+}
+
+ZoneTableHeader&
+ZoneTableSegmentMapped::getHeader() {
+    if (header_ == NULL) {
+        isc_throw(isc::InvalidOperation,
+                  "getHeader() called on an unusable mapped segment");
+    }
+    return (*header_);
+}
+
+const ZoneTableHeader&
+ZoneTableSegmentMapped::getHeader() const {
+    if (header_ == NULL) {
+        isc_throw(isc::InvalidOperation,
+                  "getHeader() called on an unusable mapped segment");
+    }
+    return (*header_);
+}
+
+MemorySegment&
+ZoneTableSegmentMapped::getMemorySegment() {
+    if (!mem_sgmt_) {
+        isc_throw(isc::InvalidOperation,
+                  "getMemorySegment() called on an unusable mapped segment");
+    }
+    return (*mem_sgmt_);
+}
+
+bool
+ZoneTableSegmentMapped::isUsable() const {
+    return (header_ != NULL);
+}
+
+bool
+ZoneTableSegmentMapped::isWritable() const {
+    return (isUsable() && writable_);
+}
+
+void
+ZoneTableSegmentMapped::reset(MemorySegmentOpenMode mode,
+                              ConstElementPtr params)
+{
+    if (!params || params->getType() != Element::map) {
+        isc_throw(isc::InvalidParameter,
+                  "mapped segment parameters must be a map");
+    }
+    ConstElementPtr file = params->get("mapped-file");
+    if (!file || file->getType() != Element::string) {
+        isc_throw(isc::InvalidParameter,
+                  "mapped segment parameters have no \"mapped-file\" string");
+    }
+    const std::string filename = file->stringValue();
+
+    // The same file can't be mapped twice, otherwise the current one is
+    // kept until the new one is ready.
+    if (mem_sgmt_ && filename == filename_) {
+        clear();
+    }
+
+    std::auto_ptr<MemorySegmentMapped> segment;
+    ZoneTableHeader* header = NULL;
+    try {
+        switch (mode) {
+        case CREATE:
+        case READ_WRITE:
+            segment.reset(new MemorySegmentMapped(
+                              filename, mode == CREATE ?
+                              MemorySegmentMapped::CREATE_ONLY :
+                              MemorySegmentMapped::OPEN_OR_CREATE));
+            header = openHeader(*segment, rrclass_);
+            break;
+        case READ_ONLY:
+            segment.reset(new MemorySegmentMapped(filename));
+            header = static_cast<ZoneTableHeader*>(
+                segment->getNamedAddress(ZONE_TABLE_HEADER_NAME));
+            if (header == NULL || header->getTable() == NULL) {
+                isc_throw(ResetFailed, "mapped file " << filename
+                          << " has no zone table");
+            }
+            break;
+        }
+    } catch (const MemorySegmentOpenError& ex) {
+        isc_throw(ResetFailed, "unable to map " << filename << ": "
+                  << ex.what());
+    } catch (const MemorySegmentError& ex) {
+        isc_throw(ResetFailed, "unable to map " << filename << ": "
+                  << ex.what());
+    }
+
+    clear();
+    mem_sgmt_.reset(segment.release());
+    filename_ = filename;
+    writable_ = (mode != READ_ONLY);
+    header_ = header;
+}
+
+void
+ZoneTableSegmentMapped::clear() {
+    if (!mem_sgmt_) {
+        return;
+    }
+    header_ = NULL;
+    if (writable_) {
+        // The readers map the whole file, keep it small.
+        try {
+            mem_sgmt_->shrinkToFit();
+        } catch (const MemorySegmentError&) {
+            // This is only an optimization.
+        }
+    }
+    mem_sgmt_.reset();
+    filename_.clear();
+    writable_ = false;
+}
+
+void
+ZoneTableSegmentMapped::refreshHeader() {
+    header_ = static_cast<ZoneTableHeader*>(
+        mem_sgmt_->getNamedAddress(ZONE_TABLE_HEADER_NAME));
+}
+
+ZoneWriter*
+ZoneTableSegmentMapped::getZoneWriter(const LoadAction& load_action,
+                                      const dns::Name& name,
+                                      const dns::RRClass& rrclass)
+{
+    if (!isWritable()) {
+        isc_throw(isc::InvalidOperation,
+                  "zones can't be loaded into a read-only mapped segment");
+    }
+    return (new ZoneWriterMapped(this, load_action, name, rrclass));
+}
+
+} // namespace memory
+} // namespace datasrc
+} // namespace isc
@@ -0,0 +1,132 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef ZONE_TABLE_SEGMENT_MAPPED_H
+#define ZONE_TABLE_SEGMENT_MAPPED_H
+
+#include <datasrc/memory/zone_table_segment.h>
+#include <util/memory_segment_mapped.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <string>
+
+namespace isc {
+namespace datasrc {
+namespace memory {
+
+/// \brief Mapped-file based implementation of ZoneTableSegment class
+///
+/// This class specifies a concrete implementation for a memory-mapped
+/// ZoneTableSegment.  The zone table is kept in a file mapped into memory
+/// (\c util::MemorySegmentMapped), so one process can build the zone data
+/// and any number of other processes can serve them, sharing a single
+/// copy in memory and starting without loading anything.
+///
+/// The segment isn't usable until \c reset() opens a file, given by the
+/// "mapped-file" item of the parameters.  A writer opens it with
+/// \c CREATE (or \c READ_WRITE to update an existing version) and loads
+/// the zones with the writers returned by \c getZoneWriter().  The
+/// readers open it with \c READ_ONLY once the writer has closed it (the
+/// file can't be opened for reading and for writing at the same time).
+///
+/// To publish a new version, the writer builds it in another file, and
+/// the readers are reset to that file: each of them maps the new file
+/// before unmapping the old one, so it switches from one version to the
+/// other at once.  Two files used in turn are enough, as long as the
+/// writer only reuses a file once no reader maps it anymore.
+///
+/// A writable segment may grow, and be remapped elsewhere, while zones
+/// are loaded; the zone data of a writable segment must not be accessed
+/// while a zone writer is used.
+class ZoneTableSegmentMapped : public ZoneTableSegment {
+    // This is so that ZoneTableSegmentMapped can be instantiated from
+    // ZoneTableSegment::create().
+    friend class ZoneTableSegment;
+    // The writer refreshes the header after the segment has grown.
+    friend class ZoneWriterMapped;
+protected:
+    /// \brief Protected constructor
+    ///
+    /// Instances are expected to be created by the factory method
+    /// (\c ZoneTableSegment::create()), so this constructor is
+    /// protected.
+    ZoneTableSegmentMapped(const isc::dns::RRClass& rrclass);
+public:
+    /// \brief Destructor
+    ///
+    /// A writable segment is shrunk to the size it uses.
+    virtual ~ZoneTableSegmentMapped();
+
+    /// \brief Return the ZoneTableHeader for the mapped zone table
+    /// segment implementation.
+    ///
+    /// \throw isc::InvalidOperation The segment is not usable.
+    virtual ZoneTableHeader& getHeader();
+
+    /// \brief const version of \c getHeader().
+    ///
+    /// \throw isc::InvalidOperation The segment is not usable.
+    virtual const ZoneTableHeader& getHeader() const;
+
+    /// \brief Return the MemorySegment for the mapped zone table segment
+    /// implementation (a MemorySegmentMapped instance).
+    ///
+    /// \throw isc::InvalidOperation The segment is not usable.
+    virtual isc::util::MemorySegment& getMemorySegment();
+
+    /// \brief Return true if a file is mapped.
+    virtual bool isUsable() const;
+
+    /// \brief Return true if a file is mapped for writing.
+    virtual bool isWritable() const;
+
+    /// \brief Map the file given by the "mapped-file" item of \c params.
+    ///
+    /// With \c CREATE and \c READ_WRITE, a zone table is created in the
+    /// file if it has none.  With \c READ_ONLY the file must have one.
+    /// If the file is the one currently mapped, it's unmapped first, as
+    /// it can't be mapped twice.
+    ///
+    /// \throw isc::InvalidParameter \c params has no "mapped-file"
+    /// string.
+    /// \throw ResetFailed The file can't be mapped in this mode, or it
+    /// has no zone table.
+    virtual void reset(MemorySegmentOpenMode mode,
+                       isc::data::ConstElementPtr params);
+
+    /// \brief Unmap the current file, if any.
+    virtual void clear();
+
+    /// \brief Concrete implementation of ZoneTableSegment::getZoneWriter
+    virtual ZoneWriter* getZoneWriter(const LoadAction& load_action,
+                                      const dns::Name& origin,
+                                      const dns::RRClass& rrclass);
+
+private:
+    // Locate the header again, after the segment has grown.
+    void refreshHeader();
+
+    const isc::dns::RRClass rrclass_;
+    boost::scoped_ptr<isc::util::MemorySegmentMapped> mem_sgmt_;
+    std::string filename_;
+    bool writable_;
+    ZoneTableHeader* header_;
+};
+
+} // namespace memory
+} // namespace datasrc
+} // namespace isc
+
+#endif // ZONE_TABLE_SEGMENT_MAPPED_H
@@ -0,0 +1,120 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "zone_writer_mapped.h"
+#include "zone_data.h"
+#include "zone_table_segment_mapped.h"
+#include "segment_object_holder.h"
+
+using isc::util::MemorySegmentGrown;
+
+namespace isc {
+namespace datasrc {
+namespace memory {
+
+ZoneWriterMapped::ZoneWriterMapped(ZoneTableSegmentMapped* segment,
+                                   const LoadAction& load_action,
+                                   const dns::Name& origin,
+                                   const dns::RRClass& rrclass) :
+    segment_(segment),
+    load_action_(load_action),
+    origin_(origin),
+    rrclass_(rrclass),
+    zone_data_name_(detail::getNextHolderName()),
+    state_(ZW_UNUSED)
+{}
+
+ZoneWriterMapped::~ZoneWriterMapped() {
+    // Clean up everything there might be left if someone forgot, just
+    // in case.
+    cleanup();
+}
+
+ZoneData*
+ZoneWriterMapped::getZoneData() {
+    return (static_cast<ZoneData*>(segment_->getMemorySegment().
+                                   getNamedAddress(zone_data_name_.c_str())));
+}
+
+void
+ZoneWriterMapped::setZoneData(ZoneData* zone_data) {
+    // Naming the address can grow the segment too.
+    segment_->getMemorySegment().setNamedAddress(zone_data_name_.c_str(),
+                                                 zone_data);
+    segment_->refreshHeader();
+}
+
+void
+ZoneWriterMapped::load() {
+    if (state_ != ZW_UNUSED) {
+        isc_throw(isc::InvalidOperation, "Trying to load twice");
+    }
+
+    // The loader handles the growth of the segment by itself.
+    ZoneData* zone_data = load_action_(segment_->getMemorySegment());
+    segment_->refreshHeader();
+
+    if (zone_data == NULL) {
+        // Bug inside load_action_.
+        isc_throw(isc::InvalidOperation, "No data returned from load action");
+    }
+
+    setZoneData(zone_data);
+    state_ = ZW_LOADED;
+}
+
+void
+ZoneWriterMapped::install() {
+    if (state_ != ZW_LOADED) {
+        isc_throw(isc::InvalidOperation, "No data to install");
+    }
+
+    while (state_ != ZW_INSTALLED) {
+        ZoneTable* table(segment_->getHeader().getTable());
+        if (table == NULL) {
+            isc_throw(isc::Unexpected, "No zone table present");
+        }
+        try {
+            const ZoneTable::AddResult result(
+                table->addZone(segment_->getMemorySegment(), rrclass_,
+                               origin_, getZoneData()));
+            state_ = ZW_INSTALLED;
+            setZoneData(result.zone_data);
+        } catch (const MemorySegmentGrown&) {
+            // The zone data weren't added, try again where the zone table
+            // is now.
+            segment_->refreshHeader();
+        }
+    }
+}
+
+void
+ZoneWriterMapped::cleanup() {
+    // We eat the data (if any) now.
+
+    if (state_ == ZW_LOADED || state_ == ZW_INSTALLED) {
+        ZoneData* zone_data = getZoneData();
+        if (zone_data != NULL) {
+            ZoneData::destroy(segment_->getMemorySegment(), zone_data,
+                              rrclass_);
+        }
+        segment_->getMemorySegment().clearNamedAddress(
+            zone_data_name_.c_str());
+        state_ = ZW_CLEANED;
+    }
+}
+
+}
+}
+}
@@ -12,6 +12,8 @@
 // OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <config.h>
+
 #include <datasrc/client_list.h>
 #include <datasrc/client.h>
 #include <datasrc/cache_config.h>
@@ -35,6 +37,8 @@
 #include <set>
 #include <fstream>
 
+#include <unistd.h>
+
 using namespace isc::datasrc;
 using isc::datasrc::unittest::MockDataSourceClient;
 using isc::datasrc::memory::InMemoryClient;
@@ -733,6 +737,54 @@ TEST_F(ListTest, masterFiles) {
     EXPECT_EQ(0, list_->getDataSources().size());
 }
 
+#ifdef USE_SHARED_MEMORY
+// A mapped cache waits for its segment, zones being loaded into it when
+// it's created.
+TEST_F(ListTest, masterFilesMapped) {
+    const ConstElementPtr elem(Element::fromJSON("["
+        "{"
+        "   \"type\": \"MasterFiles\","
+        "   \"cache-enable\": true,"
+        "   \"cache-type\": \"mapped\","
+        "   \"params\": {"
+        "       \".\": \"" TEST_DATA_DIR "/root.zone\""
+        "   }"
+        "}]"));
+    list_->configure(elem, true);
+    vector<DataSourceStatus> statuses(list_->getStatus());
+    ASSERT_EQ(1, statuses.size());
+    EXPECT_EQ(SEGMENT_WAITING, statuses[0].getSegmentState());
+    EXPECT_EQ("mapped", statuses[0].getSegmentType());
+    EXPECT_FALSE(list_->find(Name(".")).finder_);
+
+    const ConstElementPtr params(Element::fromJSON(
+        "{\"mapped-file\": \"" TEST_DATA_BUILDDIR "/list.mapped\"}"));
+    list_->resetMemorySegment("MasterFiles", ZoneTableSegment::CREATE,
+                              params);
+    statuses = list_->getStatus();
+    EXPECT_EQ(SEGMENT_INUSE, statuses[0].getSegmentState());
+    positiveResult(list_->find(Name(".")), ds_[0], Name("."), true, "root",
+                   true);
+    EXPECT_EQ(ConfigurableClientList::ZONE_SUCCESS,
+              list_->getCachedZoneWriter(Name(".")).first);
+
+    // A reader can't reload the zone.
+    list_->resetMemorySegment("MasterFiles", ZoneTableSegment::READ_ONLY,
+                              params);
+    positiveResult(list_->find(Name(".")), ds_[0], Name("."), true, "root",
+                   true);
+    EXPECT_EQ(ConfigurableClientList::ZONE_NOT_CACHED,
+              list_->getCachedZoneWriter(Name(".")).first);
+
+    EXPECT_THROW(list_->resetMemorySegment("Unknown",
+                                           ZoneTableSegment::CREATE, params),
+                 isc::InvalidParameter);
+
+    list_->configure(Element::fromJSON("[]"), true);
+    unlink(TEST_DATA_BUILDDIR "/list.mapped");
+}
+#endif
+
 // Test the names are set correctly and collission is detected.
 TEST_F(ListTest, names) {
     // Explicit name
@@ -12,12 +12,19 @@
 // OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <config.h>
+
 #include <util/memory_segment_local.h>
+#ifdef USE_SHARED_MEMORY
+#include <util/memory_segment_mapped.h>
+#endif
 
 #include <datasrc/memory/segment_object_holder.h>
 
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
 using namespace isc::util;
 using namespace isc::datasrc::memory;
 using namespace isc::datasrc::memory::detail;
@@ -64,4 +71,39 @@ TEST(SegmentObjectHolderTest, foo) {
     useHolder(sgmt, obj, false);
     EXPECT_TRUE(sgmt.allMemoryDeallocated());
 }
+
+#ifdef USE_SHARED_MEMORY
+// The held object is found again when a mapped segment grows.
+TEST(SegmentObjectHolderTest, grow) {
+    const char* const mapped_file = TEST_DATA_BUILDDIR "/holder.mapped";
+    unlink(mapped_file);
+    {
+        MemorySegmentMapped sgmt(mapped_file,
+                                 MemorySegmentMapped::CREATE_ONLY);
+        {
+            void* p = sgmt.allocate(sizeof(TestObject));
+            SegmentObjectHolder<TestObject, int> holder(sgmt,
+                                                        new(p) TestObject,
+                                                        TEST_ARG_VAL);
+
+            // Allocate more than the segment has, so it grows (and may
+            // be remapped elsewhere).
+            const size_t big_size = sgmt.getSize() * 4;
+            void* big = NULL;
+            while (big == NULL) {
+                try {
+                    big = sgmt.allocate(big_size);
+                } catch (const MemorySegmentGrown&) {}
+            }
+            sgmt.deallocate(big, big_size);
+            EXPECT_EQ(sgmt.getNamedAddress("no such name"),
+                      static_cast<void*>(NULL));
+            EXPECT_NE(static_cast<TestObject*>(NULL), holder.get());
+        }
+        // The holder has destroyed the object where it is now.
+        EXPECT_TRUE(sgmt.allMemoryDeallocated());
+    }
+    unlink(mapped_file);
+}
+#endif
 }
@@ -48,6 +48,9 @@ protected:
     {}
 
     ~ZoneDataUpdaterTest() {
+        // The updater refers to the zone data by a name in the segment,
+        // which must be released before checking for leaks.
+        updater_.reset();
         if (zone_data_ != NULL) {
             ZoneData::destroy(mem_sgmt_, zone_data_, zclass_);
         }
@@ -0,0 +1,309 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/zone_table_segment_mapped.h>
+#include <datasrc/memory/zone_writer_mapped.h>
+#include <datasrc/memory/zone_data_loader.h>
+#include <datasrc/memory/zone_data_updater.h>
+#include <datasrc/memory/segment_object_holder.h>
+#include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/zone_table.h>
+
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+#include <dns/rdataclass.h>
+
+#include <cc/data.h>
+#include <util/memory_segment_mapped.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <unistd.h>
+
+using namespace isc::dns;
+using namespace isc::datasrc;
+using namespace isc::datasrc::memory;
+using namespace isc::data;
+using namespace isc::util;
+using boost::scoped_ptr;
+using boost::lexical_cast;
+using std::string;
+
+namespace {
+
+const char* const MAPPED_FILE = TEST_DATA_BUILDDIR "/test1.mapped";
+const char* const MAPPED_FILE2 = TEST_DATA_BUILDDIR "/test2.mapped";
+
+// Parameters of the mapped segment for a file.
+ConstElementPtr
+mappedParams(const char* filename) {
+    return (Element::fromJSON(string("{\"mapped-file\": \"") + filename +
+                              "\"}"));
+}
+
+// A load action loading a zone from a file of the test data.
+ZoneData*
+loadFromFile(MemorySegment& segment, const Name& origin, const string& file) {
+    return (loadZoneData(segment, RRClass::IN(), origin,
+                         string(TEST_DATA_DIR "/") + file));
+}
+
+// A load action adding many names to the zone, so the segment grows
+// several times while the zone is loaded.
+ZoneData*
+loadManyNames(MemorySegment& segment, const Name& origin, size_t count) {
+    ZoneData* zone_data = NULL;
+    while (zone_data == NULL) {
+        try {
+            zone_data = ZoneData::create(segment, origin);
+        } catch (const MemorySegmentGrown&) {}
+    }
+    detail::SegmentObjectHolder<ZoneData, RRClass> holder(segment, zone_data,
+                                                          RRClass::IN());
+    ZoneDataUpdater updater(segment, RRClass::IN(), origin, *holder.get());
+    for (size_t i = 0; i < count; ++i) {
+        RRsetPtr rrset(new RRset(Name("host" + lexical_cast<string>(i)).
+                                 concatenate(origin), RRClass::IN(),
+                                 RRType::A(), RRTTL(3600)));
+        rrset->addRdata(rdata::in::A("192.0.2.1"));
+        updater.add(rrset, ConstRRsetPtr());
+    }
+    return (holder.release());
+}
+
+class ZoneTableSegmentMappedTest : public ::testing::Test {
+protected:
+    ZoneTableSegmentMappedTest() :
+        ztable_segment_(ZoneTableSegment::create(RRClass::IN(), "mapped")),
+        params_(mappedParams(MAPPED_FILE)),
+        params2_(mappedParams(MAPPED_FILE2))
+    {}
+
+    void SetUp() {
+        unlink(MAPPED_FILE);
+        unlink(MAPPED_FILE2);
+    }
+
+    void TearDown() {
+        ZoneTableSegment::destroy(ztable_segment_);
+        ztable_segment_ = NULL;
+        unlink(MAPPED_FILE);
+        unlink(MAPPED_FILE2);
+    }
+
+    // Loads a zone from a file of the test data.
+    void loadZone(ZoneTableSegment& segment, const Name& origin,
+                  const string& file)
+    {
+        scoped_ptr<ZoneWriter> writer(segment.getZoneWriter(
+            boost::bind(loadFromFile, _1, origin, file), origin,
+            RRClass::IN()));
+        writer->load();
+        writer->install();
+        writer->cleanup();
+    }
+
+    // Returns the result code of finding a zone in a segment.
+    result::Result findZone(const ZoneTableSegment& segment,
+                            const Name& origin)
+    {
+        return (segment.getHeader().getTable()->findZone(origin).code);
+    }
+
+    ZoneTableSegment* ztable_segment_;
+    const ConstElementPtr params_;
+    const ConstElementPtr params2_;
+};
+
+TEST_F(ZoneTableSegmentMappedTest, create) {
+    ASSERT_NE(static_cast<void*>(NULL), ztable_segment_);
+    EXPECT_NE(static_cast<void*>(NULL),
+              dynamic_cast<ZoneTableSegmentMapped*>(ztable_segment_));
+
+    // Nothing is mapped yet.
+    EXPECT_FALSE(ztable_segment_->isUsable());
+    EXPECT_FALSE(ztable_segment_->isWritable());
+    EXPECT_THROW(ztable_segment_->getHeader(), isc::InvalidOperation);
+    EXPECT_THROW(ztable_segment_->getMemorySegment(), isc::InvalidOperation);
+    EXPECT_THROW(ztable_segment_->getZoneWriter(
+                     boost::bind(loadManyNames, _1, Name("example.org"), 1),
+                     Name("example.org"), RRClass::IN()),
+                 isc::InvalidOperation);
+}
+
+TEST_F(ZoneTableSegmentMappedTest, resetBadParams) {
+    EXPECT_THROW(ztable_segment_->reset(ZoneTableSegment::CREATE,
+                                        ConstElementPtr()),
+                 isc::InvalidParameter);
+    EXPECT_THROW(ztable_segment_->reset(ZoneTableSegment::CREATE,
+                                        Element::fromJSON("\"file\"")),
+                 isc::InvalidParameter);
+    EXPECT_THROW(ztable_segment_->reset(ZoneTableSegment::CREATE,
+                                        Element::fromJSON("{}")),
+                 isc::InvalidParameter);
+    EXPECT_THROW(ztable_segment_->reset(ZoneTableSegment::CREATE,
+                                        Element::fromJSON(
+                                            "{\"mapped-file\": 42}")),
+                 isc::InvalidParameter);
+    EXPECT_FALSE(ztable_segment_->isUsable());
+}
+
+TEST_F(ZoneTableSegmentMappedTest, resetCreate) {
+    ztable_segment_->reset(ZoneTableSegment::CREATE, params_);
+    EXPECT_TRUE(ztable_segment_->isUsable());
+    EXPECT_TRUE(ztable_segment_->isWritable());
+    ASSERT_NE(static_cast<void*>(NULL),
+              ztable_segment_->getHeader().getTable());
+    EXPECT_EQ(0, ztable_segment_->getHeader().getTable()->getZoneCount());
+
+    ztable_segment_->clear();
+    EXPECT_FALSE(ztable_segment_->isUsable());
+    EXPECT_FALSE(ztable_segment_->isWritable());
+}
+
+TEST_F(ZoneTableSegmentMappedTest, resetReadOnlyWithoutFile) {
+    EXPECT_THROW(ztable_segment_->reset(ZoneTableSegment::READ_ONLY,
+                                        params_),
+                 ResetFailed);
+    EXPECT_FALSE(ztable_segment_->isUsable());
+}
+
+TEST_F(ZoneTableSegmentMappedTest, resetReadOnlyWithoutZoneTable) {
+    // A mapped file which wasn't made by a zone table segment.
+    {
+        MemorySegmentMapped segment(MAPPED_FILE,
+                                    MemorySegmentMapped::CREATE_ONLY);
+    }
+    EXPECT_THROW(ztable_segment_->reset(ZoneTableSegment::READ_ONLY,
+                                        params_),
+                 ResetFailed);
+    EXPECT_FALSE(ztable_segment_->isUsable());
+
+    // A writer adds the zone table.
+    ztable_segment_->reset(ZoneTableSegment::READ_WRITE, params_);
+    EXPECT_TRUE(ztable_segment_->isWritable());
+    EXPECT_EQ(0, ztable_segment_->getHeader().getTable()->getZoneCount());
+}
+
+TEST_F(ZoneTableSegmentMappedTest, loadAndMapReadOnly) {
+    ztable_segment_->reset(ZoneTableSegment::CREATE, params_);
+    loadZone(*ztable_segment_, Name("example.org"), "example.org.zone");
+    EXPECT_EQ(result::SUCCESS, findZone(*ztable_segment_,
+                                        Name("example.org")));
+    ztable_segment_->clear();
+
+    // The zone is served by a read-only segment.
+    scoped_ptr<ZoneTableSegment> reader(
+        ZoneTableSegment::create(RRClass::IN(), "mapped"));
+    reader->reset(ZoneTableSegment::READ_ONLY, params_);
+    EXPECT_TRUE(reader->isUsable());
+    EXPECT_FALSE(reader->isWritable());
+    EXPECT_EQ(1, reader->getHeader().getTable()->getZoneCount());
+    EXPECT_EQ(result::SUCCESS, findZone(*reader, Name("example.org")));
+    EXPECT_EQ(result::PARTIALMATCH,
+              findZone(*reader, Name("www.example.org")));
+
+    // Zones can't be loaded into it.
+    EXPECT_THROW(reader->getZoneWriter(
+                     boost::bind(loadManyNames, _1, Name("example.com"), 1),
+                     Name("example.com"), RRClass::IN()),
+                 isc::InvalidOperation);
+}
+
+TEST_F(ZoneTableSegmentMappedTest, reopenForWriting) {
+    ztable_segment_->reset(ZoneTableSegment::CREATE, params_);
+    loadZone(*ztable_segment_, Name("example.org"), "example.org.zone");
+
+    // Resetting to the same file reopens it, the zone remains.
+    ztable_segment_->reset(ZoneTableSegment::READ_WRITE, params_);
+    EXPECT_EQ(result::SUCCESS, findZone(*ztable_segment_,
+                                        Name("example.org")));
+
+    // Unless it's created again.
+    ztable_segment_->reset(ZoneTableSegment::CREATE, params_);
+    EXPECT_EQ(result::NOTFOUND, findZone(*ztable_segment_,
+                                         Name("example.org")));
+}
+
+TEST_F(ZoneTableSegmentMappedTest, loadWhileGrowing) {
+    ztable_segment_->reset(ZoneTableSegment::CREATE, params_);
+    const size_t initial_size = dynamic_cast<MemorySegmentMapped&>(
+        ztable_segment_->getMemorySegment()).getSize();
+
+    // Enough names to grow the segment several times, while it's loaded
+    // and while it's installed.
+    const Name origin("example.com");
+    const size_t count = 2000;
+    for (int i = 0; i < 2; ++i) {
+        scoped_ptr<ZoneWriter> writer(ztable_segment_->getZoneWriter(
+            boost::bind(loadManyNames, _1, origin, count), origin,
+            RRClass::IN()));
+        writer->load();
+        writer->install();
+        writer->cleanup();
+    }
+    EXPECT_LT(initial_size, dynamic_cast<MemorySegmentMapped&>(
+                  ztable_segment_->getMemorySegment()).getSize());
+    ztable_segment_->clear();
+
+    scoped_ptr<ZoneTableSegment> reader(
+        ZoneTableSegment::create(RRClass::IN(), "mapped"));
+    reader->reset(ZoneTableSegment::READ_ONLY, params_);
+    const ZoneTable::FindResult result =
+        reader->getHeader().getTable()->findZone(origin);
+    ASSERT_EQ(result::SUCCESS, result.code);
+    for (size_t i = 0; i < count; ++i) {
+        const ZoneNode* node = NULL;
+        EXPECT_EQ(ZoneTree::EXACTMATCH,
+                  result.zone_data->getZoneTree().find(
+                      Name("host" + lexical_cast<string>(i)).
+                      concatenate(origin), &node));
+        ASSERT_NE(static_cast<const ZoneNode*>(NULL), node);
+        EXPECT_NE(static_cast<const RdataSet*>(NULL), node->getData());
+    }
+}
+
+TEST_F(ZoneTableSegmentMappedTest, switchVersions) {
+    // Two versions, built in two files.
+    ztable_segment_->reset(ZoneTableSegment::CREATE, params_);
+    loadZone(*ztable_segment_, Name("example.org"), "example.org.zone");
+    ztable_segment_->reset(ZoneTableSegment::CREATE, params2_);
+    loadZone(*ztable_segment_, Name("example.org"), "example.org.zone");
+    loadZone(*ztable_segment_, Name("example.com"), "2503-test.zone");
+    ztable_segment_->clear();
+
+    scoped_ptr<ZoneTableSegment> reader(
+        ZoneTableSegment::create(RRClass::IN(), "mapped"));
+    reader->reset(ZoneTableSegment::READ_ONLY, params_);
+    EXPECT_EQ(1, reader->getHeader().getTable()->getZoneCount());
+    reader->reset(ZoneTableSegment::READ_ONLY, params2_);
+    EXPECT_EQ(2, reader->getHeader().getTable()->getZoneCount());
+
+    // If the next version can't be mapped, the current one is kept.
+    EXPECT_THROW(reader->reset(ZoneTableSegment::READ_ONLY,
+                               mappedParams(TEST_DATA_BUILDDIR
+                                            "/nonexistent.mapped")),
+                 ResetFailed);
+    EXPECT_TRUE(reader->isUsable());
+    EXPECT_EQ(2, reader->getHeader().getTable()->getZoneCount());
+}
+
+} // anonymous namespace
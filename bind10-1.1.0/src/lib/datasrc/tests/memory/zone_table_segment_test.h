@@ -53,6 +53,22 @@ public:
         return (mem_sgmt_);
     }
 
+    virtual bool isUsable() const {
+        return (true);
+    }
+
+    virtual bool isWritable() const {
+        return (true);
+    }
+
+    virtual void reset(MemorySegmentOpenMode, isc::data::ConstElementPtr) {
+        isc_throw(isc::NotImplemented, "reset() not implemented");
+    }
+
+    virtual void clear() {
+        isc_throw(isc::NotImplemented, "clear() not implemented");
+    }
+
     virtual ZoneWriter* getZoneWriter(const LoadAction& load_action,
                                       const dns::Name& name,
                                       const dns::RRClass& rrclass)
@@ -79,6 +79,17 @@ TEST_F(ZoneTableSegmentTest, getMemorySegment) {
     mem_sgmt.allMemoryDeallocated(); // use mem_sgmt
 }
 
+TEST_F(ZoneTableSegmentTest, resetLocal) {
+    // The local segment is set up at creation and can't be reset.
+    EXPECT_TRUE(ztable_segment_->isUsable());
+    EXPECT_TRUE(ztable_segment_->isWritable());
+    EXPECT_THROW(ztable_segment_->reset(ZoneTableSegment::CREATE,
+                                        Element::fromJSON("{}")),
+                 isc::NotImplemented);
+    EXPECT_THROW(ztable_segment_->clear(), isc::NotImplemented);
+    EXPECT_TRUE(ztable_segment_->isUsable());
+}
+
 ZoneData*
 loadAction(MemorySegment&) {
     // The function won't be called, so this is OK
@@ -78,6 +78,14 @@ TEST_F(ZoneTableTest, addZone) {
                  isc::BadValue);
     EXPECT_EQ(0, zone_table->getZoneCount()); // count is still 0
 
+    // Nor zones of another class. The zone data remains with the caller.
+    SegmentObjectHolder<ZoneData, RRClass> holder_ch(
+        mem_sgmt_, ZoneData::create(mem_sgmt_, zname1), RRClass::CH());
+    EXPECT_THROW(zone_table->addZone(mem_sgmt_, RRClass::CH(), zname1,
+                                     holder_ch.get()),
+                 isc::BadValue);
+    EXPECT_EQ(0, zone_table->getZoneCount());
+
     SegmentObjectHolder<ZoneData, RRClass> holder1(
         mem_sgmt_, ZoneData::create(mem_sgmt_, zname1), zclass_);
     const ZoneData* data1(holder1.get());
@@ -130,14 +138,16 @@ TEST_F(ZoneTableTest, addZone) {
     EXPECT_EQ(3, zone_table->getZoneCount());
 
     // Have the memory segment throw an exception in extending the internal
-    // tree.  It still shouldn't cause memory leak (which would be detected
-    // in TearDown()).
+    // tree.  The zone data remains with the caller, so it's released by
+    // the holder and there's no memory leak (which would be detected in
+    // TearDown()).
     SegmentObjectHolder<ZoneData, RRClass> holder6(
         mem_sgmt_, ZoneData::create(mem_sgmt_, Name("example.org")), zclass_);
     mem_sgmt_.setThrowCount(1);
     EXPECT_THROW(zone_table->addZone(mem_sgmt_, zclass_, Name("example.org"),
-                                     holder6.release()),
+                                     holder6.get()),
                  std::bad_alloc);
+    EXPECT_EQ(3, zone_table->getZoneCount());
 }
 
 TEST_F(ZoneTableTest, findZone) {
@@ -0,0 +1,371 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/alloc_counter.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+#include <dhcp/hwaddr.h>
+#include <dhcp/libdhcp++.h>
+#include <dhcp/option.h>
+#include <dhcp/option6_ia.h>
+#include <dhcp/option6_iaaddr.h>
+#include <dhcp/pkt4.h>
+#include <dhcp/pkt6.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace isc::asiolink;
+using namespace isc::bench;
+using namespace isc::dhcp;
+
+namespace {
+
+//
+// Builtin benchmark data.
+//
+// The packets below are assembled to resemble the traffic seen by a server
+// serving clients behind relays: a DHCPv4 DISCOVER forwarded by a relay
+// agent adding the relay agent information option, and a DHCPv6 SOLICIT
+// encapsulated in a RELAY-FORW message carrying the interface-id.  The
+// sets of options are those sent by common client implementations.
+
+/// @brief Appends an option to the DHCPv4 packet.
+void
+addOption4(vector<uint8_t>& wire, uint8_t type, const uint8_t* data,
+           size_t len)
+{
+    wire.push_back(type);
+    wire.push_back(len);
+    wire.insert(wire.end(), data, data + len);
+}
+
+/// @brief Appends an option to the DHCPv6 packet.
+void
+addOption6(vector<uint8_t>& wire, uint16_t type, const uint8_t* data,
+           size_t len)
+{
+    wire.push_back(type >> 8);
+    wire.push_back(type & 0xFF);
+    wire.push_back(len >> 8);
+    wire.push_back(len & 0xFF);
+    wire.insert(wire.end(), data, data + len);
+}
+
+/// @brief Returns the relayed DHCPDISCOVER.
+vector<uint8_t>
+createDiscover() {
+    // op, htype, hlen, hops, xid, secs, flags
+    const uint8_t header[] = { BOOTREQUEST, HTYPE_ETHER, 6, 1,
+                               0x5a, 0x3c, 0x1e, 0x0f, 0, 0, 0, 0 };
+    vector<uint8_t> wire(header, header + sizeof(header));
+    // ciaddr, yiaddr, siaddr
+    wire.resize(wire.size() + 12, 0);
+    // giaddr
+    const uint8_t giaddr[] = { 192, 0, 2, 1 };
+    wire.insert(wire.end(), giaddr, giaddr + sizeof(giaddr));
+    // chaddr, sname, file
+    const uint8_t chaddr[] = { 0x00, 0x1c, 0x42, 0x7e, 0x35, 0x9a };
+    wire.insert(wire.end(), chaddr, chaddr + sizeof(chaddr));
+    wire.resize(Pkt4::DHCPV4_PKT_HDR_LEN, 0);
+    // magic cookie
+    const uint8_t cookie[] = { 0x63, 0x82, 0x53, 0x63 };
+    wire.insert(wire.end(), cookie, cookie + sizeof(cookie));
+
+    const uint8_t msg_type[] = { DHCPDISCOVER };
+    addOption4(wire, DHO_DHCP_MESSAGE_TYPE, msg_type, sizeof(msg_type));
+    const uint8_t client_id[] = { HTYPE_ETHER,
+                                  0x00, 0x1c, 0x42, 0x7e, 0x35, 0x9a };
+    addOption4(wire, DHO_DHCP_CLIENT_IDENTIFIER, client_id,
+               sizeof(client_id));
+    const uint8_t max_size[] = { 0x05, 0xdc };
+    addOption4(wire, DHO_DHCP_MAX_MESSAGE_SIZE, max_size, sizeof(max_size));
+    const uint8_t host_name[] = "workstation-17";
+    addOption4(wire, DHO_HOST_NAME, host_name, sizeof(host_name) - 1);
+    const uint8_t vendor_class[] = "MSFT 5.0";
+    addOption4(wire, DHO_VENDOR_CLASS_IDENTIFIER, vendor_class,
+               sizeof(vendor_class) - 1);
+    const uint8_t prl[] = { 1, 3, 6, 15, 31, 33, 43, 44, 46, 47, 119, 121,
+                            249, 252 };
+    addOption4(wire, DHO_DHCP_PARAMETER_REQUEST_LIST, prl, sizeof(prl));
+    // circuit-id and remote-id sub-options
+    const uint8_t agent_info[] = { 1, 6, 0x00, 0x04, 0x00, 0x0a, 0x01, 0x17,
+                                   2, 6, 0x00, 0x0d, 0xb9, 0x21, 0x4f, 0x80 };
+    addOption4(wire, DHO_DHCP_AGENT_OPTIONS, agent_info, sizeof(agent_info));
+    wire.push_back(DHO_END);
+    // Clients usually pad the packet to the minimal BOOTP size.
+    if (wire.size() < 300) {
+        wire.resize(300, DHO_PAD);
+    }
+    return (wire);
+}
+
+/// @brief Returns the SOLICIT encapsulated in RELAY-FORW.
+vector<uint8_t>
+createSolicit() {
+    const uint8_t header[] = { DHCPV6_SOLICIT, 0x2c, 0x41, 0x9e };
+    vector<uint8_t> solicit(header, header + sizeof(header));
+    // DUID-LLT
+    const uint8_t duid[] = { 0, 1, 0, 1, 0x19, 0x8f, 0x4d, 0x21,
+                             0x00, 0x1c, 0x42, 0x7e, 0x35, 0x9a };
+    addOption6(solicit, D6O_CLIENTID, duid, sizeof(duid));
+    // IAID, T1, T2
+    const uint8_t ia_na[] = { 0x0e, 0x00, 0x1c, 0x42, 0, 0, 0, 0,
+                              0, 0, 0, 0 };
+    addOption6(solicit, D6O_IA_NA, ia_na, sizeof(ia_na));
+    const uint8_t elapsed[] = { 0, 0 };
+    addOption6(solicit, D6O_ELAPSED_TIME, elapsed, sizeof(elapsed));
+    const uint8_t oro[] = { 0, D6O_NAME_SERVERS, 0, 24, 0, 17, 0, 39 };
+    addOption6(solicit, D6O_ORO, oro, sizeof(oro));
+
+    // msg-type, hop-count, link-address 2001:db8:1::1,
+    // peer-address fe80::21c:42ff:fe7e:359a
+    const uint8_t relay_header[] = {
+        DHCPV6_RELAY_FORW, 0,
+        0x20, 0x01, 0x0d, 0xb8, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1,
+        0xfe, 0x80, 0, 0, 0, 0, 0, 0, 0x02, 0x1c, 0x42, 0xff,
+        0xfe, 0x7e, 0x35, 0x9a };
+    vector<uint8_t> wire(relay_header, relay_header + sizeof(relay_header));
+    const uint8_t interface_id[] = "ge-0/0/1.100";
+    addOption6(wire, D6O_INTERFACE_ID, interface_id,
+               sizeof(interface_id) - 1);
+    addOption6(wire, D6O_RELAY_MSG, &solicit[0], solicit.size());
+    return (wire);
+}
+
+/// @brief Returns the option holding the given data.
+OptionPtr
+createOption(Option::Universe u, uint16_t type, const uint8_t* data,
+             size_t len)
+{
+    return (OptionPtr(new Option(u, type, OptionBuffer(data, data + len))));
+}
+
+/// @brief Parses the received DHCPv4 packet.
+class Pkt4UnpackBenchMark {
+public:
+    Pkt4UnpackBenchMark(const vector<uint8_t>& wire) : wire_(wire) {}
+    unsigned int run() {
+        Pkt4 pkt(&wire_[0], wire_.size());
+        pkt.unpack();
+        return (1);
+    }
+private:
+    const vector<uint8_t>& wire_;
+};
+
+/// @brief Builds and packs the DHCPOFFER.
+///
+/// The options are created in advance; the benchmark measures the
+/// creation of the packet object and the rendering, as done by the server
+/// for each response.
+class Pkt4PackBenchMark {
+public:
+    Pkt4PackBenchMark() : hwaddr_(new HWAddr()) {
+        const uint8_t mac[] = { 0x00, 0x1c, 0x42, 0x7e, 0x35, 0x9a };
+        hwaddr_->hwaddr_.assign(mac, mac + sizeof(mac));
+        hwaddr_->htype_ = HTYPE_ETHER;
+
+        const uint8_t server_id[] = { 192, 0, 2, 254 };
+        options_.push_back(createOption(Option::V4, DHO_DHCP_SERVER_IDENTIFIER,
+                                        server_id, sizeof(server_id)));
+        const uint8_t lease_time[] = { 0, 0, 0x0e, 0x10 };
+        options_.push_back(createOption(Option::V4, DHO_DHCP_LEASE_TIME,
+                                        lease_time, sizeof(lease_time)));
+        const uint8_t netmask[] = { 255, 255, 255, 0 };
+        options_.push_back(createOption(Option::V4, DHO_SUBNET_MASK,
+                                        netmask, sizeof(netmask)));
+        const uint8_t routers[] = { 192, 0, 2, 1 };
+        options_.push_back(createOption(Option::V4, DHO_ROUTERS,
+                                        routers, sizeof(routers)));
+        const uint8_t dns[] = { 192, 0, 2, 53, 192, 0, 2, 54 };
+        options_.push_back(createOption(Option::V4, DHO_DOMAIN_NAME_SERVERS,
+                                        dns, sizeof(dns)));
+        const uint8_t domain[] = "example.org";
+        options_.push_back(createOption(Option::V4, DHO_DOMAIN_NAME,
+                                        domain, sizeof(domain) - 1));
+    }
+    unsigned int run() {
+        Pkt4 pkt(DHCPOFFER, 0x5a3c1e0f);
+        pkt.setHWAddr(hwaddr_);
+        pkt.setYiaddr(IOAddress("192.0.2.117"));
+        pkt.setGiaddr(IOAddress("192.0.2.1"));
+        for (vector<OptionPtr>::const_iterator it = options_.begin();
+             it != options_.end(); ++it) {
+            pkt.addOption(*it);
+        }
+        pkt.pack();
+        return (1);
+    }
+private:
+    HWAddrPtr hwaddr_;
+    vector<OptionPtr> options_;
+};
+
+/// @brief Parses the received DHCPv6 packet.
+class Pkt6UnpackBenchMark {
+public:
+    Pkt6UnpackBenchMark(const vector<uint8_t>& wire) : wire_(wire) {}
+    unsigned int run() {
+        Pkt6 pkt(&wire_[0], wire_.size());
+        const bool unpacked = pkt.unpack();
+        assert(unpacked);
+        return (1);
+    }
+private:
+    const vector<uint8_t>& wire_;
+};
+
+/// @brief Builds and packs the relayed ADVERTISE.
+class Pkt6PackBenchMark {
+public:
+    Pkt6PackBenchMark() {
+        relay_.msg_type_ = DHCPV6_RELAY_REPL;
+        relay_.linkaddr_ = IOAddress("2001:db8:1::1");
+        relay_.peeraddr_ = IOAddress("fe80::21c:42ff:fe7e:359a");
+        const uint8_t interface_id[] = "ge-0/0/1.100";
+        relay_.options_.insert(make_pair(D6O_INTERFACE_ID,
+            createOption(Option::V6, D6O_INTERFACE_ID, interface_id,
+                         sizeof(interface_id) - 1)));
+
+        const uint8_t client_id[] = { 0, 1, 0, 1, 0x19, 0x8f, 0x4d, 0x21,
+                                      0x00, 0x1c, 0x42, 0x7e, 0x35, 0x9a };
+        options_.push_back(createOption(Option::V6, D6O_CLIENTID, client_id,
+                                        sizeof(client_id)));
+        const uint8_t server_id[] = { 0, 1, 0, 1, 0x19, 0x80, 0x11, 0x02,
+                                      0x08, 0x00, 0x27, 0x5e, 0xa1, 0x44 };
+        options_.push_back(createOption(Option::V6, D6O_SERVERID, server_id,
+                                        sizeof(server_id)));
+        boost::shared_ptr<Option6IA> ia(new Option6IA(D6O_IA_NA, 0x0e001c42));
+        ia->setT1(1800);
+        ia->setT2(2880);
+        ia->addOption(OptionPtr(new Option6IAAddr(D6O_IAADDR,
+                                                  IOAddress("2001:db8:1::3a7"),
+                                                  3600, 7200)));
+        options_.push_back(ia);
+        const uint8_t dns[] = { 0x20, 0x01, 0x0d, 0xb8, 0, 1, 0, 0,
+                                0, 0, 0, 0, 0, 0, 0, 0x35 };
+        options_.push_back(createOption(Option::V6, D6O_NAME_SERVERS, dns,
+                                        sizeof(dns)));
+    }
+    unsigned int run() {
+        Pkt6 pkt(DHCPV6_ADVERTISE, 0x2c419e);
+        pkt.addRelayInfo(relay_);
+        for (vector<OptionPtr>::const_iterator it = options_.begin();
+             it != options_.end(); ++it) {
+            pkt.addOption(*it);
+        }
+        const bool packed = pkt.pack();
+        assert(packed);
+        return (1);
+    }
+private:
+    Pkt6::RelayInfo relay_;
+    vector<OptionPtr> options_;
+};
+
+/// @brief Parses the options of the DHCPv4 packet.
+class Options4BenchMark {
+public:
+    Options4BenchMark(const vector<uint8_t>& wire) :
+        options_(wire.begin() + Pkt4::DHCPV4_PKT_HDR_LEN + 4, wire.end())
+    {}
+    unsigned int run() {
+        Option::OptionCollection options;
+        LibDHCP::unpackOptions4(options_, options);
+        return (1);
+    }
+private:
+    const OptionBuffer options_;
+};
+
+/// @brief Parses the options of the DHCPv6 packet.
+///
+/// The options of the SOLICIT carried within the relay-msg are parsed.
+class Options6BenchMark {
+public:
+    Options6BenchMark(const vector<uint8_t>& wire) :
+        options_(wire.begin() + RELAY_MSG_OFFSET, wire.end())
+    {}
+    unsigned int run() {
+        Option::OptionCollection options;
+        LibDHCP::unpackOptions6(options_, options);
+        return (1);
+    }
+private:
+    // Relay header, interface-id option and relay-msg option header,
+    // followed by the header of the SOLICIT.
+    static const size_t RELAY_MSG_OFFSET = 34 + 4 + 12 + 4 + 4;
+
+    const OptionBuffer options_;
+};
+
+void
+usage() {
+    cerr << "Usage: pkt_bench [-n iterations]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 100000;
+    while ((ch = getopt(argc, argv, "n:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0) {
+        usage();
+    }
+
+    const vector<uint8_t> discover = createDiscover();
+    const vector<uint8_t> solicit = createSolicit();
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+    cout << "  DISCOVER size: " << discover.size() << endl;
+    cout << "  RELAY-FORW(SOLICIT) size: " << solicit.size() << endl;
+
+    Pkt4UnpackBenchMark pkt4_unpack(discover);
+    runBenchMark("Pkt4::unpack (DISCOVER)", iteration, pkt4_unpack);
+    Pkt4PackBenchMark pkt4_pack;
+    runBenchMark("Pkt4::pack (OFFER)", iteration, pkt4_pack);
+    Options4BenchMark options4(discover);
+    runBenchMark("LibDHCP::unpackOptions4 (DISCOVER)", iteration, options4);
+
+    Pkt6UnpackBenchMark pkt6_unpack(solicit);
+    runBenchMark("Pkt6::unpack (RELAY-FORW)", iteration, pkt6_unpack);
+    Pkt6PackBenchMark pkt6_pack;
+    runBenchMark("Pkt6::pack (RELAY-REPL)", iteration, pkt6_pack);
+    Options6BenchMark options6(solicit);
+    runBenchMark("LibDHCP::unpackOptions6 (SOLICIT)", iteration, options6);
+
+    return (0);
+}
@@ -27,6 +27,7 @@
 #include <util/io/pktinfo_utilities.h>
 
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -34,6 +35,8 @@
 #include <netinet/in.h>
 #include <string.h>
 #include <sys/select.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace isc::asiolink;
@@ -42,6 +45,52 @@ using namespace isc::util::io::internal;
 namespace isc {
 namespace dhcp {
 
+const size_t IfaceMgr::TIMERS_PER_RECEIVE;
+const size_t IfaceMgr::CHANNEL_BURST;
+const size_t IfaceMgr::BATCH_SIZE;
+
+namespace {
+
+/// @brief Connects to an abstract UNIX socket (4o6).
+///
+/// @param name name of the socket
+/// @return connected socket, or -1 on error
+int
+connect4o6(const char* name) {
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return (-1);
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, name);
+    addr.sun_path[0] = 0;
+    const int len = strlen(name) + offsetof(struct sockaddr_un, sun_path);
+    if (connect(fd, (struct sockaddr*)&addr, len) < 0) {
+        close(fd);
+        return (-1);
+    }
+    return (fd);
+}
+
+/// @brief Checks if an interface was detected the same way again.
+///
+/// @param a interface.
+/// @param b interface detected again.
+/// @return true if the sockets of the interface can be kept.
+bool
+sameIface(const Iface& a, const Iface& b) {
+    return ((a.getName() == b.getName()) &&
+            (a.flags_ == b.flags_) &&
+            (a.getHWType() == b.getHWType()) &&
+            (a.getMacLen() == b.getMacLen()) &&
+            (memcmp(a.getMac(), b.getMac(), a.getMacLen()) == 0) &&
+            (a.getAddresses() == b.getAddresses()));
+}
+
+}
+
 IfaceMgr&
 IfaceMgr::instance() {
     static IfaceMgr iface_mgr;
@@ -123,9 +172,14 @@ bool Iface::delSocket(uint16_t sockfd) {
 }
 
 IfaceMgr::IfaceMgr()
-    :control_buf_len_(CMSG_SPACE(sizeof(struct in6_pktinfo))),
+    :control_buf_len_(CMSG_SPACE(sizeof(struct in6_pktinfo)) +
+                      CMSG_SPACE(sizeof(struct timeval))),
      control_buf_(new char[control_buf_len_]),
+     batch6_(BATCH_SIZE, RCVBUFSIZE, control_buf_len_),
      session_socket_(INVALID_SOCKET), session_callback_(NULL),
+     socket_name_6to4_(FILENAME1), channel_burst_(0),
+     port4_(0), use_bcast4_(false), port6_(0), track_socket_(INVALID_SOCKET),
+     next_received4_(0), next_received6_(0),
      packet_filter_(new PktFilterInet())
 {
 
@@ -152,6 +206,14 @@ void IfaceMgr::closeSockets() {
          iface != ifaces_.end(); ++iface) {
         iface->closeSockets();
     }
+    port4_ = 0;
+    port6_ = 0;
+
+    // The packets read from the closed sockets are dropped.
+    received4_.clear();
+    next_received4_ = 0;
+    received6_.clear();
+    next_received6_ = 0;
     
     //4o6
     if (fd_6to4 > 0)
@@ -164,6 +226,7 @@ IfaceMgr::~IfaceMgr() {
     // control_buf_ is deleted automatically (scoped_ptr)
     control_buf_len_ = 0;
 
+    stopIfaceTracking();
     closeSockets();
 }
 
@@ -206,99 +269,111 @@ void IfaceMgr::stubDetectIfaces() {
 }
 
 bool IfaceMgr::openSockets4(const uint16_t port, const bool use_bcast) {
-    int sock;
     int count = 0;
 
-// This option is used to bind sockets to particular interfaces.
-// This is currently the only way to discover on which interface
-// the broadcast packet has been received. If this option is
-// not supported then only one interface should be confugured
-// to listen for broadcast traffic.
-#ifdef SO_BINDTODEVICE
-    const bool bind_to_device = true;
-#else
-    const bool bind_to_device = false;
-#endif
-
     /* 4o6 - init socket
     */
     fd_6to4 = socket (AF_UNIX, SOCK_STREAM, 0);
     if (fd_6to4 > 0) {
         struct sockaddr_un server_address;
         server_address.sun_family = AF_UNIX;
-        strcpy(server_address.sun_path, FILENAME1);
+        strcpy(server_address.sun_path, socket_name_6to4_.c_str());
         server_address.sun_path[0] = 0;
-        int len = strlen(FILENAME1) + offsetof(struct sockaddr_un, sun_path);
+        int len = socket_name_6to4_.size() +
+            offsetof(struct sockaddr_un, sun_path);
         bind(fd_6to4, (struct sockaddr *)&server_address, len);
         listen(fd_6to4, 5);
     }
     
+    // Remember how the sockets were opened, so as the interfaces found
+    // later by the interface tracking get the same sockets.
+    port4_ = port;
+    use_bcast4_ = use_bcast;
+
     int bcast_num = 0;
 
     for (IfaceCollection::iterator iface = ifaces_.begin();
          iface != ifaces_.end();
          ++iface) {
+        count += openIfaceSockets4(*iface, port, use_bcast, bcast_num);
+    }
+    return (count > 0);
+}
 
-        if (iface->flag_loopback_ ||
-            !iface->flag_up_ ||
-            !iface->flag_running_) {
-            continue;
-        }
+int IfaceMgr::openIfaceSockets4(Iface& iface, uint16_t port, bool use_bcast,
+                                int& bcast_num) {
+    int sock;
+    int count = 0;
 
-        Iface::AddressCollection addrs = iface->getAddresses();
-        for (Iface::AddressCollection::iterator addr = addrs.begin();
-             addr != addrs.end();
-             ++addr) {
+// This option is used to bind sockets to particular interfaces.
+// This is currently the only way to discover on which interface
+// the broadcast packet has been received. If this option is
+// not supported then only one interface should be confugured
+// to listen for broadcast traffic.
+#ifdef SO_BINDTODEVICE
+    const bool bind_to_device = true;
+#else
+    const bool bind_to_device = false;
+#endif
 
-            // Skip all but V4 addresses.
-            if (!addr->isV4()) {
-                continue;
-            }
+    if (iface.flag_loopback_ ||
+        !iface.flag_up_ ||
+        !iface.flag_running_) {
+        return (0);
+    }
 
-            // If selected interface is broadcast capable set appropriate
-            // options on the socket so as it can receive and send broadcast
-            // messages.
-            if (iface->flag_broadcast_ && use_bcast) {
-                // If our OS supports binding socket to a device we can listen
-                // for broadcast messages on multiple interfaces. Otherwise we
-                // bind to INADDR_ANY address but we can do it only once. Thus,
-                // if one socket has been bound we can't do it any further.
-                if (!bind_to_device && bcast_num > 0) {
-                    isc_throw(SocketConfigError, "SO_BINDTODEVICE socket option is"
-                              << " not supported on this OS; therefore, DHCP"
-                              << " server can only listen broadcast traffic on"
-                              << " a single interface");
-
-                } else {
-                    // We haven't open any broadcast sockets yet, so we can
-                    // open at least one more.
-                    sock = openSocket(iface->getName(), *addr, port, true, true);
-                    // Binding socket to an interface is not supported so we can't
-                    // open any more broadcast sockets. Increase the number of
-                    // opened broadcast sockets.
-                    if (!bind_to_device) {
-                        ++bcast_num;
-                    }
-                }
+    Iface::AddressCollection addrs = iface.getAddresses();
+    for (Iface::AddressCollection::iterator addr = addrs.begin();
+         addr != addrs.end();
+         ++addr) {
 
-            } else {
-                // Not broadcast capable, do not set broadcast flags.
-                sock = openSocket(iface->getName(), *addr, port, false, false);
+        // Skip all but V4 addresses.
+        if (!addr->isV4()) {
+            continue;
+        }
 
-            }
-            if (sock < 0) {
-                isc_throw(SocketConfigError, "failed to open IPv4 socket"
-                          << " supporting broadcast traffic");
+        // If selected interface is broadcast capable set appropriate
+        // options on the socket so as it can receive and send broadcast
+        // messages.
+        if (iface.flag_broadcast_ && use_bcast) {
+            // If our OS supports binding socket to a device we can listen
+            // for broadcast messages on multiple interfaces. Otherwise we
+            // bind to INADDR_ANY address but we can do it only once. Thus,
+            // if one socket has been bound we can't do it any further.
+            if (!bind_to_device && bcast_num > 0) {
+                isc_throw(SocketConfigError, "SO_BINDTODEVICE socket option is"
+                          << " not supported on this OS; therefore, DHCP"
+                          << " server can only listen broadcast traffic on"
+                          << " a single interface");
+
+            } else {
+                // We haven't open any broadcast sockets yet, so we can
+                // open at least one more.
+                sock = openSocket4(iface, *addr, port, true, true);
+                // Binding socket to an interface is not supported so we can't
+                // open any more broadcast sockets. Increase the number of
+                // opened broadcast sockets.
+                if (!bind_to_device) {
+                    ++bcast_num;
+                }
             }
 
-            count++;
+        } else {
+            // Not broadcast capable, do not set broadcast flags.
+            sock = openSocket4(iface, *addr, port, false, false);
+
+        }
+        if (sock < 0) {
+            isc_throw(SocketConfigError, "failed to open IPv4 socket"
+                      << " supporting broadcast traffic");
         }
+
+        count++;
     }
-    return (count > 0);
+    return (count);
 }
 
 bool IfaceMgr::openSockets6(const uint16_t port) {
-    int sock;
     int count = 0;
     
     //4o6 init socket
@@ -313,70 +388,159 @@ bool IfaceMgr::openSockets6(const uint16_t port) {
         listen(fd_4to6, 5);
     }
 
+    port6_ = port;
+
     for (IfaceCollection::iterator iface = ifaces_.begin();
          iface != ifaces_.end();
          ++iface) {
+        count += openIfaceSockets6(*iface, port);
+    }
+    return (count > 0);
+}
 
-        if (iface->flag_loopback_ ||
-            !iface->flag_up_ ||
-            !iface->flag_running_) {
-            continue;
-        }
+int IfaceMgr::openIfaceSockets6(Iface& iface, uint16_t port) {
+    int sock;
+    int count = 0;
 
-        Iface::AddressCollection addrs = iface->getAddresses();
-        for (Iface::AddressCollection::iterator addr = addrs.begin();
-             addr != addrs.end();
-             ++addr) {
+    if (iface.flag_loopback_ ||
+        !iface.flag_up_ ||
+        !iface.flag_running_) {
+        return (0);
+    }
 
-            // Skip all but V6 addresses.
-            if (!addr->isV6()) {
-                continue;
-            }
+    Iface::AddressCollection addrs = iface.getAddresses();
+    for (Iface::AddressCollection::iterator addr = addrs.begin();
+         addr != addrs.end();
+         ++addr) {
 
-            // Bind link-local addresses only. Otherwise we bind several sockets
-            // on interfaces that have several global addresses. For examples
-            // with interface with 2 global addresses, we would bind 3 sockets
-            // (one for link-local and two for global). That would result in
-            // getting each message 3 times.
-            if (!addr->getAddress().to_v6().is_link_local()){
-                continue;
-            }
+        // Skip all but V6 addresses.
+        if (!addr->isV6()) {
+            continue;
+        }
 
-            sock = openSocket(iface->getName(), *addr, port);
-            if (sock < 0) {
-                isc_throw(SocketConfigError, "failed to open unicast socket");
-            }
+        // Bind link-local addresses only. Otherwise we bind several sockets
+        // on interfaces that have several global addresses. For examples
+        // with interface with 2 global addresses, we would bind 3 sockets
+        // (one for link-local and two for global). That would result in
+        // getting each message 3 times.
+        if (!addr->getAddress().to_v6().is_link_local()){
+            continue;
+        }
 
-            // Binding socket to unicast address and then joining multicast group
-            // works well on Mac OS (and possibly other BSDs), but does not work
-            // on Linux.
-            if ( !joinMulticast(sock, iface->getName(),
-                                string(ALL_DHCP_RELAY_AGENTS_AND_SERVERS))) {
-                close(sock);
-                isc_throw(SocketConfigError, "Failed to join "
-                          << ALL_DHCP_RELAY_AGENTS_AND_SERVERS
-                          << " multicast group.");
-            }
+        sock = openSocket6(iface, *addr, port);
+        if (sock < 0) {
+            isc_throw(SocketConfigError, "failed to open unicast socket");
+        }
+
+        // Binding socket to unicast address and then joining multicast group
+        // works well on Mac OS (and possibly other BSDs), but does not work
+        // on Linux.
+        if ( !joinMulticast(sock, iface.getName(),
+                            string(ALL_DHCP_RELAY_AGENTS_AND_SERVERS))) {
+            close(sock);
+            isc_throw(SocketConfigError, "Failed to join "
+                      << ALL_DHCP_RELAY_AGENTS_AND_SERVERS
+                      << " multicast group.");
+        }
 
-            count++;
+        count++;
 
-            /// @todo: Remove this ifdef once we start supporting BSD systems.
+        /// @todo: Remove this ifdef once we start supporting BSD systems.
 #if defined(OS_LINUX)
-            // To receive multicast traffic, Linux requires binding socket to
-            // a multicast group. That in turn doesn't work on NetBSD.
-
-            int sock2 = openSocket(iface->getName(),
-                                   IOAddress(ALL_DHCP_RELAY_AGENTS_AND_SERVERS),
-                                   port);
-            if (sock2 < 0) {
-                isc_throw(SocketConfigError, "Failed to open multicast socket on "
-                          << " interface " << iface->getFullName());
-                iface->delSocket(sock); // delete previously opened socket
-            }
+        // To receive multicast traffic, Linux requires binding socket to
+        // a multicast group. That in turn doesn't work on NetBSD.
+
+        int sock2 = openSocket6(iface,
+                                IOAddress(ALL_DHCP_RELAY_AGENTS_AND_SERVERS),
+                                port);
+        if (sock2 < 0) {
+            isc_throw(SocketConfigError, "Failed to open multicast socket on "
+                      << " interface " << iface.getFullName());
+            iface.delSocket(sock); // delete previously opened socket
+        }
 #endif
+    }
+    return (count);
+}
+
+void
+IfaceMgr::openIfaceSockets(Iface& iface) {
+    if (port4_ != 0) {
+        // The broadcast sockets of the other interfaces aren't counted:
+        // without SO_BINDTODEVICE the interfaces can't change anyway.
+        int bcast_num = 0;
+        openIfaceSockets4(iface, port4_, use_bcast4_, bcast_num);
+    }
+    if (port6_ != 0) {
+        openIfaceSockets6(iface, port6_);
+    }
+}
+
+void
+IfaceMgr::updateIfaces(const IfaceCollection& detected) {
+    // Drop the interfaces which are gone first, so as their names may be
+    // taken by the new ones.
+    IfaceCollection::iterator iface = ifaces_.begin();
+    while (iface != ifaces_.end()) {
+        IfaceCollection::const_iterator d = detected.begin();
+        while ((d != detected.end()) &&
+               (d->getIndex() != iface->getIndex())) {
+            ++d;
+        }
+        if (d != detected.end()) {
+            ++iface;
+            continue;
+        }
+        const std::string name = iface->getName();
+        iface->closeSockets();
+        iface = ifaces_.erase(iface);
+        if (iface_callback_) {
+            iface_callback_(name, IFACE_REMOVED, "");
+        }
+    }
+
+    for (IfaceCollection::const_iterator d = detected.begin();
+         d != detected.end(); ++d) {
+        IfaceChange change = IFACE_CHANGED;
+        iface = ifaces_.begin();
+        while ((iface != ifaces_.end()) &&
+               (iface->getIndex() != d->getIndex())) {
+            ++iface;
+        }
+        if (iface == ifaces_.end()) {
+            change = IFACE_ADDED;
+            ifaces_.push_back(*d);
+            iface = --ifaces_.end();
+        } else if (sameIface(*iface, *d)) {
+            continue;
+        } else {
+            iface->closeSockets();
+            *iface = *d;
+        }
+
+        std::string error;
+        try {
+            openIfaceSockets(*iface);
+        } catch (const std::exception& ex) {
+            // The interface is kept without sockets: the next change may
+            // make it usable.
+            iface->closeSockets();
+            error = ex.what();
+        }
+        if (iface_callback_) {
+            iface_callback_(iface->getName(), change, error);
         }
     }
-    return (count > 0);
+}
+
+void
+IfaceMgr::stopIfaceTracking() {
+    if (track_socket_ != INVALID_SOCKET) {
+        deleteExternalSocket(track_socket_);
+        close(track_socket_);
+        track_socket_ = INVALID_SOCKET;
+    }
+    iface_callback_ = IfaceChangeCallback();
 }
 
 void
@@ -645,6 +809,13 @@ int IfaceMgr::openSocket6(Iface& iface, const IOAddress& addr, uint16_t port) {
     }
 #endif
 
+#ifdef SO_TIMESTAMP
+    // Let the kernel tell when the queries arrive, so as the servers see
+    // how long they waited in the socket queue. Without it, receive6()
+    // uses the time the query is read.
+    setsockopt(sock, SOL_SOCKET, SO_TIMESTAMP, &flag, sizeof(flag));
+#endif
+
     // multicast stuff
     if (addr.getAddress().to_v6().is_multicast()) {
         // both mcast (ALL_DHCP_RELAY_AGENTS_AND_SERVERS and ALL_DHCP_SERVERS)
@@ -701,52 +872,23 @@ const std::string & mcast) {
     return (true);
 }
 
-bool
-IfaceMgr::send(const Pkt6Ptr& pkt) {
-    int result;
-
-    Iface* iface = getIface(pkt->getIface());
-    if (!iface) {
-        isc_throw(BadValue, "Unable to send Pkt6. Invalid interface ("
-                  << pkt->getIface() << ") specified.");
-    }
-
-    memset(&control_buf_[0], 0, control_buf_len_);
-
-
+void
+IfaceMgr::prepareSend6(size_t slot, const Pkt6& pkt) {
     // Set the target address we're sending to.
     sockaddr_in6 to;
     memset(&to, 0, sizeof(to));
     to.sin6_family = AF_INET6;
-    to.sin6_port = htons(pkt->getRemotePort());
+    to.sin6_port = htons(pkt.getRemotePort());
     memcpy(&to.sin6_addr,
-           &pkt->getRemoteAddr().toBytes()[0],
+           &pkt.getRemoteAddr().toBytes()[0],
            16);
-    to.sin6_scope_id = pkt->getIndex();
-
-    // Initialize our message header structure.
-    struct msghdr m;
-    memset(&m, 0, sizeof(m));
-    m.msg_name = &to;
-    m.msg_namelen = sizeof(to);
-
-    // Set the data buffer we're sending. (Using this wacky
-    // "scatter-gather" stuff... we only have a single chunk
-    // of data to send, so we declare a single vector entry.)
-
-    // As v structure is a C-style is used for both sending and
-    // receiving data, it is shared between sending and receiving
-    // (sendmsg and recvmsg). It is also defined in system headers,
-    // so we have no control over its definition. To set iov_base
-    // (defined as void*) we must use const cast from void *.
-    // Otherwise C++ compiler would complain that we are trying
-    // to assign const void* to void*.
-    struct iovec v;
-    memset(&v, 0, sizeof(v));
-    v.iov_base = const_cast<void *>(pkt->getBuffer().getData());
-    v.iov_len = pkt->getBuffer().getLength();
-    m.msg_iov = &v;
-    m.msg_iovlen = 1;
+    to.sin6_scope_id = pkt.getIndex();
+
+    // The data buffer is sent as a single chunk of the "scatter-gather"
+    // vector, the slot pointing to the buffer of the packet.
+    struct msghdr& m = batch6_.prepareSend(slot, &to, sizeof(to),
+                                           pkt.getBuffer().getData(),
+                                           pkt.getBuffer().getLength());
 
     // Setting the interface is a bit more involved.
     //
@@ -754,8 +896,6 @@ IfaceMgr::send(const Pkt6Ptr& pkt) {
     // define the IPv6 packet information. We could set the
     // source address if we wanted, but we can safely let the
     // kernel decide what that should be.
-    m.msg_control = &control_buf_[0];
-    m.msg_controllen = control_buf_len_;
     struct cmsghdr *cmsg = CMSG_FIRSTHDR(&m);
 
     // FIXME: Code below assumes that cmsg is not NULL, but
@@ -769,12 +909,23 @@ IfaceMgr::send(const Pkt6Ptr& pkt) {
     cmsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
     struct in6_pktinfo *pktinfo = convertPktInfo6(CMSG_DATA(cmsg));
     memset(pktinfo, 0, sizeof(struct in6_pktinfo));
-    pktinfo->ipi6_ifindex = pkt->getIndex();
+    pktinfo->ipi6_ifindex = pkt.getIndex();
     m.msg_controllen = cmsg->cmsg_len;
+}
+
+bool
+IfaceMgr::send(const Pkt6Ptr& pkt) {
+    Iface* iface = getIface(pkt->getIface());
+    if (!iface) {
+        isc_throw(BadValue, "Unable to send Pkt6. Invalid interface ("
+                  << pkt->getIface() << ") specified.");
+    }
+
+    prepareSend6(0, *pkt);
 
     pkt->updateTimestamp();
 
-    result = sendmsg(getSocket(*pkt), &m, 0);
+    int result = batch6_.send(getSocket(*pkt), 1);
     if (result < 0) {
         isc_throw(SocketWriteError, "Pkt6 send failed: sendmsg() returned " << result);
     }
@@ -782,6 +933,38 @@ IfaceMgr::send(const Pkt6Ptr& pkt) {
     return (result);
 }
 
+void
+IfaceMgr::sendBatch(const Pkt6Collection& pkts, size_t& sent) {
+    sent = 0;
+    while (sent < pkts.size()) {
+        const Pkt6Ptr& pkt = pkts[sent];
+        Iface* iface = getIface(pkt->getIface());
+        if (!iface) {
+            isc_throw(BadValue, "Unable to send Pkt6. Invalid interface ("
+                      << pkt->getIface() << ") specified.");
+        }
+        const int sockfd = getSocket(*pkt);
+
+        // The following packets sent over the same interface go with it.
+        size_t count = 0;
+        while ((count < batch6_.getSize()) && (sent + count < pkts.size()) &&
+               (pkts[sent + count]->getIface() == pkt->getIface())) {
+            prepareSend6(count, *pkts[sent + count]);
+            pkts[sent + count]->updateTimestamp();
+            ++count;
+        }
+
+        // If a packet can't be sent, the next round starts with it and
+        // throws.
+        const int result = batch6_.send(sockfd, count);
+        if (result <= 0) {
+            isc_throw(SocketWriteError, "Pkt6 send failed: sendmmsg() returned "
+                      << result);
+        }
+        sent += result;
+    }
+}
+
 bool
 IfaceMgr::send(const Pkt4Ptr& pkt) {
     //4o6
@@ -799,29 +982,208 @@ IfaceMgr::send(const Pkt4Ptr& pkt) {
     return (packet_filter_->send(getSocket(*pkt), pkt));
 }
 
+void
+IfaceMgr::sendBatch(const Pkt4Collection& pkts, size_t& sent) {
+    sent = 0;
+    while (sent < pkts.size()) {
+        const Pkt4Ptr& pkt = pkts[sent];
+        //4o6
+        if (pkt->is4o6) {
+            send4to6(pkt);
+            ++sent;
+            continue;
+        }
+
+        Iface* iface = getIface(pkt->getIface());
+        if (!iface) {
+            isc_throw(BadValue, "Unable to send Pkt4. Invalid interface ("
+                      << pkt->getIface() << ") specified.");
+        }
+        const uint16_t sockfd = getSocket(*pkt);
+
+        // The following packets sent over the same interface go with it.
+        size_t last = sent + 1;
+        while ((last < pkts.size()) && !pkts[last]->is4o6 &&
+               (pkts[last]->getIface() == pkt->getIface())) {
+            ++last;
+        }
+
+        // The packet filter sends at least one packet or throws.
+        while (sent < last) {
+            sent += packet_filter_->sendBatch(sockfd, pkts, sent, last);
+        }
+    }
+}
+
+void
+IfaceMgr::runTimers(struct timeval& select_timeout) {
+    timers_.runExpired(TIMERS_PER_RECEIVE);
+
+    const uint64_t requested = static_cast<uint64_t>(select_timeout.tv_sec) *
+        1000 + select_timeout.tv_usec / 1000;
+    const uint32_t max_timeout = (requested < 0xffffffff ?
+                                  static_cast<uint32_t>(requested) :
+                                  0xffffffff);
+    const uint32_t timeout = timers_.getTimeout(max_timeout);
+    if (timeout < max_timeout) {
+        select_timeout.tv_sec = timeout / 1000;
+        select_timeout.tv_usec = (timeout % 1000) * 1000;
+    }
+}
+
+void
+IfaceMgr::addExternalSocket(int socketfd, SocketCallback callback) {
+    if (socketfd < 0) {
+        isc_throw(BadValue, "invalid external socket descriptor " << socketfd);
+    }
+    if (!callback) {
+        isc_throw(BadValue, "no callback for external socket " << socketfd);
+    }
+    for (std::list<std::pair<int, SocketCallback> >::iterator s =
+             external_sockets_.begin(); s != external_sockets_.end(); ++s) {
+        if (s->first == socketfd) {
+            s->second = callback;
+            return;
+        }
+    }
+    external_sockets_.push_back(std::make_pair(socketfd, callback));
+}
+
+void
+IfaceMgr::deleteExternalSocket(int socketfd) {
+    for (std::list<std::pair<int, SocketCallback> >::iterator s =
+             external_sockets_.begin(); s != external_sockets_.end(); ++s) {
+        if (s->first == socketfd) {
+            external_sockets_.erase(s);
+            return;
+        }
+    }
+}
+
+void
+IfaceMgr::addExternalSockets(fd_set& sockets, int& maxfd) const {
+    for (std::list<std::pair<int, SocketCallback> >::const_iterator s =
+             external_sockets_.begin(); s != external_sockets_.end(); ++s) {
+        FD_SET(s->first, &sockets);
+        if (maxfd < s->first) {
+            maxfd = s->first;
+        }
+    }
+}
+
+bool
+IfaceMgr::callExternalSocket(const fd_set& sockets) {
+    for (std::list<std::pair<int, SocketCallback> >::const_iterator s =
+             external_sockets_.begin(); s != external_sockets_.end(); ++s) {
+        if (FD_ISSET(s->first, &sockets)) {
+            // The callback may add or remove sockets, so it is called on
+            // a copy and no other socket is checked.
+            SocketCallback callback = s->second;
+            callback();
+            return (true);
+        }
+    }
+    return (false);
+}
+
 //4o6: dhcp4_srv uses this function to send pkt to dhcp6_srv
 bool
 IfaceMgr::send4to6(const Pkt4Ptr& pkt) {
-    int fd;
-    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
-        //failed to create socket
-        return false;
+    const uint8_t* data =
+        static_cast<const uint8_t*>(pkt->getBuffer().getData());
+    const size_t length = pkt->getBuffer().getLength();
+    if (!channels_4o6_.empty() &&
+        (length <= channels_4o6_[0]->getOutbound().getMaxMessageLen())) {
+        ShmRing& ring = channels_4o6_[0]->getOutbound();
+        if (ring.push(data, length)) {
+            // The DHCPv6 server only needs a wake-up call when it waits.
+            if (ring.isWaiting()) {
+                const int fd = connect4o6(FILENAME2);
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+            return (true);
+        }
+        // The ring is full: the socket is used instead.
     }
-    struct sockaddr_un addr;
-    addr.sun_family = AF_UNIX;
-    strcpy(addr.sun_path, FILENAME2);
-    addr.sun_path[0] = 0;
-    int len = strlen(FILENAME2) + offsetof(struct sockaddr_un, sun_path);
-    int result = connect(fd, (struct sockaddr*)&addr, len);
-    if (result < 0) {
-        //failed to connect
-        return false;
+
+    const int fd = connect4o6(FILENAME2);
+    if (fd < 0) {
+        return (false);
     }
-    int count = write(fd, pkt->getBuffer().getData(), pkt->getBuffer().getLength());
+    int count = write(fd, data, length);
     close(fd);
     return count;
 }
 
+void
+IfaceMgr::add4o6Channel(const Shm4o6ChannelPtr& channel) {
+    if (std::find(channels_4o6_.begin(), channels_4o6_.end(), channel) ==
+        channels_4o6_.end()) {
+        channels_4o6_.push_back(channel);
+    }
+}
+
+void
+IfaceMgr::remove4o6Channel(const Shm4o6ChannelPtr& channel) {
+    channels_4o6_.erase(std::remove(channels_4o6_.begin(),
+                                    channels_4o6_.end(), channel),
+                        channels_4o6_.end());
+}
+
+bool
+IfaceMgr::wait4o6Channels(bool waiting) {
+    bool empty = true;
+    for (size_t i = 0; i < channels_4o6_.size(); ++i) {
+        if (!channels_4o6_[i]->getInbound().setWaiting(waiting)) {
+            empty = false;
+        }
+    }
+    return (empty);
+}
+
+Pkt4Ptr
+IfaceMgr::receive4o6Channel4() {
+    for (size_t i = 0; i < channels_4o6_.size(); ++i) {
+        ShmRing& ring = channels_4o6_[i]->getInbound();
+        size_t len = 0;
+        const uint8_t* data = ring.front(len);
+        if (!data) {
+            continue;
+        }
+        Pkt4Ptr pkt;
+        try {
+            pkt.reset(new Pkt4(data, len));
+        } catch (...) {
+            ring.pop();
+            throw;
+        }
+        ring.pop();
+        pkt->updateTimestamp();
+        pkt->is4o6 = true;
+        return (pkt);
+    }
+    return (Pkt4Ptr());
+}
+
+Pkt6Ptr
+IfaceMgr::receive4o6Channel6() {
+    for (size_t i = 0; i < channels_4o6_.size(); ++i) {
+        ShmRing& ring = channels_4o6_[i]->getInbound();
+        size_t len = 0;
+        const uint8_t* data = ring.front(len);
+        if (!data) {
+            continue;
+        }
+        Pkt6Ptr reply(new Pkt6(DHCPV4_RESPONSE, 0));
+        reply->data4o6_.assign(data, data + len);
+        ring.pop();
+        return (reply);
+    }
+    return (Pkt6Ptr());
+}
+
 boost::shared_ptr<Pkt4>
 IfaceMgr::receive4(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
     // Sanity check for microsecond timeout.
@@ -829,6 +1191,14 @@ IfaceMgr::receive4(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
         isc_throw(BadValue, "fractional timeout must be shorter than"
                   " one million microseconds");
     }
+
+    // The packets read with the last one returned come first.
+    if (next_received4_ < received4_.size()) {
+        Pkt4Ptr pkt = received4_[next_received4_];
+        received4_[next_received4_++].reset();
+        return (pkt);
+    }
+
     const SocketInfo* candidate = 0;
     IfaceCollection::const_iterator iface;
     fd_set sockets;
@@ -875,16 +1245,40 @@ IfaceMgr::receive4(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
             maxfd = fd_6to4;
         FD_SET(fd_6to4, &sockets);
     }
+
+    addExternalSockets(sockets, maxfd);
     
     struct timeval select_timeout;
     select_timeout.tv_sec = timeout_sec;
     select_timeout.tv_usec = timeout_usec;
+    runTimers(select_timeout);
+
+    // 4o6: the queries in the shared memory channels are taken without
+    // waiting, until the sockets are due to be checked.
+    if (!channels_4o6_.empty()) {
+        if (channel_burst_ < CHANNEL_BURST) {
+            Pkt4Ptr pkt = receive4o6Channel4();
+            if (pkt) {
+                ++channel_burst_;
+                return (pkt);
+            }
+        }
+        channel_burst_ = 0;
+        if (!wait4o6Channels(true)) {
+            select_timeout.tv_sec = 0;
+            select_timeout.tv_usec = 0;
+        }
+    }
 
     int result = select(maxfd + 1, &sockets, NULL, NULL, &select_timeout);
+    if (!channels_4o6_.empty()) {
+        wait4o6Channels(false);
+    }
 
     if (result == 0) {
-        // nothing received and timeout has been reached
-        return (Pkt4Ptr()); // NULL
+        // nothing received and timeout has been reached (or a timer is due)
+        timers_.runExpired(TIMERS_PER_RECEIVE);
+        return (receive4o6Channel4()); // NULL if none
     } else if (result < 0) {
         isc_throw(SocketReadError, strerror(errno));
     }
@@ -904,6 +1298,10 @@ IfaceMgr::receive4(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
         return (Pkt4Ptr()); // NULL
     }
 
+    if (callExternalSocket(sockets)) {
+        return (Pkt4Ptr()); // NULL
+    }
+
     // Let's find out which interface/socket has the data
     for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
         const Iface::SocketCollection& socket_collection = iface->getSockets();
@@ -921,7 +1319,9 @@ IfaceMgr::receive4(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
     
     //4o6
     if (!candidate && fd_6to4 > 0 && FD_ISSET(fd_6to4, &sockets)) {
-        return receive6to4();
+        // An empty connection is a wake-up call for the channels.
+        Pkt4Ptr pkt = receive6to4();
+        return (pkt ? pkt : receive4o6Channel4());
     }
 
     if (!candidate) {
@@ -931,7 +1331,41 @@ IfaceMgr::receive4(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
     // Now we have a socket, let's get some data from it!
     // Skip checking if packet filter is non-NULL because it has been
     // already checked when packet filter was set.
-    return (packet_filter_->receive(*iface, *candidate));
+    received4_.clear();
+    next_received4_ = 0;
+    if (packet_filter_->receiveBatch(*iface, *candidate, received4_,
+                                     BATCH_SIZE) == 0) {
+        return (Pkt4Ptr());
+    }
+    Pkt4Ptr pkt = received4_[0];
+    received4_[0].reset();
+    next_received4_ = 1;
+    return (pkt);
+}
+
+size_t
+IfaceMgr::receiveBatch4(Pkt4Collection& pkts, uint32_t timeout_sec,
+                        uint32_t timeout_usec /* = 0 */) {
+    Pkt4Ptr pkt = receive4(timeout_sec, timeout_usec);
+    if (!pkt) {
+        return (0);
+    }
+    const size_t count = received4_.size() - next_received4_ + 1;
+    pkts.push_back(pkt);
+    pkts.insert(pkts.end(), received4_.begin() + next_received4_,
+                received4_.end());
+    received4_.clear();
+    next_received4_ = 0;
+    return (count);
+}
+
+void
+IfaceMgr::set4o6SocketName(const std::string& name) {
+    struct sockaddr_un addr;
+    if (name.empty() || (name.size() >= sizeof(addr.sun_path))) {
+        isc_throw(BadValue, "invalid 4o6 socket name '" << name << "'");
+    }
+    socket_name_6to4_ = name;
 }
 
 //4o6
@@ -941,6 +1375,11 @@ IfaceMgr::receive6to4() {
     int recv_fd = accept(fd_6to4, NULL, NULL);
     int len = read(recv_fd, buf, IfaceMgr::RCVBUFSIZE);
     close(recv_fd);
+    // The DHCPv6 server probing the socket connects without sending
+    // anything.
+    if (len <= 0) {
+        return (Pkt4Ptr());
+    }
     
     Pkt4Ptr pkt = Pkt4Ptr(new Pkt4(buf, len));
     pkt->updateTimestamp();
@@ -952,16 +1391,21 @@ IfaceMgr::receive6to4() {
 //4o6
 Pkt6Ptr
 IfaceMgr::receive4to6() {
-    uint8_t buf[IfaceMgr::RCVBUFSIZE];
+    Pkt6Ptr reply(new Pkt6(DHCPV4_RESPONSE, 0));
+
+    // Read the DHCPv4 message straight into the response packet. It is
+    // written into the DHCPV4-RESPONSE output buffer from there, when the
+    // response is packed.
+    reply->data4o6_.resize(IfaceMgr::RCVBUFSIZE);
     int recv_fd = accept(fd_4to6, NULL, NULL);
-    int len = read(recv_fd, buf, IfaceMgr::RCVBUFSIZE);
+    int len = read(recv_fd, &reply->data4o6_[0], IfaceMgr::RCVBUFSIZE);
     close(recv_fd);
-    
-    Pkt6Ptr reply(new Pkt6(DHCPV4_RESPONSE, 0));
-    
+    if (len <= 0) {
+        return (Pkt6Ptr());
+    }
+
     reply->data4o6_.resize(len);
-    memcpy(reply->data4o6_.data(), buf, len);
-        
+
     return reply;
 }
 
@@ -972,6 +1416,13 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
                   " one million microseconds");
     }
 
+    // The packets read with the last one returned come first.
+    if (next_received6_ < received6_.size()) {
+        Pkt6Ptr pkt = received6_[next_received6_];
+        received6_[next_received6_++].reset();
+        return (pkt);
+    }
+
     const SocketInfo* candidate = 0;
     fd_set sockets;
     int maxfd = 0;
@@ -1018,15 +1469,39 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
         FD_SET(fd_4to6, &sockets);
     }
 
+    addExternalSockets(sockets, maxfd);
+
     struct timeval select_timeout;
     select_timeout.tv_sec = timeout_sec;
     select_timeout.tv_usec = timeout_usec;
+    runTimers(select_timeout);
+
+    // 4o6: the responses in the shared memory channels are taken like
+    // in receive4().
+    if (!channels_4o6_.empty()) {
+        if (channel_burst_ < CHANNEL_BURST) {
+            Pkt6Ptr pkt = receive4o6Channel6();
+            if (pkt) {
+                ++channel_burst_;
+                return (pkt);
+            }
+        }
+        channel_burst_ = 0;
+        if (!wait4o6Channels(true)) {
+            select_timeout.tv_sec = 0;
+            select_timeout.tv_usec = 0;
+        }
+    }
 
     int result = select(maxfd + 1, &sockets, NULL, NULL, &select_timeout);
+    if (!channels_4o6_.empty()) {
+        wait4o6Channels(false);
+    }
 
     if (result == 0) {
-        // nothing received and timeout has been reached
-        return (Pkt6Ptr()); // NULL
+        // nothing received and timeout has been reached (or a timer is due)
+        timers_.runExpired(TIMERS_PER_RECEIVE);
+        return (receive4o6Channel6()); // NULL if none
     } else if (result < 0) {
         isc_throw(SocketReadError, strerror(errno));
     }
@@ -1046,6 +1521,10 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
         return (Pkt6Ptr()); // NULL
     }
 
+    if (callExternalSocket(sockets)) {
+        return (Pkt6Ptr()); // NULL
+    }
+
     // Let's find out which interface/socket has the data
     for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
         const Iface::SocketCollection& socket_collection = iface->getSockets();
@@ -1063,7 +1542,9 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
     
     //4o6
     if (!candidate && fd_4to6 > 0 && FD_ISSET(fd_4to6, &sockets)) {
-        return receive4to6();
+        // An empty connection is a wake-up call for the channels.
+        Pkt6Ptr pkt = receive4to6();
+        return (pkt ? pkt : receive4o6Channel6());
     }
 
     if (!candidate) {
@@ -1071,83 +1552,108 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
     }
 
     // Now we have a socket, let's get some data from it!
-    uint8_t buf[RCVBUFSIZE];
-    memset(&control_buf_[0], 0, control_buf_len_);
-    struct sockaddr_in6 from;
-    memset(&from, 0, sizeof(from));
-
-    // Initialize our message header structure.
-    struct msghdr m;
-    memset(&m, 0, sizeof(m));
-
-    // Point so we can get the from address.
-    m.msg_name = &from;
-    m.msg_namelen = sizeof(from);
-
-    // Set the data buffer we're receiving. (Using this wacky
-    // "scatter-gather" stuff... but we that doesn't really make
-    // sense for us, so we use a single vector entry.)
-    struct iovec v;
-    memset(&v, 0, sizeof(v));
-    v.iov_base = static_cast<void*>(buf);
-    v.iov_len = RCVBUFSIZE;
-    m.msg_iov = &v;
-    m.msg_iovlen = 1;
-
-    // Getting the interface is a bit more involved.
-    //
-    // We set up some space for a "control message". We have
-    // previously asked the kernel to give us packet
-    // information (when we initialized the interface), so we
-    // should get the destination address from that.
-    m.msg_control = &control_buf_[0];
-    m.msg_controllen = control_buf_len_;
+    result = batch6_.receive(candidate->sockfd_, BATCH_SIZE);
+    if (result < 0) {
+        isc_throw(SocketReadError, "failed to receive data");
+    }
+
+    // A bad datagram must not cost the others of the batch: it is only
+    // reported when there is no valid packet.
+    received6_.clear();
+    next_received6_ = 0;
+    std::string error;
+    for (int slot = 0; slot < result; ++slot) {
+        try {
+            received6_.push_back(createPacket6(slot));
+        } catch (const SocketReadError& ex) {
+            if (error.empty()) {
+                error = ex.what();
+            }
+        }
+    }
+    if (received6_.empty()) {
+        isc_throw(SocketReadError, error);
+    }
 
-    result = recvmsg(candidate->sockfd_, &m, 0);
+    Pkt6Ptr pkt = received6_[0];
+    received6_[0].reset();
+    next_received6_ = 1;
+    return (pkt);
+}
+
+size_t
+IfaceMgr::receiveBatch6(Pkt6Collection& pkts, uint32_t timeout_sec,
+                        uint32_t timeout_usec /* = 0 */) {
+    Pkt6Ptr pkt = receive6(timeout_sec, timeout_usec);
+    if (!pkt) {
+        return (0);
+    }
+    const size_t count = received6_.size() - next_received6_ + 1;
+    pkts.push_back(pkt);
+    pkts.insert(pkts.end(), received6_.begin() + next_received6_,
+                received6_.end());
+    received6_.clear();
+    next_received6_ = 0;
+    return (count);
+}
+
+Pkt6Ptr
+IfaceMgr::createPacket6(size_t slot) {
+    struct msghdr& m = batch6_.getHeader(slot);
+    const struct sockaddr_in6& from =
+        reinterpret_cast<const struct sockaddr_in6&>(batch6_.getName(slot));
 
     struct in6_addr to_addr;
     memset(&to_addr, 0, sizeof(to_addr));
 
     int ifindex = -1;
-    if (result >= 0) {
-        struct in6_pktinfo* pktinfo = NULL;
-
-
-        // If we did read successfully, then we need to loop
-        // through the control messages we received and
-        // find the one with our destination address.
-        //
-        // We also keep a flag to see if we found it. If we
-        // didn't, then we consider this to be an error.
-        bool found_pktinfo = false;
-        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&m);
-        while (cmsg != NULL) {
-            if ((cmsg->cmsg_level == IPPROTO_IPV6) &&
-                (cmsg->cmsg_type == IPV6_PKTINFO)) {
-                pktinfo = convertPktInfo6(CMSG_DATA(cmsg));
-                to_addr = pktinfo->ipi6_addr;
-                ifindex = pktinfo->ipi6_ifindex;
-                found_pktinfo = true;
-                break;
-            }
-            cmsg = CMSG_NXTHDR(&m, cmsg);
+    bool found_timestamp = false;
+    struct timeval timestamp;
+    memset(&timestamp, 0, sizeof(timestamp));
+    struct in6_pktinfo* pktinfo = NULL;
+
+    // We need to loop through the control messages we received and
+    // find the one with our destination address.
+    //
+    // We also keep a flag to see if we found it. If we
+    // didn't, then we consider this to be an error.
+    bool found_pktinfo = false;
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&m);
+    while (cmsg != NULL) {
+        if ((cmsg->cmsg_level == IPPROTO_IPV6) &&
+            (cmsg->cmsg_type == IPV6_PKTINFO)) {
+            pktinfo = convertPktInfo6(CMSG_DATA(cmsg));
+            to_addr = pktinfo->ipi6_addr;
+            ifindex = pktinfo->ipi6_ifindex;
+            found_pktinfo = true;
         }
-        if (!found_pktinfo) {
-            isc_throw(SocketReadError, "unable to find pktinfo");
+#ifdef SO_TIMESTAMP
+        if ((cmsg->cmsg_level == SOL_SOCKET) &&
+            (cmsg->cmsg_type == SCM_TIMESTAMP)) {
+            memcpy(&timestamp, CMSG_DATA(cmsg), sizeof(timestamp));
+            found_timestamp = true;
         }
-    } else {
-        isc_throw(SocketReadError, "failed to receive data");
+#endif
+        cmsg = CMSG_NXTHDR(&m, cmsg);
+    }
+    if (!found_pktinfo) {
+        isc_throw(SocketReadError, "unable to find pktinfo");
     }
 
     // Let's create a packet.
     Pkt6Ptr pkt;
     try {
-        pkt = Pkt6Ptr(new Pkt6(buf, result));
+        pkt = Pkt6Ptr(new Pkt6(batch6_.getData(slot), batch6_.getLength(slot)));
     } catch (const std::exception& ex) {
         isc_throw(SocketReadError, "failed to create new packet");
     }
 
-    pkt->updateTimestamp();
+    if (found_timestamp) {
+        pkt->setTimestamp(boost::posix_time::from_time_t(timestamp.tv_sec) +
+                          boost::posix_time::microseconds(timestamp.tv_usec));
+    } else {
+        pkt->updateTimestamp();
+    }
 
     pkt->setLocalAddr(IOAddress::fromBytes(AF_INET6,
                       reinterpret_cast<const uint8_t*>(&to_addr)));
@@ -20,14 +20,20 @@
 #include <dhcp/dhcp6.h>
 #include <dhcp/pkt4.h>
 #include <dhcp/pkt6.h>
+#include <dhcp/pkt_batch.h>
 #include <dhcp/pkt_filter.h>
+#include <dhcp/shm_ring.h>
+#include <dhcp/timer_mgr.h>
 
+#include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_array.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include <list>
 
+#include <sys/select.h>
+
 namespace isc {
 
 namespace dhcp {
@@ -294,6 +300,24 @@ public:
     /// defines callback used when commands are received over control session
     typedef void (*SessionCallback) (void);
 
+    /// defines callback used when data arrives over an external socket
+    typedef boost::function<void ()> SocketCallback;
+
+    /// @brief Changes of the interfaces found by the interface tracking.
+    enum IfaceChange {
+        IFACE_ADDED,    ///< new interface
+        IFACE_CHANGED,  ///< flags, link-layer address or addresses changed
+        IFACE_REMOVED   ///< interface is gone
+    };
+
+    /// @brief Callback reporting a change of an interface.
+    ///
+    /// The arguments are the name of the interface, the change and the
+    /// error which prevented opening its sockets (empty if none). The name
+    /// is empty if the interfaces couldn't be retrieved after a change.
+    typedef boost::function<void (const std::string&, IfaceChange,
+                                  const std::string&)> IfaceChangeCallback;
+
     /// @brief Packet reception buffer size
     ///
     /// RFC3315 states that server responses may be
@@ -412,15 +436,43 @@ public:
     /// @return true if sending was successful
     bool send(const Pkt4Ptr& pkt);
 
+    /// @brief Sends IPv6 packets.
+    ///
+    /// The packets are sent in order, like with send(const Pkt6Ptr&).
+    /// The consecutive packets sent over the same interface are sent
+    /// together, up to @ref BATCH_SIZE of them with a single system call.
+    ///
+    /// @param pkts packets to be sent
+    /// @param [out] sent number of packets sent. If an exception is
+    /// thrown, the packet which couldn't be sent is pkts[sent].
+    ///
+    /// @throw isc::BadValue if invalid interface specified in a packet.
+    /// @throw isc::dhcp::SocketWriteError if a packet can't be sent.
+    void sendBatch(const Pkt6Collection& pkts, size_t& sent);
+
+    /// @brief Sends IPv4 packets.
+    ///
+    /// The packets are sent in order, like with send(const Pkt4Ptr&).
+    /// The consecutive packets sent over the same interface are passed
+    /// together to the packet filter (see @ref PktFilter::sendBatch).
+    ///
+    /// @param pkts packets to be sent
+    /// @param [out] sent number of packets sent. If an exception is
+    /// thrown, the packet which couldn't be sent is pkts[sent].
+    ///
+    /// @throw isc::BadValue if invalid interface specified in a packet.
+    /// @throw isc::dhcp::SocketWriteError if a packet can't be sent.
+    void sendBatch(const Pkt4Collection& pkts, size_t& sent);
+
     /// @brief Tries to receive IPv6 packet over open IPv6 sockets.
     ///
     /// Attempts to receive a single IPv6 packet of any of the open IPv6 sockets.
     /// If reception is successful and all information about its sender
     /// are obtained, Pkt6 object is created and returned.
     ///
-    /// TODO Start using select() and add timeout to be able
-    /// to not wait infinitely, but rather do something useful
-    /// (e.g. remove expired leases)
+    /// The expired timers (see @ref getTimerMgr) are run first, and the
+    /// wait ends when the next timer expires, even if the timeout hasn't
+    /// elapsed.
     ///
     /// @param timeout_sec specifies integral part of the timeout (in seconds)
     /// @param timeout_usec specifies fractional part of the timeout
@@ -437,6 +489,8 @@ public:
     /// If reception is successful and all information about its sender
     /// are obtained, Pkt4 object is created and returned.
     ///
+    /// The timers are run like in @ref receive6.
+    ///
     /// @param timeout_sec specifies integral part of the timeout (in seconds)
     /// @param timeout_usec specifies fractional part of the timeout
     /// (in microseconds)
@@ -445,6 +499,42 @@ public:
     /// @throw isc::dhcp::SocketReadError if error occured when receiving a packet.
     /// @return Pkt4 object representing received packet (or NULL)
     Pkt4Ptr receive4(uint32_t timeout_sec, uint32_t timeout_usec = 0);
+
+    /// @brief Receives the IPv6 packets waiting on a socket.
+    ///
+    /// The packets queued on the socket which becomes readable are read
+    /// together, up to @ref BATCH_SIZE of them with a single system call.
+    /// @ref receive6 reads them the same way, but returns them one by
+    /// one, the next calls returning the packets already read without
+    /// waiting.
+    ///
+    /// @param [out] pkts collection the received packets are appended to
+    /// @param timeout_sec specifies integral part of the timeout (in seconds)
+    /// @param timeout_usec specifies fractional part of the timeout
+    /// (in microseconds)
+    ///
+    /// @throw isc::BadValue if timeout_usec is greater than one million
+    /// @throw isc::dhcp::SocketReadError if error occured when receiving
+    /// the packets.
+    /// @return number of packets appended, 0 if none was received in time
+    size_t receiveBatch6(Pkt6Collection& pkts, uint32_t timeout_sec,
+                         uint32_t timeout_usec = 0);
+
+    /// @brief Receives the IPv4 packets waiting on a socket.
+    ///
+    /// Works like @ref receiveBatch6, with @ref receive4.
+    ///
+    /// @param [out] pkts collection the received packets are appended to
+    /// @param timeout_sec specifies integral part of the timeout (in seconds)
+    /// @param timeout_usec specifies fractional part of the timeout
+    /// (in microseconds)
+    ///
+    /// @throw isc::BadValue if timeout_usec is greater than one million
+    /// @throw isc::dhcp::SocketReadError if error occured when receiving
+    /// the packets.
+    /// @return number of packets appended, 0 if none was received in time
+    size_t receiveBatch4(Pkt4Collection& pkts, uint32_t timeout_sec,
+                         uint32_t timeout_usec = 0);
     
     ///4o6 socket fd: used by dhcp4_srv to receive messages from dhcp6_srv by AF_UNIX socket
     int fd_6to4;
@@ -461,6 +551,48 @@ public:
 #define FILENAME1 "DHCPv4oDHCPv6_1"
 #define FILENAME2 "DHCPv4oDHCPv6_2"
 
+    /// @brief Sets the name of the socket the DHCPv4-queries are received on.
+    ///
+    /// 4o6: the socket is an abstract UNIX socket (FILENAME1 by default),
+    /// bound by @ref openSockets4. Several DHCPv4 servers behind the same
+    /// DHCPv6 server listen on different sockets.
+    ///
+    /// @param name name of the socket
+    /// @throw isc::BadValue if the name is empty or too long
+    void set4o6SocketName(const std::string& name);
+
+    /// @brief Returns the name of the socket the DHCPv4-queries are
+    /// received on.
+    const std::string& get4o6SocketName() const {
+        return (socket_name_6to4_);
+    }
+
+    /// @brief Passes 4o6 messages through a shared memory channel.
+    ///
+    /// The messages of the inbound ring of the channel are returned by
+    /// @ref receive4 (DHCPv4 server) or @ref receive6 (DHCPv6 server)
+    /// without system calls; at most @ref CHANNEL_BURST of them in a row,
+    /// so the sockets are not starved. The UNIX sockets are only used to
+    /// wake up the receiver blocked in select(). The DHCPv4 server sends
+    /// the responses through the outbound ring of the first channel.
+    ///
+    /// @param channel channel to be added
+    void add4o6Channel(const Shm4o6ChannelPtr& channel);
+
+    /// @brief Stops using a shared memory channel.
+    ///
+    /// @param channel channel to be removed
+    void remove4o6Channel(const Shm4o6ChannelPtr& channel);
+
+    /// @brief Returns the shared memory channels.
+    const std::vector<Shm4o6ChannelPtr>& get4o6Channels() const {
+        return (channels_4o6_);
+    }
+
+    /// @brief Maximum number of messages taken from the shared memory
+    /// channels before the sockets are checked.
+    static const size_t CHANNEL_BURST = 32;
+
     /// Opens UDP/IP socket and binds it to address, interface and port.
     ///
     /// Specific type of socket (UDP/IPv4 or UDP/IPv6) depends on passed addr
@@ -558,8 +690,37 @@ public:
 
     /// @brief Closes all open sockets.
     /// Is used in destructor, but also from Dhcpv4_srv and Dhcpv6_srv classes.
+    ///
+    /// The sockets are not opened on the interfaces found by the interface
+    /// tracking anymore, until @ref openSockets4 or @ref openSockets6 is
+    /// called again.
     void closeSockets();
 
+    /// @brief Starts following the changes of the interfaces.
+    ///
+    /// The interface manager subscribes to the notifications of the
+    /// changes of the links and of their addresses, and handles them in
+    /// @ref receive4 and @ref receive6, like the external sockets. The
+    /// sockets of a new or changed interface are opened like
+    /// @ref openSockets4 or @ref openSockets6 did for the other interfaces;
+    /// the sockets of a removed interface are closed. The other interfaces
+    /// keep their sockets.
+    ///
+    /// @param callback called for each interface which changed, may be
+    /// empty.
+    /// @return false if the changes can't be followed on this OS.
+    /// @throw SocketConfigError if the notifications can't be subscribed to.
+    bool startIfaceTracking(const IfaceChangeCallback& callback =
+                            IfaceChangeCallback());
+
+    /// @brief Stops following the changes of the interfaces.
+    void stopIfaceTracking();
+
+    /// @brief Checks if the changes of the interfaces are followed.
+    bool isTrackingIfaces() const {
+        return (track_socket_ != INVALID_SOCKET);
+    }
+
     /// @brief returns number of detected interfaces
     ///
     /// @return number of detected interfaces
@@ -577,6 +738,48 @@ public:
         session_callback_ = callback;
     }
 
+    /// @brief Adds a socket watched while waiting for packets.
+    ///
+    /// The callback is called by @ref receive4 or @ref receive6 when the
+    /// socket is readable; the receive call then returns NULL. This lets
+    /// the servers serve other connections (e.g. with a peer server)
+    /// from the packet loop. The callback of a socket already added is
+    /// replaced.
+    ///
+    /// @param socketfd socket descriptor
+    /// @param callback callback function
+    /// @throw BadValue if the socket descriptor is invalid or the callback
+    /// is empty
+    void addExternalSocket(int socketfd, SocketCallback callback);
+
+    /// @brief Removes a socket added with @ref addExternalSocket.
+    ///
+    /// The socket is not closed. It is not an error to remove a socket
+    /// which wasn't added.
+    ///
+    /// @param socketfd socket descriptor
+    void deleteExternalSocket(int socketfd);
+
+    /// @brief Returns the timers run while waiting for packets.
+    ///
+    /// The servers schedule their periodic tasks here.
+    TimerMgr& getTimerMgr() {
+        return (timers_);
+    }
+
+    /// @brief Maximum number of timers run by a single receive call.
+    ///
+    /// This bounds the time the processing of a packet is delayed by the
+    /// timers; the remaining expired timers are run by the next call.
+    static const size_t TIMERS_PER_RECEIVE = 8;
+
+    /// @brief Maximum number of packets read or written by a single
+    /// system call.
+    ///
+    /// The packets read together are returned by the next receive calls
+    /// before the timers and the other sockets are checked again.
+    static const size_t BATCH_SIZE = 32;
+
     /// @brief Set Packet Filter object to handle send/receive packets.
     ///
     /// Packet Filters expose low-level functions handling sockets opening
@@ -663,6 +866,25 @@ protected:
     void
     stubDetectIfaces();
 
+    /// @brief Replaces the interfaces with newly detected ones.
+    ///
+    /// The unchanged interfaces keep their sockets; the sockets of the
+    /// changed and new interfaces are opened, as far as the sockets were
+    /// opened on the other interfaces, and the removed interfaces are
+    /// dropped with their sockets. The interfaces are matched by index.
+    ///
+    /// @param detected interfaces, without sockets.
+    void updateIfaces(const IfaceCollection& detected);
+
+    /// @brief Opens the sockets of an interface.
+    ///
+    /// The sockets are opened for the port of the last call to
+    /// @ref openSockets4 and @ref openSockets6, if any.
+    ///
+    /// @param iface interface.
+    /// @throw SocketConfigError if a socket can't be opened.
+    void openIfaceSockets(Iface& iface);
+
     // TODO: having 2 maps (ifindex->iface and ifname->iface would)
     //      probably be better for performance reasons
 
@@ -685,6 +907,9 @@ protected:
     /// control-buffer, used in transmission and reception
     boost::scoped_array<char> control_buf_;
 
+    /// slots the IPv6 packets are received in and sent from
+    PktBatch batch6_;
+
     /// @brief A wrapper for OS-specific operations before sending IPv4 packet
     ///
     /// @param m message header (will be later used for sendmsg() call)
@@ -707,8 +932,120 @@ protected:
 
     /// a callback that will be called when data arrives over session_socket_
     SessionCallback session_callback_;
+
+    /// timers run while waiting for packets
+    TimerMgr timers_;
+
+    /// sockets added with addExternalSocket() and their callbacks
+    std::list<std::pair<int, SocketCallback> > external_sockets_;
+
+    /// 4o6: name of the socket the DHCPv4-queries are received on
+    std::string socket_name_6to4_;
+
+    /// 4o6: shared memory channels
+    std::vector<Shm4o6ChannelPtr> channels_4o6_;
+
+    /// 4o6: number of messages taken from the channels in a row
+    size_t channel_burst_;
+
+    /// port of the IPv4 sockets, 0 if they aren't open
+    uint16_t port4_;
+
+    /// are the IPv4 sockets open for broadcast traffic
+    bool use_bcast4_;
+
+    /// port of the IPv6 sockets, 0 if they aren't open
+    uint16_t port6_;
+
+    /// netlink socket receiving the interface changes, or INVALID_SOCKET
+    int track_socket_;
+
+    /// callback reporting the interface changes
+    IfaceChangeCallback iface_callback_;
+
+    /// IPv4 packets read with the last one returned by receive4()
+    Pkt4Collection received4_;
+
+    /// index of the next packet of received4_ to be returned
+    size_t next_received4_;
+
+    /// IPv6 packets read with the last one returned by receive6()
+    Pkt6Collection received6_;
+
+    /// index of the next packet of received6_ to be returned
+    size_t next_received6_;
+
+    /// @brief Takes a DHCPv4-query from the shared memory channels.
+    ///
+    /// @return the query, or NULL if there is none
+    Pkt4Ptr receive4o6Channel4();
+
+    /// @brief Takes a DHCPv4 response from the shared memory channels.
+    ///
+    /// @return the response, or NULL if there is none
+    Pkt6Ptr receive4o6Channel6();
+
+    /// @brief Announces that this process blocks in select(), or not.
+    ///
+    /// @param waiting true before select()
+    /// @return true if the channels are empty, i.e. select() may block
+    bool wait4o6Channels(bool waiting);
 private:
 
+    /// @brief Opens the IPv4 sockets of an interface.
+    ///
+    /// @param iface interface.
+    /// @param port port of the sockets.
+    /// @param use_bcast configure sockets to support broadcast messages.
+    /// @param [in,out] bcast_num number of broadcast sockets opened.
+    /// @return number of sockets opened.
+    int openIfaceSockets4(Iface& iface, uint16_t port, bool use_bcast,
+                          int& bcast_num);
+
+    /// @brief Opens the IPv6 sockets of an interface.
+    ///
+    /// @param iface interface.
+    /// @param port port of the sockets.
+    /// @return number of link-local addresses sockets are opened for.
+    int openIfaceSockets6(Iface& iface, uint16_t port);
+
+    /// @brief Creates a packet from a datagram received in batch6_.
+    ///
+    /// @param slot slot of the batch holding the datagram.
+    /// @throw SocketReadError if the datagram isn't a valid packet or its
+    /// interface is unknown.
+    /// @return received packet.
+    Pkt6Ptr createPacket6(size_t slot);
+
+    /// @brief Prepares a slot of batch6_ to send a packet.
+    ///
+    /// @param slot slot of the batch.
+    /// @param pkt packet to be sent.
+    void prepareSend6(size_t slot, const Pkt6& pkt);
+
+    /// @brief Reads the interface change notifications.
+    ///
+    /// Called when the tracking socket is readable.
+    void handleIfaceChanges();
+
+    /// @brief Runs the expired timers and shortens the receive timeout
+    /// to the time of the next timer.
+    ///
+    /// @param select_timeout requested timeout, adjusted on return.
+    void runTimers(struct timeval& select_timeout);
+
+    /// @brief Adds the external sockets to a set of sockets for select().
+    ///
+    /// @param sockets set of sockets
+    /// @param maxfd highest socket descriptor of the set, updated
+    void addExternalSockets(fd_set& sockets, int& maxfd) const;
+
+    /// @brief Calls the callback of a readable external socket.
+    ///
+    /// @param sockets set of sockets returned by select()
+    /// @return true if a callback was called
+    bool callExternalSocket(const fd_set& sockets);
+
     /// @brief Joins IPv6 multicast group on a socket.
     ///
     /// Socket must be created and bound to an address. Note that this
@@ -34,6 +34,16 @@ IfaceMgr::detectIfaces() {
     stubDetectIfaces();
 }
 
+bool
+IfaceMgr::startIfaceTracking(const IfaceChangeCallback&) {
+    /// @todo follow the routing socket messages on BSDs.
+    return (false);
+}
+
+void
+IfaceMgr::handleIfaceChanges() {
+}
+
 bool
 IfaceMgr::isDirectResponseSupported() {
     return (false);
@@ -18,7 +18,7 @@
 ///
 /// For detailed information about netlink interface, please refer to
 /// http://en.wikipedia.org/wiki/Netlink and RFC3549.  Comments in the
-/// detectIfaces() method (towards the end of this file) provide an overview
+/// dumpIfaces() function (towards the end of this file) provide an overview
 /// on how the netlink interface is used here.
 ///
 /// Note that this interface is very robust and allows many operations:
@@ -37,9 +37,13 @@
 #include <util/io/sockaddr_util.h>
 
 #include <boost/array.hpp>
+#include <boost/bind.hpp>
 #include <boost/static_assert.hpp>
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdint.h>
+#include <string.h>
 #include <net/if.h>
 #include <linux/rtnetlink.h>
 
@@ -55,8 +59,7 @@ namespace {
 
 /// @brief This class offers utility methods for netlink connection.
 ///
-/// See IfaceMgr::detectIfaces() (Linux implementation, towards the end of this
-/// file) for example usage.
+/// See dumpIfaces() (towards the end of this file) for example usage.
 class Netlink
 {
 public:
@@ -329,7 +332,8 @@ void Netlink::rtnl_process_reply(NetlinkMessages& info) {
     msg.msg_iov = &iov;
     msg.msg_iovlen = 1;
 
-    char buf[RCVBUF_SIZE];
+    // Aligned for the netlink message headers.
+    uint32_t buf[RCVBUF_SIZE / sizeof(uint32_t)];
 
     iov.iov_base = buf;
     iov.iov_len = sizeof(buf);
@@ -406,16 +410,10 @@ void Netlink::release_list(NetlinkMessages& messages) {
     messages.clear();
 }
 
-} // end of anonymous namespace
-
-namespace isc {
-namespace dhcp {
-
-/// @brief Detect available interfaces on Linux systems.
+/// @brief Retrieves the interfaces and their addresses from the kernel.
 ///
-/// Uses the socket-based netlink protocol to retrieve the list of interfaces
-/// from the Linux kernel.
-void IfaceMgr::detectIfaces() {
+/// @param ifaces [out] detected interfaces are appended here.
+void dumpIfaces(IfaceMgr::IfaceCollection& ifaces) {
     // Copies of netlink messages about links will be stored here.
     Netlink::NetlinkMessages link_info;
 
@@ -487,13 +485,116 @@ void IfaceMgr::detectIfaces() {
         }
 
         nl.ipaddrs_get(iface, addr_info);
-        ifaces_.push_back(iface);
+        ifaces.push_back(iface);
     }
 
     nl.release_list(link_info);
     nl.release_list(addr_info);
 }
 
+} // end of anonymous namespace
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Detect available interfaces on Linux systems.
+///
+/// Uses the socket-based netlink protocol to retrieve the list of interfaces
+/// from the Linux kernel.
+void IfaceMgr::detectIfaces() {
+    dumpIfaces(ifaces_);
+}
+
+/// @brief Subscribes to the netlink notifications about links and addresses.
+///
+/// The notifications are only used to learn that something changed: the
+/// interfaces are then retrieved again and compared with the known ones
+/// (see @ref IfaceMgr::updateIfaces), which also covers the notifications
+/// lost when the socket buffer overflows.
+bool IfaceMgr::startIfaceTracking(const IfaceChangeCallback& callback) {
+    stopIfaceTracking();
+
+    const int fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+    if (fd < 0) {
+        isc_throw(SocketConfigError, "failed to create netlink socket: "
+                  << strerror(errno));
+    }
+
+    struct sockaddr_nl local;
+    memset(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+    local.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if ((bind(fd, convertSockAddr(&local), sizeof(local)) < 0) ||
+        (fcntl(fd, F_SETFL, O_NONBLOCK) < 0) ||
+        (fcntl(fd, F_SETFD, FD_CLOEXEC) < 0)) {
+        const int error = errno;
+        close(fd);
+        isc_throw(SocketConfigError, "failed to subscribe to the interface"
+                  " changes: " << strerror(error));
+    }
+
+    track_socket_ = fd;
+    iface_callback_ = callback;
+    addExternalSocket(fd, boost::bind(&IfaceMgr::handleIfaceChanges, this));
+    return (true);
+}
+
+void IfaceMgr::handleIfaceChanges() {
+    bool changed = false;
+    // Aligned for the netlink message headers.
+    uint32_t buf[RCVBUF_SIZE / sizeof(uint32_t)];
+
+    // Take all the pending notifications: a burst of them (e.g. an interface
+    // going down with all its addresses) leads to a single update.
+    for (;;) {
+        const ssize_t len = recv(track_socket_, buf, sizeof(buf), 0);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Some notifications were dropped, so look at everything.
+            if (errno == ENOBUFS) {
+                changed = true;
+                continue;
+            }
+            break;
+        }
+        if (len == 0) {
+            break;
+        }
+        int left = len;
+        for (struct nlmsghdr* msg = reinterpret_cast<struct nlmsghdr*>(buf);
+             NLMSG_OK(msg, left); msg = NLMSG_NEXT(msg, left)) {
+            switch (msg->nlmsg_type) {
+            case RTM_NEWLINK:
+            case RTM_DELLINK:
+            case RTM_NEWADDR:
+            case RTM_DELADDR:
+                changed = true;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    IfaceCollection detected;
+    try {
+        dumpIfaces(detected);
+    } catch (const std::exception& ex) {
+        // The known interfaces are kept; the next change tries again.
+        if (iface_callback_) {
+            iface_callback_("", IFACE_CHANGED, ex.what());
+        }
+        return;
+    }
+    updateIfaces(detected);
+}
+
 bool
 IfaceMgr::isDirectResponseSupported() {
     return (false);
@@ -17,6 +17,7 @@
 #include <dhcp/dhcp4.h>
 #include <dhcp/dhcp6.h>
 #include <dhcp/libdhcp++.h>
+#include <dhcp/option4_scanner.h>
 #include <dhcp/option.h>
 #include <dhcp/option6_ia.h>
 #include <dhcp/option6_iaaddr.h>
@@ -195,7 +196,7 @@ size_t LibDHCP::unpackOptions6(const OptionBuffer& buf,
             assert(def);
             opt = def->optionFactory(Option::V6, opt_type,
                                      buf.begin() + offset,
-                                     buf.begin() + offset + opt_len);
+                                     buf.begin() + offset + opt_len, "dhcp6");
         }
         // add option to options
         options.insert(std::make_pair(opt_type, opt));
@@ -207,7 +208,22 @@ size_t LibDHCP::unpackOptions6(const OptionBuffer& buf,
 
 size_t LibDHCP::unpackOptions4(const OptionBuffer& buf,
                                isc::dhcp::Option::OptionCollection& options) {
-    size_t offset = 0;
+    return (unpackOptions4(buf.begin(), buf.end(), options));
+}
+
+size_t LibDHCP::unpackOptions4(OptionBufferConstIter begin,
+                               OptionBufferConstIter end,
+                               isc::dhcp::Option::OptionCollection& options) {
+    if (begin == end) {
+        return (0);
+    }
+
+    // Validate the whole buffer and find all options first, so as no
+    // option objects are created for a malformed buffer.
+    Option4LocationCollection locations;
+    const size_t offset = Option4Scanner::scan(&(*begin),
+                                               std::distance(begin, end),
+                                               locations);
 
     // Get the list of stdandard option definitions.
     const OptionDefContainer& option_defs = LibDHCP::getOptionDefs(Option::V4);
@@ -215,33 +231,11 @@ size_t LibDHCP::unpackOptions4(const OptionBuffer& buf,
     // using option code.
     const OptionDefContainerTypeIndex& idx = option_defs.get<1>();
 
-    // The buffer being read comprises a set of options, each starting with
-    // a one-byte type code and a one-byte length field.
-    while (offset + 1 <= buf.size()) {
-        uint8_t opt_type = buf[offset++];
-
-        // DHO_END is a special, one octet long option
-        if (opt_type == DHO_END)
-            return (offset); // just return. Don't need to add DHO_END option
-
-        // DHO_PAD is just a padding after DHO_END. Let's continue parsing
-        // in case we receive a message without DHO_END.
-        if (opt_type == DHO_PAD)
-            continue;
-
-        if (offset + 1 >= buf.size()) {
-            // opt_type must be cast to integer so as it is not treated as
-            // unsigned char value (a number is presented in error message).
-            isc_throw(OutOfRange, "Attempt to parse truncated option "
-                      << static_cast<int>(opt_type));
-        }
-
-        uint8_t opt_len =  buf[offset++];
-        if (offset + opt_len > buf.size()) {
-            isc_throw(OutOfRange, "Option parse failed. Tried to parse "
-                      << offset + opt_len << " bytes from " << buf.size()
-                      << "-byte long buffer.");
-        }
+    for (Option4LocationCollection::const_iterator loc = locations.begin();
+         loc != locations.end(); ++loc) {
+        const uint8_t opt_type = loc->type_;
+        OptionBufferConstIter data_begin = begin + loc->offset_;
+        OptionBufferConstIter data_end = data_begin + loc->len_;
 
         // Get all definitions with the particular option code. Note that option code
         // is non-unique within this container however at this point we expect
@@ -262,20 +256,17 @@ size_t LibDHCP::unpackOptions4(const OptionBuffer& buf,
                       << " is implemented");
         } else if (num_defs == 0) {
             opt = OptionPtr(new Option(Option::V4, opt_type,
-                                       buf.begin() + offset,
-                                       buf.begin() + offset + opt_len));
+                                       data_begin, data_end));
         } else {
             // The option definition has been found. Use it to create
             // the option instance from the provided buffer chunk.
             const OptionDefinitionPtr& def = *(range.first);
             assert(def);
             opt = def->optionFactory(Option::V4, opt_type,
-                                     buf.begin() + offset,
-                                     buf.begin() + offset + opt_len);
+                                     data_begin, data_end, "dhcp4");
         }
 
         options.insert(std::make_pair(opt_type, opt));
-        offset += opt_len;
     }
     return (offset);
 }
@@ -113,6 +113,25 @@ public:
     static size_t unpackOptions4(const OptionBuffer& buf,
                                  isc::dhcp::Option::OptionCollection& options);
 
+    /// @brief Parses DHCPv4 options from the part of a buffer.
+    ///
+    /// This variant allows parsing options directly from the buffer
+    /// holding the whole packet, without copying them to a separate
+    /// buffer first. The buffer is validated before any option object
+    /// is created (see @ref Option4Scanner).
+    ///
+    /// @param begin iterator pointing to the beginning of the options.
+    /// @param end iterator pointing to the end of the options.
+    /// @param options Reference to option container. Options will be
+    ///        put here.
+    ///
+    /// @throw isc::OutOfRange if any option is truncated.
+    /// @return offset of the first octet following the END option,
+    /// relative to begin.
+    static size_t unpackOptions4(OptionBufferConstIter begin,
+                                 OptionBufferConstIter end,
+                                 isc::dhcp::Option::OptionCollection& options);
+
     /// @brief Parses provided buffer as DHCPv6 options and creates Option objects.
     ///
     /// Parses provided buffer and stores created Option objects in options
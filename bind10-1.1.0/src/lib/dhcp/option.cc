@@ -235,28 +235,32 @@ void Option::addOption(OptionPtr opt) {
 }
 
 uint8_t Option::getUint8() {
-    if (data_.size() < sizeof(uint8_t) ) {
+    // Use getData() so as this works for options which don't hold
+    // their data in the on-wire format.
+    const OptionBuffer& data = getData();
+    if (data.size() < sizeof(uint8_t) ) {
         isc_throw(OutOfRange, "Attempt to read uint8 from option " << type_
-                  << " that has size " << data_.size());
+                  << " that has size " << data.size());
     }
-    return (data_[0]);
+    return (data[0]);
 }
 
 uint16_t Option::getUint16() {
-    if (data_.size() < sizeof(uint16_t) ) {
+    const OptionBuffer& data = getData();
+    if (data.size() < sizeof(uint16_t) ) {
         isc_throw(OutOfRange, "Attempt to read uint16 from option " << type_
-                  << " that has size " << data_.size());
+                  << " that has size " << data.size());
     }
-
-    return ( readUint16(&data_[0]) );
+    return (readUint16(&data[0]));
 }
 
 uint32_t Option::getUint32() {
-    if (data_.size() < sizeof(uint32_t) ) {
+    const OptionBuffer& data = getData();
+    if (data.size() < sizeof(uint32_t) ) {
         isc_throw(OutOfRange, "Attempt to read uint32 from option " << type_
-                  << " that has size " << data_.size());
+                  << " that has size " << data.size());
     }
-    return ( readUint32(&data_[0]) );
+    return (readUint32(&data[0]));
 }
 
 void Option::setUint8(uint8_t value) {
@@ -258,23 +258,29 @@ public:
     /// @brief Sets content of this option to singe uint8 value.
     ///
     /// Option it resized appropriately (to length of 1 octet).
+    /// Derived classes which don't hold the data in the on-wire format
+    /// override it.
     ///
     /// @param value value to be set
-    void setUint8(uint8_t value);
+    virtual void setUint8(uint8_t value);
 
     /// @brief Sets content of this option to singe uint16 value.
     ///
     /// Option it resized appropriately (to length of 2 octets).
+    /// Derived classes which don't hold the data in the on-wire format
+    /// override it.
     ///
     /// @param value value to be set
-    void setUint16(uint16_t value);
+    virtual void setUint16(uint16_t value);
 
     /// @brief Sets content of this option to singe uint32 value.
     ///
     /// Option it resized appropriately (to length of 4 octets).
+    /// Derived classes which don't hold the data in the on-wire format
+    /// override it.
     ///
     /// @param value value to be set
-    void setUint32(uint32_t value);
+    virtual void setUint32(uint32_t value);
 
     /// @brief Sets content of this option from buffer.
     ///
@@ -0,0 +1,200 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/option4_scanner.h>
+
+// Vector implementations are only built for x86 with a compiler that
+// allows enabling instruction sets for individual functions, so as the
+// rest of the library can be compiled for the baseline CPU.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && \
+    (defined(__clang__) || \
+     (defined(__GNUC__) && ((__GNUC__ > 4) || \
+                            (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define OPTION4_SCANNER_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using namespace isc::dhcp;
+
+size_t
+skipPadScalar(const uint8_t* buf, size_t len) {
+    size_t pos = 0;
+    while ((pos < len) && (buf[pos] == DHO_PAD)) {
+        ++pos;
+    }
+    return (pos);
+}
+
+#ifdef OPTION4_SCANNER_X86
+
+size_t
+skipPadSSE2(const uint8_t* buf, size_t len) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t pos = 0;
+    for (; pos + 16 <= len; pos += 16) {
+        __m128i block =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + pos));
+        // Bit is set for every octet equal to PAD.
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, zero));
+        if (mask != 0xFFFF) {
+            return (pos + __builtin_ctz(~mask));
+        }
+    }
+    return (pos + skipPadScalar(buf + pos, len - pos));
+}
+
+__attribute__((target("avx2")))
+size_t
+skipPadAVX2(const uint8_t* buf, size_t len) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t pos = 0;
+    for (; pos + 32 <= len; pos += 32) {
+        __m256i block =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf + pos));
+        unsigned mask = static_cast<unsigned>
+            (_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, zero)));
+        if (mask != 0xFFFFFFFFU) {
+            return (pos + __builtin_ctz(~mask));
+        }
+    }
+    return (pos + skipPadSSE2(buf + pos, len - pos));
+}
+
+#endif
+
+Option4Scanner::Implementation
+detectImplementation() {
+#ifdef OPTION4_SCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return (Option4Scanner::IMPL_AVX2);
+    }
+    return (Option4Scanner::IMPL_SSE2);
+#else
+    return (Option4Scanner::IMPL_SCALAR);
+#endif
+}
+
+}
+
+namespace isc {
+namespace dhcp {
+
+// Until this is initialized (e.g. when called during static initialization
+// of another module), the value is zero, i.e. the scalar implementation.
+const Option4Scanner::Implementation Option4Scanner::implementation_ =
+    detectImplementation();
+
+Option4Scanner::Implementation
+Option4Scanner::getDefaultImplementation() {
+    return (implementation_);
+}
+
+bool
+Option4Scanner::isSupported(Implementation impl) {
+    switch (impl) {
+    case IMPL_SCALAR:
+        return (true);
+#ifdef OPTION4_SCANNER_X86
+    case IMPL_SSE2:
+        return (true);
+    case IMPL_AVX2:
+        return (implementation_ == IMPL_AVX2);
+#endif
+    default:
+        ;
+    }
+    return (false);
+}
+
+size_t
+Option4Scanner::skipPad(const uint8_t* buf, size_t len, Implementation impl) {
+    switch (impl) {
+    case IMPL_SCALAR:
+        return (skipPadScalar(buf, len));
+#ifdef OPTION4_SCANNER_X86
+    case IMPL_SSE2:
+        return (skipPadSSE2(buf, len));
+    case IMPL_AVX2:
+        if (implementation_ == IMPL_AVX2) {
+            return (skipPadAVX2(buf, len));
+        }
+        break;
+#endif
+    default:
+        ;
+    }
+    isc_throw(BadValue, "Unsupported option scanner implementation "
+              << static_cast<int>(impl));
+}
+
+size_t
+Option4Scanner::scan(const uint8_t* buf, size_t len,
+                     Option4LocationCollection& locations,
+                     Implementation impl) {
+    if (!isSupported(impl)) {
+        isc_throw(BadValue, "Unsupported option scanner implementation "
+                  << static_cast<int>(impl));
+    }
+
+    size_t offset = 0;
+    while (offset < len) {
+        uint8_t opt_type = buf[offset];
+
+        // DHO_PAD is just a padding after DHO_END. Let's continue parsing
+        // in case we receive a message without DHO_END.
+        if (opt_type == DHO_PAD) {
+            offset += skipPad(buf + offset, len - offset, impl);
+            continue;
+        }
+
+        ++offset;
+
+        // DHO_END is a special, one octet long option
+        if (opt_type == DHO_END) {
+            return (offset);
+        }
+
+        // Note that this also rejects a zero-length option occupying the
+        // last two octets of the buffer. This is kept for compatibility
+        // with the original parser.
+        if (offset + 1 >= len) {
+            isc_throw(OutOfRange, "Attempt to parse truncated option "
+                      << static_cast<int>(opt_type));
+        }
+
+        uint8_t opt_len = buf[offset++];
+        if (offset + opt_len > len) {
+            isc_throw(OutOfRange, "Option parse failed. Tried to parse "
+                      << offset + opt_len << " bytes from " << len
+                      << "-byte long buffer.");
+        }
+
+        Option4Location location;
+        location.type_ = opt_type;
+        location.len_ = opt_len;
+        location.offset_ = offset;
+        locations.push_back(location);
+
+        offset += opt_len;
+    }
+    return (offset);
+}
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
@@ -0,0 +1,126 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef OPTION4_SCANNER_H
+#define OPTION4_SCANNER_H
+
+#include <exceptions/exceptions.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Location of a single option within a DHCPv4 options buffer.
+struct Option4Location {
+    /// @brief Option code.
+    uint8_t type_;
+    /// @brief Length of the option data (excluding option header).
+    uint8_t len_;
+    /// @brief Offset of the option data (after the option header)
+    /// from the beginning of the scanned buffer.
+    size_t offset_;
+};
+
+/// @brief Collection of option locations, in the order of appearance.
+typedef std::vector<Option4Location> Option4LocationCollection;
+
+/// @brief Validates DHCPv4 options buffer and builds its option table.
+///
+/// Parsing of DHCPv4 options is done in two passes. The first pass,
+/// implemented by this class, walks the option headers, skips padding,
+/// checks that no option extends past the end of the buffer and records
+/// the location of each option. The second pass (see
+/// @ref LibDHCP::unpackOptions4) creates option objects for the recorded
+/// locations. As the buffer is fully validated before any option object
+/// is created, nothing is allocated for malformed packets.
+///
+/// Long runs of PAD options (zero octets) are typical after the END option
+/// in packets padded to the minimal BOOTP size. Such runs are skipped
+/// using SSE2 or AVX2 instructions, when available. The implementation is
+/// selected at runtime, based on the CPU capabilities, and the portable
+/// scalar implementation is used on other platforms. All implementations
+/// produce identical results.
+class Option4Scanner {
+public:
+
+    /// @brief Implementations of the padding scan.
+    enum Implementation {
+        IMPL_SCALAR, ///< portable byte-by-byte scan
+        IMPL_SSE2,   ///< 16 octets per step
+        IMPL_AVX2    ///< 32 octets per step
+    };
+
+    /// @brief Returns the fastest implementation supported by this CPU.
+    static Implementation getDefaultImplementation();
+
+    /// @brief Checks if the specified implementation can be used.
+    ///
+    /// @param impl implementation to be checked.
+    /// @return true if implementation is compiled in and supported by CPU.
+    static bool isSupported(Implementation impl);
+
+    /// @brief Scans DHCPv4 options buffer using the default implementation.
+    ///
+    /// Scanning stops at the END option or at the end of the buffer. PAD
+    /// and END options are not recorded.
+    ///
+    /// @param buf pointer to the beginning of the options buffer.
+    /// @param len length of the buffer.
+    /// @param [out] locations collection where option locations are appended.
+    ///
+    /// @throw isc::OutOfRange if any option is truncated.
+    /// @return offset of the first octet following the END option, or the
+    /// buffer length if there is no END option.
+    static size_t scan(const uint8_t* buf, size_t len,
+                       Option4LocationCollection& locations) {
+        return (scan(buf, len, locations, implementation_));
+    }
+
+    /// @brief Scans DHCPv4 options buffer using specified implementation.
+    ///
+    /// @param buf pointer to the beginning of the options buffer.
+    /// @param len length of the buffer.
+    /// @param [out] locations collection where option locations are appended.
+    /// @param impl implementation of the padding scan to be used.
+    ///
+    /// @throw isc::OutOfRange if any option is truncated.
+    /// @throw isc::BadValue if implementation is not supported.
+    /// @return offset of the first octet following the END option, or the
+    /// buffer length if there is no END option.
+    static size_t scan(const uint8_t* buf, size_t len,
+                       Option4LocationCollection& locations,
+                       Implementation impl);
+
+    /// @brief Returns the length of the run of PAD options.
+    ///
+    /// @param buf pointer to the first octet to be checked.
+    /// @param len number of octets available.
+    /// @param impl implementation to be used.
+    ///
+    /// @throw isc::BadValue if implementation is not supported.
+    /// @return number of leading zero octets.
+    static size_t skipPad(const uint8_t* buf, size_t len, Implementation impl);
+
+private:
+    /// @brief Implementation used by default, detected once at startup.
+    static const Implementation implementation_;
+};
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
+
+#endif // OPTION4_SCANNER_H
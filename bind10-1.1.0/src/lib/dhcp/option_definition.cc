@@ -19,6 +19,7 @@
 #include <dhcp/option6_iaaddr.h>
 #include <dhcp/option_custom.h>
 #include <dhcp/option_definition.h>
+#include <dhcp/option_fixed.h>
 #include <dhcp/option_int.h>
 #include <dhcp/option_int_array.h>
 #include <dhcp/option_space.h>
@@ -109,8 +110,16 @@ OptionDefinition::addRecordField(const OptionDataType data_type) {
 OptionPtr
 OptionDefinition::optionFactory(Option::Universe u, uint16_t type,
                                 OptionBufferConstIter begin,
-                                OptionBufferConstIter end) const {
+                                OptionBufferConstIter end,
+                                const std::string& option_space) const {
     try {
+        // Frequently used standard options with a fixed layout are
+        // handled by classes specialized at compile time.
+        OptionPtr fixed = factoryFixed(u, type, option_space, begin, end);
+        if (fixed) {
+            return (fixed);
+        }
+
         switch(type_) {
         case OPT_EMPTY_TYPE:
             return (factoryEmpty(u, type));
@@ -195,13 +204,15 @@ OptionDefinition::optionFactory(Option::Universe u, uint16_t type,
 
 OptionPtr
 OptionDefinition::optionFactory(Option::Universe u, uint16_t type,
-                                const OptionBuffer& buf) const {
-    return (optionFactory(u, type, buf.begin(), buf.end()));
+                                const OptionBuffer& buf,
+                                const std::string& option_space) const {
+    return (optionFactory(u, type, buf.begin(), buf.end(), option_space));
 }
 
 OptionPtr
 OptionDefinition::optionFactory(Option::Universe u, uint16_t type,
-                                const std::vector<std::string>& values) const {
+                                const std::vector<std::string>& values,
+                                const std::string& option_space) const {
     OptionBuffer buf;
     if (!array_type_ && type_ != OPT_RECORD_TYPE) {
         if (values.empty()) {
@@ -224,7 +235,7 @@ OptionDefinition::optionFactory(Option::Universe u, uint16_t type,
                           records[i], buf);
         }
     }
-    return (optionFactory(u, type, buf.begin(), buf.end()));
+    return (optionFactory(u, type, buf.begin(), buf.end(), option_space));
 }
 
 void
@@ -475,6 +486,29 @@ OptionDefinition::factoryAddrList6(uint16_t type,
 }
 
 
+OptionPtr
+OptionDefinition::factoryFixed(Option::Universe u, uint16_t type,
+                               const std::string& option_space,
+                               OptionBufferConstIter begin,
+                               OptionBufferConstIter end) const {
+    if (option_space != (u == Option::V4 ? "dhcp4" : "dhcp6")) {
+        return (OptionPtr());
+
+    } else if (Option4MessageType::matches(u, type, type_, array_type_)) {
+        return (OptionPtr(new Option4MessageType(begin, end)));
+
+    } else if (Option4LeaseTime::matches(u, type, type_, array_type_)) {
+        return (OptionPtr(new Option4LeaseTime(begin, end)));
+
+    } else if (Option4ServerId::matches(u, type, type_, array_type_)) {
+        return (OptionPtr(new Option4ServerId(begin, end)));
+
+    } else if (Option4SubnetMask::matches(u, type, type_, array_type_)) {
+        return (OptionPtr(new Option4SubnetMask(begin, end)));
+    }
+    return (OptionPtr());
+}
+
 OptionPtr
 OptionDefinition::factoryEmpty(Option::Universe u, uint16_t type) {
     OptionPtr option(new Option(u, type));
@@ -289,12 +289,16 @@ public:
     /// @param type option type.
     /// @param begin beginning of the option buffer.
     /// @param end end of the option buffer.
+    /// @param option_space name of the option space the option belongs to.
+    /// The classes specialized for the standard options are only used
+    /// for the "dhcp4" and "dhcp6" spaces.
     ///
     /// @return instance of the DHCP option.
     /// @throw InvalidOptionValue if data for the option is invalid.
     OptionPtr optionFactory(Option::Universe u, uint16_t type,
                             OptionBufferConstIter begin,
-                            OptionBufferConstIter end) const;
+                            OptionBufferConstIter end,
+                            const std::string& option_space = "") const;
 
     /// @brief Option factory.
     ///
@@ -309,11 +313,13 @@ public:
     /// @param u option universe (V4 or V6).
     /// @param type option type.
     /// @param buf option buffer.
+    /// @param option_space name of the option space the option belongs to.
     ///
     /// @return instance of the DHCP option.
     /// @throw InvalidOptionValue if data for the option is invalid.
     OptionPtr optionFactory(Option::Universe u, uint16_t type,
-                            const OptionBuffer& buf = OptionBuffer()) const;
+                            const OptionBuffer& buf = OptionBuffer(),
+                            const std::string& option_space = "") const;
 
     /// @brief Option factory.
     ///
@@ -336,11 +342,13 @@ public:
     /// @param u option universe (V4 or V6).
     /// @param type option type.
     /// @param values a vector of values to be used to set data for an option.
+    /// @param option_space name of the option space the option belongs to.
     ///
     /// @return instance of the DHCP option.
     /// @throw InvalidOptionValue if data for the option is invalid.
     OptionPtr optionFactory(Option::Universe u, uint16_t type,
-                            const std::vector<std::string>& values) const;
+                            const std::vector<std::string>& values,
+                            const std::string& option_space = "") const;
 
     /// @brief Factory to create option with address list.
     ///
@@ -449,6 +457,27 @@ public:
 
 private:
 
+    /// @brief Factory for standard options with a fixed layout.
+    ///
+    /// Returns an instance of the @ref OptionFixed class specialized for
+    /// the option, if there is one and its layout matches this definition.
+    /// Options of the other spaces may use the same codes for something
+    /// else, so the specialized classes are only used for the standard
+    /// option space of the universe.
+    ///
+    /// @param u universe (V4 or V6).
+    /// @param type option type.
+    /// @param option_space name of the option space the option belongs to.
+    /// @param begin iterator pointing to the beginning of the buffer.
+    /// @param end iterator pointing to the end of the buffer.
+    ///
+    /// @throw isc::OutOfRange if provided option buffer is too short.
+    /// @return option instance or NULL if there is no specialized class.
+    OptionPtr factoryFixed(Option::Universe u, uint16_t type,
+                           const std::string& option_space,
+                           OptionBufferConstIter begin,
+                           OptionBufferConstIter end) const;
+
     /// @brief Check if specified option format is a record with 3 fields
     /// where first one is custom, and two others are uint32.
     ///
@@ -0,0 +1,442 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef OPTION_FIXED_H
+#define OPTION_FIXED_H
+
+#include <asiolink/io_address.h>
+#include <dhcp/dhcp4.h>
+#include <dhcp/option.h>
+#include <dhcp/option_data_types.h>
+#include <util/buffer.h>
+#include <util/io_utilities.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <sstream>
+#include <stdint.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Maps option data type to the type used to hold its value.
+///
+/// Only fixed-width data types are supported. The trait is not defined
+/// for other types so an attempt to use them with @ref OptionFixed
+/// results in a compilation error.
+template<OptionDataType TYPE>
+struct OptionFixedFieldTraits;
+
+/// uint8_t field.
+template<>
+struct OptionFixedFieldTraits<OPT_UINT8_TYPE> {
+    typedef uint8_t ValueType;
+};
+
+/// int8_t field.
+template<>
+struct OptionFixedFieldTraits<OPT_INT8_TYPE> {
+    typedef int8_t ValueType;
+};
+
+/// uint16_t field.
+template<>
+struct OptionFixedFieldTraits<OPT_UINT16_TYPE> {
+    typedef uint16_t ValueType;
+};
+
+/// int16_t field.
+template<>
+struct OptionFixedFieldTraits<OPT_INT16_TYPE> {
+    typedef int16_t ValueType;
+};
+
+/// uint32_t field.
+template<>
+struct OptionFixedFieldTraits<OPT_UINT32_TYPE> {
+    typedef uint32_t ValueType;
+};
+
+/// int32_t field.
+template<>
+struct OptionFixedFieldTraits<OPT_INT32_TYPE> {
+    typedef int32_t ValueType;
+};
+
+/// IPv4 address field, held in host byte order.
+template<>
+struct OptionFixedFieldTraits<OPT_IPV4_ADDRESS_TYPE> {
+    typedef uint32_t ValueType;
+};
+
+/// @brief Option comprising a fixed number of fixed-width fields.
+///
+/// Standard options such as DHCPv4 Message Type, Lease Time, Server
+/// Identifier or Subnet Mask are very frequent and always have the same
+/// layout. The generic classes which handle them (@ref OptionInt,
+/// @ref OptionCustom) store their data in vectors and check the data
+/// type at runtime. This class is specialized at compile time with the
+/// option code and the layout taken from the standard option definition
+/// (see std_option_defs.h). The field values are held inline, so no
+/// memory is allocated for the option data, and the data is packed and
+/// parsed by inline, non-virtual functions. The usual @ref Option
+/// interface is provided by virtual functions which call them.
+///
+/// Instances are created by @ref OptionDefinition::optionFactory for the
+/// options listed at the end of this file, when the option definition
+/// matches the template parameters.
+///
+/// @tparam U option universe.
+/// @tparam CODE option code.
+/// @tparam TYPE data type of each field.
+/// @tparam N number of fields.
+template<Option::Universe U, uint16_t CODE, OptionDataType TYPE, size_t N = 1>
+class OptionFixed : public Option {
+public:
+
+    /// @brief Type of the value held in a field.
+    typedef typename OptionFixedFieldTraits<TYPE>::ValueType ValueType;
+
+    /// @brief Length of the option data.
+    static const size_t DATA_LEN = N * sizeof(ValueType);
+
+    /// @brief Constructor, sets all fields to zero.
+    OptionFixed()
+        : Option(U, CODE) {
+        for (size_t i = 0; i < N; ++i) {
+            values_[i] = 0;
+        }
+    }
+
+    /// @brief Constructor, sets the first field.
+    ///
+    /// @param value value of the first field. Other fields are set to zero.
+    explicit OptionFixed(ValueType value)
+        : Option(U, CODE) {
+        values_[0] = value;
+        for (size_t i = 1; i < N; ++i) {
+            values_[i] = 0;
+        }
+    }
+
+    /// @brief Constructor, creates option from the buffer.
+    ///
+    /// @param begin iterator to the beginning of the option data.
+    /// @param end iterator to the end of the option data.
+    ///
+    /// @throw isc::OutOfRange if the buffer is truncated.
+    OptionFixed(OptionBufferConstIter begin, OptionBufferConstIter end)
+        : Option(U, CODE) {
+        parse(begin, end);
+    }
+
+    /// @brief Checks if this class can handle options of the definition.
+    ///
+    /// @param universe universe of the option being created.
+    /// @param code code of the option being created.
+    /// @param type data type held by the option definition.
+    /// @param array_type array indicator of the option definition.
+    ///
+    /// @return true if the definition matches the template parameters.
+    static bool matches(Option::Universe universe, uint16_t code,
+                        OptionDataType type, bool array_type) {
+        return ((universe == U) && (code == CODE) && (type == TYPE) &&
+                (N == 1) && !array_type);
+    }
+
+    /// @brief Returns the value of the field.
+    ///
+    /// @param index field index.
+    ///
+    /// @throw isc::OutOfRange if index is out of range.
+    ValueType getValue(size_t index = 0) const {
+        checkIndex(index);
+        return (values_[index]);
+    }
+
+    /// @brief Sets the value of the field.
+    ///
+    /// @param value new value.
+    /// @param index field index.
+    ///
+    /// @throw isc::OutOfRange if index is out of range.
+    void setValue(ValueType value, size_t index = 0) {
+        checkIndex(index);
+        values_[index] = value;
+    }
+
+    /// @brief Returns the value of the address field.
+    ///
+    /// @param index field index.
+    ///
+    /// @throw isc::dhcp::InvalidDataType if the field is not an address.
+    /// @throw isc::OutOfRange if index is out of range.
+    asiolink::IOAddress readAddress(size_t index = 0) const {
+        checkAddress();
+        return (asiolink::IOAddress(getValue(index)));
+    }
+
+    /// @brief Sets the value of the address field.
+    ///
+    /// @param address new IPv4 address.
+    /// @param index field index.
+    ///
+    /// @throw isc::dhcp::InvalidDataType if the field is not an address
+    /// or the address is not an IPv4 address.
+    /// @throw isc::OutOfRange if index is out of range.
+    void writeAddress(const asiolink::IOAddress& address, size_t index = 0) {
+        checkAddress();
+        if (!address.isV4()) {
+            isc_throw(InvalidDataType, address.toText()
+                      << " is not an IPv4 address");
+        }
+        setValue(static_cast<uint32_t>(address), index);
+    }
+
+    /// @brief Sets the value of the single field.
+    ///
+    /// @param value new value.
+    ///
+    /// @throw isc::BadValue if the option doesn't hold a single 8-bit field.
+    virtual void setUint8(uint8_t value) {
+        setUint(value);
+    }
+
+    /// @brief Sets the value of the single field.
+    ///
+    /// @param value new value.
+    ///
+    /// @throw isc::BadValue if the option doesn't hold a single 16-bit field.
+    virtual void setUint16(uint16_t value) {
+        setUint(value);
+    }
+
+    /// @brief Sets the value of the single field.
+    ///
+    /// @param value new value.
+    ///
+    /// @throw isc::BadValue if the option doesn't hold a single 32-bit field.
+    virtual void setUint32(uint32_t value) {
+        setUint(value);
+    }
+
+    /// @brief Stores the option data (without header) in the buffer.
+    ///
+    /// @param [out] buf output buffer.
+    void packData(isc::util::OutputBuffer& buf) const {
+        for (size_t i = 0; i < N; ++i) {
+            switch (sizeof(ValueType)) {
+            case 1:
+                buf.writeUint8(values_[i]);
+                break;
+            case 2:
+                buf.writeUint16(values_[i]);
+                break;
+            default:
+                buf.writeUint32(values_[i]);
+            }
+        }
+        if (!trailing_data_.empty()) {
+            buf.writeData(&trailing_data_[0], trailing_data_.size());
+        }
+    }
+
+    /// @brief Reads the option data (without header) from the buffer.
+    ///
+    /// Any data following the fields is kept and sent back as is when
+    /// the option is packed.
+    ///
+    /// @param begin iterator to the beginning of the option data.
+    /// @param end iterator to the end of the option data.
+    ///
+    /// @throw isc::OutOfRange if the buffer is truncated.
+    void parse(OptionBufferConstIter begin, OptionBufferConstIter end) {
+        if (std::distance(begin, end) < static_cast<int>(DATA_LEN)) {
+            isc_throw(OutOfRange, "option " << CODE << " truncated, expected "
+                      << DATA_LEN << " bytes, got "
+                      << std::distance(begin, end));
+        }
+        const uint8_t* data = &(*begin);
+        for (size_t i = 0; i < N; ++i) {
+            switch (sizeof(ValueType)) {
+            case 1:
+                values_[i] = data[0];
+                break;
+            case 2:
+                values_[i] = isc::util::readUint16(data);
+                break;
+            default:
+                values_[i] = isc::util::readUint32(data);
+            }
+            data += sizeof(ValueType);
+        }
+        trailing_data_.assign(begin + DATA_LEN, end);
+    }
+
+    /// @brief Writes option in wire-format to a buffer.
+    ///
+    /// @param [out] buf output buffer.
+    virtual void pack(isc::util::OutputBuffer& buf) {
+        packHeader(buf);
+        packData(buf);
+        packOptions(buf);
+    }
+
+    /// @brief Parses option from the received buffer.
+    ///
+    /// @param begin iterator to the beginning of the option data.
+    /// @param end iterator to the end of the option data.
+    ///
+    /// @throw isc::OutOfRange if the buffer is truncated.
+    virtual void unpack(OptionBufferConstIter begin,
+                        OptionBufferConstIter end) {
+        parse(begin, end);
+    }
+
+    /// @brief Returns length of the complete option (data length +
+    /// DHCPv4/DHCPv6 option header).
+    virtual uint16_t len() {
+        uint16_t length = ((U == Option::V4) ? OPTION4_HDR_LEN :
+                           OPTION6_HDR_LEN) + DATA_LEN + trailing_data_.size();
+        for (Option::OptionCollection::iterator it = options_.begin();
+             it != options_.end(); ++it) {
+            length += it->second->len();
+        }
+        return (length);
+    }
+
+    /// @brief Returns the option data in the on-wire format.
+    ///
+    /// The data is not held in this format so this function is slower
+    /// than the accessors. It is provided so as the option can be used
+    /// where other options are used, e.g. compared with them.
+    virtual const OptionBuffer& getData() const {
+        isc::util::OutputBuffer buf(DATA_LEN + trailing_data_.size());
+        packData(buf);
+        const uint8_t* data = static_cast<const uint8_t*>(buf.getData());
+        wire_data_.assign(data, data + buf.getLength());
+        return (wire_data_);
+    }
+
+    /// @brief Returns string representation of the option.
+    ///
+    /// @param indent number of spaces before the text.
+    virtual std::string toText(int indent = 0) {
+        std::stringstream tmp;
+        for (int i = 0; i < indent; ++i) {
+            tmp << " ";
+        }
+        tmp << "type=" << CODE << ", len="
+            << DATA_LEN + trailing_data_.size() << ":";
+        for (size_t i = 0; i < N; ++i) {
+            tmp << " ";
+            if (TYPE == OPT_IPV4_ADDRESS_TYPE) {
+                tmp << asiolink::IOAddress(values_[i]).toText();
+            } else {
+                // Cast to a wider type so as uint8_t is not printed
+                // as a character.
+                tmp << static_cast<int64_t>(values_[i]);
+            }
+        }
+        for (OptionCollection::const_iterator opt = options_.begin();
+             opt != options_.end(); ++opt) {
+            tmp << opt->second->toText(indent + 2);
+        }
+        return (tmp.str());
+    }
+
+private:
+
+    /// @brief Sets the value of the single field.
+    ///
+    /// @param value new value.
+    ///
+    /// @tparam T type of the value, its size must match the field.
+    /// @throw isc::BadValue if the option doesn't hold a single field
+    /// of the size of the value.
+    template<typename T>
+    void setUint(T value) {
+        if ((N != 1) || (sizeof(T) != sizeof(ValueType))) {
+            isc_throw(BadValue, "unable to set " << sizeof(T) << "-byte"
+                      " value of option " << CODE << " holding " << N
+                      << " field(s) of " << sizeof(ValueType) << " byte(s)");
+        }
+        values_[0] = static_cast<ValueType>(value);
+        trailing_data_.clear();
+    }
+
+    /// @brief Checks field index.
+    ///
+    /// @param index field index.
+    /// @throw isc::OutOfRange if index is out of range.
+    static void checkIndex(size_t index) {
+        if (index >= N) {
+            isc_throw(OutOfRange, "field index " << index << " out of range"
+                      " for option " << CODE << " holding " << N
+                      << " fields");
+        }
+    }
+
+    /// @brief Checks that the option holds addresses.
+    ///
+    /// @throw isc::dhcp::InvalidDataType if fields are not addresses.
+    static void checkAddress() {
+        if (TYPE != OPT_IPV4_ADDRESS_TYPE) {
+            isc_throw(InvalidDataType, "option " << CODE
+                      << " does not hold IPv4 addresses");
+        }
+    }
+
+    /// Field values.
+    ValueType values_[N];
+
+    /// Received data following the fields.
+    OptionBuffer trailing_data_;
+
+    /// Option data in the on-wire format, built by @ref getData.
+    mutable OptionBuffer wire_data_;
+};
+
+template<Option::Universe U, uint16_t CODE, OptionDataType TYPE, size_t N>
+const size_t OptionFixed<U, CODE, TYPE, N>::DATA_LEN;
+
+/// @name Standard DHCPv4 options handled by @ref OptionFixed.
+///
+/// Template parameters follow the definitions in std_option_defs.h.
+//@{
+/// DHCP Message Type (53).
+typedef OptionFixed<Option::V4, DHO_DHCP_MESSAGE_TYPE,
+                    OPT_UINT8_TYPE> Option4MessageType;
+typedef boost::shared_ptr<Option4MessageType> Option4MessageTypePtr;
+
+/// IP Address Lease Time (51).
+typedef OptionFixed<Option::V4, DHO_DHCP_LEASE_TIME,
+                    OPT_UINT32_TYPE> Option4LeaseTime;
+typedef boost::shared_ptr<Option4LeaseTime> Option4LeaseTimePtr;
+
+/// Server Identifier (54).
+typedef OptionFixed<Option::V4, DHO_DHCP_SERVER_IDENTIFIER,
+                    OPT_IPV4_ADDRESS_TYPE> Option4ServerId;
+typedef boost::shared_ptr<Option4ServerId> Option4ServerIdPtr;
+
+/// Subnet Mask (1).
+typedef OptionFixed<Option::V4, DHO_SUBNET_MASK,
+                    OPT_IPV4_ADDRESS_TYPE> Option4SubnetMask;
+typedef boost::shared_ptr<Option4SubnetMask> Option4SubnetMaskPtr;
+//@}
+
+} // isc::dhcp namespace
+} // isc namespace
+
+#endif // OPTION_FIXED_H
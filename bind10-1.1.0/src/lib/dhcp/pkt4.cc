@@ -15,6 +15,7 @@
 #include <asiolink/io_address.h>
 #include <dhcp/dhcp4.h>
 #include <dhcp/libdhcp++.h>
+#include <dhcp/option_fixed.h>
 #include <dhcp/option_int.h>
 #include <dhcp/pkt4.h>
 #include <exceptions/exceptions.h>
@@ -32,6 +33,8 @@ namespace dhcp {
 
 const IOAddress DEFAULT_ADDRESS("0.0.0.0");
 
+const size_t Pkt4::MAX_CHADDR_LEN;
+
 Pkt4::Pkt4(uint8_t msg_type, uint32_t transid)
      :local_addr_(DEFAULT_ADDRESS),
       remote_addr_(DEFAULT_ADDRESS),
@@ -208,12 +211,9 @@ Pkt4::unpack() {
       isc_throw(Unexpected, "Invalid or missing DHCP magic cookie");
     }
 
-    size_t opts_len = bufferIn.getLength() - bufferIn.getPosition();
-    vector<uint8_t> optsBuffer;
-
-    // First use of readVector.
-    bufferIn.readVector(optsBuffer, opts_len);
-    LibDHCP::unpackOptions4(optsBuffer, options_);
+    // Options are parsed in place, there is no need to copy them.
+    LibDHCP::unpackOptions4(data_.begin() + bufferIn.getPosition(),
+                            data_.end(), options_);
 
     // @todo check will need to be called separately, so hooks can be called
     // after the packet is parsed, but before its content is verified
@@ -234,6 +234,13 @@ uint8_t Pkt4::getType() const {
         isc_throw(Unexpected, "Missing DHCP Message Type option");
     }
 
+    // Received packets carry the specialized option class.
+    Option4MessageType* fixed_opt =
+        dynamic_cast<Option4MessageType*>(generic.get());
+    if (fixed_opt) {
+        return (fixed_opt->getValue());
+    }
+
     // Check if Message Type is specified as OptionInt<uint8_t>
     boost::shared_ptr<OptionInt<uint8_t> > type_opt =
         boost::dynamic_pointer_cast<OptionInt<uint8_t> >(generic);
@@ -249,6 +256,12 @@ void Pkt4::setType(uint8_t dhcp_type) {
     OptionPtr opt = getOption(DHO_DHCP_MESSAGE_TYPE);
     if (opt) {
         // There is message type option already, update it
+        Option4MessageType* fixed_opt =
+            dynamic_cast<Option4MessageType*>(opt.get());
+        if (fixed_opt) {
+            fixed_opt->setValue(dhcp_type);
+            return;
+        }
         opt->setUint8(dhcp_type);
     } else {
         // There is no message type option yet, add it
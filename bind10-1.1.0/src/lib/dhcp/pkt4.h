@@ -309,6 +309,15 @@ public:
     const isc::util::OutputBuffer&
     getBuffer() const { return (bufferOut_); };
 
+    /// @brief Exchanges the output buffer with the specified buffer.
+    ///
+    /// This is used to let the packet use a pre-allocated buffer, so
+    /// as no memory is allocated when the packet is packed (see
+    /// @ref PktBufferPool). No data is copied.
+    ///
+    /// @param buffer buffer to exchange the output buffer with.
+    void swapBuffer(isc::util::OutputBuffer& buffer) { bufferOut_.swap(buffer); }
+
     /// @brief Add an option.
     ///
     /// Throws BadValue if option with that type is already present.
@@ -418,6 +427,16 @@ public:
     /// just after receiving it.
     /// @throw isc::Unexpected if timestamp update failed
     void updateTimestamp();
+
+    /// @brief Sets packet timestamp.
+    ///
+    /// Used by the interface manager when the kernel tells when the
+    /// packet was received (SO_TIMESTAMP).
+    ///
+    /// @param timestamp reception time (UTC).
+    void setTimestamp(const boost::posix_time::ptime& timestamp) {
+        timestamp_ = timestamp;
+    }
     
     /// 4o6: is this a dhcpv4ov6 packet?
     int is4o6;
@@ -540,6 +559,9 @@ protected:
 
 typedef boost::shared_ptr<Pkt4> Pkt4Ptr;
 
+/// @brief A collection of DHCPv4 packets, e.g. received together.
+typedef std::vector<Pkt4Ptr> Pkt4Collection;
+
 } // isc::dhcp namespace
 
 } // isc namespace
@@ -121,6 +121,11 @@ uint16_t Pkt6::directLen() const {
         length += (*it).second->len();
     }
 
+    //4o6: DHCPv4 message is packed in place as OPTION_DHCPV4_MSG
+    if (!data4o6_.empty()) {
+        length += Option::OPTION6_HDR_LEN + data4o6_.size();
+    }
+
     return (length);
 }
 
@@ -194,6 +199,13 @@ Pkt6::packUDP() {
 
         // the rest are options
         LibDHCP::packOptions(bufferOut_, options_);
+
+        //4o6: write DHCPv4 message straight into its final position
+        if (!data4o6_.empty()) {
+            bufferOut_.writeUint16(OPTION_DHCPV4_MSG);
+            bufferOut_.writeUint16(data4o6_.size());
+            bufferOut_.writeData(&data4o6_[0], data4o6_.size());
+        }
     }
     catch (const Exception& e) {
         /// @todo: throw exception here once we turn this function to void.
@@ -391,7 +403,7 @@ Pkt6::toText() {
 }
 
 OptionPtr
-Pkt6::getOption(uint16_t opt_type) {
+Pkt6::getOption(uint16_t opt_type) const {
     isc::dhcp::Option::OptionCollection::const_iterator x = options_.find(opt_type);
     if (x!=options_.end()) {
         return (*x).second;
@@ -23,6 +23,7 @@
 #include <boost/shared_ptr.hpp>
 
 #include <iostream>
+#include <vector>
 
 #include <time.h>
 
@@ -114,6 +115,15 @@ public:
     /// @return reference to output buffer
     const isc::util::OutputBuffer& getBuffer() const { return (bufferOut_); };
 
+    /// @brief Exchanges the output buffer with the specified buffer.
+    ///
+    /// This is used to let the packet use a pre-allocated buffer, so
+    /// as no memory is allocated when the packet is packed (see
+    /// @ref PktBufferPool). No data is copied.
+    ///
+    /// @param buffer buffer to exchange the output buffer with.
+    void swapBuffer(isc::util::OutputBuffer& buffer) { bufferOut_.swap(buffer); }
+
     /// @brief Returns reference to input buffer.
     ///
     /// @return reference to input buffer
@@ -182,7 +192,7 @@ public:
     /// @param type option type we are looking for
     ///
     /// @return pointer to found option (or NULL)
-    OptionPtr getOption(uint16_t type);
+    OptionPtr getOption(uint16_t type) const;
 
     /// @brief returns option inserted by relay
     ///
@@ -328,6 +338,16 @@ public:
     /// @throw isc::Unexpected if timestamp update failed
     void updateTimestamp();
 
+    /// @brief Sets packet timestamp.
+    ///
+    /// Used by the interface manager when the kernel tells when the
+    /// packet was received (SO_TIMESTAMP).
+    ///
+    /// @param timestamp reception time (UTC).
+    void setTimestamp(const boost::posix_time::ptime& timestamp) {
+        timestamp_ = timestamp;
+    }
+
     /// @brief Return textual type of packet.
     ///
     /// Returns the name of valid packet received by the server (e.g. SOLICIT).
@@ -367,6 +387,10 @@ public:
     std::vector<RelayInfo> relay_info_;
     
     //4o6: content of OPTION_DHCPV4_MSG, used by dhcp6_srv when receiving v4msg from dhcp4_srv
+    //
+    // If not empty, pack() writes it as OPTION_DHCPV4_MSG directly into the
+    // output buffer, after all other options, so as the DHCPv4 message does
+    // not have to be copied into a separate Option object first.
     OptionBuffer data4o6_;
 protected:
     /// Builds on wire packet for TCP transmission.
@@ -499,6 +523,9 @@ protected:
 
 typedef boost::shared_ptr<Pkt6> Pkt6Ptr;
 
+/// @brief A collection of DHCPv6 packets, e.g. received together.
+typedef std::vector<Pkt6Ptr> Pkt6Collection;
+
 } // isc::dhcp namespace
 
 } // isc namespace
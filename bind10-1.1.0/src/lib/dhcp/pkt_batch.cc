@@ -0,0 +1,160 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+#include <dhcp/pkt_batch.h>
+#include <exceptions/exceptions.h>
+
+#include <string.h>
+
+namespace isc {
+namespace dhcp {
+
+PktBatch::PktBatch(size_t size, size_t buffer_size, size_t control_len)
+    : size_(size), buffer_size_(buffer_size), control_len_(control_len),
+      data_(size * buffer_size), control_(size * control_len),
+      names_(size), iovs_(size), headers_(size)
+#if !defined (OS_LINUX) || !defined (MSG_WAITFORONE)
+      , lengths_(size)
+#endif
+{
+    if (size_ == 0) {
+        isc_throw(BadValue, "a packet batch must have at least one slot");
+    }
+}
+
+struct msghdr&
+PktBatch::getHeader(size_t slot) {
+#if defined (OS_LINUX) && defined (MSG_WAITFORONE)
+    return (headers_[slot].msg_hdr);
+#else
+    return (headers_[slot]);
+#endif
+}
+
+size_t
+PktBatch::getLength(size_t slot) const {
+#if defined (OS_LINUX) && defined (MSG_WAITFORONE)
+    return (headers_[slot].msg_len);
+#else
+    return (lengths_[slot]);
+#endif
+}
+
+struct msghdr&
+PktBatch::prepareReceive(size_t slot) {
+    memset(&names_[slot], 0, sizeof(names_[slot]));
+    memset(&control_[slot * control_len_], 0, control_len_);
+
+    iovs_[slot].iov_base = &data_[slot * buffer_size_];
+    iovs_[slot].iov_len = buffer_size_;
+
+    struct msghdr& m = getHeader(slot);
+    memset(&m, 0, sizeof(m));
+    m.msg_name = &names_[slot];
+    m.msg_namelen = sizeof(names_[slot]);
+    m.msg_iov = &iovs_[slot];
+    m.msg_iovlen = 1;
+    m.msg_control = &control_[slot * control_len_];
+    m.msg_controllen = control_len_;
+    return (m);
+}
+
+struct msghdr&
+PktBatch::prepareSend(size_t slot, const void* name, socklen_t name_len,
+                      const void* data, size_t length) {
+    if (name_len > sizeof(names_[slot])) {
+        isc_throw(BadValue, "destination address too long: " << name_len);
+    }
+    memcpy(&names_[slot], name, name_len);
+    memset(&control_[slot * control_len_], 0, control_len_);
+
+    // The data are only read, iov_base not being const because the
+    // structure is used for the reception as well.
+    iovs_[slot].iov_base = const_cast<void*>(data);
+    iovs_[slot].iov_len = length;
+
+    struct msghdr& m = getHeader(slot);
+    memset(&m, 0, sizeof(m));
+    m.msg_name = &names_[slot];
+    m.msg_namelen = name_len;
+    m.msg_iov = &iovs_[slot];
+    m.msg_iovlen = 1;
+    m.msg_control = &control_[slot * control_len_];
+    m.msg_controllen = control_len_;
+    return (m);
+}
+
+int
+PktBatch::receive(int sockfd, size_t count) {
+    if (count > size_) {
+        count = size_;
+    } else if (count == 0) {
+        return (0);
+    }
+    for (size_t slot = 0; slot < count; ++slot) {
+        prepareReceive(slot);
+    }
+
+#if defined (OS_LINUX) && defined (MSG_WAITFORONE)
+    return (recvmmsg(sockfd, &headers_[0], count, MSG_WAITFORONE, NULL));
+#else
+    int received = 0;
+    for (size_t slot = 0; slot < count; ++slot) {
+        int flags = 0;
+        if (slot > 0) {
+#ifdef MSG_DONTWAIT
+            flags = MSG_DONTWAIT;
+#else
+            // Without it, the next recvmsg() could block.
+            break;
+#endif
+        }
+        const int result = recvmsg(sockfd, &headers_[slot], flags);
+        if (result < 0) {
+            break;
+        }
+        lengths_[slot] = result;
+        ++received;
+    }
+    return (received > 0 ? received : -1);
+#endif
+}
+
+int
+PktBatch::send(int sockfd, size_t count) {
+    if (count > size_) {
+        count = size_;
+    } else if (count == 0) {
+        return (0);
+    }
+
+#if defined (OS_LINUX) && defined (MSG_WAITFORONE)
+    return (sendmmsg(sockfd, &headers_[0], count, 0));
+#else
+    int sent = 0;
+    for (size_t slot = 0; slot < count; ++slot) {
+        const int result = sendmsg(sockfd, &headers_[slot], 0);
+        if (result < 0) {
+            break;
+        }
+        lengths_[slot] = result;
+        ++sent;
+    }
+    return (sent > 0 ? sent : -1);
+#endif
+}
+
+} // namespace isc::dhcp
+} // namespace isc
@@ -0,0 +1,170 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef PKT_BATCH_H
+#define PKT_BATCH_H
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Message headers to receive or send several datagrams at once.
+///
+/// A batch is made of slots, each having its own data buffer, address
+/// and control messages area. They are allocated by the constructor, so
+/// receiving or sending a batch allocates no memory.
+///
+/// On Linux the datagrams are read with a single recvmmsg() call and
+/// written with a single sendmmsg() call. Elsewhere, they are read and
+/// written one by one with recvmsg() and sendmsg(), the reception only
+/// waiting for the first one.
+///
+/// A slot is prepared with @ref prepareReceive or @ref prepareSend, then
+/// its control messages are read or written through the message header
+/// returned by these methods (with CMSG_FIRSTHDR() etc.).
+class PktBatch : public boost::noncopyable {
+public:
+
+    /// @brief Constructor.
+    ///
+    /// @param size number of slots.
+    /// @param buffer_size size of the data buffer of a slot, i.e. the
+    /// largest datagram received.
+    /// @param control_len size of the control messages area of a slot.
+    PktBatch(size_t size, size_t buffer_size, size_t control_len);
+
+    /// @brief Returns the number of slots.
+    size_t getSize() const {
+        return (size_);
+    }
+
+    /// @brief Prepares a slot for the reception of a datagram.
+    ///
+    /// The header points to the buffers of the slot, the control
+    /// messages area being cleared.
+    ///
+    /// @param slot slot index.
+    /// @return message header of the slot.
+    struct msghdr& prepareReceive(size_t slot);
+
+    /// @brief Prepares a slot for sending a datagram.
+    ///
+    /// The data are not copied, so they must not be released before the
+    /// datagram is sent. The whole control messages area is cleared and
+    /// given to the header: its length must be set to the length of the
+    /// control messages written, or to 0 if there are none.
+    ///
+    /// @param slot slot index.
+    /// @param name destination address, copied to the slot.
+    /// @param name_len length of the destination address.
+    /// @param data datagram data.
+    /// @param length datagram length.
+    /// @return message header of the slot.
+    struct msghdr& prepareSend(size_t slot, const void* name,
+                               socklen_t name_len, const void* data,
+                               size_t length);
+
+    /// @brief Receives datagrams in the first slots.
+    ///
+    /// The slots are prepared by this method. It waits for the first
+    /// datagram, if the socket is blocking, and takes the others which
+    /// are already queued.
+    ///
+    /// @param sockfd socket descriptor.
+    /// @param count maximum number of datagrams, capped by the size.
+    /// @return number of datagrams received, or -1 (errno being set) if
+    /// none could be received.
+    int receive(int sockfd, size_t count);
+
+    /// @brief Sends the datagrams of the first slots, in order.
+    ///
+    /// The slots must have been prepared with @ref prepareSend.
+    ///
+    /// @param sockfd socket descriptor.
+    /// @param count number of datagrams, capped by the size.
+    /// @return number of datagrams sent, stopping at the first one which
+    /// can't be sent, or -1 (errno being set) if none could be sent.
+    int send(int sockfd, size_t count);
+
+    /// @brief Returns the message header of a slot.
+    ///
+    /// @param slot slot index.
+    struct msghdr& getHeader(size_t slot);
+
+    /// @brief Returns the data buffer of a slot.
+    ///
+    /// @param slot slot index.
+    const uint8_t* getData(size_t slot) const {
+        return (&data_[slot * buffer_size_]);
+    }
+
+    /// @brief Returns the length of the datagram received or sent in a
+    /// slot.
+    ///
+    /// @param slot slot index.
+    size_t getLength(size_t slot) const;
+
+    /// @brief Returns the address a datagram was received from.
+    ///
+    /// @param slot slot index.
+    const struct sockaddr_storage& getName(size_t slot) const {
+        return (names_[slot]);
+    }
+
+private:
+
+    /// number of slots
+    size_t size_;
+
+    /// size of the data buffer of a slot
+    size_t buffer_size_;
+
+    /// size of the control messages area of a slot
+    size_t control_len_;
+
+    /// data buffers of the slots
+    std::vector<uint8_t> data_;
+
+    /// control messages areas of the slots
+    std::vector<uint8_t> control_;
+
+    /// addresses of the slots
+    std::vector<struct sockaddr_storage> names_;
+
+    /// data vectors of the slots
+    std::vector<struct iovec> iovs_;
+
+#if defined (OS_LINUX) && defined (MSG_WAITFORONE)
+    /// message headers of the slots, with the lengths of the datagrams
+    std::vector<struct mmsghdr> headers_;
+#else
+    /// message headers of the slots
+    std::vector<struct msghdr> headers_;
+
+    /// lengths of the datagrams received or sent in the slots
+    std::vector<size_t> lengths_;
+#endif
+};
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // PKT_BATCH_H
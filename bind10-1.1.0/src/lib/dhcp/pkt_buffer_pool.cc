@@ -0,0 +1,116 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcp/pkt_buffer_pool.h>
+
+using namespace isc::util;
+
+namespace isc {
+namespace dhcp {
+
+const size_t PktBufferPool::DEFAULT_BUFFER_SIZE;
+const size_t PktBufferPool::DEFAULT_MAX_POOLED;
+
+PktBufferPool::PktBufferPool(size_t buffer_size, size_t max_pooled)
+    : buffer_size_(buffer_size), max_pooled_(max_pooled),
+      allocated_count_(0) {
+    free_.reserve(max_pooled_);
+    spare_.reserve(max_pooled_);
+}
+
+OutputBufferPtr
+PktBufferPool::takeFree() {
+    if (free_.empty()) {
+        ++allocated_count_;
+        return (OutputBufferPtr(new OutputBuffer(buffer_size_)));
+    }
+    OutputBufferPtr holder = free_.back();
+    free_.pop_back();
+    holder->clear();
+    return (holder);
+}
+
+void
+PktBufferPool::keepSpare(const OutputBufferPtr& holder) {
+    // If buffers are acquired but never released, don't let the
+    // collection of spare objects grow without limit.
+    if (spare_.size() < max_pooled_) {
+        spare_.push_back(holder);
+    }
+}
+
+OutputBufferPtr
+PktBufferPool::takeSpare() {
+    if (spare_.empty()) {
+        return (OutputBufferPtr(new OutputBuffer(0)));
+    }
+    OutputBufferPtr holder = spare_.back();
+    spare_.pop_back();
+    holder->clear();
+    return (holder);
+}
+
+void
+PktBufferPool::acquire(OutputBuffer& buffer) {
+    OutputBufferPtr holder = takeFree();
+    buffer.swap(*holder);
+    keepSpare(holder);
+}
+
+void
+PktBufferPool::acquire(Pkt4& pkt) {
+    OutputBufferPtr holder = takeFree();
+    pkt.swapBuffer(*holder);
+    keepSpare(holder);
+}
+
+void
+PktBufferPool::acquire(Pkt6& pkt) {
+    OutputBufferPtr holder = takeFree();
+    pkt.swapBuffer(*holder);
+    keepSpare(holder);
+}
+
+void
+PktBufferPool::release(OutputBuffer& buffer) {
+    if (free_.size() >= max_pooled_) {
+        return;
+    }
+    OutputBufferPtr holder = takeSpare();
+    buffer.swap(*holder);
+    free_.push_back(holder);
+}
+
+void
+PktBufferPool::release(Pkt4& pkt) {
+    if (free_.size() >= max_pooled_) {
+        return;
+    }
+    OutputBufferPtr holder = takeSpare();
+    pkt.swapBuffer(*holder);
+    free_.push_back(holder);
+}
+
+void
+PktBufferPool::release(Pkt6& pkt) {
+    if (free_.size() >= max_pooled_) {
+        return;
+    }
+    OutputBufferPtr holder = takeSpare();
+    pkt.swapBuffer(*holder);
+    free_.push_back(holder);
+}
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
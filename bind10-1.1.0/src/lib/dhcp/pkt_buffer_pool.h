@@ -0,0 +1,158 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef PKT_BUFFER_POOL_H
+#define PKT_BUFFER_POOL_H
+
+#include <dhcp/pkt4.h>
+#include <dhcp/pkt6.h>
+#include <util/buffer.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Pool of pre-sized output buffers for outgoing packets.
+///
+/// Every Pkt4 and Pkt6 object owns an output buffer which grows (by
+/// reallocation) while the packet is being packed and is freed together
+/// with the packet. For a server that builds a response for every query
+/// this means several allocations per transaction. This pool keeps a
+/// number of buffers that are large enough to hold any typical DHCP
+/// message and hands them out to packets for the duration of a single
+/// transaction.
+///
+/// The buffer storage is exchanged with the packet's own buffer
+/// (see @ref isc::util::OutputBuffer::swap), so no data is copied and
+/// in the steady state no memory is allocated. A typical usage is:
+///
+/// @code
+/// pool.acquire(*rsp);
+/// rsp->pack();
+/// IfaceMgr::instance().send(rsp);
+/// pool.release(*rsp);
+/// @endcode
+///
+/// The pool is not thread safe. It is expected that each server thread
+/// uses its own pool.
+class PktBufferPool : public boost::noncopyable {
+public:
+
+    /// @brief Default size of a pooled buffer.
+    ///
+    /// This is large enough to hold any unfragmented packet sent over
+    /// Ethernet, including a DHCPv4 message encapsulated in DHCPv6.
+    static const size_t DEFAULT_BUFFER_SIZE = 1500;
+
+    /// @brief Default maximum number of buffers held by the pool.
+    static const size_t DEFAULT_MAX_POOLED = 16;
+
+    /// @brief Constructor.
+    ///
+    /// @param buffer_size size of the newly allocated buffers.
+    /// @param max_pooled maximum number of free buffers kept by the pool.
+    PktBufferPool(size_t buffer_size = DEFAULT_BUFFER_SIZE,
+                  size_t max_pooled = DEFAULT_MAX_POOLED);
+
+    /// @brief Hands out a pooled buffer to an output buffer.
+    ///
+    /// The storage of the specified buffer is replaced with an empty,
+    /// pre-sized pooled buffer. New buffer is allocated if the pool
+    /// is empty.
+    ///
+    /// @param buffer buffer to receive the pooled storage.
+    void acquire(isc::util::OutputBuffer& buffer);
+
+    /// @brief Hands out a pooled buffer to a DHCPv4 packet.
+    ///
+    /// @param pkt packet which output buffer should use pooled storage.
+    void acquire(Pkt4& pkt);
+
+    /// @brief Hands out a pooled buffer to a DHCPv6 packet.
+    ///
+    /// @param pkt packet which output buffer should use pooled storage.
+    void acquire(Pkt6& pkt);
+
+    /// @brief Returns the storage of an output buffer to the pool.
+    ///
+    /// The buffer is left with an empty storage. If the pool already holds
+    /// the maximum number of buffers, the storage is left in the buffer
+    /// and will be freed together with it.
+    ///
+    /// @param buffer buffer which storage is returned to the pool.
+    void release(isc::util::OutputBuffer& buffer);
+
+    /// @brief Returns the output buffer of a DHCPv4 packet to the pool.
+    ///
+    /// The packet must not be sent after this call as its on-wire data
+    /// is gone.
+    ///
+    /// @param pkt packet which output buffer is returned to the pool.
+    void release(Pkt4& pkt);
+
+    /// @brief Returns the output buffer of a DHCPv6 packet to the pool.
+    ///
+    /// The packet must not be sent after this call as its on-wire data
+    /// is gone.
+    ///
+    /// @param pkt packet which output buffer is returned to the pool.
+    void release(Pkt6& pkt);
+
+    /// @brief Returns number of free buffers held by the pool.
+    size_t getFreeCount() const { return (free_.size()); }
+
+    /// @brief Returns number of buffers allocated by the pool so far.
+    size_t getAllocatedCount() const { return (allocated_count_); }
+
+    /// @brief Returns the size of the newly allocated buffers.
+    size_t getBufferSize() const { return (buffer_size_); }
+
+private:
+
+    /// @brief Takes a free buffer from the pool or allocates a new one.
+    isc::util::OutputBufferPtr takeFree();
+
+    /// @brief Stores an exchanged buffer object for later reuse.
+    ///
+    /// @param holder buffer object holding the storage taken from a packet.
+    void keepSpare(const isc::util::OutputBufferPtr& holder);
+
+    /// @brief Takes an object to hold storage returned to the pool.
+    isc::util::OutputBufferPtr takeSpare();
+
+    /// Size of the newly allocated buffers.
+    size_t buffer_size_;
+
+    /// Maximum number of free buffers kept by the pool.
+    size_t max_pooled_;
+
+    /// Number of buffers allocated by the pool.
+    size_t allocated_count_;
+
+    /// Pre-sized buffers ready to be handed out.
+    std::vector<isc::util::OutputBufferPtr> free_;
+
+    /// Buffer objects holding the storage taken from packets. They are
+    /// reused to hold the storage returned to the pool, so as returning
+    /// a buffer does not require an allocation.
+    std::vector<isc::util::OutputBufferPtr> spare_;
+};
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
+
+#endif // PKT_BUFFER_POOL_H
@@ -16,6 +16,7 @@
 #define PKT_FILTER_H
 
 #include <asiolink/io_address.h>
+#include <dhcp/pkt4.h>
 
 namespace isc {
 namespace dhcp {
@@ -76,6 +77,50 @@ public:
     ///
     /// @return result of sending the packet. It is 0 if successful.
     virtual int send(uint16_t sockfd, const Pkt4Ptr& pkt) = 0;
+
+    /// @brief Receive the packets queued on specified socket.
+    ///
+    /// Packet filters able to read several packets with a single system
+    /// call override this method. The default implementation receives a
+    /// single packet with receive().
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param [out] pkts collection the received packets are appended to
+    /// @param max_count maximum number of packets to receive
+    ///
+    /// @return number of packets appended
+    virtual size_t receiveBatch(const Iface& iface,
+                                const SocketInfo& socket_info,
+                                Pkt4Collection& pkts, size_t /* max_count */) {
+        Pkt4Ptr pkt = receive(iface, socket_info);
+        if (!pkt) {
+            return (0);
+        }
+        pkts.push_back(pkt);
+        return (1);
+    }
+
+    /// @brief Send packets over specified socket.
+    ///
+    /// The packets from first to last (excluded) are sent in order. The
+    /// default implementation sends the first one with send(); packet
+    /// filters able to send several packets with a single system call
+    /// override this method.
+    ///
+    /// @param sockfd socket descriptor
+    /// @param pkts packets to be sent
+    /// @param first index of the first packet to be sent
+    /// @param last index past the last packet to be sent
+    ///
+    /// @return number of packets sent, at least one: it stops before the
+    /// first packet which can't be sent, if it isn't the first one.
+    /// @throw SocketWriteError if the first packet can't be sent
+    virtual size_t sendBatch(uint16_t sockfd, const Pkt4Collection& pkts,
+                             size_t first, size_t /* last */) {
+        send(sockfd, pkts[first]);
+        return (1);
+    }
 };
 
 } // namespace isc::dhcp
@@ -17,14 +17,17 @@
 #include <dhcp/pkt4.h>
 #include <dhcp/pkt_filter_inet.h>
 
+#include <algorithm>
+
 using namespace isc::asiolink;
 
 namespace isc {
 namespace dhcp {
 
 PktFilterInet::PktFilterInet()
-    : control_buf_len_(CMSG_SPACE(sizeof(struct in6_pktinfo))),
-      control_buf_(new char[control_buf_len_])
+    : control_buf_len_(CMSG_SPACE(sizeof(struct in6_pktinfo)) +
+                       CMSG_SPACE(sizeof(struct timeval))),
+      batch_(IfaceMgr::BATCH_SIZE, IfaceMgr::RCVBUFSIZE, control_buf_len_)
 {
 }
 
@@ -103,48 +106,61 @@ int PktFilterInet::openSocket(const Iface&,
     }
 #endif
 
+    // The time the kernel received the query tells how long it waited in
+    // the socket queue. It is read along the IP_PKTINFO (see receive());
+    // if it can't be enabled, the time the query is read is used.
+#if defined (SO_TIMESTAMP) && defined (OS_LINUX)
+    const int timestamp = 1;
+    setsockopt(sock, SOL_SOCKET, SO_TIMESTAMP, &timestamp, sizeof(timestamp));
+#endif
+
     return (sock);
 
 }
 
 Pkt4Ptr
 PktFilterInet::receive(const Iface& iface, const SocketInfo& socket_info) {
-    struct sockaddr_in from_addr;
-    uint8_t buf[IfaceMgr::RCVBUFSIZE];
-
-    memset(&control_buf_[0], 0, control_buf_len_);
-    memset(&from_addr, 0, sizeof(from_addr));
-
-    // Initialize our message header structure.
-    struct msghdr m;
-    memset(&m, 0, sizeof(m));
-
-    // Point so we can get the from address.
-    m.msg_name = &from_addr;
-    m.msg_namelen = sizeof(from_addr);
+    if (batch_.receive(socket_info.sockfd_, 1) < 0) {
+        isc_throw(SocketReadError, "failed to receive UDP4 data");
+    }
 
-    struct iovec v;
-    v.iov_base = static_cast<void*>(buf);
-    v.iov_len = IfaceMgr::RCVBUFSIZE;
-    m.msg_iov = &v;
-    m.msg_iovlen = 1;
+    return (createPacket(iface, socket_info, 0));
+}
 
-    // Getting the interface is a bit more involved.
-    //
-    // We set up some space for a "control message". We have
-    // previously asked the kernel to give us packet
-    // information (when we initialized the interface), so we
-    // should get the destination address from that.
-    m.msg_control = &control_buf_[0];
-    m.msg_controllen = control_buf_len_;
-
-    int result = recvmsg(socket_info.sockfd_, &m, 0);
+size_t
+PktFilterInet::receiveBatch(const Iface& iface, const SocketInfo& socket_info,
+                            Pkt4Collection& pkts, size_t max_count) {
+    const int result = batch_.receive(socket_info.sockfd_, max_count);
     if (result < 0) {
         isc_throw(SocketReadError, "failed to receive UDP4 data");
     }
 
+    size_t count = 0;
+    for (int slot = 0; slot < result; ++slot) {
+        try {
+            pkts.push_back(createPacket(iface, socket_info, slot));
+            ++count;
+        } catch (const isc::Exception&) {
+            // A bad datagram must not cost the others of the batch.
+            if (result == 1) {
+                throw;
+            }
+        }
+    }
+
+    return (count);
+}
+
+Pkt4Ptr
+PktFilterInet::createPacket(const Iface& iface, const SocketInfo& socket_info,
+                            size_t slot) {
+    struct msghdr& m = batch_.getHeader(slot);
+    const struct sockaddr_in& from_addr =
+        reinterpret_cast<const struct sockaddr_in&>(batch_.getName(slot));
+
     // We have all data let's create Pkt4 object.
-    Pkt4Ptr pkt = Pkt4Ptr(new Pkt4(buf, result));
+    Pkt4Ptr pkt = Pkt4Ptr(new Pkt4(batch_.getData(slot),
+                                   batch_.getLength(slot)));
 
     pkt->updateTimestamp();
 
@@ -180,7 +196,6 @@ PktFilterInet::receive(const Iface& iface, const SocketInfo& socket_info) {
 
             pkt->setIndex(pktinfo->ipi_ifindex);
             pkt->setLocalAddr(IOAddress(htonl(pktinfo->ipi_addr.s_addr)));
-            break;
 
             // This field is useful, when we are bound to unicast
             // address e.g. 192.0.2.1 and the packet was sent to
@@ -190,17 +205,26 @@ PktFilterInet::receive(const Iface& iface, const SocketInfo& socket_info) {
             // XXX: Perhaps we should uncomment this:
             // to_addr = pktinfo->ipi_spec_dst;
         }
+#if defined (SO_TIMESTAMP)
+        if ((cmsg->cmsg_level == SOL_SOCKET) &&
+            (cmsg->cmsg_type == SCM_TIMESTAMP)) {
+            struct timeval tv;
+            memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+            pkt->setTimestamp(boost::posix_time::from_time_t(tv.tv_sec) +
+                              boost::posix_time::microseconds(tv.tv_usec));
+        }
+#endif
         cmsg = CMSG_NXTHDR(&m, cmsg);
     }
+#else
+    static_cast<void>(m);
 #endif
 
     return (pkt);
 }
 
-int
-PktFilterInet::send(uint16_t sockfd, const Pkt4Ptr& pkt) {
-    memset(&control_buf_[0], 0, control_buf_len_);
-
+void
+PktFilterInet::prepareSend(size_t slot, const Pkt4Ptr& pkt) {
     // Set the target address we're sending to.
     sockaddr_in to;
     memset(&to, 0, sizeof(to));
@@ -208,23 +232,11 @@ PktFilterInet::send(uint16_t sockfd, const Pkt4Ptr& pkt) {
     to.sin_port = htons(pkt->getRemotePort());
     to.sin_addr.s_addr = htonl(pkt->getRemoteAddr());
 
-    struct msghdr m;
-    // Initialize our message header structure.
-    memset(&m, 0, sizeof(m));
-    m.msg_name = &to;
-    m.msg_namelen = sizeof(to);
-
-    // Set the data buffer we're sending. (Using this wacky
-    // "scatter-gather" stuff... we only have a single chunk
-    // of data to send, so we declare a single vector entry.)
-    struct iovec v;
-    memset(&v, 0, sizeof(v));
-    // iov_base field is of void * type. We use it for packet
-    // transmission, so this buffer will not be modified.
-    v.iov_base = const_cast<void *>(pkt->getBuffer().getData());
-    v.iov_len = pkt->getBuffer().getLength();
-    m.msg_iov = &v;
-    m.msg_iovlen = 1;
+    // The slot holds the data buffer of the packet, which is sent as a
+    // single chunk.
+    struct msghdr& m = batch_.prepareSend(slot, &to, sizeof(to),
+                                          pkt->getBuffer().getData(),
+                                          pkt->getBuffer().getLength());
 
 // In the future the OS-specific code may be abstracted to a different
 // file but for now we keep it here because there is no code yet, which
@@ -236,8 +248,6 @@ PktFilterInet::send(uint16_t sockfd, const Pkt4Ptr& pkt) {
     // define the IPv4 packet information. We could set the
     // source address if we wanted, but we can safely let the
     // kernel decide what that should be.
-    m.msg_control = &control_buf_[0];
-    m.msg_controllen = control_buf_len_;
     struct cmsghdr* cmsg = CMSG_FIRSTHDR(&m);
     cmsg->cmsg_level = IPPROTO_IP;
     cmsg->cmsg_type = IP_PKTINFO;
@@ -246,19 +256,41 @@ PktFilterInet::send(uint16_t sockfd, const Pkt4Ptr& pkt) {
     memset(pktinfo, 0, sizeof(struct in_pktinfo));
     pktinfo->ipi_ifindex = pkt->getIndex();
     m.msg_controllen = cmsg->cmsg_len;
+#else
+    m.msg_control = NULL;
+    m.msg_controllen = 0;
 #endif
+}
+
+int
+PktFilterInet::send(uint16_t sockfd, const Pkt4Ptr& pkt) {
+    prepareSend(0, pkt);
 
     pkt->updateTimestamp();
 
-    int result = sendmsg(sockfd, &m, 0);
-    if (result < 0) {
+    if (batch_.send(sockfd, 1) < 0) {
         isc_throw(SocketWriteError, "pkt4 send failed");
     }
 
-    return (result);
+    return (batch_.getLength(0));
 }
 
+size_t
+PktFilterInet::sendBatch(uint16_t sockfd, const Pkt4Collection& pkts,
+                         size_t first, size_t last) {
+    const size_t count = std::min(last - first, batch_.getSize());
+    for (size_t slot = 0; slot < count; ++slot) {
+        prepareSend(slot, pkts[first + slot]);
+        pkts[first + slot]->updateTimestamp();
+    }
 
+    const int result = batch_.send(sockfd, count);
+    if (result <= 0) {
+        isc_throw(SocketWriteError, "pkt4 send failed");
+    }
+
+    return (result);
+}
 
 } // end of isc::dhcp namespace
 } // end of isc namespace
@@ -15,6 +15,7 @@
 #ifndef PKT_FILTER_INET_H
 #define PKT_FILTER_INET_H
 
+#include <dhcp/pkt_batch.h>
 #include <dhcp/pkt_filter.h>
 
 namespace isc {
@@ -23,13 +24,15 @@ namespace dhcp {
 /// @brief Packet handling class using AF_INET socket family
 ///
 /// This class provides methods to send and recive packet via socket using
-/// AF_INET family and SOCK_DGRAM type.
+/// AF_INET family and SOCK_DGRAM type. The packets are received and sent
+/// through a @ref PktBatch, up to @ref IfaceMgr::BATCH_SIZE of them with
+/// a single system call.
 class PktFilterInet : public PktFilter {
 public:
 
     /// @brief Constructor
     ///
-    /// Allocates control buffer.
+    /// Allocates the buffers of the batch.
     PktFilterInet();
 
     /// @brief Open socket.
@@ -63,11 +66,55 @@ public:
     /// @return result of sending a packet. It is 0 if successful.
     virtual int send(uint16_t sockfd, const Pkt4Ptr& pkt);
 
+    /// @brief Receive the packets queued on specified socket.
+    ///
+    /// The datagrams too short to be DHCPv4 messages are dropped, unless
+    /// a single datagram is received: the error is then thrown like by
+    /// receive().
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param [out] pkts collection the received packets are appended to
+    /// @param max_count maximum number of packets to receive
+    ///
+    /// @return number of packets appended
+    virtual size_t receiveBatch(const Iface& iface,
+                                const SocketInfo& socket_info,
+                                Pkt4Collection& pkts, size_t max_count);
+
+    /// @brief Send packets over specified socket.
+    ///
+    /// @param sockfd socket descriptor
+    /// @param pkts packets to be sent
+    /// @param first index of the first packet to be sent
+    /// @param last index past the last packet to be sent
+    ///
+    /// @return number of packets sent, at least one.
+    /// @throw SocketWriteError if the first packet can't be sent
+    virtual size_t sendBatch(uint16_t sockfd, const Pkt4Collection& pkts,
+                             size_t first, size_t last);
+
 private:
-    /// Length of the control_buf_ array.
+    /// @brief Creates a packet from a datagram received in the batch.
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param slot slot of the batch holding the datagram
+    ///
+    /// @return Received packet
+    Pkt4Ptr createPacket(const Iface& iface, const SocketInfo& socket_info,
+                         size_t slot);
+
+    /// @brief Prepares a slot of the batch to send a packet.
+    ///
+    /// @param slot slot of the batch
+    /// @param pkt packet to be sent
+    void prepareSend(size_t slot, const Pkt4Ptr& pkt);
+
+    /// Length of the control messages area of a slot.
     size_t control_buf_len_;
-    /// Control buffer, used in transmission and reception.
-    boost::scoped_array<char> control_buf_;
+    /// Slots used in transmission and reception.
+    PktBatch batch_;
 };
 
 } // namespace isc::dhcp
@@ -0,0 +1,61 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+#include <dhcp/response_cache.h>
+
+namespace isc {
+namespace dhcp {
+
+ResponseCacheKey::ResponseCacheKey(const Pkt4& query)
+    : transid_(query.getTransid()), type_(query.getType()),
+      iface_(query.getIface()) {
+    OptionPtr client_id = query.getOption(DHO_DHCP_CLIENT_IDENTIFIER);
+    if (client_id) {
+        client_id_ = client_id->getData();
+    } else {
+        HWAddrPtr hwaddr = query.getHWAddr();
+        if (hwaddr) {
+            client_id_ = hwaddr->hwaddr_;
+            client_id_.push_back(hwaddr->htype_);
+        }
+    }
+}
+
+ResponseCacheKey::ResponseCacheKey(const Pkt6& query)
+    : transid_(query.getTransid()), type_(query.getType()),
+      iface_(query.getIface()) {
+    OptionPtr client_id = query.getOption(D6O_CLIENTID);
+    if (client_id) {
+        client_id_ = client_id->getData();
+    }
+}
+
+bool
+ResponseCacheKey::operator<(const ResponseCacheKey& other) const {
+    if (transid_ != other.transid_) {
+        return (transid_ < other.transid_);
+    }
+    if (type_ != other.type_) {
+        return (type_ < other.type_);
+    }
+    if (client_id_ != other.client_id_) {
+        return (client_id_ < other.client_id_);
+    }
+    return (iface_ < other.iface_);
+}
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
@@ -0,0 +1,280 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <dhcp/pkt4.h>
+#include <dhcp/pkt6.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Identifies a client transaction for the purpose of response caching.
+///
+/// Two queries having the same key are considered to be retransmissions
+/// of the same message.
+struct ResponseCacheKey {
+
+    /// @brief Creates a key for a DHCPv4 query.
+    ///
+    /// The client identifier option is used to identify the client. If it
+    /// is not present, the hardware address is used.
+    ///
+    /// @param query parsed DHCPv4 query.
+    explicit ResponseCacheKey(const Pkt4& query);
+
+    /// @brief Creates a key for a DHCPv6 query.
+    ///
+    /// The client is identified by the contents of the Client Identifier
+    /// option (DUID), if present.
+    ///
+    /// @param query parsed DHCPv6 query.
+    explicit ResponseCacheKey(const Pkt6& query);
+
+    /// @brief Compares keys (required by std::map).
+    bool operator<(const ResponseCacheKey& other) const;
+
+    /// @brief Transaction id.
+    uint32_t transid_;
+
+    /// @brief Message type.
+    uint8_t type_;
+
+    /// @brief Name of the interface on which the query was received.
+    std::string iface_;
+
+    /// @brief Client identifier.
+    std::vector<uint8_t> client_id_;
+};
+
+/// @brief Short-lived cache of responses sent by the server.
+///
+/// Clients retransmit their queries with the same transaction id when
+/// they don't get the response quickly enough. In particular, when the
+/// server has been unavailable for a while, a large number of clients
+/// retransmit at the same time. Processing every retransmission (subnet
+/// selection, lease allocation and lease database lookups) makes the
+/// server even slower, which causes more retransmissions.
+///
+/// This cache holds the responses sent within the last few seconds. If
+/// a query is a retransmission of the query for which the response is
+/// held, the cached response can be sent again, as is, without
+/// processing the query.
+///
+/// Responses are held for a configured time (window), measured using the
+/// reception timestamps of the queries. The number of held responses is
+/// also limited. If the limit is reached the oldest response is removed.
+/// Cached responses are held together with their on-wire data so the
+/// packets must not be modified by the caller after they are inserted.
+///
+/// @tparam PktPtrType pointer to the packet type, i.e. Pkt4Ptr or Pkt6Ptr.
+template<typename PktPtrType>
+class ResponseCache : public boost::noncopyable {
+public:
+
+    /// @brief Default maximum number of responses held.
+    static const size_t DEFAULT_MAX_ENTRIES = 4096;
+
+    /// @brief Constructor.
+    ///
+    /// @param window time (in milliseconds) for which responses are held.
+    /// Value of 0 disables caching.
+    /// @param max_entries maximum number of responses held.
+    ResponseCache(uint32_t window = 0,
+                  size_t max_entries = DEFAULT_MAX_ENTRIES)
+        : window_(boost::posix_time::milliseconds(window)),
+          max_entries_(max_entries), sequence_(0), hits_(0), misses_(0),
+          evictions_(0) {
+    }
+
+    /// @brief Sets the time for which responses are held.
+    ///
+    /// Changing the window removes all held responses.
+    ///
+    /// @param window time (in milliseconds), 0 disables caching.
+    void setWindow(uint32_t window) {
+        window_ = boost::posix_time::milliseconds(window);
+        clear();
+    }
+
+    /// @brief Returns the time (in milliseconds) for which responses are held.
+    uint32_t getWindow() const {
+        return (static_cast<uint32_t>(window_.total_milliseconds()));
+    }
+
+    /// @brief Checks if the cache is enabled.
+    bool isEnabled() const {
+        return ((window_.total_milliseconds() > 0) && (max_entries_ > 0));
+    }
+
+    /// @brief Finds the response sent to an earlier copy of the query.
+    ///
+    /// Responses older than the window (relative to the timestamp of the
+    /// query) are removed first.
+    ///
+    /// @param query parsed client's query.
+    /// @return cached response or NULL pointer if there is none.
+    template<typename QueryType>
+    PktPtrType lookup(const QueryType& query) {
+        if (!isEnabled()) {
+            return (PktPtrType());
+        }
+        expire(query.getTimestamp());
+        typename EntryMap::const_iterator it =
+            entries_.find(ResponseCacheKey(query));
+        if (it == entries_.end()) {
+            ++misses_;
+            return (PktPtrType());
+        }
+        ++hits_;
+        return (it->second.response_);
+    }
+
+    /// @brief Stores the response sent to the query.
+    ///
+    /// @param query parsed client's query.
+    /// @param response packed response sent to the client.
+    /// @return true if the response has been stored, false if the cache
+    /// is disabled.
+    template<typename QueryType>
+    bool insert(const QueryType& query, const PktPtrType& response) {
+        if (!isEnabled()) {
+            return (false);
+        }
+        while (entries_.size() >= max_entries_) {
+            removeOldest();
+        }
+        Entry entry;
+        entry.response_ = response;
+        entry.timestamp_ = query.getTimestamp();
+        entry.sequence_ = ++sequence_;
+        // If the query has been re-sent after its response expired, the
+        // new response replaces the expired one. The queue record of the
+        // old response is skipped during removal.
+        typename EntryMap::iterator it = entries_.insert(
+            std::make_pair(ResponseCacheKey(query), entry)).first;
+        it->second = entry;
+        queue_.push_back(QueueRecord(it, entry.sequence_));
+        return (true);
+    }
+
+    /// @brief Removes all held responses.
+    void clear() {
+        entries_.clear();
+        queue_.clear();
+    }
+
+    /// @brief Returns number of held responses.
+    size_t size() const { return (entries_.size()); }
+
+    /// @brief Returns number of queries for which a response was found.
+    uint64_t getHits() const { return (hits_); }
+
+    /// @brief Returns number of queries for which no response was found.
+    uint64_t getMisses() const { return (misses_); }
+
+    /// @brief Returns number of responses removed due to age or size limit.
+    uint64_t getEvictions() const { return (evictions_); }
+
+private:
+
+    /// @brief Cached response.
+    struct Entry {
+        /// Packed response.
+        PktPtrType response_;
+        /// Timestamp of the query for which the response was sent.
+        boost::posix_time::ptime timestamp_;
+        /// Insertion sequence number.
+        uint64_t sequence_;
+    };
+
+    /// @brief Container for cached responses.
+    typedef std::map<ResponseCacheKey, Entry> EntryMap;
+
+    /// @brief Record of the insertion order: entry and its sequence number.
+    typedef std::pair<typename EntryMap::iterator, uint64_t> QueueRecord;
+
+    /// @brief Removes entries which are older than the window.
+    ///
+    /// @param now current time.
+    void expire(const boost::posix_time::ptime& now) {
+        while (!queue_.empty()) {
+            const QueueRecord& record = queue_.front();
+            if ((record.first->second.sequence_ == record.second) &&
+                (now - record.first->second.timestamp_ <= window_)) {
+                return;
+            }
+            removeOldest();
+        }
+    }
+
+    /// @brief Removes the entry which has been inserted first.
+    void removeOldest() {
+        const QueueRecord record = queue_.front();
+        queue_.pop_front();
+        // Record may refer to the entry which has been replaced.
+        if (record.first->second.sequence_ == record.second) {
+            entries_.erase(record.first);
+            ++evictions_;
+        }
+    }
+
+    /// Time for which responses are held.
+    boost::posix_time::time_duration window_;
+
+    /// Maximum number of held responses.
+    size_t max_entries_;
+
+    /// Sequence number of the last inserted entry.
+    uint64_t sequence_;
+
+    /// Cached responses.
+    EntryMap entries_;
+
+    /// Entries in the order of insertion (which is also the order in which
+    /// they expire).
+    std::deque<QueueRecord> queue_;
+
+    /// Number of cache hits.
+    uint64_t hits_;
+
+    /// Number of cache misses.
+    uint64_t misses_;
+
+    /// Number of removed responses.
+    uint64_t evictions_;
+};
+
+template<typename PktPtrType>
+const size_t ResponseCache<PktPtrType>::DEFAULT_MAX_ENTRIES;
+
+/// @brief Cache of DHCPv4 responses.
+typedef ResponseCache<Pkt4Ptr> ResponseCache4;
+
+/// @brief Cache of DHCPv6 responses.
+typedef ResponseCache<Pkt6Ptr> ResponseCache6;
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
+
+#endif // RESPONSE_CACHE_H
@@ -0,0 +1,328 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcp/shm_ring.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+/// Length of the message header.
+const uint32_t LEN_SIZE = sizeof(uint32_t);
+
+/// Length marking the end of the data area.
+const uint32_t WRAP_MARKER = 0xffffffff;
+
+/// @brief Returns the size of the record of a message.
+uint32_t
+recordLen(size_t len) {
+    return ((LEN_SIZE + len + 7) & ~7U);
+}
+
+/// @brief Header of the file of a channel.
+struct ChannelHeader {
+    /// Identifies the file as a channel.
+    uint32_t magic_;
+    /// Layout of the file.
+    uint32_t version_;
+    /// Size of each ring.
+    uint32_t capacity_;
+    /// Set by the DHCPv4 server when it stops.
+    volatile uint32_t closed_;
+    /// Padding up to the next cache line.
+    uint8_t pad_[48];
+};
+
+const uint32_t CHANNEL_MAGIC = 0x346f3652; // "4o6R"
+const uint32_t CHANNEL_VERSION = 1;
+
+/// @brief Returns the size of the file of a channel.
+size_t
+channelSize(uint32_t capacity) {
+    return (sizeof(ChannelHeader) + 2 * sizeof(isc::dhcp::ShmRing::Control) +
+            2 * static_cast<size_t>(capacity));
+}
+
+/// @brief Checks that a ring capacity is valid.
+bool
+validCapacity(uint32_t capacity) {
+    return ((capacity >= 64) && (capacity <= (1U << 30)) &&
+            ((capacity & (capacity - 1)) == 0));
+}
+
+}
+
+namespace isc {
+namespace dhcp {
+
+const uint32_t Shm4o6Channel::DEFAULT_CAPACITY;
+
+ShmRing::ShmRing(Control* control, uint8_t* data, uint32_t capacity)
+    : control_(control), data_(data), capacity_(capacity), front_len_(0) {
+    if (!validCapacity(capacity)) {
+        isc_throw(BadValue, "invalid ring capacity " << capacity
+                  << ", must be a power of two between 64 and 2^30");
+    }
+}
+
+bool
+ShmRing::push(const uint8_t* data, size_t len) {
+    if (len > getMaxMessageLen()) {
+        isc_throw(BadValue, "message of " << len << " bytes doesn't fit"
+                  " in the ring, maximum is " << getMaxMessageLen());
+    }
+    const uint32_t head = control_->head_;
+    const uint32_t tail = control_->tail_;
+    // The consumer must be done with the space before it is overwritten.
+    __sync_synchronize();
+
+    const uint32_t record = recordLen(len);
+    uint32_t offset = head & (capacity_ - 1);
+    uint32_t skip = 0;
+    if (record > capacity_ - offset) {
+        // The rest of the data area is skipped.
+        skip = capacity_ - offset;
+    }
+    if (skip + record > capacity_ - (head - tail)) {
+        return (false);
+    }
+    if (skip > 0) {
+        memcpy(data_ + offset, &WRAP_MARKER, LEN_SIZE);
+        offset = 0;
+    }
+    const uint32_t len32 = static_cast<uint32_t>(len);
+    memcpy(data_ + offset, &len32, LEN_SIZE);
+    memcpy(data_ + offset + LEN_SIZE, data, len);
+
+    // The message must be complete before the consumer sees it.
+    __sync_synchronize();
+    control_->head_ = head + skip + record;
+    // The consumer may have started waiting in the meantime; the waiting
+    // flag is read after the new head is visible.
+    __sync_synchronize();
+    return (true);
+}
+
+const uint8_t*
+ShmRing::front(size_t& len) {
+    uint32_t tail = control_->tail_;
+    const uint32_t head = control_->head_;
+    // The message must not be read before the head is.
+    __sync_synchronize();
+
+    len = 0;
+    front_len_ = 0;
+    if (head == tail) {
+        return (NULL);
+    }
+    uint32_t offset = tail & (capacity_ - 1);
+    uint32_t msg_len;
+    memcpy(&msg_len, data_ + offset, LEN_SIZE);
+    if (msg_len == WRAP_MARKER) {
+        tail += capacity_ - offset;
+        offset = 0;
+        if (head == tail) {
+            // The producer doesn't skip the end without writing a message.
+            control_->tail_ = head;
+            return (NULL);
+        }
+        memcpy(&msg_len, data_, LEN_SIZE);
+    }
+    // The other process may be broken; a record running past the head
+    // or the end of the data area empties the ring.
+    if ((msg_len > getMaxMessageLen()) ||
+        (recordLen(msg_len) > head - tail) ||
+        (recordLen(msg_len) > capacity_ - offset)) {
+        control_->tail_ = head;
+        return (NULL);
+    }
+    // The consumer owns the tail, so the skipped end can be released now.
+    if (tail != control_->tail_) {
+        __sync_synchronize();
+        control_->tail_ = tail;
+    }
+    front_len_ = recordLen(msg_len);
+    len = msg_len;
+    return (data_ + offset + LEN_SIZE);
+}
+
+void
+ShmRing::pop() {
+    if (front_len_ == 0) {
+        return;
+    }
+    // The message must be copied before the producer may overwrite it.
+    __sync_synchronize();
+    control_->tail_ = control_->tail_ + front_len_;
+    front_len_ = 0;
+}
+
+bool
+ShmRing::empty() const {
+    return (control_->head_ == control_->tail_);
+}
+
+bool
+ShmRing::setWaiting(bool waiting) {
+    control_->waiting_ = waiting ? 1 : 0;
+    // The flag must be visible to the producer before the head is read
+    // again, so either the consumer sees a new message or the producer
+    // sees the flag.
+    __sync_synchronize();
+    return (empty());
+}
+
+bool
+ShmRing::isWaiting() const {
+    return (control_->waiting_ != 0);
+}
+
+Shm4o6Channel::Shm4o6Channel(const std::string& path, int fd, bool creator)
+    : path_(path), fd_(fd), creator_(creator), base_(NULL), size_(0) {
+    struct stat st;
+    if (fstat(fd_, &st) < 0) {
+        const int error = errno;
+        close(fd_);
+        isc_throw(ShmChannelError, "failed to check 4o6 channel file "
+                  << path_ << ": " << strerror(error));
+    }
+    size_ = st.st_size;
+    if (size_ < sizeof(ChannelHeader)) {
+        close(fd_);
+        isc_throw(ShmChannelError, "4o6 channel file " << path_
+                  << " is truncated");
+    }
+    void* base = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+        const int error = errno;
+        close(fd_);
+        isc_throw(ShmChannelError, "failed to map 4o6 channel file "
+                  << path_ << ": " << strerror(error));
+    }
+    base_ = static_cast<uint8_t*>(base);
+
+    const ChannelHeader* header = reinterpret_cast<ChannelHeader*>(base_);
+    if ((header->magic_ != CHANNEL_MAGIC) ||
+        (header->version_ != CHANNEL_VERSION) ||
+        !validCapacity(header->capacity_) ||
+        (channelSize(header->capacity_) != size_)) {
+        munmap(base_, size_);
+        close(fd_);
+        isc_throw(ShmChannelError, "invalid 4o6 channel file " << path_);
+    }
+
+    const uint32_t capacity = header->capacity_;
+    ShmRing::Control* controls =
+        reinterpret_cast<ShmRing::Control*>(base_ + sizeof(ChannelHeader));
+    uint8_t* data = base_ + sizeof(ChannelHeader) + 2 * sizeof(ShmRing::Control);
+    boost::shared_ptr<ShmRing> queries(new ShmRing(&controls[0], data,
+                                                   capacity));
+    boost::shared_ptr<ShmRing> responses(new ShmRing(&controls[1],
+                                                     data + capacity,
+                                                     capacity));
+    inbound_ = creator_ ? queries : responses;
+    outbound_ = creator_ ? responses : queries;
+}
+
+Shm4o6Channel::~Shm4o6Channel() {
+    if (creator_) {
+        __sync_synchronize();
+        reinterpret_cast<ChannelHeader*>(base_)->closed_ = 1;
+        __sync_synchronize();
+        // Don't remove the file of a newer instance.
+        struct stat mine;
+        struct stat current;
+        if ((fstat(fd_, &mine) == 0) && (stat(path_.c_str(), &current) == 0) &&
+            (mine.st_dev == current.st_dev) &&
+            (mine.st_ino == current.st_ino)) {
+            unlink(path_.c_str());
+        }
+    }
+    munmap(base_, size_);
+    close(fd_);
+}
+
+Shm4o6ChannelPtr
+Shm4o6Channel::create(const std::string& path, uint32_t capacity) {
+    if (!validCapacity(capacity)) {
+        isc_throw(BadValue, "invalid ring capacity " << capacity
+                  << ", must be a power of two between 64 and 2^30");
+    }
+    // The file is set up under another name, so the DHCPv6 server never
+    // opens a partially initialized file.
+    const std::string tmp_path = path + ".new";
+    const int fd = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        isc_throw(ShmChannelError, "failed to create 4o6 channel file "
+                  << tmp_path << ": " << strerror(errno));
+    }
+    ChannelHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic_ = CHANNEL_MAGIC;
+    header.version_ = CHANNEL_VERSION;
+    header.capacity_ = capacity;
+    // The rest of the file reads as zeros: both rings are empty.
+    if ((ftruncate(fd, channelSize(capacity)) < 0) ||
+        (pwrite(fd, &header, sizeof(header), 0) !=
+         static_cast<ssize_t>(sizeof(header)))) {
+        const int error = errno;
+        close(fd);
+        unlink(tmp_path.c_str());
+        isc_throw(ShmChannelError, "failed to initialize 4o6 channel file "
+                  << tmp_path << ": " << strerror(error));
+    }
+    Shm4o6ChannelPtr channel;
+    try {
+        channel.reset(new Shm4o6Channel(path, fd, true));
+    } catch (...) {
+        unlink(tmp_path.c_str());
+        throw;
+    }
+    if (rename(tmp_path.c_str(), path.c_str()) < 0) {
+        const int error = errno;
+        unlink(tmp_path.c_str());
+        isc_throw(ShmChannelError, "failed to create 4o6 channel file "
+                  << path << ": " << strerror(error));
+    }
+    return (channel);
+}
+
+Shm4o6ChannelPtr
+Shm4o6Channel::open(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        isc_throw(ShmChannelError, "failed to open 4o6 channel file "
+                  << path << ": " << strerror(errno));
+    }
+    return (Shm4o6ChannelPtr(new Shm4o6Channel(path, fd, false)));
+}
+
+std::string
+Shm4o6Channel::getPath(const std::string& dir,
+                       const std::string& socket_name) {
+    return (dir + "/" + socket_name + ".4o6");
+}
+
+bool
+Shm4o6Channel::isClosed() const {
+    return (reinterpret_cast<const ChannelHeader*>(base_)->closed_ != 0);
+}
+
+} // namespace isc::dhcp
+} // namespace isc
@@ -0,0 +1,232 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <exceptions/exceptions.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Exception thrown when a shared memory channel can't be set up.
+class ShmChannelError : public Exception {
+public:
+    ShmChannelError(const char* file, size_t line, const char* what) :
+        isc::Exception(file, line, what) { };
+};
+
+/// @brief Single-producer, single-consumer ring of messages.
+///
+/// The ring passes variable length messages from one process to another
+/// through shared memory, without locks and without system calls: the
+/// producer owns the head position and the consumer owns the tail
+/// position, each of them only reading the position of the other.
+///
+/// A message is stored as its 32 bit length followed by its data, padded
+/// to 8 bytes. A message which doesn't fit before the end of the data area
+/// is preceded by a marker sending the consumer back to the beginning, so
+/// each message is contiguous and is copied only once on each side.
+///
+/// The consumer sets the waiting flag before it blocks in select(); the
+/// producer checks it after each message and wakes the consumer up
+/// through a socket only when it is set (see @ref IfaceMgr).
+class ShmRing {
+public:
+    /// @brief Positions of the ring, shared by both processes.
+    ///
+    /// The positions count the bytes since the ring was created (modulo
+    /// 2^32); they are on separate cache lines so the producer and the
+    /// consumer don't invalidate each other's cache on each message.
+    struct Control {
+        /// Position where the producer writes the next message.
+        volatile uint32_t head_;
+        /// Padding up to the next cache line.
+        uint8_t pad1_[60];
+        /// Position of the next message for the consumer.
+        volatile uint32_t tail_;
+        /// Non-zero when the consumer is about to block.
+        volatile uint32_t waiting_;
+        /// Padding up to the next cache line.
+        uint8_t pad2_[56];
+    };
+
+    /// @brief Constructor.
+    ///
+    /// The ring doesn't own the memory. A new ring must have its control
+    /// block zeroed.
+    ///
+    /// @param control positions of the ring.
+    /// @param data data area.
+    /// @param capacity size of the data area, a power of two between
+    /// 64 bytes and 1GB.
+    /// @throw isc::BadValue if the capacity is invalid.
+    ShmRing(Control* control, uint8_t* data, uint32_t capacity);
+
+    /// @brief Returns the maximum length of a message.
+    size_t getMaxMessageLen() const {
+        return (capacity_ / 4);
+    }
+
+    /// @brief Appends a message (producer).
+    ///
+    /// @param data message data.
+    /// @param len message length.
+    /// @return false if there is no room for the message.
+    /// @throw isc::BadValue if the message is longer than the maximum.
+    bool push(const uint8_t* data, size_t len);
+
+    /// @brief Returns the oldest message (consumer).
+    ///
+    /// The message stays in the ring until @ref pop is called.
+    ///
+    /// @param [out] len length of the message.
+    /// @return pointer to the message data, or NULL if the ring is empty.
+    /// A corrupted ring is emptied.
+    const uint8_t* front(size_t& len);
+
+    /// @brief Removes the message returned by @ref front (consumer).
+    void pop();
+
+    /// @brief Checks if the ring has no message.
+    bool empty() const;
+
+    /// @brief Announces that the consumer blocks, or is awake (consumer).
+    ///
+    /// @param waiting true before the consumer blocks.
+    /// @return true if the ring is empty, i.e. the consumer may block.
+    bool setWaiting(bool waiting);
+
+    /// @brief Checks if the consumer must be woken up (producer).
+    bool isWaiting() const;
+
+private:
+    /// Positions of the ring.
+    Control* control_;
+    /// Data area.
+    uint8_t* data_;
+    /// Size of the data area.
+    uint32_t capacity_;
+    /// Length of the record returned by front(), 0 if none.
+    uint32_t front_len_;
+};
+
+/// @brief Pair of shared memory rings between the DHCPv6 and DHCPv4 servers.
+///
+/// 4o6: the channel is a memory-mapped file holding the ring of the
+/// DHCPv4-queries (DHCPv6 server to DHCPv4 server) and the ring of the
+/// responses (back). The DHCPv4 server creates the file when it starts and
+/// removes it when it stops; the DHCPv6 server opens it. Each side reads
+/// its inbound ring and writes its outbound ring.
+///
+/// The file is mapped directly rather than through
+/// @ref isc::util::MemorySegmentMapped: the latter takes an exclusive lock
+/// on the file for a writer, and both servers write to the channel.
+class Shm4o6Channel : public boost::noncopyable {
+public:
+    /// @brief Default size of each ring.
+    static const uint32_t DEFAULT_CAPACITY = 1 << 20;
+
+    /// @brief Creates a channel (DHCPv4 server).
+    ///
+    /// An existing file is replaced, so the DHCPv6 server doesn't use the
+    /// rings of a previous instance.
+    ///
+    /// @param path name of the file.
+    /// @param capacity size of each ring.
+    /// @throw ShmChannelError if the file can't be created.
+    /// @throw isc::BadValue if the capacity is invalid.
+    static boost::shared_ptr<Shm4o6Channel>
+    create(const std::string& path, uint32_t capacity = DEFAULT_CAPACITY);
+
+    /// @brief Opens a channel created by the DHCPv4 server (DHCPv6 server).
+    ///
+    /// @param path name of the file.
+    /// @throw ShmChannelError if the file doesn't exist or is invalid.
+    static boost::shared_ptr<Shm4o6Channel> open(const std::string& path);
+
+    /// @brief Returns the name of the file of a channel.
+    ///
+    /// @param dir directory of the file.
+    /// @param socket_name name of the 4o6 socket of the DHCPv4 server.
+    static std::string getPath(const std::string& dir,
+                               const std::string& socket_name);
+
+    /// @brief Destructor.
+    ///
+    /// The DHCPv4 server marks the channel as closed and removes the file.
+    ~Shm4o6Channel();
+
+    /// @brief Returns the ring of the messages to this process.
+    ShmRing& getInbound() {
+        return (*inbound_);
+    }
+
+    /// @brief Returns the ring of the messages from this process.
+    ShmRing& getOutbound() {
+        return (*outbound_);
+    }
+
+    /// @brief Checks if the DHCPv4 server has closed the channel.
+    bool isClosed() const;
+
+    /// @brief Checks if the channel was created by this process.
+    bool isCreator() const {
+        return (creator_);
+    }
+
+    /// @brief Returns the name of the file.
+    const std::string& getPathName() const {
+        return (path_);
+    }
+
+private:
+    /// @brief Constructor.
+    ///
+    /// @param path name of the file.
+    /// @param fd open file.
+    /// @param creator true if the channel is created by this process.
+    Shm4o6Channel(const std::string& path, int fd, bool creator);
+
+    /// Name of the file.
+    std::string path_;
+    /// Open file.
+    int fd_;
+    /// Is the channel created by this process.
+    bool creator_;
+    /// Mapped file.
+    uint8_t* base_;
+    /// Size of the mapping.
+    size_t size_;
+    /// Ring of the messages to this process.
+    boost::shared_ptr<ShmRing> inbound_;
+    /// Ring of the messages from this process.
+    boost::shared_ptr<ShmRing> outbound_;
+};
+
+/// @brief Pointer to a shared memory channel.
+typedef boost::shared_ptr<Shm4o6Channel> Shm4o6ChannelPtr;
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // SHM_RING_H
@@ -20,6 +20,7 @@
 #include <dhcp/pkt6.h>
 #include <dhcp/pkt_filter.h>
 
+#include <boost/bind.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
 
@@ -105,6 +106,46 @@ class NakedIfaceMgr: public IfaceMgr {
 public:
     NakedIfaceMgr() { }
     IfaceCollection & getIfacesLst() { return ifaces_; }
+    void setPort4(uint16_t port) { port4_ = port; }
+    void setIfaceCallback(const IfaceChangeCallback& callback) {
+        iface_callback_ = callback;
+    }
+    using IfaceMgr::openIfaceSockets;
+    using IfaceMgr::updateIfaces;
+};
+
+/// Opens real sockets, which are not bound, and counts them.
+class CountingPktFilter : public PktFilter {
+public:
+
+    /// Constructor
+    CountingPktFilter()
+        : opened_(0) {
+    }
+
+    /// Opens an unbound UDP socket.
+    virtual int openSocket(const Iface&,
+                           const isc::asiolink::IOAddress&,
+                           const uint16_t,
+                           const bool,
+                           const bool) {
+        ++opened_;
+        return (socket(AF_INET, SOCK_DGRAM, 0));
+    }
+
+    /// Does nothing
+    virtual Pkt4Ptr receive(const Iface&,
+                            const SocketInfo&) {
+        return (Pkt4Ptr());
+    }
+
+    /// Does nothing
+    virtual int send(uint16_t, const Pkt4Ptr&) {
+        return (0);
+    }
+
+    /// Number of sockets opened.
+    int opened_;
 };
 
 // dummy class for now, but this will be expanded when needed
@@ -807,6 +848,101 @@ TEST_F(IfaceMgrTest, sendReceive4) {
     EXPECT_THROW(ifacemgr->send(sendPkt), SocketWriteError);
 }
 
+// Verifies that the packets sent together are received together, in order.
+TEST_F(IfaceMgrTest, sendReceiveBatch6) {
+    boost::scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+
+    int socket1 = 0;
+    EXPECT_NO_THROW(
+        socket1 = ifacemgr->openSocket(LOOPBACK, IOAddress("::1"), 10547);
+    );
+    EXPECT_GT(socket1, 0);
+
+    Pkt6Collection sent_pkts;
+    for (uint32_t transid = 1; transid <= 3; ++transid) {
+        Pkt6Ptr pkt(new Pkt6(DHCPV6_SOLICIT, transid));
+        ASSERT_TRUE(pkt->pack());
+        pkt->setRemotePort(10547);
+        pkt->setRemoteAddr(IOAddress("::1"));
+        pkt->setIndex(1);
+        pkt->setIface(LOOPBACK);
+        sent_pkts.push_back(pkt);
+    }
+
+    size_t sent = 0;
+    ASSERT_NO_THROW(ifacemgr->sendBatch(sent_pkts, sent));
+    EXPECT_EQ(3, sent);
+
+    // The first packet is returned by receive6(), the others are then
+    // returned by receiveBatch6() without waiting.
+    Pkt6Ptr pkt = ifacemgr->receive6(10);
+    ASSERT_TRUE(pkt);
+    ASSERT_TRUE(pkt->unpack());
+    EXPECT_EQ(1, pkt->getTransid());
+
+    Pkt6Collection received;
+    ASSERT_EQ(2, ifacemgr->receiveBatch6(received, 10));
+    ASSERT_EQ(2, received.size());
+    for (size_t i = 0; i < received.size(); ++i) {
+        ASSERT_TRUE(received[i]->unpack());
+        EXPECT_EQ(i + 2, received[i]->getTransid());
+        EXPECT_EQ("::1", received[i]->getRemoteAddr().toText());
+        EXPECT_EQ(LOOPBACK, received[i]->getIface());
+    }
+
+    // Nothing more to receive.
+    received.clear();
+    EXPECT_EQ(0, ifacemgr->receiveBatch6(received, 0, 1000));
+    EXPECT_TRUE(received.empty());
+}
+
+// Verifies that the packets sent together are received together, in order.
+TEST_F(IfaceMgrTest, sendReceiveBatch4) {
+    boost::scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+
+    int socket1 = 0;
+    EXPECT_NO_THROW(
+        socket1 = ifacemgr->openSocket(LOOPBACK, IOAddress("127.0.0.1"),
+                                       DHCP4_SERVER_PORT + 10000);
+    );
+    EXPECT_GE(socket1, 0);
+
+    Pkt4Collection sent_pkts;
+    for (uint32_t transid = 1; transid <= 3; ++transid) {
+        Pkt4Ptr pkt(new Pkt4(DHCPDISCOVER, transid));
+        pkt->setLocalAddr(IOAddress("127.0.0.1"));
+        pkt->setRemotePort(DHCP4_SERVER_PORT + 10000);
+        pkt->setRemoteAddr(IOAddress("127.0.0.1"));
+        pkt->setIndex(1);
+        pkt->setIface(LOOPBACK);
+        ASSERT_NO_THROW(pkt->pack());
+        sent_pkts.push_back(pkt);
+    }
+
+    size_t sent = 0;
+    ASSERT_NO_THROW(ifacemgr->sendBatch(sent_pkts, sent));
+    EXPECT_EQ(3, sent);
+
+    Pkt4Collection received;
+    ASSERT_EQ(3, ifacemgr->receiveBatch4(received, 10));
+    ASSERT_EQ(3, received.size());
+    for (size_t i = 0; i < received.size(); ++i) {
+        ASSERT_NO_THROW(received[i]->unpack());
+        EXPECT_EQ(i + 1, received[i]->getTransid());
+        EXPECT_EQ("127.0.0.1", received[i]->getRemoteAddr().toText());
+        EXPECT_EQ(DHCP4_SERVER_PORT + 10000, received[i]->getLocalPort());
+    }
+
+    // The packets aren't received again.
+    EXPECT_FALSE(ifacemgr->receive4(0, 1000));
+
+    // The packet which couldn't be sent is reported.
+    close(socket1);
+    sent = 10;
+    EXPECT_THROW(ifacemgr->sendBatch(sent_pkts, sent), SocketWriteError);
+    EXPECT_EQ(0, sent);
+}
+
 // Verifies that it is possible to set custom packet filter object
 // to handle sockets opening and send/receive operation.
 TEST_F(IfaceMgrTest, setPacketFilter) {
@@ -1367,4 +1503,203 @@ TEST_F(IfaceMgrTest, controlSession) {
     close(pipefd[0]);
 }
 
+int timer_calls;
+
+void timer_callback(void) {
+    ++timer_calls;
+}
+
+TEST_F(IfaceMgrTest, timers) {
+    // tests that the receive methods wait only until the next timer
+    // expires and run the expired timers.
+    using namespace boost::posix_time;
+
+    timer_calls = 0;
+
+    boost::scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+    ifacemgr->getTimerMgr().schedule(100, timer_callback);
+
+    // The timer ends the wait much earlier than the 10s timeout.
+    ptime start_time = microsec_clock::universal_time();
+    Pkt6Ptr pkt6;
+    ASSERT_NO_THROW(pkt6 = ifacemgr->receive6(10));
+    time_duration duration = microsec_clock::universal_time() - start_time;
+    EXPECT_FALSE(pkt6);
+    EXPECT_EQ(1, timer_calls);
+    EXPECT_GE(duration.total_microseconds(), 100000 - TIMEOUT_TOLERANCE);
+    EXPECT_LE(duration.total_microseconds(), 1000000);
+
+    // A timer which is due is run before waiting for packets.
+    ifacemgr->getTimerMgr().schedule(0, timer_callback);
+    usleep(20000);
+    Pkt4Ptr pkt4;
+    ASSERT_NO_THROW(pkt4 = ifacemgr->receive4(0, 1000));
+    EXPECT_FALSE(pkt4);
+    EXPECT_EQ(2, timer_calls);
+    EXPECT_EQ(0, ifacemgr->getTimerMgr().size());
+}
+
+
+int external_calls;
+
+/// @brief Callback of an external socket: reads the data.
+void external_callback(int fd) {
+    char buf[64];
+    if (read(fd, buf, sizeof(buf)) > 0) {
+        ++external_calls;
+    }
+}
+
+TEST_F(IfaceMgrTest, externalSockets) {
+    // tests that the callbacks of the external sockets are called by
+    // the receive methods when there is data.
+    external_calls = 0;
+
+    boost::scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+
+    int pipefd[2];
+    ASSERT_EQ(0, pipe(pipefd));
+    EXPECT_THROW(ifacemgr->addExternalSocket(-1,
+                     boost::bind(external_callback, pipefd[0])), BadValue);
+    EXPECT_THROW(ifacemgr->addExternalSocket(pipefd[0],
+                                             IfaceMgr::SocketCallback()),
+                 BadValue);
+    ASSERT_NO_THROW(ifacemgr->addExternalSocket(pipefd[0],
+                        boost::bind(external_callback, pipefd[0])));
+
+    Pkt4Ptr pkt4;
+    ASSERT_NO_THROW(pkt4 = ifacemgr->receive4(0, 1000));
+    EXPECT_FALSE(pkt4);
+    EXPECT_EQ(0, external_calls);
+
+    ASSERT_EQ(1, write(pipefd[1], "x", 1));
+    ASSERT_NO_THROW(pkt4 = ifacemgr->receive4(1));
+    EXPECT_FALSE(pkt4);
+    EXPECT_EQ(1, external_calls);
+
+    ASSERT_EQ(1, write(pipefd[1], "x", 1));
+    Pkt6Ptr pkt6;
+    ASSERT_NO_THROW(pkt6 = ifacemgr->receive6(1));
+    EXPECT_FALSE(pkt6);
+    EXPECT_EQ(2, external_calls);
+
+    // A removed socket is not watched anymore.
+    ifacemgr->deleteExternalSocket(pipefd[0]);
+    ASSERT_EQ(1, write(pipefd[1], "x", 1));
+    ASSERT_NO_THROW(pkt4 = ifacemgr->receive4(0, 1000));
+    EXPECT_EQ(2, external_calls);
+
+    close(pipefd[1]);
+    close(pipefd[0]);
+}
+
+/// @brief Creates an interface which is up, with one address.
+Iface createIface(const std::string& name, int index, const char* addr) {
+    Iface iface(name, index);
+    iface.flag_up_ = true;
+    iface.flag_running_ = true;
+    iface.addAddress(IOAddress(addr));
+    return (iface);
+}
+
+vector<string> iface_changes;
+
+/// @brief Interface change callback: records the changes.
+void iface_change_callback(const string& name, IfaceMgr::IfaceChange change,
+                           const string& error) {
+    ostringstream tmp;
+    tmp << name << "/" << change;
+    if (!error.empty()) {
+        tmp << "/error";
+    }
+    iface_changes.push_back(tmp.str());
+}
+
+TEST_F(IfaceMgrTest, updateIfaces) {
+    // tests that the interfaces detected again only get new sockets
+    // when they are new or changed.
+    iface_changes.clear();
+
+    boost::scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+    boost::shared_ptr<CountingPktFilter> filter(new CountingPktFilter());
+    ASSERT_NO_THROW(ifacemgr->setPacketFilter(filter));
+    ifacemgr->setIfaceCallback(iface_change_callback);
+    ifacemgr->setPort4(PORT2);
+
+    IfaceMgr::IfaceCollection& ifaces = ifacemgr->getIfacesLst();
+    ifaces.clear();
+    ifaces.push_back(createIface("eth0", 1, "192.0.2.1"));
+    ifaces.push_back(createIface("eth1", 2, "192.0.2.2"));
+    ifaces.push_back(createIface("eth2", 3, "192.0.2.3"));
+    for (IfaceMgr::IfaceCollection::iterator iface = ifaces.begin();
+         iface != ifaces.end(); ++iface) {
+        ASSERT_NO_THROW(ifacemgr->openIfaceSockets(*iface));
+    }
+    ASSERT_EQ(3, filter->opened_);
+    const int eth0_sock =
+        ifacemgr->getIface("eth0")->getSockets().front().sockfd_;
+
+    // eth0 is the same, eth1 has a new address, eth2 is gone and eth3
+    // appeared.
+    IfaceMgr::IfaceCollection detected;
+    detected.push_back(createIface("eth0", 1, "192.0.2.1"));
+    detected.push_back(createIface("eth1", 2, "192.0.2.20"));
+    detected.push_back(createIface("eth3", 4, "192.0.2.4"));
+    ifacemgr->updateIfaces(detected);
+
+    EXPECT_EQ(5, filter->opened_);
+    ASSERT_EQ(3, ifaces.size());
+    EXPECT_FALSE(ifacemgr->getIface("eth2"));
+
+    Iface* eth0 = ifacemgr->getIface("eth0");
+    ASSERT_TRUE(eth0);
+    ASSERT_EQ(1, eth0->getSockets().size());
+    EXPECT_EQ(eth0_sock, eth0->getSockets().front().sockfd_);
+
+    Iface* eth1 = ifacemgr->getIface("eth1");
+    ASSERT_TRUE(eth1);
+    ASSERT_EQ(1, eth1->getSockets().size());
+    EXPECT_EQ("192.0.2.20", eth1->getSockets().front().addr_.toText());
+
+    Iface* eth3 = ifacemgr->getIface("eth3");
+    ASSERT_TRUE(eth3);
+    EXPECT_EQ(1, eth3->getSockets().size());
+
+    ASSERT_EQ(3, iface_changes.size());
+    EXPECT_EQ("eth2/2", iface_changes[0]);
+    EXPECT_EQ("eth1/1", iface_changes[1]);
+    EXPECT_EQ("eth3/0", iface_changes[2]);
+
+    // Without open sockets, the interfaces don't get any.
+    iface_changes.clear();
+    ifacemgr->closeSockets();
+    detected.push_back(createIface("eth4", 5, "192.0.2.5"));
+    ifacemgr->updateIfaces(detected);
+    EXPECT_EQ(5, filter->opened_);
+    ASSERT_TRUE(ifacemgr->getIface("eth4"));
+    EXPECT_TRUE(ifacemgr->getIface("eth4")->getSockets().empty());
+    ASSERT_EQ(1, iface_changes.size());
+    EXPECT_EQ("eth4/0", iface_changes[0]);
+}
+
+#if defined(OS_LINUX)
+TEST_F(IfaceMgrTest, ifaceTracking) {
+    // tests that the interface tracking socket is watched with the
+    // external sockets.
+    boost::scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+    EXPECT_FALSE(ifacemgr->isTrackingIfaces());
+
+    ASSERT_TRUE(ifacemgr->startIfaceTracking());
+    EXPECT_TRUE(ifacemgr->isTrackingIfaces());
+
+    // Nothing changed, so the receive methods just time out.
+    Pkt4Ptr pkt4;
+    ASSERT_NO_THROW(pkt4 = ifacemgr->receive4(0, 1000));
+    EXPECT_FALSE(pkt4);
+
+    ifacemgr->stopIfaceTracking();
+    EXPECT_FALSE(ifacemgr->isTrackingIfaces());
+}
+#endif
+
 }
@@ -22,6 +22,7 @@
 #include <dhcp/option6_ia.h>
 #include <dhcp/option6_iaaddr.h>
 #include <dhcp/option_custom.h>
+#include <dhcp/option_fixed.h>
 #include <dhcp/option_int.h>
 #include <dhcp/option_int_array.h>
 #include <dhcp/option_string.h>
@@ -157,8 +158,10 @@ private:
         // has been specified.
         EXPECT_EQ(encapsulates, def->getEncapsulatedSpace());
         OptionPtr option;
-        // Create the option.
-        ASSERT_NO_THROW(option = def->optionFactory(u, code, begin, end))
+        // Create the option in the standard option space.
+        const std::string space = (u == Option::V4 ? "dhcp4" : "dhcp6");
+        ASSERT_NO_THROW(option = def->optionFactory(u, code, begin, end,
+                                                    space))
             << "Option creation failed for option code " << code;
         // Make sure it is not NULL.
         ASSERT_TRUE(option);
@@ -542,7 +545,7 @@ TEST_F(LibDhcpTest, stdOptionDefs4) {
     OptionBufferConstIter end = buf.end();
 
     LibDhcpTest::testStdOptionDefs4(DHO_SUBNET_MASK, begin, end,
-                                    typeid(OptionCustom));
+                                    typeid(Option4SubnetMask));
 
     LibDhcpTest::testStdOptionDefs4(DHO_TIME_OFFSET, begin, begin + 4,
                                     typeid(OptionInt<uint32_t>));
@@ -693,16 +696,16 @@ TEST_F(LibDhcpTest, stdOptionDefs4) {
                                     typeid(OptionCustom));
 
     LibDhcpTest::testStdOptionDefs4(DHO_DHCP_LEASE_TIME, begin, begin + 4,
-                                    typeid(OptionInt<uint32_t>));
+                                    typeid(Option4LeaseTime));
 
     LibDhcpTest::testStdOptionDefs4(DHO_DHCP_OPTION_OVERLOAD, begin, begin + 1,
                                     typeid(OptionInt<uint8_t>));
 
     LibDhcpTest::testStdOptionDefs4(DHO_DHCP_MESSAGE_TYPE, begin, begin + 1,
-                                    typeid(OptionInt<uint8_t>));
+                                    typeid(Option4MessageType));
 
     LibDhcpTest::testStdOptionDefs4(DHO_DHCP_SERVER_IDENTIFIER, begin, end,
-                                    typeid(OptionCustom));
+                                    typeid(Option4ServerId));
 
     LibDhcpTest::testStdOptionDefs4(DHO_DHCP_PARAMETER_REQUEST_LIST, begin, end,
                                     typeid(Option));
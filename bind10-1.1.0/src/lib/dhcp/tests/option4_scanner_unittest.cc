@@ -0,0 +1,221 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/option4_scanner.h>
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <vector>
+
+using namespace isc;
+using namespace isc::dhcp;
+
+namespace {
+
+/// All implementations which may be available.
+const Option4Scanner::Implementation implementations[] = {
+    Option4Scanner::IMPL_SCALAR,
+    Option4Scanner::IMPL_SSE2,
+    Option4Scanner::IMPL_AVX2
+};
+
+const size_t implementations_num =
+    sizeof(implementations) / sizeof(implementations[0]);
+
+/// @brief Reference parser, following the original parsing loop.
+///
+/// @param buf buffer to be parsed.
+/// @param [out] locations found options.
+/// @param [out] offset value returned by the parser.
+/// @return false if the buffer is malformed.
+bool
+referenceScan(const std::vector<uint8_t>& buf,
+              Option4LocationCollection& locations, size_t& offset) {
+    offset = 0;
+    while (offset + 1 <= buf.size()) {
+        uint8_t opt_type = buf[offset++];
+        if (opt_type == DHO_END) {
+            return (true);
+        }
+        if (opt_type == DHO_PAD) {
+            continue;
+        }
+        if (offset + 1 >= buf.size()) {
+            return (false);
+        }
+        uint8_t opt_len = buf[offset++];
+        if (offset + opt_len > buf.size()) {
+            return (false);
+        }
+        Option4Location location;
+        location.type_ = opt_type;
+        location.len_ = opt_len;
+        location.offset_ = offset;
+        locations.push_back(location);
+        offset += opt_len;
+    }
+    return (true);
+}
+
+/// @brief Generates a random options buffer.
+///
+/// Buffers contain runs of padding of various lengths, so as the vector
+/// implementations are exercised around the block boundaries. Some of
+/// them are truncated or contain no END option.
+std::vector<uint8_t>
+randomBuffer() {
+    std::vector<uint8_t> buf;
+    const int options_num = random() % 8;
+    for (int i = 0; i < options_num; ++i) {
+        buf.resize(buf.size() + random() % 70, DHO_PAD);
+        buf.push_back(1 + random() % 254);
+        const uint8_t len = random() % 20;
+        buf.push_back(len);
+        for (int j = 0; j < len; ++j) {
+            buf.push_back(random() % 256);
+        }
+    }
+    switch (random() % 4) {
+    case 0:
+        // Packet padded after the END option.
+        buf.push_back(DHO_END);
+        buf.resize(buf.size() + random() % 100, DHO_PAD);
+        break;
+    case 1:
+        // No END option but padding.
+        buf.resize(buf.size() + random() % 100, DHO_PAD);
+        break;
+    case 2:
+        // Truncated.
+        if (!buf.empty()) {
+            buf.resize(random() % buf.size());
+        }
+        break;
+    default:
+        buf.push_back(DHO_END);
+    }
+    return (buf);
+}
+
+// Checks that the run of padding is found correctly by each implementation,
+// for all lengths and alignments.
+TEST(Option4ScannerTest, skipPad) {
+    std::vector<uint8_t> buf(160, DHO_PAD);
+    for (size_t i = 0; i < implementations_num; ++i) {
+        if (!Option4Scanner::isSupported(implementations[i])) {
+            continue;
+        }
+        for (size_t start = 0; start < 32; ++start) {
+            for (size_t pad = 0; start + pad < buf.size(); ++pad) {
+                buf[start + pad] = 1;
+                EXPECT_EQ(pad, Option4Scanner::skipPad(&buf[start],
+                                                       buf.size() - start,
+                                                       implementations[i]))
+                    << "implementation " << implementations[i];
+                buf[start + pad] = DHO_PAD;
+            }
+            EXPECT_EQ(buf.size() - start,
+                      Option4Scanner::skipPad(&buf[start], buf.size() - start,
+                                              implementations[i]));
+        }
+    }
+}
+
+// Checks that options are located and that the scanner stops on END.
+TEST(Option4ScannerTest, scan) {
+    const uint8_t data[] = {
+        DHO_PAD, DHO_PAD,
+        53, 1, 3,                  // message type
+        12, 3, 'f', 'o', 'o',      // hostname
+        DHO_PAD,
+        DHO_END,
+        DHO_PAD, DHO_PAD, 12, 1    // garbage after END is ignored
+    };
+    Option4LocationCollection locations;
+    size_t offset = Option4Scanner::scan(data, sizeof(data), locations);
+    EXPECT_EQ(12, offset);
+    ASSERT_EQ(2, locations.size());
+    EXPECT_EQ(53, locations[0].type_);
+    EXPECT_EQ(1, locations[0].len_);
+    EXPECT_EQ(4, locations[0].offset_);
+    EXPECT_EQ(12, locations[1].type_);
+    EXPECT_EQ(3, locations[1].len_);
+    EXPECT_EQ(7, locations[1].offset_);
+}
+
+// Checks that truncated options are reported.
+TEST(Option4ScannerTest, truncated) {
+    Option4LocationCollection locations;
+    // Option code only.
+    const uint8_t no_len[] = { DHO_PAD, 53 };
+    EXPECT_THROW(Option4Scanner::scan(no_len, sizeof(no_len), locations),
+                 OutOfRange);
+    // Option data shorter than length.
+    const uint8_t short_data[] = { 12, 4, 'f', 'o', 'o' };
+    EXPECT_THROW(Option4Scanner::scan(short_data, sizeof(short_data),
+                                      locations),
+                 OutOfRange);
+}
+
+// Checks that all implementations give the same results as the original
+// parsing loop for randomly generated buffers.
+TEST(Option4ScannerTest, randomBuffers) {
+    srandom(1);
+    for (int n = 0; n < 5000; ++n) {
+        std::vector<uint8_t> buf = randomBuffer();
+        Option4LocationCollection expected;
+        size_t expected_offset = 0;
+        bool valid = referenceScan(buf, expected, expected_offset);
+
+        for (size_t i = 0; i < implementations_num; ++i) {
+            if (!Option4Scanner::isSupported(implementations[i])) {
+                continue;
+            }
+            Option4LocationCollection locations;
+            if (!valid) {
+                EXPECT_THROW(Option4Scanner::scan(buf.empty() ? NULL : &buf[0],
+                                                  buf.size(), locations,
+                                                  implementations[i]),
+                             OutOfRange);
+                continue;
+            }
+            size_t offset = 0;
+            ASSERT_NO_THROW(offset =
+                            Option4Scanner::scan(buf.empty() ? NULL : &buf[0],
+                                                 buf.size(), locations,
+                                                 implementations[i]));
+            EXPECT_EQ(expected_offset, offset);
+            ASSERT_EQ(expected.size(), locations.size());
+            for (size_t j = 0; j < expected.size(); ++j) {
+                EXPECT_EQ(expected[j].type_, locations[j].type_);
+                EXPECT_EQ(expected[j].len_, locations[j].len_);
+                EXPECT_EQ(expected[j].offset_, locations[j].offset_);
+            }
+        }
+    }
+}
+
+// Checks that the default implementation is supported and that scalar
+// implementation is always available.
+TEST(Option4ScannerTest, implementations) {
+    EXPECT_TRUE(Option4Scanner::isSupported(Option4Scanner::IMPL_SCALAR));
+    EXPECT_TRUE(Option4Scanner::isSupported(
+                    Option4Scanner::getDefaultImplementation()));
+}
+
+} // end of anonymous namespace
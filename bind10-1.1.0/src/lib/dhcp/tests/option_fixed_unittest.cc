@@ -0,0 +1,191 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+#include <dhcp/option_custom.h>
+#include <dhcp/option_definition.h>
+#include <dhcp/option_fixed.h>
+#include <dhcp/option_int.h>
+#include <dhcp/pkt4.h>
+#include <util/buffer.h>
+
+#include <gtest/gtest.h>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace isc::util;
+
+namespace {
+
+/// @brief Returns the on-wire data of the packed option.
+OptionBuffer
+packOption(Option& option) {
+    OutputBuffer buf(0);
+    option.pack(buf);
+    const uint8_t* data = static_cast<const uint8_t*>(buf.getData());
+    return (OptionBuffer(data, data + buf.getLength()));
+}
+
+// Checks that the option holding an integer is packed and parsed.
+TEST(OptionFixedTest, integer) {
+    Option4LeaseTime option(3600);
+    EXPECT_EQ(Option::V4, option.getUniverse());
+    EXPECT_EQ(DHO_DHCP_LEASE_TIME, option.getType());
+    EXPECT_EQ(3600, option.getValue());
+    EXPECT_EQ(6, option.len());
+
+    const uint8_t expected[] = { DHO_DHCP_LEASE_TIME, 4, 0, 0, 0x0E, 0x10 };
+    OptionBuffer wire = packOption(option);
+    ASSERT_EQ(sizeof(expected), wire.size());
+    EXPECT_TRUE(std::equal(wire.begin(), wire.end(), expected));
+
+    // The data is accessible through the generic interface.
+    EXPECT_EQ(3600, option.getUint32());
+    EXPECT_EQ(OptionBuffer(expected + 2, expected + sizeof(expected)),
+              option.getData());
+
+    Option4LeaseTime parsed(wire.begin() + 2, wire.end());
+    EXPECT_EQ(3600, parsed.getValue());
+
+    // Only one field is held.
+    EXPECT_THROW(option.getValue(1), isc::OutOfRange);
+    EXPECT_THROW(option.readAddress(), InvalidDataType);
+}
+
+// Checks that the option holding an address is packed and parsed.
+TEST(OptionFixedTest, address) {
+    Option4ServerId option;
+    EXPECT_EQ("0.0.0.0", option.readAddress().toText());
+    option.writeAddress(IOAddress("192.0.2.1"));
+    EXPECT_EQ("192.0.2.1", option.readAddress().toText());
+    EXPECT_THROW(option.writeAddress(IOAddress("2001:db8::1")),
+                 InvalidDataType);
+
+    const uint8_t expected[] = { DHO_DHCP_SERVER_IDENTIFIER, 4, 192, 0, 2, 1 };
+    OptionBuffer wire = packOption(option);
+    ASSERT_EQ(sizeof(expected), wire.size());
+    EXPECT_TRUE(std::equal(wire.begin(), wire.end(), expected));
+
+    Option4ServerId parsed(wire.begin() + 2, wire.end());
+    EXPECT_EQ("192.0.2.1", parsed.readAddress().toText());
+    EXPECT_EQ("type=54, len=4: 192.0.2.1", parsed.toText());
+}
+
+// Checks that truncated data is rejected and trailing data is kept.
+TEST(OptionFixedTest, unpack) {
+    OptionBuffer buf(3, 1);
+    EXPECT_THROW(Option4SubnetMask(buf.begin(), buf.end()), isc::OutOfRange);
+
+    buf.resize(6, 2);
+    Option4SubnetMask option(buf.begin(), buf.end());
+    EXPECT_EQ("1.1.1.2", option.readAddress().toText());
+    EXPECT_EQ(8, option.len());
+    EXPECT_EQ(buf, option.getData());
+
+    const uint8_t expected[] = { DHO_SUBNET_MASK, 6, 1, 1, 1, 2, 2, 2 };
+    OptionBuffer wire = packOption(option);
+    ASSERT_EQ(sizeof(expected), wire.size());
+    EXPECT_TRUE(std::equal(wire.begin(), wire.end(), expected));
+
+    // Parsing the data again replaces the trailing data.
+    option.unpack(buf.begin(), buf.begin() + 4);
+    EXPECT_EQ(6, option.len());
+}
+
+// Checks that the value is set through the generic interface only if
+// its size matches the field.
+TEST(OptionFixedTest, setUint) {
+    OptionPtr option(new Option4LeaseTime(3600));
+    option->setUint32(7200);
+    EXPECT_EQ(7200, option->getUint32());
+    EXPECT_EQ(7200, boost::dynamic_pointer_cast<Option4LeaseTime>(option)->
+              getValue());
+    EXPECT_THROW(option->setUint8(1), isc::BadValue);
+    EXPECT_THROW(option->setUint16(1), isc::BadValue);
+    EXPECT_EQ(7200, option->getUint32());
+
+    option.reset(new Option4MessageType(DHCPDISCOVER));
+    option->setUint8(DHCPOFFER);
+    EXPECT_EQ(DHCPOFFER, option->getUint8());
+    EXPECT_THROW(option->setUint32(DHCPOFFER), isc::BadValue);
+    EXPECT_EQ(3, option->len());
+}
+
+// Checks that the specialized option is created by the standard option
+// definition and that it gives the same results as the generic class.
+TEST(OptionFixedTest, optionFactory) {
+    OptionDefinition def("subnet-mask", DHO_SUBNET_MASK, "ipv4-address");
+    const uint8_t data[] = { 255, 255, 255, 0 };
+    OptionBuffer buf(data, data + sizeof(data));
+
+    OptionPtr option = def.optionFactory(Option::V4, DHO_SUBNET_MASK, buf,
+                                         "dhcp4");
+    ASSERT_TRUE(option);
+    ASSERT_TRUE(typeid(*option) == typeid(Option4SubnetMask));
+
+    OptionCustom custom(def, Option::V4, buf);
+    EXPECT_EQ(custom.len(), option->len());
+    EXPECT_EQ(packOption(custom), packOption(*option));
+    EXPECT_TRUE(custom.equal(option));
+
+    // The specialized class is not used for a definition which doesn't
+    // match the layout.
+    OptionDefinition def_array("subnet-mask", DHO_SUBNET_MASK, "ipv4-address",
+                               true);
+    option = def_array.optionFactory(Option::V4, DHO_SUBNET_MASK, buf,
+                                     "dhcp4");
+    ASSERT_TRUE(option);
+    EXPECT_FALSE(typeid(*option) == typeid(Option4SubnetMask));
+
+    // The universe must match too.
+    option = def.optionFactory(Option::V6, DHO_SUBNET_MASK, buf, "dhcp6");
+    ASSERT_TRUE(option);
+    EXPECT_FALSE(typeid(*option) == typeid(Option4SubnetMask));
+
+    // Other option spaces may use the code for something else, so the
+    // generic class is used for them.
+    option = def.optionFactory(Option::V4, DHO_SUBNET_MASK, buf, "isc");
+    ASSERT_TRUE(option);
+    EXPECT_TRUE(typeid(*option) == typeid(OptionCustom));
+    option = def.optionFactory(Option::V4, DHO_SUBNET_MASK, buf);
+    ASSERT_TRUE(option);
+    EXPECT_TRUE(typeid(*option) == typeid(OptionCustom));
+}
+
+// Checks that the message type of the received packet is held in the
+// specialized option and can be updated.
+TEST(OptionFixedTest, messageType) {
+    Pkt4 pkt(DHCPDISCOVER, 1234);
+    pkt.pack();
+    const uint8_t* data =
+        static_cast<const uint8_t*>(pkt.getBuffer().getData());
+    Pkt4 received(data, pkt.getBuffer().getLength());
+    ASSERT_NO_THROW(received.unpack());
+
+    OptionPtr option = received.getOption(DHO_DHCP_MESSAGE_TYPE);
+    ASSERT_TRUE(option);
+    ASSERT_TRUE(typeid(*option) == typeid(Option4MessageType));
+    EXPECT_EQ(DHCPDISCOVER, received.getType());
+
+    received.setType(DHCPREQUEST);
+    EXPECT_EQ(DHCPREQUEST, received.getType());
+    EXPECT_EQ(DHCPREQUEST, option->getUint8());
+}
+
+} // end of anonymous namespace
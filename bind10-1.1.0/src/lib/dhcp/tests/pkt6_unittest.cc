@@ -552,4 +552,33 @@ TEST_F(Pkt6Test, relayPack) {
     EXPECT_EQ(0, memcmp(relay_opt_data, relay_opt_data, sizeof(relay_opt_data)));
 }
 
+// This test verifies that the DHCPv4 message stored in data4o6_ is packed
+// as OPTION_DHCPV4_MSG directly into the output buffer.
+TEST_F(Pkt6Test, pack4o6) {
+    Pkt6 pkt(DHCPV4_RESPONSE, 0x020304);
+    OptionPtr opt(new Option(Option::V6, 100));
+    pkt.addOption(opt);
+
+    const uint8_t msg4[] = { 2, 1, 6, 0, 0xde, 0xad, 0xbe, 0xef };
+    pkt.data4o6_.assign(msg4, msg4 + sizeof(msg4));
+
+    EXPECT_EQ(Pkt6::DHCPV6_PKT_HDR_LEN + 2 * Option::OPTION6_HDR_LEN
+              + sizeof(msg4), pkt.len());
+    ASSERT_TRUE(pkt.pack());
+    ASSERT_EQ(pkt.len(), pkt.getBuffer().getLength());
+
+    // The packed message can be parsed back and the DHCPv4 message is
+    // carried in the regular DHCPv4 Message option.
+    Pkt6 clone(static_cast<const uint8_t*>(pkt.getBuffer().getData()),
+               pkt.getBuffer().getLength());
+    ASSERT_TRUE(clone.unpack());
+    EXPECT_EQ(DHCPV4_RESPONSE, clone.getType());
+    EXPECT_EQ(0x020304, clone.getTransid());
+    EXPECT_TRUE(clone.getOption(100));
+    OptionPtr msg_opt = clone.getOption(OPTION_DHCPV4_MSG);
+    ASSERT_TRUE(msg_opt);
+    ASSERT_EQ(sizeof(msg4), msg_opt->getData().size());
+    EXPECT_EQ(0, memcmp(msg4, &msg_opt->getData()[0], sizeof(msg4)));
+}
+
 }
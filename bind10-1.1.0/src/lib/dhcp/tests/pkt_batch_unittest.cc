@@ -0,0 +1,109 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <config.h>
+
+#include <dhcp/pkt_batch.h>
+#include <exceptions/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace isc;
+using namespace isc::dhcp;
+
+namespace {
+
+/// @brief Test fixture providing a pair of connected datagram sockets.
+class PktBatchTest : public ::testing::Test {
+public:
+    PktBatchTest() {
+        sockets_[0] = sockets_[1] = -1;
+        if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets_) != 0) {
+            ADD_FAILURE() << "socketpair() failed";
+        }
+    }
+
+    ~PktBatchTest() {
+        close(sockets_[0]);
+        close(sockets_[1]);
+    }
+
+    /// @brief Prepares a slot to send a datagram of the given length,
+    /// filled with the given value.
+    void prepareSlot(PktBatch& batch, size_t slot, size_t length,
+                     uint8_t value) {
+        data_[slot].assign(length, value);
+        struct msghdr& m = batch.prepareSend(slot, NULL, 0, &data_[slot][0],
+                                             length);
+        m.msg_name = NULL;
+        m.msg_control = NULL;
+        m.msg_controllen = 0;
+    }
+
+    int sockets_[2];
+    std::vector<uint8_t> data_[4];
+};
+
+// Checks that a batch can't be empty.
+TEST_F(PktBatchTest, constructor) {
+    EXPECT_THROW(PktBatch(0, 1500, 64), BadValue);
+    PktBatch batch(4, 1500, 64);
+    EXPECT_EQ(4, batch.getSize());
+}
+
+// Checks that the datagrams sent together are received together, each in
+// its slot.
+TEST_F(PktBatchTest, sendReceive) {
+    PktBatch send_batch(4, 1500, 64);
+    for (size_t slot = 0; slot < 3; ++slot) {
+        prepareSlot(send_batch, slot, 100 + slot, slot + 1);
+    }
+    ASSERT_EQ(3, send_batch.send(sockets_[0], 3));
+    for (size_t slot = 0; slot < 3; ++slot) {
+        EXPECT_EQ(100 + slot, send_batch.getLength(slot));
+    }
+
+    // At most two datagrams are taken, the third stays queued.
+    PktBatch batch(4, 1500, 64);
+    ASSERT_EQ(2, batch.receive(sockets_[1], 2));
+    for (size_t slot = 0; slot < 2; ++slot) {
+        ASSERT_EQ(100 + slot, batch.getLength(slot));
+        EXPECT_EQ(0, memcmp(batch.getData(slot), &data_[slot][0],
+                            batch.getLength(slot)));
+    }
+
+    // The batch size caps the count; only the queued datagram is received,
+    // without waiting for others.
+    ASSERT_EQ(1, batch.receive(sockets_[1], 10));
+    ASSERT_EQ(102, batch.getLength(0));
+    EXPECT_EQ(0, memcmp(batch.getData(0), &data_[2][0], 102));
+
+    EXPECT_EQ(0, batch.receive(sockets_[1], 0));
+}
+
+// Checks that the errors are reported.
+TEST_F(PktBatchTest, errors) {
+    PktBatch batch(4, 1500, 64);
+    EXPECT_EQ(-1, batch.receive(-1, 4));
+
+    prepareSlot(batch, 0, 10, 0);
+    EXPECT_EQ(-1, batch.send(-1, 1));
+}
+
+}
@@ -0,0 +1,120 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+#include <dhcp/option.h>
+#include <dhcp/pkt_buffer_pool.h>
+#include <util/buffer.h>
+
+#include <gtest/gtest.h>
+
+using namespace isc;
+using namespace isc::dhcp;
+using namespace isc::util;
+
+namespace {
+
+// Checks that buffers are pre-sized and recycled.
+TEST(PktBufferPoolTest, acquireRelease) {
+    PktBufferPool pool(1024, 2);
+    EXPECT_EQ(1024, pool.getBufferSize());
+    EXPECT_EQ(0, pool.getFreeCount());
+    EXPECT_EQ(0, pool.getAllocatedCount());
+
+    OutputBuffer buf(0);
+    pool.acquire(buf);
+    EXPECT_EQ(1, pool.getAllocatedCount());
+    EXPECT_EQ(1024, buf.getCapacity());
+    EXPECT_EQ(0, buf.getLength());
+
+    buf.writeUint32(0x01020304);
+    const void* storage = buf.getData();
+    pool.release(buf);
+    EXPECT_EQ(1, pool.getFreeCount());
+    EXPECT_NE(storage, buf.getData());
+
+    // The same storage is handed out again, cleared.
+    OutputBuffer buf2(0);
+    pool.acquire(buf2);
+    EXPECT_EQ(storage, buf2.getData());
+    EXPECT_EQ(0, buf2.getLength());
+    EXPECT_EQ(1, pool.getAllocatedCount());
+    EXPECT_EQ(0, pool.getFreeCount());
+}
+
+// Checks that the pool does not hold more than the maximum number of buffers.
+TEST(PktBufferPoolTest, maxPooled) {
+    PktBufferPool pool(512, 2);
+    OutputBuffer buf1(0), buf2(0), buf3(0);
+    pool.acquire(buf1);
+    pool.acquire(buf2);
+    pool.acquire(buf3);
+    EXPECT_EQ(3, pool.getAllocatedCount());
+
+    pool.release(buf1);
+    pool.release(buf2);
+    EXPECT_EQ(2, pool.getFreeCount());
+
+    // The pool is full, so the storage stays with the buffer.
+    const void* storage = buf3.getData();
+    pool.release(buf3);
+    EXPECT_EQ(2, pool.getFreeCount());
+    EXPECT_EQ(storage, buf3.getData());
+}
+
+// Checks that DHCPv4 packet is packed into a pooled buffer.
+TEST(PktBufferPoolTest, pkt4) {
+    PktBufferPool pool;
+    Pkt4 pkt(DHCPOFFER, 1234);
+    pool.acquire(pkt);
+    EXPECT_EQ(PktBufferPool::DEFAULT_BUFFER_SIZE, pkt.getBuffer().getCapacity());
+
+    const void* storage = pkt.getBuffer().getData();
+    pkt.pack();
+    // The whole message fits in the buffer, so it is not reallocated.
+    EXPECT_EQ(storage, pkt.getBuffer().getData());
+
+    // The on-wire data is the same as if the packet used its own buffer.
+    Pkt4 ref(DHCPOFFER, 1234);
+    ref.pack();
+    ASSERT_EQ(ref.getBuffer().getLength(), pkt.getBuffer().getLength());
+    EXPECT_EQ(0, memcmp(ref.getBuffer().getData(), pkt.getBuffer().getData(),
+                        ref.getBuffer().getLength()));
+
+    pool.release(pkt);
+    EXPECT_EQ(0, pkt.getBuffer().getLength());
+    EXPECT_EQ(1, pool.getFreeCount());
+}
+
+// Checks that DHCPv6 packet is packed into a pooled buffer.
+TEST(PktBufferPoolTest, pkt6) {
+    PktBufferPool pool;
+    Pkt6 pkt(DHCPV6_REPLY, 1234);
+    pkt.addOption(OptionPtr(new Option(Option::V6, 100)));
+    pool.acquire(pkt);
+
+    const void* storage = pkt.getBuffer().getData();
+    ASSERT_TRUE(pkt.pack());
+    EXPECT_EQ(storage, pkt.getBuffer().getData());
+    EXPECT_EQ(pkt.len(), pkt.getBuffer().getLength());
+
+    pool.release(pkt);
+    EXPECT_EQ(0, pkt.getBuffer().getLength());
+    EXPECT_EQ(1, pool.getFreeCount());
+}
+
+}
@@ -0,0 +1,161 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+#include <dhcp/option.h>
+#include <dhcp/response_cache.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <gtest/gtest.h>
+
+using namespace isc;
+using namespace isc::dhcp;
+using namespace boost::posix_time;
+
+namespace {
+
+/// @brief DHCPv4 packet with a timestamp set by the test.
+class TestPkt4 : public Pkt4 {
+public:
+    TestPkt4(uint8_t msg_type, uint32_t transid, const ptime& timestamp)
+        : Pkt4(msg_type, transid) {
+        timestamp_ = timestamp;
+        setIface("eth0");
+        const uint8_t hwaddr[] = { 0, 1, 2, 3, 4, 5 };
+        setHWAddr(HTYPE_ETHER, sizeof(hwaddr),
+                  std::vector<uint8_t>(hwaddr, hwaddr + sizeof(hwaddr)));
+    }
+};
+
+/// @brief DHCPv6 packet with a timestamp set by the test.
+class TestPkt6 : public Pkt6 {
+public:
+    TestPkt6(uint8_t msg_type, uint32_t transid, const ptime& timestamp)
+        : Pkt6(msg_type, transid) {
+        timestamp_ = timestamp;
+        setIface("eth0");
+    }
+};
+
+class ResponseCacheTest : public ::testing::Test {
+public:
+    ResponseCacheTest()
+        : now_(microsec_clock::universal_time()) {
+    }
+
+    /// Reference time.
+    ptime now_;
+};
+
+// Checks that the disabled cache doesn't hold responses.
+TEST_F(ResponseCacheTest, disabled) {
+    ResponseCache4 cache;
+    EXPECT_FALSE(cache.isEnabled());
+    TestPkt4 query(DHCPDISCOVER, 1234, now_);
+    Pkt4Ptr rsp(new Pkt4(DHCPOFFER, 1234));
+    EXPECT_FALSE(cache.insert(query, rsp));
+    EXPECT_FALSE(cache.lookup(query));
+    EXPECT_EQ(0, cache.size());
+    EXPECT_EQ(0, cache.getMisses());
+}
+
+// Checks that retransmitted DHCPv4 query hits the cache and that
+// different queries don't.
+TEST_F(ResponseCacheTest, lookup4) {
+    ResponseCache4 cache(2000);
+    EXPECT_TRUE(cache.isEnabled());
+    EXPECT_EQ(2000, cache.getWindow());
+
+    TestPkt4 query(DHCPDISCOVER, 1234, now_);
+    Pkt4Ptr rsp(new Pkt4(DHCPOFFER, 1234));
+    EXPECT_FALSE(cache.lookup(query));
+    EXPECT_TRUE(cache.insert(query, rsp));
+    EXPECT_EQ(1, cache.size());
+
+    // Retransmission within the window.
+    TestPkt4 retransmit(DHCPDISCOVER, 1234, now_ + seconds(1));
+    EXPECT_TRUE(cache.lookup(retransmit) == rsp);
+
+    // Different message type.
+    TestPkt4 request(DHCPREQUEST, 1234, now_ + seconds(1));
+    EXPECT_FALSE(cache.lookup(request));
+
+    // Different transaction id.
+    TestPkt4 other(DHCPDISCOVER, 1235, now_ + seconds(1));
+    EXPECT_FALSE(cache.lookup(other));
+
+    // Different client identifier.
+    TestPkt4 client(DHCPDISCOVER, 1234, now_ + seconds(1));
+    const uint8_t id[] = { 1, 0, 1, 2, 3, 4, 6 };
+    client.addOption(OptionPtr(new Option(Option::V4,
+                                          DHO_DHCP_CLIENT_IDENTIFIER,
+                                          OptionBuffer(id, id + sizeof(id)))));
+    EXPECT_FALSE(cache.lookup(client));
+
+    // Different interface.
+    TestPkt4 iface(DHCPDISCOVER, 1234, now_ + seconds(1));
+    iface.setIface("eth1");
+    EXPECT_FALSE(cache.lookup(iface));
+
+    EXPECT_EQ(1, cache.getHits());
+    EXPECT_EQ(5, cache.getMisses());
+}
+
+// Checks that responses are removed when they get older than the window.
+TEST_F(ResponseCacheTest, expire) {
+    ResponseCache6 cache(2000);
+    TestPkt6 query1(DHCPV6_SOLICIT, 1, now_);
+    TestPkt6 query2(DHCPV6_SOLICIT, 2, now_ + seconds(1));
+    cache.insert(query1, Pkt6Ptr(new Pkt6(DHCPV6_ADVERTISE, 1)));
+    cache.insert(query2, Pkt6Ptr(new Pkt6(DHCPV6_ADVERTISE, 2)));
+    EXPECT_EQ(2, cache.size());
+
+    TestPkt6 retransmit1(DHCPV6_SOLICIT, 1, now_ + milliseconds(2500));
+    EXPECT_FALSE(cache.lookup(retransmit1));
+    EXPECT_EQ(1, cache.size());
+    EXPECT_EQ(1, cache.getEvictions());
+
+    TestPkt6 retransmit2(DHCPV6_SOLICIT, 2, now_ + milliseconds(2500));
+    EXPECT_TRUE(cache.lookup(retransmit2));
+
+    // The expired query is re-sent and a new response is stored.
+    Pkt6Ptr rsp(new Pkt6(DHCPV6_ADVERTISE, 1));
+    cache.insert(retransmit1, rsp);
+    TestPkt6 retransmit3(DHCPV6_SOLICIT, 1, now_ + seconds(3));
+    EXPECT_TRUE(cache.lookup(retransmit3) == rsp);
+
+    // Changing the window clears the cache.
+    cache.setWindow(1000);
+    EXPECT_EQ(0, cache.size());
+}
+
+// Checks that the number of held responses is limited.
+TEST_F(ResponseCacheTest, maxEntries) {
+    ResponseCache6 cache(2000, 2);
+    for (uint32_t transid = 1; transid <= 3; ++transid) {
+        TestPkt6 query(DHCPV6_SOLICIT, transid, now_);
+        cache.insert(query, Pkt6Ptr(new Pkt6(DHCPV6_ADVERTISE, transid)));
+    }
+    EXPECT_EQ(2, cache.size());
+    EXPECT_EQ(1, cache.getEvictions());
+
+    EXPECT_FALSE(cache.lookup(TestPkt6(DHCPV6_SOLICIT, 1, now_)));
+    EXPECT_TRUE(cache.lookup(TestPkt6(DHCPV6_SOLICIT, 2, now_)));
+    EXPECT_TRUE(cache.lookup(TestPkt6(DHCPV6_SOLICIT, 3, now_)));
+}
+
+} // end of anonymous namespace
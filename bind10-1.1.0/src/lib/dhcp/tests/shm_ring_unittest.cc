@@ -0,0 +1,245 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcp/shm_ring.h>
+#include <exceptions/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <vector>
+
+#include <string.h>
+#include <unistd.h>
+
+using namespace isc;
+using namespace isc::dhcp;
+
+namespace {
+
+/// Name of the channel file used in the tests.
+const char* CHANNEL_FILE = "shm-ring-test.4o6";
+
+class ShmRingTest : public ::testing::Test {
+public:
+    ShmRingTest()
+        : data_(CAPACITY, 0xee) {
+        memset(&control_, 0, sizeof(control_));
+    }
+
+    /// @brief Returns a message of the given length and content.
+    static std::vector<uint8_t> message(size_t len, uint8_t value) {
+        return (std::vector<uint8_t>(len, value));
+    }
+
+    /// @brief Pushes a message.
+    static bool push(ShmRing& ring, const std::vector<uint8_t>& msg) {
+        return (ring.push(msg.empty() ? NULL : &msg[0], msg.size()));
+    }
+
+    /// @brief Pops a message, returns it.
+    static std::vector<uint8_t> pop(ShmRing& ring) {
+        size_t len = 0;
+        const uint8_t* data = ring.front(len);
+        if (!data) {
+            return (std::vector<uint8_t>(1, 0xff));
+        }
+        std::vector<uint8_t> msg(data, data + len);
+        ring.pop();
+        return (msg);
+    }
+
+    /// Size of the test ring.
+    static const uint32_t CAPACITY = 256;
+
+    ShmRing::Control control_;
+    std::vector<uint8_t> data_;
+};
+
+const uint32_t ShmRingTest::CAPACITY;
+
+// Checks that invalid capacities are rejected.
+TEST_F(ShmRingTest, constructor) {
+    EXPECT_THROW(ShmRing(&control_, &data_[0], 0), BadValue);
+    EXPECT_THROW(ShmRing(&control_, &data_[0], 32), BadValue);
+    EXPECT_THROW(ShmRing(&control_, &data_[0], 100), BadValue);
+    EXPECT_NO_THROW(ShmRing(&control_, &data_[0], CAPACITY));
+}
+
+// Checks that the messages are passed in order.
+TEST_F(ShmRingTest, pushPop) {
+    ShmRing ring(&control_, &data_[0], CAPACITY);
+    EXPECT_TRUE(ring.empty());
+    size_t len = 1;
+    EXPECT_FALSE(ring.front(len));
+    EXPECT_EQ(0, len);
+
+    EXPECT_TRUE(push(ring, message(10, 1)));
+    EXPECT_TRUE(push(ring, message(0, 0)));
+    EXPECT_TRUE(push(ring, message(64, 3)));
+    EXPECT_FALSE(ring.empty());
+    EXPECT_TRUE(message(10, 1) == pop(ring));
+    EXPECT_TRUE(message(0, 0) == pop(ring));
+    // The message stays until it is popped.
+    ASSERT_TRUE(ring.front(len));
+    EXPECT_EQ(64, len);
+    ASSERT_TRUE(ring.front(len));
+    EXPECT_TRUE(message(64, 3) == pop(ring));
+    EXPECT_TRUE(ring.empty());
+
+    EXPECT_THROW(push(ring, message(ring.getMaxMessageLen() + 1, 4)),
+                 BadValue);
+}
+
+// Checks that a full ring refuses messages, and that the messages wrap
+// around the end of the data area.
+TEST_F(ShmRingTest, wrap) {
+    ShmRing ring(&control_, &data_[0], CAPACITY);
+    // Each record takes 64 bytes.
+    const std::vector<uint8_t> msg = message(60, 5);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(push(ring, msg));
+    }
+    EXPECT_FALSE(push(ring, message(1, 6)));
+    EXPECT_TRUE(msg == pop(ring));
+    EXPECT_TRUE(push(ring, message(1, 6)));
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(msg == pop(ring));
+    }
+    EXPECT_TRUE(message(1, 6) == pop(ring));
+    EXPECT_TRUE(ring.empty());
+
+    // Four records of 56 bytes leave 24 bytes at the end, so the next
+    // record starts at the beginning of the data area.
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(push(ring, message(52, 7)));
+    }
+    // The skipped end counts: 24 + 64 bytes don't fit in the 32 bytes
+    // left.
+    EXPECT_FALSE(push(ring, msg));
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(message(52, 7) == pop(ring));
+    }
+    EXPECT_TRUE(push(ring, msg));
+    EXPECT_TRUE(push(ring, message(1, 6)));
+    EXPECT_TRUE(msg == pop(ring));
+    EXPECT_TRUE(message(1, 6) == pop(ring));
+    EXPECT_TRUE(ring.empty());
+
+    // Many rounds, with messages of different sizes.
+    for (int i = 0; i < 1000; ++i) {
+        const std::vector<uint8_t> msg1 = message(i % 61, i & 0xff);
+        const std::vector<uint8_t> msg2 = message((i * 7) % 61, ~i & 0xff);
+        ASSERT_TRUE(push(ring, msg1));
+        ASSERT_TRUE(push(ring, msg2));
+        ASSERT_TRUE(msg1 == pop(ring)) << "round " << i;
+        ASSERT_TRUE(msg2 == pop(ring)) << "round " << i;
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+// Checks that a corrupted ring is emptied.
+TEST_F(ShmRingTest, corrupted) {
+    ShmRing ring(&control_, &data_[0], CAPACITY);
+    EXPECT_TRUE(push(ring, message(10, 1)));
+    const uint32_t bad_len = 200;
+    memcpy(&data_[0], &bad_len, sizeof(bad_len));
+    size_t len = 0;
+    EXPECT_FALSE(ring.front(len));
+    EXPECT_TRUE(ring.empty());
+    EXPECT_TRUE(push(ring, message(10, 2)));
+    EXPECT_TRUE(message(10, 2) == pop(ring));
+}
+
+// Checks the waiting flag.
+TEST_F(ShmRingTest, waiting) {
+    ShmRing ring(&control_, &data_[0], CAPACITY);
+    EXPECT_FALSE(ring.isWaiting());
+    EXPECT_TRUE(ring.setWaiting(true));
+    EXPECT_TRUE(ring.isWaiting());
+    EXPECT_TRUE(push(ring, message(10, 1)));
+    // The consumer must not block with a message in the ring.
+    EXPECT_FALSE(ring.setWaiting(true));
+    EXPECT_FALSE(ring.setWaiting(false));
+    EXPECT_FALSE(ring.isWaiting());
+}
+
+class Shm4o6ChannelTest : public ::testing::Test {
+public:
+    Shm4o6ChannelTest() {
+        unlink(CHANNEL_FILE);
+    }
+
+    ~Shm4o6ChannelTest() {
+        unlink(CHANNEL_FILE);
+    }
+};
+
+// Checks that the DHCPv4 and DHCPv6 servers exchange messages through
+// the channel.
+TEST_F(Shm4o6ChannelTest, exchange) {
+    EXPECT_THROW(Shm4o6Channel::open(CHANNEL_FILE), ShmChannelError);
+
+    Shm4o6ChannelPtr dhcp4 = Shm4o6Channel::create(CHANNEL_FILE, 4096);
+    EXPECT_TRUE(dhcp4->isCreator());
+    Shm4o6ChannelPtr dhcp6 = Shm4o6Channel::open(CHANNEL_FILE);
+    EXPECT_FALSE(dhcp6->isCreator());
+    EXPECT_FALSE(dhcp6->isClosed());
+
+    const uint8_t query[] = { 1, 2, 3 };
+    ASSERT_TRUE(dhcp6->getOutbound().push(query, sizeof(query)));
+    size_t len = 0;
+    const uint8_t* data = dhcp4->getInbound().front(len);
+    ASSERT_TRUE(data);
+    ASSERT_EQ(sizeof(query), len);
+    EXPECT_EQ(0, memcmp(query, data, len));
+    dhcp4->getInbound().pop();
+
+    const uint8_t response[] = { 4, 5 };
+    ASSERT_TRUE(dhcp4->getOutbound().push(response, sizeof(response)));
+    EXPECT_TRUE(dhcp4->getInbound().empty());
+    data = dhcp6->getInbound().front(len);
+    ASSERT_TRUE(data);
+    ASSERT_EQ(sizeof(response), len);
+    EXPECT_EQ(0, memcmp(response, data, len));
+
+    // The DHCPv4 server stops: the file is gone.
+    dhcp4.reset();
+    EXPECT_TRUE(dhcp6->isClosed());
+    EXPECT_THROW(Shm4o6Channel::open(CHANNEL_FILE), ShmChannelError);
+}
+
+// Checks that a new DHCPv4 server replaces the file, and that the old
+// one doesn't remove the file of the new one.
+TEST_F(Shm4o6ChannelTest, restart) {
+    Shm4o6ChannelPtr old_dhcp4 = Shm4o6Channel::create(CHANNEL_FILE, 4096);
+    Shm4o6ChannelPtr dhcp4 = Shm4o6Channel::create(CHANNEL_FILE, 8192);
+    old_dhcp4.reset();
+    Shm4o6ChannelPtr dhcp6;
+    ASSERT_NO_THROW(dhcp6 = Shm4o6Channel::open(CHANNEL_FILE));
+    EXPECT_EQ(2048, dhcp6->getOutbound().getMaxMessageLen());
+}
+
+// Checks that files which aren't channels are rejected.
+TEST_F(Shm4o6ChannelTest, invalid) {
+    EXPECT_THROW(Shm4o6Channel::create(CHANNEL_FILE, 1000), BadValue);
+    std::ofstream file(CHANNEL_FILE);
+    file << "not a channel";
+    file.close();
+    EXPECT_THROW(Shm4o6Channel::open(CHANNEL_FILE), ShmChannelError);
+}
+
+}
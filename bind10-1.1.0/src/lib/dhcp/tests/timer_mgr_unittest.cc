@@ -0,0 +1,213 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcp/timer_mgr.h>
+#include <exceptions/exceptions.h>
+
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace isc;
+using namespace isc::dhcp;
+
+namespace {
+
+/// @brief Timer manager with the time set by the test.
+class NakedTimerMgr : public TimerMgr {
+public:
+    NakedTimerMgr(uint32_t tick, uint32_t slots)
+        : TimerMgr(tick, slots), now_(1000000) {
+    }
+
+    /// Current time in milliseconds.
+    uint64_t now_;
+
+protected:
+    virtual uint64_t getNow() const {
+        return (now_);
+    }
+};
+
+class TimerMgrTest : public ::testing::Test {
+public:
+    TimerMgrTest()
+        : timers_(10, 16) {
+    }
+
+    /// @brief Records the call of the timer callback.
+    void expired(int timer) {
+        expired_.push_back(timer);
+    }
+
+    /// @brief Returns the callback recording the timer.
+    TimerMgr::Callback callback(int timer) {
+        return (boost::bind(&TimerMgrTest::expired, this, timer));
+    }
+
+    /// Timers with 10ms ticks and a wheel of 16 slots.
+    NakedTimerMgr timers_;
+
+    /// Timers which callbacks have been called, in order.
+    std::vector<int> expired_;
+};
+
+// Checks that invalid parameters are rejected.
+TEST_F(TimerMgrTest, constructor) {
+    EXPECT_THROW(TimerMgr(0, 16), isc::BadValue);
+    EXPECT_THROW(TimerMgr(10, 0), isc::BadValue);
+    EXPECT_NO_THROW(TimerMgr());
+}
+
+// Checks that timers expire after their delay and in order.
+TEST_F(TimerMgrTest, expire) {
+    EXPECT_EQ(500, timers_.getTimeout(500));
+    EXPECT_EQ(0, timers_.runExpired(10));
+
+    const TimerMgr::TimerId id1 = timers_.schedule(25, callback(1));
+    timers_.schedule(5, callback(2));
+    EXPECT_NE(TimerMgr::INVALID_TIMER, id1);
+    EXPECT_TRUE(timers_.isScheduled(id1));
+    EXPECT_EQ(2, timers_.size());
+    // The delays are rounded up to the ticks.
+    EXPECT_EQ(10, timers_.getTimeout(500));
+    EXPECT_EQ(7, timers_.getTimeout(7));
+
+    timers_.now_ += 9;
+    EXPECT_EQ(0, timers_.runExpired(10));
+    EXPECT_EQ(1, timers_.getTimeout(500));
+
+    timers_.now_ += 1;
+    EXPECT_EQ(0, timers_.getTimeout(500));
+    EXPECT_EQ(1, timers_.runExpired(10));
+    ASSERT_EQ(1, expired_.size());
+    EXPECT_EQ(2, expired_[0]);
+    EXPECT_EQ(20, timers_.getTimeout(500));
+
+    timers_.now_ += 20;
+    EXPECT_EQ(1, timers_.runExpired(10));
+    ASSERT_EQ(2, expired_.size());
+    EXPECT_EQ(1, expired_[1]);
+    EXPECT_FALSE(timers_.isScheduled(id1));
+    EXPECT_EQ(0, timers_.size());
+    EXPECT_EQ(500, timers_.getTimeout(500));
+}
+
+// Checks that timers due more than a turn of the wheel ahead expire
+// on time.
+TEST_F(TimerMgrTest, longDelay) {
+    // The wheel turns in 160ms.
+    timers_.schedule(1000, callback(1));
+    timers_.schedule(170, callback(2));
+    EXPECT_EQ(170, timers_.getTimeout(5000));
+
+    timers_.now_ += 170;
+    EXPECT_EQ(1, timers_.runExpired(10));
+    EXPECT_EQ(830, timers_.getTimeout(5000));
+
+    // The slot of the first timer is passed several times.
+    for (int i = 0; i < 8; ++i) {
+        timers_.now_ += 100;
+        EXPECT_EQ(0, timers_.runExpired(10));
+    }
+    timers_.now_ += 30;
+    EXPECT_EQ(1, timers_.runExpired(10));
+    ASSERT_EQ(2, expired_.size());
+    EXPECT_EQ(2, expired_[0]);
+    EXPECT_EQ(1, expired_[1]);
+}
+
+// Checks that the timers expire when the time jumps by more than
+// a turn of the wheel.
+TEST_F(TimerMgrTest, timeJump) {
+    timers_.schedule(100, callback(1));
+    timers_.schedule(50, callback(2));
+    timers_.schedule(10000, callback(3));
+    timers_.now_ += 5000;
+    EXPECT_EQ(2, timers_.runExpired(10));
+    EXPECT_EQ(1, timers_.size());
+    EXPECT_EQ(5000, timers_.getTimeout(10000));
+}
+
+// Checks that cancelled timers don't expire.
+TEST_F(TimerMgrTest, cancel) {
+    const TimerMgr::TimerId id1 = timers_.schedule(10, callback(1));
+    timers_.schedule(30, callback(2));
+    EXPECT_TRUE(timers_.cancel(id1));
+    EXPECT_FALSE(timers_.cancel(id1));
+    EXPECT_FALSE(timers_.isScheduled(id1));
+    // The next timer is the second one.
+    EXPECT_EQ(30, timers_.getTimeout(500));
+
+    timers_.now_ += 50;
+    EXPECT_EQ(1, timers_.runExpired(10));
+    ASSERT_EQ(1, expired_.size());
+    EXPECT_EQ(2, expired_[0]);
+
+    // A timer cancelled after it has expired, but before it is run.
+    const TimerMgr::TimerId id3 = timers_.schedule(10, callback(3));
+    timers_.now_ += 10;
+    EXPECT_EQ(0, timers_.getTimeout(500));
+    EXPECT_TRUE(timers_.cancel(id3));
+    EXPECT_EQ(0, timers_.runExpired(10));
+    EXPECT_EQ(1, expired_.size());
+}
+
+// Checks that the number of callbacks called at once is bounded.
+TEST_F(TimerMgrTest, slices) {
+    for (int i = 0; i < 5; ++i) {
+        timers_.schedule(10, callback(i));
+    }
+    timers_.now_ += 10;
+    EXPECT_EQ(2, timers_.runExpired(2));
+    // The rest is run without waiting.
+    EXPECT_EQ(0, timers_.getTimeout(500));
+    EXPECT_EQ(2, timers_.runExpired(2));
+    EXPECT_EQ(1, timers_.runExpired(2));
+    EXPECT_EQ(5, expired_.size());
+    EXPECT_EQ(500, timers_.getTimeout(500));
+}
+
+/// @brief Task rescheduling itself from its callback.
+class PeriodicTask {
+public:
+    PeriodicTask(TimerMgr& timers) : timers_(timers), runs_(0) {
+        timers_.schedule(100, boost::bind(&PeriodicTask::run, this));
+    }
+
+    void run() {
+        ++runs_;
+        timers_.schedule(100, boost::bind(&PeriodicTask::run, this));
+    }
+
+    TimerMgr& timers_;
+    int runs_;
+};
+
+// Checks that the callbacks can schedule timers.
+TEST_F(TimerMgrTest, periodic) {
+    PeriodicTask task(timers_);
+    for (int i = 0; i < 10; ++i) {
+        timers_.now_ += 100;
+        EXPECT_EQ(1, timers_.runExpired(10));
+        EXPECT_EQ(100, timers_.getTimeout(500));
+    }
+    EXPECT_EQ(10, task.runs_);
+    EXPECT_EQ(1, timers_.size());
+}
+
+}
@@ -0,0 +1,185 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcp/timer_mgr.h>
+#include <exceptions/exceptions.h>
+
+#include <time.h>
+
+namespace isc {
+namespace dhcp {
+
+const TimerMgr::TimerId TimerMgr::INVALID_TIMER;
+const uint32_t TimerMgr::DEFAULT_TICK;
+const uint32_t TimerMgr::DEFAULT_SLOTS;
+
+TimerMgr::TimerMgr(uint32_t tick, uint32_t slots)
+    : tick_(tick), current_(0), last_id_(INVALID_TIMER), next_due_(0),
+      next_due_valid_(false) {
+    if (tick == 0) {
+        isc_throw(BadValue, "duration of a timer tick must not be 0");
+    }
+    if (slots == 0) {
+        isc_throw(BadValue, "number of timer wheel slots must not be 0");
+    }
+    slots_.resize(slots);
+}
+
+uint64_t
+TimerMgr::getNow() const {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000);
+}
+
+TimerMgr::TimerId
+TimerMgr::schedule(uint32_t delay, const Callback& callback) {
+    const uint64_t now = getNow();
+    if (timers_.empty()) {
+        // Nothing is stored in the wheel, so there is no need to go over
+        // the slots of the ticks which have elapsed since it was used.
+        current_ = now / tick_;
+    } else {
+        advance(now);
+    }
+
+    // Round up, so the timer doesn't expire before the delay.
+    uint64_t due = (now + delay + tick_ - 1) / tick_;
+    if (due < current_) {
+        due = current_;
+    }
+    const TimerId id = ++last_id_;
+    Timer& timer = timers_[id];
+    timer.due_ = due;
+    timer.callback_ = callback;
+    slots_[due % slots_.size()].push_back(id);
+
+    if (next_due_valid_ && (due < next_due_)) {
+        next_due_ = due;
+    }
+    return (id);
+}
+
+bool
+TimerMgr::cancel(TimerId id) {
+    TimerMap::iterator timer = timers_.find(id);
+    if (timer == timers_.end()) {
+        return (false);
+    }
+    forgetDue(timer->second.due_);
+    timers_.erase(timer);
+    return (true);
+}
+
+void
+TimerMgr::advance(uint64_t now) {
+    const uint64_t now_tick = now / tick_;
+    if (now_tick < current_) {
+        return;
+    }
+    // A single turn of the wheel inspects every slot.
+    if (now_tick - current_ >= slots_.size()) {
+        current_ = now_tick - slots_.size() + 1;
+    }
+    for (; current_ <= now_tick; ++current_) {
+        std::vector<TimerId>& slot = slots_[current_ % slots_.size()];
+        for (size_t i = 0; i < slot.size(); ) {
+            TimerMap::const_iterator timer =
+                timers_.find(slot[i]);
+            if (timer != timers_.end()) {
+                if (timer->second.due_ > now_tick) {
+                    // Due in one of the next turns.
+                    ++i;
+                    continue;
+                }
+                expired_.push_back(slot[i]);
+                forgetDue(timer->second.due_);
+            }
+            slot[i] = slot.back();
+            slot.pop_back();
+        }
+    }
+}
+
+bool
+TimerMgr::findNextDue() {
+    if (next_due_valid_) {
+        return (true);
+    }
+    // Look for the first due timer in the next turn of the wheel, and if
+    // there is none, in all timers.
+    for (uint64_t tick = current_; tick < current_ + slots_.size(); ++tick) {
+        const std::vector<TimerId>& slot = slots_[tick % slots_.size()];
+        for (std::vector<TimerId>::const_iterator id = slot.begin();
+             id != slot.end(); ++id) {
+            TimerMap::const_iterator timer =
+                timers_.find(*id);
+            if ((timer != timers_.end()) && (timer->second.due_ == tick)) {
+                next_due_ = tick;
+                next_due_valid_ = true;
+                return (true);
+            }
+        }
+    }
+    for (TimerMap::const_iterator timer = timers_.begin();
+         timer != timers_.end(); ++timer) {
+        if (!next_due_valid_ || (timer->second.due_ < next_due_)) {
+            next_due_ = timer->second.due_;
+            next_due_valid_ = true;
+        }
+    }
+    return (next_due_valid_);
+}
+
+uint32_t
+TimerMgr::getTimeout(uint32_t max_timeout) {
+    const uint64_t now = getNow();
+    advance(now);
+    if (!expired_.empty()) {
+        return (0);
+    }
+    if (!findNextDue()) {
+        return (max_timeout);
+    }
+    // The wheel has been advanced past the current tick, so the next
+    // due tick starts in the future.
+    const uint64_t due = next_due_ * tick_;
+    const uint64_t timeout = (due > now ? due - now : 0);
+    return (timeout < max_timeout ? static_cast<uint32_t>(timeout) :
+            max_timeout);
+}
+
+size_t
+TimerMgr::runExpired(size_t max_timers) {
+    advance(getNow());
+    size_t count = 0;
+    while (!expired_.empty() && (count < max_timers)) {
+        const TimerId id = expired_.front();
+        expired_.pop_front();
+        TimerMap::iterator timer = timers_.find(id);
+        if (timer == timers_.end()) {
+            // Cancelled after it expired.
+            continue;
+        }
+        Callback callback;
+        callback.swap(timer->second.callback_);
+        timers_.erase(timer);
+        ++count;
+        callback();
+    }
+    return (count);
+}
+
+} // namespace isc::dhcp
+} // namespace isc
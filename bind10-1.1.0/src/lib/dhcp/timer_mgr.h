@@ -0,0 +1,189 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef TIMER_MGR_H
+#define TIMER_MGR_H
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <deque>
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Schedules the periodic tasks of a server.
+///
+/// The servers run in a single thread which waits for packets in
+/// @ref IfaceMgr::receive4 or @ref IfaceMgr::receive6. The timers are
+/// run by the interface manager from there: the wait ends when the next
+/// timer is due, and the due timers are run before the sockets are
+/// checked. A task which has a lot of work to do (e.g. to go over a large
+/// table) is expected to do a bounded part of it and to schedule itself
+/// again, so that the processing of packets is not delayed by much.
+///
+/// The timers are kept in a hashed timer wheel. The time is divided into
+/// ticks and a timer due at the tick N is stored in the slot N modulo the
+/// number of slots; the timers themselves are in a hash table indexed by
+/// their identifiers. Scheduling and cancelling a timer take constant time
+/// on average, whatever the number of timers. Timers due more than one
+/// turn of the wheel ahead stay in their slots until the wheel has turned
+/// enough times. Finding when the next timer is due goes over the slots
+/// of one turn of the wheel, and over all timers when none is due within
+/// that turn.
+///
+/// Timers are one-shot; a periodic task schedules itself again from its
+/// callback. The timer manager is not thread safe.
+class TimerMgr : public boost::noncopyable {
+public:
+    /// @brief Identifier of a scheduled timer.
+    typedef uint64_t TimerId;
+
+    /// @brief Function called when a timer expires.
+    typedef boost::function<void ()> Callback;
+
+    /// @brief Identifier never returned by @ref schedule.
+    static const TimerId INVALID_TIMER = 0;
+
+    /// @brief Default duration of a tick in milliseconds.
+    static const uint32_t DEFAULT_TICK = 10;
+
+    /// @brief Default number of slots of the wheel.
+    static const uint32_t DEFAULT_SLOTS = 1024;
+
+    /// @brief Constructor.
+    ///
+    /// @param tick duration of a tick in milliseconds. Timers expire with
+    /// this precision.
+    /// @param slots number of slots of the wheel.
+    /// @throw isc::BadValue if the tick or the number of slots is 0.
+    TimerMgr(uint32_t tick = DEFAULT_TICK, uint32_t slots = DEFAULT_SLOTS);
+
+    /// @brief Destructor.
+    virtual ~TimerMgr() { }
+
+    /// @brief Schedules a timer.
+    ///
+    /// @param delay time in milliseconds after which the timer expires.
+    /// A timer never expires earlier, but it may expire up to one tick
+    /// later.
+    /// @param callback function to call when the timer expires.
+    /// @return identifier of the timer.
+    TimerId schedule(uint32_t delay, const Callback& callback);
+
+    /// @brief Cancels a timer.
+    ///
+    /// @param id identifier of the timer.
+    /// @return true if the timer was scheduled, false if it has already
+    /// expired or has been cancelled.
+    bool cancel(TimerId id);
+
+    /// @brief Checks if a timer is scheduled.
+    ///
+    /// @param id identifier of the timer.
+    bool isScheduled(TimerId id) const {
+        return (timers_.count(id) != 0);
+    }
+
+    /// @brief Returns the time until the next timer expires.
+    ///
+    /// @param max_timeout value returned if no timer expires earlier.
+    /// @return time in milliseconds, 0 if there are expired timers to run.
+    uint32_t getTimeout(uint32_t max_timeout);
+
+    /// @brief Runs the expired timers.
+    ///
+    /// The timers are removed before their callbacks are called, so the
+    /// callbacks may schedule and cancel timers. An exception thrown by a
+    /// callback is propagated to the caller; the remaining expired timers
+    /// are run by the next call.
+    ///
+    /// @param max_timers maximum number of callbacks to call.
+    /// @return number of callbacks called.
+    size_t runExpired(size_t max_timers);
+
+    /// @brief Returns the number of scheduled timers.
+    size_t size() const {
+        return (timers_.size());
+    }
+
+protected:
+    /// @brief Returns the current time in milliseconds.
+    ///
+    /// The time is measured by the monotonic clock from an unspecified
+    /// point. Unit tests override this to control the time.
+    virtual uint64_t getNow() const;
+
+private:
+    /// @brief Scheduled timer.
+    struct Timer {
+        /// Tick at which the timer expires.
+        uint64_t due_;
+        /// Function to call when the timer expires.
+        Callback callback_;
+    };
+
+    /// @brief Moves the expired timers to the queue of timers to run.
+    ///
+    /// @param now current time in milliseconds.
+    void advance(uint64_t now);
+
+    /// @brief Forgets the earliest due tick if it is the tick of a timer
+    /// which is removed.
+    ///
+    /// @param due tick at which the removed timer was due.
+    void forgetDue(uint64_t due) {
+        if (due == next_due_) {
+            next_due_valid_ = false;
+        }
+    }
+
+    /// @brief Finds the earliest tick at which a timer is due.
+    ///
+    /// The result is cached until a timer due at that tick is removed.
+    /// Otherwise, the slots of the next turn of the wheel are searched, and
+    /// if no timer is due within that turn, all timers are.
+    ///
+    /// @return false if there are no timers.
+    bool findNextDue();
+
+    /// Duration of a tick in milliseconds.
+    uint32_t tick_;
+    /// Identifiers of the timers stored in each slot. Cancelled timers
+    /// are removed from the slots lazily.
+    std::vector<std::vector<TimerId> > slots_;
+    /// Hash table of the timers indexed by their identifiers.
+    typedef boost::unordered_map<TimerId, Timer> TimerMap;
+    /// Scheduled timers.
+    TimerMap timers_;
+    /// Expired timers waiting to be run.
+    std::deque<TimerId> expired_;
+    /// First tick the wheel hasn't been advanced past.
+    uint64_t current_;
+    /// Identifier of the last scheduled timer.
+    TimerId last_id_;
+    /// Earliest tick at which a timer is due, if next_due_valid_ is set.
+    uint64_t next_due_;
+    /// Is next_due_ up to date.
+    bool next_due_valid_;
+};
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // TIMER_MGR_H
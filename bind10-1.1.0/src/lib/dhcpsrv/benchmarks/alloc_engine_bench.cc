@@ -0,0 +1,218 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/alloc_counter.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/duid.h>
+#include <dhcp/hwaddr.h>
+#include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/lease_mgr.h>
+#include <dhcpsrv/lease_mgr_factory.h>
+#include <dhcpsrv/pool.h>
+#include <dhcpsrv/subnet.h>
+#include <log/logger_support.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace isc::asiolink;
+using namespace isc::bench;
+using namespace isc::dhcp;
+
+namespace {
+
+/// @brief Returns the n-th address of the IPv4 pool (10.0.0.0/8).
+IOAddress
+address4(uint32_t n) {
+    return (IOAddress(0x0a000000 + n + 1));
+}
+
+/// @brief Returns the n-th address of the IPv6 pool (2001:db8:1::/64).
+IOAddress
+address6(uint32_t n) {
+    uint8_t addr[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 1 };
+    addr[12] = n >> 24;
+    addr[13] = (n >> 16) & 0xFF;
+    addr[14] = (n >> 8) & 0xFF;
+    addr[15] = (n & 0xFF) + 1;
+    return (IOAddress::fromBytes(AF_INET6, addr));
+}
+
+/// @brief Checks if the n-th address of the pool is leased.
+///
+/// The leased addresses are scattered over the pool, as they are in a
+/// pool in which the leases have been allocated and released for some
+/// time, so the allocator finds a leased address with the probability
+/// given by the fill level.
+bool
+isLeased(uint32_t n, unsigned int fill) {
+    return (((n * 2654435761U) >> 8) % 100 < fill);
+}
+
+/// @brief Returns the client identifying data of the n-th client.
+vector<uint8_t>
+clientData(uint8_t prefix, uint32_t n, size_t len) {
+    vector<uint8_t> data(len, prefix);
+    for (size_t i = 0; i < 4; ++i) {
+        data[len - i - 1] = (n >> (8 * i)) & 0xFF;
+    }
+    return (data);
+}
+
+/// @brief Picks the IPv4 address for the new client (DISCOVER).
+class Allocate4BenchMark {
+public:
+    Allocate4BenchMark(AllocEngine& engine, const Subnet4Ptr& subnet) :
+        engine_(engine), subnet_(subnet),
+        clientid_(new ClientId(clientData(0x01, 0xffffffff, 7))),
+        hwaddr_(new HWAddr(clientData(0x02, 0xffffffff, 6), HTYPE_ETHER))
+    {}
+    unsigned int run() {
+        const Lease4Ptr lease =
+            engine_.allocateAddress4(subnet_, clientid_, hwaddr_,
+                                     IOAddress("0.0.0.0"), true);
+        assert(lease);
+        return (1);
+    }
+private:
+    AllocEngine& engine_;
+    const Subnet4Ptr subnet_;
+    const ClientIdPtr clientid_;
+    const HWAddrPtr hwaddr_;
+};
+
+/// @brief Picks the IPv6 address for the new client (SOLICIT).
+class Allocate6BenchMark {
+public:
+    Allocate6BenchMark(AllocEngine& engine, const Subnet6Ptr& subnet) :
+        engine_(engine), subnet_(subnet),
+        duid_(new DUID(clientData(0x00, 0xffffffff, 14)))
+    {}
+    unsigned int run() {
+        const Lease6Ptr lease =
+            engine_.allocateAddress6(subnet_, duid_, 1, IOAddress("::"),
+                                     true);
+        assert(lease);
+        return (1);
+    }
+private:
+    AllocEngine& engine_;
+    const Subnet6Ptr subnet_;
+    const DuidPtr duid_;
+};
+
+/// @brief Runs the benchmarks for the given pool fill level.
+void
+runFillLevel(int iteration, uint32_t pool_size, unsigned int fill) {
+    LeaseMgrFactory::create("type=memfile");
+    LeaseMgr& lease_mgr = LeaseMgrFactory::instance();
+
+    Subnet4Ptr subnet4(new Subnet4(IOAddress("10.0.0.0"), 8,
+                                   1000, 2000, 4000));
+    subnet4->addPool(Pool4Ptr(new Pool4(address4(0),
+                                        address4(pool_size - 1))));
+    Subnet6Ptr subnet6(new Subnet6(IOAddress("2001:db8:1::"), 64,
+                                   1000, 2000, 3000, 4000));
+    subnet6->addPool(Pool6Ptr(new Pool6(Pool6::TYPE_IA, address6(0),
+                                        address6(pool_size - 1))));
+
+    uint32_t leased = 0;
+    for (uint32_t n = 0; n < pool_size; ++n) {
+        if (!isLeased(n, fill)) {
+            continue;
+        }
+        const vector<uint8_t> hwaddr = clientData(0x02, n, 6);
+        const vector<uint8_t> clientid = clientData(0x01, n, 7);
+        lease_mgr.addLease(Lease4Ptr(new Lease4(address4(n), &hwaddr[0],
+                                                hwaddr.size(), &clientid[0],
+                                                clientid.size(), 4000, 1000,
+                                                2000, time(NULL),
+                                                subnet4->getID())));
+        const DuidPtr duid(new DUID(clientData(0x00, n, 14)));
+        lease_mgr.addLease(Lease6Ptr(new Lease6(Lease6::LEASE_IA_NA,
+                                                address6(n), duid, n, 3000,
+                                                4000, 1000, 2000,
+                                                subnet6->getID())));
+        ++leased;
+    }
+    cout << "Pool " << fill << "% full (" << leased << " of " << pool_size
+         << " addresses leased)" << endl;
+
+    ostringstream name;
+    name << "allocateAddress4 (" << fill << "% full)";
+    AllocEngine engine4(AllocEngine::ALLOC_ITERATIVE, 0);
+    Allocate4BenchMark allocate4(engine4, subnet4);
+    runBenchMark(name.str(), iteration, allocate4);
+
+    name.str("");
+    name << "allocateAddress6 (" << fill << "% full)";
+    AllocEngine engine6(AllocEngine::ALLOC_ITERATIVE, 0);
+    Allocate6BenchMark allocate6(engine6, subnet6);
+    runBenchMark(name.str(), iteration, allocate6);
+
+    LeaseMgrFactory::destroy();
+}
+
+void
+usage() {
+    cerr << "Usage: alloc_engine_bench [-n iterations] [-p pool_size]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 10000;
+    int pool_size = 65536;
+    while ((ch = getopt(argc, argv, "n:p:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case 'p':
+            pool_size = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if ((argc != 0) || (pool_size < 100) || (pool_size > 0xfffffe)) {
+        usage();
+    }
+
+    isc::log::initLogger("alloc_engine_bench", isc::log::ERROR);
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+    cout << "  Pool size: " << pool_size << endl;
+
+    const unsigned int fill_levels[] = { 0, 50, 90, 99 };
+    for (size_t i = 0; i < sizeof(fill_levels) / sizeof(fill_levels[0]);
+         ++i) {
+        runFillLevel(iteration, pool_size, fill_levels[i]);
+    }
+
+    return (0);
+}
@@ -0,0 +1,183 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/alloc_counter.h>
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/cfgmgr.h>
+#include <dhcpsrv/pool.h>
+#include <dhcpsrv/subnet.h>
+#include <log/logger_support.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace isc::asiolink;
+using namespace isc::bench;
+using namespace isc::dhcp;
+
+namespace {
+
+/// @brief Returns the address in the n-th configured IPv4 subnet.
+///
+/// The subnets are 10.x.y.0/24.
+IOAddress
+subnetAddress4(uint32_t n, uint8_t host) {
+    return (IOAddress(0x0a000000 + (n << 8) + host));
+}
+
+/// @brief Returns the address in the n-th configured IPv6 subnet.
+///
+/// The subnets are 2001:db8:x::/64.
+IOAddress
+subnetAddress6(uint16_t n, uint8_t host) {
+    uint8_t addr[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+    addr[4] = n >> 8;
+    addr[5] = n & 0xFF;
+    addr[15] = host;
+    return (IOAddress::fromBytes(AF_INET6, addr));
+}
+
+/// @brief Looks up the IPv4 subnets for the given addresses.
+class Subnet4BenchMark {
+public:
+    Subnet4BenchMark(const vector<IOAddress>& addrs) : addrs_(addrs) {}
+    unsigned int run() {
+        CfgMgr& cfg_mgr = CfgMgr::instance();
+        for (vector<IOAddress>::const_iterator it = addrs_.begin();
+             it != addrs_.end(); ++it) {
+            const Subnet4Ptr subnet = cfg_mgr.getSubnet4(*it);
+            assert(subnet);
+        }
+        return (addrs_.size());
+    }
+private:
+    const vector<IOAddress>& addrs_;
+};
+
+/// @brief Looks up the IPv6 subnets for the given addresses.
+class Subnet6BenchMark {
+public:
+    Subnet6BenchMark(const vector<IOAddress>& addrs) : addrs_(addrs) {}
+    unsigned int run() {
+        CfgMgr& cfg_mgr = CfgMgr::instance();
+        for (vector<IOAddress>::const_iterator it = addrs_.begin();
+             it != addrs_.end(); ++it) {
+            const Subnet6Ptr subnet = cfg_mgr.getSubnet6(*it);
+            assert(subnet);
+        }
+        return (addrs_.size());
+    }
+private:
+    const vector<IOAddress>& addrs_;
+};
+
+void
+usage() {
+    cerr << "Usage: cfgmgr_bench [-n iterations] [-s subnets]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 10000;
+    int subnets = 1000;
+    while ((ch = getopt(argc, argv, "n:s:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case 's':
+            subnets = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if ((argc != 0) || (subnets <= 0) || (subnets > 65535)) {
+        usage();
+    }
+
+    isc::log::initLogger("cfgmgr_bench", isc::log::WARN);
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+    cout << "  Subnets: " << subnets << endl;
+
+    // The subnets are installed at once, as the servers do: adding them
+    // one by one copies the collection each time.
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+    Subnet4Collection subnets4;
+    Subnet6Collection subnets6;
+    for (int i = 0; i < subnets; ++i) {
+        Subnet4Ptr subnet4(new Subnet4(subnetAddress4(i, 0), 24,
+                                       1000, 2000, 4000));
+        subnet4->addPool(Pool4Ptr(new Pool4(subnetAddress4(i, 10),
+                                            subnetAddress4(i, 250))));
+        subnets4.push_back(subnet4);
+
+        Subnet6Ptr subnet6(new Subnet6(subnetAddress6(i, 0), 64,
+                                       1000, 2000, 3000, 4000));
+        subnet6->addPool(Pool6Ptr(new Pool6(Pool6::TYPE_IA,
+                                            subnetAddress6(i, 10),
+                                            subnetAddress6(i, 250))));
+        subnets6.push_back(subnet6);
+    }
+    cfg_mgr.replaceSubnets4(cfg_mgr.buildSubnets4(subnets4));
+    cfg_mgr.replaceSubnets6(cfg_mgr.buildSubnets6(subnets6));
+
+    // Lookups of the addresses in the first subnet, the last subnet and
+    // all subnets in turn.
+    vector<IOAddress> first4(1, subnetAddress4(0, 100));
+    vector<IOAddress> last4(1, subnetAddress4(subnets - 1, 100));
+    vector<IOAddress> all4;
+    vector<IOAddress> first6(1, subnetAddress6(0, 100));
+    vector<IOAddress> last6(1, subnetAddress6(subnets - 1, 100));
+    vector<IOAddress> all6;
+    for (int i = 0; i < subnets; ++i) {
+        all4.push_back(subnetAddress4(i, 100));
+        all6.push_back(subnetAddress6(i, 100));
+    }
+
+    Subnet4BenchMark subnet4_first(first4);
+    runBenchMark("CfgMgr::getSubnet4 (first subnet)", iteration,
+                 subnet4_first);
+    Subnet4BenchMark subnet4_last(last4);
+    runBenchMark("CfgMgr::getSubnet4 (last subnet)", iteration,
+                 subnet4_last);
+    Subnet4BenchMark subnet4_all(all4);
+    runBenchMark("CfgMgr::getSubnet4 (all subnets)", iteration / subnets + 1,
+                 subnet4_all);
+
+    Subnet6BenchMark subnet6_first(first6);
+    runBenchMark("CfgMgr::getSubnet6 (first subnet)", iteration,
+                 subnet6_first);
+    Subnet6BenchMark subnet6_last(last6);
+    runBenchMark("CfgMgr::getSubnet6 (last subnet)", iteration,
+                 subnet6_last);
+    Subnet6BenchMark subnet6_all(all6);
+    runBenchMark("CfgMgr::getSubnet6 (all subnets)", iteration / subnets + 1,
+                 subnet6_all);
+
+    return (0);
+}
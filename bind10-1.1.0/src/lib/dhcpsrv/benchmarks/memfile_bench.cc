@@ -0,0 +1,243 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/alloc_counter.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/duid.h>
+#include <dhcp/hwaddr.h>
+#include <dhcpsrv/lease_mgr.h>
+#include <dhcpsrv/memfile_lease_mgr.h>
+#include <log/logger_support.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace isc::asiolink;
+using namespace isc::bench;
+using namespace isc::dhcp;
+
+namespace {
+
+/// Identifier of the subnet all leases belong to.
+const SubnetID SUBNET_ID = 1;
+
+/// @brief Returns the n-th IPv4 address (10.0.0.0/8).
+IOAddress
+address4(uint32_t n) {
+    return (IOAddress(0x0a000000 + n + 1));
+}
+
+/// @brief Returns the n-th IPv6 address (2001:db8:1::/64).
+IOAddress
+address6(uint32_t n) {
+    uint8_t addr[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 1 };
+    addr[12] = n >> 24;
+    addr[13] = (n >> 16) & 0xFF;
+    addr[14] = (n >> 8) & 0xFF;
+    addr[15] = n & 0xFF;
+    return (IOAddress::fromBytes(AF_INET6, addr));
+}
+
+/// @brief Returns the client identifying data for the n-th client.
+///
+/// @param prefix The leading octets distinguishing the kinds of data.
+/// @param n The client number.
+/// @param len Length of the data.
+vector<uint8_t>
+clientData(const uint8_t prefix, uint32_t n, size_t len) {
+    vector<uint8_t> data(len, prefix);
+    for (size_t i = 0; (i < 4) && (i < len); ++i) {
+        data[len - i - 1] = (n >> (8 * i)) & 0xFF;
+    }
+    return (data);
+}
+
+/// @brief Keys of the leases of a single client.
+struct ClientKeys {
+    ClientKeys(uint32_t n) :
+        addr4_(address4(n)), addr6_(address6(n)),
+        hwaddr_(clientData(0x02, n, 6), HTYPE_ETHER),
+        clientid_(clientData(0x01, n, 7)), duid_(clientData(0x00, n, 14)),
+        iaid_(n)
+    {}
+
+    const IOAddress addr4_;
+    const IOAddress addr6_;
+    const HWAddr hwaddr_;
+    const ClientId clientid_;
+    const DUID duid_;
+    const uint32_t iaid_;
+};
+
+/// @brief Creates the IPv4 lease of the client.
+Lease4Ptr
+createLease4(const ClientKeys& keys) {
+    const vector<uint8_t>& clientid = keys.clientid_.getClientId();
+    return (Lease4Ptr(new Lease4(keys.addr4_, &keys.hwaddr_.hwaddr_[0],
+                                 keys.hwaddr_.hwaddr_.size(), &clientid[0],
+                                 clientid.size(), 4000, 1000, 2000,
+                                 time(NULL), SUBNET_ID)));
+}
+
+/// @brief Creates the IPv6 lease of the client.
+Lease6Ptr
+createLease6(const ClientKeys& keys) {
+    return (Lease6Ptr(new Lease6(Lease6::LEASE_IA_NA, keys.addr6_,
+                                 DuidPtr(new DUID(keys.duid_)), keys.iaid_,
+                                 3000, 4000, 1000, 2000, SUBNET_ID)));
+}
+
+/// @brief Type of the lookup.
+enum LookupType {
+    BY_ADDR4,
+    BY_HWADDR,
+    BY_CLIENTID,
+    BY_ADDR6,
+    BY_DUID
+};
+
+/// @brief Looks up the existing leases, a different one in each iteration.
+class LookupBenchMark {
+public:
+    LookupBenchMark(const LeaseMgr& lease_mgr, const vector<ClientKeys>& keys,
+                    LookupType type) :
+        lease_mgr_(lease_mgr), keys_(keys), type_(type), next_(0)
+    {}
+    unsigned int run() {
+        const ClientKeys& keys = keys_[next_];
+        next_ = (next_ + 1) % keys_.size();
+        Lease4Ptr lease4;
+        Lease6Ptr lease6;
+        switch (type_) {
+        case BY_ADDR4:
+            lease4 = lease_mgr_.getLease4(keys.addr4_);
+            break;
+        case BY_HWADDR:
+            lease4 = lease_mgr_.getLease4(keys.hwaddr_, SUBNET_ID);
+            break;
+        case BY_CLIENTID:
+            lease4 = lease_mgr_.getLease4(keys.clientid_, SUBNET_ID);
+            break;
+        case BY_ADDR6:
+            lease6 = lease_mgr_.getLease6(keys.addr6_);
+            break;
+        case BY_DUID:
+            lease6 = lease_mgr_.getLease6(keys.duid_, keys.iaid_, SUBNET_ID);
+            break;
+        }
+        assert(lease4 || lease6);
+        return (1);
+    }
+private:
+    const LeaseMgr& lease_mgr_;
+    const vector<ClientKeys>& keys_;
+    const LookupType type_;
+    size_t next_;
+};
+
+/// @brief Adds the lease and deletes it.
+///
+/// The lease is created in advance; the benchmark measures the cost of
+/// updating the indexes of the storage.
+template <typename LeasePtrType>
+class AddDeleteBenchMark {
+public:
+    AddDeleteBenchMark(LeaseMgr& lease_mgr, const LeasePtrType& lease) :
+        lease_mgr_(lease_mgr), lease_(lease)
+    {}
+    unsigned int run() {
+        bool done = lease_mgr_.addLease(lease_);
+        assert(done);
+        done = lease_mgr_.deleteLease(lease_->addr_);
+        assert(done);
+        return (1);
+    }
+private:
+    LeaseMgr& lease_mgr_;
+    const LeasePtrType lease_;
+};
+
+void
+usage() {
+    cerr << "Usage: memfile_bench [-n iterations] [-l leases]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 100000;
+    int leases = 100000;
+    while ((ch = getopt(argc, argv, "n:l:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case 'l':
+            leases = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if ((argc != 0) || (leases <= 0)) {
+        usage();
+    }
+
+    isc::log::initLogger("memfile_bench", isc::log::ERROR);
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+    cout << "  Leases: " << leases << endl;
+
+    const LeaseMgr::ParameterMap parameters;
+    Memfile_LeaseMgr lease_mgr(parameters);
+    vector<ClientKeys> keys;
+    keys.reserve(leases);
+    for (int i = 0; i < leases; ++i) {
+        keys.push_back(ClientKeys(i));
+        lease_mgr.addLease(createLease4(keys.back()));
+        lease_mgr.addLease(createLease6(keys.back()));
+    }
+
+    LookupBenchMark by_addr4(lease_mgr, keys, BY_ADDR4);
+    runBenchMark("getLease4 (address)", iteration, by_addr4);
+    LookupBenchMark by_hwaddr(lease_mgr, keys, BY_HWADDR);
+    runBenchMark("getLease4 (hwaddr, subnet)", iteration, by_hwaddr);
+    LookupBenchMark by_clientid(lease_mgr, keys, BY_CLIENTID);
+    runBenchMark("getLease4 (client-id, subnet)", iteration, by_clientid);
+    AddDeleteBenchMark<Lease4Ptr> add_delete4(lease_mgr,
+                                              createLease4(ClientKeys(leases)));
+    runBenchMark("addLease + deleteLease (IPv4)", iteration, add_delete4);
+
+    LookupBenchMark by_addr6(lease_mgr, keys, BY_ADDR6);
+    runBenchMark("getLease6 (address)", iteration, by_addr6);
+    LookupBenchMark by_duid(lease_mgr, keys, BY_DUID);
+    runBenchMark("getLease6 (duid, iaid, subnet)", iteration, by_duid);
+    AddDeleteBenchMark<Lease6Ptr> add_delete6(lease_mgr,
+                                              createLease6(ClientKeys(leases)));
+    runBenchMark("addLease + deleteLease (IPv6)", iteration, add_delete6);
+
+    return (0);
+}
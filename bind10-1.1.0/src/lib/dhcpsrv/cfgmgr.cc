@@ -17,9 +17,73 @@
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dhcpsrv_log.h>
 
+#include <map>
+#include <string>
+
 using namespace isc::asiolink;
 using namespace isc::util;
 
+namespace {
+
+/// @brief Builds the subnets of a new configuration.
+///
+/// @param subnets new subnets.
+/// @param current subnets of the current configuration.
+/// @param [out] result new subnets, with the state of the current
+/// subnets with the same prefix.
+/// @return number of subnets which kept their state.
+template<typename SubnetCollectionType>
+size_t
+inheritSubnets(const SubnetCollectionType& subnets,
+               const SubnetCollectionType& current,
+               SubnetCollectionType& result) {
+    typedef typename SubnetCollectionType::value_type SubnetPtrType;
+    std::map<std::string, SubnetPtrType> by_prefix;
+    for (typename SubnetCollectionType::const_iterator subnet =
+             current.begin(); subnet != current.end(); ++subnet) {
+        by_prefix[(*subnet)->toText()] = *subnet;
+    }
+
+    size_t inherited = 0;
+    result.reserve(subnets.size());
+    for (typename SubnetCollectionType::const_iterator subnet =
+             subnets.begin(); subnet != subnets.end(); ++subnet) {
+        typename std::map<std::string, SubnetPtrType>::iterator previous =
+            by_prefix.find((*subnet)->toText());
+        if (previous != by_prefix.end()) {
+            (*subnet)->inheritState(*previous->second);
+            // A prefix configured twice must not get the same ID twice.
+            by_prefix.erase(previous);
+            ++inherited;
+        }
+        result.push_back(*subnet);
+    }
+    return (inherited);
+}
+
+/// @brief Finds the subnet with the specified prefix.
+///
+/// @param begin beginning of the range of subnets to search.
+/// @param end end of the range of subnets to search.
+/// @param prefix prefix of the subnet.
+/// @param prefix_len length of the prefix.
+/// @return iterator pointing to the subnet, or end.
+template<typename SubnetIteratorType>
+SubnetIteratorType
+findSubnet(SubnetIteratorType begin, SubnetIteratorType end,
+           const IOAddress& prefix, uint8_t prefix_len) {
+    for (SubnetIteratorType subnet = begin; subnet != end; ++subnet) {
+        const std::pair<IOAddress, uint8_t> subnet_prefix = (*subnet)->get();
+        if ((subnet_prefix.second == prefix_len) &&
+            (subnet_prefix.first == prefix)) {
+            return (subnet);
+        }
+    }
+    return (end);
+}
+
+}
+
 namespace isc {
 namespace dhcp {
 
@@ -130,8 +194,9 @@ CfgMgr::getSubnet6(const std::string& iface) {
     }
 
     // If there is more than one, we need to choose the proper one
-    for (Subnet6Collection::iterator subnet = subnets6_.begin();
-         subnet != subnets6_.end(); ++subnet) {
+    const ConstSubnet6CollectionPtr subnets = getSubnets6();
+    for (Subnet6Collection::const_iterator subnet = subnets->begin();
+         subnet != subnets->end(); ++subnet) {
         if (iface == (*subnet)->getIface()) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET6_IFACE)
@@ -153,16 +218,17 @@ CfgMgr::getSubnet6(const isc::asiolink::IOAddress& hint) {
     // configuration. Such requirement makes sense in IPv4, but not in IPv6.
     // The server does not need to have a global address (using just link-local
     // is ok for DHCPv6 server) from the pool it serves.
-    if ((subnets6_.size() == 1) && hint.getAddress().to_v6().is_link_local()) {
+    const ConstSubnet6CollectionPtr subnets = getSubnets6();
+    if ((subnets->size() == 1) && hint.getAddress().to_v6().is_link_local()) {
         LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                   DHCPSRV_CFGMGR_ONLY_SUBNET6)
-                  .arg(subnets6_[0]->toText()).arg(hint.toText());
-        return (subnets6_[0]);
+                  .arg((*subnets)[0]->toText()).arg(hint.toText());
+        return ((*subnets)[0]);
     }
 
     // If there is more than one, we need to choose the proper one
-    for (Subnet6Collection::iterator subnet = subnets6_.begin();
-         subnet != subnets6_.end(); ++subnet) {
+    for (Subnet6Collection::const_iterator subnet = subnets->begin();
+         subnet != subnets->end(); ++subnet) {
 
         if ((*subnet)->inRange(hint)) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
@@ -188,7 +254,10 @@ void CfgMgr::addSubnet6(const Subnet6Ptr& subnet) {
     /// other already defined subnet.
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_ADD_SUBNET6)
               .arg(subnet->toText());
-    subnets6_.push_back(subnet);
+    boost::shared_ptr<Subnet6Collection>
+        subnets(new Subnet6Collection(*getSubnets6()));
+    subnets->push_back(subnet);
+    boost::atomic_store(&subnets6_, ConstSubnet6CollectionPtr(subnets));
 }
 
 Subnet4Ptr
@@ -202,16 +271,17 @@ CfgMgr::getSubnet4(const isc::asiolink::IOAddress& hint) {
     // configuration. Such requirement makes sense in IPv4, but not in IPv6.
     // The server does not need to have a global address (using just link-local
     // is ok for DHCPv6 server) from the pool it serves.
-    if (subnets4_.size() == 1) {
+    const ConstSubnet4CollectionPtr subnets = getSubnets4();
+    if (subnets->size() == 1) {
         LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                   DHCPSRV_CFGMGR_ONLY_SUBNET4)
-                  .arg(subnets4_[0]->toText()).arg(hint.toText());
-        return (subnets4_[0]);
+                  .arg((*subnets)[0]->toText()).arg(hint.toText());
+        return ((*subnets)[0]);
     }
 
     // If there is more than one, we need to choose the proper one
-    for (Subnet4Collection::iterator subnet = subnets4_.begin();
-         subnet != subnets4_.end(); ++subnet) {
+    for (Subnet4Collection::const_iterator subnet = subnets->begin();
+         subnet != subnets->end(); ++subnet) {
         if ((*subnet)->inRange(hint)) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET4)
@@ -231,7 +301,92 @@ void CfgMgr::addSubnet4(const Subnet4Ptr& subnet) {
     /// other already defined subnet.
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_ADD_SUBNET4)
               .arg(subnet->toText());
-    subnets4_.push_back(subnet);
+    boost::shared_ptr<Subnet4Collection>
+        subnets(new Subnet4Collection(*getSubnets4()));
+    subnets->push_back(subnet);
+    boost::atomic_store(&subnets4_, ConstSubnet4CollectionPtr(subnets));
+}
+
+Subnet6Ptr
+CfgMgr::getSubnet6ByPrefix(const IOAddress& prefix, uint8_t prefix_len) const {
+    const ConstSubnet6CollectionPtr subnets = getSubnets6();
+    Subnet6Collection::const_iterator subnet =
+        findSubnet(subnets->begin(), subnets->end(), prefix, prefix_len);
+    return (subnet != subnets->end() ? *subnet : Subnet6Ptr());
+}
+
+bool CfgMgr::updateSubnet6(const Subnet6Ptr& subnet) {
+    const std::pair<IOAddress, uint8_t> prefix = subnet->get();
+    boost::shared_ptr<Subnet6Collection>
+        subnets(new Subnet6Collection(*getSubnets6()));
+    Subnet6Collection::iterator current =
+        findSubnet(subnets->begin(), subnets->end(), prefix.first,
+                   prefix.second);
+    if (current == subnets->end()) {
+        return (false);
+    }
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_UPDATE_SUBNET6)
+              .arg(subnet->toText());
+    subnet->inheritState(**current);
+    *current = subnet;
+    boost::atomic_store(&subnets6_, ConstSubnet6CollectionPtr(subnets));
+    return (true);
+}
+
+bool CfgMgr::deleteSubnet6(const IOAddress& prefix, uint8_t prefix_len) {
+    boost::shared_ptr<Subnet6Collection>
+        subnets(new Subnet6Collection(*getSubnets6()));
+    Subnet6Collection::iterator subnet =
+        findSubnet(subnets->begin(), subnets->end(), prefix, prefix_len);
+    if (subnet == subnets->end()) {
+        return (false);
+    }
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_DEL_SUBNET6)
+              .arg((*subnet)->toText());
+    subnets->erase(subnet);
+    boost::atomic_store(&subnets6_, ConstSubnet6CollectionPtr(subnets));
+    return (true);
+}
+
+Subnet4Ptr
+CfgMgr::getSubnet4ByPrefix(const IOAddress& prefix, uint8_t prefix_len) const {
+    const ConstSubnet4CollectionPtr subnets = getSubnets4();
+    Subnet4Collection::const_iterator subnet =
+        findSubnet(subnets->begin(), subnets->end(), prefix, prefix_len);
+    return (subnet != subnets->end() ? *subnet : Subnet4Ptr());
+}
+
+bool CfgMgr::updateSubnet4(const Subnet4Ptr& subnet) {
+    const std::pair<IOAddress, uint8_t> prefix = subnet->get();
+    boost::shared_ptr<Subnet4Collection>
+        subnets(new Subnet4Collection(*getSubnets4()));
+    Subnet4Collection::iterator current =
+        findSubnet(subnets->begin(), subnets->end(), prefix.first,
+                   prefix.second);
+    if (current == subnets->end()) {
+        return (false);
+    }
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_UPDATE_SUBNET4)
+              .arg(subnet->toText());
+    subnet->inheritState(**current);
+    *current = subnet;
+    boost::atomic_store(&subnets4_, ConstSubnet4CollectionPtr(subnets));
+    return (true);
+}
+
+bool CfgMgr::deleteSubnet4(const IOAddress& prefix, uint8_t prefix_len) {
+    boost::shared_ptr<Subnet4Collection>
+        subnets(new Subnet4Collection(*getSubnets4()));
+    Subnet4Collection::iterator subnet =
+        findSubnet(subnets->begin(), subnets->end(), prefix, prefix_len);
+    if (subnet == subnets->end()) {
+        return (false);
+    }
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_DEL_SUBNET4)
+              .arg((*subnet)->toText());
+    subnets->erase(subnet);
+    boost::atomic_store(&subnets4_, ConstSubnet4CollectionPtr(subnets));
+    return (true);
 }
 
 void CfgMgr::deleteOptionDefs() {
@@ -240,12 +395,48 @@ void CfgMgr::deleteOptionDefs() {
 
 void CfgMgr::deleteSubnets4() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_DELETE_SUBNET4);
-    subnets4_.clear();
+    boost::atomic_store(&subnets4_,
+                        ConstSubnet4CollectionPtr(new Subnet4Collection()));
 }
 
 void CfgMgr::deleteSubnets6() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_DELETE_SUBNET6);
-    subnets6_.clear();
+    boost::atomic_store(&subnets6_,
+                        ConstSubnet6CollectionPtr(new Subnet6Collection()));
+}
+
+ConstSubnet4CollectionPtr
+CfgMgr::buildSubnets4(const Subnet4Collection& subnets) const {
+    boost::shared_ptr<Subnet4Collection> result(new Subnet4Collection());
+    const size_t inherited = inheritSubnets(subnets, *getSubnets4(), *result);
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+              DHCPSRV_CFGMGR_BUILD_SUBNETS4)
+        .arg(result->size()).arg(inherited);
+    return (result);
+}
+
+void CfgMgr::replaceSubnets4(const ConstSubnet4CollectionPtr& subnets) {
+    boost::atomic_store(&subnets4_, subnets);
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+              DHCPSRV_CFGMGR_REPLACE_SUBNETS4)
+        .arg(subnets->size());
+}
+
+ConstSubnet6CollectionPtr
+CfgMgr::buildSubnets6(const Subnet6Collection& subnets) const {
+    boost::shared_ptr<Subnet6Collection> result(new Subnet6Collection());
+    const size_t inherited = inheritSubnets(subnets, *getSubnets6(), *result);
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+              DHCPSRV_CFGMGR_BUILD_SUBNETS6)
+        .arg(result->size()).arg(inherited);
+    return (result);
+}
+
+void CfgMgr::replaceSubnets6(const ConstSubnet6CollectionPtr& subnets) {
+    boost::atomic_store(&subnets6_, subnets);
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+              DHCPSRV_CFGMGR_REPLACE_SUBNETS6)
+        .arg(subnets->size());
 }
 
 std::string CfgMgr::getDataDir() {
@@ -254,7 +445,8 @@ std::string CfgMgr::getDataDir() {
 
 
 CfgMgr::CfgMgr()
-    :datadir_(DHCP_DATA_DIR) {
+    :subnets6_(new Subnet6Collection()), subnets4_(new Subnet4Collection()),
+     datadir_(DHCP_DATA_DIR) {
     // DHCP_DATA_DIR must be set set with -DDHCP_DATA_DIR="..." in Makefile.am
     // Note: the definition of DHCP_DATA_DIR needs to include quotation marks
     // See AM_CPPFLAGS definition in Makefile.am
@@ -179,27 +179,79 @@ public:
 
     /// @brief adds an IPv6 subnet
     ///
+    /// The collection of the subnets is copied, so the servers install
+    /// the subnets of a configuration at once with @ref replaceSubnets6.
+    ///
     /// @param subnet new subnet to be added.
     void addSubnet6(const Subnet6Ptr& subnet);
 
+    /// @brief returns all configured IPv6 subnets
+    ///
+    /// The collection is never modified: the changes of the configuration
+    /// replace it, so the caller can keep using it while the configuration
+    /// changes.
+    ///
+    /// @return collection of the IPv6 subnets
+    ConstSubnet6CollectionPtr getSubnets6() const {
+        return (boost::atomic_load(&subnets6_));
+    }
+
+    /// @brief Builds the IPv6 subnets of a new configuration.
+    ///
+    /// This method is used during reconfiguration, before the new
+    /// configuration is committed. The new subnets which have the same
+    /// prefix as one of the current subnets take over its ID and
+    /// allocation state (see @ref Subnet::inheritState). The current
+    /// subnets are not modified.
+    ///
+    /// @param subnets new subnets.
+    /// @return collection to be installed with @ref replaceSubnets6.
+    ConstSubnet6CollectionPtr
+    buildSubnets6(const Subnet6Collection& subnets) const;
+
+    /// @brief Replaces all IPv6 subnets.
+    ///
+    /// The collection is installed with an atomic pointer swap, so a
+    /// lookup never sees a partial configuration. The subnets of the
+    /// collection should be built by @ref buildSubnets6 when the
+    /// configuration is parsed, as the allocation state is taken then.
+    ///
+    /// @param subnets new subnets.
+    void replaceSubnets6(const ConstSubnet6CollectionPtr& subnets);
+
+    /// @brief returns the IPv6 subnet with the specified prefix
+    ///
+    /// @param prefix prefix of the subnet.
+    /// @param prefix_len length of the prefix.
+    /// @return a subnet object (or NULL if there is no such subnet)
+    Subnet6Ptr getSubnet6ByPrefix(const isc::asiolink::IOAddress& prefix,
+                                  uint8_t prefix_len) const;
+
+    /// @brief replaces the IPv6 subnet with the same prefix
+    ///
+    /// The new subnet takes the place, the ID and the allocation state of
+    /// the existing subnet (see @ref Subnet::inheritState). The other
+    /// subnets are not affected.
+    ///
+    /// @param subnet new definition of the subnet.
+    /// @return false if there is no subnet with the same prefix.
+    bool updateSubnet6(const Subnet6Ptr& subnet);
+
+    /// @brief removes the IPv6 subnet with the specified prefix
+    ///
+    /// @param prefix prefix of the subnet.
+    /// @param prefix_len length of the prefix.
+    /// @return false if there is no such subnet.
+    bool deleteSubnet6(const isc::asiolink::IOAddress& prefix,
+                       uint8_t prefix_len);
+
     /// @brief Delete all option definitions.
     void deleteOptionDefs();
 
-    /// @todo: Add subnet6 removal routines. Currently it is not possible
-    /// to remove subnets. The only case where subnet6 removal would be
-    /// needed is a dynamic server reconfiguration - a use case that is not
-    /// planned to be supported any time soon.
-
     /// @brief removes all IPv6 subnets
     ///
-    /// This method removes all existing IPv6 subnets. It is used during
-    /// reconfiguration - old configuration is wiped and new definitions
-    /// are used to recreate subnets.
-    ///
-    /// @todo Implement more intelligent approach. Note that comparison
-    /// between old and new configuration is tricky. For example: is
-    /// 2000::/64 and 2000::/48 the same subnet or is it something
-    /// completely new?
+    /// This method removes all existing IPv6 subnets. The servers use
+    /// @ref replaceSubnets6 instead during reconfiguration.
     void deleteSubnets6();
 
     /// @brief get IPv4 subnet by address
@@ -218,18 +270,63 @@ public:
     /// @brief adds a subnet4
     void addSubnet4(const Subnet4Ptr& subnet);
 
-    /// @brief removes all IPv4 subnets
+    /// @brief returns all configured IPv4 subnets
     ///
-    /// This method removes all existing IPv4 subnets. It is used during
-    /// reconfiguration - old configuration is wiped and new definitions
-    /// are used to recreate subnets.
+    /// The IPv4 counterpart of @ref getSubnets6.
     ///
-    /// @todo Implement more intelligent approach. Note that comparison
-    /// between old and new configuration is tricky. For example: is
-    /// 192.0.2.0/23 and 192.0.2.0/24 the same subnet or is it something
-    /// completely new?
+    /// @return collection of the IPv4 subnets
+    ConstSubnet4CollectionPtr getSubnets4() const {
+        return (boost::atomic_load(&subnets4_));
+    }
+
+    /// @brief returns the IPv4 subnet with the specified prefix
+    ///
+    /// @param prefix prefix of the subnet.
+    /// @param prefix_len length of the prefix.
+    /// @return a subnet object (or NULL if there is no such subnet)
+    Subnet4Ptr getSubnet4ByPrefix(const isc::asiolink::IOAddress& prefix,
+                                  uint8_t prefix_len) const;
+
+    /// @brief replaces the IPv4 subnet with the same prefix
+    ///
+    /// The IPv4 counterpart of @ref updateSubnet6.
+    ///
+    /// @param subnet new definition of the subnet.
+    /// @return false if there is no subnet with the same prefix.
+    bool updateSubnet4(const Subnet4Ptr& subnet);
+
+    /// @brief removes the IPv4 subnet with the specified prefix
+    ///
+    /// @param prefix prefix of the subnet.
+    /// @param prefix_len length of the prefix.
+    /// @return false if there is no such subnet.
+    bool deleteSubnet4(const isc::asiolink::IOAddress& prefix,
+                       uint8_t prefix_len);
+
+    /// @brief removes all IPv4 subnets
+    ///
+    /// This method removes all existing IPv4 subnets. The servers use
+    /// @ref replaceSubnets4 instead during reconfiguration.
     void deleteSubnets4();
 
+    /// @brief Builds the IPv4 subnets of a new configuration.
+    ///
+    /// The IPv4 counterpart of @ref buildSubnets6. Subnets are matched
+    /// by prefix and prefix length, so 192.0.2.0/23 doesn't take over
+    /// 192.0.2.0/24.
+    ///
+    /// @param subnets new subnets.
+    /// @return collection to be installed with @ref replaceSubnets4.
+    ConstSubnet4CollectionPtr
+    buildSubnets4(const Subnet4Collection& subnets) const;
+
+    /// @brief Replaces all IPv4 subnets.
+    ///
+    /// The IPv4 counterpart of @ref replaceSubnets6.
+    ///
+    /// @param subnets new subnets.
+    void replaceSubnets4(const ConstSubnet4CollectionPtr& subnets);
+
 
     /// @brief returns path do the data directory
     ///
@@ -256,16 +353,14 @@ protected:
     /// That is a simple vector of pointers. It does not make much sense to
     /// optimize access time (e.g. using a map), because typical search
     /// pattern will use calling inRange() method on each subnet until
-    /// a match is found.
-    Subnet6Collection subnets6_;
+    /// a match is found. The container is not modified once installed:
+    /// a change installs a modified copy, with boost::atomic_store.
+    ConstSubnet6CollectionPtr subnets6_;
 
     /// @brief a container for IPv4 subnets.
     ///
-    /// That is a simple vector of pointers. It does not make much sense to
-    /// optimize access time (e.g. using a map), because typical search
-    /// pattern will use calling inRange() method on each subnet until
-    /// a match is found.
-    Subnet4Collection subnets4_;
+    /// The IPv4 counterpart of @ref subnets6_.
+    ConstSubnet4CollectionPtr subnets4_;
 
 private:
 
@@ -0,0 +1,134 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/hash_ring.h>
+#include <exceptions/exceptions.h>
+
+#include <algorithm>
+#include <map>
+
+namespace isc {
+namespace dhcp {
+
+const size_t HashRing::NO_MEMBER;
+const size_t HashRing::DEFAULT_REPLICAS;
+
+HashRing::HashRing(size_t replicas)
+    : replicas_(replicas) {
+    if (replicas == 0) {
+        isc_throw(BadValue, "number of points of a hash ring member"
+                  " must not be 0");
+    }
+}
+
+uint64_t
+HashRing::hash(const uint8_t* data, size_t len) {
+    // FNV-1a, followed by a finalizer mixing all bits, because FNV
+    // spreads short keys which differ in the last bytes poorly.
+    uint64_t value = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; ++i) {
+        value ^= data[i];
+        value *= 1099511628211ULL;
+    }
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return (value);
+}
+
+void
+HashRing::setMembers(const std::vector<std::string>& names) {
+    std::map<std::string, bool> previous;
+    for (size_t i = 0; i < names_.size(); ++i) {
+        previous[names_[i]] = up_[i];
+    }
+
+    std::vector<bool> up;
+    std::vector<std::pair<uint64_t, size_t> > points;
+    points.reserve(names.size() * replicas_);
+    for (size_t member = 0; member < names.size(); ++member) {
+        if (std::find(names.begin(), names.begin() + member,
+                      names[member]) != names.begin() + member) {
+            isc_throw(BadValue, "duplicate hash ring member "
+                      << names[member]);
+        }
+        std::map<std::string, bool>::const_iterator state =
+            previous.find(names[member]);
+        up.push_back(state == previous.end() || state->second);
+
+        // The points are the hashes of the name followed by the
+        // number of the point.
+        std::vector<uint8_t> point_key(names[member].begin(),
+                                       names[member].end());
+        point_key.resize(point_key.size() + 4);
+        for (uint32_t replica = 0; replica < replicas_; ++replica) {
+            uint8_t* number = &point_key[point_key.size() - 4];
+            number[0] = replica >> 24;
+            number[1] = (replica >> 16) & 0xff;
+            number[2] = (replica >> 8) & 0xff;
+            number[3] = replica & 0xff;
+            points.push_back(std::make_pair(hash(&point_key[0],
+                                                 point_key.size()),
+                                            member));
+        }
+    }
+    std::sort(points.begin(), points.end());
+
+    names_ = names;
+    up_.swap(up);
+    points_.swap(points);
+}
+
+void
+HashRing::setUp(size_t member, bool up) {
+    if (member >= up_.size()) {
+        isc_throw(OutOfRange, "no hash ring member " << member);
+    }
+    up_[member] = up;
+}
+
+bool
+HashRing::isUp(size_t member) const {
+    if (member >= up_.size()) {
+        isc_throw(OutOfRange, "no hash ring member " << member);
+    }
+    return (up_[member]);
+}
+
+size_t
+HashRing::select(const uint8_t* key, size_t key_len) const {
+    if (points_.empty()) {
+        return (NO_MEMBER);
+    }
+    const uint64_t key_hash = hash(key, key_len);
+    std::vector<std::pair<uint64_t, size_t> >::const_iterator point =
+        std::lower_bound(points_.begin(), points_.end(),
+                         std::make_pair(key_hash, static_cast<size_t>(0)));
+    // Go around the ring once, starting at the point of the key.
+    for (size_t checked = 0; checked < points_.size(); ++checked) {
+        if (point == points_.end()) {
+            point = points_.begin();
+        }
+        if (up_[point->second]) {
+            return (point->second);
+        }
+        ++point;
+    }
+    return (NO_MEMBER);
+}
+
+} // namespace isc::dhcp
+} // namespace isc
@@ -0,0 +1,114 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef HASH_RING_H
+#define HASH_RING_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Consistent hashing of clients to a set of servers.
+///
+/// Each member (e.g. a DHCPv4 server the DHCPv6 server forwards the
+/// DHCPv4-queries to) is placed at several points of a ring of 64 bit
+/// hash values, computed from its name. A key (e.g. the client
+/// identifier) is mapped to the member at the first point following the
+/// hash of the key. Members which are down are skipped, so their keys are
+/// spread over the next members of the ring, while the keys of the other
+/// members don't move. When a member is added or removed, only the keys
+/// between its points and the preceding points move.
+///
+/// The members are identified by their index in the list of the names
+/// given to @ref setMembers.
+class HashRing {
+public:
+    /// @brief Index returned by @ref select when no member is up.
+    static const size_t NO_MEMBER = static_cast<size_t>(-1);
+
+    /// @brief Default number of points of each member.
+    static const size_t DEFAULT_REPLICAS = 64;
+
+    /// @brief Constructor.
+    ///
+    /// @param replicas number of points of each member on the ring. More
+    /// points spread the keys more evenly.
+    /// @throw isc::BadValue if replicas is 0.
+    HashRing(size_t replicas = DEFAULT_REPLICAS);
+
+    /// @brief Sets the members.
+    ///
+    /// The members which were already members keep their state, the new
+    /// members are up.
+    ///
+    /// @param names names of the members.
+    /// @throw isc::BadValue if a name is given twice.
+    void setMembers(const std::vector<std::string>& names);
+
+    /// @brief Returns the names of the members.
+    const std::vector<std::string>& getMembers() const {
+        return (names_);
+    }
+
+    /// @brief Marks a member as up or down.
+    ///
+    /// @param member index of the member.
+    /// @param up true if the member is up.
+    /// @throw isc::OutOfRange if there is no such member.
+    void setUp(size_t member, bool up);
+
+    /// @brief Checks if a member is up.
+    ///
+    /// @param member index of the member.
+    /// @throw isc::OutOfRange if there is no such member.
+    bool isUp(size_t member) const;
+
+    /// @brief Returns the member a key is mapped to.
+    ///
+    /// @param key pointer to the key.
+    /// @param key_len length of the key.
+    /// @return index of the member, or NO_MEMBER if no member is up.
+    size_t select(const uint8_t* key, size_t key_len) const;
+
+    /// @brief Hashes a key.
+    ///
+    /// The hash doesn't depend on the platform, so all servers sharing
+    /// a ring map the keys the same way.
+    ///
+    /// @param data pointer to the key.
+    /// @param len length of the key.
+    /// @return hash of the key.
+    static uint64_t hash(const uint8_t* data, size_t len);
+
+private:
+    /// Number of points of each member.
+    size_t replicas_;
+    /// Names of the members.
+    std::vector<std::string> names_;
+    /// Is each member up.
+    std::vector<bool> up_;
+    /// Points of the ring (hash, member), sorted by hash.
+    std::vector<std::pair<uint64_t, size_t> > points_;
+};
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // HASH_RING_H
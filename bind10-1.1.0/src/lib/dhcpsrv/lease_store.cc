@@ -0,0 +1,880 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/hash_ring.h>
+#include <dhcpsrv/lease_store.h>
+#include <util/io_utilities.h>
+
+using namespace isc::asiolink;
+using namespace isc::util;
+
+namespace {
+
+/// Flags of the records.
+const uint8_t FLAG_FIXED = 1;
+const uint8_t FLAG_FQDN_FWD = 2;
+const uint8_t FLAG_FQDN_REV = 4;
+/// The lease has a client identifier (IPv4) or a DUID (IPv6).
+const uint8_t FLAG_ID = 8;
+/// The record holds a lease.
+const uint8_t FLAG_IN_USE = 16;
+
+/// Length of a field held in the extras.
+const uint8_t LONG = 0xff;
+
+/// Length of an IPv6 address.
+const size_t V6ADDR_LEN = 16;
+
+/// Identify the layout of the stores; to be changed with the records.
+const uint32_t LEASE4_STORE_MAGIC = 0x4c533431; // "LS41"
+const uint32_t LEASE6_STORE_MAGIC = 0x4c533631; // "LS61"
+
+/// @brief Fields of the extras.
+///
+/// The extras of a record are the lengths of these fields, 32 bits each,
+/// followed by their data.
+enum ExtrasField {
+    EXTRAS_HWADDR,
+    EXTRAS_ID,
+    EXTRAS_HOSTNAME,
+    EXTRAS_COMMENTS,
+    EXTRAS_FIELDS
+};
+
+/// @brief Returns the data of a vector, NULL if it is empty.
+const uint8_t*
+data(const std::vector<uint8_t>& vec) {
+    return (vec.empty() ? NULL : &vec[0]);
+}
+
+/// @brief Checks if a field of a record holds a key.
+bool
+sameKey(const uint8_t* field, size_t field_len,
+        const std::vector<uint8_t>& key) {
+    return ((field_len == key.size()) &&
+            ((field_len == 0) || (memcmp(field, &key[0], field_len) == 0)));
+}
+
+/// @brief Hashes a variable length key with two identifiers.
+uint64_t
+keyHash(const uint8_t* key, size_t len, uint32_t id1, uint32_t id2) {
+    uint8_t buf[16];
+    const uint64_t hash = isc::dhcp::HashRing::hash(key, len);
+    writeUint32(static_cast<uint32_t>(hash >> 32), buf);
+    writeUint32(static_cast<uint32_t>(hash), buf + 4);
+    writeUint32(id1, buf + 8);
+    writeUint32(id2, buf + 12);
+    return (isc::dhcp::HashRing::hash(buf, sizeof(buf)));
+}
+
+/// @brief Hashes an IPv4 address.
+uint64_t
+addressHash(uint32_t addr) {
+    uint8_t buf[4];
+    writeUint32(addr, buf);
+    return (isc::dhcp::HashRing::hash(buf, sizeof(buf)));
+}
+
+/// @brief Returns the flags of the common part of a lease.
+uint8_t
+leaseFlags(const isc::dhcp::Lease& lease) {
+    return ((lease.fixed_ ? FLAG_FIXED : 0) |
+            (lease.fqdn_fwd_ ? FLAG_FQDN_FWD : 0) |
+            (lease.fqdn_rev_ ? FLAG_FQDN_REV : 0));
+}
+
+/// @brief Sets the common part of a lease from the flags of a record.
+void
+setLeaseFlags(isc::dhcp::Lease& lease, uint8_t flags) {
+    lease.fixed_ = (flags & FLAG_FIXED) != 0;
+    lease.fqdn_fwd_ = (flags & FLAG_FQDN_FWD) != 0;
+    lease.fqdn_rev_ = (flags & FLAG_FQDN_REV) != 0;
+}
+
+/// @brief Copies an identifier into the space of a record.
+///
+/// @return length to be stored in the record, LONG if the identifier is
+/// in the extras.
+uint8_t
+storeId(const std::vector<uint8_t>& id, uint8_t* field, size_t field_len) {
+    if (id.size() > field_len) {
+        return (LONG);
+    }
+    if (!id.empty()) {
+        memcpy(field, &id[0], id.size());
+    }
+    return (static_cast<uint8_t>(id.size()));
+}
+
+/// @brief Returns the size of extras.
+size_t
+extrasSize(const uint8_t* extras) {
+    size_t size = EXTRAS_FIELDS * sizeof(uint32_t);
+    for (int field = 0; field < EXTRAS_FIELDS; ++field) {
+        size += reinterpret_cast<const uint32_t*>(extras)[field];
+    }
+    return (size);
+}
+
+/// @brief Returns a field of extras.
+const uint8_t*
+extrasField(const uint8_t* extras, ExtrasField field, size_t& len) {
+    const uint32_t* lens = reinterpret_cast<const uint32_t*>(extras);
+    const uint8_t* value = extras + EXTRAS_FIELDS * sizeof(uint32_t);
+    for (int i = 0; i < field; ++i) {
+        value += lens[i];
+    }
+    len = lens[field];
+    return (value);
+}
+
+/// @brief Allocates the extras of a lease, if it needs any.
+///
+/// @param segment segment the extras are allocated from.
+/// @param hwaddr hardware address too long for the record, or NULL.
+/// @param id identifier too long for the record, or NULL.
+/// @param lease lease.
+/// @return extras, or NULL if the lease needs none.
+/// @throw isc::util::MemorySegmentGrown if the segment has grown.
+uint8_t*
+createExtras(MemorySegment& segment, const std::vector<uint8_t>* hwaddr,
+             const std::vector<uint8_t>* id, const isc::dhcp::Lease& lease) {
+    if (!hwaddr && !id && lease.hostname_.empty() &&
+        lease.comments_.empty()) {
+        return (NULL);
+    }
+    uint32_t lens[EXTRAS_FIELDS];
+    lens[EXTRAS_HWADDR] = hwaddr ? hwaddr->size() : 0;
+    lens[EXTRAS_ID] = id ? id->size() : 0;
+    lens[EXTRAS_HOSTNAME] = lease.hostname_.size();
+    lens[EXTRAS_COMMENTS] = lease.comments_.size();
+    size_t size = sizeof(lens);
+    for (int field = 0; field < EXTRAS_FIELDS; ++field) {
+        size += lens[field];
+    }
+    uint8_t* extras = static_cast<uint8_t*>(segment.allocate(size));
+    memcpy(extras, lens, sizeof(lens));
+    uint8_t* value = extras + sizeof(lens);
+    if (hwaddr) {
+        memcpy(value, &(*hwaddr)[0], hwaddr->size());
+        value += hwaddr->size();
+    }
+    if (id) {
+        memcpy(value, &(*id)[0], id->size());
+        value += id->size();
+    }
+    memcpy(value, lease.hostname_.data(), lease.hostname_.size());
+    value += lease.hostname_.size();
+    memcpy(value, lease.comments_.data(), lease.comments_.size());
+    return (extras);
+}
+
+/// @brief Allocates the extras of an IPv4 lease, if it needs any.
+uint8_t*
+createExtras(MemorySegment& segment, const isc::dhcp::Lease4& lease) {
+    std::vector<uint8_t> client_id;
+    if (lease.client_id_) {
+        client_id = lease.client_id_->getClientId();
+    }
+    return (createExtras(segment,
+                         lease.hwaddr_.size() >
+                         isc::dhcp::Lease4Store::HWADDR_LEN ?
+                         &lease.hwaddr_ : NULL,
+                         client_id.size() >
+                         isc::dhcp::Lease4Store::CLIENT_ID_LEN ?
+                         &client_id : NULL, lease));
+}
+
+/// @brief Allocates the extras of an IPv6 lease, if it needs any.
+uint8_t*
+createExtras(MemorySegment& segment, const isc::dhcp::Lease6& lease) {
+    std::vector<uint8_t> duid;
+    if (lease.duid_) {
+        duid = lease.duid_->getDuid();
+    }
+    return (createExtras(segment, NULL,
+                         duid.size() > isc::dhcp::Lease6Store::DUID_LEN ?
+                         &duid : NULL, lease));
+}
+
+/// @brief Returns the extras of a record, NULL if it has none.
+///
+/// The extras are referenced by their offset from the record, so the
+/// records may be zeroed and don't depend on the address of the segment.
+template <typename Record>
+const uint8_t*
+getExtras(const Record& record) {
+    if (record.extras_ == 0) {
+        return (NULL);
+    }
+    return (reinterpret_cast<const uint8_t*>(&record) + record.extras_);
+}
+
+/// @brief Sets the extras of a record.
+template <typename Record>
+void
+setExtras(Record& record, const uint8_t* extras) {
+    record.extras_ = extras ?
+        (extras - reinterpret_cast<const uint8_t*>(&record)) : 0;
+}
+
+/// @brief Releases the extras of a record.
+template <typename Record>
+void
+releaseExtras(MemorySegment& segment, Record& record) {
+    const uint8_t* extras = getExtras(record);
+    if (extras) {
+        record.extras_ = 0;
+        segment.deallocate(const_cast<uint8_t*>(extras), extrasSize(extras));
+    }
+}
+
+/// @brief Copies the hostname and the comments of a record to a lease.
+template <typename Record>
+void
+getExtrasStrings(const Record& record, isc::dhcp::Lease& lease) {
+    const uint8_t* extras = getExtras(record);
+    if (extras) {
+        size_t len;
+        const uint8_t* value = extrasField(extras, EXTRAS_HOSTNAME, len);
+        lease.hostname_.assign(reinterpret_cast<const char*>(value), len);
+        value = extrasField(extras, EXTRAS_COMMENTS, len);
+        lease.comments_.assign(reinterpret_cast<const char*>(value), len);
+    }
+}
+
+}
+
+namespace isc {
+namespace dhcp {
+
+const uint32_t LeaseHandleIndex::NO_HANDLE;
+const uint32_t LeaseHandleIndex::EMPTY;
+const uint32_t LeaseHandleIndex::REMOVED;
+const size_t Lease4Store::HWADDR_LEN;
+const size_t Lease4Store::CLIENT_ID_LEN;
+const size_t Lease6Store::DUID_LEN;
+
+LeaseHandleIndex::LeaseHandleIndex()
+    : capacity_(0), used_(0), filled_(0) {
+}
+
+void
+LeaseHandleIndex::destroy(MemorySegment& segment) {
+    if (capacity_ > 0) {
+        segment.deallocate(slots_.get(), capacity_ * sizeof(Slot));
+    }
+    slots_ = static_cast<Slot*>(NULL);
+    capacity_ = used_ = filled_ = 0;
+}
+
+void
+LeaseHandleIndex::reserve(MemorySegment& segment) {
+    // At most 3/4 of the slots are filled, so a search always ends on an
+    // empty slot.
+    if ((static_cast<uint64_t>(filled_) + 1) * 4 <=
+        static_cast<uint64_t>(capacity_) * 3) {
+        return;
+    }
+    // The table is rebuilt without the removed slots, at most half full.
+    uint64_t capacity = 16;
+    while (capacity < (static_cast<uint64_t>(used_) + 1) * 2) {
+        capacity *= 2;
+    }
+    if (capacity > 0x80000000ULL) {
+        isc_throw(OutOfRange, "too many leases in an index");
+    }
+    Slot* slots = static_cast<Slot*>(segment.allocate(capacity *
+                                                      sizeof(Slot)));
+    for (uint64_t i = 0; i < capacity; ++i) {
+        slots[i].hash_ = 0;
+        slots[i].handle_ = EMPTY;
+    }
+    const size_t mask = capacity - 1;
+    const Slot* old_slots = slots_.get();
+    for (uint32_t i = 0; i < capacity_; ++i) {
+        if ((old_slots[i].handle_ == EMPTY) ||
+            (old_slots[i].handle_ == REMOVED)) {
+            continue;
+        }
+        size_t pos = old_slots[i].hash_ & mask;
+        while (slots[pos].handle_ != EMPTY) {
+            pos = (pos + 1) & mask;
+        }
+        slots[pos] = old_slots[i];
+    }
+    if (capacity_ > 0) {
+        segment.deallocate(slots_.get(), capacity_ * sizeof(Slot));
+    }
+    slots_ = slots;
+    capacity_ = capacity;
+    filled_ = used_;
+}
+
+void
+LeaseHandleIndex::insert(uint64_t hash, uint32_t handle) {
+    Slot* slots = slots_.get();
+    const size_t mask = capacity_ - 1;
+    size_t pos = start(hash);
+    while ((slots[pos].handle_ != EMPTY) && (slots[pos].handle_ != REMOVED)) {
+        pos = (pos + 1) & mask;
+    }
+    if (slots[pos].handle_ == EMPTY) {
+        ++filled_;
+    }
+    slots[pos].hash_ = static_cast<uint32_t>(hash);
+    slots[pos].handle_ = handle;
+    ++used_;
+}
+
+void
+LeaseHandleIndex::erase(uint64_t hash, uint32_t handle) {
+    if (capacity_ == 0) {
+        return;
+    }
+    Slot* slots = slots_.get();
+    const size_t mask = capacity_ - 1;
+    for (size_t pos = start(hash); slots[pos].handle_ != EMPTY;
+         pos = (pos + 1) & mask) {
+        if (slots[pos].handle_ == handle) {
+            // The slot can't be emptied, it may be on the way to another.
+            slots[pos].handle_ = REMOVED;
+            --used_;
+            return;
+        }
+    }
+}
+
+void
+LeaseHandleIndex::clear() {
+    Slot* slots = slots_.get();
+    for (uint32_t i = 0; i < capacity_; ++i) {
+        slots[i].handle_ = EMPTY;
+    }
+    used_ = filled_ = 0;
+}
+
+uint32_t
+LeaseHandleIndex::next(uint64_t hash, size_t& pos) const {
+    if (capacity_ == 0) {
+        return (NO_HANDLE);
+    }
+    const Slot* slots = slots_.get();
+    const size_t mask = capacity_ - 1;
+    const uint32_t hash32 = static_cast<uint32_t>(hash);
+    while (slots[pos].handle_ != EMPTY) {
+        const Slot& slot = slots[pos];
+        pos = (pos + 1) & mask;
+        if ((slot.handle_ != REMOVED) && (slot.hash_ == hash32)) {
+            return (slot.handle_);
+        }
+    }
+    return (NO_HANDLE);
+}
+
+Lease4Store::Lease4Store()
+    : magic_(LEASE4_STORE_MAGIC), record_size_(sizeof(Record)),
+      updating_(0) {
+}
+
+Lease4Store*
+Lease4Store::create(MemorySegment& segment) {
+    return (new(segment.allocate(sizeof(Lease4Store))) Lease4Store());
+}
+
+void
+Lease4Store::destroy(MemorySegment& segment, Lease4Store* store) {
+    for (uint32_t handle = 0; handle < store->records_.getLimit(); ++handle) {
+        releaseExtras(segment, store->records_[handle]);
+    }
+    store->records_.destroy(segment);
+    store->by_address_.destroy(segment);
+    store->by_hwaddr_.destroy(segment);
+    store->by_client_id_.destroy(segment);
+    store->~Lease4Store();
+    segment.deallocate(store, sizeof(Lease4Store));
+}
+
+bool
+Lease4Store::isValid() const {
+    return ((magic_ == LEASE4_STORE_MAGIC) && (record_size_ == sizeof(Record)));
+}
+
+void
+Lease4Store::recover(MemorySegment& segment) {
+    updating_ = 1;
+    by_address_.clear();
+    by_hwaddr_.clear();
+    by_client_id_.clear();
+    records_.clearFree();
+    for (uint32_t handle = 0; handle < records_.getLimit(); ++handle) {
+        const Record& record = records_[handle];
+        // A record whose extras were released is being removed.
+        if ((record.flags_ & FLAG_IN_USE) &&
+            ((record.extras_ != 0) ||
+             ((record.hwaddr_len_ != LONG) &&
+              (record.client_id_len_ != LONG)))) {
+            reserve(segment);
+            index(handle);
+        } else {
+            records_.addFree(handle);
+        }
+    }
+    updating_ = 0;
+}
+
+bool
+Lease4Store::add(MemorySegment& segment, const Lease4& lease) {
+    if (find(static_cast<uint32_t>(lease.addr_)) !=
+        LeaseHandleIndex::NO_HANDLE) {
+        return (false);
+    }
+    reserve(segment);
+    uint8_t* extras = createExtras(segment, lease);
+    updating_ = 1;
+    store(records_.allocate(), lease, extras);
+    updating_ = 0;
+    return (true);
+}
+
+Lease4Ptr
+Lease4Store::getByAddress(uint32_t addr) const {
+    const uint32_t handle = find(addr);
+    if (handle == LeaseHandleIndex::NO_HANDLE) {
+        return (Lease4Ptr());
+    }
+    return (get(handle));
+}
+
+Lease4Ptr
+Lease4Store::getByHWAddr(const std::vector<uint8_t>& hwaddr,
+                         SubnetID subnet_id) const {
+    const uint64_t hash = keyHash(data(hwaddr), hwaddr.size(), subnet_id, 0);
+    size_t pos = by_hwaddr_.start(hash);
+    for (uint32_t handle = by_hwaddr_.next(hash, pos);
+         handle != LeaseHandleIndex::NO_HANDLE;
+         handle = by_hwaddr_.next(hash, pos)) {
+        size_t len;
+        const uint8_t* field = getHWAddr(handle, len);
+        if ((records_[handle].subnet_id_ == subnet_id) &&
+            sameKey(field, len, hwaddr)) {
+            return (get(handle));
+        }
+    }
+    return (Lease4Ptr());
+}
+
+Lease4Ptr
+Lease4Store::getByClientId(const std::vector<uint8_t>& client_id,
+                           SubnetID subnet_id) const {
+    const uint64_t hash = keyHash(data(client_id), client_id.size(),
+                                  subnet_id, 0);
+    size_t pos = by_client_id_.start(hash);
+    for (uint32_t handle = by_client_id_.next(hash, pos);
+         handle != LeaseHandleIndex::NO_HANDLE;
+         handle = by_client_id_.next(hash, pos)) {
+        size_t len;
+        const uint8_t* field = getClientId(handle, len);
+        if ((records_[handle].subnet_id_ == subnet_id) &&
+            sameKey(field, len, client_id)) {
+            return (get(handle));
+        }
+    }
+    return (Lease4Ptr());
+}
+
+bool
+Lease4Store::update(MemorySegment& segment, const Lease4& lease) {
+    const uint32_t handle = find(static_cast<uint32_t>(lease.addr_));
+    if (handle == LeaseHandleIndex::NO_HANDLE) {
+        return (false);
+    }
+    reserve(segment);
+    uint8_t* extras = createExtras(segment, lease);
+    updating_ = 1;
+    unstore(segment, handle);
+    store(handle, lease, extras);
+    updating_ = 0;
+    return (true);
+}
+
+bool
+Lease4Store::erase(MemorySegment& segment, uint32_t addr) {
+    const uint32_t handle = find(addr);
+    if (handle == LeaseHandleIndex::NO_HANDLE) {
+        return (false);
+    }
+    updating_ = 1;
+    unstore(segment, handle);
+    records_.release(handle);
+    updating_ = 0;
+    return (true);
+}
+
+void
+Lease4Store::reserve(MemorySegment& segment) {
+    records_.reserve(segment);
+    by_address_.reserve(segment);
+    by_hwaddr_.reserve(segment);
+    by_client_id_.reserve(segment);
+}
+
+uint32_t
+Lease4Store::find(uint32_t addr) const {
+    const uint64_t hash = addressHash(addr);
+    size_t pos = by_address_.start(hash);
+    for (uint32_t handle = by_address_.next(hash, pos);
+         handle != LeaseHandleIndex::NO_HANDLE;
+         handle = by_address_.next(hash, pos)) {
+        if (records_[handle].addr_ == addr) {
+            return (handle);
+        }
+    }
+    return (LeaseHandleIndex::NO_HANDLE);
+}
+
+void
+Lease4Store::store(uint32_t handle, const Lease4& lease, uint8_t* extras) {
+    Record& record = records_[handle];
+    memset(&record, 0, sizeof(record));
+    record.addr_ = static_cast<uint32_t>(lease.addr_);
+    record.subnet_id_ = lease.subnet_id_;
+    record.t1_ = lease.t1_;
+    record.t2_ = lease.t2_;
+    record.valid_lft_ = lease.valid_lft_;
+    record.ext_ = lease.ext_;
+    record.cltt_ = lease.cltt_;
+    setExtras(record, extras);
+    record.hwaddr_len_ = storeId(lease.hwaddr_, record.hwaddr_, HWADDR_LEN);
+    record.flags_ = leaseFlags(lease);
+    if (lease.client_id_) {
+        record.flags_ |= FLAG_ID;
+        record.client_id_len_ = storeId(lease.client_id_->getClientId(),
+                                        record.client_id_, CLIENT_ID_LEN);
+    }
+    record.flags_ |= FLAG_IN_USE;
+    index(handle);
+}
+
+void
+Lease4Store::unstore(MemorySegment& segment, uint32_t handle) {
+    Record& record = records_[handle];
+    by_address_.erase(addressHash(record.addr_), handle);
+    size_t len;
+    const uint8_t* key = getHWAddr(handle, len);
+    by_hwaddr_.erase(keyHash(key, len, record.subnet_id_, 0), handle);
+    if (record.flags_ & FLAG_ID) {
+        key = getClientId(handle, len);
+        by_client_id_.erase(keyHash(key, len, record.subnet_id_, 0), handle);
+    }
+    record.flags_ &= ~FLAG_IN_USE;
+    releaseExtras(segment, record);
+}
+
+void
+Lease4Store::index(uint32_t handle) {
+    const Record& record = records_[handle];
+    by_address_.insert(addressHash(record.addr_), handle);
+    size_t len;
+    const uint8_t* key = getHWAddr(handle, len);
+    by_hwaddr_.insert(keyHash(key, len, record.subnet_id_, 0), handle);
+    if (record.flags_ & FLAG_ID) {
+        key = getClientId(handle, len);
+        by_client_id_.insert(keyHash(key, len, record.subnet_id_, 0), handle);
+    }
+}
+
+Lease4Ptr
+Lease4Store::get(uint32_t handle) const {
+    const Record& record = records_[handle];
+    Lease4Ptr lease(new Lease4());
+    lease->addr_ = IOAddress(record.addr_);
+    lease->subnet_id_ = record.subnet_id_;
+    lease->t1_ = record.t1_;
+    lease->t2_ = record.t2_;
+    lease->valid_lft_ = record.valid_lft_;
+    lease->ext_ = record.ext_;
+    lease->cltt_ = static_cast<time_t>(record.cltt_);
+    setLeaseFlags(*lease, record.flags_);
+
+    size_t len;
+    const uint8_t* field = getHWAddr(handle, len);
+    lease->hwaddr_.assign(field, field + len);
+    if (record.flags_ & FLAG_ID) {
+        field = getClientId(handle, len);
+        lease->client_id_.reset(new ClientId(field, len));
+    }
+    getExtrasStrings(record, *lease);
+    return (lease);
+}
+
+const uint8_t*
+Lease4Store::getHWAddr(uint32_t handle, size_t& len) const {
+    const Record& record = records_[handle];
+    if (record.hwaddr_len_ == LONG) {
+        return (extrasField(getExtras(record), EXTRAS_HWADDR, len));
+    }
+    len = record.hwaddr_len_;
+    return (record.hwaddr_);
+}
+
+const uint8_t*
+Lease4Store::getClientId(uint32_t handle, size_t& len) const {
+    const Record& record = records_[handle];
+    if (record.client_id_len_ == LONG) {
+        return (extrasField(getExtras(record), EXTRAS_ID, len));
+    }
+    len = record.client_id_len_;
+    return (record.client_id_);
+}
+
+Lease6Store::Lease6Store()
+    : magic_(LEASE6_STORE_MAGIC), record_size_(sizeof(Record)),
+      updating_(0) {
+}
+
+Lease6Store*
+Lease6Store::create(MemorySegment& segment) {
+    return (new(segment.allocate(sizeof(Lease6Store))) Lease6Store());
+}
+
+void
+Lease6Store::destroy(MemorySegment& segment, Lease6Store* store) {
+    for (uint32_t handle = 0; handle < store->records_.getLimit(); ++handle) {
+        releaseExtras(segment, store->records_[handle]);
+    }
+    store->records_.destroy(segment);
+    store->by_address_.destroy(segment);
+    store->by_duid_.destroy(segment);
+    store->~Lease6Store();
+    segment.deallocate(store, sizeof(Lease6Store));
+}
+
+bool
+Lease6Store::isValid() const {
+    return ((magic_ == LEASE6_STORE_MAGIC) && (record_size_ == sizeof(Record)));
+}
+
+void
+Lease6Store::recover(MemorySegment& segment) {
+    updating_ = 1;
+    by_address_.clear();
+    by_duid_.clear();
+    records_.clearFree();
+    for (uint32_t handle = 0; handle < records_.getLimit(); ++handle) {
+        const Record& record = records_[handle];
+        // A record whose extras were released is being removed.
+        if ((record.flags_ & FLAG_IN_USE) &&
+            ((record.extras_ != 0) || (record.duid_len_ != LONG))) {
+            reserve(segment);
+            index(handle);
+        } else {
+            records_.addFree(handle);
+        }
+    }
+    updating_ = 0;
+}
+
+bool
+Lease6Store::add(MemorySegment& segment, const Lease6& lease) {
+    const std::vector<uint8_t> addr = lease.addr_.toBytes();
+    if ((addr.size() != V6ADDR_LEN) ||
+        (find(&addr[0]) != LeaseHandleIndex::NO_HANDLE)) {
+        return (false);
+    }
+    reserve(segment);
+    uint8_t* extras = createExtras(segment, lease);
+    updating_ = 1;
+    store(records_.allocate(), lease, extras);
+    updating_ = 0;
+    return (true);
+}
+
+Lease6Ptr
+Lease6Store::getByAddress(const IOAddress& addr) const {
+    if (!addr.isV6()) {
+        return (Lease6Ptr());
+    }
+    const uint32_t handle = find(&addr.toBytes()[0]);
+    if (handle == LeaseHandleIndex::NO_HANDLE) {
+        return (Lease6Ptr());
+    }
+    return (get(handle));
+}
+
+Lease6Ptr
+Lease6Store::getByDuid(const std::vector<uint8_t>& duid, uint32_t iaid,
+                       SubnetID subnet_id) const {
+    const uint64_t hash = keyHash(data(duid), duid.size(), iaid, subnet_id);
+    size_t pos = by_duid_.start(hash);
+    for (uint32_t handle = by_duid_.next(hash, pos);
+         handle != LeaseHandleIndex::NO_HANDLE;
+         handle = by_duid_.next(hash, pos)) {
+        const Record& record = records_[handle];
+        size_t len;
+        const uint8_t* field = getDuid(handle, len);
+        if ((record.iaid_ == iaid) && (record.subnet_id_ == subnet_id) &&
+            sameKey(field, len, duid)) {
+            return (get(handle));
+        }
+    }
+    return (Lease6Ptr());
+}
+
+bool
+Lease6Store::update(MemorySegment& segment, const Lease6& lease) {
+    if (!lease.addr_.isV6()) {
+        return (false);
+    }
+    const uint32_t handle = find(&lease.addr_.toBytes()[0]);
+    if (handle == LeaseHandleIndex::NO_HANDLE) {
+        return (false);
+    }
+    reserve(segment);
+    uint8_t* extras = createExtras(segment, lease);
+    updating_ = 1;
+    unstore(segment, handle);
+    store(handle, lease, extras);
+    updating_ = 0;
+    return (true);
+}
+
+bool
+Lease6Store::erase(MemorySegment& segment, const IOAddress& addr) {
+    if (!addr.isV6()) {
+        return (false);
+    }
+    const uint32_t handle = find(&addr.toBytes()[0]);
+    if (handle == LeaseHandleIndex::NO_HANDLE) {
+        return (false);
+    }
+    updating_ = 1;
+    unstore(segment, handle);
+    records_.release(handle);
+    updating_ = 0;
+    return (true);
+}
+
+void
+Lease6Store::reserve(MemorySegment& segment) {
+    records_.reserve(segment);
+    by_address_.reserve(segment);
+    by_duid_.reserve(segment);
+}
+
+uint32_t
+Lease6Store::find(const uint8_t* addr) const {
+    const uint64_t hash = HashRing::hash(addr, V6ADDR_LEN);
+    size_t pos = by_address_.start(hash);
+    for (uint32_t handle = by_address_.next(hash, pos);
+         handle != LeaseHandleIndex::NO_HANDLE;
+         handle = by_address_.next(hash, pos)) {
+        if (memcmp(records_[handle].addr_, addr, V6ADDR_LEN) == 0) {
+            return (handle);
+        }
+    }
+    return (LeaseHandleIndex::NO_HANDLE);
+}
+
+void
+Lease6Store::store(uint32_t handle, const Lease6& lease, uint8_t* extras) {
+    Record& record = records_[handle];
+    memset(&record, 0, sizeof(record));
+    const std::vector<uint8_t> addr = lease.addr_.toBytes();
+    memcpy(record.addr_, &addr[0], sizeof(record.addr_));
+    record.iaid_ = lease.iaid_;
+    record.subnet_id_ = lease.subnet_id_;
+    record.preferred_lft_ = lease.preferred_lft_;
+    record.valid_lft_ = lease.valid_lft_;
+    record.t1_ = lease.t1_;
+    record.t2_ = lease.t2_;
+    record.cltt_ = lease.cltt_;
+    setExtras(record, extras);
+    record.type_ = static_cast<uint8_t>(lease.type_);
+    record.prefixlen_ = lease.prefixlen_;
+    record.flags_ = leaseFlags(lease);
+    if (lease.duid_) {
+        record.flags_ |= FLAG_ID;
+        record.duid_len_ = storeId(lease.duid_->getDuid(), record.duid_,
+                                   DUID_LEN);
+    }
+    record.flags_ |= FLAG_IN_USE;
+    index(handle);
+}
+
+void
+Lease6Store::unstore(MemorySegment& segment, uint32_t handle) {
+    Record& record = records_[handle];
+    by_address_.erase(HashRing::hash(record.addr_, sizeof(record.addr_)),
+                      handle);
+    if (record.flags_ & FLAG_ID) {
+        size_t len;
+        const uint8_t* key = getDuid(handle, len);
+        by_duid_.erase(keyHash(key, len, record.iaid_, record.subnet_id_),
+                       handle);
+    }
+    record.flags_ &= ~FLAG_IN_USE;
+    releaseExtras(segment, record);
+}
+
+void
+Lease6Store::index(uint32_t handle) {
+    const Record& record = records_[handle];
+    by_address_.insert(HashRing::hash(record.addr_, sizeof(record.addr_)),
+                       handle);
+    if (record.flags_ & FLAG_ID) {
+        size_t len;
+        const uint8_t* key = getDuid(handle, len);
+        by_duid_.insert(keyHash(key, len, record.iaid_, record.subnet_id_),
+                        handle);
+    }
+}
+
+Lease6Ptr
+Lease6Store::get(uint32_t handle) const {
+    const Record& record = records_[handle];
+    Lease6Ptr lease(new Lease6());
+    lease->addr_ = IOAddress::fromBytes(AF_INET6, record.addr_);
+    lease->iaid_ = record.iaid_;
+    lease->subnet_id_ = record.subnet_id_;
+    lease->preferred_lft_ = record.preferred_lft_;
+    lease->valid_lft_ = record.valid_lft_;
+    lease->t1_ = record.t1_;
+    lease->t2_ = record.t2_;
+    lease->cltt_ = static_cast<time_t>(record.cltt_);
+    lease->type_ = static_cast<Lease6::LeaseType>(record.type_);
+    lease->prefixlen_ = record.prefixlen_;
+    setLeaseFlags(*lease, record.flags_);
+
+    if (record.flags_ & FLAG_ID) {
+        size_t len;
+        const uint8_t* field = getDuid(handle, len);
+        lease->duid_.reset(new DUID(field, len));
+    }
+    getExtrasStrings(record, *lease);
+    return (lease);
+}
+
+const uint8_t*
+Lease6Store::getDuid(uint32_t handle, size_t& len) const {
+    const Record& record = records_[handle];
+    if (record.duid_len_ == LONG) {
+        return (extrasField(getExtras(record), EXTRAS_ID, len));
+    }
+    len = record.duid_len_;
+    return (record.duid_);
+}
+
+} // namespace isc::dhcp
+} // namespace isc
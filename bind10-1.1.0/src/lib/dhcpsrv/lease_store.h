@@ -0,0 +1,611 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef LEASE_STORE_H
+#define LEASE_STORE_H
+
+#include <dhcpsrv/lease_mgr.h>
+#include <util/memory_segment.h>
+
+#include <boost/interprocess/offset_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <new>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Open addressing hash table of record handles.
+///
+/// The table maps the hash of a key to the handles of the records having
+/// this key. It doesn't hold the keys: several keys may have the same
+/// hash, so the caller checks each record returned by @ref next. Each slot
+/// takes 8 bytes (32 bits of the hash and the handle), which is much less
+/// than a node of an ordered index. The table holds up to 2^32 slots.
+///
+/// The slots are allocated from a memory segment and referenced by offset,
+/// so the table may live in a segment mapped at another address by another
+/// process. Only @ref reserve allocates memory: it is called before
+/// @ref insert, so a segment which grows (see
+/// @ref isc::util::MemorySegment::allocate) leaves the table unchanged.
+class LeaseHandleIndex : public boost::noncopyable {
+public:
+    /// @brief Handle returned by @ref next when there is no more record.
+    static const uint32_t NO_HANDLE = 0xffffffff;
+
+    /// @brief Constructor.
+    LeaseHandleIndex();
+
+    /// @brief Releases the slots.
+    ///
+    /// @param segment segment the slots were allocated from.
+    void destroy(isc::util::MemorySegment& segment);
+
+    /// @brief Makes room for a handle.
+    ///
+    /// @param segment segment the slots are allocated from.
+    /// @throw isc::util::MemorySegmentGrown if the segment has grown; the
+    /// table is unchanged.
+    void reserve(isc::util::MemorySegment& segment);
+
+    /// @brief Adds a handle.
+    ///
+    /// @ref reserve must have been called.
+    ///
+    /// @param hash hash of the key of the record.
+    /// @param handle handle of the record.
+    void insert(uint64_t hash, uint32_t handle);
+
+    /// @brief Removes a handle.
+    ///
+    /// @param hash hash of the key of the record, as given to @ref insert.
+    /// @param handle handle of the record.
+    void erase(uint64_t hash, uint32_t handle);
+
+    /// @brief Removes all handles, keeping the slots.
+    void clear();
+
+    /// @brief Returns the position where the search of a hash starts.
+    ///
+    /// @param hash hash of the searched key.
+    size_t start(uint64_t hash) const {
+        return (capacity_ == 0 ? 0 :
+                (static_cast<uint32_t>(hash) & (capacity_ - 1)));
+    }
+
+    /// @brief Returns the next handle of the records with a hash.
+    ///
+    /// @param hash hash of the searched key.
+    /// @param [in,out] pos position returned by @ref start, updated past
+    /// the returned handle.
+    /// @return handle of the record, or NO_HANDLE.
+    uint32_t next(uint64_t hash, size_t& pos) const;
+
+    /// @brief Returns the number of handles.
+    size_t size() const {
+        return (used_);
+    }
+
+private:
+    /// Handle of a slot which was never used.
+    static const uint32_t EMPTY = NO_HANDLE;
+    /// Handle of a slot whose handle was removed.
+    static const uint32_t REMOVED = 0xfffffffe;
+
+    /// @brief Slot of the table.
+    struct Slot {
+        /// Lower 32 bits of the hash, which give the position.
+        uint32_t hash_;
+        /// Handle, EMPTY or REMOVED.
+        uint32_t handle_;
+    };
+
+    /// Slots, a power of two of them.
+    boost::interprocess::offset_ptr<Slot> slots_;
+    /// Number of slots.
+    uint32_t capacity_;
+    /// Number of handles.
+    uint32_t used_;
+    /// Number of slots which are not empty, i.e. used or removed.
+    uint32_t filled_;
+};
+
+/// @brief Records in slabs, addressed by 32 bit handles.
+///
+/// The records are allocated by slabs of SLAB_SIZE records from a memory
+/// segment. The slabs never move, so handles stay valid until the record
+/// is released. Released records are reused first: a released record
+/// holds the handle of the next released one in its first 4 bytes.
+///
+/// As for @ref LeaseHandleIndex, only @ref reserve allocates memory.
+///
+/// @tparam Record plain old data record, at least 4 bytes long.
+template <typename Record>
+class RecordSlabs : public boost::noncopyable {
+public:
+    /// @brief Handle of no record.
+    static const uint32_t NO_HANDLE = 0xffffffff;
+
+    /// @brief Number of bits of a handle selecting a record in a slab.
+    static const uint32_t SLAB_BITS = 12;
+
+    /// @brief Number of records of a slab.
+    static const uint32_t SLAB_SIZE = 1 << SLAB_BITS;
+
+    /// @brief Constructor.
+    RecordSlabs()
+        : slab_count_(0), table_size_(0), free_(NO_HANDLE), next_(0),
+          count_(0) {
+    }
+
+    /// @brief Releases the slabs.
+    ///
+    /// @param segment segment the slabs were allocated from.
+    void destroy(isc::util::MemorySegment& segment) {
+        for (uint32_t i = 0; i < slab_count_; ++i) {
+            segment.deallocate(slabs_[i].get(), SLAB_SIZE * sizeof(Record));
+        }
+        if (table_size_ > 0) {
+            segment.deallocate(slabs_.get(), table_size_ * sizeof(SlabPtr));
+        }
+        slabs_ = static_cast<SlabPtr*>(NULL);
+        slab_count_ = table_size_ = 0;
+        free_ = NO_HANDLE;
+        next_ = count_ = 0;
+    }
+
+    /// @brief Makes room for a record.
+    ///
+    /// @param segment segment the slabs are allocated from.
+    /// @throw isc::util::MemorySegmentGrown if the segment has grown.
+    void reserve(isc::util::MemorySegment& segment) {
+        if ((free_ != NO_HANDLE) || (next_ < slab_count_ * SLAB_SIZE)) {
+            return;
+        }
+        if (slab_count_ == table_size_) {
+            const uint32_t size = (table_size_ == 0) ? 16 : table_size_ * 2;
+            SlabPtr* table =
+                static_cast<SlabPtr*>(segment.allocate(size * sizeof(SlabPtr)));
+            for (uint32_t i = 0; i < size; ++i) {
+                new(&table[i]) SlabPtr(i < slab_count_ ? slabs_[i].get() :
+                                       NULL);
+            }
+            if (table_size_ > 0) {
+                segment.deallocate(slabs_.get(),
+                                   table_size_ * sizeof(SlabPtr));
+            }
+            slabs_ = table;
+            table_size_ = size;
+        }
+        Record* slab =
+            static_cast<Record*>(segment.allocate(SLAB_SIZE * sizeof(Record)));
+        memset(slab, 0, SLAB_SIZE * sizeof(Record));
+        slabs_[slab_count_] = slab;
+        ++slab_count_;
+    }
+
+    /// @brief Allocates a zeroed record.
+    ///
+    /// @ref reserve must have been called.
+    ///
+    /// @return handle of the record.
+    uint32_t allocate() {
+        uint32_t handle;
+        if (free_ != NO_HANDLE) {
+            handle = free_;
+            Record& record = (*this)[handle];
+            memcpy(&free_, &record, sizeof(free_));
+            memset(&record, 0, sizeof(Record));
+        } else {
+            handle = next_++;
+        }
+        ++count_;
+        return (handle);
+    }
+
+    /// @brief Releases a record.
+    ///
+    /// @param handle handle of the record.
+    void release(uint32_t handle) {
+        Record& record = (*this)[handle];
+        memset(&record, 0, sizeof(Record));
+        memcpy(&record, &free_, sizeof(free_));
+        free_ = handle;
+        --count_;
+    }
+
+    /// @brief Forgets the released records.
+    ///
+    /// The records below @ref getLimit are then either in use again
+    /// or given to @ref addFree.
+    void clearFree() {
+        free_ = NO_HANDLE;
+        count_ = next_;
+    }
+
+    /// @brief Adds a record to the released records.
+    ///
+    /// @param handle handle of the record.
+    void addFree(uint32_t handle) {
+        release(handle);
+    }
+
+    /// @brief Returns a record.
+    ///
+    /// @param handle handle of an allocated record.
+    Record& operator[](uint32_t handle) {
+        return (slabs_[handle >> SLAB_BITS][handle & (SLAB_SIZE - 1)]);
+    }
+
+    /// @brief Returns a record.
+    ///
+    /// @param handle handle of an allocated record.
+    const Record& operator[](uint32_t handle) const {
+        return (slabs_[handle >> SLAB_BITS][handle & (SLAB_SIZE - 1)]);
+    }
+
+    /// @brief Returns the number of allocated records.
+    size_t size() const {
+        return (count_);
+    }
+
+    /// @brief Returns the handle of the first record never allocated.
+    uint32_t getLimit() const {
+        return (next_);
+    }
+
+private:
+    /// Pointer to a slab.
+    typedef boost::interprocess::offset_ptr<Record> SlabPtr;
+
+    /// Table of the slabs.
+    boost::interprocess::offset_ptr<SlabPtr> slabs_;
+    /// Number of slabs.
+    uint32_t slab_count_;
+    /// Size of the table of the slabs.
+    uint32_t table_size_;
+    /// Handle of the last released record.
+    uint32_t free_;
+    /// Handle of the first record never allocated.
+    uint32_t next_;
+    /// Number of allocated records.
+    uint32_t count_;
+};
+
+/// @brief Compact storage of IPv4 leases.
+///
+/// Each lease is a fixed size record of 80 bytes, with the hardware
+/// address and a short client identifier held inline, instead of a Lease4
+/// object with its vector, client identifier object and strings, each
+/// allocated separately. The few leases with longer identifiers, a
+/// hostname or comments have these in a separate block. The leases are
+/// searched through hash tables of handles by address, by hardware address
+/// and subnet, and by client identifier and subnet.
+///
+/// The Lease4 objects are built on each search: modifying a returned lease
+/// doesn't modify the stored one, @ref update has to be called.
+///
+/// The store is allocated from a memory segment and only holds offsets,
+/// so it can be kept in a file mapped by @ref isc::util::MemorySegmentMapped
+/// and used again by the next process mapping the file. The methods which
+/// allocate memory throw isc::util::MemorySegmentGrown when the segment
+/// grows, before changing anything: the caller gets the new address of
+/// the store from the segment and calls the method again.
+class Lease4Store : public boost::noncopyable {
+public:
+    /// @brief Space of the hardware address in a record.
+    static const size_t HWADDR_LEN = 20;
+
+    /// @brief Space of the client identifier in a record.
+    static const size_t CLIENT_ID_LEN = 16;
+
+    /// @brief Creates an empty store.
+    ///
+    /// @param segment segment the store is allocated from.
+    /// @throw isc::util::MemorySegmentGrown if the segment has grown.
+    static Lease4Store* create(isc::util::MemorySegment& segment);
+
+    /// @brief Destroys a store.
+    ///
+    /// @param segment segment the store was allocated from.
+    /// @param store store to be destroyed.
+    static void destroy(isc::util::MemorySegment& segment, Lease4Store* store);
+
+    /// @brief Checks that the store was created by this version of the code.
+    bool isValid() const;
+
+    /// @brief Checks if a change was interrupted.
+    ///
+    /// When the process changing a store kept in a file stops in the middle
+    /// of a change, the next one must call @ref recover.
+    bool isInterrupted() const {
+        return (updating_ != 0);
+    }
+
+    /// @brief Rebuilds the indexes from the records.
+    ///
+    /// @param segment segment the store is allocated from.
+    /// @throw isc::util::MemorySegmentGrown if the segment has grown.
+    void recover(isc::util::MemorySegment& segment);
+
+    /// @brief Adds a lease.
+    ///
+    /// @param segment segment the store is allocated from.
+    /// @param lease lease to be added.
+    /// @return false if there is a lease for the address already.
+    /// @throw isc::util::MemorySegmentGrown if the segment has grown.
+    bool add(isc::util::MemorySegment& segment, const Lease4& lease);
+
+    /// @brief Returns the lease of an address.
+    ///
+    /// @param addr IPv4 address.
+    /// @return lease, or NULL if there is none.
+    Lease4Ptr getByAddress(uint32_t addr) const;
+
+    /// @brief Returns the lease of a hardware address in a subnet.
+    ///
+    /// @param hwaddr hardware address.
+    /// @param subnet_id identifier of the subnet.
+    /// @return lease, one of them if there are several, or NULL.
+    Lease4Ptr getByHWAddr(const std::vector<uint8_t>& hwaddr,
+                          SubnetID subnet_id) const;
+
+    /// @brief Returns the lease of a client identifier in a subnet.
+    ///
+    /// @param client_id client identifier.
+    /// @param subnet_id identifier of the subnet.
+    /// @return lease, one of them if there are several, or NULL.
+    Lease4Ptr getByClientId(const std::vector<uint8_t>& client_id,
+                            SubnetID subnet_id) const;
+
+    /// @brief Replaces the lease of the address of a lease.
+    ///
+    /// @param segment segment the store is allocated from.
+    /// @param lease new lease.
+    /// @return false if there is no lease for the address.
+    /// @throw isc::util::MemorySegmentGrown if the segment has grown.
+    bool update(isc::util::MemorySegment& segment, const Lease4& lease);
+
+    /// @brief Removes the lease of an address.
+    ///
+    /// @param segment segment the store is allocated from.
+    /// @param addr IPv4 address.
+    /// @return false if there is no lease for the address.
+    bool erase(isc::util::MemorySegment& segment, uint32_t addr);
+
+    /// @brief Returns the number of leases.
+    size_t size() const {
+        return (records_.size());
+    }
+
+private:
+    /// @brief Constructor.
+    Lease4Store();
+
+    /// @brief Lease record.
+    struct Record {
+        uint32_t addr_;
+        uint32_t subnet_id_;
+        uint32_t t1_;
+        uint32_t t2_;
+        uint32_t valid_lft_;
+        uint32_t ext_;
+        int64_t cltt_;
+        /// Offset of the extras from the record, 0 if none.
+        int64_t extras_;
+        uint8_t hwaddr_[HWADDR_LEN];
+        /// Length of the hardware address, LONG if in the extras.
+        uint8_t hwaddr_len_;
+        /// Length of the client identifier, LONG if in the extras.
+        uint8_t client_id_len_;
+        uint8_t flags_;
+        uint8_t client_id_[CLIENT_ID_LEN];
+    };
+
+    /// @brief Makes room for a lease in the records and the indexes.
+    void reserve(isc::util::MemorySegment& segment);
+
+    /// @brief Returns the handle of the lease of an address.
+    uint32_t find(uint32_t addr) const;
+
+    /// @brief Copies a lease into a record and adds it to the indexes.
+    ///
+    /// @param handle handle of a zeroed record.
+    /// @param lease lease to be copied.
+    /// @param extras extras of the lease, allocated by the caller.
+    void store(uint32_t handle, const Lease4& lease, uint8_t* extras);
+
+    /// @brief Removes a record from the indexes and releases its extras.
+    void unstore(isc::util::MemorySegment& segment, uint32_t handle);
+
+    /// @brief Adds a record to the indexes.
+    void index(uint32_t handle);
+
+    /// @brief Builds the lease of a record.
+    Lease4Ptr get(uint32_t handle) const;
+
+    /// @brief Returns the hardware address of a record.
+    const uint8_t* getHWAddr(uint32_t handle, size_t& len) const;
+
+    /// @brief Returns the client identifier of a record.
+    const uint8_t* getClientId(uint32_t handle, size_t& len) const;
+
+    /// Identifies the layout of the store.
+    uint32_t magic_;
+    /// Size of a record.
+    uint32_t record_size_;
+    /// Non-zero during a change.
+    uint32_t updating_;
+    /// Records.
+    RecordSlabs<Record> records_;
+    /// Index by address.
+    LeaseHandleIndex by_address_;
+    /// Index by hardware address and subnet.
+    LeaseHandleIndex by_hwaddr_;
+    /// Index by client identifier and subnet.
+    LeaseHandleIndex by_client_id_;
+};
+
+/// @brief Compact storage of IPv6 leases.
+///
+/// Same as @ref Lease4Store, for Lease6 objects: the records hold the
+/// address and a short DUID inline, and the leases are searched by address
+/// and by DUID, IAID and subnet.
+class Lease6Store : public boost::noncopyable {
+public:
+    /// @brief Space of the DUID in a record.
+    static const size_t DUID_LEN = 20;
+
+    /// @brief Creates an empty store.
+    ///
+    /// @param segment segment the store is allocated from.
+    /// @throw isc::util::MemorySegmentGrown if the segment has grown.
+    static Lease6Store* create(isc::util::MemorySegment& segment);
+
+    /// @brief Destroys a store.
+    ///
+    /// @param segment segment the store was allocated from.
+    /// @param store store to be destroyed.
+    static void destroy(isc::util::MemorySegment& segment, Lease6Store* store);
+
+    /// @brief Checks that the store was created by this version of the code.
+    bool isValid() const;
+
+    /// @brief Checks if a change was interrupted.
+    bool isInterrupted() const {
+        return (updating_ != 0);
+    }
+
+    /// @brief Rebuilds the indexes from the records.
+    ///
+    /// @param segment segment the store is allocated from.
+    /// @throw isc::util::MemorySegmentGrown if the segment has grown.
+    void recover(isc::util::MemorySegment& segment);
+
+    /// @brief Adds a lease.
+    ///
+    /// @param segment segment the store is allocated from.
+    /// @param lease lease to be added.
+    /// @return false if there is a lease for the address already.
+    /// @throw isc::util::MemorySegmentGrown if the segment has grown.
+    bool add(isc::util::MemorySegment& segment, const Lease6& lease);
+
+    /// @brief Returns the lease of an address.
+    ///
+    /// @param addr IPv6 address.
+    /// @return lease, or NULL if there is none.
+    Lease6Ptr getByAddress(const isc::asiolink::IOAddress& addr) const;
+
+    /// @brief Returns the lease of a DUID and IAID in a subnet.
+    ///
+    /// @param duid DUID.
+    /// @param iaid IA identifier.
+    /// @param subnet_id identifier of the subnet.
+    /// @return lease, one of them if there are several, or NULL.
+    Lease6Ptr getByDuid(const std::vector<uint8_t>& duid, uint32_t iaid,
+                        SubnetID subnet_id) const;
+
+    /// @brief Replaces the lease of the address of a lease.
+    ///
+    /// @param segment segment the store is allocated from.
+    /// @param lease new lease.
+    /// @return false if there is no lease for the address.
+    /// @throw isc::util::MemorySegmentGrown if the segment has grown.
+    bool update(isc::util::MemorySegment& segment, const Lease6& lease);
+
+    /// @brief Removes the lease of an address.
+    ///
+    /// @param segment segment the store is allocated from.
+    /// @param addr IPv6 address.
+    /// @return false if there is no lease for the address.
+    bool erase(isc::util::MemorySegment& segment,
+               const isc::asiolink::IOAddress& addr);
+
+    /// @brief Returns the number of leases.
+    size_t size() const {
+        return (records_.size());
+    }
+
+private:
+    /// @brief Constructor.
+    Lease6Store();
+
+    /// @brief Lease record.
+    struct Record {
+        uint8_t addr_[16];
+        uint32_t iaid_;
+        uint32_t subnet_id_;
+        uint32_t preferred_lft_;
+        uint32_t valid_lft_;
+        uint32_t t1_;
+        uint32_t t2_;
+        int64_t cltt_;
+        /// Offset of the extras from the record, 0 if none.
+        int64_t extras_;
+        uint8_t type_;
+        uint8_t prefixlen_;
+        uint8_t flags_;
+        /// Length of the DUID, LONG if in the extras.
+        uint8_t duid_len_;
+        uint8_t duid_[DUID_LEN];
+    };
+
+    /// @brief Makes room for a lease in the records and the indexes.
+    void reserve(isc::util::MemorySegment& segment);
+
+    /// @brief Returns the handle of the lease of an address.
+    uint32_t find(const uint8_t* addr) const;
+
+    /// @brief Copies a lease into a record and adds it to the indexes.
+    ///
+    /// @param handle handle of a zeroed record.
+    /// @param lease lease to be copied.
+    /// @param extras extras of the lease, allocated by the caller.
+    void store(uint32_t handle, const Lease6& lease, uint8_t* extras);
+
+    /// @brief Removes a record from the indexes and releases its extras.
+    void unstore(isc::util::MemorySegment& segment, uint32_t handle);
+
+    /// @brief Adds a record to the indexes.
+    void index(uint32_t handle);
+
+    /// @brief Builds the lease of a record.
+    Lease6Ptr get(uint32_t handle) const;
+
+    /// @brief Returns the DUID of a record.
+    const uint8_t* getDuid(uint32_t handle, size_t& len) const;
+
+    /// Identifies the layout of the store.
+    uint32_t magic_;
+    /// Size of a record.
+    uint32_t record_size_;
+    /// Non-zero during a change.
+    uint32_t updating_;
+    /// Records.
+    RecordSlabs<Record> records_;
+    /// Index by address.
+    LeaseHandleIndex by_address_;
+    /// Index by DUID, IAID and subnet.
+    LeaseHandleIndex by_duid_;
+};
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // LEASE_STORE_H
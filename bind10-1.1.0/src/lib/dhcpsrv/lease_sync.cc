@@ -0,0 +1,657 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcp/iface_mgr.h>
+#include <dhcpsrv/cfgmgr.h>
+#include <dhcpsrv/dhcpsrv_log.h>
+#include <dhcpsrv/lease_sync.h>
+#include <util/buffer.h>
+#include <util/io_utilities.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace isc::asiolink;
+using namespace isc::util;
+
+namespace {
+
+/// Start of the stream.
+const uint32_t SYNC_MAGIC = 0x4c53594e; // "LSYN"
+
+/// Operations of the records.
+const uint8_t OP_UPDATE = 1;
+const uint8_t OP_DELETE = 2;
+
+/// Length of the header of a frame.
+const size_t FRAME_HEADER_LEN = 4;
+
+/// Length of the header of a record.
+const size_t RECORD_HEADER_LEN = 3;
+
+/// Maximum length of a frame.
+const size_t MAX_FRAME_LEN = 1 << 20;
+
+/// Amount of data not sent yet above which no frame is added.
+const size_t MAX_OUTPUT = 1 << 16;
+
+/// Flags of a lease record.
+const uint8_t FLAG_FIXED = 0x01;
+const uint8_t FLAG_FQDN_FWD = 0x02;
+const uint8_t FLAG_FQDN_REV = 0x04;
+
+/// @brief Returns the monotonic time in milliseconds.
+uint64_t
+getNow() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000);
+}
+
+/// @brief Makes a socket non-blocking.
+bool
+setNonBlocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL);
+    return ((flags >= 0) && (fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0));
+}
+
+/// @brief Returns the socket address of an IPv4 address and port.
+struct sockaddr_in
+makeAddress(const IOAddress& addr, uint16_t port) {
+    if (!addr.isV4()) {
+        isc_throw(isc::BadValue, "lease synchronization address "
+                  << addr.toText() << " is not an IPv4 address");
+    }
+    struct sockaddr_in sockaddr;
+    memset(&sockaddr, 0, sizeof(sockaddr));
+    sockaddr.sin_family = AF_INET;
+    sockaddr.sin_port = htons(port);
+    sockaddr.sin_addr.s_addr = htonl(static_cast<uint32_t>(addr));
+    return (sockaddr);
+}
+
+/// @brief Returns a record from its buffer.
+std::vector<uint8_t>
+makeRecord(OutputBuffer& buf) {
+    buf.writeUint16At(buf.getLength() - RECORD_HEADER_LEN, 1);
+    const uint8_t* data = static_cast<const uint8_t*>(buf.getData());
+    return (std::vector<uint8_t>(data, data + buf.getLength()));
+}
+
+/// @brief Returns the configured IPv4 subnet with an identifier.
+isc::dhcp::Subnet4Ptr
+findSubnet(isc::dhcp::SubnetID id) {
+    const isc::dhcp::ConstSubnet4CollectionPtr subnets =
+        isc::dhcp::CfgMgr::instance().getSubnets4();
+    for (isc::dhcp::Subnet4Collection::const_iterator subnet =
+             subnets->begin(); subnet != subnets->end(); ++subnet) {
+        if ((*subnet)->getID() == id) {
+            return (*subnet);
+        }
+    }
+    return (isc::dhcp::Subnet4Ptr());
+}
+
+/// @brief Encodes a new or updated lease.
+///
+/// The subnet identifiers are given by each server to its subnets, so the
+/// subnet is sent as its prefix.
+///
+/// @param lease lease to encode.
+/// @param subnet subnet of the lease.
+std::vector<uint8_t>
+encodeUpdate(const isc::dhcp::Lease4& lease,
+             const isc::dhcp::Subnet4& subnet) {
+    OutputBuffer buf(128);
+    buf.writeUint8(OP_UPDATE);
+    buf.writeUint16(0);
+    buf.writeUint32(static_cast<uint32_t>(lease.addr_));
+    buf.writeUint32(lease.ext_);
+    buf.writeUint32(lease.t1_);
+    buf.writeUint32(lease.t2_);
+    buf.writeUint32(lease.valid_lft_);
+    const uint64_t cltt = static_cast<uint64_t>(lease.cltt_);
+    buf.writeUint32(cltt >> 32);
+    buf.writeUint32(cltt & 0xffffffff);
+    const std::pair<IOAddress, uint8_t> prefix = subnet.get();
+    buf.writeUint32(static_cast<uint32_t>(prefix.first));
+    buf.writeUint8(prefix.second);
+    buf.writeUint8((lease.fixed_ ? FLAG_FIXED : 0) |
+                   (lease.fqdn_fwd_ ? FLAG_FQDN_FWD : 0) |
+                   (lease.fqdn_rev_ ? FLAG_FQDN_REV : 0));
+    // The lengths are bounded by the packets the data comes from.
+    const size_t hwaddr_len = std::min(lease.hwaddr_.size(),
+                                       static_cast<size_t>(0xff));
+    buf.writeUint8(hwaddr_len);
+    if (hwaddr_len > 0) {
+        buf.writeData(&lease.hwaddr_[0], hwaddr_len);
+    }
+    std::vector<uint8_t> client_id;
+    if (lease.client_id_) {
+        client_id = lease.client_id_->getClientId();
+    }
+    buf.writeUint8(client_id.size());
+    if (!client_id.empty()) {
+        buf.writeData(&client_id[0], client_id.size());
+    }
+    const size_t hostname_len = std::min(lease.hostname_.size(),
+                                         static_cast<size_t>(0xff));
+    buf.writeUint8(hostname_len);
+    buf.writeData(lease.hostname_.data(), hostname_len);
+    return (makeRecord(buf));
+}
+
+/// @brief Encodes a deleted lease.
+std::vector<uint8_t>
+encodeDelete(const IOAddress& addr) {
+    OutputBuffer buf(RECORD_HEADER_LEN + 4);
+    buf.writeUint8(OP_DELETE);
+    buf.writeUint16(0);
+    buf.writeUint32(static_cast<uint32_t>(addr));
+    return (makeRecord(buf));
+}
+
+/// @brief Decodes a new or updated lease.
+///
+/// The subnet identifier of the lease is not set.
+///
+/// @param buf record data.
+/// @param prefix set to the prefix of the subnet of the lease.
+/// @param prefix_len set to the length of the prefix.
+/// @throw isc::Exception if the record is invalid.
+isc::dhcp::Lease4Ptr
+decodeUpdate(InputBuffer& buf, IOAddress& prefix, uint8_t& prefix_len) {
+    isc::dhcp::Lease4Ptr lease(new isc::dhcp::Lease4());
+    lease->addr_ = IOAddress(buf.readUint32());
+    lease->ext_ = buf.readUint32();
+    lease->t1_ = buf.readUint32();
+    lease->t2_ = buf.readUint32();
+    lease->valid_lft_ = buf.readUint32();
+    uint64_t cltt = buf.readUint32();
+    cltt = (cltt << 32) | buf.readUint32();
+    lease->cltt_ = static_cast<time_t>(cltt);
+    prefix = IOAddress(buf.readUint32());
+    prefix_len = buf.readUint8();
+    const uint8_t flags = buf.readUint8();
+    lease->fixed_ = (flags & FLAG_FIXED) != 0;
+    lease->fqdn_fwd_ = (flags & FLAG_FQDN_FWD) != 0;
+    lease->fqdn_rev_ = (flags & FLAG_FQDN_REV) != 0;
+    buf.readVector(lease->hwaddr_, buf.readUint8());
+    std::vector<uint8_t> client_id;
+    buf.readVector(client_id, buf.readUint8());
+    if (!client_id.empty()) {
+        lease->client_id_.reset(new isc::dhcp::ClientId(client_id));
+    }
+    std::vector<uint8_t> hostname;
+    buf.readVector(hostname, buf.readUint8());
+    lease->hostname_.assign(hostname.begin(), hostname.end());
+    return (lease);
+}
+
+}
+
+namespace isc {
+namespace dhcp {
+
+const uint32_t LeaseSync::TICK_INTERVAL;
+const uint32_t LeaseSync::HEARTBEAT_INTERVAL;
+const uint32_t LeaseSync::PEER_TIMEOUT;
+const uint32_t LeaseSync::RECONNECT_INTERVAL;
+const size_t LeaseSync::BATCH_SIZE;
+const size_t LeaseSync::MAX_BACKLOG;
+
+LeaseSync::LeaseSync(LeaseMgr& lease_mgr,
+                     const IOAddress& local_addr, uint16_t local_port,
+                     const IOAddress& peer_addr, uint16_t peer_port)
+    : lease_mgr_(lease_mgr), peer_addr_(peer_addr), peer_port_(peer_port),
+      listen_fd_(-1), out_fd_(-1), connected_(false), next_connect_(0),
+      last_sent_(0), backlog_full_(false), output_sent_(0), in_fd_(-1),
+      input_started_(false), last_heard_(0), peer_up_(false), applied_(0),
+      timer_(TimerMgr::INVALID_TIMER) {
+    // Both addresses are checked before anything is opened.
+    makeAddress(peer_addr, peer_port);
+    const struct sockaddr_in local = makeAddress(local_addr, local_port);
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        isc_throw(LeaseSyncError, "failed to open the lease synchronization"
+                  " socket: " << strerror(errno));
+    }
+    const int flag = 1;
+    if ((setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &flag,
+                    sizeof(flag)) < 0) ||
+        (bind(listen_fd_, reinterpret_cast<const struct sockaddr*>(&local),
+              sizeof(local)) < 0) ||
+        (listen(listen_fd_, 1) < 0) ||
+        !setNonBlocking(listen_fd_)) {
+        const int error = errno;
+        close(listen_fd_);
+        isc_throw(LeaseSyncError, "failed to listen for the peer on "
+                  << local_addr.toText() << " port " << local_port << ": "
+                  << strerror(error));
+    }
+    IfaceMgr::instance().addExternalSocket(listen_fd_,
+        boost::bind(&LeaseSync::acceptPeer, this));
+    tick();
+}
+
+LeaseSync::~LeaseSync() {
+    IfaceMgr::instance().getTimerMgr().cancel(timer_);
+    disconnectPeer();
+    closeInbound();
+    IfaceMgr::instance().deleteExternalSocket(listen_fd_);
+    close(listen_fd_);
+}
+
+void
+LeaseSync::leaseUpdated(const Lease4& lease) {
+    const Subnet4Ptr subnet = findSubnet(lease.subnet_id_);
+    if (!subnet) {
+        LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+                  DHCPSRV_LEASE_SYNC_SKIPPED)
+            .arg(lease.addr_.toText()).arg(lease.subnet_id_);
+        return;
+    }
+    std::vector<uint8_t> record = encodeUpdate(lease, *subnet);
+    queue(record);
+}
+
+void
+LeaseSync::leaseDeleted(const IOAddress& addr) {
+    std::vector<uint8_t> record = encodeDelete(addr);
+    queue(record);
+}
+
+void
+LeaseSync::queue(std::vector<uint8_t>& record) {
+    if (backlog_.size() >= MAX_BACKLOG) {
+        if (!backlog_full_) {
+            LOG_WARN(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_BACKLOG_FULL)
+                .arg(MAX_BACKLOG).arg(peer_addr_.toText());
+            backlog_full_ = true;
+        }
+        backlog_.pop_front();
+    }
+    backlog_.push_back(std::vector<uint8_t>());
+    backlog_.back().swap(record);
+    if (connected_ && (backlog_.size() >= BATCH_SIZE)) {
+        flush();
+    }
+}
+
+void
+LeaseSync::flush() {
+    if (!connected_) {
+        return;
+    }
+    while (!backlog_.empty() && (output_.size() - output_sent_ < MAX_OUTPUT)) {
+        const size_t frame = output_.size();
+        output_.resize(frame + FRAME_HEADER_LEN);
+        for (size_t count = 0; (count < BATCH_SIZE) && !backlog_.empty();
+             ++count) {
+            output_.insert(output_.end(), backlog_.front().begin(),
+                           backlog_.front().end());
+            backlog_.pop_front();
+        }
+        writeUint32(output_.size() - frame - FRAME_HEADER_LEN,
+                    &output_[frame]);
+    }
+    if (backlog_.empty()) {
+        backlog_full_ = false;
+    }
+    write();
+}
+
+bool
+LeaseSync::write() {
+    while (output_sent_ < output_.size()) {
+        const ssize_t sent = send(out_fd_, &output_[output_sent_],
+                                  output_.size() - output_sent_,
+                                  MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            } else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                break;
+            }
+            LOG_WARN(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_DISCONNECTED)
+                .arg(peer_addr_.toText()).arg(strerror(errno));
+            disconnectPeer();
+            return (false);
+        }
+        output_sent_ += sent;
+        last_sent_ = getNow();
+    }
+    if (output_sent_ == output_.size()) {
+        output_.clear();
+        output_sent_ = 0;
+    } else if (output_sent_ >= MAX_OUTPUT) {
+        output_.erase(output_.begin(), output_.begin() + output_sent_);
+        output_sent_ = 0;
+    }
+    return (true);
+}
+
+void
+LeaseSync::tick() {
+    const uint64_t now = getNow();
+    if (out_fd_ < 0) {
+        if (now >= next_connect_) {
+            connectPeer();
+        }
+    } else if (!connected_) {
+        checkConnect();
+    }
+    if (connected_) {
+        flush();
+        if (connected_ && output_.empty() &&
+            (now - last_sent_ >= HEARTBEAT_INTERVAL)) {
+            output_.resize(FRAME_HEADER_LEN, 0);
+            write();
+        }
+    }
+    if (peer_up_ && (now - last_heard_ >= PEER_TIMEOUT)) {
+        setPeerUp(false, "no heartbeat");
+    }
+    timer_ = IfaceMgr::instance().getTimerMgr().schedule(TICK_INTERVAL,
+        boost::bind(&LeaseSync::tick, this));
+}
+
+void
+LeaseSync::connectPeer() {
+    next_connect_ = getNow() + RECONNECT_INTERVAL;
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_CONNECT_FAIL)
+            .arg(peer_addr_.toText()).arg(peer_port_).arg(strerror(errno));
+        return;
+    }
+#ifdef SO_NOSIGPIPE
+    const int flag = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &flag, sizeof(flag));
+#endif
+    const struct sockaddr_in peer = makeAddress(peer_addr_, peer_port_);
+    if (!setNonBlocking(fd) ||
+        ((connect(fd, reinterpret_cast<const struct sockaddr*>(&peer),
+                  sizeof(peer)) < 0) && (errno != EINPROGRESS))) {
+        // The peer may just not be started yet.
+        LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+                  DHCPSRV_LEASE_SYNC_CONNECT_FAIL)
+            .arg(peer_addr_.toText()).arg(peer_port_).arg(strerror(errno));
+        close(fd);
+        return;
+    }
+    out_fd_ = fd;
+    checkConnect();
+}
+
+void
+LeaseSync::checkConnect() {
+    struct pollfd pfd;
+    pfd.fd = out_fd_;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 0) <= 0) {
+        // Still in progress.
+        return;
+    }
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(out_fd_, SOL_SOCKET, SO_ERROR, &error, &len) < 0) {
+        error = errno;
+    }
+    if (error != 0) {
+        LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+                  DHCPSRV_LEASE_SYNC_CONNECT_FAIL)
+            .arg(peer_addr_.toText()).arg(peer_port_).arg(strerror(error));
+        disconnectPeer();
+        return;
+    }
+    connected_ = true;
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_CONNECTED)
+        .arg(peer_addr_.toText()).arg(peer_port_);
+    IfaceMgr::instance().addExternalSocket(out_fd_,
+        boost::bind(&LeaseSync::outboundReadable, this));
+    // The magic number is followed by a heartbeat, so the peer sees this
+    // server up at once.
+    output_.assign(FRAME_HEADER_LEN * 2, 0);
+    output_sent_ = 0;
+    writeUint32(SYNC_MAGIC, &output_[0]);
+    flush();
+}
+
+void
+LeaseSync::disconnectPeer() {
+    if (out_fd_ >= 0) {
+        IfaceMgr::instance().deleteExternalSocket(out_fd_);
+        close(out_fd_);
+        out_fd_ = -1;
+    }
+    connected_ = false;
+    output_.clear();
+    output_sent_ = 0;
+}
+
+void
+LeaseSync::outboundReadable() {
+    // The peer never sends anything on this connection.
+    uint8_t buf[256];
+    const ssize_t len = recv(out_fd_, buf, sizeof(buf), MSG_DONTWAIT);
+    if ((len == 0) ||
+        ((len < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) &&
+         (errno != EINTR))) {
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_DISCONNECTED)
+            .arg(peer_addr_.toText())
+            .arg(len == 0 ? "connection closed" : strerror(errno));
+        disconnectPeer();
+    }
+}
+
+void
+LeaseSync::acceptPeer() {
+    struct sockaddr_in from;
+    socklen_t from_len = sizeof(from);
+    const int fd = accept(listen_fd_, reinterpret_cast<struct sockaddr*>(&from),
+                          &from_len);
+    if (fd < 0) {
+        return;
+    }
+    const IOAddress from_addr(ntohl(from.sin_addr.s_addr));
+    if (from_addr != peer_addr_) {
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_REJECTED)
+            .arg(from_addr.toText());
+        close(fd);
+        return;
+    }
+    if (!setNonBlocking(fd)) {
+        close(fd);
+        return;
+    }
+    // The peer reconnected: the previous connection is dead.
+    closeInbound();
+    in_fd_ = fd;
+    IfaceMgr::instance().addExternalSocket(in_fd_,
+        boost::bind(&LeaseSync::readPeer, this));
+}
+
+void
+LeaseSync::closeInbound() {
+    if (in_fd_ >= 0) {
+        IfaceMgr::instance().deleteExternalSocket(in_fd_);
+        close(in_fd_);
+        in_fd_ = -1;
+    }
+    input_.clear();
+    input_started_ = false;
+}
+
+void
+LeaseSync::readPeer() {
+    uint8_t buf[16384];
+    const ssize_t len = recv(in_fd_, buf, sizeof(buf), MSG_DONTWAIT);
+    if (len < 0) {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+            return;
+        }
+        const int error = errno;
+        closeInbound();
+        setPeerUp(false, strerror(error));
+        return;
+    } else if (len == 0) {
+        closeInbound();
+        setPeerUp(false, "connection closed");
+        return;
+    }
+    input_.insert(input_.end(), buf, buf + len);
+    if (!processInput()) {
+        closeInbound();
+        setPeerUp(false, "invalid data");
+    }
+}
+
+bool
+LeaseSync::processInput() {
+    size_t pos = 0;
+    if (!input_started_) {
+        if (input_.size() < sizeof(SYNC_MAGIC)) {
+            return (true);
+        }
+        if (readUint32(&input_[0]) != SYNC_MAGIC) {
+            LOG_ERROR(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_INVALID)
+                .arg(peer_addr_.toText()).arg("unknown protocol");
+            return (false);
+        }
+        input_started_ = true;
+        pos = sizeof(SYNC_MAGIC);
+    }
+    while (input_.size() - pos >= FRAME_HEADER_LEN) {
+        const uint32_t frame_len = readUint32(&input_[pos]);
+        if (frame_len > MAX_FRAME_LEN) {
+            LOG_ERROR(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_INVALID)
+                .arg(peer_addr_.toText()).arg("frame too long");
+            return (false);
+        }
+        if (input_.size() - pos - FRAME_HEADER_LEN < frame_len) {
+            break;
+        }
+        pos += FRAME_HEADER_LEN;
+        const size_t end = pos + frame_len;
+        while (pos < end) {
+            if (end - pos < RECORD_HEADER_LEN) {
+                LOG_ERROR(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_INVALID)
+                    .arg(peer_addr_.toText()).arg("truncated record");
+                return (false);
+            }
+            const uint8_t op = input_[pos];
+            const size_t record_len = readUint16(&input_[pos + 1]);
+            pos += RECORD_HEADER_LEN;
+            if ((end - pos < record_len) ||
+                !apply(op, &input_[0] + pos, record_len)) {
+                LOG_ERROR(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_INVALID)
+                    .arg(peer_addr_.toText()).arg("invalid record");
+                return (false);
+            }
+            pos += record_len;
+        }
+        last_heard_ = getNow();
+        setPeerUp(true, NULL);
+    }
+    input_.erase(input_.begin(), input_.begin() + pos);
+    return (true);
+}
+
+bool
+LeaseSync::apply(uint8_t op, const uint8_t* data, size_t len) {
+    Lease4Ptr lease;
+    IOAddress addr("0.0.0.0");
+    IOAddress prefix("0.0.0.0");
+    uint8_t prefix_len = 0;
+    try {
+        InputBuffer buf(data, len);
+        if (op == OP_UPDATE) {
+            lease = decodeUpdate(buf, prefix, prefix_len);
+            addr = lease->addr_;
+        } else if (op == OP_DELETE) {
+            addr = IOAddress(buf.readUint32());
+        } else {
+            // Operations of a newer peer are skipped.
+            return (true);
+        }
+    } catch (const isc::Exception&) {
+        return (false);
+    }
+
+    if (op == OP_UPDATE) {
+        const Subnet4Ptr subnet =
+            CfgMgr::instance().getSubnet4ByPrefix(prefix, prefix_len);
+        if (!subnet) {
+            LOG_WARN(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_NO_SUBNET)
+                .arg(peer_addr_.toText()).arg(addr.toText())
+                .arg(prefix.toText())
+                .arg(static_cast<unsigned int>(prefix_len));
+            return (true);
+        }
+        lease->subnet_id_ = subnet->getID();
+    }
+
+    try {
+        if (op == OP_DELETE) {
+            lease_mgr_.deleteLease(addr);
+        } else {
+            Lease4Ptr existing = lease_mgr_.getLease4(addr);
+            if (!existing) {
+                lease_mgr_.addLease(lease);
+            } else if (lease->cltt_ >= existing->cltt_) {
+                lease_mgr_.updateLease4(lease);
+            }
+        }
+        ++applied_;
+    } catch (const isc::Exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_APPLY_FAIL)
+            .arg(addr.toText()).arg(ex.what());
+    }
+    return (true);
+}
+
+void
+LeaseSync::setPeerUp(bool up, const char* reason) {
+    if (up == peer_up_) {
+        return;
+    }
+    peer_up_ = up;
+    if (up) {
+        LOG_INFO(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_PEER_UP)
+            .arg(peer_addr_.toText());
+    } else {
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_LEASE_SYNC_PEER_DOWN)
+            .arg(peer_addr_.toText()).arg(reason);
+    }
+}
+
+} // namespace isc::dhcp
+} // namespace isc
@@ -0,0 +1,244 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef LEASE_SYNC_H
+#define LEASE_SYNC_H
+
+#include <asiolink/io_address.h>
+#include <dhcp/timer_mgr.h>
+#include <dhcpsrv/lease_mgr.h>
+#include <exceptions/exceptions.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <deque>
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Exception thrown when the lease synchronization can't be set up.
+class LeaseSyncError : public Exception {
+public:
+    LeaseSyncError(const char* file, size_t line, const char* what) :
+        isc::Exception(file, line, what) { };
+};
+
+/// @brief Streams the lease changes of a DHCPv4 server to its peer.
+///
+/// The servers of a load balancing pair (see @ref LoadBalancer) each
+/// keep the leases of both servers, so a server can take over the
+/// clients of its peer. Each server listens for the connection of its
+/// peer, which only receives lease changes, and connects to the peer,
+/// which only sends lease changes; the changes are applied to the lease
+/// database through the @ref LeaseMgr interface.
+///
+/// The changes are queued by the packet processing and sent in batches:
+/// when a batch is full, or from a timer run by @ref IfaceMgr. Writes
+/// never block, so a slow or unreachable peer doesn't delay the
+/// processing of the packets; while the peer is unreachable the most
+/// recent @ref MAX_BACKLOG changes are kept and sent on reconnection.
+/// A heartbeat is sent when there is no change to send, and the peer is
+/// considered down when nothing is received from it for
+/// @ref PEER_TIMEOUT milliseconds, or when its connection is closed.
+///
+/// Both servers answer disjoint sets of clients, so a conflict only
+/// happens when both give the same address at the same time; the lease
+/// of the most recent transmission of the client is kept.
+///
+/// The stream starts with a 32 bit magic number, followed by frames
+/// made of a 32 bit length and of the records of the batch; an empty
+/// frame is a heartbeat. A record is an 8 bit operation, a 16 bit
+/// length and the lease (update) or the address (deletion). The subnet
+/// identifiers are local to each server, so the subnet of a lease is sent
+/// as its prefix and mapped to the subnet with the same prefix by the
+/// peer, which rejects the lease when it has no such subnet.
+class LeaseSync : public boost::noncopyable {
+public:
+    /// @brief Interval of the timer, in milliseconds.
+    static const uint32_t TICK_INTERVAL = 100;
+
+    /// @brief Idle time after which a heartbeat is sent, in milliseconds.
+    static const uint32_t HEARTBEAT_INTERVAL = 1000;
+
+    /// @brief Silence after which the peer is down, in milliseconds.
+    static const uint32_t PEER_TIMEOUT = 3000;
+
+    /// @brief Delay between connection attempts, in milliseconds.
+    static const uint32_t RECONNECT_INTERVAL = 1000;
+
+    /// @brief Number of changes sent in a frame.
+    static const size_t BATCH_SIZE = 64;
+
+    /// @brief Maximum number of changes waiting to be sent.
+    static const size_t MAX_BACKLOG = 65536;
+
+    /// @brief Constructor.
+    ///
+    /// Starts listening for the peer; the connection to the peer is made
+    /// by the timer.
+    ///
+    /// @param lease_mgr lease database the changes of the peer are
+    /// applied to.
+    /// @param local_addr IPv4 address the peer connects to.
+    /// @param local_port port the peer connects to.
+    /// @param peer_addr IPv4 address of the peer.
+    /// @param peer_port port of the peer.
+    /// @throw LeaseSyncError if the listening socket can't be opened.
+    /// @throw isc::BadValue if an address is not an IPv4 address.
+    LeaseSync(LeaseMgr& lease_mgr,
+              const isc::asiolink::IOAddress& local_addr, uint16_t local_port,
+              const isc::asiolink::IOAddress& peer_addr, uint16_t peer_port);
+
+    /// @brief Destructor.
+    ///
+    /// Closes the connections; the changes not sent yet are lost.
+    ~LeaseSync();
+
+    /// @brief Queues a new or updated lease.
+    ///
+    /// The lease is not sent if its subnet is no longer configured.
+    ///
+    /// @param lease lease given to a client.
+    void leaseUpdated(const Lease4& lease);
+
+    /// @brief Queues a deleted lease.
+    ///
+    /// @param addr address of the lease.
+    void leaseDeleted(const isc::asiolink::IOAddress& addr);
+
+    /// @brief Sends the queued changes which can be sent without blocking.
+    void flush();
+
+    /// @brief Checks if the peer is up.
+    bool isPeerUp() const {
+        return (peer_up_);
+    }
+
+    /// @brief Checks if the connection to the peer is established.
+    bool isConnected() const {
+        return (connected_);
+    }
+
+    /// @brief Returns the number of changes waiting to be sent.
+    size_t getBacklog() const {
+        return (backlog_.size());
+    }
+
+    /// @brief Returns the number of changes of the peer applied.
+    uint64_t getApplied() const {
+        return (applied_);
+    }
+
+private:
+    /// @brief Runs the periodic tasks and schedules the next run.
+    void tick();
+
+    /// @brief Starts connecting to the peer.
+    void connectPeer();
+
+    /// @brief Checks if the connection to the peer is established.
+    void checkConnect();
+
+    /// @brief Closes the connection to the peer.
+    void disconnectPeer();
+
+    /// @brief Writes the output buffer without blocking.
+    ///
+    /// @return false if the connection was closed.
+    bool write();
+
+    /// @brief Called when the connection to the peer is readable, i.e.
+    /// closed or failed.
+    void outboundReadable();
+
+    /// @brief Accepts the connection of the peer.
+    void acceptPeer();
+
+    /// @brief Reads and applies the changes of the peer.
+    void readPeer();
+
+    /// @brief Closes the connection of the peer.
+    void closeInbound();
+
+    /// @brief Applies the complete frames received.
+    ///
+    /// @return false if the data is invalid.
+    bool processInput();
+
+    /// @brief Applies a change of the peer.
+    ///
+    /// @param op operation.
+    /// @param data record data.
+    /// @param len length of the record data.
+    /// @return false if the record is invalid.
+    bool apply(uint8_t op, const uint8_t* data, size_t len);
+
+    /// @brief Marks the peer as up or down.
+    ///
+    /// @param up new state.
+    /// @param reason reason why the peer is down.
+    void setPeerUp(bool up, const char* reason);
+
+    /// @brief Queues a record.
+    ///
+    /// @param record encoded record.
+    void queue(std::vector<uint8_t>& record);
+
+    /// Lease database the changes of the peer are applied to.
+    LeaseMgr& lease_mgr_;
+    /// Address of the peer.
+    isc::asiolink::IOAddress peer_addr_;
+    /// Port of the peer.
+    uint16_t peer_port_;
+    /// Socket the peer connects to.
+    int listen_fd_;
+    /// Connection to the peer.
+    int out_fd_;
+    /// Is the connection to the peer established.
+    bool connected_;
+    /// Time of the next connection attempt.
+    uint64_t next_connect_;
+    /// Time of the last write to the peer.
+    uint64_t last_sent_;
+    /// Changes waiting to be sent.
+    std::deque<std::vector<uint8_t> > backlog_;
+    /// Has the backlog overflown since it was last empty.
+    bool backlog_full_;
+    /// Data being sent.
+    std::vector<uint8_t> output_;
+    /// Number of bytes of the output buffer already sent.
+    size_t output_sent_;
+    /// Connection of the peer.
+    int in_fd_;
+    /// Data received and not processed yet.
+    std::vector<uint8_t> input_;
+    /// Has the magic number of the peer been received.
+    bool input_started_;
+    /// Time of the last data received from the peer.
+    uint64_t last_heard_;
+    /// Is the peer up.
+    bool peer_up_;
+    /// Number of changes of the peer applied.
+    uint64_t applied_;
+    /// Timer of the periodic tasks.
+    TimerMgr::TimerId timer_;
+};
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // LEASE_SYNC_H
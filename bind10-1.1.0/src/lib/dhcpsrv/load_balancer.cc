@@ -0,0 +1,80 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcp/dhcp4.h>
+#include <dhcpsrv/hash_ring.h>
+#include <dhcpsrv/load_balancer.h>
+#include <exceptions/exceptions.h>
+
+namespace isc {
+namespace dhcp {
+
+const unsigned int LoadBalancer::BUCKETS;
+
+LoadBalancer::LoadBalancer(Role role)
+    : role_(role) {
+}
+
+LoadBalancer::Role
+LoadBalancer::roleFromText(const std::string& name) {
+    if (name == "primary") {
+        return (PRIMARY);
+    } else if (name == "secondary") {
+        return (SECONDARY);
+    }
+    isc_throw(BadValue, "invalid load balancing role '" << name
+              << "', expected primary or secondary");
+}
+
+uint8_t
+LoadBalancer::getBucket(const Pkt4& query) {
+    std::vector<uint8_t> key;
+    OptionPtr client_id = query.getOption(DHO_DHCP_CLIENT_IDENTIFIER);
+    if (client_id && !client_id->getData().empty()) {
+        key = client_id->getData();
+    } else if (query.getHWAddr()) {
+        key = query.getHWAddr()->hwaddr_;
+    }
+    // Both servers must compute the same bucket, whatever their
+    // platform: the hash of the hash ring is used for that reason.
+    return (static_cast<uint8_t>(HashRing::hash(key.empty() ? NULL : &key[0],
+                                                key.size()) >> 56));
+}
+
+bool
+LoadBalancer::isOwnBucket(uint8_t bucket) const {
+    return ((bucket < BUCKETS / 2) == (role_ == PRIMARY));
+}
+
+bool
+LoadBalancer::inScope(const Pkt4& query, bool peer_up) const {
+    if (!peer_up) {
+        return (true);
+    }
+    switch (query.getType()) {
+    case DHCPDISCOVER:
+        break;
+    case DHCPREQUEST:
+        if (static_cast<uint32_t>(query.getCiaddr()) != 0) {
+            return (true);
+        }
+        break;
+    default:
+        return (true);
+    }
+    return (isOwnBucket(getBucket(query)));
+}
+
+} // namespace isc::dhcp
+} // namespace isc
@@ -0,0 +1,93 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef LOAD_BALANCER_H
+#define LOAD_BALANCER_H
+
+#include <dhcp/pkt4.h>
+
+#include <string>
+
+#include <stdint.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Splits the DHCPv4 clients between the servers of a pair.
+///
+/// Both servers of an active-active pair receive the broadcast queries
+/// of all clients. Each client is mapped to one of 256 buckets by the
+/// hash of its client identifier, or of its hardware address when it
+/// sends none; the primary server answers the clients of the lower half
+/// of the buckets and the secondary server those of the upper half. The
+/// mapping only depends on the client, so both servers agree on it
+/// without talking to each other.
+///
+/// When the peer is down, the server answers all clients (takeover).
+/// Only the queries of the clients looking for a lease (DHCPDISCOVER,
+/// and DHCPREQUEST without client address) are balanced: the other
+/// queries are sent to the server which gave the lease, and the leases
+/// of both servers are known to both (see @ref LeaseSync).
+class LoadBalancer {
+public:
+    /// @brief Role of the server in the pair.
+    enum Role {
+        PRIMARY,
+        SECONDARY
+    };
+
+    /// @brief Number of buckets.
+    static const unsigned int BUCKETS = 256;
+
+    /// @brief Constructor.
+    ///
+    /// @param role role of this server.
+    explicit LoadBalancer(Role role);
+
+    /// @brief Converts the name of a role ("primary" or "secondary").
+    ///
+    /// @param name name of the role.
+    /// @throw isc::BadValue if the name is not a role.
+    static Role roleFromText(const std::string& name);
+
+    /// @brief Returns the role of this server.
+    Role getRole() const {
+        return (role_);
+    }
+
+    /// @brief Returns the bucket of the client which sent a query.
+    ///
+    /// @param query DHCPv4 query.
+    static uint8_t getBucket(const Pkt4& query);
+
+    /// @brief Checks if this server answers the clients of a bucket.
+    ///
+    /// @param bucket bucket of the clients.
+    bool isOwnBucket(uint8_t bucket) const;
+
+    /// @brief Checks if this server answers a query.
+    ///
+    /// @param query DHCPv4 query.
+    /// @param peer_up false if the peer is down.
+    bool inScope(const Pkt4& query, bool peer_up) const;
+
+private:
+    /// Role of this server.
+    Role role_;
+};
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // LOAD_BALANCER_H
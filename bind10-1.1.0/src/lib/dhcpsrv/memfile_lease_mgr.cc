@@ -12,58 +12,193 @@
 // OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <config.h>
+
 #include <dhcpsrv/dhcpsrv_log.h>
 #include <dhcpsrv/memfile_lease_mgr.h>
 #include <exceptions/exceptions.h>
+#include <util/memory_segment_local.h>
+#ifdef USE_SHARED_MEMORY
+#include <util/memory_segment_mapped.h>
+#endif
 
 #include <iostream>
 
 using namespace isc::dhcp;
+using namespace isc::util;
+
+namespace {
+
+/// Names of the stores in the segment.
+const char* const LEASE4_STORE = "lease4-store";
+const char* const LEASE6_STORE = "lease6-store";
+
+/// @brief Returns a store of a segment, creating it if needed.
+///
+/// @param segment segment holding the store.
+/// @param name name of the store in the segment.
+/// @param readonly true if the store must not be created.
+/// @return store, or NULL if there is none in a read-only segment.
+template <typename Store>
+Store*
+openStore(MemorySegment& segment, const char* name, bool readonly) {
+    Store* store = static_cast<Store*>(segment.getNamedAddress(name));
+    if (store || readonly) {
+        return (store);
+    }
+    for (;;) {
+        try {
+            store = Store::create(segment);
+            break;
+        } catch (const MemorySegmentGrown&) {
+            // Nothing was allocated, try again in the larger segment.
+        }
+    }
+    if (segment.setNamedAddress(name, store)) {
+        // The segment has grown, the store has moved.
+        store = static_cast<Store*>(segment.getNamedAddress(name));
+    }
+    return (store);
+}
+
+}
 
 Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
-    : LeaseMgr(parameters) {
-    LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_WARNING);
+    : LeaseMgr(parameters), storage4_(NULL), storage6_(NULL),
+      readonly_(false) {
+    try {
+        file_name_ = getParameter("name");
+    } catch (...) {
+        // No file name: the leases are kept in memory.
+    }
+    try {
+        readonly_ = (getParameter("readonly") == "true");
+    } catch (...) {
+        // Opened for writing by default.
+    }
+
+    if (file_name_.empty()) {
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_WARNING);
+        readonly_ = false;
+        segment_.reset(new MemorySegmentLocal());
+    } else {
+#ifdef USE_SHARED_MEMORY
+        try {
+            if (readonly_) {
+                segment_.reset(new MemorySegmentMapped(file_name_));
+            } else {
+                segment_.reset(new MemorySegmentMapped(
+                                   file_name_,
+                                   MemorySegmentMapped::OPEN_OR_CREATE));
+            }
+        } catch (const MemorySegmentOpenError& ex) {
+            isc_throw(DbOpenError, "unable to open memfile lease database "
+                      << file_name_ << ": " << ex.what());
+        }
+#else
+        isc_throw(DbOpenError, "unable to open memfile lease database "
+                  << file_name_ << ": built without shared memory support");
+#endif
+    }
+
+    storage4_ = openStore<Lease4Store>(*segment_, LEASE4_STORE, readonly_);
+    storage6_ = openStore<Lease6Store>(*segment_, LEASE6_STORE, readonly_);
+    if (!storage4_ || !storage6_ || !storage4_->isValid() ||
+        !storage6_->isValid()) {
+        isc_throw(DbOpenError, file_name_ << " is not a memfile lease"
+                  " database of this version");
+    }
+
+    if (storage4_->isInterrupted() || storage6_->isInterrupted()) {
+        // The previous server stopped in the middle of a change.
+        if (readonly_) {
+            isc_throw(DbOpenError, "memfile lease database " << file_name_
+                      << " must be opened for writing first to recover"
+                      " from an interrupted change");
+        }
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_RECOVER).arg(file_name_);
+        for (;;) {
+            try {
+                if (storage4_->isInterrupted()) {
+                    storage4_->recover(*segment_);
+                }
+                if (storage6_->isInterrupted()) {
+                    storage6_->recover(*segment_);
+                }
+                break;
+            } catch (const MemorySegmentGrown&) {
+                refreshStores();
+            }
+        }
+    }
+
+    if (!file_name_.empty()) {
+        LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_MAPPED_OPEN)
+            .arg(file_name_).arg(storage4_->size()).arg(storage6_->size());
+    }
 }
 
 Memfile_LeaseMgr::~Memfile_LeaseMgr() {
+    // The leases of a file stay there for the next process.
+    if (file_name_.empty()) {
+        Lease4Store::destroy(*segment_, storage4_);
+        Lease6Store::destroy(*segment_, storage6_);
+        segment_->clearNamedAddress(LEASE4_STORE);
+        segment_->clearNamedAddress(LEASE6_STORE);
+    }
+}
+
+void
+Memfile_LeaseMgr::checkWritable() const {
+    if (readonly_) {
+        isc_throw(DbOperationError, "memfile lease database " << file_name_
+                  << " is opened read-only");
+    }
+}
+
+void
+Memfile_LeaseMgr::refreshStores() {
+    storage4_ = static_cast<Lease4Store*>(
+        segment_->getNamedAddress(LEASE4_STORE));
+    storage6_ = static_cast<Lease6Store*>(
+        segment_->getNamedAddress(LEASE6_STORE));
 }
 
 bool Memfile_LeaseMgr::addLease(const Lease4Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_ADD_ADDR4).arg(lease->addr_.toText());
 
-    if (getLease4(lease->addr_)) {
-        // there is a lease with specified address already
-        return (false);
+    checkWritable();
+    // false if there is a lease with specified address already
+    for (;;) {
+        try {
+            return (storage4_->add(*segment_, *lease));
+        } catch (const MemorySegmentGrown&) {
+            refreshStores();
+        }
     }
-    storage4_.insert(lease);
-    return (true);
 }
 
 bool Memfile_LeaseMgr::addLease(const Lease6Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_ADD_ADDR6).arg(lease->addr_.toText());
 
-    if (getLease6(lease->addr_)) {
-        // there is a lease with specified address already
-        return (false);
+    checkWritable();
+    // false if there is a lease with specified address already
+    for (;;) {
+        try {
+            return (storage6_->add(*segment_, *lease));
+        } catch (const MemorySegmentGrown&) {
+            refreshStores();
+        }
     }
-    storage6_.insert(lease);
-    return (true);
 }
 
 Lease4Ptr Memfile_LeaseMgr::getLease4(const isc::asiolink::IOAddress& addr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_ADDR4).arg(addr.toText());
 
-    typedef Lease4Storage::nth_index<0>::type SearchIndex;
-    const SearchIndex& idx = storage4_.get<0>();
-    Lease4Storage::iterator l = idx.find(addr);
-    if (l == storage4_.end()) {
-        return (Lease4Ptr());
-    } else {
-        return (*l);
-    }
+    return (storage4_->getByAddress(static_cast<uint32_t>(addr)));
 }
 
 Lease4Collection Memfile_LeaseMgr::getLease4(const HWAddr& hwaddr) const {
@@ -79,22 +214,7 @@ Lease4Ptr Memfile_LeaseMgr::getLease4(const HWAddr& hwaddr,
               DHCPSRV_MEMFILE_GET_SUBID_HWADDR).arg(subnet_id)
         .arg(hwaddr.toText());
 
-    // We are going to use index #1 of the multi index container.
-    // We define SearchIndex locally in this function because
-    // currently only this function uses this index.
-    typedef Lease4Storage::nth_index<1>::type SearchIndex;
-    // Get the index.
-    const SearchIndex& idx = storage4_.get<1>();
-    // Try to find the lease using HWAddr and subnet id.
-    SearchIndex::const_iterator lease =
-        idx.find(boost::make_tuple(hwaddr.hwaddr_, subnet_id));
-    // Lease was not found. Return empty pointer to the caller.
-    if (lease == idx.end()) {
-        return Lease4Ptr();
-    }
-
-    // Lease was found. Return it to the caller.
-    return (*lease);
+    return (storage4_->getByHWAddr(hwaddr.hwaddr_, subnet_id));
 }
 
 Lease4Collection Memfile_LeaseMgr::getLease4(const ClientId& clientid) const {
@@ -109,21 +229,7 @@ Lease4Ptr Memfile_LeaseMgr::getLease4(const ClientId& client_id,
               DHCPSRV_MEMFILE_GET_SUBID_CLIENTID).arg(subnet_id)
               .arg(client_id.toText());
 
-    // We are going to use index #2 of the multi index container.
-    // We define SearchIndex locally in this function because
-    // currently only this function uses this index.
-    typedef Lease4Storage::nth_index<2>::type SearchIndex;
-    // Get the index.
-    const SearchIndex& idx = storage4_.get<2>();
-    // Try to get the lease using client id and subnet id.
-    SearchIndex::const_iterator lease =
-        idx.find(boost::make_tuple(client_id.getClientId(), subnet_id));
-    // Lease was not found. Return empty pointer to the caller.
-    if (lease == idx.end()) {
-        return Lease4Ptr();
-    }
-    // Lease was found. Return it to the caller.
-    return (*lease);
+    return (storage4_->getByClientId(client_id.getClientId(), subnet_id));
 }
 
 Lease6Ptr Memfile_LeaseMgr::getLease6(
@@ -131,12 +237,7 @@ Lease6Ptr Memfile_LeaseMgr::getLease6(
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_ADDR6).arg(addr.toText());
 
-    Lease6Storage::iterator l = storage6_.find(addr);
-    if (l == storage6_.end()) {
-        return (Lease6Ptr());
-    } else {
-        return (*l);
-    }
+    return (storage6_->getByAddress(addr));
 }
 
 Lease6Collection Memfile_LeaseMgr::getLease6(const DUID& duid,
@@ -153,60 +254,60 @@ Lease6Ptr Memfile_LeaseMgr::getLease6(const DUID& duid, uint32_t iaid,
               DHCPSRV_MEMFILE_GET_IAID_SUBID_DUID)
               .arg(iaid).arg(subnet_id).arg(duid.toText());
 
-    // We are going to use index #1 of the multi index container.
-    // We define SearchIndex locally in this function because
-    // currently only this function uses this index.
-    typedef Lease6Storage::nth_index<1>::type SearchIndex;
-    // Get the index.
-    const SearchIndex& idx = storage6_.get<1>();
-    // Try to get the lease using the DUID, IAID and Subnet ID.
-    SearchIndex::const_iterator lease =
-        idx.find(boost::make_tuple(duid.getDuid(), iaid, subnet_id));
-    // Lease was not found. Return empty pointer.
-    if (lease == idx.end()) {
-        return (Lease6Ptr());
-    }
-    // Lease was found, return it to the caller.
-    return (*lease);
+    return (storage6_->getByDuid(duid.getDuid(), iaid, subnet_id));
 }
 
 void Memfile_LeaseMgr::updateLease4(const Lease4Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_UPDATE_ADDR4).arg(lease->addr_.toText());
 
+    checkWritable();
+    bool updated;
+    for (;;) {
+        try {
+            updated = storage4_->update(*segment_, *lease);
+            break;
+        } catch (const MemorySegmentGrown&) {
+            refreshStores();
+        }
+    }
+    if (!updated) {
+        isc_throw(NoSuchLease, "unable to update lease for address " <<
+                  lease->addr_.toText() << " as it does not exist");
+    }
 }
 
 void Memfile_LeaseMgr::updateLease6(const Lease6Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_UPDATE_ADDR6).arg(lease->addr_.toText());
 
-
+    checkWritable();
+    bool updated;
+    for (;;) {
+        try {
+            updated = storage6_->update(*segment_, *lease);
+            break;
+        } catch (const MemorySegmentGrown&) {
+            refreshStores();
+        }
+    }
+    if (!updated) {
+        isc_throw(NoSuchLease, "unable to update lease for address " <<
+                  lease->addr_.toText() << " as it does not exist");
+    }
 }
 
 bool Memfile_LeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_DELETE_ADDR).arg(addr.toText());
+    checkWritable();
+    // false if there is no such lease
     if (addr.isV4()) {
         // v4 lease
-        Lease4Storage::iterator l = storage4_.find(addr);
-        if (l == storage4_.end()) {
-            // No such lease
-            return (false);
-        } else {
-            storage4_.erase(l);
-            return (true);
-        }
-
+        return (storage4_->erase(*segment_, static_cast<uint32_t>(addr)));
     } else {
         // v6 lease
-        Lease6Storage::iterator l = storage6_.find(addr);
-        if (l == storage6_.end()) {
-            // No such lease
-            return (false);
-        } else {
-            storage6_.erase(l);
-            return (true);
-        }
+        return (storage6_->erase(*segment_, addr));
     }
 }
 
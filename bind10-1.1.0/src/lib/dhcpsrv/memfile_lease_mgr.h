@@ -16,14 +16,11 @@
 #define MEMFILE_LEASE_MGR_H
 
 #include <dhcp/hwaddr.h>
-#include <dhcpsrv/key_from_key.h>
 #include <dhcpsrv/lease_mgr.h>
+#include <dhcpsrv/lease_store.h>
+#include <util/memory_segment.h>
 
-#include <boost/multi_index/indexed_by.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/composite_key.hpp>
+#include <boost/scoped_ptr.hpp>
 
 namespace isc {
 namespace dhcp {
@@ -36,6 +33,15 @@ namespace dhcp {
 // class testing. It may later evolve into more useful backend if the
 // need arises. We can reuse code from memfile benchmark. See code in
 // tests/tools/dhcp-ubench/memfile_bench.{cc|h}
+//
+// The leases are held in compact records (see Lease4Store and Lease6Store),
+// so the returned leases are copies: a modified lease must be passed to
+// updateLease4() or updateLease6() to be stored.
+//
+// With the "name" parameter, the stores are kept in a file mapped by
+// isc::util::MemorySegmentMapped: a restarted server maps the file and
+// finds its leases without loading them, and other processes may open the
+// file with "readonly=true" to read the leases while no server writes it.
 class Memfile_LeaseMgr : public LeaseMgr {
 public:
 
@@ -45,8 +51,14 @@ public:
     /// are passed in the "name=value" format, separated by spaces.
     /// Values may be enclosed in double quotes, if needed.
     ///
+    /// The leases are kept in memory, unless the "name" parameter gives
+    /// the file they are kept in. The file is created if needed, and
+    /// opened read-only if the "readonly" parameter is "true".
+    ///
     /// @param parameters A data structure relating keywords and values
     ///        concerned with the database.
+    /// @throw DbOpenError if the file can't be opened or isn't a lease
+    ///        database of this version.
     Memfile_LeaseMgr(const ParameterMap& parameters);
 
     /// @brief Destructor (closes file)
@@ -151,20 +163,16 @@ public:
 
     /// @brief Updates IPv4 lease.
     ///
-    /// @todo Not implemented yet
-    ///
     /// @param lease4 The lease to be updated.
     ///
-    /// If no such lease is present, an exception will be thrown.
+    /// @throw isc::dhcp::NoSuchLease if no such lease is present.
     virtual void updateLease4(const Lease4Ptr& lease4);
 
-    /// @brief Updates IPv4 lease.
-    ///
-    /// @todo Not implemented yet
+    /// @brief Updates IPv6 lease.
     ///
     /// @param lease6 The lease to be updated.
     ///
-    /// If no such lease is present, an exception will be thrown.
+    /// @throw isc::dhcp::NoSuchLease if no such lease is present.
     virtual void updateLease6(const Lease6Ptr& lease6);
 
     /// @brief Deletes a lease.
@@ -186,11 +194,9 @@ public:
 
     /// @brief Returns backend name.
     ///
-    /// For now, memfile can only store data in memory.
-    ///
-    /// @return Name of the backend.
+    /// @return Name of the file the leases are kept in, or "memory".
     virtual std::string getName() const {
-        return ("memory");
+        return (file_name_.empty() ? std::string("memory") : file_name_);
     }
 
     /// @brief Returns description of the backend.
@@ -222,114 +228,28 @@ public:
 
 protected:
 
-    // This is a multi-index container, which holds elements that can
-    // be accessed using different search indexes.
-    typedef boost::multi_index_container<
-        // It holds pointers to Lease6 objects.
-        Lease6Ptr,
-        boost::multi_index::indexed_by<
-            // Specification of the first index starts here.
-            // This index sorts leases by IPv6 addresses represented as
-            // IOAddress objects.
-            boost::multi_index::ordered_unique<
-                boost::multi_index::member<Lease, isc::asiolink::IOAddress, &Lease::addr_>
-            >,
-
-            // Specification of the second index starts here.
-            boost::multi_index::ordered_unique<
-                // This is a composite index that will be used to search for
-                // the lease using three attributes: DUID, IAID, Subnet Id.
-                boost::multi_index::composite_key<
-                    Lease6,
-                    // The DUID value can't be directly accessed from the Lease6
-                    // object because it is wrapped with the DUID object (actually
-                    // pointer to this object). Therefore we need to use
-                    // KeyFromKeyExtractor class to extract the DUID value from
-                    // this cascaded structure.
-                    KeyFromKeyExtractor<
-                        // The value of the DUID is accessed by the getDuid() method
-                        // from the DUID object.
-                        boost::multi_index::const_mem_fun<DUID, std::vector<uint8_t>,
-                                                          &DUID::getDuid>,
-                        // The DUID object is stored in the duid_ member of the
-                        // Lease6 object.
-                        boost::multi_index::member<Lease6, DuidPtr, &Lease6::duid_>
-                    >,
-                    // The two other ingredients of this index are IAID and
-                    // subnet id.
-                    boost::multi_index::member<Lease6, uint32_t, &Lease6::iaid_>,
-                    boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
-                >
-            >
-        >
-     > Lease6Storage; // Specify the type name of this container.
-
-    // This is a multi-index container, which holds elements that can
-    // be accessed using different search indexes.
-    typedef boost::multi_index_container<
-        // It holds pointers to Lease4 objects.
-        Lease4Ptr, 
-        // Specification of search indexes starts here.
-        boost::multi_index::indexed_by<
-            // Specification of the first index starts here.
-            // This index sorts leases by IPv4 addresses represented as
-            // IOAddress objects.
-            boost::multi_index::ordered_unique<
-                // The IPv4 address are held in addr_ members that belong to
-                // Lease class.
-                boost::multi_index::member<Lease, isc::asiolink::IOAddress, &Lease::addr_>
-            >,
-
-            // Specification of the second index starts here.
-            boost::multi_index::ordered_unique<
-                // This is a composite index that combines two attributes of the
-                // Lease4 object: hardware address and subnet id.
-                boost::multi_index::composite_key<
-                    Lease4,
-                    // The hardware address is held in the hwaddr_ member of the
-                    // Lease4 object.
-                    boost::multi_index::member<Lease4, std::vector<uint8_t>,
-                                               &Lease4::hwaddr_>,
-                    // The subnet id is held in the subnet_id_ member of Lease4
-                    // class. Note that the subnet_id_ is defined in the base
-                    // class (Lease) so we have to point to this class rather
-                    // than derived class: Lease4.
-                    boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
-                >
-            >,
-
-            // Specification of the third index starts here.
-            boost::multi_index::ordered_unique<
-                // This is a composite index that uses two values to search for a
-                // lease: client id and subnet id.
-                boost::multi_index::composite_key<
-                    Lease4,
-                    // The client id value is not directly accessible through the
-                    // Lease4 object as it is wrapped with the ClientIdPtr object.
-                    // Therefore we use the KeyFromKeyExtractor class to access
-                    // client id through this cascaded structure. The client id
-                    // is used as an index value.
-                    KeyFromKeyExtractor<
-                        // Specify that the vector holding client id value can be obtained
-                        // from the ClientId object.
-                        boost::multi_index::const_mem_fun<ClientId, std::vector<uint8_t>,
-                                                          &ClientId::getClientId>,
-                        // Specify that the ClientId object (actually pointer to it) can
-                        // be accessed by the client_id_ member of Lease4 class.
-                        boost::multi_index::member<Lease4, ClientIdPtr, &Lease4::client_id_>
-                    >,
-                    // The subnet id is accessed through the subnet_id_ member.
-                    boost::multi_index::member<Lease, uint32_t, &Lease::subnet_id_>
-                >
-            >
-        >
-    > Lease4Storage; // Specify the type name for this container.
+    /// @brief Throws if the leases can't be changed.
+    ///
+    /// @throw DbOperationError if the file is opened read-only.
+    void checkWritable() const;
+
+    /// @brief Gets the stores again after the segment has grown.
+    void refreshStores();
+
+    /// @brief segment holding the stores: local memory or a mapped file
+    boost::scoped_ptr<isc::util::MemorySegment> segment_;
 
     /// @brief stores IPv4 leases
-    Lease4Storage storage4_;
+    Lease4Store* storage4_;
 
     /// @brief stores IPv6 leases
-    Lease6Storage storage6_;
+    Lease6Store* storage6_;
+
+    /// @brief name of the file, empty if the leases are in memory
+    std::string file_name_;
+
+    /// @brief is the file opened read-only
+    bool readonly_;
 };
 
 }; // end of isc::dhcp namespace
@@ -0,0 +1,125 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+#include <dhcpsrv/rate_limiter.h>
+
+#include <algorithm>
+
+using namespace boost::posix_time;
+
+namespace isc {
+namespace dhcp {
+
+RateLimiter::RateLimiter()
+    : rate_(0), burst_(0), shed_delay_(0) {
+}
+
+void
+RateLimiter::setRate(uint32_t rate, uint32_t burst) {
+    rate_ = rate;
+    burst_ = (burst != 0 ? burst : rate);
+    buckets_.clear();
+}
+
+RateLimiter::Decision
+RateLimiter::check(SubnetID subnet_id, Priority priority,
+                   const ptime& received, const ptime& now) {
+    if ((shed_delay_ != 0) && (priority != PRIORITY_EXISTING_LEASE) &&
+        !received.is_special()) {
+        // The other queries which may allocate a lease wait longer: the
+        // client has chosen this server already.
+        uint64_t delay = shed_delay_;
+        if (priority != PRIORITY_NEW_CLIENT) {
+            delay *= 2;
+        }
+        if (now - received >= milliseconds(delay)) {
+            return (SHED);
+        }
+    }
+
+    if ((rate_ != 0) && !takeToken(subnet_id, now) &&
+        (priority != PRIORITY_EXISTING_LEASE)) {
+        return (RATE_LIMITED);
+    }
+    return (ACCEPT);
+}
+
+bool
+RateLimiter::takeToken(SubnetID subnet_id, const ptime& now) {
+    std::map<SubnetID, Bucket>::iterator bucket = buckets_.find(subnet_id);
+    if (bucket == buckets_.end()) {
+        Bucket full;
+        full.tokens_ = burst_;
+        full.refilled_ = now;
+        bucket = buckets_.insert(std::make_pair(subnet_id, full)).first;
+    } else {
+        const time_duration elapsed = now - bucket->second.refilled_;
+        // A clock going backwards doesn't take tokens away.
+        if (!elapsed.is_negative()) {
+            bucket->second.tokens_ =
+                std::min(static_cast<double>(burst_), bucket->second.tokens_ +
+                         elapsed.total_microseconds() * (rate_ / 1000000.0));
+            bucket->second.refilled_ = now;
+        }
+    }
+
+    if (bucket->second.tokens_ < 1) {
+        return (false);
+    }
+    bucket->second.tokens_ -= 1;
+    return (true);
+}
+
+RateLimiter::Priority
+RateLimiter::getPriority(const Pkt4& query) {
+    switch (query.getType()) {
+    case DHCPDISCOVER:
+        return (PRIORITY_NEW_CLIENT);
+    case DHCPREQUEST:
+        // Renewing and rebinding clients fill in their address.
+        if (static_cast<uint32_t>(query.getCiaddr()) != 0) {
+            return (PRIORITY_EXISTING_LEASE);
+        }
+        break;
+    case DHCPRELEASE:
+    case DHCPDECLINE:
+        return (PRIORITY_EXISTING_LEASE);
+    default:
+        ;
+    }
+    return (PRIORITY_NORMAL);
+}
+
+RateLimiter::Priority
+RateLimiter::getPriority(const Pkt6& query) {
+    switch (query.getType()) {
+    case DHCPV6_SOLICIT:
+        return (PRIORITY_NEW_CLIENT);
+    case DHCPV6_RENEW:
+    case DHCPV6_REBIND:
+    case DHCPV6_CONFIRM:
+    case DHCPV6_RELEASE:
+    case DHCPV6_DECLINE:
+        return (PRIORITY_EXISTING_LEASE);
+    default:
+        ;
+    }
+    return (PRIORITY_NORMAL);
+}
+
+} // namespace isc::dhcp
+} // namespace isc
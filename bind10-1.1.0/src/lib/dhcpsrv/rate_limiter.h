@@ -0,0 +1,160 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <dhcp/pkt4.h>
+#include <dhcp/pkt6.h>
+#include <dhcpsrv/subnet.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <map>
+
+#include <stdint.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Limits the queries a DHCP server processes when it is overloaded.
+///
+/// When a large segment comes up, all its clients send their first query
+/// at once and retransmit when the answers are late. Processing every
+/// query in arrival order then makes all answers late. The limiter lets
+/// the server drop queries right after parsing them, the cheapest ones to
+/// lose first:
+///
+/// - Shedding: a query which waited in the socket queue for the shedding
+///   delay is dropped if it comes from a new client (DHCPDISCOVER,
+///   SOLICIT); after twice the delay, the other queries which may allocate
+///   a lease are dropped too. Renewals and releases of existing leases are
+///   never shed. The clients retransmit the dropped queries, by then the
+///   queue is shorter.
+/// - Rate limiting: each subnet has a token bucket, refilled at the
+///   configured rate up to the burst size. A query takes a token; when
+///   there is none, the query is dropped, unless it renews or releases a
+///   lease (it then takes nothing). The queries of clients without subnet
+///   share the bucket of the subnet identifier 0.
+///
+/// Both are disabled by default.
+class RateLimiter {
+public:
+
+    /// @brief How important a query is for the clients.
+    enum Priority {
+        PRIORITY_NEW_CLIENT,    ///< A client looking for a server
+        PRIORITY_NORMAL,        ///< Other queries which may allocate leases
+        PRIORITY_EXISTING_LEASE ///< Renewals and releases of leases
+    };
+
+    /// @brief What to do with a query.
+    enum Decision {
+        ACCEPT,                 ///< The query is processed
+        RATE_LIMITED,           ///< The bucket of the subnet is empty
+        SHED                    ///< The query waited too long
+    };
+
+    /// @brief Constructor.
+    ///
+    /// The rate limiting and the shedding are disabled.
+    RateLimiter();
+
+    /// @brief Sets the rate of the queries of each subnet.
+    ///
+    /// The buckets are refilled.
+    ///
+    /// @param rate queries per second, 0 disables the rate limiting.
+    /// @param burst size of the buckets, 0 for the rate.
+    void setRate(uint32_t rate, uint32_t burst = 0);
+
+    /// @brief Returns the rate of the queries of each subnet.
+    uint32_t getRate() const {
+        return (rate_);
+    }
+
+    /// @brief Returns the size of the buckets.
+    uint32_t getBurst() const {
+        return (burst_);
+    }
+
+    /// @brief Sets the shedding delay.
+    ///
+    /// @param delay time in milliseconds, 0 disables the shedding.
+    void setShedDelay(uint32_t delay) {
+        shed_delay_ = delay;
+    }
+
+    /// @brief Returns the shedding delay in milliseconds.
+    uint32_t getShedDelay() const {
+        return (shed_delay_);
+    }
+
+    /// @brief Checks if queries may be dropped.
+    bool isEnabled() const {
+        return ((rate_ != 0) || (shed_delay_ != 0));
+    }
+
+    /// @brief Decides what to do with a query.
+    ///
+    /// @param subnet_id subnet of the client, 0 if there is none.
+    /// @param priority priority of the query.
+    /// @param received time the query was received.
+    /// @param now current time.
+    Decision check(SubnetID subnet_id, Priority priority,
+                   const boost::posix_time::ptime& received,
+                   const boost::posix_time::ptime& now);
+
+    /// @brief Returns the priority of a DHCPv4 query.
+    ///
+    /// @param query parsed query.
+    static Priority getPriority(const Pkt4& query);
+
+    /// @brief Returns the priority of a DHCPv6 query.
+    ///
+    /// @param query parsed query.
+    static Priority getPriority(const Pkt6& query);
+
+private:
+    /// @brief Token bucket of a subnet.
+    struct Bucket {
+        /// Available tokens.
+        double tokens_;
+        /// Last time the bucket was refilled.
+        boost::posix_time::ptime refilled_;
+    };
+
+    /// @brief Takes a token from the bucket of a subnet.
+    ///
+    /// @return false if the bucket is empty.
+    bool takeToken(SubnetID subnet_id, const boost::posix_time::ptime& now);
+
+    /// Queries per second of each subnet, 0 if not limited.
+    uint32_t rate_;
+
+    /// Size of the buckets.
+    uint32_t burst_;
+
+    /// Shedding delay in milliseconds, 0 if the queries are not shed.
+    uint32_t shed_delay_;
+
+    /// Buckets indexed by subnet identifier.
+    std::map<SubnetID, Bucket> buckets_;
+};
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // RATE_LIMITER_H
@@ -0,0 +1,377 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/pool.h>
+#include <dhcpsrv/server_counters.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <cstring>
+#include <limits>
+#include <set>
+#include <string>
+
+using namespace isc::asiolink;
+using namespace isc::data;
+using namespace isc::util::thread;
+
+namespace {
+
+/// @brief Source of the unique identifiers of the counters objects.
+uint64_t last_counters_id = 0;
+
+/// @brief Source of the thread identifiers.
+uint64_t last_thread_id = 0;
+
+/// @brief Identifier of the calling thread (0 until assigned).
+__thread uint64_t thread_id = 0;
+
+/// @brief Identifier of the counters object the cached slot belongs to.
+__thread uint64_t cached_counters_id = 0;
+
+/// @brief Slot of the calling thread in the counters object identified by
+/// cached_counters_id.
+__thread void* cached_slot = NULL;
+
+/// @brief Converts a counter value to an element.
+///
+/// Values which don't fit in the integer element are saturated.
+ElementPtr
+toCount(uint64_t value) {
+    const uint64_t max = std::numeric_limits<long int>::max();
+    return (Element::create(static_cast<long int>(value < max ? value :
+                                                  max)));
+}
+
+/// @brief Returns the number of addresses in the pool.
+///
+/// The result saturates at the maximum value of uint64_t, which happens
+/// only for IPv6 pools.
+uint64_t
+poolSize(const isc::dhcp::Pool& pool) {
+    const std::vector<uint8_t> first = pool.getFirstAddress().toBytes();
+    const std::vector<uint8_t> last = pool.getLastAddress().toBytes();
+
+    // Subtract the first address from the last one, octet by octet.
+    std::vector<uint8_t> diff(last.size());
+    int borrow = 0;
+    for (int i = last.size() - 1; i >= 0; --i) {
+        const int octet = last[i] - first[i] - borrow;
+        borrow = (octet < 0) ? 1 : 0;
+        diff[i] = static_cast<uint8_t>(octet + (borrow << 8));
+    }
+
+    uint64_t size = 0;
+    for (size_t i = 0; i < diff.size(); ++i) {
+        if (size > (std::numeric_limits<uint64_t>::max() >> 8)) {
+            return (std::numeric_limits<uint64_t>::max());
+        }
+        size = (size << 8) | diff[i];
+    }
+    return (size == std::numeric_limits<uint64_t>::max() ? size : size + 1);
+}
+
+}
+
+namespace isc {
+namespace dhcp {
+
+const uint8_t ServerCounters::MAX_MSG_TYPE;
+const size_t ServerCounters::CACHE_LINE_SIZE;
+
+ServerCounters::SubnetCounters::SubnetCounters() {
+    memset(values_, 0, sizeof(values_));
+}
+
+ServerCounters::Slot::Slot() {
+    memset(counters_, 0, sizeof(counters_));
+    memset(received_, 0, sizeof(received_));
+    memset(sent_, 0, sizeof(sent_));
+}
+
+ServerCounters::ServerCounters()
+    : id_(__sync_add_and_fetch(&last_counters_id, 1)) {
+}
+
+ServerCounters::~ServerCounters() {
+    for (std::map<uint64_t, Slot*>::iterator slot = slots_.begin();
+         slot != slots_.end(); ++slot) {
+        delete slot->second;
+    }
+}
+
+ServerCounters::Slot&
+ServerCounters::getSlot() {
+    if (cached_counters_id == id_) {
+        return (*static_cast<Slot*>(cached_slot));
+    }
+    return (findSlot());
+}
+
+ServerCounters::Slot&
+ServerCounters::findSlot() {
+    if (thread_id == 0) {
+        thread_id = __sync_add_and_fetch(&last_thread_id, 1);
+    }
+
+    Mutex::Locker locker(mutex_);
+    Slot*& slot = slots_[thread_id];
+    if (slot == NULL) {
+        slot = new Slot();
+    }
+    cached_counters_id = id_;
+    cached_slot = slot;
+    return (*slot);
+}
+
+void
+ServerCounters::incSubnet(SubnetID subnet_id, SubnetCounterType type) {
+    Slot& slot = getSlot();
+    SubnetMap::iterator subnet = slot.subnets_.find(subnet_id);
+    if (subnet == slot.subnets_.end()) {
+        Mutex::Locker locker(slot.mutex_);
+        subnet = slot.subnets_.insert(std::make_pair(subnet_id,
+                                                     SubnetCounters())).first;
+    }
+    ++subnet->second.values_[type];
+}
+
+uint64_t
+ServerCounters::get(CounterType type) const {
+    Mutex::Locker locker(mutex_);
+    uint64_t value = 0;
+    for (std::map<uint64_t, Slot*>::const_iterator slot = slots_.begin();
+         slot != slots_.end(); ++slot) {
+        value += slot->second->counters_[type];
+    }
+    return (value);
+}
+
+uint64_t
+ServerCounters::getReceived(uint8_t msg_type) const {
+    Mutex::Locker locker(mutex_);
+    uint64_t value = 0;
+    for (std::map<uint64_t, Slot*>::const_iterator slot = slots_.begin();
+         slot != slots_.end(); ++slot) {
+        value += slot->second->received_[msg_type <= MAX_MSG_TYPE ?
+                                         msg_type : 0];
+    }
+    return (value);
+}
+
+uint64_t
+ServerCounters::getSent(uint8_t msg_type) const {
+    Mutex::Locker locker(mutex_);
+    uint64_t value = 0;
+    for (std::map<uint64_t, Slot*>::const_iterator slot = slots_.begin();
+         slot != slots_.end(); ++slot) {
+        value += slot->second->sent_[msg_type <= MAX_MSG_TYPE ?
+                                     msg_type : 0];
+    }
+    return (value);
+}
+
+uint64_t
+ServerCounters::getSubnet(SubnetID subnet_id, SubnetCounterType type) const {
+    Mutex::Locker locker(mutex_);
+    uint64_t value = 0;
+    for (std::map<uint64_t, Slot*>::const_iterator slot = slots_.begin();
+         slot != slots_.end(); ++slot) {
+        Mutex::Locker slot_locker(slot->second->mutex_);
+        SubnetMap::const_iterator subnet =
+            slot->second->subnets_.find(subnet_id);
+        if (subnet != slot->second->subnets_.end()) {
+            value += subnet->second.values_[type];
+        }
+    }
+    return (value);
+}
+
+ElementPtr
+ServerCounters::toElement(TypeNamer namer) const {
+    // Sum the slots first, so the lock is held for a short time.
+    uint64_t counters[COUNTER_TYPES] = { 0 };
+    uint64_t received[MAX_MSG_TYPE + 1] = { 0 };
+    uint64_t sent[MAX_MSG_TYPE + 1] = { 0 };
+    SubnetMap subnets;
+    {
+        Mutex::Locker locker(mutex_);
+        for (std::map<uint64_t, Slot*>::const_iterator slot = slots_.begin();
+             slot != slots_.end(); ++slot) {
+            for (int i = 0; i < COUNTER_TYPES; ++i) {
+                counters[i] += slot->second->counters_[i];
+            }
+            for (int i = 0; i <= MAX_MSG_TYPE; ++i) {
+                received[i] += slot->second->received_[i];
+                sent[i] += slot->second->sent_[i];
+            }
+            Mutex::Locker slot_locker(slot->second->mutex_);
+            for (SubnetMap::const_iterator subnet =
+                     slot->second->subnets_.begin();
+                 subnet != slot->second->subnets_.end(); ++subnet) {
+                SubnetCounters& sum = subnets[subnet->first];
+                for (int i = 0; i < SUBNET_COUNTER_TYPES; ++i) {
+                    sum.values_[i] += subnet->second.values_[i];
+                }
+            }
+        }
+    }
+
+    ElementPtr result = Element::createMap();
+    for (int i = 0; i < COUNTER_TYPES; ++i) {
+        result->set(counterToText(static_cast<CounterType>(i)),
+                    toCount(counters[i]));
+    }
+
+    // Names returned for more than one type are ambiguous, such types are
+    // reported by their numbers.
+    std::set<std::string> names;
+    std::set<std::string> ambiguous;
+    for (unsigned int type = 0; type <= MAX_MSG_TYPE; ++type) {
+        const std::string name = namer(type);
+        if (!names.insert(name).second) {
+            ambiguous.insert(name);
+        }
+    }
+    ElementPtr received_map = Element::createMap();
+    ElementPtr sent_map = Element::createMap();
+    for (unsigned int type = 0; type <= MAX_MSG_TYPE; ++type) {
+        if ((received[type] == 0) && (sent[type] == 0)) {
+            continue;
+        }
+        std::string name = namer(type);
+        if (ambiguous.count(name) > 0) {
+            name = boost::lexical_cast<std::string>(type);
+        }
+        if (received[type] > 0) {
+            received_map->set(name, toCount(received[type]));
+        }
+        if (sent[type] > 0) {
+            sent_map->set(name, toCount(sent[type]));
+        }
+    }
+    result->set("received", received_map);
+    result->set("sent", sent_map);
+
+    ElementPtr subnets_map = Element::createMap();
+    for (SubnetMap::const_iterator subnet = subnets.begin();
+         subnet != subnets.end(); ++subnet) {
+        ElementPtr item = Element::createMap();
+        for (int i = 0; i < SUBNET_COUNTER_TYPES; ++i) {
+            item->set(subnetCounterToText(static_cast<SubnetCounterType>(i)),
+                      toCount(subnet->second.values_[i]));
+        }
+        subnets_map->set(boost::lexical_cast<std::string>(subnet->first),
+                         item);
+    }
+    result->set("subnets", subnets_map);
+    return (result);
+}
+
+void
+ServerCounters::addPoolUsage(const ElementPtr& stats, const Subnet& subnet) {
+    if (!stats->contains("subnets")) {
+        stats->set("subnets", Element::createMap());
+    }
+    ElementPtr subnets =
+        boost::const_pointer_cast<Element>(stats->get("subnets"));
+    const std::string key = boost::lexical_cast<std::string>(subnet.getID());
+    ElementPtr item;
+    if (subnets->contains(key)) {
+        item = boost::const_pointer_cast<Element>(subnets->get(key));
+    } else {
+        item = Element::createMap();
+        for (int i = 0; i < SUBNET_COUNTER_TYPES; ++i) {
+            item->set(subnetCounterToText(static_cast<SubnetCounterType>(i)),
+                      toCount(0));
+        }
+        subnets->set(key, item);
+    }
+    item->set("subnet", Element::create(subnet.toText()));
+
+    // Only the pools of addresses are counted (no prefix delegation).
+    const bool v6 = (dynamic_cast<const Subnet6*>(&subnet) != NULL);
+    uint64_t total = 0;
+    const PoolCollection& all_pools = subnet.getPools();
+    for (PoolCollection::const_iterator pool = all_pools.begin();
+         pool != all_pools.end(); ++pool) {
+        if (v6 && (static_cast<const Pool6*>(pool->get())->getType() !=
+                   Pool6::TYPE_IA)) {
+            continue;
+        }
+        const uint64_t size = poolSize(**pool);
+        if (size > std::numeric_limits<uint64_t>::max() - total) {
+            total = std::numeric_limits<uint64_t>::max();
+        } else {
+            total += size;
+        }
+    }
+    item->set("total-addresses", toCount(total));
+}
+
+const char*
+ServerCounters::counterToText(CounterType type) {
+    switch (type) {
+    case PARSE_FAILED:
+        return ("parse-failed");
+    case PROCESS_FAILED:
+        return ("process-failed");
+    case NO_SUBNET:
+        return ("no-subnet");
+    case ALLOC_FAILED:
+        return ("alloc-failed");
+    case SEND_FAILED:
+        return ("send-failed");
+    case DHCP4O6_FORWARDED:
+        return ("dhcp4o6-forwarded");
+    case DHCP4O6_ANSWERED:
+        return ("dhcp4o6-answered");
+    case DHCP4O6_TIMED_OUT:
+        return ("dhcp4o6-timed-out");
+    case LB_NOT_IN_SCOPE:
+        return ("load-balancing-skipped");
+    case RATE_LIMITED:
+        return ("rate-limited");
+    case OVERLOAD_SHED:
+        return ("overload-shed");
+    default:
+        ;
+    }
+    return ("unknown");
+}
+
+const char*
+ServerCounters::subnetCounterToText(SubnetCounterType type) {
+    switch (type) {
+    case SUBNET_RECEIVED:
+        return ("received");
+    case SUBNET_ALLOCATED:
+        return ("allocated");
+    case SUBNET_ALLOC_FAILED:
+        return ("alloc-failed");
+    case SUBNET_RELEASED:
+        return ("released");
+    case SUBNET_RATE_LIMITED:
+        return ("rate-limited");
+    case SUBNET_SHED:
+        return ("shed");
+    default:
+        ;
+    }
+    return ("unknown");
+}
+
+} // namespace isc::dhcp
+} // namespace isc
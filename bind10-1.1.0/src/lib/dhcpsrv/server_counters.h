@@ -0,0 +1,221 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SERVER_COUNTERS_H
+#define SERVER_COUNTERS_H
+
+#include <cc/data.h>
+#include <dhcpsrv/subnet.h>
+#include <util/threads/sync.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <map>
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Statistics counters of a DHCP server.
+///
+/// The counters count the received and sent messages per message type,
+/// the events of the message processing (parse failures, allocation
+/// failures, DHCPv4-over-DHCPv6 forwarding) and the lease operations per
+/// subnet. They are reported to the b10-stats module in reply to the
+/// "getstats" command.
+///
+/// Each thread updating the counters gets its own slot, so the counters
+/// are incremented without atomic operations or locks. The slots are
+/// padded to cache line boundaries, so the threads don't share cache
+/// lines either. Reading the counters sums the slots of all threads;
+/// the values read while other threads update them may be slightly
+/// behind, but they are never torn.
+///
+/// The per-subnet counters of a slot are held in a map. The owning thread
+/// looks the subnet up without locking and takes the lock of the slot
+/// only to insert a subnet seen for the first time, which is what the
+/// readers synchronize with.
+class ServerCounters : public boost::noncopyable {
+public:
+
+    /// @brief Server-wide counters.
+    enum CounterType {
+        PARSE_FAILED,       ///< Received messages which couldn't be parsed
+        PROCESS_FAILED,     ///< Messages dropped due to processing errors
+        NO_SUBNET,          ///< Messages from clients with no subnet
+        ALLOC_FAILED,       ///< Failed lease allocations
+        SEND_FAILED,        ///< Responses which couldn't be sent
+        DHCP4O6_FORWARDED,  ///< DHCPv4-queries passed to the DHCPv4 server
+        DHCP4O6_ANSWERED,   ///< DHCPv4-queries answered by the DHCPv4 server
+        DHCP4O6_TIMED_OUT,  ///< DHCPv4-queries not answered in time
+        LB_NOT_IN_SCOPE,    ///< Queries left to the load balancing peer
+        RATE_LIMITED,       ///< Queries over the rate of their subnet
+        OVERLOAD_SHED,      ///< Queries which waited too long to be processed
+        COUNTER_TYPES       ///< Number of counters (not a counter)
+    };
+
+    /// @brief Per-subnet counters.
+    enum SubnetCounterType {
+        SUBNET_RECEIVED,        ///< Messages processed within the subnet
+        SUBNET_ALLOCATED,       ///< Leases assigned or renewed
+        SUBNET_ALLOC_FAILED,    ///< Failed lease allocations
+        SUBNET_RELEASED,        ///< Leases released by the clients
+        SUBNET_RATE_LIMITED,    ///< Queries over the rate of the subnet
+        SUBNET_SHED,            ///< Queries which waited too long
+        SUBNET_COUNTER_TYPES    ///< Number of counters (not a counter)
+    };
+
+    /// @brief Highest message type counted separately. Messages of higher
+    /// types are counted with the type 0.
+    static const uint8_t MAX_MSG_TYPE = 63;
+
+    /// @brief Size of the cache line the slots are padded to.
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    /// @brief Function returning the name of a message type.
+    typedef const char* (*TypeNamer)(uint8_t);
+
+    /// @brief Constructor.
+    ///
+    /// All counters are zero.
+    ServerCounters();
+
+    /// @brief Destructor.
+    ~ServerCounters();
+
+    /// @brief Increments a server-wide counter.
+    ///
+    /// @param type counter to increment
+    void inc(CounterType type) {
+        ++getSlot().counters_[type];
+    }
+
+    /// @brief Counts a received message.
+    ///
+    /// @param msg_type type of the message
+    void incReceived(uint8_t msg_type) {
+        ++getSlot().received_[msg_type <= MAX_MSG_TYPE ? msg_type : 0];
+    }
+
+    /// @brief Counts a sent message.
+    ///
+    /// @param msg_type type of the message
+    void incSent(uint8_t msg_type) {
+        ++getSlot().sent_[msg_type <= MAX_MSG_TYPE ? msg_type : 0];
+    }
+
+    /// @brief Increments a per-subnet counter.
+    ///
+    /// @param subnet_id identifier of the subnet
+    /// @param type counter to increment
+    void incSubnet(SubnetID subnet_id, SubnetCounterType type);
+
+    /// @brief Returns the value of a server-wide counter.
+    uint64_t get(CounterType type) const;
+
+    /// @brief Returns the number of received messages of the given type.
+    uint64_t getReceived(uint8_t msg_type) const;
+
+    /// @brief Returns the number of sent messages of the given type.
+    uint64_t getSent(uint8_t msg_type) const;
+
+    /// @brief Returns the value of a per-subnet counter.
+    uint64_t getSubnet(SubnetID subnet_id, SubnetCounterType type) const;
+
+    /// @brief Returns the counters in the form reported to b10-stats.
+    ///
+    /// The result is a map with the server-wide counters, the maps
+    /// "received" and "sent" with the message counts indexed by the names
+    /// of the message types and the map "subnets" with the per-subnet
+    /// counters indexed by the subnet identifiers. Zero counts of the
+    /// message types and unused subnets are omitted.
+    ///
+    /// @param namer function returning the names of the message types
+    isc::data::ElementPtr toElement(TypeNamer namer) const;
+
+    /// @brief Adds the size of the address pools to the statistics.
+    ///
+    /// For each subnet, the number of addresses in its pools is stored in
+    /// the entry of the subnet in the "subnets" map of @c stats, together
+    /// with the subnet prefix. The map and the entry are created if needed.
+    ///
+    /// The number of leased addresses is not reported: it could only be
+    /// obtained by lease database lookups, which would hold up the
+    /// processing of the queries at every statistics request.
+    ///
+    /// @param stats statistics returned by @ref toElement
+    /// @param subnet subnet which pools are counted
+    static void addPoolUsage(const isc::data::ElementPtr& stats,
+                             const Subnet& subnet);
+
+    /// @brief Returns the names of the server-wide counters.
+    static const char* counterToText(CounterType type);
+
+    /// @brief Returns the names of the per-subnet counters.
+    static const char* subnetCounterToText(SubnetCounterType type);
+
+private:
+    /// @brief Per-subnet counters held in a slot.
+    struct SubnetCounters {
+        SubnetCounters();
+        uint64_t values_[SUBNET_COUNTER_TYPES];
+    };
+
+    /// @brief Per-subnet counters indexed by the subnet identifier.
+    typedef std::map<SubnetID, SubnetCounters> SubnetMap;
+
+    /// @brief Counters updated by a single thread.
+    struct Slot : public boost::noncopyable {
+        Slot();
+
+        /// @brief Keeps the counters off the cache line of the preceding
+        /// allocation.
+        char head_padding_[CACHE_LINE_SIZE];
+        uint64_t counters_[COUNTER_TYPES];
+        uint64_t received_[MAX_MSG_TYPE + 1];
+        uint64_t sent_[MAX_MSG_TYPE + 1];
+        SubnetMap subnets_;
+        /// @brief Protects the insertions into subnets_.
+        mutable isc::util::thread::Mutex mutex_;
+        /// @brief Keeps the counters off the cache line of the following
+        /// allocation.
+        char tail_padding_[CACHE_LINE_SIZE];
+    };
+
+    /// @brief Returns the slot of the calling thread.
+    ///
+    /// The slot is cached in thread local storage, so after the first call
+    /// from a thread, this only compares the identifier of the counters
+    /// with the cached one.
+    Slot& getSlot();
+
+    /// @brief Finds or creates the slot of the calling thread.
+    Slot& findSlot();
+
+    /// @brief Unique identifier of this object (used by the slot cache).
+    const uint64_t id_;
+
+    /// @brief Slots indexed by the thread identifiers.
+    std::map<uint64_t, Slot*> slots_;
+
+    /// @brief Protects slots_.
+    mutable isc::util::thread::Mutex mutex_;
+};
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // SERVER_COUNTERS_H
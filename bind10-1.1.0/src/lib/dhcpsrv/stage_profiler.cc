@@ -0,0 +1,191 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/stage_profiler.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <cstring>
+#include <set>
+#include <string>
+
+#include <sys/time.h>
+#include <time.h>
+
+using namespace isc::data;
+
+namespace isc {
+namespace dhcp {
+
+const size_t StageProfiler::BUCKET_COUNT;
+const uint8_t StageProfiler::MAX_MSG_TYPE;
+
+StageProfiler::AllocCounter StageProfiler::alloc_counter_ = NULL;
+
+StageProfiler::StageProfiler()
+    : enabled_(false) {
+}
+
+void
+StageProfiler::setEnabled(bool enabled) {
+    if (enabled && stats_.empty()) {
+        stats_.resize((MAX_MSG_TYPE + 1) * STAGE_COUNT);
+        reset();
+    }
+    enabled_ = enabled;
+}
+
+void
+StageProfiler::reset() {
+    if (!stats_.empty()) {
+        memset(&stats_[0], 0, stats_.size() * sizeof(StageStats));
+    }
+}
+
+const StageProfiler::StageStats&
+StageProfiler::getStats(uint8_t msg_type, Stage stage) const {
+    static const StageStats empty = StageStats();
+    if (stats_.empty()) {
+        return (empty);
+    }
+    if (msg_type > MAX_MSG_TYPE) {
+        msg_type = 0;
+    }
+    return (stats_[msg_type * STAGE_COUNT + stage]);
+}
+
+void
+StageProfiler::recordInternal(uint8_t msg_type, Stage stage,
+                              const Mark& begin, const Mark& end) {
+    const uint64_t duration = end.time_ - begin.time_;
+    if (msg_type > MAX_MSG_TYPE) {
+        msg_type = 0;
+    }
+    StageStats& stats = stats_[msg_type * STAGE_COUNT + stage];
+    ++stats.count_;
+    stats.total_ += duration;
+    if (duration > stats.max_) {
+        stats.max_ = duration;
+    }
+    stats.allocs_ += end.allocs_ - begin.allocs_;
+    ++stats.buckets_[bucketIndex(duration)];
+}
+
+size_t
+StageProfiler::bucketIndex(uint64_t duration) {
+    size_t index = 0;
+    while ((duration > 0) && (index < BUCKET_COUNT - 1)) {
+        duration >>= 1;
+        ++index;
+    }
+    return (index);
+}
+
+ElementPtr
+StageProfiler::toElement(TypeNamer namer) const {
+    ElementPtr result = Element::createMap();
+    if (stats_.empty()) {
+        return (result);
+    }
+
+    // Names returned for more than one type are ambiguous.
+    std::set<std::string> names;
+    std::set<std::string> ambiguous;
+    for (unsigned int type = 0; type <= MAX_MSG_TYPE; ++type) {
+        const std::string name = namer(type);
+        if (!names.insert(name).second) {
+            ambiguous.insert(name);
+        }
+    }
+
+    for (unsigned int type = 0; type <= MAX_MSG_TYPE; ++type) {
+        ElementPtr stages = Element::createMap();
+        for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+            const StageStats& stats = stats_[type * STAGE_COUNT + stage];
+            if (stats.count_ == 0) {
+                continue;
+            }
+            ElementPtr item = Element::createMap();
+            item->set("count", Element::create(static_cast<long int>(
+                                                   stats.count_)));
+            item->set("total-ns", Element::create(static_cast<long int>(
+                                                      stats.total_)));
+            item->set("max-ns", Element::create(static_cast<long int>(
+                                                    stats.max_)));
+            item->set("allocations", Element::create(static_cast<long int>(
+                                                         stats.allocs_)));
+            ElementPtr histogram = Element::createList();
+            for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+                histogram->add(Element::create(static_cast<long int>(
+                                                   stats.buckets_[i])));
+            }
+            item->set("histogram", histogram);
+            stages->set(stageToText(static_cast<Stage>(stage)), item);
+        }
+        if (stages->mapValue().empty()) {
+            continue;
+        }
+        std::string name = namer(type);
+        if (ambiguous.count(name) > 0) {
+            name = boost::lexical_cast<std::string>(type);
+        }
+        result->set(name, stages);
+    }
+    return (result);
+}
+
+const char*
+StageProfiler::stageToText(Stage stage) {
+    switch (stage) {
+    case RECEIVE_WAIT:
+        return ("receive-wait");
+    case UNPACK:
+        return ("unpack");
+    case SUBNET_SELECTION:
+        return ("subnet-selection");
+    case LEASE_BACKEND:
+        return ("lease-backend");
+    case PACK:
+        return ("pack");
+    case SEND:
+        return ("send");
+    case IPC_WAIT:
+        return ("ipc-wait");
+    default:
+        ;
+    }
+    return ("unknown");
+}
+
+uint64_t
+StageProfiler::now() {
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return (static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec);
+    }
+#endif
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (static_cast<uint64_t>(tv.tv_sec) * 1000000000 +
+            tv.tv_usec * 1000);
+}
+
+void
+StageProfiler::setAllocCounter(AllocCounter counter) {
+    alloc_counter_ = counter;
+}
+
+} // namespace isc::dhcp
+} // namespace isc
@@ -0,0 +1,246 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef STAGE_PROFILER_H
+#define STAGE_PROFILER_H
+
+#include <cc/data.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Processing time of the stages of the DHCP message handling.
+///
+/// The server marks the beginning of each stage of the processing of a
+/// message (waiting for the message, parsing it, selecting the subnet,
+/// accessing the lease database, building the response and sending it)
+/// and records the time spent in the stage when the stage ends. The
+/// times are aggregated per message type into logarithmic histograms, so
+/// the distribution of the processing time of a busy server can be
+/// obtained without attaching a profiler.
+///
+/// The clock is read with clock_gettime(CLOCK_MONOTONIC), which doesn't
+/// enter the kernel on the common platforms. When the profiler is
+/// disabled (the default), neither the clock is read nor any data are
+/// stored, so the cost is a single test of a flag.
+///
+/// If an allocation counter is installed (see @ref setAllocCounter), the
+/// number of memory allocations made in each stage is recorded too.
+class StageProfiler : public boost::noncopyable {
+public:
+
+    /// @brief Stages of the message processing.
+    enum Stage {
+        RECEIVE_WAIT,       ///< Waiting for the message to arrive
+        UNPACK,             ///< Parsing the received message
+        SUBNET_SELECTION,   ///< Selecting the subnet for the client
+        LEASE_BACKEND,      ///< Allocation engine and lease database
+        PACK,               ///< Rendering the response
+        SEND,               ///< Sending the response
+        IPC_WAIT,           ///< Waiting for the DHCPv4 server (4o6)
+        STAGE_COUNT         ///< Number of stages (not a stage)
+    };
+
+    /// @brief Number of histogram buckets.
+    ///
+    /// Bucket 0 counts zero durations, bucket N (N > 0) the durations from
+    /// 2^(N-1) to 2^N - 1 nanoseconds. The last bucket also counts all
+    /// longer durations.
+    static const size_t BUCKET_COUNT = 32;
+
+    /// @brief Highest message type for which the times are stored
+    /// separately. Times of the messages of higher types are stored
+    /// with the type 0.
+    static const uint8_t MAX_MSG_TYPE = 63;
+
+    /// @brief Statistics of a single stage for a single message type.
+    struct StageStats {
+        /// @brief Number of recorded durations.
+        uint64_t count_;
+        /// @brief Sum of the durations in nanoseconds.
+        uint64_t total_;
+        /// @brief Longest duration in nanoseconds.
+        uint64_t max_;
+        /// @brief Sum of the allocation counts.
+        uint64_t allocs_;
+        /// @brief Histogram of the durations.
+        uint64_t buckets_[BUCKET_COUNT];
+    };
+
+    /// @brief Beginning of a stage.
+    struct Mark {
+        /// @brief Time in nanoseconds, 0 if the profiler is disabled.
+        uint64_t time_;
+        /// @brief Allocation count.
+        uint64_t allocs_;
+    };
+
+    /// @brief Function returning the number of allocations so far.
+    typedef uint64_t (*AllocCounter)();
+
+    /// @brief Function returning the name of a message type.
+    typedef const char* (*TypeNamer)(uint8_t type);
+
+    /// @brief Measures the stage between the construction and destruction.
+    class Timer : public boost::noncopyable {
+    public:
+        /// @brief Constructor, marks the beginning of the stage.
+        ///
+        /// @param profiler profiler recording the stage.
+        /// @param msg_type type of the processed message.
+        /// @param stage the stage being measured.
+        Timer(StageProfiler& profiler, uint8_t msg_type, Stage stage) :
+            profiler_(profiler), msg_type_(msg_type), stage_(stage),
+            mark_(profiler.mark())
+        {}
+
+        /// @brief Destructor, records the stage.
+        ~Timer() {
+            profiler_.record(msg_type_, stage_, mark_);
+        }
+
+    private:
+        StageProfiler& profiler_;
+        const uint8_t msg_type_;
+        const Stage stage_;
+        const Mark mark_;
+    };
+
+    /// @brief Constructor.
+    ///
+    /// The profiler is created disabled.
+    StageProfiler();
+
+    /// @brief Enables or disables the profiler.
+    ///
+    /// The statistics collected so far are kept.
+    ///
+    /// @param enabled true to enable the profiler.
+    void setEnabled(bool enabled);
+
+    /// @brief Checks if the profiler is enabled.
+    bool isEnabled() const {
+        return (enabled_);
+    }
+
+    /// @brief Discards the collected statistics.
+    void reset();
+
+    /// @brief Marks the beginning of a stage.
+    ///
+    /// @return the current time (and allocation count) or an empty mark
+    /// if the profiler is disabled.
+    Mark mark() const {
+        Mark mark = { 0, 0 };
+        if (enabled_) {
+            mark.time_ = now();
+            if (alloc_counter_) {
+                mark.allocs_ = alloc_counter_();
+            }
+        }
+        return (mark);
+    }
+
+    /// @brief Records the end of the stage.
+    ///
+    /// Nothing is recorded if the profiler is disabled or if the mark was
+    /// taken while the profiler was disabled.
+    ///
+    /// @param msg_type type of the processed message.
+    /// @param stage the stage which ends.
+    /// @param mark the beginning of the stage.
+    void record(uint8_t msg_type, Stage stage, const Mark& mark) {
+        if (enabled_ && mark.time_) {
+            recordInternal(msg_type, stage, mark, this->mark());
+        }
+    }
+
+    /// @brief Records the stage which ended earlier.
+    ///
+    /// @param msg_type type of the processed message.
+    /// @param stage the stage.
+    /// @param begin the beginning of the stage.
+    /// @param end the end of the stage.
+    void record(uint8_t msg_type, Stage stage, const Mark& begin,
+                const Mark& end) {
+        if (enabled_ && begin.time_ && end.time_) {
+            recordInternal(msg_type, stage, begin, end);
+        }
+    }
+
+    /// @brief Returns the statistics of the stage.
+    ///
+    /// @param msg_type message type.
+    /// @param stage the stage.
+    const StageStats& getStats(uint8_t msg_type, Stage stage) const;
+
+    /// @brief Returns the collected statistics as an element.
+    ///
+    /// The element is a map indexed by the message type name, holding
+    /// maps indexed by the stage name (see @ref stageToText). Each
+    /// stage is a map of "count", "total-ns", "max-ns", "allocations"
+    /// and "histogram" (the list of BUCKET_COUNT bucket counts). Message
+    /// types and stages which have not been recorded are omitted.
+    ///
+    /// @param namer function returning the name of a message type. Types
+    /// for which it returns the same name are reported by number.
+    isc::data::ElementPtr toElement(TypeNamer namer) const;
+
+    /// @brief Returns the name of the stage used in the statistics.
+    static const char* stageToText(Stage stage);
+
+    /// @brief Returns the current time of the monotonic clock.
+    ///
+    /// @return time in nanoseconds.
+    static uint64_t now();
+
+    /// @brief Installs the function counting memory allocations.
+    ///
+    /// The function is used by all profilers. It is set when the program
+    /// is built with allocation counting (--enable-alloc-counting).
+    ///
+    /// @param counter the function, NULL to disable allocation counting.
+    static void setAllocCounter(AllocCounter counter);
+
+    /// @brief Returns the index of the histogram bucket for a duration.
+    static size_t bucketIndex(uint64_t duration);
+
+private:
+
+    /// @brief Stores the duration of the stage.
+    void recordInternal(uint8_t msg_type, Stage stage, const Mark& begin,
+                        const Mark& end);
+
+    /// @brief Indicates if the profiler is enabled.
+    bool enabled_;
+
+    /// @brief Statistics indexed by message type and stage.
+    ///
+    /// Allocated when the profiler is enabled for the first time.
+    std::vector<StageStats> stats_;
+
+    /// @brief The allocation counter, if installed.
+    static AllocCounter alloc_counter_;
+};
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // STAGE_PROFILER_H
@@ -261,6 +261,20 @@ public:
     /// @return unique ID for that subnet
     SubnetID getID() const { return (id_); }
 
+    /// @brief Takes over the state of the subnet this one replaces.
+    ///
+    /// When the server is reconfigured, a new subnet object is created for
+    /// every configured subnet. If the previous configuration had a subnet
+    /// with the same prefix, the new subnet keeps its ID, which the leases
+    /// refer to, and the last allocated address, so the allocation doesn't
+    /// start over from the beginning of the pools.
+    ///
+    /// @param previous subnet of the previous configuration.
+    void inheritState(const Subnet& previous) {
+        id_ = previous.id_;
+        last_allocated_ = previous.last_allocated_;
+    }
+
     /// @brief returns subnet parameters (prefix and prefix length)
     ///
     /// @return (prefix, prefix length) pair
@@ -423,6 +437,9 @@ typedef boost::shared_ptr<Subnet4> Subnet4Ptr;
 /// @brief A collection of Subnet6 objects
 typedef std::vector<Subnet4Ptr> Subnet4Collection;
 
+/// @brief A pointer to a collection of Subnet4 objects which is not modified
+typedef boost::shared_ptr<const Subnet4Collection> ConstSubnet4CollectionPtr;
+
 
 /// @brief A configuration holder for IPv6 subnet.
 ///
@@ -491,6 +508,9 @@ typedef boost::shared_ptr<Subnet6> Subnet6Ptr;
 /// @brief A collection of Subnet6 objects
 typedef std::vector<Subnet6Ptr> Subnet6Collection;
 
+/// @brief A pointer to a collection of Subnet6 objects which is not modified
+typedef boost::shared_ptr<const Subnet6Collection> ConstSubnet6CollectionPtr;
+
 } // end of isc::dhcp namespace
 } // end of isc namespace
 
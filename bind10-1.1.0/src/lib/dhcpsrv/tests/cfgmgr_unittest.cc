@@ -364,8 +364,14 @@ TEST_F(CfgMgrTest, subnet4) {
     // Try to find an address that does not belong to any subnet
     EXPECT_FALSE(cfg_mgr.getSubnet4(IOAddress("192.0.2.192")));
 
+    // All subnets are returned in the order they were added.
+    ASSERT_EQ(3, cfg_mgr.getSubnets4()->size());
+    EXPECT_EQ(subnet1, cfg_mgr.getSubnets4()->at(0));
+    EXPECT_EQ(subnet3, cfg_mgr.getSubnets4()->at(2));
+
     // Check that deletion of the subnets works.
     cfg_mgr.deleteSubnets4();
+    EXPECT_TRUE(cfg_mgr.getSubnets4()->empty());
     EXPECT_FALSE(cfg_mgr.getSubnet4(IOAddress("192.0.2.191")));
     EXPECT_FALSE(cfg_mgr.getSubnet4(IOAddress("192.0.2.15")));
     EXPECT_FALSE(cfg_mgr.getSubnet4(IOAddress("192.0.2.85")));
@@ -406,6 +412,148 @@ TEST_F(CfgMgrTest, subnet6) {
     EXPECT_FALSE(cfg_mgr.getSubnet6(IOAddress("4000::123")));
 }
 
+// This test verifies that the replaced IPv4 subnets keep the ID and the
+// allocation state of the subnets with the same prefix.
+TEST_F(CfgMgrTest, replaceSubnets4) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+
+    Subnet4Ptr subnet1(new Subnet4(IOAddress("192.0.2.0"), 26, 1, 2, 3));
+    Subnet4Ptr subnet2(new Subnet4(IOAddress("192.0.2.64"), 26, 1, 2, 3));
+    subnet1->setLastAllocated(IOAddress("192.0.2.10"));
+    cfg_mgr.addSubnet4(subnet1);
+    cfg_mgr.addSubnet4(subnet2);
+
+    // The first subnet is kept, the second one is resized, which makes
+    // it a different subnet, and the third one is new.
+    Subnet4Collection subnets;
+    subnets.push_back(Subnet4Ptr(new Subnet4(IOAddress("192.0.2.0"), 26,
+                                             1, 2, 3)));
+    subnets.push_back(Subnet4Ptr(new Subnet4(IOAddress("192.0.2.64"), 27,
+                                             1, 2, 3)));
+    subnets.push_back(Subnet4Ptr(new Subnet4(IOAddress("192.0.2.128"), 26,
+                                             1, 2, 3)));
+    const ConstSubnet4CollectionPtr previous = cfg_mgr.getSubnets4();
+    const ConstSubnet4CollectionPtr built = cfg_mgr.buildSubnets4(subnets);
+    // Building the subnets doesn't change the configuration.
+    EXPECT_EQ(previous, cfg_mgr.getSubnets4());
+    cfg_mgr.replaceSubnets4(built);
+
+    // The previous collection is not modified by the replacement.
+    ASSERT_EQ(2, previous->size());
+    EXPECT_EQ(subnet2, (*previous)[1]);
+
+    const ConstSubnet4CollectionPtr replaced_ptr = cfg_mgr.getSubnets4();
+    const Subnet4Collection& replaced = *replaced_ptr;
+    ASSERT_EQ(3, replaced.size());
+    EXPECT_EQ(subnets[0], replaced[0]);
+    EXPECT_EQ(subnet1->getID(), replaced[0]->getID());
+    EXPECT_EQ("192.0.2.10",
+              replaced[0]->getLastAllocated().toText());
+    EXPECT_NE(subnet2->getID(), replaced[1]->getID());
+    EXPECT_NE(subnet1->getID(), replaced[2]->getID());
+
+    EXPECT_EQ(replaced[2], cfg_mgr.getSubnet4(IOAddress("192.0.2.191")));
+    EXPECT_FALSE(cfg_mgr.getSubnet4(IOAddress("192.0.2.100")));
+
+    // Removing all subnets is a replacement too.
+    cfg_mgr.replaceSubnets4(cfg_mgr.buildSubnets4(Subnet4Collection()));
+    EXPECT_TRUE(cfg_mgr.getSubnets4()->empty());
+}
+
+// This test verifies that the replaced IPv6 subnets keep the ID and the
+// allocation state of the subnets with the same prefix.
+TEST_F(CfgMgrTest, replaceSubnets6) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+
+    Subnet6Ptr subnet1(new Subnet6(IOAddress("2000::"), 48, 1, 2, 3, 4));
+    Subnet6Ptr subnet2(new Subnet6(IOAddress("3000::"), 48, 1, 2, 3, 4));
+    subnet1->setLastAllocated(IOAddress("2000::10"));
+    cfg_mgr.addSubnet6(subnet1);
+    cfg_mgr.addSubnet6(subnet2);
+
+    // The subnets are listed in a different order and a prefix is
+    // listed twice: only the first subnet takes over the state.
+    Subnet6Collection subnets;
+    subnets.push_back(Subnet6Ptr(new Subnet6(IOAddress("4000::"), 48,
+                                             1, 2, 3, 4)));
+    subnets.push_back(Subnet6Ptr(new Subnet6(IOAddress("2000::"), 48,
+                                             1, 2, 3, 4)));
+    subnets.push_back(Subnet6Ptr(new Subnet6(IOAddress("2000::"), 48,
+                                             1, 2, 3, 4)));
+    cfg_mgr.replaceSubnets6(cfg_mgr.buildSubnets6(subnets));
+
+    const ConstSubnet6CollectionPtr replaced_ptr = cfg_mgr.getSubnets6();
+    const Subnet6Collection& replaced = *replaced_ptr;
+    ASSERT_EQ(3, replaced.size());
+    EXPECT_NE(subnet1->getID(), replaced[0]->getID());
+    EXPECT_EQ(subnet1->getID(), replaced[1]->getID());
+    EXPECT_EQ("2000::10",
+              replaced[1]->getLastAllocated().toText());
+    EXPECT_NE(subnet1->getID(), replaced[2]->getID());
+
+    EXPECT_FALSE(cfg_mgr.getSubnet6(IOAddress("3000::1")));
+}
+
+// This test verifies that single IPv4 subnets can be found by prefix,
+// updated and removed.
+TEST_F(CfgMgrTest, updateSubnet4) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+
+    Subnet4Ptr subnet1(new Subnet4(IOAddress("192.0.2.0"), 26, 1, 2, 3));
+    Subnet4Ptr subnet2(new Subnet4(IOAddress("192.0.2.64"), 26, 1, 2, 3));
+    Subnet4Ptr subnet3(new Subnet4(IOAddress("192.0.2.128"), 26, 1, 2, 3));
+    subnet2->setLastAllocated(IOAddress("192.0.2.70"));
+    cfg_mgr.addSubnet4(subnet1);
+    cfg_mgr.addSubnet4(subnet2);
+    cfg_mgr.addSubnet4(subnet3);
+
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet4ByPrefix(IOAddress("192.0.2.64"), 26));
+    EXPECT_FALSE(cfg_mgr.getSubnet4ByPrefix(IOAddress("192.0.2.64"), 27));
+
+    // The updated subnet takes the place and the state of the old one.
+    Subnet4Ptr updated(new Subnet4(IOAddress("192.0.2.64"), 26, 4, 5, 6));
+    EXPECT_TRUE(cfg_mgr.updateSubnet4(updated));
+    ASSERT_EQ(3, cfg_mgr.getSubnets4()->size());
+    EXPECT_EQ(updated, cfg_mgr.getSubnets4()->at(1));
+    EXPECT_EQ(subnet2->getID(), updated->getID());
+    EXPECT_EQ("192.0.2.70", updated->getLastAllocated().toText());
+    EXPECT_EQ(updated, cfg_mgr.getSubnet4(IOAddress("192.0.2.100")));
+
+    Subnet4Ptr unknown(new Subnet4(IOAddress("192.0.3.0"), 26, 1, 2, 3));
+    EXPECT_FALSE(cfg_mgr.updateSubnet4(unknown));
+
+    EXPECT_TRUE(cfg_mgr.deleteSubnet4(IOAddress("192.0.2.0"), 26));
+    EXPECT_FALSE(cfg_mgr.deleteSubnet4(IOAddress("192.0.2.0"), 26));
+    ASSERT_EQ(2, cfg_mgr.getSubnets4()->size());
+    EXPECT_EQ(updated, cfg_mgr.getSubnets4()->at(0));
+    EXPECT_EQ(subnet3, cfg_mgr.getSubnets4()->at(1));
+    EXPECT_FALSE(cfg_mgr.getSubnet4(IOAddress("192.0.2.1")));
+}
+
+// This test verifies that single IPv6 subnets can be found by prefix,
+// updated and removed.
+TEST_F(CfgMgrTest, updateSubnet6) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+
+    Subnet6Ptr subnet1(new Subnet6(IOAddress("2000::"), 48, 1, 2, 3, 4));
+    Subnet6Ptr subnet2(new Subnet6(IOAddress("3000::"), 48, 1, 2, 3, 4));
+    cfg_mgr.addSubnet6(subnet1);
+    cfg_mgr.addSubnet6(subnet2);
+
+    EXPECT_EQ(subnet1, cfg_mgr.getSubnet6ByPrefix(IOAddress("2000::"), 48));
+    EXPECT_FALSE(cfg_mgr.getSubnet6ByPrefix(IOAddress("2000::"), 64));
+
+    Subnet6Ptr updated(new Subnet6(IOAddress("2000::"), 48, 5, 6, 7, 8));
+    EXPECT_TRUE(cfg_mgr.updateSubnet6(updated));
+    EXPECT_EQ(subnet1->getID(), updated->getID());
+    EXPECT_EQ(updated, cfg_mgr.getSubnet6(IOAddress("2000::1")));
+
+    EXPECT_TRUE(cfg_mgr.deleteSubnet6(IOAddress("3000::"), 48));
+    EXPECT_FALSE(cfg_mgr.deleteSubnet6(IOAddress("4000::"), 48));
+    ASSERT_EQ(1, cfg_mgr.getSubnets6()->size());
+    EXPECT_EQ(updated, cfg_mgr.getSubnets6()->at(0));
+}
+
 // This test verifies that new DHCPv4 option spaces can be added to
 // the configuration manager and that duplicated option space is
 // rejected.
@@ -0,0 +1,158 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcpsrv/hash_ring.h>
+#include <exceptions/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace isc;
+using namespace isc::dhcp;
+
+namespace {
+
+class HashRingTest : public ::testing::Test {
+public:
+    /// @brief Sets the members "a", "b", ... of the ring.
+    void setMembers(size_t count) {
+        std::vector<std::string> names;
+        for (size_t i = 0; i < count; ++i) {
+            names.push_back(std::string(1, 'a' + i));
+        }
+        ring_.setMembers(names);
+    }
+
+    /// @brief Returns the members all test keys are mapped to.
+    std::vector<size_t> selectAll() const {
+        std::vector<size_t> members;
+        for (uint32_t i = 0; i < KEYS; ++i) {
+            members.push_back(select(i));
+        }
+        return (members);
+    }
+
+    /// @brief Returns the member a test key is mapped to.
+    size_t select(uint32_t i) const {
+        // Keys looking like hardware addresses of the same vendor.
+        const uint8_t key[] = { 0x00, 0x0c, 0x01,
+                                static_cast<uint8_t>(i >> 16),
+                                static_cast<uint8_t>((i >> 8) & 0xff),
+                                static_cast<uint8_t>(i & 0xff) };
+        return (ring_.select(key, sizeof(key)));
+    }
+
+    /// Number of test keys.
+    static const uint32_t KEYS = 10000;
+
+    HashRing ring_;
+};
+
+const uint32_t HashRingTest::KEYS;
+
+// Checks that an empty ring maps no key.
+TEST_F(HashRingTest, empty) {
+    EXPECT_THROW(HashRing(0), BadValue);
+    EXPECT_EQ(HashRing::NO_MEMBER, select(1));
+    setMembers(1);
+    EXPECT_EQ(0, select(1));
+    ring_.setMembers(std::vector<std::string>());
+    EXPECT_EQ(HashRing::NO_MEMBER, select(1));
+}
+
+// Checks that the hash doesn't depend on the platform.
+TEST_F(HashRingTest, hash) {
+    const uint8_t key[] = { 1, 2, 3, 4 };
+    EXPECT_EQ(0xf6ec518342f132beULL, HashRing::hash(key, sizeof(key)));
+    EXPECT_NE(HashRing::hash(key, 3), HashRing::hash(key, sizeof(key)));
+}
+
+// Checks that the keys are spread over the members.
+TEST_F(HashRingTest, spread) {
+    setMembers(4);
+    std::vector<size_t> counts(4);
+    const std::vector<size_t> members = selectAll();
+    for (uint32_t i = 0; i < KEYS; ++i) {
+        ASSERT_LT(members[i], 4);
+        ++counts[members[i]];
+    }
+    for (size_t member = 0; member < 4; ++member) {
+        EXPECT_GT(counts[member], KEYS / 8) << "member " << member;
+        EXPECT_LT(counts[member], KEYS / 2) << "member " << member;
+    }
+    // The mapping is stable.
+    EXPECT_TRUE(members == selectAll());
+}
+
+// Checks that only the keys of a member which is down move.
+TEST_F(HashRingTest, down) {
+    setMembers(4);
+    const std::vector<size_t> members = selectAll();
+
+    ring_.setUp(2, false);
+    EXPECT_FALSE(ring_.isUp(2));
+    const std::vector<size_t> moved = selectAll();
+    for (uint32_t i = 0; i < KEYS; ++i) {
+        if (members[i] == 2) {
+            EXPECT_NE(2, moved[i]);
+        } else {
+            EXPECT_EQ(members[i], moved[i]);
+        }
+    }
+
+    // The keys come back when the member is up again.
+    ring_.setUp(2, true);
+    EXPECT_TRUE(members == selectAll());
+
+    // No member is up.
+    for (size_t member = 0; member < 4; ++member) {
+        ring_.setUp(member, false);
+    }
+    EXPECT_EQ(HashRing::NO_MEMBER, select(1));
+    EXPECT_THROW(ring_.setUp(4, false), OutOfRange);
+    EXPECT_THROW(ring_.isUp(4), OutOfRange);
+}
+
+// Checks that only the keys taken by an added member move, and that
+// the members keep their state.
+TEST_F(HashRingTest, addMember) {
+    setMembers(3);
+    ring_.setUp(1, false);
+    const std::vector<size_t> members = selectAll();
+
+    setMembers(4);
+    EXPECT_FALSE(ring_.isUp(1));
+    EXPECT_TRUE(ring_.isUp(3));
+    const std::vector<size_t> moved = selectAll();
+    size_t moved_count = 0;
+    for (uint32_t i = 0; i < KEYS; ++i) {
+        if (moved[i] != members[i]) {
+            EXPECT_EQ(3, moved[i]);
+            ++moved_count;
+        }
+    }
+    EXPECT_GT(moved_count, 0);
+
+    std::vector<std::string> names;
+    names.push_back("a");
+    names.push_back("a");
+    EXPECT_THROW(ring_.setMembers(names), BadValue);
+    EXPECT_EQ(4, ring_.getMembers().size());
+}
+
+}
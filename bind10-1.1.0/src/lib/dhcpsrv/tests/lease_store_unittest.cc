@@ -0,0 +1,460 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/lease_store.h>
+#include <util/memory_segment_local.h>
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <vector>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace isc::util;
+
+namespace {
+
+/// @brief Local segment pretending to grow on every other allocation.
+///
+/// The stores must be left unchanged by the failed allocations, so the
+/// changes complete when they are tried again.
+class GrowingSegment : public MemorySegmentLocal {
+public:
+    GrowingSegment() : allocations_(0) {
+    }
+
+    virtual void* allocate(size_t size) {
+        if (++allocations_ % 2 == 1) {
+            isc_throw(MemorySegmentGrown, "test segment has grown");
+        }
+        return (MemorySegmentLocal::allocate(size));
+    }
+
+private:
+    size_t allocations_;
+};
+
+/// @brief Test fixture holding the stores in a local segment.
+class LeaseStoreTest : public ::testing::Test {
+public:
+    LeaseStoreTest()
+        : store4_(Lease4Store::create(segment_)),
+          store6_(Lease6Store::create(segment_)) {
+    }
+
+    /// @brief Checks that the stores release all their memory.
+    virtual void TearDown() {
+        Lease4Store::destroy(segment_, store4_);
+        Lease6Store::destroy(segment_, store6_);
+        EXPECT_TRUE(segment_.allMemoryDeallocated());
+    }
+
+    MemorySegmentLocal segment_;
+    Lease4Store* store4_;
+    Lease6Store* store6_;
+};
+
+/// @brief Returns the handles of the records with a hash.
+std::set<uint32_t>
+lookup(const LeaseHandleIndex& index, uint64_t hash) {
+    std::set<uint32_t> handles;
+    size_t pos = index.start(hash);
+    for (uint32_t handle = index.next(hash, pos);
+         handle != LeaseHandleIndex::NO_HANDLE;
+         handle = index.next(hash, pos)) {
+        handles.insert(handle);
+    }
+    return (handles);
+}
+
+/// @brief Returns an IPv4 lease.
+Lease4Ptr
+createLease4(const std::string& addr, uint8_t hwaddr_byte, size_t hwaddr_len,
+             uint8_t client_id_byte, size_t client_id_len,
+             SubnetID subnet_id) {
+    const std::vector<uint8_t> hwaddr(hwaddr_len, hwaddr_byte);
+    const std::vector<uint8_t> client_id(client_id_len, client_id_byte);
+    Lease4Ptr lease(new Lease4(IOAddress(addr),
+                               hwaddr.empty() ? NULL : &hwaddr[0],
+                               hwaddr.size(),
+                               client_id.empty() ? NULL : &client_id[0],
+                               client_id.size(), 3600, 1800, 2700, 1234567,
+                               subnet_id));
+    return (lease);
+}
+
+/// @brief Returns an IPv6 lease.
+Lease6Ptr
+createLease6(const std::string& addr, uint8_t duid_byte, size_t duid_len,
+             uint32_t iaid, SubnetID subnet_id) {
+    DuidPtr duid(new DUID(std::vector<uint8_t>(duid_len, duid_byte)));
+    Lease6Ptr lease(new Lease6(Lease6::LEASE_IA_PD, IOAddress(addr), duid,
+                               iaid, 100, 200, 50, 80, subnet_id, 56));
+    lease->cltt_ = 1234567;
+    return (lease);
+}
+
+// Checks that the index finds the handles of a hash, including when
+// the hashes collide, and that removed handles aren't found.
+TEST(LeaseHandleIndexTest, insertErase) {
+    MemorySegmentLocal segment;
+    LeaseHandleIndex index;
+    EXPECT_TRUE(lookup(index, 1).empty());
+    index.erase(1, 0);
+
+    // 1000 handles with 10 different hashes; the lower bits are the same
+    // so the slots of the hashes are mixed.
+    for (uint32_t handle = 0; handle < 1000; ++handle) {
+        index.reserve(segment);
+        index.insert((static_cast<uint64_t>(handle % 10) << 40) |
+                     (handle % 10) << 20, handle);
+    }
+    EXPECT_EQ(1000, index.size());
+    for (uint32_t hash = 0; hash < 10; ++hash) {
+        const std::set<uint32_t> handles =
+            lookup(index, (static_cast<uint64_t>(hash) << 40) | hash << 20);
+        ASSERT_EQ(100, handles.size());
+        EXPECT_EQ(hash, *handles.begin());
+        EXPECT_EQ(hash + 990, *handles.rbegin());
+    }
+    EXPECT_TRUE(lookup(index, 10 << 20).empty());
+
+    // Remove the even handles, a few times over the removed slots.
+    for (int round = 0; round < 3; ++round) {
+        for (uint32_t handle = 0; handle < 1000; handle += 2) {
+            index.erase((static_cast<uint64_t>(handle % 10) << 40) |
+                        (handle % 10) << 20, handle);
+        }
+        EXPECT_EQ(500, index.size());
+        for (uint32_t handle = 0; handle < 1000; handle += 2) {
+            index.reserve(segment);
+            index.insert((static_cast<uint64_t>(handle % 10) << 40) |
+                         (handle % 10) << 20, handle + 1000);
+            index.erase((static_cast<uint64_t>(handle % 10) << 40) |
+                        (handle % 10) << 20, handle + 1000);
+        }
+    }
+    EXPECT_TRUE(lookup(index, 2 << 20).empty());
+    EXPECT_EQ(100, lookup(index, (1ULL << 40) | 1 << 20).size());
+
+    // The handles are removed, the slots are kept.
+    index.clear();
+    EXPECT_EQ(0, index.size());
+    EXPECT_TRUE(lookup(index, (1ULL << 40) | 1 << 20).empty());
+    index.insert(5, 5);
+    EXPECT_EQ(1, lookup(index, 5).size());
+
+    index.destroy(segment);
+    EXPECT_TRUE(segment.allMemoryDeallocated());
+}
+
+// Checks that the records are reused and keep their handle.
+TEST(RecordSlabsTest, allocateRelease) {
+    MemorySegmentLocal segment;
+    RecordSlabs<uint64_t> slabs;
+    std::vector<uint32_t> handles;
+    for (uint32_t i = 0; i < 3 * RecordSlabs<uint64_t>::SLAB_SIZE; ++i) {
+        slabs.reserve(segment);
+        handles.push_back(slabs.allocate());
+        EXPECT_EQ(0, slabs[handles.back()]);
+        slabs[handles.back()] = i;
+    }
+    EXPECT_EQ(3 * RecordSlabs<uint64_t>::SLAB_SIZE, slabs.size());
+    for (uint32_t i = 0; i < handles.size(); ++i) {
+        ASSERT_EQ(i, slabs[handles[i]]);
+    }
+    slabs.release(handles[5]);
+    slabs.reserve(segment);
+    EXPECT_EQ(handles[5], slabs.allocate());
+    EXPECT_EQ(0, slabs[handles[5]]);
+
+    // The released records are given again after clearFree().
+    slabs.release(handles[7]);
+    slabs.clearFree();
+    EXPECT_EQ(3 * RecordSlabs<uint64_t>::SLAB_SIZE, slabs.size());
+    slabs.addFree(handles[7]);
+    EXPECT_EQ(3 * RecordSlabs<uint64_t>::SLAB_SIZE - 1, slabs.size());
+    EXPECT_EQ(handles[7], slabs.allocate());
+
+    slabs.destroy(segment);
+    EXPECT_TRUE(segment.allMemoryDeallocated());
+}
+
+// Checks that the IPv4 leases are stored and found by each key.
+TEST_F(LeaseStoreTest, addGet4) {
+    Lease4Store& store = *store4_;
+    Lease4Ptr lease = createLease4("192.0.2.1", 0x11, 6, 0x21, 7, 1);
+    lease->hostname_ = "host.example.org";
+    lease->fqdn_rev_ = true;
+    lease->ext_ = 5;
+    ASSERT_TRUE(store.add(segment_, *lease));
+    EXPECT_FALSE(store.add(segment_,
+                           *createLease4("192.0.2.1", 0x12, 6, 0x22, 7, 1)));
+    EXPECT_EQ(1, store.size());
+
+    // Identifiers too long for the record.
+    Lease4Ptr long_ids = createLease4("192.0.2.2", 0x13, 40, 0x23, 100, 1);
+    ASSERT_TRUE(store.add(segment_, *long_ids));
+    // A lease without client identifier, with the same hardware address
+    // in another subnet.
+    Lease4Ptr no_id = createLease4("192.0.2.3", 0x11, 6, 0, 0, 2);
+    ASSERT_TRUE(store.add(segment_, *no_id));
+
+    Lease4Ptr found = store.getByAddress(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(found);
+    EXPECT_TRUE(*lease == *found);
+    // The lease is a copy.
+    EXPECT_NE(lease.get(), found.get());
+    found = store.getByAddress(IOAddress("192.0.2.2"));
+    ASSERT_TRUE(found);
+    EXPECT_TRUE(*long_ids == *found);
+    found = store.getByAddress(IOAddress("192.0.2.3"));
+    ASSERT_TRUE(found);
+    EXPECT_TRUE(*no_id == *found);
+    EXPECT_FALSE(found->client_id_);
+    EXPECT_FALSE(store.getByAddress(IOAddress("192.0.2.4")));
+
+    found = store.getByHWAddr(lease->hwaddr_, 1);
+    ASSERT_TRUE(found);
+    EXPECT_EQ("192.0.2.1", found->addr_.toText());
+    found = store.getByHWAddr(lease->hwaddr_, 2);
+    ASSERT_TRUE(found);
+    EXPECT_EQ("192.0.2.3", found->addr_.toText());
+    found = store.getByHWAddr(long_ids->hwaddr_, 1);
+    ASSERT_TRUE(found);
+    EXPECT_EQ("192.0.2.2", found->addr_.toText());
+    EXPECT_FALSE(store.getByHWAddr(long_ids->hwaddr_, 2));
+    EXPECT_FALSE(store.getByHWAddr(std::vector<uint8_t>(5, 0x11), 1));
+
+    found = store.getByClientId(lease->client_id_->getClientId(), 1);
+    ASSERT_TRUE(found);
+    EXPECT_EQ("192.0.2.1", found->addr_.toText());
+    found = store.getByClientId(long_ids->client_id_->getClientId(), 1);
+    ASSERT_TRUE(found);
+    EXPECT_EQ("192.0.2.2", found->addr_.toText());
+    EXPECT_FALSE(store.getByClientId(lease->client_id_->getClientId(), 2));
+}
+
+// Checks that the IPv4 leases are updated and removed with their keys.
+TEST_F(LeaseStoreTest, updateErase4) {
+    Lease4Store& store = *store4_;
+    Lease4Ptr lease = createLease4("192.0.2.1", 0x11, 6, 0x21, 7, 1);
+    EXPECT_FALSE(store.update(segment_, *lease));
+    ASSERT_TRUE(store.add(segment_, *lease));
+
+    // Everything but the address changes.
+    Lease4Ptr updated = createLease4("192.0.2.1", 0x12, 30, 0x22, 20, 2);
+    updated->comments_ = "moved";
+    updated->fixed_ = true;
+    updated->cltt_ = 7654321;
+    ASSERT_TRUE(store.update(segment_, *updated));
+    Lease4Ptr found = store.getByAddress(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(found);
+    EXPECT_TRUE(*updated == *found);
+    EXPECT_FALSE(store.getByHWAddr(lease->hwaddr_, 1));
+    EXPECT_FALSE(store.getByClientId(lease->client_id_->getClientId(), 1));
+    EXPECT_TRUE(store.getByHWAddr(updated->hwaddr_, 2));
+    EXPECT_TRUE(store.getByClientId(updated->client_id_->getClientId(), 2));
+
+    EXPECT_FALSE(store.erase(segment_, IOAddress("192.0.2.2")));
+    EXPECT_TRUE(store.erase(segment_, IOAddress("192.0.2.1")));
+    EXPECT_FALSE(store.erase(segment_, IOAddress("192.0.2.1")));
+    EXPECT_EQ(0, store.size());
+    EXPECT_FALSE(store.getByAddress(IOAddress("192.0.2.1")));
+    EXPECT_FALSE(store.getByHWAddr(updated->hwaddr_, 2));
+    EXPECT_FALSE(store.getByClientId(updated->client_id_->getClientId(), 2));
+
+    // The record is reused without the extras of the previous lease.
+    ASSERT_TRUE(store.add(segment_, *lease));
+    found = store.getByAddress(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(found);
+    EXPECT_TRUE(*lease == *found);
+}
+
+// Checks that many IPv4 leases are found after some are removed.
+TEST_F(LeaseStoreTest, many4) {
+    Lease4Store& store = *store4_;
+    const uint32_t base = static_cast<uint32_t>(IOAddress("10.0.0.0"));
+    for (uint32_t i = 0; i < 20000; ++i) {
+        Lease4Ptr lease = createLease4("10.0.0.0", 0, 6, 0, 7, 1);
+        lease->addr_ = IOAddress(base + i);
+        lease->hwaddr_[4] = i >> 8;
+        lease->hwaddr_[5] = i & 0xff;
+        ASSERT_TRUE(store.add(segment_, *lease));
+    }
+    for (uint32_t i = 0; i < 20000; i += 3) {
+        ASSERT_TRUE(store.erase(segment_, base + i));
+    }
+    for (uint32_t i = 0; i < 20000; ++i) {
+        Lease4Ptr found = store.getByAddress(base + i);
+        std::vector<uint8_t> hwaddr(6, 0);
+        hwaddr[4] = i >> 8;
+        hwaddr[5] = i & 0xff;
+        if (i % 3 == 0) {
+            ASSERT_FALSE(found);
+            ASSERT_FALSE(store.getByHWAddr(hwaddr, 1));
+        } else {
+            ASSERT_TRUE(found);
+            ASSERT_TRUE(found->hwaddr_ == hwaddr);
+            found = store.getByHWAddr(hwaddr, 1);
+            ASSERT_TRUE(found);
+            ASSERT_EQ(base + i, static_cast<uint32_t>(found->addr_));
+        }
+    }
+}
+
+// Checks that the IPv6 leases are stored, found, updated and removed.
+TEST_F(LeaseStoreTest, addGetUpdateErase6) {
+    Lease6Store& store = *store6_;
+    Lease6Ptr lease = createLease6("2001:db8:1::", 0x31, 14, 7, 1);
+    lease->hostname_ = "host.example.org";
+    lease->fqdn_fwd_ = true;
+    ASSERT_TRUE(store.add(segment_, *lease));
+    EXPECT_FALSE(store.add(segment_,
+                           *createLease6("2001:db8:1::", 0x32, 14, 8, 1)));
+    // A DUID too long for the record.
+    Lease6Ptr long_duid = createLease6("2001:db8:2::", 0x33, 100, 7, 1);
+    ASSERT_TRUE(store.add(segment_, *long_duid));
+    EXPECT_EQ(2, store.size());
+
+    Lease6Ptr found = store.getByAddress(IOAddress("2001:db8:1::"));
+    ASSERT_TRUE(found);
+    EXPECT_TRUE(*lease == *found);
+    EXPECT_EQ(Lease6::LEASE_IA_PD, found->type_);
+    EXPECT_EQ(56, found->prefixlen_);
+    found = store.getByAddress(IOAddress("2001:db8:2::"));
+    ASSERT_TRUE(found);
+    EXPECT_TRUE(*long_duid == *found);
+    EXPECT_FALSE(store.getByAddress(IOAddress("2001:db8:3::")));
+    EXPECT_FALSE(store.getByAddress(IOAddress("192.0.2.1")));
+
+    found = store.getByDuid(lease->duid_->getDuid(), 7, 1);
+    ASSERT_TRUE(found);
+    EXPECT_EQ("2001:db8:1::", found->addr_.toText());
+    found = store.getByDuid(long_duid->duid_->getDuid(), 7, 1);
+    ASSERT_TRUE(found);
+    EXPECT_EQ("2001:db8:2::", found->addr_.toText());
+    EXPECT_FALSE(store.getByDuid(lease->duid_->getDuid(), 8, 1));
+    EXPECT_FALSE(store.getByDuid(lease->duid_->getDuid(), 7, 2));
+
+    Lease6Ptr updated = createLease6("2001:db8:1::", 0x31, 14, 9, 1);
+    updated->preferred_lft_ = 1000;
+    ASSERT_TRUE(store.update(segment_, *updated));
+    EXPECT_FALSE(store.update(segment_,
+                              *createLease6("2001:db8:3::", 0x31, 14, 9, 1)));
+    found = store.getByAddress(IOAddress("2001:db8:1::"));
+    ASSERT_TRUE(found);
+    EXPECT_TRUE(*updated == *found);
+    EXPECT_FALSE(store.getByDuid(lease->duid_->getDuid(), 7, 1));
+    EXPECT_TRUE(store.getByDuid(lease->duid_->getDuid(), 9, 1));
+
+    EXPECT_TRUE(store.erase(segment_, IOAddress("2001:db8:2::")));
+    EXPECT_FALSE(store.erase(segment_, IOAddress("2001:db8:2::")));
+    EXPECT_FALSE(store.getByDuid(long_duid->duid_->getDuid(), 7, 1));
+    EXPECT_EQ(1, store.size());
+}
+
+// Checks that the indexes and the released records are rebuilt from the
+// records.
+TEST_F(LeaseStoreTest, recover) {
+    Lease4Store& store = *store4_;
+    EXPECT_TRUE(store.isValid());
+    EXPECT_FALSE(store.isInterrupted());
+    const uint32_t base = static_cast<uint32_t>(IOAddress("10.0.0.0"));
+    for (uint32_t i = 0; i < 100; ++i) {
+        Lease4Ptr lease = createLease4("10.0.0.0", i, 6, i, (i % 3) * 10, 1);
+        lease->addr_ = IOAddress(base + i);
+        ASSERT_TRUE(store.add(segment_, *lease));
+    }
+    for (uint32_t i = 0; i < 100; i += 2) {
+        ASSERT_TRUE(store.erase(segment_, base + i));
+    }
+
+    store.recover(segment_);
+    EXPECT_FALSE(store.isInterrupted());
+    EXPECT_EQ(50, store.size());
+    for (uint32_t i = 0; i < 100; ++i) {
+        const std::vector<uint8_t> id((i % 3) * 10, i);
+        if (i % 2 == 0) {
+            ASSERT_FALSE(store.getByAddress(base + i));
+            ASSERT_FALSE(store.getByHWAddr(std::vector<uint8_t>(6, i), 1));
+        } else {
+            ASSERT_TRUE(store.getByAddress(base + i));
+            ASSERT_TRUE(store.getByHWAddr(std::vector<uint8_t>(6, i), 1));
+            const Lease4Ptr found = store.getByClientId(id, 1);
+            ASSERT_EQ(!id.empty(), static_cast<bool>(found));
+        }
+    }
+    // The released records are used again.
+    ASSERT_TRUE(store.add(segment_, *createLease4("10.0.1.0", 0, 6, 0, 7, 1)));
+    EXPECT_EQ(51, store.size());
+
+    Lease6Ptr lease6 = createLease6("2001:db8:1::", 0x31, 100, 7, 1);
+    ASSERT_TRUE(store6_->add(segment_, *lease6));
+    store6_->recover(segment_);
+    Lease6Ptr found = store6_->getByDuid(lease6->duid_->getDuid(), 7, 1);
+    ASSERT_TRUE(found);
+    EXPECT_TRUE(*lease6 == *found);
+}
+
+/// @brief Calls a method of a store until the segment doesn't grow.
+template <typename Store, typename Lease>
+bool
+retry(bool (Store::*method)(MemorySegment&, const Lease&),
+      Store* store, MemorySegment& segment, const Lease& lease) {
+    for (;;) {
+        try {
+            return ((store->*method)(segment, lease));
+        } catch (const MemorySegmentGrown&) {
+        }
+    }
+}
+
+// Checks that the changes interrupted by a growing segment complete when
+// they are tried again.
+TEST(LeaseStoreGrownTest, retry) {
+    GrowingSegment segment;
+    Lease4Store* store = NULL;
+    while (!store) {
+        try {
+            store = Lease4Store::create(segment);
+        } catch (const MemorySegmentGrown&) {
+        }
+    }
+    const uint32_t base = static_cast<uint32_t>(IOAddress("10.0.0.0"));
+    for (uint32_t i = 0; i < 5000; ++i) {
+        Lease4Ptr lease = createLease4("10.0.0.0", i, 30, i, 20, 1);
+        lease->addr_ = IOAddress(base + i);
+        ASSERT_TRUE(retry(&Lease4Store::add, store, segment, *lease));
+        lease->hostname_ = "host.example.org";
+        ASSERT_TRUE(retry(&Lease4Store::update, store, segment, *lease));
+    }
+    EXPECT_EQ(5000, store->size());
+    for (uint32_t i = 0; i < 5000; ++i) {
+        Lease4Ptr found = store->getByAddress(base + i);
+        ASSERT_TRUE(found);
+        ASSERT_EQ("host.example.org", found->hostname_);
+        found = store->getByHWAddr(std::vector<uint8_t>(30, i), 1);
+        ASSERT_TRUE(found);
+    }
+    Lease4Store::destroy(segment, store);
+    EXPECT_TRUE(segment.allMemoryDeallocated());
+}
+
+}
@@ -0,0 +1,226 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/iface_mgr.h>
+#include <dhcpsrv/cfgmgr.h>
+#include <dhcpsrv/lease_sync.h>
+#include <dhcpsrv/memfile_lease_mgr.h>
+#include <exceptions/exceptions.h>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include <time.h>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+
+namespace {
+
+/// Ports of the test servers.
+const uint16_t PORT_A = 54701;
+const uint16_t PORT_B = 54702;
+
+class LeaseSyncTest : public ::testing::Test {
+public:
+    LeaseSyncTest()
+        : lease_mgr_a_(new Memfile_LeaseMgr(LeaseMgr::ParameterMap())),
+          lease_mgr_b_(new Memfile_LeaseMgr(LeaseMgr::ParameterMap())),
+          subnet_(new Subnet4(IOAddress("192.0.2.0"), 24, 1800, 2700, 3600)) {
+        // Both servers of the test share the configuration.
+        CfgMgr::instance().deleteSubnets4();
+        CfgMgr::instance().addSubnet4(subnet_);
+    }
+
+    ~LeaseSyncTest() {
+        // The synchronization must stop before the lease databases go.
+        sync_a_.reset();
+        sync_b_.reset();
+        CfgMgr::instance().deleteSubnets4();
+    }
+
+    /// @brief Starts the synchronization of server A.
+    void startA() {
+        sync_a_.reset(new LeaseSync(*lease_mgr_a_, IOAddress("127.0.0.1"),
+                                    PORT_A, IOAddress("127.0.0.1"), PORT_B));
+    }
+
+    /// @brief Starts the synchronization of server B.
+    void startB() {
+        sync_b_.reset(new LeaseSync(*lease_mgr_b_, IOAddress("127.0.0.1"),
+                                    PORT_B, IOAddress("127.0.0.1"), PORT_A));
+    }
+
+    /// @brief Runs the packet loop of both servers until a condition is
+    /// true, or for at most 5 seconds.
+    ///
+    /// @param condition condition to wait for.
+    /// @return the condition.
+    static bool runUntil(const boost::function<bool ()>& condition) {
+        const time_t end = time(NULL) + 5;
+        while (!condition() && (time(NULL) < end)) {
+            IfaceMgr::instance().receive4(0, 10000);
+        }
+        return (condition());
+    }
+
+    /// @brief Checks if both servers see their peer up.
+    bool pairUp() const {
+        return (sync_a_->isPeerUp() && sync_b_->isPeerUp());
+    }
+
+    /// @brief Checks if server A lost both connections with server B.
+    bool peerGone() const {
+        return (!sync_a_->isPeerUp() && !sync_a_->isConnected());
+    }
+
+    /// @brief Checks if server B applied a number of changes.
+    bool appliedByB(uint64_t count) const {
+        return (sync_b_->getApplied() >= count);
+    }
+
+    /// @brief Returns a lease.
+    ///
+    /// @param addr leased address.
+    /// @param client number of the client.
+    /// @param cltt time of the last transmission of the client.
+    Lease4Ptr createLease(const std::string& addr, uint8_t client,
+                          time_t cltt) const {
+        const uint8_t hwaddr[] = { 0x00, 0x0c, 0x01, 0x02, 0x03, client };
+        const uint8_t client_id[] = { 0x01, 0x00, 0x0c, 0x01, client };
+        Lease4Ptr lease(new Lease4(IOAddress(addr), hwaddr, sizeof(hwaddr),
+                                   client_id, sizeof(client_id), 3600, 1800,
+                                   2700, cltt, subnet_->getID()));
+        lease->hostname_ = "client.example.org";
+        lease->fqdn_fwd_ = true;
+        return (lease);
+    }
+
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr_a_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr_b_;
+    boost::scoped_ptr<LeaseSync> sync_a_;
+    boost::scoped_ptr<LeaseSync> sync_b_;
+    Subnet4Ptr subnet_;
+};
+
+// Checks that invalid addresses are rejected.
+TEST_F(LeaseSyncTest, invalidAddress) {
+    EXPECT_THROW(LeaseSync(*lease_mgr_a_, IOAddress("::1"), PORT_A,
+                           IOAddress("127.0.0.1"), PORT_B), BadValue);
+    EXPECT_THROW(LeaseSync(*lease_mgr_a_, IOAddress("127.0.0.1"), PORT_A,
+                           IOAddress("::1"), PORT_B), BadValue);
+    startA();
+    // The port is taken.
+    EXPECT_THROW(LeaseSync(*lease_mgr_b_, IOAddress("127.0.0.1"), PORT_A,
+                           IOAddress("127.0.0.1"), PORT_B), LeaseSyncError);
+}
+
+// Checks that the lease changes of a server are applied by its peer.
+TEST_F(LeaseSyncTest, changes) {
+    startA();
+    startB();
+    ASSERT_TRUE(runUntil(boost::bind(&LeaseSyncTest::pairUp, this)));
+
+    // More changes than a batch.
+    const size_t COUNT = LeaseSync::BATCH_SIZE * 2 + 10;
+    for (size_t i = 0; i < COUNT; ++i) {
+        std::ostringstream addr;
+        addr << "192.0.2." << i + 1;
+        sync_a_->leaseUpdated(*createLease(addr.str(), i, 1000));
+    }
+    ASSERT_TRUE(runUntil(boost::bind(&LeaseSyncTest::appliedByB, this,
+                                     COUNT)));
+    EXPECT_EQ(0, sync_a_->getBacklog());
+    Lease4Ptr lease = lease_mgr_b_->getLease4(IOAddress("192.0.2.3"));
+    ASSERT_TRUE(lease);
+    EXPECT_TRUE(*createLease("192.0.2.3", 2, 1000) == *lease);
+
+    // An update replaces the lease, unless it is older.
+    Lease4Ptr update = createLease("192.0.2.3", 200, 2000);
+    sync_a_->leaseUpdated(*update);
+    sync_a_->leaseUpdated(*createLease("192.0.2.3", 201, 1500));
+    sync_a_->leaseDeleted(IOAddress("192.0.2.4"));
+    ASSERT_TRUE(runUntil(boost::bind(&LeaseSyncTest::appliedByB, this,
+                                     COUNT + 3)));
+    lease = lease_mgr_b_->getLease4(IOAddress("192.0.2.3"));
+    ASSERT_TRUE(lease);
+    EXPECT_TRUE(*update == *lease);
+    EXPECT_FALSE(lease_mgr_b_->getLease4(IOAddress("192.0.2.4")));
+    EXPECT_TRUE(lease_mgr_b_->getLease4(IOAddress("192.0.2.5")));
+}
+
+// Checks that a server sees its peer go down, and that the changes made
+// while the peer is down are sent when it is back.
+TEST_F(LeaseSyncTest, peerDown) {
+    startA();
+    startB();
+    ASSERT_TRUE(runUntil(boost::bind(&LeaseSyncTest::pairUp, this)));
+
+    sync_b_.reset();
+    ASSERT_TRUE(runUntil(boost::bind(&LeaseSyncTest::peerGone, this)));
+    sync_a_->leaseUpdated(*createLease("192.0.2.1", 1, 1000));
+    sync_a_->leaseUpdated(*createLease("192.0.2.2", 2, 1000));
+    EXPECT_EQ(2, sync_a_->getBacklog());
+
+    startB();
+    ASSERT_TRUE(runUntil(boost::bind(&LeaseSyncTest::appliedByB, this, 2)));
+    EXPECT_TRUE(lease_mgr_b_->getLease4(IOAddress("192.0.2.1")));
+    EXPECT_TRUE(lease_mgr_b_->getLease4(IOAddress("192.0.2.2")));
+    EXPECT_TRUE(runUntil(boost::bind(&LeaseSyncTest::pairUp, this)));
+}
+
+// Checks that the subnet of a lease is mapped by its prefix, and that the
+// leases of unknown subnets are neither sent nor applied.
+TEST_F(LeaseSyncTest, subnets) {
+    startA();
+    startB();
+    ASSERT_TRUE(runUntil(boost::bind(&LeaseSyncTest::pairUp, this)));
+
+    // The subnet of the lease is not configured.
+    Lease4Ptr lease = createLease("192.0.2.1", 1, 1000);
+    lease->subnet_id_ = subnet_->getID() + 1;
+    sync_a_->leaseUpdated(*lease);
+    EXPECT_EQ(0, sync_a_->getBacklog());
+
+    // The subnet is removed before the peer gets the lease: the lease is
+    // rejected, and the next change is applied.
+    sync_a_->leaseUpdated(*createLease("192.0.2.2", 2, 1000));
+    CfgMgr::instance().deleteSubnets4();
+    sync_a_->leaseDeleted(IOAddress("192.0.2.3"));
+    ASSERT_TRUE(runUntil(boost::bind(&LeaseSyncTest::appliedByB, this, 1)));
+    EXPECT_FALSE(lease_mgr_b_->getLease4(IOAddress("192.0.2.2")));
+
+    // The lease gets the identifier of the subnet with the same prefix.
+    Subnet4Ptr subnet(new Subnet4(IOAddress("192.0.2.0"), 24, 1800, 2700,
+                                  3600));
+    ASSERT_NE(subnet_->getID(), subnet->getID());
+    CfgMgr::instance().addSubnet4(subnet_);
+    sync_a_->leaseUpdated(*createLease("192.0.2.4", 4, 1000));
+    CfgMgr::instance().deleteSubnets4();
+    CfgMgr::instance().addSubnet4(subnet);
+    ASSERT_TRUE(runUntil(boost::bind(&LeaseSyncTest::appliedByB, this, 2)));
+    lease = lease_mgr_b_->getLease4(IOAddress("192.0.2.4"));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(subnet->getID(), lease->subnet_id_);
+}
+
+}
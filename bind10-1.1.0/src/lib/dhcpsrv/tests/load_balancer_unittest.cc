@@ -0,0 +1,125 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/dhcp4.h>
+#include <dhcp/option.h>
+#include <dhcpsrv/load_balancer.h>
+#include <exceptions/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+
+namespace {
+
+/// @brief Returns a query of a client.
+///
+/// @param type message type.
+/// @param client number of the client.
+/// @param with_client_id true if the client sends a client identifier.
+Pkt4Ptr
+createQuery(uint8_t type, uint32_t client, bool with_client_id = false) {
+    Pkt4Ptr query(new Pkt4(type, 1234));
+    std::vector<uint8_t> mac(6);
+    mac[0] = 0x00;
+    mac[1] = 0x0c;
+    mac[2] = 0x01;
+    mac[3] = client >> 16;
+    mac[4] = (client >> 8) & 0xff;
+    mac[5] = client & 0xff;
+    query->setHWAddr(HTYPE_ETHER, mac.size(), mac);
+    if (with_client_id) {
+        std::vector<uint8_t> client_id(mac);
+        client_id.insert(client_id.begin(), 0xff);
+        query->addOption(OptionPtr(new Option(Option::V4,
+                                              DHO_DHCP_CLIENT_IDENTIFIER,
+                                              client_id)));
+    }
+    return (query);
+}
+
+// Checks the names of the roles.
+TEST(LoadBalancerTest, roleFromText) {
+    EXPECT_EQ(LoadBalancer::PRIMARY, LoadBalancer::roleFromText("primary"));
+    EXPECT_EQ(LoadBalancer::SECONDARY,
+              LoadBalancer::roleFromText("secondary"));
+    EXPECT_THROW(LoadBalancer::roleFromText("backup"), BadValue);
+    EXPECT_THROW(LoadBalancer::roleFromText(""), BadValue);
+}
+
+// Checks that the servers of a pair answer disjoint halves of the
+// clients, and that the buckets are spread evenly enough.
+TEST(LoadBalancerTest, split) {
+    LoadBalancer primary(LoadBalancer::PRIMARY);
+    LoadBalancer secondary(LoadBalancer::SECONDARY);
+    size_t primary_count = 0;
+    const uint32_t CLIENTS = 10000;
+    for (uint32_t client = 0; client < CLIENTS; ++client) {
+        Pkt4Ptr query = createQuery(DHCPDISCOVER, client);
+        const bool in_primary = primary.inScope(*query, true);
+        ASSERT_NE(in_primary, secondary.inScope(*query, true));
+        if (in_primary) {
+            ++primary_count;
+        }
+        // The peer is down: the server answers all clients.
+        EXPECT_TRUE(primary.inScope(*query, false));
+        EXPECT_TRUE(secondary.inScope(*query, false));
+    }
+    EXPECT_GT(primary_count, CLIENTS * 2 / 5);
+    EXPECT_LT(primary_count, CLIENTS * 3 / 5);
+}
+
+// Checks that the client identifier takes precedence over the hardware
+// address, and that the bucket doesn't depend on the platform.
+TEST(LoadBalancerTest, bucket) {
+    Pkt4Ptr query = createQuery(DHCPDISCOVER, 1);
+    Pkt4Ptr query_client_id = createQuery(DHCPDISCOVER, 1, true);
+    EXPECT_EQ(0x37, LoadBalancer::getBucket(*query));
+    EXPECT_EQ(0xff, LoadBalancer::getBucket(*query_client_id));
+
+    LoadBalancer primary(LoadBalancer::PRIMARY);
+    EXPECT_TRUE(primary.isOwnBucket(0));
+    EXPECT_TRUE(primary.isOwnBucket(127));
+    EXPECT_FALSE(primary.isOwnBucket(128));
+    EXPECT_FALSE(primary.isOwnBucket(255));
+}
+
+// Checks that only the queries of clients looking for a lease are
+// balanced.
+TEST(LoadBalancerTest, messageTypes) {
+    LoadBalancer primary(LoadBalancer::PRIMARY);
+    LoadBalancer secondary(LoadBalancer::SECONDARY);
+    for (uint32_t client = 0; client < 100; ++client) {
+        Pkt4Ptr request = createQuery(DHCPREQUEST, client);
+        EXPECT_NE(primary.inScope(*request, true),
+                  secondary.inScope(*request, true));
+        // A renewing client talks to the server which gave the lease.
+        request->setCiaddr(IOAddress("192.0.2.10"));
+        EXPECT_TRUE(primary.inScope(*request, true));
+        EXPECT_TRUE(secondary.inScope(*request, true));
+
+        Pkt4Ptr release = createQuery(DHCPRELEASE, client);
+        EXPECT_TRUE(primary.inScope(*release, true));
+        EXPECT_TRUE(secondary.inScope(*release, true));
+    }
+}
+
+}
@@ -18,12 +18,17 @@
 #include <dhcp/duid.h>
 #include <dhcpsrv/lease_mgr.h>
 #include <dhcpsrv/memfile_lease_mgr.h>
+#ifdef USE_SHARED_MEMORY
+#include <util/memory_segment_mapped.h>
+#endif
 
 #include <gtest/gtest.h>
 
 #include <iostream>
 #include <sstream>
 
+#include <unistd.h>
+
 using namespace std;
 using namespace isc;
 using namespace isc::asiolink;
@@ -130,6 +135,181 @@ TEST_F(MemfileLeaseMgrTest, addGetDelete6) {
     EXPECT_EQ(Lease6Ptr(), x);
 }
 
+// Checks that a Lease4 object returned by the manager is a copy, which
+// is stored by updateLease4().
+TEST_F(MemfileLeaseMgrTest, update4) {
+    const LeaseMgr::ParameterMap pmap;  // Empty parameter map
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+
+    const uint8_t hwaddr[] = { 0, 1, 2, 3, 4, 5 };
+    const uint8_t clientid[] = { 1, 0, 1, 2, 3, 4, 5 };
+    Lease4Ptr lease(new Lease4(IOAddress("192.0.2.1"), hwaddr, sizeof(hwaddr),
+                               clientid, sizeof(clientid), 100, 50, 80,
+                               time(NULL), 1));
+    EXPECT_THROW(lease_mgr->updateLease4(lease), NoSuchLease);
+    ASSERT_TRUE(lease_mgr->addLease(lease));
+
+    Lease4Ptr x = lease_mgr->getLease4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(x);
+    x->valid_lft_ = 200;
+    x->subnet_id_ = 2;
+    EXPECT_EQ(100, lease_mgr->getLease4(IOAddress("192.0.2.1"))->valid_lft_);
+
+    ASSERT_NO_THROW(lease_mgr->updateLease4(x));
+    Lease4Ptr y = lease_mgr->getLease4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(y);
+    EXPECT_TRUE(*x == *y);
+    EXPECT_FALSE(lease_mgr->getLease4(HWAddr(hwaddr, sizeof(hwaddr),
+                                             HTYPE_ETHER), 1));
+    EXPECT_TRUE(lease_mgr->getLease4(HWAddr(hwaddr, sizeof(hwaddr),
+                                            HTYPE_ETHER), 2));
+    EXPECT_TRUE(lease_mgr->getLease4(ClientId(clientid, sizeof(clientid)), 2));
+
+    EXPECT_TRUE(lease_mgr->deleteLease(IOAddress("192.0.2.1")));
+    EXPECT_THROW(lease_mgr->updateLease4(x), NoSuchLease);
+}
+
+// Checks that a Lease6 object returned by the manager is a copy, which
+// is stored by updateLease6().
+TEST_F(MemfileLeaseMgrTest, update6) {
+    const LeaseMgr::ParameterMap pmap;  // Empty parameter map
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+
+    uint8_t llt[] = {0, 1, 2, 3, 4, 5, 6, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf};
+    DuidPtr duid(new DUID(llt, sizeof(llt)));
+    Lease6Ptr lease(new Lease6(Lease6::LEASE_IA_NA,
+                               IOAddress("2001:db8:1::456"), duid, 7, 100,
+                               200, 50, 80, 8));
+    EXPECT_THROW(lease_mgr->updateLease6(lease), NoSuchLease);
+    ASSERT_TRUE(lease_mgr->addLease(lease));
+
+    Lease6Ptr x = lease_mgr->getLease6(IOAddress("2001:db8:1::456"));
+    ASSERT_TRUE(x);
+    x->iaid_ = 9;
+    x->cltt_ = 1234;
+    EXPECT_EQ(7, lease_mgr->getLease6(IOAddress("2001:db8:1::456"))->iaid_);
+
+    ASSERT_NO_THROW(lease_mgr->updateLease6(x));
+    Lease6Ptr y = lease_mgr->getLease6(IOAddress("2001:db8:1::456"));
+    ASSERT_TRUE(y);
+    EXPECT_TRUE(*x == *y);
+    EXPECT_FALSE(lease_mgr->getLease6(*duid, 7, 8));
+    EXPECT_TRUE(lease_mgr->getLease6(*duid, 9, 8));
+}
+
+#ifdef USE_SHARED_MEMORY
+
+/// Name of the lease file used in the tests.
+const char* const LEASE_FILE = "memfile-lease-test.mapped";
+
+class MemfileMappedTest : public ::testing::Test {
+public:
+    MemfileMappedTest() {
+        unlink(LEASE_FILE);
+    }
+
+    ~MemfileMappedTest() {
+        unlink(LEASE_FILE);
+    }
+
+    /// @brief Returns the parameters of a lease manager using the file.
+    static LeaseMgr::ParameterMap parameters(bool readonly) {
+        LeaseMgr::ParameterMap pmap;
+        pmap["type"] = "memfile";
+        pmap["name"] = LEASE_FILE;
+        if (readonly) {
+            pmap["readonly"] = "true";
+        }
+        return (pmap);
+    }
+
+    /// @brief Returns an IPv4 lease of the n-th address of 10.0.0.0/8.
+    static Lease4Ptr createLease4(uint32_t n) {
+        const uint8_t hwaddr[] = { 0, 1, 2, static_cast<uint8_t>(n >> 16),
+                                   static_cast<uint8_t>((n >> 8) & 0xff),
+                                   static_cast<uint8_t>(n & 0xff) };
+        return (Lease4Ptr(new Lease4(IOAddress(0x0a000000 + n), hwaddr,
+                                     sizeof(hwaddr), NULL, 0, 100, 50, 80,
+                                     1234567, 1)));
+    }
+};
+
+// Checks that the leases stay in the file for the next lease manager.
+TEST_F(MemfileMappedTest, reopen) {
+    const uint32_t count = 3000;
+    uint8_t llt[] = {0, 1, 2, 3, 4, 5, 6, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf};
+    DuidPtr duid(new DUID(llt, sizeof(llt)));
+    Lease6Ptr lease6(new Lease6(Lease6::LEASE_IA_NA,
+                                IOAddress("2001:db8:1::456"), duid, 7, 100,
+                                200, 50, 80, 8));
+    {
+        Memfile_LeaseMgr lease_mgr(parameters(false));
+        EXPECT_EQ(LEASE_FILE, lease_mgr.getName());
+        // Enough leases for the file to grow a few times.
+        for (uint32_t n = 0; n < count; ++n) {
+            ASSERT_TRUE(lease_mgr.addLease(createLease4(n)));
+        }
+        ASSERT_TRUE(lease_mgr.addLease(lease6));
+        EXPECT_TRUE(lease_mgr.deleteLease(IOAddress("10.0.0.5")));
+    }
+
+    Memfile_LeaseMgr lease_mgr(parameters(false));
+    for (uint32_t n = 0; n < count; ++n) {
+        Lease4Ptr lease = lease_mgr.getLease4(IOAddress(0x0a000000 + n));
+        if (n == 5) {
+            ASSERT_FALSE(lease);
+        } else {
+            ASSERT_TRUE(lease);
+            ASSERT_TRUE(*createLease4(n) == *lease);
+        }
+    }
+    const HWAddr hwaddr(createLease4(7)->hwaddr_, HTYPE_ETHER);
+    Lease4Ptr lease = lease_mgr.getLease4(hwaddr, 1);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("10.0.0.7", lease->addr_.toText());
+    Lease6Ptr x = lease_mgr.getLease6(*duid, 7, 8);
+    ASSERT_TRUE(x);
+    EXPECT_TRUE(*lease6 == *x);
+
+    // The leases can be changed again.
+    EXPECT_TRUE(lease_mgr.addLease(createLease4(5)));
+    EXPECT_TRUE(lease_mgr.deleteLease(IOAddress("2001:db8:1::456")));
+}
+
+// Checks that several readers share the file, and can't change it. (The
+// file locks keeping the readers and the writer apart are per process,
+// see the tests of MemorySegmentMapped.)
+TEST_F(MemfileMappedTest, readonly) {
+    EXPECT_THROW(Memfile_LeaseMgr(parameters(true)), DbOpenError);
+    {
+        Memfile_LeaseMgr lease_mgr(parameters(false));
+        ASSERT_TRUE(lease_mgr.addLease(createLease4(1)));
+    }
+
+    Memfile_LeaseMgr reader1(parameters(true));
+    Memfile_LeaseMgr reader2(parameters(true));
+    EXPECT_TRUE(reader1.getLease4(IOAddress("10.0.0.1")));
+    EXPECT_TRUE(reader2.getLease4(IOAddress("10.0.0.1")));
+    EXPECT_THROW(reader1.addLease(createLease4(2)), DbOperationError);
+    EXPECT_THROW(reader1.updateLease4(createLease4(1)), DbOperationError);
+    EXPECT_THROW(reader1.deleteLease(IOAddress("10.0.0.1")),
+                 DbOperationError);
+}
+
+// Checks that a mapped file without leases is rejected by a reader.
+TEST_F(MemfileMappedTest, notLeaseFile) {
+    {
+        isc::util::MemorySegmentMapped segment(
+            LEASE_FILE, isc::util::MemorySegmentMapped::CREATE_ONLY);
+    }
+    EXPECT_THROW(Memfile_LeaseMgr(parameters(true)), DbOpenError);
+    // A writer creates the leases.
+    EXPECT_NO_THROW(Memfile_LeaseMgr(parameters(false)));
+    EXPECT_NO_THROW(Memfile_LeaseMgr(parameters(true)));
+}
+
+#endif // USE_SHARED_MEMORY
+
 // TODO: Write more memfile tests
 
 }; // end of anonymous namespace
@@ -0,0 +1,167 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+#include <dhcpsrv/rate_limiter.h>
+
+#include <gtest/gtest.h>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace boost::posix_time;
+
+namespace {
+
+/// @brief Test fixture, with a fixed current time.
+class RateLimiterTest : public ::testing::Test {
+public:
+    /// @brief Constructor.
+    RateLimiterTest()
+        : now_(time_from_string("2013-06-01 12:00:00")) {
+    }
+
+    /// @brief Checks a query received at the current time.
+    RateLimiter::Decision check(SubnetID subnet_id,
+                                RateLimiter::Priority priority) {
+        return (limiter_.check(subnet_id, priority, now_, now_));
+    }
+
+    RateLimiter limiter_;
+    ptime now_;
+};
+
+// Checks that nothing is dropped by default.
+TEST_F(RateLimiterTest, disabled) {
+    EXPECT_FALSE(limiter_.isEnabled());
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(RateLimiter::ACCEPT,
+                  limiter_.check(1, RateLimiter::PRIORITY_NEW_CLIENT,
+                                 now_ - hours(1), now_));
+    }
+}
+
+// Checks that each subnet has its own bucket, refilled at the rate.
+TEST_F(RateLimiterTest, rate) {
+    limiter_.setRate(10, 5);
+    EXPECT_TRUE(limiter_.isEnabled());
+    EXPECT_EQ(10, limiter_.getRate());
+    EXPECT_EQ(5, limiter_.getBurst());
+
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(RateLimiter::ACCEPT,
+                  check(1, RateLimiter::PRIORITY_NEW_CLIENT));
+    }
+    EXPECT_EQ(RateLimiter::RATE_LIMITED,
+              check(1, RateLimiter::PRIORITY_NEW_CLIENT));
+    EXPECT_EQ(RateLimiter::RATE_LIMITED,
+              check(1, RateLimiter::PRIORITY_NORMAL));
+
+    // Renewals don't need a token.
+    EXPECT_EQ(RateLimiter::ACCEPT,
+              check(1, RateLimiter::PRIORITY_EXISTING_LEASE));
+
+    // Another subnet is not affected.
+    EXPECT_EQ(RateLimiter::ACCEPT, check(2, RateLimiter::PRIORITY_NEW_CLIENT));
+
+    // 10 queries per second: one token every 100ms.
+    now_ += milliseconds(150);
+    EXPECT_EQ(RateLimiter::ACCEPT, check(1, RateLimiter::PRIORITY_NEW_CLIENT));
+    EXPECT_EQ(RateLimiter::RATE_LIMITED,
+              check(1, RateLimiter::PRIORITY_NEW_CLIENT));
+    now_ += milliseconds(50);
+    EXPECT_EQ(RateLimiter::ACCEPT, check(1, RateLimiter::PRIORITY_NEW_CLIENT));
+
+    // The bucket doesn't hold more than the burst.
+    now_ += hours(1);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(RateLimiter::ACCEPT,
+                  check(1, RateLimiter::PRIORITY_NEW_CLIENT));
+    }
+    EXPECT_EQ(RateLimiter::RATE_LIMITED,
+              check(1, RateLimiter::PRIORITY_NEW_CLIENT));
+
+    // The burst defaults to the rate.
+    limiter_.setRate(3);
+    EXPECT_EQ(3, limiter_.getBurst());
+    limiter_.setRate(0);
+    EXPECT_FALSE(limiter_.isEnabled());
+}
+
+// Checks that the queries which waited too long are shed by priority.
+TEST_F(RateLimiterTest, shed) {
+    limiter_.setShedDelay(200);
+    EXPECT_TRUE(limiter_.isEnabled());
+
+    const ptime received = now_ - milliseconds(250);
+    EXPECT_EQ(RateLimiter::SHED,
+              limiter_.check(1, RateLimiter::PRIORITY_NEW_CLIENT, received,
+                             now_));
+    EXPECT_EQ(RateLimiter::ACCEPT,
+              limiter_.check(1, RateLimiter::PRIORITY_NORMAL, received,
+                             now_));
+
+    const ptime late = now_ - milliseconds(400);
+    EXPECT_EQ(RateLimiter::SHED,
+              limiter_.check(1, RateLimiter::PRIORITY_NORMAL, late, now_));
+    EXPECT_EQ(RateLimiter::ACCEPT,
+              limiter_.check(1, RateLimiter::PRIORITY_EXISTING_LEASE,
+                             now_ - hours(1), now_));
+
+    EXPECT_EQ(RateLimiter::ACCEPT,
+              limiter_.check(1, RateLimiter::PRIORITY_NEW_CLIENT,
+                             now_ - milliseconds(100), now_));
+
+    // Queries without reception time are not shed.
+    EXPECT_EQ(RateLimiter::ACCEPT,
+              limiter_.check(1, RateLimiter::PRIORITY_NEW_CLIENT, ptime(),
+                             now_));
+}
+
+// Checks the priorities of the DHCPv4 queries.
+TEST_F(RateLimiterTest, priority4) {
+    EXPECT_EQ(RateLimiter::PRIORITY_NEW_CLIENT,
+              RateLimiter::getPriority(Pkt4(DHCPDISCOVER, 1)));
+    Pkt4 request(DHCPREQUEST, 1);
+    EXPECT_EQ(RateLimiter::PRIORITY_NORMAL,
+              RateLimiter::getPriority(request));
+    request.setCiaddr(IOAddress("192.0.2.1"));
+    EXPECT_EQ(RateLimiter::PRIORITY_EXISTING_LEASE,
+              RateLimiter::getPriority(request));
+    EXPECT_EQ(RateLimiter::PRIORITY_EXISTING_LEASE,
+              RateLimiter::getPriority(Pkt4(DHCPRELEASE, 1)));
+    EXPECT_EQ(RateLimiter::PRIORITY_NORMAL,
+              RateLimiter::getPriority(Pkt4(DHCPINFORM, 1)));
+}
+
+// Checks the priorities of the DHCPv6 queries.
+TEST_F(RateLimiterTest, priority6) {
+    EXPECT_EQ(RateLimiter::PRIORITY_NEW_CLIENT,
+              RateLimiter::getPriority(Pkt6(DHCPV6_SOLICIT, 1)));
+    EXPECT_EQ(RateLimiter::PRIORITY_NORMAL,
+              RateLimiter::getPriority(Pkt6(DHCPV6_REQUEST, 1)));
+    EXPECT_EQ(RateLimiter::PRIORITY_EXISTING_LEASE,
+              RateLimiter::getPriority(Pkt6(DHCPV6_RENEW, 1)));
+    EXPECT_EQ(RateLimiter::PRIORITY_EXISTING_LEASE,
+              RateLimiter::getPriority(Pkt6(DHCPV6_REBIND, 1)));
+    EXPECT_EQ(RateLimiter::PRIORITY_NORMAL,
+              RateLimiter::getPriority(Pkt6(DHCPV4_QUERY, 1)));
+}
+
+}
@@ -0,0 +1,188 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/pool.h>
+#include <dhcpsrv/server_counters.h>
+#include <dhcpsrv/subnet.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace isc::asiolink;
+using namespace isc::data;
+using namespace isc::dhcp;
+using namespace isc::util::thread;
+
+namespace {
+
+/// @brief Names the message types 1 and 2, all other types are "UNKNOWN".
+const char*
+typeName(uint8_t type) {
+    switch (type) {
+    case 1:
+        return ("DISCOVER");
+    case 2:
+        return ("OFFER");
+    default:
+        ;
+    }
+    return ("UNKNOWN");
+}
+
+/// @brief Increments the counters the given number of times.
+void
+incCounters(ServerCounters* counters, int count) {
+    for (int i = 0; i < count; ++i) {
+        counters->inc(ServerCounters::ALLOC_FAILED);
+        counters->incReceived(1);
+        counters->incSubnet(5, ServerCounters::SUBNET_ALLOCATED);
+    }
+}
+
+// Checks that the counters are incremented and reported.
+TEST(ServerCountersTest, basic) {
+    ServerCounters counters;
+    EXPECT_EQ(0, counters.get(ServerCounters::PARSE_FAILED));
+    EXPECT_EQ(0, counters.getReceived(1));
+    EXPECT_EQ(0, counters.getSubnet(1, ServerCounters::SUBNET_RECEIVED));
+
+    counters.inc(ServerCounters::PARSE_FAILED);
+    counters.inc(ServerCounters::PARSE_FAILED);
+    counters.inc(ServerCounters::DHCP4O6_TIMED_OUT);
+    counters.incReceived(1);
+    counters.incSent(2);
+    counters.incSent(2);
+    // Types above the maximum are counted with the type 0.
+    counters.incReceived(200);
+    counters.incSubnet(1, ServerCounters::SUBNET_RECEIVED);
+    counters.incSubnet(1, ServerCounters::SUBNET_RECEIVED);
+    counters.incSubnet(2, ServerCounters::SUBNET_RELEASED);
+
+    EXPECT_EQ(2, counters.get(ServerCounters::PARSE_FAILED));
+    EXPECT_EQ(1, counters.get(ServerCounters::DHCP4O6_TIMED_OUT));
+    EXPECT_EQ(0, counters.get(ServerCounters::ALLOC_FAILED));
+    EXPECT_EQ(1, counters.getReceived(1));
+    EXPECT_EQ(1, counters.getReceived(0));
+    EXPECT_EQ(1, counters.getReceived(200));
+    EXPECT_EQ(2, counters.getSent(2));
+    EXPECT_EQ(2, counters.getSubnet(1, ServerCounters::SUBNET_RECEIVED));
+    EXPECT_EQ(1, counters.getSubnet(2, ServerCounters::SUBNET_RELEASED));
+    EXPECT_EQ(0, counters.getSubnet(3, ServerCounters::SUBNET_RELEASED));
+
+    // Other objects have their own counters.
+    ServerCounters other;
+    other.inc(ServerCounters::PARSE_FAILED);
+    EXPECT_EQ(1, other.get(ServerCounters::PARSE_FAILED));
+    EXPECT_EQ(2, counters.get(ServerCounters::PARSE_FAILED));
+}
+
+// Checks that the counters incremented by several threads are summed.
+TEST(ServerCountersTest, threads) {
+    ServerCounters counters;
+    incCounters(&counters, 10);
+
+    std::vector<boost::shared_ptr<Thread> > threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.push_back(boost::shared_ptr<Thread>(
+            new Thread(boost::bind(&incCounters, &counters, 1000))));
+    }
+    for (int i = 0; i < threads.size(); ++i) {
+        threads[i]->wait();
+    }
+
+    EXPECT_EQ(4010, counters.get(ServerCounters::ALLOC_FAILED));
+    EXPECT_EQ(4010, counters.getReceived(1));
+    EXPECT_EQ(4010, counters.getSubnet(5, ServerCounters::SUBNET_ALLOCATED));
+}
+
+// Checks the structure reported to b10-stats.
+TEST(ServerCountersTest, toElement) {
+    ServerCounters counters;
+    counters.inc(ServerCounters::NO_SUBNET);
+    counters.incReceived(1);
+    counters.incSent(2);
+    counters.incReceived(7);
+    counters.incReceived(8);
+    counters.incSubnet(3, ServerCounters::SUBNET_ALLOC_FAILED);
+
+    ConstElementPtr stats = counters.toElement(typeName);
+    ASSERT_TRUE(stats);
+    EXPECT_EQ(1, stats->get("no-subnet")->intValue());
+    EXPECT_EQ(0, stats->get("parse-failed")->intValue());
+    EXPECT_EQ(0, stats->get("dhcp4o6-forwarded")->intValue());
+
+    // Ambiguous names are replaced with the numbers of the types.
+    EXPECT_EQ("{ \"7\": 1, \"8\": 1, \"DISCOVER\": 1 }",
+              stats->get("received")->str());
+    EXPECT_EQ("{ \"OFFER\": 1 }", stats->get("sent")->str());
+
+    ConstElementPtr subnet = stats->get("subnets")->get("3");
+    ASSERT_TRUE(subnet);
+    EXPECT_EQ(1, subnet->get("alloc-failed")->intValue());
+    EXPECT_EQ(0, subnet->get("allocated")->intValue());
+}
+
+// Checks that the size of the pools is counted.
+TEST(ServerCountersTest, addPoolUsage) {
+    Subnet4Ptr subnet(new Subnet4(IOAddress("192.0.2.0"), 24, 1, 2, 3));
+    subnet->addPool(Pool4Ptr(new Pool4(IOAddress("192.0.2.10"),
+                                       IOAddress("192.0.2.19"))));
+    subnet->addPool(Pool4Ptr(new Pool4(IOAddress("192.0.2.100"),
+                                       IOAddress("192.0.2.104"))));
+
+    ElementPtr stats = Element::createMap();
+    ServerCounters::addPoolUsage(stats, *subnet);
+    const std::string key = boost::lexical_cast<std::string>(subnet->getID());
+    ConstElementPtr item = stats->get("subnets")->get(key);
+    ASSERT_TRUE(item);
+    EXPECT_EQ("192.0.2.0/24", item->get("subnet")->stringValue());
+    EXPECT_EQ(15, item->get("total-addresses")->intValue());
+    // The leased addresses are not looked up.
+    EXPECT_FALSE(item->contains("assigned-addresses"));
+
+    // The usage is added to the existing counters of the subnet.
+    ServerCounters counters;
+    counters.incSubnet(subnet->getID(), ServerCounters::SUBNET_ALLOCATED);
+    stats = counters.toElement(typeName);
+    ServerCounters::addPoolUsage(stats, *subnet);
+    ASSERT_EQ(1, stats->get("subnets")->mapValue().size());
+    item = stats->get("subnets")->get(key);
+    ASSERT_TRUE(item);
+    EXPECT_EQ(1, item->get("allocated")->intValue());
+    EXPECT_EQ(15, item->get("total-addresses")->intValue());
+
+    // The size of large IPv6 pools saturates.
+    Subnet6Ptr subnet6(new Subnet6(IOAddress("2001:db8::"), 48, 1, 2, 3, 4));
+    subnet6->addPool(Pool6Ptr(new Pool6(Pool6::TYPE_IA,
+                                        IOAddress("2001:db8::"), 64)));
+    ServerCounters::addPoolUsage(stats, *subnet6);
+    item = stats->get("subnets")->get(
+        boost::lexical_cast<std::string>(subnet6->getID()));
+    ASSERT_TRUE(item);
+    EXPECT_EQ(std::numeric_limits<long int>::max(),
+              item->get("total-addresses")->intValue());
+}
+
+}
@@ -0,0 +1,181 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcpsrv/stage_profiler.h>
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+using namespace isc::data;
+using namespace isc::dhcp;
+
+namespace {
+
+/// @brief Fake allocation counter.
+uint64_t alloc_count = 0;
+
+uint64_t
+getAllocCount() {
+    return (alloc_count);
+}
+
+/// @brief Names the message types 1 and 2, all other types are "UNKNOWN".
+const char*
+typeName(uint8_t type) {
+    switch (type) {
+    case 1:
+        return ("DISCOVER");
+    case 2:
+        return ("OFFER");
+    default:
+        ;
+    }
+    return ("UNKNOWN");
+}
+
+// Checks that nothing is recorded while the profiler is disabled.
+TEST(StageProfilerTest, disabled) {
+    StageProfiler profiler;
+    EXPECT_FALSE(profiler.isEnabled());
+
+    StageProfiler::Mark mark = profiler.mark();
+    EXPECT_EQ(0, mark.time_);
+    profiler.record(1, StageProfiler::UNPACK, mark);
+    EXPECT_EQ(0, profiler.getStats(1, StageProfiler::UNPACK).count_);
+    EXPECT_TRUE(profiler.toElement(typeName)->mapValue().empty());
+
+    // A stage which started while the profiler was disabled is not
+    // recorded.
+    profiler.setEnabled(true);
+    profiler.record(1, StageProfiler::UNPACK, mark);
+    EXPECT_EQ(0, profiler.getStats(1, StageProfiler::UNPACK).count_);
+}
+
+// Checks that the durations are recorded per message type and stage.
+TEST(StageProfilerTest, record) {
+    StageProfiler profiler;
+    profiler.setEnabled(true);
+
+    {
+        StageProfiler::Timer timer(profiler, 1, StageProfiler::PACK);
+        usleep(2000);
+    }
+    profiler.record(1, StageProfiler::PACK, profiler.mark());
+    // Types above the maximum are stored with the type 0.
+    profiler.record(200, StageProfiler::SEND, profiler.mark());
+
+    const StageProfiler::StageStats& stats =
+        profiler.getStats(1, StageProfiler::PACK);
+    EXPECT_EQ(2, stats.count_);
+    EXPECT_GE(stats.max_, 2000000);
+    EXPECT_GE(stats.total_, stats.max_);
+    uint64_t histogram_count = 0;
+    for (size_t i = 0; i < StageProfiler::BUCKET_COUNT; ++i) {
+        histogram_count += stats.buckets_[i];
+    }
+    EXPECT_EQ(2, histogram_count);
+    EXPECT_EQ(1, stats.buckets_[StageProfiler::bucketIndex(stats.max_)]);
+    EXPECT_EQ(0, profiler.getStats(1, StageProfiler::UNPACK).count_);
+    EXPECT_EQ(1, profiler.getStats(0, StageProfiler::SEND).count_);
+    EXPECT_EQ(1, profiler.getStats(200, StageProfiler::SEND).count_);
+
+    profiler.reset();
+    EXPECT_EQ(0, profiler.getStats(1, StageProfiler::PACK).count_);
+    EXPECT_TRUE(profiler.isEnabled());
+}
+
+// Checks the histogram buckets.
+TEST(StageProfilerTest, bucketIndex) {
+    EXPECT_EQ(0, StageProfiler::bucketIndex(0));
+    EXPECT_EQ(1, StageProfiler::bucketIndex(1));
+    EXPECT_EQ(2, StageProfiler::bucketIndex(2));
+    EXPECT_EQ(2, StageProfiler::bucketIndex(3));
+    EXPECT_EQ(11, StageProfiler::bucketIndex(1024));
+    EXPECT_EQ(StageProfiler::BUCKET_COUNT - 1,
+              StageProfiler::bucketIndex(1ULL << 40));
+}
+
+// Checks that the allocations are counted when the counter is installed.
+TEST(StageProfilerTest, allocations) {
+    StageProfiler profiler;
+    profiler.setEnabled(true);
+    StageProfiler::setAllocCounter(getAllocCount);
+
+    StageProfiler::Mark mark = profiler.mark();
+    alloc_count += 5;
+    profiler.record(1, StageProfiler::LEASE_BACKEND, mark);
+    StageProfiler::setAllocCounter(NULL);
+
+    EXPECT_EQ(5, profiler.getStats(1, StageProfiler::LEASE_BACKEND).allocs_);
+}
+
+// Checks that the stage which ended earlier is recorded.
+TEST(StageProfilerTest, recordEnded) {
+    StageProfiler profiler;
+    profiler.setEnabled(true);
+
+    StageProfiler::Mark begin = { 1000, 0 };
+    StageProfiler::Mark end = { 1500, 0 };
+    profiler.record(1, StageProfiler::RECEIVE_WAIT, begin, end);
+    EXPECT_EQ(500, profiler.getStats(1, StageProfiler::RECEIVE_WAIT).total_);
+
+    // The stage is not recorded if any mark is empty.
+    StageProfiler::Mark empty = { 0, 0 };
+    profiler.record(1, StageProfiler::RECEIVE_WAIT, empty, end);
+    EXPECT_EQ(1, profiler.getStats(1, StageProfiler::RECEIVE_WAIT).count_);
+}
+
+// Checks the statistics reported as an element.
+TEST(StageProfilerTest, toElement) {
+    StageProfiler profiler;
+    profiler.setEnabled(true);
+    profiler.record(1, StageProfiler::UNPACK, profiler.mark());
+    profiler.record(1, StageProfiler::SEND, profiler.mark());
+    profiler.record(3, StageProfiler::UNPACK, profiler.mark());
+
+    ConstElementPtr stats = profiler.toElement(typeName);
+    ASSERT_EQ(2, stats->mapValue().size());
+
+    // The type 3 is not named uniquely, so it's reported by number.
+    ConstElementPtr discover = stats->get("DISCOVER");
+    ASSERT_TRUE(discover);
+    EXPECT_EQ(2, discover->mapValue().size());
+    ASSERT_TRUE(stats->get("3"));
+    EXPECT_FALSE(stats->get("OFFER"));
+
+    ConstElementPtr unpack = discover->get("unpack");
+    ASSERT_TRUE(unpack);
+    EXPECT_EQ(1, unpack->get("count")->intValue());
+    EXPECT_EQ(0, unpack->get("allocations")->intValue());
+    EXPECT_EQ(unpack->get("total-ns")->intValue(),
+              unpack->get("max-ns")->intValue());
+    EXPECT_EQ(StageProfiler::BUCKET_COUNT,
+              unpack->get("histogram")->size());
+    ASSERT_TRUE(discover->get("send"));
+}
+
+// Checks the names of the stages.
+TEST(StageProfilerTest, stageToText) {
+    EXPECT_EQ(std::string("receive-wait"),
+              StageProfiler::stageToText(StageProfiler::RECEIVE_WAIT));
+    EXPECT_EQ(std::string("ipc-wait"),
+              StageProfiler::stageToText(StageProfiler::IPC_WAIT));
+    EXPECT_EQ(std::string("unknown"),
+              StageProfiler::stageToText(StageProfiler::STAGE_COUNT));
+}
+
+} // end of anonymous namespace
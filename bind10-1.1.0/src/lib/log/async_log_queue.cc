@@ -0,0 +1,408 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "config.h"
+#include <log/async_log_queue.h>
+#include <log/log_formatter.h>
+#include <log/logger_impl.h>
+
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+#ifdef ENABLE_LOGGER_CHECKS
+#include <iostream>
+#endif
+
+#include <sched.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace isc::util::thread;
+
+namespace isc {
+namespace log {
+
+const size_t AsyncLogSlot::MAX_ARGS;
+const size_t AsyncLogSlot::TEXT_SIZE;
+const size_t AsyncLogQueue::DEFAULT_CAPACITY;
+
+string
+AsyncLogSlot::argToText(size_t index) const {
+    const Argument& arg = args_[index];
+    switch (arg.type_) {
+    case Argument::SIGNED:
+        return (boost::lexical_cast<string>(arg.value_.signed_));
+    case Argument::UNSIGNED:
+        return (boost::lexical_cast<string>(arg.value_.unsigned_));
+    case Argument::DOUBLE:
+        return (boost::lexical_cast<string>(arg.value_.double_));
+    case Argument::TEXT:
+    default:
+        ;
+    }
+    return (string(text_ + arg.value_.text_.offset_, arg.value_.text_.length_));
+}
+
+string*
+AsyncLogSlot::createMessage() const {
+    string* message = logger_->lookupMessage(ident_);
+    try {
+        for (size_t i = 0; i < arg_count_; ++i) {
+            replacePlaceholder(message, argToText(i), i + 1);
+        }
+    } catch (...) {
+        delete message;
+        throw;
+    }
+    return (message);
+}
+
+/// \brief Ring buffer and the thread outputting the messages
+///
+/// This is a bounded queue in which every slot carries a sequence number
+/// telling whether the slot is free for the producer reserving position
+/// N (sequence == N), holds the published message at position N
+/// (sequence == N + 1) or is still being filled in.  The single consumer
+/// is the background thread.
+class AsyncLogQueue::Impl {
+public:
+    Impl(size_t capacity, OverflowPolicy policy) :
+        slots_(capacity), mask_(capacity - 1), policy_(policy),
+        enqueue_pos_(0), dequeue_pos_(0), running_(true), sleeping_(false)
+    {
+        for (size_t i = 0; i < capacity; ++i) {
+            slots_[i].sequence_ = i;
+        }
+        thread_.reset(new Thread(boost::bind(&Impl::run, this)));
+    }
+
+    /// \brief Reserves the next free slot.
+    ///
+    /// \return The slot or NULL if the queue is full.
+    AsyncLogSlot* tryReserve() {
+        size_t pos = enqueue_pos_;
+        for (;;) {
+            AsyncLogSlot& slot = slots_[pos & mask_];
+            const size_t sequence = slot.sequence_;
+            __sync_synchronize();
+            const ptrdiff_t diff = static_cast<ptrdiff_t>(sequence - pos);
+            if (diff == 0) {
+                const size_t found =
+                    __sync_val_compare_and_swap(&enqueue_pos_, pos, pos + 1);
+                if (found == pos) {
+                    return (&slot);
+                }
+                pos = found;
+            } else if (diff < 0) {
+                return (NULL);
+            } else {
+                pos = enqueue_pos_;
+            }
+        }
+    }
+
+    /// \brief Makes the slot available to the consumer.
+    void publish(AsyncLogSlot* slot) {
+        // The contents of the slot must be visible before the sequence
+        // number is updated, and the update must be visible before the
+        // sleeping_ flag is read.
+        __sync_synchronize();
+        slot->sequence_ = slot->sequence_ + 1;
+        __sync_synchronize();
+        if (sleeping_) {
+            Mutex::Locker locker(mutex_);
+            cond_.signal();
+        }
+    }
+
+    /// \brief Waits until the consumer has handled the given position.
+    void waitFor(size_t pos) {
+        while (static_cast<ptrdiff_t>(dequeue_pos_ - pos) < 0) {
+            wakeUp();
+            usleep(100);
+        }
+    }
+
+    /// \brief Terminates the background thread once the queue is empty.
+    void shutdown() {
+        waitFor(enqueue_pos_);
+        {
+            Mutex::Locker locker(mutex_);
+            running_ = false;
+            cond_.signal();
+        }
+        thread_->wait();
+    }
+
+    /// \brief Returns the current enqueue position.
+    size_t getEnqueuePos() const {
+        return (enqueue_pos_);
+    }
+
+    /// \brief Returns the number of slots.
+    size_t getCapacity() const {
+        return (slots_.size());
+    }
+
+    /// \brief Returns the overflow policy.
+    OverflowPolicy getPolicy() const {
+        return (policy_);
+    }
+
+private:
+    /// \brief Wakes up the background thread if it sleeps.
+    void wakeUp() {
+        Mutex::Locker locker(mutex_);
+        cond_.signal();
+    }
+
+    /// \brief Checks if the slot at the dequeue position is published.
+    bool ready() const {
+        const AsyncLogSlot& slot = slots_[dequeue_pos_ & mask_];
+        return (slot.sequence_ == dequeue_pos_ + 1);
+    }
+
+    /// \brief Outputs the message held in the slot.
+    ///
+    /// There is no caller to pass an exception to, so a failure to format
+    /// the message is reported in the same way as excess placeholders are
+    /// reported by checkExcessPlaceholders().
+    void output(const AsyncLogSlot& slot) {
+        if (slot.cancelled_) {
+            return;
+        }
+        string message;
+        try {
+            boost::scoped_ptr<string> text(slot.createMessage());
+            checkExcessPlaceholders(text.get(), slot.arg_count_ + 1);
+            message.swap(*text);
+        } catch (const std::exception& ex) {
+#ifdef ENABLE_LOGGER_CHECKS
+            cerr << "Message " << slot.ident_ << ": " << ex.what() << endl;
+            assert("Formatting of a queued message failed" == NULL);
+#endif /* ENABLE_LOGGER_CHECKS */
+            message = string(slot.ident_) + " @@Formatting failed: " +
+                ex.what() + "@@";
+        }
+        try {
+            slot.logger_->outputRaw(slot.severity_, message);
+        } catch (...) {
+            // A failing appender has nobody to report to either, the
+            // message is lost.
+        }
+    }
+
+    /// \brief Body of the background thread.
+    void run() {
+        for (;;) {
+            while (ready()) {
+                __sync_synchronize();
+                AsyncLogSlot& slot = slots_[dequeue_pos_ & mask_];
+                output(slot);
+                __sync_synchronize();
+                slot.sequence_ = dequeue_pos_ + slots_.size();
+                ++dequeue_pos_;
+            }
+
+            Mutex::Locker locker(mutex_);
+            sleeping_ = true;
+            __sync_synchronize();
+            if (!ready()) {
+                if (!running_) {
+                    return;
+                }
+                cond_.wait(mutex_);
+            }
+            sleeping_ = false;
+        }
+    }
+
+    /// The slots.
+    vector<AsyncLogSlot> slots_;
+
+    /// Mask converting the position to the slot index.
+    const size_t mask_;
+
+    /// What to do when the queue is full.
+    const OverflowPolicy policy_;
+
+    /// Position the next message will be stored at.
+    volatile size_t enqueue_pos_;
+
+    /// Position of the next message to output.
+    volatile size_t dequeue_pos_;
+
+    /// Cleared when the thread is to terminate.
+    bool running_;
+
+    /// Set when the background thread is about to wait for messages.
+    volatile bool sleeping_;
+
+    /// Mutex protecting running_ and sleeping_ transitions.
+    Mutex mutex_;
+
+    /// Condition variable the background thread waits on.
+    CondVar cond_;
+
+    /// The background thread.
+    boost::scoped_ptr<Thread> thread_;
+};
+
+AsyncLogQueue::Impl* volatile AsyncLogQueue::instance_ = NULL;
+
+namespace {
+
+/// Number of messages discarded since the start of the program.
+volatile uint64_t dropped_messages = 0;
+
+/// \brief Stops the queue at exit.
+void
+stopAtExit() {
+    AsyncLogQueue::stop();
+}
+
+}
+
+AsyncLogQueue::Impl*
+AsyncLogQueue::getInstance() {
+    Impl* impl = instance_;
+    __sync_synchronize();
+    return (impl);
+}
+
+void
+AsyncLogQueue::start(size_t capacity, OverflowPolicy policy) {
+    if (capacity == 0) {
+        isc_throw(isc::BadValue, "capacity of the logging queue must not "
+                  "be 0");
+    }
+    size_t slots = 1;
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+
+    stop();
+    Impl* impl = new Impl(slots, policy);
+    // The queue must be constructed before other threads can see it.
+    __sync_synchronize();
+    instance_ = impl;
+    __sync_synchronize();
+
+    static bool registered = false;
+    if (!registered) {
+        atexit(stopAtExit);
+        registered = true;
+    }
+}
+
+void
+AsyncLogQueue::stop() {
+    Impl* impl = getInstance();
+    if (impl != NULL) {
+        impl->shutdown();
+        instance_ = NULL;
+        __sync_synchronize();
+        delete impl;
+    }
+}
+
+void
+AsyncLogQueue::flush() {
+    Impl* impl = getInstance();
+    if (impl != NULL) {
+        impl->waitFor(impl->getEnqueuePos());
+    }
+}
+
+uint64_t
+AsyncLogQueue::getDropped() {
+    return (__sync_fetch_and_add(&dropped_messages, 0));
+}
+
+AsyncLogQueue::OverflowPolicy
+AsyncLogQueue::getPolicy() {
+    Impl* impl = getInstance();
+    if (impl == NULL) {
+        isc_throw(isc::InvalidOperation, "the logging queue is not running");
+    }
+    return (impl->getPolicy());
+}
+
+size_t
+AsyncLogQueue::getCapacity() {
+    Impl* impl = getInstance();
+    if (impl == NULL) {
+        isc_throw(isc::InvalidOperation, "the logging queue is not running");
+    }
+    return (impl->getCapacity());
+}
+
+AsyncLogSlot*
+AsyncLogQueue::reserve(LoggerImpl* logger, const Severity& severity,
+                       const MessageID& ident, bool& dropped)
+{
+    dropped = false;
+    Impl* impl = getInstance();
+    if (impl == NULL) {
+        return (NULL);
+    }
+
+    AsyncLogSlot* slot = impl->tryReserve();
+    while (slot == NULL) {
+        switch (impl->getPolicy()) {
+        case DROP:
+            __sync_fetch_and_add(&dropped_messages, 1);
+            dropped = true;
+            return (NULL);
+        case SYNCHRONOUS:
+            return (NULL);
+        case BLOCK:
+        default:
+            sched_yield();
+            slot = impl->tryReserve();
+        }
+    }
+
+    slot->logger_ = logger;
+    slot->severity_ = severity;
+    slot->ident_ = ident;
+    slot->cancelled_ = false;
+    slot->arg_count_ = 0;
+    slot->text_length_ = 0;
+    return (slot);
+}
+
+void
+AsyncLogQueue::publish(AsyncLogSlot* slot) {
+    // The slot has been reserved while the queue was running and stop()
+    // waits for all reserved slots to be output, so the instance is still
+    // there.
+    getInstance()->publish(slot);
+}
+
+void
+AsyncLogQueue::cancel(AsyncLogSlot* slot) {
+    slot->cancelled_ = true;
+    getInstance()->publish(slot);
+}
+
+} // namespace log
+} // namespace isc
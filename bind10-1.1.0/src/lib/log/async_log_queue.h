@@ -0,0 +1,324 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef ASYNC_LOG_QUEUE_H
+#define ASYNC_LOG_QUEUE_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include <stdint.h>
+
+#include <exceptions/exceptions.h>
+#include <log/logger_level.h>
+#include <log/message_types.h>
+
+#include <boost/lexical_cast.hpp>
+
+namespace isc {
+namespace log {
+
+class LoggerImpl;
+class AsyncLogQueue;
+
+/// \brief Message stored in the asynchronous logging queue
+///
+/// The slot holds everything needed to produce the message later: the
+/// logger, the severity, the message identifier and the arguments.  The
+/// arguments are stored in their native form; numbers are converted to
+/// text (and the placeholders are replaced) by the thread which outputs
+/// the message.  Text arguments are copied into the storage held within
+/// the slot, so storing a message doesn't allocate memory.
+///
+/// If an argument doesn't fit in the slot (there are too many arguments or
+/// the text is too long), addArg() returns false and the formatter falls
+/// back to formatting the message itself.
+class AsyncLogSlot {
+public:
+    /// Maximum number of arguments held in the slot.
+    static const size_t MAX_ARGS = 8;
+
+    /// Size of the storage for the text arguments.
+    static const size_t TEXT_SIZE = 384;
+
+    /// \brief Stores a signed integer argument.
+    bool addArg(short value) { return (addSigned(value)); }
+    bool addArg(int value) { return (addSigned(value)); }
+    bool addArg(long value) { return (addSigned(value)); }
+    bool addArg(long long value) { return (addSigned(value)); }
+
+    /// \brief Stores an unsigned integer argument.
+    bool addArg(unsigned short value) { return (addUnsigned(value)); }
+    bool addArg(unsigned int value) { return (addUnsigned(value)); }
+    bool addArg(unsigned long value) { return (addUnsigned(value)); }
+    bool addArg(unsigned long long value) { return (addUnsigned(value)); }
+
+    /// \brief Stores a floating point argument.
+    bool addArg(double value) {
+        if (arg_count_ == MAX_ARGS) {
+            return (false);
+        }
+        args_[arg_count_].type_ = Argument::DOUBLE;
+        args_[arg_count_++].value_.double_ = value;
+        return (true);
+    }
+
+    /// \brief Stores a text argument.
+    bool addArg(const std::string& value) {
+        return (addText(value.data(), value.size()));
+    }
+
+    /// \brief Stores a text argument.
+    bool addArg(const char* value) {
+        return (addText(value, std::strlen(value)));
+    }
+
+    /// \brief Stores an argument of any other type.
+    ///
+    /// The argument is converted to text by the calling thread, as there
+    /// is no way to keep a copy of an arbitrary object.
+    ///
+    /// \throw boost::bad_lexical_cast if the conversion fails.
+    template<class Arg> bool addArg(const Arg& value) {
+        return (addArg(boost::lexical_cast<std::string>(value)));
+    }
+
+    /// \brief Returns the number of stored arguments.
+    size_t getArgCount() const {
+        return (arg_count_);
+    }
+
+    /// \brief Creates the message text
+    ///
+    /// Looks up the text of the message and replaces the placeholders
+    /// with the stored arguments.  It doesn't check for excess
+    /// placeholders, as more arguments may be added to the message.
+    ///
+    /// \return Pointer to the message text.  The caller is responsible for
+    ///     deleting it.
+    std::string* createMessage() const;
+
+private:
+    friend class AsyncLogQueue;
+
+    /// \brief Argument of the message
+    struct Argument {
+        enum Type {
+            SIGNED,
+            UNSIGNED,
+            DOUBLE,
+            TEXT
+        };
+
+        Type type_;
+        union {
+            int64_t signed_;
+            uint64_t unsigned_;
+            double double_;
+            struct {
+                uint16_t offset_;
+                uint16_t length_;
+            } text_;
+        } value_;
+    };
+
+    /// \brief Stores a signed integer argument.
+    bool addSigned(int64_t value) {
+        if (arg_count_ == MAX_ARGS) {
+            return (false);
+        }
+        args_[arg_count_].type_ = Argument::SIGNED;
+        args_[arg_count_++].value_.signed_ = value;
+        return (true);
+    }
+
+    /// \brief Stores an unsigned integer argument.
+    bool addUnsigned(uint64_t value) {
+        if (arg_count_ == MAX_ARGS) {
+            return (false);
+        }
+        args_[arg_count_].type_ = Argument::UNSIGNED;
+        args_[arg_count_++].value_.unsigned_ = value;
+        return (true);
+    }
+
+    /// \brief Copies a text argument to the storage of the slot.
+    bool addText(const char* data, size_t length) {
+        if ((arg_count_ == MAX_ARGS) || (length > TEXT_SIZE - text_length_)) {
+            return (false);
+        }
+        std::memcpy(text_ + text_length_, data, length);
+        args_[arg_count_].type_ = Argument::TEXT;
+        args_[arg_count_].value_.text_.offset_ = text_length_;
+        args_[arg_count_++].value_.text_.length_ = length;
+        text_length_ += length;
+        return (true);
+    }
+
+    /// \brief Returns the text form of an argument.
+    std::string argToText(size_t index) const;
+
+    /// Position of the slot in the queue (set by the queue).
+    volatile size_t sequence_;
+
+    /// Logger which outputs the message.
+    LoggerImpl* logger_;
+
+    /// Severity of the message.
+    Severity severity_;
+
+    /// Identifier of the message.
+    MessageID ident_;
+
+    /// Set if the message shouldn't be output.
+    bool cancelled_;
+
+    /// Number of stored arguments.
+    size_t arg_count_;
+
+    /// Stored arguments.
+    Argument args_[MAX_ARGS];
+
+    /// Number of octets of the text storage in use.
+    size_t text_length_;
+
+    /// Storage for the text arguments.
+    char text_[TEXT_SIZE];
+};
+
+/// \brief Queue of messages waiting to be output by the logging thread
+///
+/// In the default (synchronous) mode, the thread logging a message looks
+/// up the message text, converts all arguments to strings, replaces the
+/// placeholders and writes the message out while holding the logging mutex.
+/// When verbose logging is enabled on a busy server, this work is done on
+/// the packet processing path and it dominates the processing time.
+///
+/// When the queue is started, the logging thread only copies the message
+/// identifier and the raw arguments into a slot of a fixed-size ring
+/// buffer.  A background thread takes the messages from the ring, formats
+/// them and passes them to the appenders.  Slots are reserved with a
+/// compare-and-swap on the position counter, so producers never take a
+/// lock (unless they need to wake up the background thread).
+///
+/// The messages are output in the order in which the slots were reserved.
+/// The placeholder checks are performed by the background thread.  If the
+/// message can't be formatted, the program is aborted when
+/// ENABLE_LOGGER_CHECKS is defined; otherwise the message identifier is
+/// output together with the description of the failure.
+///
+/// The queue is a process-wide singleton controlled by the static
+/// methods.  start() and stop() must be called when no other threads log
+/// (e.g. during the program initialization).
+class AsyncLogQueue {
+public:
+    /// \brief What to do when a message is logged and the queue is full
+    enum OverflowPolicy {
+        DROP,           ///< Discard the message (and count it as dropped)
+        BLOCK,          ///< Wait until there is room in the queue
+        SYNCHRONOUS     ///< Format and output the message immediately
+    };
+
+    /// Default number of slots in the queue.
+    static const size_t DEFAULT_CAPACITY = 1024;
+
+    /// \brief Starts the asynchronous logging
+    ///
+    /// Creates the ring buffer and the background thread.  If the queue
+    /// is already running, it is stopped first.  The queue is stopped
+    /// automatically at exit.
+    ///
+    /// \param capacity Number of slots in the ring buffer, rounded up to
+    ///     the power of two.
+    /// \param policy What to do when the queue is full.
+    ///
+    /// \throw isc::BadValue if the capacity is 0.
+    static void start(size_t capacity = DEFAULT_CAPACITY,
+                      OverflowPolicy policy = DROP);
+
+    /// \brief Stops the asynchronous logging
+    ///
+    /// Outputs all queued messages and terminates the background thread.
+    /// Messages logged afterwards are output synchronously.  Does nothing
+    /// if the queue is not running.
+    static void stop();
+
+    /// \brief Checks if the asynchronous logging is enabled.
+    ///
+    /// The instance isn't accessed here, so no memory barrier is needed.
+    static bool isRunning() {
+        return (instance_ != NULL);
+    }
+
+    /// \brief Waits until all messages logged so far are output.
+    ///
+    /// Does nothing if the queue is not running.
+    static void flush();
+
+    /// \brief Returns the number of discarded messages
+    ///
+    /// The counter is not reset when the queue is stopped.
+    static uint64_t getDropped();
+
+    /// \brief Returns the overflow policy of the running queue.
+    ///
+    /// \throw isc::InvalidOperation if the queue is not running.
+    static OverflowPolicy getPolicy();
+
+    /// \brief Returns the number of slots of the running queue.
+    ///
+    /// \throw isc::InvalidOperation if the queue is not running.
+    static size_t getCapacity();
+
+    /// \brief Reserves a slot for a message
+    ///
+    /// This is used by the Logger.
+    ///
+    /// \param logger Logger which will output the message.
+    /// \param severity Severity of the message.
+    /// \param ident Identifier of the message.
+    /// \param dropped Set to true if the message has been discarded.
+    ///
+    /// \return Pointer to the slot the arguments are to be stored in, or
+    ///     NULL if the message must be output synchronously (or not at all
+    ///     if dropped is set).
+    static AsyncLogSlot* reserve(LoggerImpl* logger, const Severity& severity,
+                                 const MessageID& ident, bool& dropped);
+
+    /// \brief Passes the message to the background thread
+    ///
+    /// The slot must not be accessed afterwards.
+    static void publish(AsyncLogSlot* slot);
+
+    /// \brief Releases the slot without outputting the message.
+    static void cancel(AsyncLogSlot* slot);
+
+private:
+    class Impl;
+
+    /// \brief Returns the running queue
+    ///
+    /// The pointer is read after a memory barrier, so the queue created
+    /// by another thread is seen fully constructed.
+    static Impl* getInstance();
+
+    /// The running queue, NULL if the asynchronous logging is disabled.
+    static Impl* volatile instance_;
+};
+
+} // namespace log
+} // namespace isc
+
+#endif // ASYNC_LOG_QUEUE_H
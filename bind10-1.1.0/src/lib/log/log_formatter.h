@@ -21,6 +21,7 @@
 
 #include <exceptions/exceptions.h>
 #include <boost/lexical_cast.hpp>
+#include <log/async_log_queue.h>
 #include <log/logger_level.h>
 
 namespace isc {
@@ -107,6 +108,11 @@ replacePlaceholder(std::string* message, const std::string& replacement,
 /// destroyed before any call to .arg, producing an output, and then the one
 /// the .arg calls are called on would get destroyed as well, producing output
 /// again. So, think of this behaviour as soul moving from one to another.
+///
+/// When the asynchronous logging is enabled (see AsyncLogQueue), the
+/// formatter holds a slot of the logging queue instead of the message text.
+/// The arguments are stored in the slot and the message is published to
+/// the background thread by the destructor.
 template<class Logger> class Formatter {
 private:
     /// \brief The logger we will use to output the final message.
@@ -123,6 +129,11 @@ private:
     /// \brief Which will be the next placeholder to replace
     unsigned nextPlaceholder_;
 
+    /// \brief Slot of the asynchronous logging queue
+    ///
+    /// If not NULL, the arguments are stored in the slot rather than
+    /// replaced in the message_.
+    mutable AsyncLogSlot* slot_;
 
 public:
     /// \brief Constructor of "active" formatter
@@ -142,7 +153,20 @@ public:
     Formatter(const Severity& severity = NONE, std::string* message = NULL,
               Logger* logger = NULL) :
         logger_(logger), severity_(severity), message_(message),
-        nextPlaceholder_(0)
+        nextPlaceholder_(0), slot_(NULL)
+    {
+    }
+
+    /// \brief Constructor of formatter storing the message in the queue
+    ///
+    /// \param severity The severity of the message (DEBUG, ERROR etc.)
+    /// \param slot Slot of the asynchronous logging queue reserved for the
+    ///     message.  It is published when the formatter is destroyed.
+    /// \param logger The logger used if the message doesn't fit in the
+    ///     slot and must be output synchronously.
+    Formatter(const Severity& severity, AsyncLogSlot* slot, Logger* logger) :
+        logger_(logger), severity_(severity), message_(NULL),
+        nextPlaceholder_(0), slot_(slot)
     {
     }
 
@@ -153,16 +177,20 @@ public:
     /// object being copied relinquishes that responsibility.
     Formatter(const Formatter& other) :
         logger_(other.logger_), severity_(other.severity_),
-        message_(other.message_), nextPlaceholder_(other.nextPlaceholder_)
+        message_(other.message_), nextPlaceholder_(other.nextPlaceholder_),
+        slot_(other.slot_)
     {
         other.logger_ = NULL;
+        other.slot_ = NULL;
     }
 
     /// \brief Destructor.
     //
     /// This is the place where output happens if the formatter is active.
     ~ Formatter() {
-        if (logger_) {
+        if (slot_) {
+            AsyncLogQueue::publish(slot_);
+        } else if (logger_) {
             checkExcessPlaceholders(message_, ++nextPlaceholder_);
             logger_->output(severity_, *message_);
             delete message_;
@@ -179,7 +207,9 @@ public:
             severity_ = other.severity_;
             message_ = other.message_;
             nextPlaceholder_ = other.nextPlaceholder_;
+            slot_ = other.slot_;
             other.logger_ = NULL;
+            other.slot_ = NULL;
         }
 
         return *this;
@@ -195,6 +225,9 @@ public:
     template<class Arg> Formatter& arg(const Arg& value) {
         if (logger_) {
             try {
+                if (slot_ && storeArg(value)) {
+                    return (*this);
+                }
                 return (arg(boost::lexical_cast<std::string>(value)));
             } catch (const boost::bad_lexical_cast& ex) {
                 // The formatting of the log message got wrong, we don't want
@@ -220,6 +253,9 @@ public:
     ///
     /// \param arg The text to place into the placeholder.
     Formatter& arg(const std::string& arg) {
+        if (slot_ && storeArg(arg)) {
+            return (*this);
+        }
         if (logger_) {
             // Note that this method does a replacement and returns the
             // modified string. If there are multiple invocations of arg() (e.g.
@@ -254,12 +290,42 @@ public:
     /// The expected use is when there was an exception processing
     /// the arguments for the message.
     void deactivate() {
+        if (slot_) {
+            AsyncLogQueue::cancel(slot_);
+            slot_ = NULL;
+        }
         if (logger_) {
             delete message_;
             message_ = NULL;
             logger_ = NULL;
         }
     }
+
+private:
+    /// \brief Stores the argument in the slot of the logging queue
+    ///
+    /// If the slot has no room for the argument, the message is formatted
+    /// using the arguments stored so far, the slot is released and the
+    /// formatter continues in the synchronous mode.  The queue is flushed
+    /// first, so the message isn't output before those logged earlier.
+    ///
+    /// \return true if the argument has been stored.
+    template<class Arg> bool storeArg(const Arg& value) {
+        try {
+            if (slot_->addArg(value)) {
+                ++nextPlaceholder_;
+                return (true);
+            }
+            message_ = slot_->createMessage();
+        } catch (...) {
+            deactivate();
+            throw;
+        }
+        AsyncLogQueue::cancel(slot_);
+        slot_ = NULL;
+        AsyncLogQueue::flush();
+        return (false);
+    }
 };
 
 }
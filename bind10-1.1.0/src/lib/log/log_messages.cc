@@ -7,6 +7,7 @@
 namespace isc {
 namespace log {
 
+extern const isc::log::MessageID LOG_BAD_ASYNC_SPEC = "LOG_BAD_ASYNC_SPEC";
 extern const isc::log::MessageID LOG_BAD_DESTINATION = "LOG_BAD_DESTINATION";
 extern const isc::log::MessageID LOG_BAD_SEVERITY = "LOG_BAD_SEVERITY";
 extern const isc::log::MessageID LOG_BAD_STREAM = "LOG_BAD_STREAM";
@@ -34,6 +35,7 @@ extern const isc::log::MessageID LOG_WRITE_ERROR = "LOG_WRITE_ERROR";
 namespace {
 
 const char* values[] = {
+    "LOG_BAD_ASYNC_SPEC", "invalid asynchronous logging specification '%1', logging synchronously",
     "LOG_BAD_DESTINATION", "unrecognized log destination: %1",
     "LOG_BAD_SEVERITY", "unrecognized log severity: %1",
     "LOG_BAD_STREAM", "bad log console output stream: %1",
@@ -8,6 +8,7 @@
 namespace isc {
 namespace log {
 
+extern const isc::log::MessageID LOG_BAD_ASYNC_SPEC;
 extern const isc::log::MessageID LOG_BAD_DESTINATION;
 extern const isc::log::MessageID LOG_BAD_SEVERITY;
 extern const isc::log::MessageID LOG_BAD_STREAM;
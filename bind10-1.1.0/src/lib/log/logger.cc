@@ -15,6 +15,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 
+#include <log/async_log_queue.h>
 #include <log/logger.h>
 #include <log/logger_impl.h>
 #include <log/logger_name.h>
@@ -42,6 +43,10 @@ void Logger::initLoggerImpl() {
 // Destructor.
 
 Logger::~Logger() {
+    // Queued messages may refer to the implementation.
+    if (loggerptr_ && AsyncLogQueue::isRunning()) {
+        AsyncLogQueue::flush();
+    }
     delete loggerptr_;
 }
 
@@ -129,11 +134,27 @@ Logger::output(const Severity& severity, const std::string& message) {
     getLoggerPtr()->outputRaw(severity, message);
 }
 
+Logger::Formatter
+Logger::createFormatter(const Severity& severity,
+                        const isc::log::MessageID& ident)
+{
+    if (AsyncLogQueue::isRunning()) {
+        bool dropped = false;
+        AsyncLogSlot* slot = AsyncLogQueue::reserve(getLoggerPtr(), severity,
+                                                    ident, dropped);
+        if (slot) {
+            return (Formatter(severity, slot, this));
+        } else if (dropped) {
+            return (Formatter());
+        }
+    }
+    return (Formatter(severity, getLoggerPtr()->lookupMessage(ident), this));
+}
+
 Logger::Formatter
 Logger::debug(int dbglevel, const isc::log::MessageID& ident) {
     if (isDebugEnabled(dbglevel)) {
-        return (Formatter(DEBUG, getLoggerPtr()->lookupMessage(ident),
-                          this));
+        return (createFormatter(DEBUG, ident));
     } else {
         return (Formatter());
     }
@@ -142,8 +163,7 @@ Logger::debug(int dbglevel, const isc::log::MessageID& ident) {
 Logger::Formatter
 Logger::info(const isc::log::MessageID& ident) {
     if (isInfoEnabled()) {
-        return (Formatter(INFO, getLoggerPtr()->lookupMessage(ident),
-                          this));
+        return (createFormatter(INFO, ident));
     } else {
         return (Formatter());
     }
@@ -152,8 +172,7 @@ Logger::info(const isc::log::MessageID& ident) {
 Logger::Formatter
 Logger::warn(const isc::log::MessageID& ident) {
     if (isWarnEnabled()) {
-        return (Formatter(WARN, getLoggerPtr()->lookupMessage(ident),
-                          this));
+        return (createFormatter(WARN, ident));
     } else {
         return (Formatter());
     }
@@ -162,8 +181,7 @@ Logger::warn(const isc::log::MessageID& ident) {
 Logger::Formatter
 Logger::error(const isc::log::MessageID& ident) {
     if (isErrorEnabled()) {
-        return (Formatter(ERROR, getLoggerPtr()->lookupMessage(ident),
-                          this));
+        return (createFormatter(ERROR, ident));
     } else {
         return (Formatter());
     }
@@ -172,8 +190,7 @@ Logger::error(const isc::log::MessageID& ident) {
 Logger::Formatter
 Logger::fatal(const isc::log::MessageID& ident) {
     if (isFatalEnabled()) {
-        return (Formatter(FATAL, getLoggerPtr()->lookupMessage(ident),
-                          this));
+        return (createFormatter(FATAL, ident));
     } else {
         return (Formatter());
     }
@@ -278,6 +278,18 @@ private:
     /// \param message Text of the message to be output.
     void output(const Severity& severity, const std::string& message);
 
+    /// \brief Create formatter for the message
+    ///
+    /// If the asynchronous logging is enabled, the formatter stores the
+    /// message in the logging queue.  Otherwise (or if the queue is full
+    /// and the overflow policy says so) the message is formatted and
+    /// output by the calling thread.
+    ///
+    /// \param severity Severity of the message.
+    /// \param ident Message identification.
+    Formatter createFormatter(const Severity& severity,
+                              const MessageID& ident);
+
     /// \brief Copy Constructor
     ///
     /// Disabled (marked private) as it makes no sense to copy the logger -
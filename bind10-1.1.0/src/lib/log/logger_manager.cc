@@ -13,8 +13,10 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <algorithm>
+#include <cstdlib>
 #include <vector>
 
+#include <log/async_log_queue.h>
 #include <log/logger.h>
 #include <log/logger_manager.h>
 #include <log/logger_manager_impl.h>
@@ -55,6 +57,47 @@ std::string& initRootName() {
     return (root);
 }
 
+// Start the asynchronous logging if requested by the B10_LOGGER_ASYNC
+// environment variable.  It holds the overflow policy ("drop", "block" or
+// "sync"), optionally followed by a colon and the size of the queue.
+void startAsyncLogging() {
+    using namespace isc::log;
+
+    const char* spec_char = getenv("B10_LOGGER_ASYNC");
+    if (!spec_char || AsyncLogQueue::isRunning()) {
+        return;
+    }
+    const std::string spec(spec_char);
+    const size_t colon = spec.find(':');
+    const std::string policy_text = spec.substr(0, colon);
+
+    AsyncLogQueue::OverflowPolicy policy;
+    if (policy_text == "drop") {
+        policy = AsyncLogQueue::DROP;
+    } else if (policy_text == "block") {
+        policy = AsyncLogQueue::BLOCK;
+    } else if (policy_text == "sync") {
+        policy = AsyncLogQueue::SYNCHRONOUS;
+    } else {
+        LOG_WARN(logger, LOG_BAD_ASYNC_SPEC).arg(spec);
+        return;
+    }
+
+    size_t capacity = AsyncLogQueue::DEFAULT_CAPACITY;
+    if (colon != std::string::npos) {
+        try {
+            capacity = boost::lexical_cast<size_t>(spec.substr(colon + 1));
+        } catch (const boost::bad_lexical_cast&) {
+            capacity = 0;
+        }
+        if (capacity == 0) {
+            LOG_WARN(logger, LOG_BAD_ASYNC_SPEC).arg(spec);
+            return;
+        }
+    }
+    AsyncLogQueue::start(capacity, policy);
+}
+
 } // Anonymous namespace
 
 
@@ -74,6 +117,8 @@ LoggerManager::~LoggerManager() {
 // Initialize processing
 void
 LoggerManager::processInit() {
+    // Output the queued messages before the appenders are replaced.
+    AsyncLogQueue::flush();
     impl_->processInit();
 }
 
@@ -141,6 +186,8 @@ LoggerManager::init(const std::string& root, isc::log::Severity severity,
 
     // Ensure that the mutex is constructed and ready at this point.
     (void) getMutex();
+
+    startAsyncLogging();
 }
 
 
@@ -0,0 +1,213 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <log/async_log_queue.h>
+#include <log/logger.h>
+#include <log/logger_manager.h>
+#include <log/log_messages.h>
+
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+#include <util/unittests/check_valgrind.h>
+#include <util/unittests/resource.h>
+
+#include <log4cplus/logger.h>
+#include <log4cplus/spi/loggingevent.h>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace isc;
+using namespace isc::log;
+using namespace isc::util::thread;
+using namespace std;
+
+namespace {
+
+/// \brief Appender recording the text of the messages
+///
+/// The appender can be blocked to simulate a slow output.
+class RecordingAppender : public log4cplus::Appender {
+public:
+    virtual void close() {}
+
+    /// \brief Mutex held while the output is blocked.
+    Mutex block_;
+
+    /// \brief Messages output so far.
+    vector<string> messages_;
+
+protected:
+    virtual void append(const log4cplus::spi::InternalLoggingEvent& event) {
+        Mutex::Locker locker(block_);
+        messages_.push_back(event.getMessage());
+    }
+};
+
+class AsyncLogQueueTest : public ::testing::Test {
+public:
+    AsyncLogQueueTest() :
+        logger_("async"), appender_(new RecordingAppender()),
+        appender_ptr_(appender_)
+    {
+        logger_.setSeverity(isc::log::INFO);
+        log4cplus::Logger impl =
+            log4cplus::Logger::getInstance(logger_.getName());
+        impl.removeAllAppenders();
+        impl.addAppender(appender_ptr_);
+        impl.setAdditivity(false);
+    }
+
+    ~AsyncLogQueueTest() {
+        AsyncLogQueue::stop();
+        log4cplus::Logger::getInstance(logger_.getName()).removeAllAppenders();
+        LoggerManager::reset();
+    }
+
+    /// \brief Logs a number of messages.
+    void logMessages(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            logger_.info(LOG_BAD_DESTINATION).arg(i);
+        }
+    }
+
+    Logger logger_;
+    RecordingAppender* appender_;
+    log4cplus::SharedAppenderPtr appender_ptr_;
+};
+
+// Checks the parameters of the queue.
+TEST_F(AsyncLogQueueTest, start) {
+    EXPECT_FALSE(AsyncLogQueue::isRunning());
+    EXPECT_THROW(AsyncLogQueue::getCapacity(), isc::InvalidOperation);
+    EXPECT_THROW(AsyncLogQueue::start(0), isc::BadValue);
+    EXPECT_FALSE(AsyncLogQueue::isRunning());
+
+    AsyncLogQueue::start(10, AsyncLogQueue::BLOCK);
+    EXPECT_TRUE(AsyncLogQueue::isRunning());
+    EXPECT_EQ(16, AsyncLogQueue::getCapacity());
+    EXPECT_EQ(AsyncLogQueue::BLOCK, AsyncLogQueue::getPolicy());
+
+    AsyncLogQueue::stop();
+    EXPECT_FALSE(AsyncLogQueue::isRunning());
+    // Stopping the stopped queue does nothing.
+    EXPECT_NO_THROW(AsyncLogQueue::stop());
+}
+
+// Checks that the messages are formatted by the background thread in the
+// same way as by the logging thread.
+TEST_F(AsyncLogQueueTest, format) {
+    AsyncLogQueue::start();
+
+    logger_.info(LOG_INPUT_OPEN_FAIL).arg("messages.txt").arg(42);
+    logger_.warn(LOG_INPUT_OPEN_FAIL).arg(string("other")).arg(-1.5);
+    logger_.error(LOG_NO_SUCH_MESSAGE).arg(static_cast<uint8_t>('x'));
+    // Message below the severity of the logger isn't queued at all.
+    logger_.debug(10, LOG_NO_SUCH_MESSAGE).arg(1);
+
+    // A text argument too long to be stored in the slot.
+    const string long_text(AsyncLogSlot::TEXT_SIZE + 1, 'a');
+    logger_.info(LOG_INPUT_OPEN_FAIL).arg(5).arg(long_text);
+
+    AsyncLogQueue::flush();
+    ASSERT_EQ(4, appender_->messages_.size());
+    EXPECT_EQ("LOG_INPUT_OPEN_FAIL unable to open message file messages.txt "
+              "for input: 42", appender_->messages_[0]);
+    EXPECT_EQ("LOG_INPUT_OPEN_FAIL unable to open message file other "
+              "for input: -1.5", appender_->messages_[1]);
+    EXPECT_EQ("LOG_NO_SUCH_MESSAGE could not replace message text for 'x': "
+              "no such message", appender_->messages_[2]);
+    EXPECT_EQ("LOG_INPUT_OPEN_FAIL unable to open message file 5 "
+              "for input: " + long_text, appender_->messages_[3]);
+}
+
+// Checks that the placeholder mismatches are reported by the background
+// thread in the same way as by the logging thread.
+TEST_F(AsyncLogQueueTest, mismatchedPlaceholders) {
+#ifdef ENABLE_LOGGER_CHECKS
+#ifdef EXPECT_DEATH
+    // There is nobody to throw the exception to, so the check aborts the
+    // program.
+    if (!isc::util::unittests::runningOnValgrind()) {
+        EXPECT_DEATH({
+            isc::util::unittests::dontCreateCoreDumps();
+            AsyncLogQueue::start();
+            logger_.info(LOG_BAD_DESTINATION).arg("one").arg("two");
+            AsyncLogQueue::flush();
+        }, ".*");
+    }
+#endif /* EXPECT_DEATH */
+#else
+    AsyncLogQueue::start();
+    logger_.info(LOG_BAD_DESTINATION).arg("one").arg("two");
+    logger_.info(LOG_INPUT_OPEN_FAIL).arg("one");
+    AsyncLogQueue::flush();
+    ASSERT_EQ(2, appender_->messages_.size());
+    EXPECT_EQ("LOG_BAD_DESTINATION unrecognized log destination: one "
+              "@@Missing placeholder %2 for 'two'@@", appender_->messages_[0]);
+    EXPECT_EQ("LOG_INPUT_OPEN_FAIL unable to open message file one "
+              "for input: %2 @@Excess logger placeholders still exist@@",
+              appender_->messages_[1]);
+#endif /* ENABLE_LOGGER_CHECKS */
+}
+
+// Checks that messages are discarded when the queue is full and the policy
+// says so.
+TEST_F(AsyncLogQueueTest, drop) {
+    AsyncLogQueue::start(8, AsyncLogQueue::DROP);
+    const uint64_t dropped = AsyncLogQueue::getDropped();
+    {
+        // The slot is freed after the message is output, so no more than
+        // the capacity can be queued while the output is blocked.
+        Mutex::Locker locker(appender_->block_);
+        logMessages(11);
+        EXPECT_EQ(dropped + 3, AsyncLogQueue::getDropped());
+    }
+    AsyncLogQueue::flush();
+    ASSERT_EQ(8, appender_->messages_.size());
+    EXPECT_EQ("LOG_BAD_DESTINATION unrecognized log destination: 7",
+              appender_->messages_[7]);
+}
+
+// Checks that no messages are lost when several threads log with the
+// blocking policy and that stop() outputs all queued messages.
+TEST_F(AsyncLogQueueTest, block) {
+    AsyncLogQueue::start(4, AsyncLogQueue::BLOCK);
+    const uint64_t dropped = AsyncLogQueue::getDropped();
+
+    vector<boost::shared_ptr<Thread> > threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.push_back(boost::shared_ptr<Thread>(new Thread(
+            boost::bind(&AsyncLogQueueTest::logMessages, this, 500))));
+    }
+    for (int i = 0; i < threads.size(); ++i) {
+        threads[i]->wait();
+    }
+
+    AsyncLogQueue::stop();
+    EXPECT_EQ(2000, appender_->messages_.size());
+    EXPECT_EQ(dropped, AsyncLogQueue::getDropped());
+
+    // Messages are output synchronously now.
+    logMessages(1);
+    EXPECT_EQ(2001, appender_->messages_.size());
+}
+
+}
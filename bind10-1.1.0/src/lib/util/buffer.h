@@ -16,6 +16,7 @@
 #define BUFFER_H 1
 
 #include <stdlib.h>
+#include <algorithm>
 #include <cstring>
 #include <vector>
 
@@ -417,6 +418,18 @@ public:
     /// This method can be used to re-initialize and reuse the buffer without
     /// constructing a new one.
     void clear() { size_ = 0; }
+    /// \brief Exchange the content of two buffers.
+    ///
+    /// The underlying storage, data length and capacity are exchanged
+    /// without copying any data or allocating memory.  This allows
+    /// callers to recycle pre-allocated buffers.
+    ///
+    /// \param other The buffer to exchange the content with.
+    void swap(OutputBuffer& other) {
+        std::swap(buffer_, other.buffer_);
+        std::swap(size_, other.size_);
+        std::swap(allocated_, other.allocated_);
+    }
     /// \brief Write an unsigned 8-bit integer into the buffer.
     ///
     /// \param data The 8-bit integer to be written into the buffer.
@@ -258,6 +258,31 @@ TEST_F(BufferTest, outputBufferZeroSize) {
     });
 }
 
+TEST_F(BufferTest, outputBufferSwap) {
+    obuffer.writeData(testdata, sizeof(testdata));
+    const void* data = obuffer.getData();
+    const size_t capacity = obuffer.getCapacity();
+
+    OutputBuffer other(256);
+    other.writeUint8(1);
+    const void* other_data = other.getData();
+
+    // The storage is exchanged, not copied.
+    obuffer.swap(other);
+    EXPECT_EQ(other_data, obuffer.getData());
+    EXPECT_EQ(1, obuffer.getLength());
+    EXPECT_EQ(256, obuffer.getCapacity());
+    EXPECT_EQ(data, other.getData());
+    EXPECT_EQ(sizeof(testdata), other.getLength());
+    EXPECT_EQ(capacity, other.getCapacity());
+    EXPECT_EQ(0, memcmp(other.getData(), testdata, sizeof(testdata)));
+
+    // Both buffers remain usable after the exchange.
+    obuffer.writeUint8(2);
+    EXPECT_EQ(2, obuffer.getLength());
+    EXPECT_EQ(2, obuffer[1]);
+}
+
 TEST_F(BufferTest, inputBufferReadVectorAll) {
     std::vector<uint8_t> vec;
 
@@ -0,0 +1,253 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <cc/data.h>
+#include <exceptions/exceptions.h>
+#include <log/logger_support.h>
+
+#include "pcap_reader.h"
+#include "replay_packet.h"
+#include "replay_stats.h"
+#include "server_target.h"
+#include "udp_target.h"
+
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace isc::data;
+using namespace isc::replay;
+using namespace std;
+
+namespace {
+
+void
+usage() {
+    cerr << "Usage: dhcp-replay [-h] [-c config-file | -4 server4 -6 server6]"
+        " [-n copies]\n"
+        "           [-r rate] [-t timeout] [-i interface] [-p port4]"
+        " [-P port6]\n"
+        "           capture-file\n"
+        "\n"
+        "Replays the messages sent to DHCP servers in a pcap capture and\n"
+        "reports the throughput and the latency per message class.\n"
+        "\n"
+        "  -c config-file  process the messages by servers in this process,\n"
+        "                  configured with the \"Dhcp4\" and \"Dhcp6\" maps"
+        " of the\n"
+        "                  JSON file (messages for a missing server are"
+        " skipped)\n"
+        "  -4 server4      send DHCPv4 messages to this DHCPv4 server\n"
+        "  -6 server6      send DHCPv6 messages and DHCPv4-queries to this\n"
+        "                  DHCPv6 server\n"
+        "  -n copies       replay the capture as this many clients per"
+        " captured\n"
+        "                  client (default 1)\n"
+        "  -r rate         messages sent per second (default: as fast as"
+        " possible)\n"
+        "  -t timeout      seconds to wait for a response (default 1)\n"
+        "  -i interface    interface the messages are received on by the\n"
+        "                  servers in this process (default eth0)\n"
+        "  -p port4        local port for DHCPv4 (default 68)\n"
+        "  -P port6        local port for DHCPv6 (default 546)\n";
+}
+
+template <typename T>
+T
+parseNumber(const char* value, const char* name) {
+    try {
+        return (boost::lexical_cast<T>(value));
+    } catch (const boost::bad_lexical_cast&) {
+        isc_throw(isc::InvalidParameter, "invalid " << name << ": " << value);
+    }
+}
+
+}
+
+int
+main(int argc, char* argv[]) {
+    string config_file;
+    string server4;
+    string server6;
+    uint32_t copies = 1;
+    double rate = 0;
+    double timeout = 1;
+    string iface = "eth0";
+    uint16_t port4 = 68;
+    uint16_t port6 = 546;
+
+    int opt;
+    try {
+        while ((opt = getopt(argc, argv, "hc:4:6:n:r:t:i:p:P:")) != -1) {
+            switch (opt) {
+            case 'c':
+                config_file = optarg;
+                break;
+            case '4':
+                server4 = optarg;
+                break;
+            case '6':
+                server6 = optarg;
+                break;
+            case 'n':
+                copies = parseNumber<uint32_t>(optarg, "number of copies");
+                break;
+            case 'r':
+                rate = parseNumber<double>(optarg, "rate");
+                break;
+            case 't':
+                timeout = parseNumber<double>(optarg, "timeout");
+                break;
+            case 'i':
+                iface = optarg;
+                break;
+            case 'p':
+                port4 = parseNumber<uint16_t>(optarg, "DHCPv4 port");
+                break;
+            case 'P':
+                port6 = parseNumber<uint16_t>(optarg, "DHCPv6 port");
+                break;
+            case 'h':
+                usage();
+                return (0);
+            default:
+                usage();
+                return (1);
+            }
+        }
+        if (optind != argc - 1) {
+            isc_throw(isc::InvalidParameter, "one capture file expected");
+        }
+        if (config_file.empty() == (server4.empty() && server6.empty())) {
+            isc_throw(isc::InvalidParameter, "either the server"
+                      " configuration or the server addresses expected");
+        }
+        if ((copies == 0) || (copies > ReplayPacket::MAX_COPY + 1)) {
+            isc_throw(isc::InvalidParameter, "number of copies must be"
+                      " between 1 and " << ReplayPacket::MAX_COPY + 1);
+        }
+    } catch (const isc::Exception& ex) {
+        cerr << "Error parsing command line options: " << ex.what() << endl;
+        usage();
+        return (1);
+    }
+
+    try {
+        // The servers in this process log through the BIND 10 logging.
+        isc::log::initLogger("dhcp-replay", isc::log::WARN);
+
+        ReplayStats stats;
+        boost::scoped_ptr<ReplayTarget> target;
+        bool has_v4;
+        bool has_v6;
+        if (!config_file.empty()) {
+            ifstream config_stream(config_file.c_str());
+            if (!config_stream.is_open()) {
+                isc_throw(isc::BadValue, "unable to open " << config_file);
+            }
+            ConstElementPtr config = Element::fromJSON(config_stream,
+                                                       config_file);
+            target.reset(new ServerTarget(stats, config, iface));
+            has_v4 = config->contains("Dhcp4");
+            has_v6 = config->contains("Dhcp6");
+        } else {
+            target.reset(new UdpTarget(stats, server4, server6, port4, port6,
+                                       timeout));
+            has_v4 = !server4.empty();
+            has_v6 = !server6.empty();
+        }
+
+        // Load the client messages the servers can process.
+        PcapReader reader(argv[optind]);
+        vector<ReplayPacketPtr> packets;
+        size_t skipped = 0;
+        Datagram datagram;
+        while (reader.next(datagram)) {
+            ReplayPacketPtr packet = ReplayPacket::fromDatagram(datagram);
+            if (!packet) {
+                continue;
+            }
+            // With the servers in this process, the DHCPv4-queries need
+            // both servers.
+            const bool v4_needed =
+                (packet->getProtocol() == ReplayPacket::DHCPV4) ||
+                ((packet->getProtocol() == ReplayPacket::DHCPV4_OVER_DHCPV6) &&
+                 !config_file.empty());
+            const bool v6_needed =
+                (packet->getProtocol() != ReplayPacket::DHCPV4);
+            if ((v4_needed && !has_v4) || (v6_needed && !has_v6)) {
+                ++skipped;
+                continue;
+            }
+            packets.push_back(packet);
+        }
+        cout << "Loaded " << packets.size() << " client messages ("
+             << skipped << " skipped for a missing server, "
+             << reader.getSkipped() << " frames not UDP)" << endl;
+        if (packets.empty()) {
+            return (1);
+        }
+
+        // Send the messages, with the given rate if any.
+        const double start = currentTime();
+        uint64_t sent = 0;
+        vector<uint8_t> payload;
+        for (uint32_t copy = 0; copy < copies; ++copy) {
+            for (vector<ReplayPacketPtr>::const_iterator packet =
+                     packets.begin(); packet != packets.end(); ++packet) {
+                if (rate > 0) {
+                    const double due = start + sent / rate;
+                    double wait = due - currentTime();
+                    if (wait > 0) {
+                        target->receive(wait);
+                        wait = due - currentTime();
+                        if (wait > 0) {
+                            usleep(static_cast<useconds_t>(wait * 1e6));
+                        }
+                    }
+                }
+                (*packet)->makeCopy(copy, payload);
+                target->send(**packet, payload);
+                target->receive(0);
+                ++sent;
+            }
+        }
+        const double send_duration = currentTime() - start;
+
+        // Wait for the outstanding responses.
+        const double deadline = currentTime() + timeout;
+        while (target->pending() && (currentTime() < deadline)) {
+            target->receive(deadline - currentTime());
+        }
+        const double duration = currentTime() - start;
+
+        cout << "Sent " << sent << " messages in " << send_duration << " s ("
+             << (send_duration > 0 ? sent / send_duration : 0)
+             << " messages/s)" << endl;
+        stats.print(cout, duration);
+
+    } catch (const std::exception& ex) {
+        cerr << "Error running dhcp-replay: " << ex.what() << endl;
+        return (1);
+    }
+    return (0);
+}
@@ -0,0 +1,256 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "pcap_reader.h"
+
+#include <sys/socket.h>
+
+using namespace isc::asiolink;
+
+namespace {
+
+/// Magic number of the files with microsecond timestamps.
+const uint32_t PCAP_MAGIC = 0xa1b2c3d4;
+/// Magic number of the files with nanosecond timestamps.
+const uint32_t PCAP_MAGIC_NSEC = 0xa1b23c4d;
+
+/// Supported link types.
+const uint32_t LINKTYPE_NULL = 0;
+const uint32_t LINKTYPE_ETHERNET = 1;
+const uint32_t LINKTYPE_RAW = 101;
+const uint32_t LINKTYPE_LINUX_SLL = 113;
+
+/// Size of the file header and of the record header.
+const size_t FILE_HEADER_SIZE = 24;
+const size_t RECORD_HEADER_SIZE = 16;
+
+/// Longest frame accepted (larger snaplens are used by some tools).
+const uint32_t MAX_FRAME_SIZE = 262144;
+
+const uint16_t ETHERTYPE_IP = 0x0800;
+const uint16_t ETHERTYPE_IPV6 = 0x86dd;
+const uint16_t ETHERTYPE_VLAN = 0x8100;
+
+const uint8_t IPPROTO_UDP_NUMBER = 17;
+const size_t UDP_HEADER_SIZE = 8;
+
+uint16_t
+readUint16(const uint8_t* data) {
+    return ((data[0] << 8) | data[1]);
+}
+
+uint32_t
+readUint32(const uint8_t* data) {
+    // The record headers are read in the native order and converted by
+    // toHost() if the file was written with the other byte order.
+    uint32_t value;
+    std::copy(data, data + sizeof(value), reinterpret_cast<uint8_t*>(&value));
+    return (value);
+}
+
+uint32_t
+swap32(uint32_t value) {
+    return (((value & 0xff) << 24) | ((value & 0xff00) << 8) |
+            ((value >> 8) & 0xff00) | (value >> 24));
+}
+
+}
+
+namespace isc {
+namespace replay {
+
+Datagram::Datagram() :
+    time_(0), src_addr_("::"), dst_addr_("::"), src_port_(0), dst_port_(0)
+{}
+
+PcapReader::PcapReader(const std::string& file_name) :
+    file_(file_name.c_str(), std::ios::in | std::ios::binary),
+    swapped_(false), nanosec_(false), link_type_(0), skipped_(0)
+{
+    if (!file_.is_open()) {
+        isc_throw(PcapError, "unable to open capture file " << file_name);
+    }
+    uint8_t header[FILE_HEADER_SIZE];
+    if (!file_.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        isc_throw(PcapError, "capture file " << file_name
+                  << " is too short");
+    }
+    const uint32_t magic = readUint32(header);
+    if ((magic == PCAP_MAGIC) || (magic == PCAP_MAGIC_NSEC)) {
+        swapped_ = false;
+    } else if ((swap32(magic) == PCAP_MAGIC) ||
+               (swap32(magic) == PCAP_MAGIC_NSEC)) {
+        swapped_ = true;
+    } else {
+        isc_throw(PcapError, file_name << " is not a pcap file"
+                  " (pcapng files must be converted first)");
+    }
+    nanosec_ = (toHost(magic) == PCAP_MAGIC_NSEC);
+    link_type_ = toHost(readUint32(header + 20)) & 0xffff;
+    if ((link_type_ != LINKTYPE_NULL) && (link_type_ != LINKTYPE_ETHERNET) &&
+        (link_type_ != LINKTYPE_RAW) && (link_type_ != LINKTYPE_LINUX_SLL)) {
+        isc_throw(PcapError, "unsupported link type " << link_type_
+                  << " in " << file_name);
+    }
+}
+
+uint32_t
+PcapReader::toHost(uint32_t value) const {
+    return (swapped_ ? swap32(value) : value);
+}
+
+bool
+PcapReader::next(Datagram& datagram) {
+    for (;;) {
+        uint8_t header[RECORD_HEADER_SIZE];
+        file_.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (file_.gcount() == 0) {
+            return (false);
+        } else if (file_.gcount() != sizeof(header)) {
+            isc_throw(PcapError, "capture file truncated in a record header");
+        }
+        const uint32_t sec = toHost(readUint32(header));
+        const uint32_t frac = toHost(readUint32(header + 4));
+        const uint32_t caplen = toHost(readUint32(header + 8));
+        const uint32_t origlen = toHost(readUint32(header + 12));
+        if (caplen > MAX_FRAME_SIZE) {
+            isc_throw(PcapError, "frame of " << caplen << " bytes in"
+                      " the capture file");
+        }
+        frame_.resize(caplen);
+        if (caplen && !file_.read(reinterpret_cast<char*>(&frame_[0]),
+                                  caplen)) {
+            // The last frame was cut short, e.g. when the capture was
+            // interrupted.
+            ++skipped_;
+            return (false);
+        }
+
+        datagram.time_ = sec + frac / (nanosec_ ? 1e9 : 1e6);
+        if ((caplen == origlen) && caplen &&
+            parseFrame(&frame_[0], caplen, datagram)) {
+            return (true);
+        }
+        ++skipped_;
+    }
+}
+
+bool
+PcapReader::parseFrame(const uint8_t* data, size_t length,
+                       Datagram& datagram) {
+    size_t offset = 0;
+    uint16_t ethertype = 0;
+    switch (link_type_) {
+    case LINKTYPE_ETHERNET:
+        offset = 14;
+        if (length < offset) {
+            return (false);
+        }
+        ethertype = readUint16(data + 12);
+        while ((ethertype == ETHERTYPE_VLAN) && (length >= offset + 4)) {
+            ethertype = readUint16(data + offset + 2);
+            offset += 4;
+        }
+        break;
+
+    case LINKTYPE_LINUX_SLL:
+        offset = 16;
+        if (length < offset) {
+            return (false);
+        }
+        ethertype = readUint16(data + 14);
+        break;
+
+    case LINKTYPE_NULL:
+        // The address family is in the byte order of the capturing host
+        // and its value for IPv6 differs between the systems, so the
+        // version of the IP header is checked instead.
+        offset = 4;
+        break;
+
+    default:
+        break;
+    }
+    if (ethertype && (ethertype != ETHERTYPE_IP) &&
+        (ethertype != ETHERTYPE_IPV6)) {
+        return (false);
+    }
+    if (length <= offset) {
+        return (false);
+    }
+    return (parseIp(data + offset, length - offset, datagram));
+}
+
+bool
+PcapReader::parseIp(const uint8_t* data, size_t length, Datagram& datagram) {
+    const uint8_t version = data[0] >> 4;
+    size_t offset;
+    size_t end;
+    if (version == 4) {
+        if (length < 20) {
+            return (false);
+        }
+        offset = (data[0] & 0x0f) * 4;
+        end = readUint16(data + 2);
+        // More fragments flag or a fragment offset: not a whole datagram.
+        if ((readUint16(data + 6) & 0x3fff) ||
+            (data[9] != IPPROTO_UDP_NUMBER)) {
+            return (false);
+        }
+        datagram.src_addr_ = IOAddress::fromBytes(AF_INET, data + 12);
+        datagram.dst_addr_ = IOAddress::fromBytes(AF_INET, data + 16);
+
+    } else if (version == 6) {
+        if (length < 40) {
+            return (false);
+        }
+        offset = 40;
+        end = offset + readUint16(data + 4);
+        uint8_t next_header = data[6];
+        // Hop-by-hop, routing and destination options headers are
+        // skipped, fragments are not reassembled.
+        while ((next_header == 0) || (next_header == 43) ||
+               (next_header == 60)) {
+            if (offset + 2 > length) {
+                return (false);
+            }
+            next_header = data[offset];
+            offset += (data[offset + 1] + 1) * 8;
+        }
+        if (next_header != IPPROTO_UDP_NUMBER) {
+            return (false);
+        }
+        datagram.src_addr_ = IOAddress::fromBytes(AF_INET6, data + 8);
+        datagram.dst_addr_ = IOAddress::fromBytes(AF_INET6, data + 24);
+
+    } else {
+        return (false);
+    }
+
+    if ((end > length) || (offset + UDP_HEADER_SIZE > end)) {
+        return (false);
+    }
+    const size_t udp_length = readUint16(data + offset + 4);
+    if ((udp_length < UDP_HEADER_SIZE) || (offset + udp_length > end)) {
+        return (false);
+    }
+    datagram.src_port_ = readUint16(data + offset);
+    datagram.dst_port_ = readUint16(data + offset + 2);
+    datagram.payload_.assign(data + offset + UDP_HEADER_SIZE,
+                             data + offset + udp_length);
+    return (true);
+}
+
+} // namespace replay
+} // namespace isc
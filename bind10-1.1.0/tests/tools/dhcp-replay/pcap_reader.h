@@ -0,0 +1,117 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef PCAP_READER_H
+#define PCAP_READER_H
+
+#include <asiolink/io_address.h>
+#include <exceptions/exceptions.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace replay {
+
+/// \brief Exception thrown when the capture file can't be read.
+class PcapError : public isc::Exception {
+public:
+    PcapError(const char* file, size_t line, const char* what) :
+        isc::Exception(file, line, what) {}
+};
+
+/// \brief UDP datagram read from a capture file.
+struct Datagram {
+    /// \brief Constructor.
+    Datagram();
+
+    /// Capture time in seconds since the epoch.
+    double time_;
+    /// Source address.
+    isc::asiolink::IOAddress src_addr_;
+    /// Destination address.
+    isc::asiolink::IOAddress dst_addr_;
+    /// Source port.
+    uint16_t src_port_;
+    /// Destination port.
+    uint16_t dst_port_;
+    /// UDP payload.
+    std::vector<uint8_t> payload_;
+};
+
+/// \brief Reader of the UDP datagrams in a pcap file.
+///
+/// The reader understands the classic pcap format (not pcapng) in both
+/// byte orders and with microsecond or nanosecond timestamps. The
+/// supported link types are Ethernet (with 802.1Q tags), Linux cooked
+/// capture, raw IP and BSD loopback. IPv6 extension headers are skipped.
+/// Frames carrying anything else than UDP, truncated frames and IP
+/// fragments are skipped, so the reader returns only complete datagrams.
+class PcapReader : public boost::noncopyable {
+public:
+    /// \brief Opens the capture file and reads its header.
+    ///
+    /// \param file_name name of the capture file
+    /// \throw PcapError if the file can't be opened or its header isn't
+    /// a pcap header of a supported link type
+    PcapReader(const std::string& file_name);
+
+    /// \brief Reads the next UDP datagram.
+    ///
+    /// \param datagram datagram to be filled in
+    /// \return false if there are no more datagrams in the file
+    /// \throw PcapError if the file is truncated in a record header
+    bool next(Datagram& datagram);
+
+    /// \brief Returns the number of frames which were skipped.
+    uint64_t getSkipped() const {
+        return (skipped_);
+    }
+
+private:
+    /// \brief Extracts the UDP datagram from a captured frame.
+    ///
+    /// \return false if the frame doesn't carry a complete UDP datagram
+    bool parseFrame(const uint8_t* data, size_t length, Datagram& datagram);
+
+    /// \brief Extracts the UDP datagram from an IPv4 or IPv6 packet.
+    bool parseIp(const uint8_t* data, size_t length, Datagram& datagram);
+
+    /// \brief Converts a field of the file header or a record header to
+    /// the host byte order.
+    uint32_t toHost(uint32_t value) const;
+
+    /// Capture file.
+    std::ifstream file_;
+    /// True if the file was written with the other byte order.
+    bool swapped_;
+    /// True if the timestamps have a nanosecond resolution.
+    bool nanosec_;
+    /// Link type of the capture.
+    uint32_t link_type_;
+    /// Buffer for the frames.
+    std::vector<uint8_t> frame_;
+    /// Number of frames skipped.
+    uint64_t skipped_;
+};
+
+} // namespace replay
+} // namespace isc
+
+#endif // PCAP_READER_H
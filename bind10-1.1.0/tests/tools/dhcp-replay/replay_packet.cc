@@ -0,0 +1,361 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "replay_packet.h"
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+
+using namespace isc::dhcp;
+
+namespace {
+
+/// Offset of the fields of the DHCPv4 message.
+const size_t V4_HLEN_OFFSET = 2;
+const size_t V4_XID_OFFSET = 4;
+const size_t V4_CHADDR_OFFSET = 28;
+const size_t V4_CHADDR_SIZE = 16;
+const size_t V4_COOKIE_OFFSET = 236;
+const size_t V4_OPTIONS_OFFSET = 240;
+
+/// Size of the DHCPv6 message header and of the relay message header.
+const size_t V6_HEADER_SIZE = 4;
+const size_t V6_RELAY_HEADER_SIZE = 34;
+
+/// Limit of the nesting of the relay messages.
+const int MAX_RELAY_DEPTH = 32;
+
+/// \brief Returns the name of the DHCPv4 message type.
+std::string
+getName4(uint8_t type) {
+    switch (type) {
+    case DHCPDISCOVER:
+        return ("DISCOVER");
+    case DHCPOFFER:
+        return ("OFFER");
+    case DHCPREQUEST:
+        return ("REQUEST");
+    case DHCPDECLINE:
+        return ("DECLINE");
+    case DHCPACK:
+        return ("ACK");
+    case DHCPNAK:
+        return ("NAK");
+    case DHCPRELEASE:
+        return ("RELEASE");
+    case DHCPINFORM:
+        return ("INFORM");
+    default:
+        ;
+    }
+    return ("BOOTP");
+}
+
+/// \brief Returns the name of the DHCPv6 message type.
+std::string
+getName6(uint8_t type) {
+    switch (type) {
+    case DHCPV6_SOLICIT:
+        return ("SOLICIT");
+    case DHCPV6_REQUEST:
+        return ("REQUEST");
+    case DHCPV6_CONFIRM:
+        return ("CONFIRM");
+    case DHCPV6_RENEW:
+        return ("RENEW");
+    case DHCPV6_REBIND:
+        return ("REBIND");
+    case DHCPV6_RELEASE:
+        return ("RELEASE");
+    case DHCPV6_DECLINE:
+        return ("DECLINE");
+    case DHCPV6_INFORMATION_REQUEST:
+        return ("INFORMATION-REQUEST");
+    case DHCPV6_RELAY_FORW:
+        return ("RELAY-FORW");
+    case DHCPV4_QUERY:
+        return ("DHCPV4-QUERY");
+    default:
+        ;
+    }
+    return ("UNKNOWN");
+}
+
+/// \brief Finds a DHCPv4 option.
+///
+/// \return offset of the option data or 0 if the option isn't present
+size_t
+findOption4(const uint8_t* data, size_t length, uint8_t code,
+            size_t& option_length) {
+    if ((length < V4_OPTIONS_OFFSET) ||
+        (data[V4_COOKIE_OFFSET] != 99) || (data[V4_COOKIE_OFFSET + 1] != 130) ||
+        (data[V4_COOKIE_OFFSET + 2] != 83) ||
+        (data[V4_COOKIE_OFFSET + 3] != 99)) {
+        return (0);
+    }
+    size_t offset = V4_OPTIONS_OFFSET;
+    while (offset < length) {
+        const uint8_t option = data[offset];
+        if (option == DHO_END) {
+            break;
+        } else if (option == DHO_PAD) {
+            ++offset;
+            continue;
+        }
+        if (offset + 2 > length) {
+            break;
+        }
+        option_length = data[offset + 1];
+        if (offset + 2 + option_length > length) {
+            break;
+        }
+        if (option == code) {
+            return (offset + 2);
+        }
+        offset += 2 + option_length;
+    }
+    return (0);
+}
+
+/// \brief Finds a DHCPv6 option in the options starting at the offset.
+///
+/// \return offset of the option data or 0 if the option isn't present
+size_t
+findOption6(const uint8_t* data, size_t length, size_t offset, uint16_t code,
+            size_t& option_length) {
+    while (offset + 4 <= length) {
+        const uint16_t option = (data[offset] << 8) | data[offset + 1];
+        option_length = (data[offset + 2] << 8) | data[offset + 3];
+        if (offset + 4 + option_length > length) {
+            break;
+        }
+        if (option == code) {
+            return (offset + 4);
+        }
+        offset += 4 + option_length;
+    }
+    return (0);
+}
+
+/// \brief Returns the offset of the options of the DHCPv6 message.
+size_t
+getOptionsOffset6(const uint8_t* data) {
+    return (((data[0] == DHCPV6_RELAY_FORW) || (data[0] == DHCPV6_RELAY_REPL)) ?
+            V6_RELAY_HEADER_SIZE : V6_HEADER_SIZE);
+}
+
+/// \brief Returns the class name of the DHCPv4 message.
+std::string
+getClassName4(const uint8_t* data, size_t length) {
+    size_t option_length = 0;
+    const size_t type = findOption4(data, length, DHO_DHCP_MESSAGE_TYPE,
+                                    option_length);
+    return (getName4((type && option_length) ? data[type] : 0));
+}
+
+/// \brief Returns the class name of the DHCPv6 message.
+std::string
+getClassName6(const uint8_t* data, size_t length, int depth = 0) {
+    if (length < V6_HEADER_SIZE) {
+        return ("UNKNOWN");
+    }
+    const std::string name = getName6(data[0]);
+    size_t inner_length = 0;
+    if ((data[0] == DHCPV6_RELAY_FORW) && (depth < MAX_RELAY_DEPTH)) {
+        const size_t inner = findOption6(data, length, V6_RELAY_HEADER_SIZE,
+                                         D6O_RELAY_MSG, inner_length);
+        if (inner) {
+            return (name + "(" + getClassName6(data + inner, inner_length,
+                                               depth + 1) + ")");
+        }
+    } else if (data[0] == DHCPV4_QUERY) {
+        const size_t inner = findOption6(data, length, V6_HEADER_SIZE,
+                                         OPTION_DHCPV4_MSG, inner_length);
+        if (inner) {
+            return (name + "(" + getClassName4(data + inner, inner_length) +
+                    ")");
+        }
+    }
+    return (name);
+}
+
+/// \brief XORs the last three octets of the data with the copy number.
+void
+xorTail(uint8_t* data, size_t length, uint32_t copy) {
+    for (size_t i = 0; (i < 3) && (i < length); ++i) {
+        data[length - 1 - i] ^= (copy >> (8 * i)) & 0xff;
+    }
+}
+
+/// \brief Rewrites the client of the DHCPv4 message.
+void
+rewrite4(uint8_t* data, size_t length, uint32_t copy) {
+    if (length < V4_OPTIONS_OFFSET) {
+        return;
+    }
+    xorTail(data + V4_XID_OFFSET, 4, copy);
+    const size_t hlen = std::min(static_cast<size_t>(data[V4_HLEN_OFFSET]),
+                                 V4_CHADDR_SIZE);
+    xorTail(data + V4_CHADDR_OFFSET, hlen, copy);
+    size_t option_length = 0;
+    const size_t client_id = findOption4(data, length,
+                                         DHO_DHCP_CLIENT_IDENTIFIER,
+                                         option_length);
+    if (client_id) {
+        xorTail(data + client_id, option_length, copy);
+    }
+}
+
+/// \brief Rewrites the client of the DHCPv6 message.
+void
+rewrite6(uint8_t* data, size_t length, uint32_t copy, int depth = 0) {
+    if (length < V6_HEADER_SIZE) {
+        return;
+    }
+    const bool relay = (data[0] == DHCPV6_RELAY_FORW);
+    // The header of the DHCPv4-query holds flags rather than a transaction
+    // id, the transaction id of the DHCPv4 message is rewritten instead.
+    if (!relay && (data[0] != DHCPV4_QUERY)) {
+        xorTail(data + 1, 3, copy);
+    }
+    size_t offset = getOptionsOffset6(data);
+    size_t option_length = 0;
+    while (offset + 4 <= length) {
+        const uint16_t option = (data[offset] << 8) | data[offset + 1];
+        option_length = (data[offset + 2] << 8) | data[offset + 3];
+        offset += 4;
+        if (offset + option_length > length) {
+            break;
+        }
+        if ((option == D6O_CLIENTID) && !relay) {
+            xorTail(data + offset, option_length, copy);
+        } else if ((option == D6O_RELAY_MSG) && relay &&
+                   (depth < MAX_RELAY_DEPTH)) {
+            rewrite6(data + offset, option_length, copy, depth + 1);
+        } else if ((option == OPTION_DHCPV4_MSG) &&
+                   (data[0] == DHCPV4_QUERY)) {
+            rewrite4(data + offset, option_length, copy);
+        }
+        offset += option_length;
+    }
+}
+
+}
+
+namespace isc {
+namespace replay {
+
+ReplayPacket::ReplayPacket(Protocol protocol, const std::string& class_name,
+                           const Datagram& datagram) :
+    protocol_(protocol), class_name_(class_name), time_(datagram.time_),
+    src_addr_(datagram.src_addr_), dst_addr_(datagram.dst_addr_),
+    payload_(datagram.payload_)
+{}
+
+ReplayPacketPtr
+ReplayPacket::fromDatagram(const Datagram& datagram) {
+    const std::vector<uint8_t>& payload = datagram.payload_;
+    if ((datagram.dst_port_ == DHCP4_SERVER_PORT) &&
+        (payload.size() >= V4_OPTIONS_OFFSET) && (payload[0] == BOOTREQUEST)) {
+        return (ReplayPacketPtr(new ReplayPacket(DHCPV4,
+            getClassName4(&payload[0], payload.size()), datagram)));
+    }
+    if ((datagram.dst_port_ != DHCP6_SERVER_PORT) ||
+        (payload.size() < V6_HEADER_SIZE)) {
+        return (ReplayPacketPtr());
+    }
+    switch (payload[0]) {
+    case DHCPV6_SOLICIT:
+    case DHCPV6_REQUEST:
+    case DHCPV6_CONFIRM:
+    case DHCPV6_RENEW:
+    case DHCPV6_REBIND:
+    case DHCPV6_RELEASE:
+    case DHCPV6_DECLINE:
+    case DHCPV6_INFORMATION_REQUEST:
+    case DHCPV6_RELAY_FORW:
+        return (ReplayPacketPtr(new ReplayPacket(DHCPV6,
+            getClassName6(&payload[0], payload.size()), datagram)));
+
+    case DHCPV4_QUERY:
+        return (ReplayPacketPtr(new ReplayPacket(DHCPV4_OVER_DHCPV6,
+            getClassName6(&payload[0], payload.size()), datagram)));
+
+    default:
+        ;
+    }
+    // Messages sent by the servers to the relays or other servers.
+    return (ReplayPacketPtr());
+}
+
+void
+ReplayPacket::makeCopy(uint32_t copy, std::vector<uint8_t>& payload) const {
+    payload = payload_;
+    if ((copy == 0) || payload.empty()) {
+        return;
+    }
+    if (protocol_ == DHCPV4) {
+        rewrite4(&payload[0], payload.size(), copy);
+    } else {
+        rewrite6(&payload[0], payload.size(), copy);
+    }
+}
+
+bool
+ReplayPacket::getMatchKey(bool v6, const uint8_t* data, size_t length,
+                          uint32_t& key) {
+    if (!v6) {
+        if (length < V4_XID_OFFSET + 4) {
+            return (false);
+        }
+        key = (data[V4_XID_OFFSET] << 24) | (data[V4_XID_OFFSET + 1] << 16) |
+            (data[V4_XID_OFFSET + 2] << 8) | data[V4_XID_OFFSET + 3];
+        return (true);
+    }
+
+    for (int depth = 0; depth < MAX_RELAY_DEPTH; ++depth) {
+        if (length < V6_HEADER_SIZE) {
+            return (false);
+        }
+        size_t inner_length = 0;
+        size_t inner = 0;
+        switch (data[0]) {
+        case DHCPV6_RELAY_FORW:
+        case DHCPV6_RELAY_REPL:
+            inner = findOption6(data, length, V6_RELAY_HEADER_SIZE,
+                                D6O_RELAY_MSG, inner_length);
+            if (!inner) {
+                return (false);
+            }
+            data += inner;
+            length = inner_length;
+            continue;
+
+        case DHCPV4_QUERY:
+        case DHCPV4_RESPONSE:
+            inner = findOption6(data, length, V6_HEADER_SIZE,
+                                OPTION_DHCPV4_MSG, inner_length);
+            return (inner &&
+                    getMatchKey(false, data + inner, inner_length, key));
+
+        default:
+            key = (data[1] << 16) | (data[2] << 8) | data[3];
+            return (true);
+        }
+    }
+    return (false);
+}
+
+} // namespace replay
+} // namespace isc
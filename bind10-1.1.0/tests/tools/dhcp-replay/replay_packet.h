@@ -0,0 +1,138 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef REPLAY_PACKET_H
+#define REPLAY_PACKET_H
+
+#include "pcap_reader.h"
+
+#include <asiolink/io_address.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace replay {
+
+class ReplayPacket;
+
+/// \brief Pointer to the replayed packet.
+typedef boost::shared_ptr<ReplayPacket> ReplayPacketPtr;
+
+/// \brief Client message extracted from a capture.
+///
+/// The packet holds the payload of a message sent by a client (or by
+/// a relay on behalf of a client) to a server, together with the name
+/// of its message class. The class is the message type, qualified with
+/// the type of the encapsulated message for the relayed DHCPv6 messages
+/// (e.g. "RELAY-FORW(SOLICIT)") and the DHCPv4-queries (e.g.
+/// "DHCPV4-QUERY(DISCOVER)").
+///
+/// To replay the capture with a larger client population, each packet
+/// can be sent several times as different clients. Copy 0 is the message
+/// as captured. In the other copies, the last three octets of the client
+/// hardware address, the DHCPv4 client identifier and the DHCPv6 client
+/// DUID, and the transaction id are XORed with the copy number. This
+/// applies to the messages encapsulated in DHCPv6 relay messages and in
+/// DHCPv4-queries too.
+class ReplayPacket {
+public:
+    /// \brief Protocol of the message.
+    enum Protocol {
+        DHCPV4,             ///< DHCPv4 over UDP/IPv4
+        DHCPV6,             ///< DHCPv6
+        DHCPV4_OVER_DHCPV6  ///< DHCPv4-query sent over DHCPv6
+    };
+
+    /// \brief Highest copy number which makes a distinct client.
+    static const uint32_t MAX_COPY = 0xffffff;
+
+    /// \brief Makes a packet from a captured datagram.
+    ///
+    /// \param datagram datagram read from the capture
+    /// \return packet or NULL if the datagram isn't a message sent to
+    /// a DHCP server
+    static ReplayPacketPtr fromDatagram(const Datagram& datagram);
+
+    /// \brief Returns the protocol of the message.
+    Protocol getProtocol() const {
+        return (protocol_);
+    }
+
+    /// \brief Returns the name of the message class.
+    const std::string& getClassName() const {
+        return (class_name_);
+    }
+
+    /// \brief Returns the capture time of the message in seconds.
+    double getTime() const {
+        return (time_);
+    }
+
+    /// \brief Returns the address the message was sent from.
+    const isc::asiolink::IOAddress& getSrcAddr() const {
+        return (src_addr_);
+    }
+
+    /// \brief Returns the address the message was sent to.
+    const isc::asiolink::IOAddress& getDstAddr() const {
+        return (dst_addr_);
+    }
+
+    /// \brief Returns the captured payload.
+    const std::vector<uint8_t>& getPayload() const {
+        return (payload_);
+    }
+
+    /// \brief Makes the payload of a copy of the message.
+    ///
+    /// \param copy copy number (0 to \ref MAX_COPY)
+    /// \param [out] payload payload of the copy
+    void makeCopy(uint32_t copy, std::vector<uint8_t>& payload) const;
+
+    /// \brief Returns the key matching a response to its query.
+    ///
+    /// The key is the transaction id of the message, of the relayed message
+    /// in the DHCPv6 relay messages and of the DHCPv4 message in the
+    /// DHCPv4-queries and DHCPv4-responses.
+    ///
+    /// \param v6 true for DHCPv6 messages, false for DHCPv4
+    /// \param data message
+    /// \param length length of the message
+    /// \param [out] key key of the message
+    /// \return false if the message is too short to carry the key
+    static bool getMatchKey(bool v6, const uint8_t* data, size_t length,
+                            uint32_t& key);
+
+private:
+    /// \brief Constructor (instances are created by fromDatagram()).
+    ReplayPacket(Protocol protocol, const std::string& class_name,
+                 const Datagram& datagram);
+
+    Protocol protocol_;
+    std::string class_name_;
+    double time_;
+    isc::asiolink::IOAddress src_addr_;
+    isc::asiolink::IOAddress dst_addr_;
+    std::vector<uint8_t> payload_;
+};
+
+} // namespace replay
+} // namespace isc
+
+#endif // REPLAY_PACKET_H
@@ -0,0 +1,83 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "replay_stats.h"
+
+#include <iomanip>
+
+#include <time.h>
+
+namespace isc {
+namespace replay {
+
+double
+currentTime() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec + now.tv_nsec / 1e9);
+}
+
+void
+ReplayStats::sent(const std::string& class_name) {
+    ++classes_[class_name].sent_;
+}
+
+void
+ReplayStats::answered(const std::string& class_name, double delay) {
+    classes_[class_name].delays_.add(delay);
+}
+
+uint64_t
+ReplayStats::getSent(const std::string& class_name) const {
+    std::map<std::string, ClassStats>::const_iterator stats =
+        classes_.find(class_name);
+    return (stats == classes_.end() ? 0 : stats->second.sent_);
+}
+
+uint64_t
+ReplayStats::getAnswered(const std::string& class_name) const {
+    std::map<std::string, ClassStats>::const_iterator stats =
+        classes_.find(class_name);
+    return (stats == classes_.end() ? 0 : stats->second.delays_.getCount());
+}
+
+void
+ReplayStats::print(std::ostream& out, double duration) const {
+    out << std::left << std::setw(32) << "class" << std::right
+        << std::setw(10) << "sent" << std::setw(10) << "answered"
+        << std::setw(12) << "answers/s" << std::setw(10) << "min ms"
+        << std::setw(10) << "p50 ms" << std::setw(10) << "p99 ms"
+        << std::setw(10) << "max ms" << std::endl;
+    out << std::fixed;
+    for (std::map<std::string, ClassStats>::const_iterator stats =
+             classes_.begin(); stats != classes_.end(); ++stats) {
+        const isc::perfdhcp::LatencyHistogram& delays = stats->second.delays_;
+        out << std::left << std::setw(32) << stats->first << std::right
+            << std::setw(10) << stats->second.sent_
+            << std::setw(10) << delays.getCount() << std::setw(12)
+            << std::setprecision(1)
+            << (duration > 0 ? delays.getCount() / duration : 0.0)
+            << std::setprecision(3);
+        if (delays.getCount()) {
+            out << std::setw(10) << delays.getMin() * 1e3
+                << std::setw(10) << delays.getPercentile(50) * 1e3
+                << std::setw(10) << delays.getPercentile(99) * 1e3
+                << std::setw(10) << delays.getMax() * 1e3;
+        }
+        out << std::endl;
+    }
+}
+
+} // namespace replay
+} // namespace isc
@@ -0,0 +1,78 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef REPLAY_STATS_H
+#define REPLAY_STATS_H
+
+#include "../perfdhcp/latency_histogram.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+
+#include <stdint.h>
+
+namespace isc {
+namespace replay {
+
+/// \brief Returns the time of a monotonic clock in seconds.
+double currentTime();
+
+/// \brief Throughput and latency of the replayed messages.
+///
+/// The statistics are kept per message class, see \ref ReplayPacket.
+/// The latency of a message is the time from sending it to receiving the
+/// first response to it.
+class ReplayStats {
+public:
+    /// \brief Counts a sent message.
+    ///
+    /// \param class_name class of the message
+    void sent(const std::string& class_name);
+
+    /// \brief Counts a response.
+    ///
+    /// \param class_name class of the message which was answered
+    /// \param delay time between the message and the response in seconds
+    void answered(const std::string& class_name, double delay);
+
+    /// \brief Returns the number of sent messages of the class.
+    uint64_t getSent(const std::string& class_name) const;
+
+    /// \brief Returns the number of answered messages of the class.
+    uint64_t getAnswered(const std::string& class_name) const;
+
+    /// \brief Prints the statistics of all message classes.
+    ///
+    /// \param out stream to print to
+    /// \param duration duration of the replay in seconds, used to compute
+    /// the rates
+    void print(std::ostream& out, double duration) const;
+
+private:
+    /// \brief Statistics of a message class.
+    struct ClassStats {
+        ClassStats() : sent_(0) {}
+        uint64_t sent_;
+        isc::perfdhcp::LatencyHistogram delays_;
+    };
+
+    /// Statistics indexed by the class names.
+    std::map<std::string, ClassStats> classes_;
+};
+
+} // namespace replay
+} // namespace isc
+
+#endif // REPLAY_STATS_H
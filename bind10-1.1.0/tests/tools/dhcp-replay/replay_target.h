@@ -0,0 +1,68 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef REPLAY_TARGET_H
+#define REPLAY_TARGET_H
+
+#include "replay_packet.h"
+#include "replay_stats.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace replay {
+
+/// \brief Destination of the replayed messages.
+///
+/// The target delivers the messages to the server and records the sent
+/// messages and the responses in the statistics.
+class ReplayTarget : public boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \param stats statistics to record the messages in
+    ReplayTarget(ReplayStats& stats) : stats_(stats) {}
+
+    /// \brief Destructor.
+    virtual ~ReplayTarget() {}
+
+    /// \brief Sends a message to the server.
+    ///
+    /// \param packet replayed packet
+    /// \param payload payload of the copy of the packet to be sent
+    virtual void send(const ReplayPacket& packet,
+                      const std::vector<uint8_t>& payload) = 0;
+
+    /// \brief Collects the responses.
+    ///
+    /// \param timeout time to wait for the responses in seconds, 0 to
+    /// collect only those already received
+    virtual void receive(double timeout) = 0;
+
+    /// \brief Returns true if responses to some messages are expected.
+    virtual bool pending() const = 0;
+
+protected:
+    /// Statistics of the replay.
+    ReplayStats& stats_;
+};
+
+} // namespace replay
+} // namespace isc
+
+#endif // REPLAY_TARGET_H
@@ -0,0 +1,220 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "server_target.h"
+
+#include <config/ccsession.h>
+#include <dhcp/dhcp6.h>
+#include <dhcp4/config_parser.h>
+#include <dhcp6/config_parser.h>
+
+using namespace isc::data;
+using namespace isc::dhcp;
+
+namespace {
+
+/// \brief Applies the configuration to the server.
+///
+/// \throw isc::BadValue if the configuration is rejected
+template <typename Server>
+void
+configure(ConstElementPtr (*configureServer)(Server&, ConstElementPtr),
+          Server& server, ConstElementPtr config) {
+    int rcode = 0;
+    ConstElementPtr comment =
+        isc::config::parseAnswer(rcode, configureServer(server, config));
+    if (rcode != 0) {
+        isc_throw(isc::BadValue, "server configuration rejected: "
+                  << (comment ? comment->str() : "no reason given"));
+    }
+}
+
+}
+
+namespace isc {
+namespace replay {
+
+ReplayDhcpv4Srv::ReplayDhcpv4Srv() :
+    Dhcpv4Srv(0, "type=memfile", false), response_time_(0), responses_(0)
+{}
+
+void
+ReplayDhcpv4Srv::process(const Pkt4Ptr& query) {
+    query_ = query;
+    shutdown_ = false;
+    run();
+}
+
+Pkt4Ptr
+ReplayDhcpv4Srv::receivePacket(int) {
+    Pkt4Ptr query;
+    query.swap(query_);
+    if (!query) {
+        shutdown_ = true;
+    }
+    return (query);
+}
+
+void
+ReplayDhcpv4Srv::sendPackets(const Pkt4Collection& packets, size_t& sent) {
+    for (sent = 0; sent < packets.size(); ++sent) {
+        const Pkt4Ptr& packet = packets[sent];
+        if (packet->is4o6) {
+            const uint8_t* data =
+                static_cast<const uint8_t*>(packet->getBuffer().getData());
+            responses4o6_.push_back(
+                OptionBuffer(data, data + packet->getBuffer().getLength()));
+        }
+    }
+    if (sent) {
+        response_time_ = currentTime();
+        responses_ += sent;
+    }
+}
+
+ReplayDhcpv6Srv::ReplayDhcpv6Srv() :
+    Dhcpv6Srv(0), response_time_(0), responses_(0)
+{}
+
+void
+ReplayDhcpv6Srv::process(const Pkt6Ptr& query) {
+    query_ = query;
+    shutdown_ = false;
+    run();
+}
+
+Pkt6Ptr
+ReplayDhcpv6Srv::receivePacket(int) {
+    Pkt6Ptr query;
+    query.swap(query_);
+    if (!query) {
+        shutdown_ = true;
+    }
+    return (query);
+}
+
+void
+ReplayDhcpv6Srv::sendPackets(const Pkt6Collection& packets, size_t& sent) {
+    sent = packets.size();
+    if (sent) {
+        response_time_ = currentTime();
+        responses_ += sent;
+    }
+}
+
+bool
+ReplayDhcpv6Srv::forwardDHCPv4Query(const OptionBuffer& data) {
+    queries4o6_.push_back(data);
+    return (true);
+}
+
+ServerTarget::ServerTarget(ReplayStats& stats, ConstElementPtr config,
+                           const std::string& iface) :
+    ReplayTarget(stats), iface_(iface)
+{
+    if (!config || (config->getType() != Element::map)) {
+        isc_throw(isc::BadValue, "server configuration is not a map");
+    }
+    if (config->contains("Dhcp4")) {
+        srv4_.reset(new ReplayDhcpv4Srv());
+        configure(&configureDhcp4Server, static_cast<Dhcpv4Srv&>(*srv4_),
+                  config->get("Dhcp4"));
+    }
+    if (config->contains("Dhcp6")) {
+        srv6_.reset(new ReplayDhcpv6Srv());
+        configure(&configureDhcp6Server, static_cast<Dhcpv6Srv&>(*srv6_),
+                  config->get("Dhcp6"));
+    }
+    if (!srv4_ && !srv6_) {
+        isc_throw(isc::BadValue, "server configuration has neither Dhcp4"
+                  " nor Dhcp6");
+    }
+}
+
+ServerTarget::~ServerTarget() {
+}
+
+void
+ServerTarget::send(const ReplayPacket& packet,
+                   const std::vector<uint8_t>& payload) {
+    stats_.sent(packet.getClassName());
+    const double start = currentTime();
+
+    if (packet.getProtocol() == ReplayPacket::DHCPV4) {
+        if (!srv4_) {
+            isc_throw(isc::BadValue, "no DHCPv4 server to process "
+                      << packet.getClassName());
+        }
+        Pkt4Ptr query(new Pkt4(&payload[0], payload.size()));
+        query->setRemoteAddr(packet.getSrcAddr());
+        query->setLocalAddr(packet.getDstAddr());
+        query->setIface(iface_);
+        query->updateTimestamp();
+        srv4_->responses_ = 0;
+        srv4_->process(query);
+        if (srv4_->responses_) {
+            stats_.answered(packet.getClassName(),
+                            srv4_->response_time_ - start);
+        }
+        return;
+    }
+
+    if (!srv6_ ||
+        ((packet.getProtocol() == ReplayPacket::DHCPV4_OVER_DHCPV6) &&
+         !srv4_)) {
+        isc_throw(isc::BadValue, "no DHCPv6 and DHCPv4 server to process "
+                  << packet.getClassName());
+    }
+    Pkt6Ptr query(new Pkt6(&payload[0], payload.size()));
+    query->setRemoteAddr(packet.getSrcAddr());
+    query->setLocalAddr(packet.getDstAddr());
+    query->setIface(iface_);
+    query->updateTimestamp();
+    srv6_->responses_ = 0;
+    srv6_->process(query);
+    process4o6();
+    if (srv6_->responses_) {
+        stats_.answered(packet.getClassName(), srv6_->response_time_ - start);
+    }
+}
+
+void
+ServerTarget::process4o6() {
+    std::vector<OptionBuffer> queries;
+    queries.swap(srv6_->queries4o6_);
+    if (!srv4_) {
+        return;
+    }
+    for (std::vector<OptionBuffer>::const_iterator data = queries.begin();
+         data != queries.end(); ++data) {
+        // This is what the interface managers of the servers do with the
+        // messages read from the UNIX sockets.
+        Pkt4Ptr query(new Pkt4(&(*data)[0], data->size()));
+        query->is4o6 = true;
+        query->updateTimestamp();
+        srv4_->process(query);
+    }
+
+    std::vector<OptionBuffer> responses;
+    responses.swap(srv4_->responses4o6_);
+    for (std::vector<OptionBuffer>::iterator data = responses.begin();
+         data != responses.end(); ++data) {
+        Pkt6Ptr response(new Pkt6(DHCPV4_RESPONSE, 0));
+        response->data4o6_.swap(*data);
+        srv6_->process(response);
+    }
+}
+
+} // namespace replay
+} // namespace isc
@@ -0,0 +1,158 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SERVER_TARGET_H
+#define SERVER_TARGET_H
+
+#include "replay_target.h"
+
+#include <cc/data.h>
+#include <dhcp4/dhcp4_srv.h>
+#include <dhcp6/dhcp6_srv.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace isc {
+namespace replay {
+
+/// \brief DHCPv4 server processing the packets handed to it.
+///
+/// The server replaces the interface manager with in-memory queues:
+/// process() runs the main loop of the server for a single query and
+/// the responses are collected instead of being sent.
+class ReplayDhcpv4Srv : public isc::dhcp::Dhcpv4Srv {
+public:
+    /// \brief Constructor, doesn't open any sockets.
+    ReplayDhcpv4Srv();
+
+    /// \brief Processes a query.
+    ///
+    /// \param query query (not unpacked)
+    void process(const isc::dhcp::Pkt4Ptr& query);
+
+    /// \brief Time of the last response sent.
+    double response_time_;
+
+    /// \brief Number of responses sent.
+    size_t responses_;
+
+    /// \brief Responses to the DHCPv4 messages received over DHCPv6.
+    std::vector<isc::dhcp::OptionBuffer> responses4o6_;
+
+protected:
+    virtual isc::dhcp::Pkt4Ptr receivePacket(int timeout);
+
+    /// \brief Records the responses instead of sending them.
+    virtual void sendPackets(const isc::dhcp::Pkt4Collection& packets,
+                             size_t& sent);
+
+private:
+    /// Query to be returned by the next receivePacket() call.
+    isc::dhcp::Pkt4Ptr query_;
+};
+
+/// \brief DHCPv6 server processing the packets handed to it.
+///
+/// Like \ref ReplayDhcpv4Srv, with the DHCPv4 messages of the
+/// DHCPv4-queries collected instead of being passed to the DHCPv4
+/// server.
+class ReplayDhcpv6Srv : public isc::dhcp::Dhcpv6Srv {
+public:
+    /// \brief Constructor, doesn't open any sockets.
+    ReplayDhcpv6Srv();
+
+    /// \brief Processes a query.
+    ///
+    /// \param query query (not unpacked)
+    void process(const isc::dhcp::Pkt6Ptr& query);
+
+    /// \brief Time of the last response sent.
+    double response_time_;
+
+    /// \brief Number of responses sent.
+    size_t responses_;
+
+    /// \brief DHCPv4 messages to be passed to the DHCPv4 server.
+    std::vector<isc::dhcp::OptionBuffer> queries4o6_;
+
+protected:
+    virtual isc::dhcp::Pkt6Ptr receivePacket(int timeout);
+
+    /// \brief Records the responses instead of sending them.
+    virtual void sendPackets(const isc::dhcp::Pkt6Collection& packets,
+                             size_t& sent);
+    virtual bool forwardDHCPv4Query(const isc::dhcp::OptionBuffer& data);
+
+private:
+    /// Query to be returned by the next receivePacket() call.
+    isc::dhcp::Pkt6Ptr query_;
+};
+
+/// \brief Target processing the messages by servers in this process.
+///
+/// The messages are processed synchronously by \ref ReplayDhcpv4Srv and
+/// \ref ReplayDhcpv6Srv, so the latency of a message is the time the
+/// server spends on it (including the lease database), without the
+/// network and the kernel. The DHCPv4-queries are processed by the DHCPv6
+/// server, their DHCPv4 messages by the DHCPv4 server and the responses
+/// by the DHCPv6 server again, like with the UNIX sockets between the
+/// servers.
+///
+/// The servers use the memfile lease database, which is empty at the
+/// start of the replay.
+class ServerTarget : public ReplayTarget {
+public:
+    /// \brief Constructor.
+    ///
+    /// \param stats statistics to record the messages in
+    /// \param config configuration with the "Dhcp4" and "Dhcp6" maps
+    /// in the format of the server configuration; a server is created
+    /// only for the present maps
+    /// \param iface name of the interface the messages are received on
+    /// \throw isc::BadValue if the configuration is rejected
+    ServerTarget(ReplayStats& stats, isc::data::ConstElementPtr config,
+                 const std::string& iface);
+
+    /// \brief Destructor.
+    virtual ~ServerTarget();
+
+    /// \brief Processes the message.
+    ///
+    /// \throw isc::BadValue if there is no server for the message
+    virtual void send(const ReplayPacket& packet,
+                      const std::vector<uint8_t>& payload);
+
+    /// \brief Does nothing, the responses are recorded by send().
+    virtual void receive(double) {}
+
+    virtual bool pending() const {
+        return (false);
+    }
+
+private:
+    /// \brief Processes the messages passed between the servers.
+    void process4o6();
+
+    boost::scoped_ptr<ReplayDhcpv4Srv> srv4_;
+    boost::scoped_ptr<ReplayDhcpv6Srv> srv6_;
+    std::string iface_;
+};
+
+} // namespace replay
+} // namespace isc
+
+#endif // SERVER_TARGET_H
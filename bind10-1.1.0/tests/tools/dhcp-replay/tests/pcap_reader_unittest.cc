@@ -0,0 +1,225 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include "../pcap_reader.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace isc::replay;
+using namespace std;
+
+namespace {
+
+const char* CAPTURE_FILE = "pcap_reader_test.pcap";
+
+/// \brief Writes capture files for the tests.
+class PcapReaderTest : public ::testing::Test {
+public:
+    ~PcapReaderTest() {
+        remove(CAPTURE_FILE);
+    }
+
+    /// \brief Appends a 16 bit value in the network byte order.
+    static void add16(vector<uint8_t>& data, uint16_t value) {
+        data.push_back(value >> 8);
+        data.push_back(value & 0xff);
+    }
+
+    /// \brief Appends a 32 bit value in the given byte order.
+    static void add32(vector<uint8_t>& data, uint32_t value, bool big) {
+        for (int i = 0; i < 4; ++i) {
+            data.push_back(value >> (big ? 24 - 8 * i : 8 * i));
+        }
+    }
+
+    /// \brief Returns an UDP datagram with a 3 octet payload.
+    static vector<uint8_t> udp(uint16_t src_port, uint16_t dst_port) {
+        vector<uint8_t> data;
+        add16(data, src_port);
+        add16(data, dst_port);
+        add16(data, 11);
+        add16(data, 0);
+        data.push_back(1);
+        data.push_back(2);
+        data.push_back(3);
+        return (data);
+    }
+
+    /// \brief Returns an IPv4 packet 192.0.2.1 -> 192.0.2.2.
+    static vector<uint8_t> ipv4(const vector<uint8_t>& payload,
+                                uint8_t protocol = 17,
+                                uint16_t fragment = 0) {
+        vector<uint8_t> data;
+        data.push_back(0x45);
+        data.push_back(0);
+        add16(data, 20 + payload.size());
+        add16(data, 0);
+        add16(data, fragment);
+        data.push_back(64);
+        data.push_back(protocol);
+        add16(data, 0);
+        const uint8_t addrs[] = { 192, 0, 2, 1, 192, 0, 2, 2 };
+        data.insert(data.end(), addrs, addrs + sizeof(addrs));
+        data.insert(data.end(), payload.begin(), payload.end());
+        return (data);
+    }
+
+    /// \brief Returns an IPv6 packet fe80::1 -> ff02::1:2 with
+    /// a hop-by-hop options header.
+    static vector<uint8_t> ipv6(const vector<uint8_t>& payload) {
+        vector<uint8_t> data;
+        add32(data, 0x60000000, true);
+        add16(data, 8 + payload.size());
+        data.push_back(0);
+        data.push_back(1);
+        uint8_t addrs[32] = { 0xfe, 0x80 };
+        addrs[15] = 1;
+        addrs[16] = 0xff;
+        addrs[17] = 0x02;
+        addrs[29] = 1;
+        addrs[31] = 2;
+        data.insert(data.end(), addrs, addrs + sizeof(addrs));
+        const uint8_t hop_by_hop[] = { 17, 0, 1, 4, 0, 0, 0, 0 };
+        data.insert(data.end(), hop_by_hop, hop_by_hop + sizeof(hop_by_hop));
+        data.insert(data.end(), payload.begin(), payload.end());
+        return (data);
+    }
+
+    /// \brief Returns an Ethernet frame, with a VLAN tag if requested.
+    static vector<uint8_t> ethernet(const vector<uint8_t>& packet, bool v6,
+                                    bool vlan = false) {
+        vector<uint8_t> data(12, 0);
+        if (vlan) {
+            add16(data, 0x8100);
+            add16(data, 10);
+        }
+        add16(data, v6 ? 0x86dd : 0x0800);
+        data.insert(data.end(), packet.begin(), packet.end());
+        return (data);
+    }
+
+    /// \brief Writes the capture file.
+    ///
+    /// \param frames captured frames, the n-th frame captured at n.5 s
+    /// \param link_type link type of the capture
+    /// \param big true to write the headers in the big endian order
+    static void write(const vector<vector<uint8_t> >& frames,
+                      uint32_t link_type = 1, bool big = false) {
+        vector<uint8_t> data;
+        add32(data, 0xa1b2c3d4, big);
+        data.push_back(big ? 0 : 2);
+        data.push_back(big ? 2 : 0);
+        data.push_back(big ? 0 : 4);
+        data.push_back(big ? 4 : 0);
+        add32(data, 0, big);
+        add32(data, 0, big);
+        add32(data, 65535, big);
+        add32(data, link_type, big);
+        for (size_t i = 0; i < frames.size(); ++i) {
+            add32(data, i, big);
+            add32(data, 500000, big);
+            add32(data, frames[i].size(), big);
+            add32(data, frames[i].size(), big);
+            data.insert(data.end(), frames[i].begin(), frames[i].end());
+        }
+        ofstream file(CAPTURE_FILE, ios::out | ios::binary | ios::trunc);
+        file.write(reinterpret_cast<const char*>(&data[0]), data.size());
+    }
+};
+
+// Checks that the datagrams are extracted from the Ethernet frames and
+// the other frames are skipped.
+TEST_F(PcapReaderTest, ethernet) {
+    vector<vector<uint8_t> > frames;
+    frames.push_back(ethernet(ipv4(udp(68, 67)), false));
+    // TCP segment.
+    frames.push_back(ethernet(ipv4(udp(1, 2), 6), false));
+    // IPv4 fragment.
+    frames.push_back(ethernet(ipv4(udp(68, 67), 17, 0x2000), false));
+    frames.push_back(ethernet(ipv6(udp(546, 547)), true, true));
+    write(frames);
+
+    PcapReader reader(CAPTURE_FILE);
+    Datagram datagram;
+    ASSERT_TRUE(reader.next(datagram));
+    EXPECT_DOUBLE_EQ(0.5, datagram.time_);
+    EXPECT_EQ("192.0.2.1", datagram.src_addr_.toText());
+    EXPECT_EQ("192.0.2.2", datagram.dst_addr_.toText());
+    EXPECT_EQ(68, datagram.src_port_);
+    EXPECT_EQ(67, datagram.dst_port_);
+    ASSERT_EQ(3, datagram.payload_.size());
+    EXPECT_EQ(3, datagram.payload_[2]);
+
+    ASSERT_TRUE(reader.next(datagram));
+    EXPECT_DOUBLE_EQ(3.5, datagram.time_);
+    EXPECT_EQ("fe80::1", datagram.src_addr_.toText());
+    EXPECT_EQ("ff02::1:2", datagram.dst_addr_.toText());
+    EXPECT_EQ(547, datagram.dst_port_);
+    EXPECT_EQ(3, datagram.payload_.size());
+
+    EXPECT_FALSE(reader.next(datagram));
+    EXPECT_EQ(2, reader.getSkipped());
+}
+
+// Checks the other link types and the byte order of the file.
+TEST_F(PcapReaderTest, linkTypes) {
+    vector<vector<uint8_t> > frames;
+    frames.push_back(ipv4(udp(68, 67)));
+    write(frames, 101, true);
+    {
+        PcapReader reader(CAPTURE_FILE);
+        Datagram datagram;
+        ASSERT_TRUE(reader.next(datagram));
+        EXPECT_EQ(67, datagram.dst_port_);
+        EXPECT_FALSE(reader.next(datagram));
+    }
+
+    // Linux cooked capture.
+    vector<uint8_t> sll(14, 0);
+    PcapReaderTest::add16(sll, 0x86dd);
+    const vector<uint8_t> packet = ipv6(udp(546, 547));
+    sll.insert(sll.end(), packet.begin(), packet.end());
+    frames[0] = sll;
+    write(frames, 113);
+    {
+        PcapReader reader(CAPTURE_FILE);
+        Datagram datagram;
+        ASSERT_TRUE(reader.next(datagram));
+        EXPECT_EQ(546, datagram.src_port_);
+    }
+}
+
+// Checks that invalid files are rejected.
+TEST_F(PcapReaderTest, invalid) {
+    EXPECT_THROW(PcapReader("no-such-file.pcap"), PcapError);
+
+    // Unsupported link type.
+    write(vector<vector<uint8_t> >(), 105);
+    EXPECT_THROW(PcapReader reader(CAPTURE_FILE), PcapError);
+
+    // Not a capture file at all.
+    ofstream file(CAPTURE_FILE, ios::out | ios::trunc);
+    file << "this is not a capture file";
+    file.close();
+    EXPECT_THROW(PcapReader reader(CAPTURE_FILE), PcapError);
+}
+
+}
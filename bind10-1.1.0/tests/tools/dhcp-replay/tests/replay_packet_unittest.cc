@@ -0,0 +1,246 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include "../replay_packet.h"
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace isc::replay;
+using namespace std;
+
+namespace {
+
+/// \brief Builds the messages for the tests.
+class ReplayPacketTest : public ::testing::Test {
+public:
+    /// \brief Returns a DHCPv4 message with the hardware address
+    /// 00:01:02:03:04:05, the xid 0x11223344 and the client identifier
+    /// 01:02:03:04.
+    static vector<uint8_t> message4(uint8_t op, uint8_t type) {
+        vector<uint8_t> data(240, 0);
+        data[0] = op;
+        data[1] = 1;
+        data[2] = 6;
+        data[4] = 0x11;
+        data[5] = 0x22;
+        data[6] = 0x33;
+        data[7] = 0x44;
+        for (int i = 0; i < 6; ++i) {
+            data[28 + i] = i;
+        }
+        data[236] = 99;
+        data[237] = 130;
+        data[238] = 83;
+        data[239] = 99;
+        const uint8_t options[] = {
+            DHO_DHCP_MESSAGE_TYPE, 1, type,
+            DHO_DHCP_CLIENT_IDENTIFIER, 4, 1, 2, 3, 4,
+            DHO_END
+        };
+        data.insert(data.end(), options, options + sizeof(options));
+        return (data);
+    }
+
+    /// \brief Returns a DHCPv6 message with the transaction id 0xabcdef
+    /// and the client DUID 00:01:02:03.
+    static vector<uint8_t> message6(uint8_t type) {
+        const uint8_t data[] = {
+            type, 0xab, 0xcd, 0xef,
+            0, D6O_CLIENTID, 0, 4, 0, 1, 2, 3
+        };
+        return (vector<uint8_t>(data, data + sizeof(data)));
+    }
+
+    /// \brief Returns the message encapsulated in an option.
+    ///
+    /// \param header header of the encapsulating message
+    /// \param code code of the option holding the message
+    /// \param message encapsulated message
+    static vector<uint8_t> encapsulate(const vector<uint8_t>& header,
+                                       uint16_t code,
+                                       const vector<uint8_t>& message) {
+        vector<uint8_t> data(header);
+        data.push_back(code >> 8);
+        data.push_back(code & 0xff);
+        data.push_back(message.size() >> 8);
+        data.push_back(message.size() & 0xff);
+        data.insert(data.end(), message.begin(), message.end());
+        return (data);
+    }
+
+    /// \brief Returns a relay-forward holding the message.
+    static vector<uint8_t> relay(const vector<uint8_t>& message) {
+        vector<uint8_t> header(34, 0);
+        header[0] = DHCPV6_RELAY_FORW;
+        return (encapsulate(header, D6O_RELAY_MSG, message));
+    }
+
+    /// \brief Returns a DHCPv4-query (or response) holding the message.
+    static vector<uint8_t> query4o6(const vector<uint8_t>& message,
+                                    uint8_t type = DHCPV4_QUERY) {
+        vector<uint8_t> header(4, 0);
+        header[0] = type;
+        header[1] = 0x80;
+        return (encapsulate(header, OPTION_DHCPV4_MSG, message));
+    }
+
+    /// \brief Returns the packet made from the payload sent to the port.
+    static ReplayPacketPtr packet(const vector<uint8_t>& payload,
+                                  uint16_t port) {
+        Datagram datagram;
+        datagram.time_ = 1.5;
+        datagram.src_addr_ = IOAddress("fe80::1");
+        datagram.dst_addr_ = IOAddress("ff02::1:2");
+        datagram.src_port_ = port + 1;
+        datagram.dst_port_ = port;
+        datagram.payload_ = payload;
+        return (ReplayPacket::fromDatagram(datagram));
+    }
+};
+
+// Checks the classification of the client messages.
+TEST_F(ReplayPacketTest, fromDatagram) {
+    ReplayPacketPtr p = packet(message4(BOOTREQUEST, DHCPDISCOVER), 67);
+    ASSERT_TRUE(p);
+    EXPECT_EQ(ReplayPacket::DHCPV4, p->getProtocol());
+    EXPECT_EQ("DISCOVER", p->getClassName());
+    EXPECT_DOUBLE_EQ(1.5, p->getTime());
+    EXPECT_EQ("fe80::1", p->getSrcAddr().toText());
+    EXPECT_EQ("ff02::1:2", p->getDstAddr().toText());
+    EXPECT_TRUE(p->getPayload() == message4(BOOTREQUEST, DHCPDISCOVER));
+
+    p = packet(message6(DHCPV6_SOLICIT), 547);
+    ASSERT_TRUE(p);
+    EXPECT_EQ(ReplayPacket::DHCPV6, p->getProtocol());
+    EXPECT_EQ("SOLICIT", p->getClassName());
+
+    p = packet(relay(relay(message6(DHCPV6_RENEW))), 547);
+    ASSERT_TRUE(p);
+    EXPECT_EQ(ReplayPacket::DHCPV6, p->getProtocol());
+    EXPECT_EQ("RELAY-FORW(RELAY-FORW(RENEW))", p->getClassName());
+
+    p = packet(query4o6(message4(BOOTREQUEST, DHCPREQUEST)), 547);
+    ASSERT_TRUE(p);
+    EXPECT_EQ(ReplayPacket::DHCPV4_OVER_DHCPV6, p->getProtocol());
+    EXPECT_EQ("DHCPV4-QUERY(REQUEST)", p->getClassName());
+
+    // The messages sent by the servers and the other traffic are ignored.
+    EXPECT_FALSE(packet(message4(BOOTREPLY, DHCPOFFER), 67));
+    EXPECT_FALSE(packet(message4(BOOTREQUEST, DHCPDISCOVER), 68));
+    EXPECT_FALSE(packet(message6(DHCPV6_ADVERTISE), 547));
+    EXPECT_FALSE(packet(query4o6(message4(BOOTREPLY, DHCPACK),
+                                 DHCPV4_RESPONSE), 547));
+    EXPECT_FALSE(packet(message6(DHCPV6_SOLICIT), 546));
+    EXPECT_FALSE(packet(vector<uint8_t>(2, 1), 547));
+}
+
+// Checks the rewriting of the DHCPv4 clients.
+TEST_F(ReplayPacketTest, makeCopy4) {
+    const vector<uint8_t> original = message4(BOOTREQUEST, DHCPDISCOVER);
+    ReplayPacketPtr p = packet(original, 67);
+    ASSERT_TRUE(p);
+
+    vector<uint8_t> payload;
+    p->makeCopy(0, payload);
+    EXPECT_TRUE(payload == original);
+
+    p->makeCopy(0x010203, payload);
+    ASSERT_EQ(original.size(), payload.size());
+    vector<uint8_t> expected(original);
+    // xid
+    expected[5] ^= 1;
+    expected[6] ^= 2;
+    expected[7] ^= 3;
+    // chaddr
+    expected[31] ^= 1;
+    expected[32] ^= 2;
+    expected[33] ^= 3;
+    // client identifier
+    expected[246] ^= 1;
+    expected[247] ^= 2;
+    expected[248] ^= 3;
+    EXPECT_TRUE(payload == expected);
+}
+
+// Checks the rewriting of the DHCPv6 clients, relayed or not.
+TEST_F(ReplayPacketTest, makeCopy6) {
+    const vector<uint8_t> original = message6(DHCPV6_REQUEST);
+    vector<uint8_t> expected(original);
+    expected[1] ^= 1;
+    expected[2] ^= 2;
+    expected[3] ^= 3;
+    expected[9] ^= 1;
+    expected[10] ^= 2;
+    expected[11] ^= 3;
+
+    vector<uint8_t> payload;
+    packet(original, 547)->makeCopy(0x010203, payload);
+    EXPECT_TRUE(payload == expected);
+
+    // Only the relayed message is rewritten.
+    packet(relay(original), 547)->makeCopy(0x010203, payload);
+    EXPECT_TRUE(payload == relay(expected));
+}
+
+// Checks the rewriting of the DHCPv4-queries.
+TEST_F(ReplayPacketTest, makeCopy4o6) {
+    const vector<uint8_t> message = message4(BOOTREQUEST, DHCPREQUEST);
+    ReplayPacketPtr p = packet(query4o6(message), 547);
+    ASSERT_TRUE(p);
+
+    vector<uint8_t> copy4;
+    packet(message, 67)->makeCopy(5, copy4);
+    vector<uint8_t> payload;
+    p->makeCopy(5, payload);
+    // The flags of the query are unchanged.
+    EXPECT_TRUE(payload == query4o6(copy4));
+}
+
+// Checks that the responses match their queries.
+TEST_F(ReplayPacketTest, getMatchKey) {
+    uint32_t key = 0;
+    vector<uint8_t> data = message4(BOOTREPLY, DHCPOFFER);
+    ASSERT_TRUE(ReplayPacket::getMatchKey(false, &data[0], data.size(), key));
+    EXPECT_EQ(0x11223344, key);
+    EXPECT_FALSE(ReplayPacket::getMatchKey(false, &data[0], 7, key));
+
+    data = message6(DHCPV6_REPLY);
+    ASSERT_TRUE(ReplayPacket::getMatchKey(true, &data[0], data.size(), key));
+    EXPECT_EQ(0xabcdef, key);
+
+    data = relay(message6(DHCPV6_ADVERTISE));
+    data[0] = DHCPV6_RELAY_REPL;
+    ASSERT_TRUE(ReplayPacket::getMatchKey(true, &data[0], data.size(), key));
+    EXPECT_EQ(0xabcdef, key);
+
+    data = query4o6(message4(BOOTREPLY, DHCPACK), DHCPV4_RESPONSE);
+    ASSERT_TRUE(ReplayPacket::getMatchKey(true, &data[0], data.size(), key));
+    EXPECT_EQ(0x11223344, key);
+
+    // A relay message without the relayed message has no key.
+    data.assign(34, 0);
+    data[0] = DHCPV6_RELAY_REPL;
+    EXPECT_FALSE(ReplayPacket::getMatchKey(true, &data[0], data.size(), key));
+}
+
+}
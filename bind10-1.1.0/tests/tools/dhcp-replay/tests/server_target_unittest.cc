@@ -0,0 +1,154 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include "../server_target.h"
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace isc::asiolink;
+using namespace isc::data;
+using namespace isc::dhcp;
+using namespace isc::replay;
+using namespace std;
+
+namespace {
+
+/// \brief Configuration of both servers, with a subnet each.
+const char* SERVERS_CONFIG =
+    "{ \"Dhcp4\": { \"rebind-timer\": 2000,"
+    "               \"renew-timer\": 1000,"
+    "               \"subnet4\": [ {"
+    "                   \"pool\": [ \"192.0.2.1 - 192.0.2.100\" ],"
+    "                   \"subnet\": \"192.0.2.0/24\" } ],"
+    "               \"valid-lifetime\": 4000 },"
+    "  \"Dhcp6\": { \"preferred-lifetime\": 3000,"
+    "               \"rebind-timer\": 2000,"
+    "               \"renew-timer\": 1000,"
+    "               \"subnet6\": [ {"
+    "                   \"pool\": [ \"2001:db8:1::/80\" ],"
+    "                   \"subnet\": \"2001:db8:1::/64\" } ],"
+    "               \"valid-lifetime\": 4000 } }";
+
+/// \brief Runs the exchanges with the servers of a \ref ServerTarget.
+class ServerTargetTest : public ::testing::Test {
+public:
+    /// \brief Constructor, creates the target.
+    ServerTargetTest() :
+        target_(stats_, Element::fromJSON(SERVERS_CONFIG), "eth0")
+    {}
+
+    /// \brief Returns a DHCPDISCOVER with the hardware address
+    /// 00:01:02:03:04:05.
+    static vector<uint8_t> discover() {
+        vector<uint8_t> data(240, 0);
+        data[0] = BOOTREQUEST;
+        data[1] = HTYPE_ETHER;
+        data[2] = 6;
+        data[4] = 0x11;
+        data[5] = 0x22;
+        data[6] = 0x33;
+        data[7] = 0x44;
+        for (int i = 0; i < 6; ++i) {
+            data[28 + i] = i;
+        }
+        data[236] = 99;
+        data[237] = 130;
+        data[238] = 83;
+        data[239] = 99;
+        data.push_back(DHO_DHCP_MESSAGE_TYPE);
+        data.push_back(1);
+        data.push_back(DHCPDISCOVER);
+        data.push_back(DHO_END);
+        return (data);
+    }
+
+    /// \brief Returns the packet made from the payload sent to the port.
+    static ReplayPacketPtr packet(const vector<uint8_t>& payload,
+                                  uint16_t port, const string& src,
+                                  const string& dst) {
+        Datagram datagram;
+        datagram.time_ = 1.5;
+        datagram.src_addr_ = IOAddress(src);
+        datagram.dst_addr_ = IOAddress(dst);
+        datagram.src_port_ = port + 1;
+        datagram.dst_port_ = port;
+        datagram.payload_ = payload;
+        return (ReplayPacket::fromDatagram(datagram));
+    }
+
+    /// \brief Statistics of the target.
+    ReplayStats stats_;
+
+    /// \brief Tested target.
+    ServerTarget target_;
+};
+
+// Checks a DHCPv4 exchange is processed and answered.
+TEST_F(ServerTargetTest, discover) {
+    ReplayPacketPtr p = packet(discover(), DHCP4_SERVER_PORT, "192.0.2.200",
+                               "255.255.255.255");
+    ASSERT_TRUE(p);
+
+    target_.send(*p, p->getPayload());
+    EXPECT_EQ(1, stats_.getSent("DISCOVER"));
+    EXPECT_EQ(1, stats_.getAnswered("DISCOVER"));
+    EXPECT_FALSE(target_.pending());
+}
+
+// Checks a DHCPv6 exchange is processed and answered.
+TEST_F(ServerTargetTest, solicit) {
+    const uint8_t data[] = {
+        DHCPV6_SOLICIT, 0xab, 0xcd, 0xef,
+        0, D6O_CLIENTID, 0, 10, 0, 3, 0, 1, 0, 1, 2, 3, 4, 5
+    };
+    ReplayPacketPtr p = packet(vector<uint8_t>(data, data + sizeof(data)),
+                               DHCP6_SERVER_PORT, "fe80::1", "ff02::1:2");
+    ASSERT_TRUE(p);
+
+    target_.send(*p, p->getPayload());
+    EXPECT_EQ(1, stats_.getSent("SOLICIT"));
+    EXPECT_EQ(1, stats_.getAnswered("SOLICIT"));
+    EXPECT_FALSE(target_.pending());
+}
+
+// Checks the DHCPv4 message of a DHCPv4-query is processed by the DHCPv4
+// server and its response is sent back by the DHCPv6 server.
+TEST_F(ServerTargetTest, dhcpv4Query) {
+    const vector<uint8_t> message = discover();
+    vector<uint8_t> data(4, 0);
+    data[0] = DHCPV4_QUERY;
+    data[1] = 0x80;
+    data.push_back(OPTION_DHCPV4_MSG >> 8);
+    data.push_back(OPTION_DHCPV4_MSG & 0xff);
+    data.push_back(message.size() >> 8);
+    data.push_back(message.size() & 0xff);
+    data.insert(data.end(), message.begin(), message.end());
+    ReplayPacketPtr p = packet(data, DHCP6_SERVER_PORT, "fe80::1",
+                               "ff02::1:2");
+    ASSERT_TRUE(p);
+
+    target_.send(*p, p->getPayload());
+    EXPECT_EQ(1, stats_.getSent("DHCPV4-QUERY(DISCOVER)"));
+    EXPECT_EQ(1, stats_.getAnswered("DHCPV4-QUERY(DISCOVER)"));
+    EXPECT_FALSE(target_.pending());
+}
+
+}
@@ -0,0 +1,234 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "udp_target.h"
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+#include <exceptions/exceptions.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+/// Bit distinguishing the keys of the DHCPv6 messages.
+const uint64_t V6_KEY = 1ULL << 32;
+
+/// Size of the receive buffer, large enough for any DHCP message.
+const size_t RECEIVE_BUFFER_SIZE = 65536;
+
+}
+
+namespace isc {
+namespace replay {
+
+UdpTarget::UdpTarget(ReplayStats& stats, const std::string& server4,
+                     const std::string& server6, uint16_t port4,
+                     uint16_t port6, double timeout) :
+    ReplayTarget(stats), server4_(server4), server6_(server6),
+    socket4_(-1), socket6_(-1), timeout_(timeout), last_expire_(0)
+{
+    if (!server4_.empty()) {
+        socket4_ = openSocket(AF_INET, port4);
+    }
+    if (!server6_.empty()) {
+        try {
+            socket6_ = openSocket(AF_INET6, port6);
+        } catch (...) {
+            if (socket4_ >= 0) {
+                close(socket4_);
+            }
+            throw;
+        }
+    }
+}
+
+UdpTarget::~UdpTarget() {
+    if (socket4_ >= 0) {
+        close(socket4_);
+    }
+    if (socket6_ >= 0) {
+        close(socket6_);
+    }
+}
+
+int
+UdpTarget::openSocket(int family, uint16_t port) {
+    const int sock = socket(family, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        isc_throw(isc::Unexpected, "unable to open a socket: "
+                  << strerror(errno));
+    }
+    int result;
+    if (family == AF_INET) {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        result = bind(sock, reinterpret_cast<struct sockaddr*>(&addr),
+                      sizeof(addr));
+    } else {
+        struct sockaddr_in6 addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin6_family = AF_INET6;
+        addr.sin6_port = htons(port);
+        addr.sin6_addr = in6addr_any;
+        result = bind(sock, reinterpret_cast<struct sockaddr*>(&addr),
+                      sizeof(addr));
+    }
+    if ((result < 0) || (fcntl(sock, F_SETFL, O_NONBLOCK) < 0)) {
+        const int error = errno;
+        close(sock);
+        isc_throw(isc::Unexpected, "unable to bind a socket to port "
+                  << port << ": " << strerror(error));
+    }
+    return (sock);
+}
+
+void
+UdpTarget::send(const ReplayPacket& packet,
+                const std::vector<uint8_t>& payload) {
+    const bool v6 = (packet.getProtocol() != ReplayPacket::DHCPV4);
+    const int sock = v6 ? socket6_ : socket4_;
+    if (sock < 0) {
+        isc_throw(isc::BadValue, "no " << (v6 ? "DHCPv6" : "DHCPv4")
+                  << " server to send " << packet.getClassName() << " to");
+    }
+
+    int result;
+    if (v6) {
+        struct sockaddr_in6 addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin6_family = AF_INET6;
+        addr.sin6_port = htons(DHCP6_SERVER_PORT);
+        inet_pton(AF_INET6, server6_.c_str(), &addr.sin6_addr);
+        result = sendto(sock, &payload[0], payload.size(), 0,
+                        reinterpret_cast<struct sockaddr*>(&addr),
+                        sizeof(addr));
+    } else {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(isc::dhcp::DHCP4_SERVER_PORT);
+        inet_pton(AF_INET, server4_.c_str(), &addr.sin_addr);
+        result = sendto(sock, &payload[0], payload.size(), 0,
+                        reinterpret_cast<struct sockaddr*>(&addr),
+                        sizeof(addr));
+    }
+    stats_.sent(packet.getClassName());
+    // A message which couldn't be sent (e.g. because the socket buffer
+    // is full) is counted as sent and never answered.
+    uint32_t key = 0;
+    if ((result >= 0) &&
+        ReplayPacket::getMatchKey(v6, &payload[0], payload.size(), key)) {
+        Pending message = { &packet.getClassName(), currentTime() };
+        pending_.insert(std::make_pair(v6 ? (V6_KEY | key) : key, message));
+    }
+}
+
+void
+UdpTarget::receive(double timeout) {
+    const double deadline = currentTime() + timeout;
+    for (;;) {
+        fd_set sockets;
+        FD_ZERO(&sockets);
+        const int max_socket = std::max(socket4_, socket6_);
+        if (socket4_ >= 0) {
+            FD_SET(socket4_, &sockets);
+        }
+        if (socket6_ >= 0) {
+            FD_SET(socket6_, &sockets);
+        }
+        const double wait = std::max(deadline - currentTime(), 0.0);
+        struct timeval select_timeout;
+        select_timeout.tv_sec = static_cast<long>(wait);
+        select_timeout.tv_usec =
+            static_cast<long>((wait - select_timeout.tv_sec) * 1e6);
+        const int ready = select(max_socket + 1, &sockets, NULL, NULL,
+                                 &select_timeout);
+        if (ready <= 0) {
+            break;
+        }
+        if ((socket4_ >= 0) && FD_ISSET(socket4_, &sockets)) {
+            receiveResponse(socket4_, false);
+        }
+        if ((socket6_ >= 0) && FD_ISSET(socket6_, &sockets)) {
+            receiveResponse(socket6_, true);
+        }
+        if (pending_.empty()) {
+            break;
+        }
+    }
+    expire(currentTime());
+}
+
+void
+UdpTarget::receiveResponse(int socket, bool v6) {
+    static uint8_t buffer[RECEIVE_BUFFER_SIZE];
+    for (;;) {
+        const ssize_t length = recv(socket, buffer, sizeof(buffer), 0);
+        if (length <= 0) {
+            return;
+        }
+        const double now = currentTime();
+        uint32_t key = 0;
+        if (!ReplayPacket::getMatchKey(v6, buffer, length, key)) {
+            continue;
+        }
+        // The oldest message with the key is the one answered.
+        const uint64_t full_key = v6 ? (V6_KEY | key) : key;
+        PendingMap::iterator first = pending_.lower_bound(full_key);
+        PendingMap::iterator message = first;
+        for (PendingMap::iterator it = first;
+             (it != pending_.end()) && (it->first == full_key); ++it) {
+            if (it->second.time_ < message->second.time_) {
+                message = it;
+            }
+        }
+        if ((message != pending_.end()) && (message->first == full_key)) {
+            stats_.answered(*message->second.class_name_,
+                            now - message->second.time_);
+            pending_.erase(message);
+        }
+    }
+}
+
+void
+UdpTarget::expire(double now) {
+    if (now - last_expire_ < 1) {
+        return;
+    }
+    last_expire_ = now;
+    for (PendingMap::iterator message = pending_.begin();
+         message != pending_.end(); ) {
+        if (now - message->second.time_ > timeout_) {
+            pending_.erase(message++);
+        } else {
+            ++message;
+        }
+    }
+}
+
+} // namespace replay
+} // namespace isc
@@ -0,0 +1,105 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef UDP_TARGET_H
+#define UDP_TARGET_H
+
+#include "replay_target.h"
+
+#include <map>
+#include <string>
+
+namespace isc {
+namespace replay {
+
+/// \brief Target sending the messages to the servers over UDP.
+///
+/// The DHCPv4 messages are sent to port 67 of the DHCPv4 server, the
+/// DHCPv6 messages and the DHCPv4-queries to port 547 of the DHCPv6
+/// server. The responses are received on the client ports (68 and 546)
+/// by default, which is where the servers send them for the messages not
+/// relayed, so the target usually has to run as root.
+///
+/// The responses are matched to the messages by the keys returned by
+/// \ref ReplayPacket::getMatchKey. Messages not answered within the
+/// timeout are forgotten.
+class UdpTarget : public ReplayTarget {
+public:
+    /// \brief Constructor.
+    ///
+    /// \param stats statistics to record the messages in
+    /// \param server4 address of the DHCPv4 server, empty if none
+    /// \param server6 address of the DHCPv6 server, empty if none
+    /// \param port4 local port of the DHCPv4 socket
+    /// \param port6 local port of the DHCPv6 socket
+    /// \param timeout time to wait for a response in seconds
+    /// \throw isc::Unexpected if a socket can't be opened
+    UdpTarget(ReplayStats& stats, const std::string& server4,
+              const std::string& server6, uint16_t port4, uint16_t port6,
+              double timeout);
+
+    /// \brief Destructor, closes the sockets.
+    virtual ~UdpTarget();
+
+    /// \brief Sends the message.
+    ///
+    /// \throw isc::BadValue if there is no server for the protocol of the
+    /// message
+    virtual void send(const ReplayPacket& packet,
+                      const std::vector<uint8_t>& payload);
+
+    virtual void receive(double timeout);
+
+    virtual bool pending() const {
+        return (!pending_.empty());
+    }
+
+private:
+    /// \brief Message waiting for a response.
+    struct Pending {
+        const std::string* class_name_;
+        double time_;
+    };
+
+    /// \brief Messages waiting for responses, indexed by the match key
+    /// (the key of DHCPv6 messages has the bit 32 set).
+    typedef std::multimap<uint64_t, Pending> PendingMap;
+
+    /// \brief Opens a socket bound to the port.
+    static int openSocket(int family, uint16_t port);
+
+    /// \brief Receives a response on the socket and matches it.
+    void receiveResponse(int socket, bool v6);
+
+    /// \brief Drops the messages waiting longer than the timeout.
+    void expire(double now);
+
+    /// Addresses of the servers.
+    std::string server4_;
+    std::string server6_;
+    /// Sockets (-1 if there is no server).
+    int socket4_;
+    int socket6_;
+    /// Time to wait for a response.
+    double timeout_;
+    /// Messages waiting for responses.
+    PendingMap pending_;
+    /// Time of the last expiration.
+    double last_expire_;
+};
+
+} // namespace replay
+} // namespace isc
+
+#endif // UDP_TARGET_H
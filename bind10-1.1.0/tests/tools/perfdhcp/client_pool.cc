@@ -0,0 +1,225 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <exceptions/exceptions.h>
+
+#include "client_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace isc {
+namespace perfdhcp {
+
+const uint32_t ClientPool::TICK_MS;
+const uint32_t ClientPool::WHEEL_SLOTS;
+
+ClientPool::ClientPool(const uint32_t size, const size_t address_len,
+                       const std::vector<uint8_t>& mac_template,
+                       const uint32_t timeout_ms)
+    : state_(size, FREE), release_(size, 0), timer_(size, 0),
+      rebind_(size, 0), expire_(size, 0), address_len_(address_len),
+      mac_template_(mac_template), timeout_ms_(timeout_ms),
+      wheel_(WHEEL_SLOTS) {
+    if (size == 0) {
+        isc_throw(isc::BadValue, "number of simulated clients must be"
+                  " positive");
+    }
+    if ((address_len != 4) && (address_len != 16)) {
+        isc_throw(isc::BadValue, "invalid length of the leased address "
+                  << address_len);
+    }
+    if (mac_template.size() < 4) {
+        isc_throw(isc::BadValue, "MAC address template is too short");
+    }
+    addresses_.resize(static_cast<size_t>(size) * address_len);
+    // The clients are taken from the back, so the client 0 is the first.
+    free_.reserve(size);
+    for (uint32_t i = size; i > 0; --i) {
+        free_.push_back(i - 1);
+    }
+    std::fill(counts_, counts_ + STATES_NUM, 0);
+    counts_[FREE] = size;
+}
+
+bool
+ClientPool::acquire(const uint64_t now, uint32_t& index) {
+    // The list may hold clients which left the FREE state without being
+    // taken from it (e.g. when a late response has been received).
+    while (!free_.empty()) {
+        index = free_.back();
+        free_.pop_back();
+        if (getState(index) == FREE) {
+            setState(index, SELECTING, now);
+            return (true);
+        }
+    }
+    return (false);
+}
+
+void
+ClientPool::setState(const uint32_t index, const State state,
+                     const uint64_t now) {
+    const State old_state = getState(index);
+    if ((old_state == FREE) && (state == FREE)) {
+        return;
+    }
+    --counts_[old_state];
+    ++counts_[state];
+    state_[index] = state;
+
+    switch (state) {
+    case FREE:
+        timer_[index] = 0;
+        free_.push_back(index);
+        break;
+    case SELECTING:
+    case REQUESTING:
+    case RELEASING:
+    case DECLINING:
+        startTimer(index, toTicks(now + timeout_ms_));
+        break;
+    default:
+        ;
+    }
+}
+
+void
+ClientPool::bind(const uint32_t index, const uint8_t* address, uint32_t t1,
+                 uint32_t t2, const uint32_t valid, const bool release,
+                 const uint64_t now) {
+    if (t1 == 0) {
+        t1 = valid / 2;
+    }
+    if (t2 == 0) {
+        t2 = valid / 8 * 7;
+    }
+    setState(index, BOUND, now);
+    memcpy(&addresses_[index * address_len_], address, address_len_);
+    release_[index] = release ? 1 : 0;
+    rebind_[index] = toTicks(now + t2 * 1000ULL);
+    expire_[index] = toTicks(now + valid * 1000ULL);
+    startTimer(index, toTicks(now + t1 * 1000ULL));
+}
+
+std::vector<uint8_t>
+ClientPool::getMacAddress(const uint32_t index) const {
+    std::vector<uint8_t> mac(mac_template_);
+    uint32_t value = index;
+    for (std::vector<uint8_t>::iterator it = mac.end() - 1;
+         value > 0; --it) {
+        *it += static_cast<uint8_t>(value & 0xFF);
+        value >>= 8;
+    }
+    return (mac);
+}
+
+bool
+ClientPool::findClient(const std::vector<uint8_t>& mac,
+                       uint32_t& index) const {
+    if (mac.size() < mac_template_.size()) {
+        return (false);
+    }
+    // Only the trailing part of a DUID holds the MAC address.
+    std::vector<uint8_t>::const_iterator begin =
+        mac.end() - mac_template_.size();
+    if (!std::equal(mac_template_.begin(), mac_template_.end() - 4, begin)) {
+        return (false);
+    }
+    uint64_t value = 0;
+    for (size_t i = mac_template_.size() - 4; i < mac_template_.size();
+         ++i) {
+        value = (value << 8) |
+            static_cast<uint8_t>(begin[i] - mac_template_[i]);
+    }
+    if (value >= getSize()) {
+        return (false);
+    }
+    index = static_cast<uint32_t>(value);
+    return (true);
+}
+
+void
+ClientPool::getEvents(const uint64_t now,
+                      std::vector<std::pair<uint32_t, Event> >& events) {
+    expired_.clear();
+    wheel_.advance(toTicks(now), expired_);
+    for (size_t i = 0; i < expired_.size(); ++i) {
+        const uint32_t index = expired_[i].id_;
+        // The timer has been replaced or stopped since it was scheduled.
+        if (timer_[index] != expired_[i].due_) {
+            continue;
+        }
+        timer_[index] = 0;
+        switch (getState(index)) {
+        case BOUND:
+            if (release_[index]) {
+                events.push_back(std::make_pair(index, RELEASE));
+            } else {
+                setState(index, RENEWING, now);
+                startTimer(index, rebind_[index]);
+                events.push_back(std::make_pair(index, RENEW));
+            }
+            break;
+        case RENEWING:
+            setState(index, REBINDING, now);
+            startTimer(index, expire_[index]);
+            events.push_back(std::make_pair(index, REBIND));
+            break;
+        case REBINDING:
+            setState(index, FREE, now);
+            events.push_back(std::make_pair(index, EXPIRE));
+            break;
+        case FREE:
+            break;
+        default:
+            setState(index, FREE, now);
+            events.push_back(std::make_pair(index, TIMEOUT));
+        }
+    }
+}
+
+std::string
+ClientPool::stateToString(const State state) {
+    switch (state) {
+    case FREE:
+        return ("free");
+    case SELECTING:
+        return ("selecting");
+    case REQUESTING:
+        return ("requesting");
+    case BOUND:
+        return ("bound");
+    case RENEWING:
+        return ("renewing");
+    case REBINDING:
+        return ("rebinding");
+    case RELEASING:
+        return ("releasing");
+    case DECLINING:
+        return ("declining");
+    default:
+        ;
+    }
+    return ("unknown");
+}
+
+void
+ClientPool::startTimer(const uint32_t index, const uint32_t due) {
+    timer_[index] = wheel_.schedule(index, due);
+}
+
+} // namespace perfdhcp
+} // namespace isc
@@ -0,0 +1,238 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef CLIENT_POOL_H
+#define CLIENT_POOL_H
+
+#include "timer_wheel.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace perfdhcp {
+
+/// \brief Population of simulated DHCP clients.
+///
+/// The pool holds the state of the lease of each simulated client:
+/// whether the client has a lease, the leased address and the times at
+/// which the client renews, rebinds and loses the lease. The data is
+/// kept in arrays indexed by the number of the client rather than in
+/// objects, so a pool of millions of clients takes a few tens of octets
+/// per client.
+///
+/// The identity of the client is derived from its index: the index is
+/// added to the last four octets of the MAC address template, so the
+/// index of the client sending or receiving a packet can be calculated
+/// back from its MAC address (or the DUID which ends with it).
+///
+/// The times of the lease are measured in milliseconds since an
+/// arbitrary point chosen by the caller and the timers are scheduled
+/// in the \ref TimerWheel with the resolution of \ref TICK_MS.
+class ClientPool {
+public:
+    /// \brief State of the simulated client.
+    enum State {
+        FREE,        ///< No lease, may start a new exchange.
+        SELECTING,   ///< DISCOVER or SOLICIT sent.
+        REQUESTING,  ///< REQUEST sent.
+        BOUND,       ///< Lease obtained.
+        RENEWING,    ///< Lease being renewed (T1 passed).
+        REBINDING,   ///< Lease being rebound (T2 passed).
+        RELEASING,   ///< RELEASE sent, waiting for the reply.
+        DECLINING,   ///< DECLINE sent, waiting for the reply.
+        STATES_NUM   ///< Number of states.
+    };
+
+    /// \brief Event of the lease lifecycle.
+    enum Event {
+        RENEW,       ///< T1 passed, RENEWING entered.
+        REBIND,      ///< T2 passed, REBINDING entered.
+        RELEASE,     ///< T1 passed for the client releasing the lease.
+        EXPIRE,      ///< Lease expired, FREE entered.
+        TIMEOUT      ///< No response to DISCOVER, SOLICIT, REQUEST,
+                     ///< RELEASE or DECLINE, FREE entered.
+    };
+
+    /// Resolution of the timers in milliseconds.
+    static const uint32_t TICK_MS = 100;
+
+    /// Number of slots in the timer wheel (about 13 minutes).
+    static const uint32_t WHEEL_SLOTS = 8192;
+
+    /// \brief Constructor.
+    ///
+    /// Creates the pool in which all clients are FREE.
+    ///
+    /// \param size number of clients.
+    /// \param address_len length of the leased address (4 or 16).
+    /// \param mac_template MAC address of the client 0.
+    /// \param timeout_ms time after which the client waiting for the
+    /// response gives up and becomes FREE.
+    /// \throw isc::BadValue if the size is 0, the address length is
+    /// neither 4 nor 16 or the MAC template is shorter than 4 octets.
+    ClientPool(const uint32_t size, const size_t address_len,
+               const std::vector<uint8_t>& mac_template,
+               const uint32_t timeout_ms);
+
+    /// \brief Returns the number of clients.
+    uint32_t getSize() const { return (state_.size()); }
+
+    /// \brief Returns the number of clients in the state.
+    ///
+    /// \param state state of the clients.
+    uint32_t getCount(const State state) const { return (counts_[state]); }
+
+    /// \brief Returns the state of the client.
+    ///
+    /// \param index index of the client.
+    State getState(const uint32_t index) const {
+        return (static_cast<State>(state_[index]));
+    }
+
+    /// \brief Takes a FREE client to start a new exchange.
+    ///
+    /// The client enters the SELECTING state.
+    ///
+    /// \param now current time in milliseconds.
+    /// \param [out] index index of the client.
+    /// \return false if there are no FREE clients.
+    bool acquire(const uint64_t now, uint32_t& index);
+
+    /// \brief Changes the state of the client.
+    ///
+    /// For the states in which the client waits for the response the
+    /// timeout is started. For the FREE state the client is returned to
+    /// the pool of free clients.
+    ///
+    /// \param index index of the client.
+    /// \param state new state.
+    /// \param now current time in milliseconds.
+    void setState(const uint32_t index, const State state,
+                  const uint64_t now);
+
+    /// \brief Records the lease obtained or extended by the client.
+    ///
+    /// The client enters the BOUND state. Zero T1 and T2 are replaced
+    /// with 1/2 and 7/8 of the valid lifetime.
+    ///
+    /// \param index index of the client.
+    /// \param address leased address of the length given to the
+    /// constructor.
+    /// \param t1 renewal time in seconds.
+    /// \param t2 rebinding time in seconds.
+    /// \param valid valid lifetime in seconds.
+    /// \param release true if the client releases the lease at T1
+    /// instead of renewing it.
+    /// \param now current time in milliseconds.
+    void bind(const uint32_t index, const uint8_t* address, uint32_t t1,
+              uint32_t t2, const uint32_t valid, const bool release,
+              const uint64_t now);
+
+    /// \brief Returns the address leased by the client.
+    ///
+    /// \param index index of the client.
+    /// \return pointer to the address of the length given to the
+    /// constructor.
+    const uint8_t* getAddress(const uint32_t index) const {
+        return (&addresses_[index * address_len_]);
+    }
+
+    /// \brief Returns the MAC address of the client.
+    ///
+    /// \param index index of the client.
+    std::vector<uint8_t> getMacAddress(const uint32_t index) const;
+
+    /// \brief Finds the client using the MAC address.
+    ///
+    /// \param mac MAC address or DUID ending with the MAC address.
+    /// \param [out] index index of the client.
+    /// \return false if the address doesn't belong to a client.
+    bool findClient(const std::vector<uint8_t>& mac, uint32_t& index) const;
+
+    /// \brief Collects the lifecycle events due now.
+    ///
+    /// The clients are moved to the states given in the description
+    /// of the \ref Event, except that the state of the client releasing
+    /// the lease is left BOUND and is to be set by the caller once the
+    /// RELEASE is sent.
+    ///
+    /// \param now current time in milliseconds.
+    /// \param [out] events vector the pairs of the client index and the
+    /// event are appended to.
+    void getEvents(const uint64_t now,
+                   std::vector<std::pair<uint32_t, Event> >& events);
+
+    /// \brief Returns the name of the state.
+    ///
+    /// \param state state of the client.
+    static std::string stateToString(const State state);
+
+private:
+    /// \brief Converts the time in milliseconds to ticks.
+    ///
+    /// The times too far in the future (e.g. of the infinite leases)
+    /// are capped.
+    static uint32_t toTicks(const uint64_t ms) {
+        const uint64_t ticks = ms / TICK_MS + 1;
+        return (static_cast<uint32_t>(std::min<uint64_t>(ticks,
+            std::numeric_limits<uint32_t>::max())));
+    }
+
+    /// \brief Starts the single timer of the client.
+    void startTimer(const uint32_t index, const uint32_t due);
+
+    /// State of each client.
+    std::vector<uint8_t> state_;
+    /// Set for the clients releasing the lease at T1.
+    std::vector<uint8_t> release_;
+    /// Tick of the pending timer of each client, 0 if none.
+    std::vector<uint32_t> timer_;
+    /// Tick of T2 of each client.
+    std::vector<uint32_t> rebind_;
+    /// Tick at which the lease of each client expires.
+    std::vector<uint32_t> expire_;
+    /// Leased addresses.
+    std::vector<uint8_t> addresses_;
+    /// Indexes of the clients which entered the FREE state.
+    std::vector<uint32_t> free_;
+    /// Number of clients in each state.
+    uint32_t counts_[STATES_NUM];
+    /// Length of the leased address.
+    const size_t address_len_;
+    /// MAC address of the client 0.
+    const std::vector<uint8_t> mac_template_;
+    /// Timeout of the response in milliseconds.
+    const uint32_t timeout_ms_;
+    /// Timers of the clients.
+    TimerWheel wheel_;
+    /// Buffer for the expired timers.
+    std::vector<TimerWheel::Timer> expired_;
+};
+
+/// Pointer to the pool of simulated clients.
+typedef boost::shared_ptr<ClientPool> ClientPoolPtr;
+
+} // namespace perfdhcp
+} // namespace isc
+
+#endif // CLIENT_POOL_H
@@ -51,6 +51,7 @@ CommandOptions::reset() {
     // We don't use constructor initialization list because we
     // will need to reset all members many times to perform unit tests
     ipversion_ = 0;
+    dhcp4o6_ = false;
     exchange_mode_ = DORA_SARR;
     rate_ = 0;
     report_delay_ = 0;
@@ -68,6 +69,11 @@ CommandOptions::reset() {
     is_interface_ = false;
     preload_ = 0;
     aggressivity_ = 1;
+    threads_num_ = 0;
+    pin_threads_ = false;
+    simulated_clients_ = 0;
+    release_ratio_ = 0;
+    decline_ratio_ = 0;
     local_port_ = 0;
     seeded_ = false;
     seed_ = 0;
@@ -82,6 +88,8 @@ CommandOptions::reset() {
     rip_offset_ = -1;
     diags_.clear();
     wrapped_.clear();
+    time_series_file_.clear();
+    time_series_format_ = "csv";
     server_name_.clear();
     generateDuidTemplate();
 }
@@ -147,10 +155,27 @@ CommandOptions::initialize(int argc, char** argv, bool print_cmd_line) {
     std::ostringstream stream;
     stream << "perfdhcp";
 
+    // getopt() would take -4o6 for -4 followed by unknown -o and -6, so
+    // this switch is removed from the argument vector before parsing.
+    std::vector<char*> args;
+    for (int i = 0; i < argc; ++i) {
+        if ((i > 0) && (std::string(argv[i]) == "-4o6")) {
+            check(dhcp4o6_, "-4o6 already specified");
+            ipversion_ = 6;
+            dhcp4o6_ = true;
+            stream << " -4o6";
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    args.push_back(NULL);
+    argc = args.size() - 1;
+    argv = &args[0];
+
     // In this section we collect argument values from command line
     // they will be tuned and validated elsewhere
     while((opt = getopt(argc, argv, "hv46r:t:R:b:n:p:d:D:l:P:a:L:"
-                        "s:iBc1T:X:O:E:S:I:x:w:")) != -1) {
+                        "s:iBc1T:X:O:E:S:I:x:w:g:Gy:Y:M:u:U:")) != -1) {
         stream << " -" << static_cast<char>(opt);
         if (optarg) {
             stream << " " << optarg;
@@ -167,6 +192,7 @@ CommandOptions::initialize(int argc, char** argv, bool print_cmd_line) {
 
         case '6':
             check(ipversion_ == 4, "IP version already set to 4");
+            check(dhcp4o6_, "-6 is not compatible with -4o6");
             ipversion_ = 6;
             break;
 
@@ -237,6 +263,16 @@ CommandOptions::initialize(int argc, char** argv, bool print_cmd_line) {
                                              " must not be a negative integer");
             break;
 
+        case 'g':
+            threads_num_ = positiveInteger("number of receiving threads:"
+                                           " -g<threads> must be a positive"
+                                           " integer");
+            break;
+
+        case 'G':
+            pin_threads_ = true;
+            break;
+
         case 'h':
             usage();
             return (true);
@@ -245,6 +281,12 @@ CommandOptions::initialize(int argc, char** argv, bool print_cmd_line) {
             exchange_mode_ = DO_SA;
             break;
 
+        case 'M':
+            simulated_clients_ = positiveInteger("number of simulated clients:"
+                                                 " -M<clients> must be a"
+                                                 " positive integer");
+            break;
+
         case 'I':
             rip_offset_ = positiveInteger("value of ip address offset:"
                                           " -I<value> must be a"
@@ -343,6 +385,18 @@ CommandOptions::initialize(int argc, char** argv, bool print_cmd_line) {
             }
             break;
 
+        case 'u':
+            release_ratio_ = percentage("percentage of releasing clients:"
+                                        " -u<release-ratio> must be a"
+                                        " number from 0 to 100");
+            break;
+
+        case 'U':
+            decline_ratio_ = percentage("percentage of declining clients:"
+                                        " -U<decline-ratio> must be a"
+                                        " number from 0 to 100");
+            break;
+
         case 'v':
             version();
             return (true);
@@ -357,6 +411,21 @@ CommandOptions::initialize(int argc, char** argv, bool print_cmd_line) {
                                     " -x<value> must be specified");
             break;
 
+        case 'y':
+            time_series_file_ = nonEmptyString("name of the time series file:"
+                                               " -y<file> must be specified");
+            break;
+
+        case 'Y':
+            time_series_format_ = nonEmptyString("format of the time series:"
+                                                 " -Y<format> must be"
+                                                 " specified");
+            check((time_series_format_ != "csv") &&
+                  (time_series_format_ != "json"),
+                  "format of the time series: -Y<format> must be"
+                  " csv or json");
+            break;
+
         case 'X':
             if (xid_offset_.size() < 2) {
                 offset_arg = positiveInteger("value of transaction id:"
@@ -618,6 +687,10 @@ CommandOptions::validate() const {
           "-B is not compatible with IPv6 (-6)");
     check((getIpVersion() != 6) && (isRapidCommit() != 0),
           "-6 (IPv6) must be set to use -c");
+    check(isDhcp4o6() && (isRapidCommit() != 0),
+          "-c is not compatible with -4o6");
+    check(isDhcp4o6() && (getTemplateFiles().size() > 0),
+          "-T<template-file> is not compatible with -4o6");
     check((getExchangeMode() == DO_SA) && (getNumRequests().size() > 1),
           "second -n<num-request> is not compatible with -i");
     check((getExchangeMode() == DO_SA) && (getDropTime()[1] != 1.),
@@ -662,7 +735,23 @@ CommandOptions::validate() const {
     check((getTemplateFiles().size() < 2) && (getRequestedIpOffset() >= 0),
           "second/request -T<template-file> must be set to "
           "use -I<ip-offset>\n");
-
+    check((getThreadsNum() == 0) && isPinThreads(),
+          "-g<threads> must be set to use -G\n");
+    check((getReportDelay() == 0) && !getTimeSeriesFile().empty(),
+          "-t<report> must be set to use -y<file>\n");
+    check((getSimulatedClientsNum() > 0) && (getExchangeMode() == DO_SA),
+          "-M<clients> is not compatible with -i\n");
+    check((getSimulatedClientsNum() > 0) && (getClientsNum() > 1),
+          "-M<clients> is not compatible with -R<range>\n");
+    check((getSimulatedClientsNum() > 0) && !getTemplateFiles().empty(),
+          "-M<clients> is not compatible with -T<template-file>\n");
+    check((getSimulatedClientsNum() == 0) &&
+          ((getReleaseRatio() > 0) || (getDeclineRatio() > 0)),
+          "-M<clients> must be set to use -u<release-ratio> and "
+          "-U<decline-ratio>\n");
+    check(getReleaseRatio() + getDeclineRatio() > 100,
+          "sum of -u<release-ratio> and -U<decline-ratio> must not "
+          "exceed 100\n");
 }
 
 void
@@ -685,6 +774,17 @@ CommandOptions::positiveInteger(const std::string& errmsg) const {
     }
 }
 
+double
+CommandOptions::percentage(const std::string& errmsg) const {
+    try {
+        double value = boost::lexical_cast<double>(optarg);
+        check((value < 0) || (value > 100), errmsg);
+        return (value);
+    } catch (boost::bad_lexical_cast&) {
+        isc_throw(InvalidParameter, errmsg);
+    }
+}
+
 int
 CommandOptions::nonNegativeInteger(const std::string& errmsg) const {
     try {
@@ -708,8 +808,11 @@ CommandOptions::nonEmptyString(const std::string& errmsg) const {
 void
 CommandOptions::printCommandLine() const {
     std::cout << "IPv" << static_cast<int>(ipversion_) << std::endl;
+    if (dhcp4o6_) {
+        std::cout << "DHCPv4-over-DHCPv6" << std::endl;
+    }
     if (exchange_mode_ == DO_SA) {
-        if (ipversion_ == 4) {
+        if (isDhcp4()) {
             std::cout << "DISCOVER-OFFER only" << std::endl;
         } else {
             std::cout << "SOLICIT-ADVERETISE only" << std::endl;
@@ -746,6 +849,17 @@ CommandOptions::printCommandLine() const {
         std::cout << "preload=" << preload_ <<  std::endl;
     }
     std::cout << "aggressivity=" << aggressivity_ << std::endl;
+    if (threads_num_ != 0) {
+        std::cout << "receiving-threads=" << threads_num_ << std::endl;
+    }
+    if (pin_threads_) {
+        std::cout << "pin-threads" << std::endl;
+    }
+    if (simulated_clients_ != 0) {
+        std::cout << "simulated-clients=" << simulated_clients_ << std::endl;
+        std::cout << "release-ratio=" << release_ratio_ << std::endl;
+        std::cout << "decline-ratio=" << decline_ratio_ << std::endl;
+    }
     if (getLocalPort() != 0) {
         std::cout << "local-port=" << local_port_ <<  std::endl;
     }
@@ -785,6 +899,10 @@ CommandOptions::printCommandLine() const {
     if (!wrapped_.empty()) {
         std::cout << "wrapped=" << wrapped_ << std::endl;
     }
+    if (!time_series_file_.empty()) {
+        std::cout << "time-series=" << time_series_file_ << " ("
+                  << time_series_format_ << ")" << std::endl;
+    }
     if (!localname_.empty()) {
         if (is_interface_) {
             std::cout << "interface=" << localname_ << std::endl;
@@ -800,13 +918,15 @@ CommandOptions::printCommandLine() const {
 void
 CommandOptions::usage() const {
     std::cout <<
-        "perfdhcp [-hv] [-4|-6] [-r<rate>] [-t<report>] [-R<range>] [-b<base>]\n"
+        "perfdhcp [-hv] [-4|-6|-4o6] [-r<rate>] [-t<report>] [-R<range>] [-b<base>]\n"
         "    [-n<num-request>] [-p<test-period>] [-d<drop-time>] [-D<max-drop>]\n"
         "    [-l<local-addr|interface>] [-P<preload>] [-a<aggressivity>]\n"
         "    [-L<local-port>] [-s<seed>] [-i] [-B] [-c] [-1]\n"
         "    [-T<template-file>] [-X<xid-offset>] [-O<random-offset]\n"
         "    [-E<time-offset>] [-S<srvid-offset>] [-I<ip-offset>]\n"
-        "    [-x<diagnostic-selector>] [-w<wrapped>] [server]\n"
+        "    [-x<diagnostic-selector>] [-w<wrapped>] [-g<threads>] [-G]\n"
+        "    [-y<file>] [-Y<format>] [-M<clients>] [-u<release-ratio>]\n"
+        "    [-U<decline-ratio>] [server]\n"
         "\n"
         "The [server] argument is the name/address of the DHCP server to\n"
         "contact.  For DHCPv4 operation, exchanges are initiated by\n"
@@ -820,6 +940,12 @@ CommandOptions::usage() const {
         "argument is optional only in the case that -l is used to specify an\n"
         "interface, in which case [server] defaults to 'all'.\n"
         "\n"
+        "For DHCPv4-over-DHCPv6 operation (-4o6), the DHCP DISCOVER and\n"
+        "REQUEST messages are carried in the DHCPv4 Message option of\n"
+        "DHCPV4-QUERY messages sent to the DHCPv6 [server] (which accepts\n"
+        "the same special names as for DHCPv6), and the exchanges are matched\n"
+        "using the transaction ids of the DHCPv4 messages.\n"
+        "\n"
         "The default is to perform a single 4-way exchange, effectively pinging\n"
         "the server.\n"
         "The -r option is used to set up a performance test, without\n"
@@ -829,6 +955,8 @@ CommandOptions::usage() const {
         "-1: Take the server-ID option from the first received message.\n"
         "-4: DHCPv4 operation (default). This is incompatible with the -6 option.\n"
         "-6: DHCPv6 operation. This is incompatible with the -4 option.\n"
+        "-4o6: DHCPv4-over-DHCPv6 operation. This is incompatible with the\n"
+        "    -4 and -6 options.\n"
         "-a<aggressivity>: When the target sending rate is not yet reached,\n"
         "    control how many exchanges are initiated before the next pause.\n"
         "-b<base>: The base mac, duid, IP, etc, used to simulate different\n"
@@ -841,6 +969,13 @@ CommandOptions::usage() const {
         "-E<time-offset>: Offset of the (DHCPv4) secs field / (DHCPv6)\n"
         "    elapsed-time option in the (second/request) template.\n"
         "    The value 0 disables it.\n"
+        "-g<threads>: Receive the responses in the specified number of\n"
+        "    threads.  The packets are sent in batches by the main thread, at\n"
+        "    the rate enforced by the token bucket (of the -a<aggressivity>\n"
+        "    size) refilled using the monotonic clock.  By default all work\n"
+        "    is done in a single thread.\n"
+        "-G: Pin each receiving thread to a separate CPU.  This requires\n"
+        "    the -g<threads> option.\n"
         "-h: Print this help.\n"
         "-i: Do only the initial part of an exchange: DO or SA, depending on\n"
         "    whether -6 is given.\n"
@@ -854,6 +989,12 @@ CommandOptions::usage() const {
         "    via which exchanges are initiated.\n"
         "-L<local-port>: Specify the local port to use\n"
         "    (the value 0 means to use the default).\n"
+        "-M<clients>: Simulate the given number of clients going through\n"
+        "    the whole lease lifecycle.  New exchanges are initiated at the\n"
+        "    -r<rate> by the clients having no lease.  Once a client obtains\n"
+        "    the lease, it renews it at T1, rebinds it at T2 and drops it\n"
+        "    when it expires, using the times sent by the server.  This is\n"
+        "    not compatible with -i, -R and -T.\n"
         "-O<random-offset>: Offset of the last octet to randomize in the template.\n"
         "-P<preload>: Initiate first <preload> exchanges back to back at startup.\n"
         "-r<rate>: Initiate <rate> DORA/SARR (or if -i is given, DO/SA)\n"
@@ -868,6 +1009,10 @@ CommandOptions::usage() const {
         "    (second/request) template.\n"
         "-T<template-file>: The name of a file containing the template to use\n"
         "    as a stream of hexadecimal digits.\n"
+        "-u<release-ratio>: Percentage of the simulated clients (-M) which\n"
+        "    release the lease at T1 instead of renewing it.\n"
+        "-U<decline-ratio>: Percentage of the simulated clients (-M) which\n"
+        "    decline the newly leased address.\n"
         "-v: Report the version number of this program.\n"
         "-w<wrapped>: Command to call with start/stop at the beginning/end of\n"
         "    the program.\n"
@@ -904,7 +1049,19 @@ CommandOptions::usage() const {
         "    specified in the same manner as -d.  This can be used as an\n"
         "    alternative to -n, or both options can be given, in which case the\n"
         "    testing is completed when either limit is reached.\n"
-        "-t<report>: Delay in seconds between two periodic reports.\n"
+        "-t<report>: Delay in seconds between two periodic reports.  The\n"
+        "    periodic report includes the 50th, 90th, 99th and 99.9th\n"
+        "    percentiles of the delays of responses received since the\n"
+        "    previous report.\n"
+        "-y<file>: Write the statistics of each exchange type in each\n"
+        "    periodic report interval to the file, as the time series for\n"
+        "    further processing.  Each record holds the elapsed time, the\n"
+        "    sent/received/dropped packets counters, the number of responses\n"
+        "    received in the interval and the percentiles and maximum of\n"
+        "    their delays in milliseconds.  This requires -t<report>.\n"
+        "-Y<format>: Format of the -y<file> time series: 'csv' (the default,\n"
+        "    with the header in the first line) or 'json' (one object per\n"
+        "    line).\n"
         "\n"
         "Errors:\n"
         "- tooshort: received a too short message\n"
@@ -66,6 +66,19 @@ public:
     /// \return IP version to be used.
     uint8_t getIpVersion() const { return ipversion_; }
 
+    /// \brief Checks if DHCPv4-over-DHCPv6 mode is used (-4o6).
+    ///
+    /// In this mode DHCPv4 messages are carried in DHCPV4-QUERY and
+    /// DHCPV4-RESPONSE messages sent over IPv6, so the IP version is 6.
+    ///
+    /// \return true if DHCPv4 messages are sent over DHCPv6.
+    bool isDhcp4o6() const { return dhcp4o6_; }
+
+    /// \brief Checks if DHCPv4 messages are exchanged.
+    ///
+    /// \return true for DHCPv4 (-4) and DHCPv4-over-DHCPv6 (-4o6) modes.
+    bool isDhcp4() const { return ((ipversion_ == 4) || dhcp4o6_); }
+
     /// \brief Returns packet exchange mode.
     ///
     /// \return packet exchange mode.
@@ -183,6 +196,35 @@ public:
     /// \return true if rapid commit option is used.
     bool isRapidCommit() const { return rapid_commit_; }
 
+    /// \brief Returns number of threads receiving packets.
+    ///
+    /// \return number of receiving threads, 0 if packets are sent and
+    /// received by the single thread.
+    int getThreadsNum() const { return threads_num_; }
+
+    /// \brief Check if receiving threads are pinned to CPUs.
+    ///
+    /// \return true if receiving threads are pinned to separate CPUs.
+    bool isPinThreads() const { return pin_threads_; }
+
+    /// \brief Returns number of simulated clients.
+    ///
+    /// \return number of clients whose leases are tracked through
+    /// their lifecycle, 0 if the lifecycle is not simulated.
+    uint32_t getSimulatedClientsNum() const { return simulated_clients_; }
+
+    /// \brief Returns percentage of clients releasing leases.
+    ///
+    /// \return percentage of bound clients which release the lease
+    /// at T1 instead of renewing it.
+    double getReleaseRatio() const { return release_ratio_; }
+
+    /// \brief Returns percentage of clients declining leases.
+    ///
+    /// \return percentage of clients which decline the newly
+    /// leased address.
+    double getDeclineRatio() const { return decline_ratio_; }
+
     /// \brief Check if server-ID to be taken from first package.
     ///
     /// \return true if server-iD to be taken from first package.
@@ -228,6 +270,17 @@ public:
     /// \return wrapped command (start/stop).
     std::string getWrapped() const { return wrapped_; }
 
+    /// \brief Returns name of the time series file.
+    ///
+    /// \return name of the file the statistics of each report interval
+    /// are written to, empty if not specified.
+    std::string getTimeSeriesFile() const { return time_series_file_; }
+
+    /// \brief Returns format of the time series file.
+    ///
+    /// \return "csv" or "json".
+    std::string getTimeSeriesFormat() const { return time_series_format_; }
+
     /// \brief Returns server name.
     ///
     /// \return server name.
@@ -294,6 +347,14 @@ private:
     /// \throw InvalidParameter if lexical cast fails.
     int nonNegativeInteger(const std::string& errmsg) const;
 
+    /// \brief Returns percentage from the argument.
+    ///
+    /// \param errmsg error message if the argument is not a number
+    /// in the range of 0 to 100.
+    /// \throw InvalidParameter if the argument is invalid.
+    /// \return percentage.
+    double percentage(const std::string& errmsg) const;
+
     /// \brief Returns command line string if it is not empty.
     ///
     /// \param errmsg Error message if string is empty.
@@ -371,6 +432,8 @@ private:
     /// IP protocol version to be used, expected values are:
     /// 4 for IPv4 and 6 for IPv6, default value 0 means "not set"
     uint8_t ipversion_;
+    /// DHCPv4 messages are sent in DHCPv6 messages (-4o6)
+    bool dhcp4o6_;
     /// Packet exchange mode (e.g. DORA/SARR)
     ExchangeMode exchange_mode_;
     /// Rate in exchange per second
@@ -432,6 +495,16 @@ private:
     bool rapid_commit_;
     /// Indicates that we take server id from first received packet.
     bool use_first_;
+    /// Number of threads receiving packets.
+    int threads_num_;
+    /// Indicates that receiving threads are pinned to CPUs.
+    bool pin_threads_;
+    /// Number of simulated clients going through the lease lifecycle.
+    uint32_t simulated_clients_;
+    /// Percentage of clients releasing the lease at T1.
+    double release_ratio_;
+    /// Percentage of clients declining the leased address.
+    double decline_ratio_;
     /// Packet template file names. These files store template packets
     /// that are used for initiating echanges. Template packets
     /// read from files are later tuned with variable data.
@@ -457,6 +530,11 @@ private:
     /// Command to be executed at the beginning/end of the test.
     /// This command is expected to expose start and stop argument.
     std::string wrapped_;
+    /// Name of the file the statistics of each report interval are
+    /// written to, specified with -y<file>.
+    std::string time_series_file_;
+    /// Format of the time series file (csv or json).
+    std::string time_series_format_;
     /// Server name specified as last argument of command line.
     std::string server_name_;
 };
@@ -0,0 +1,145 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <exceptions/exceptions.h>
+
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace isc {
+namespace perfdhcp {
+
+const int LatencyHistogram::SUB_BUCKET_BITS;
+const uint64_t LatencyHistogram::SUB_BUCKETS;
+const uint64_t LatencyHistogram::MAX_DELAY;
+const int LatencyHistogram::BUCKETS;
+
+LatencyHistogram::LatencyHistogram() {
+    clear();
+}
+
+void
+LatencyHistogram::add(const double delay) {
+    uint64_t delay_us = 0;
+    if (delay > 0) {
+        const double rounded = std::floor(delay * 1e6 + 0.5);
+        delay_us = rounded < MAX_DELAY ? static_cast<uint64_t>(rounded) :
+            MAX_DELAY;
+    }
+    ++buckets_[getBucketIndex(delay_us)];
+    ++count_;
+    min_ = std::min(min_, delay_us);
+    max_ = std::max(max_, delay_us);
+}
+
+void
+LatencyHistogram::add(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKETS; ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void
+LatencyHistogram::clear() {
+    memset(buckets_, 0, sizeof(buckets_));
+    count_ = 0;
+    min_ = MAX_DELAY;
+    max_ = 0;
+}
+
+double
+LatencyHistogram::getMin() const {
+    if (count_ == 0) {
+        isc_throw(InvalidOperation, "no delays recorded");
+    }
+    return (static_cast<double>(min_) / 1e6);
+}
+
+double
+LatencyHistogram::getMax() const {
+    if (count_ == 0) {
+        isc_throw(InvalidOperation, "no delays recorded");
+    }
+    return (static_cast<double>(max_) / 1e6);
+}
+
+double
+LatencyHistogram::getPercentile(const double percentile) const {
+    if ((percentile < 0) || (percentile > 100)) {
+        isc_throw(BadValue, "percentile " << percentile
+                  << " is out of range 0..100");
+    }
+    if (count_ == 0) {
+        isc_throw(InvalidOperation, "no delays recorded");
+    }
+    // Number of the delays which are not longer than the percentile,
+    // rounded to the nearest integer to avoid the floating point error.
+    uint64_t target =
+        static_cast<uint64_t>(percentile / 100 * count_ + 0.5);
+    if (target == 0) {
+        return (getMin());
+    }
+    target = std::min(target, count_);
+    uint64_t total = 0;
+    int index = 0;
+    for (; index < BUCKETS - 1; ++index) {
+        total += buckets_[index];
+        if (total >= target) {
+            break;
+        }
+    }
+    const uint64_t delay_us = std::min(getBucketMax(index), max_);
+    return (static_cast<double>(delay_us) / 1e6);
+}
+
+int
+LatencyHistogram::getBucketIndex(uint64_t delay) {
+    if (delay > MAX_DELAY) {
+        delay = MAX_DELAY;
+    }
+    if (delay < SUB_BUCKETS) {
+        return (static_cast<int>(delay));
+    }
+    // Shift bringing the delay to the range of SUB_BUCKETS / 2 to
+    // SUB_BUCKETS - 1. Each shift adds SUB_BUCKETS / 2 buckets.
+    int shift = 0;
+    while ((delay >> shift) >= SUB_BUCKETS) {
+        ++shift;
+    }
+    const uint64_t half = SUB_BUCKETS / 2;
+    return (static_cast<int>(SUB_BUCKETS + (shift - 1) * half +
+                             (delay >> shift) - half));
+}
+
+uint64_t
+LatencyHistogram::getBucketMax(const int index) {
+    if (index < static_cast<int>(SUB_BUCKETS)) {
+        return (index);
+    }
+    const uint64_t half = SUB_BUCKETS / 2;
+    const uint64_t offset = index - SUB_BUCKETS;
+    const int shift = static_cast<int>(offset / half) + 1;
+    const uint64_t top = offset % half + half;
+    return (((top + 1) << shift) - 1);
+}
+
+} // namespace perfdhcp
+} // namespace isc
@@ -0,0 +1,121 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+namespace isc {
+namespace perfdhcp {
+
+/// \brief Histogram of packet delays.
+///
+/// The delays are counted in buckets with log-linear boundaries, the
+/// same way as in HdrHistogram. Delays are recorded with a microsecond
+/// resolution. Delays shorter than \ref SUB_BUCKETS microseconds have
+/// a bucket of their own. Each range between the consecutive powers of
+/// two above that is split into \ref SUB_BUCKETS / 2 equal buckets, so
+/// the relative error of the reported percentiles is below 1/64
+/// regardless of the magnitude of the delay.
+///
+/// The number of buckets is fixed, so the memory used by the histogram
+/// doesn't depend on the number of recorded delays or on the length of
+/// the test. Delays longer than \ref MAX_DELAY are counted in the last
+/// bucket.
+class LatencyHistogram {
+public:
+    /// Number of buckets for the delays below 2^SUB_BUCKET_BITS us.
+    static const int SUB_BUCKET_BITS = 7;
+    /// Number of buckets below 2^SUB_BUCKET_BITS us.
+    static const uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    /// Longest delay counted accurately, about 12 days (in us).
+    static const uint64_t MAX_DELAY = (1ULL << 40) - 1;
+    /// Total number of buckets.
+    static const int BUCKETS =
+        SUB_BUCKETS + (40 - SUB_BUCKET_BITS) * (SUB_BUCKETS / 2);
+
+    /// \brief Constructor.
+    ///
+    /// Creates an empty histogram.
+    LatencyHistogram();
+
+    /// \brief Records a delay.
+    ///
+    /// \param delay delay in seconds. Negative delays are counted as 0.
+    void add(const double delay);
+
+    /// \brief Adds delays recorded in the other histogram.
+    ///
+    /// \param other histogram to be merged into this one.
+    void add(const LatencyHistogram& other);
+
+    /// \brief Removes all recorded delays.
+    void clear();
+
+    /// \brief Returns the number of recorded delays.
+    uint64_t getCount() const { return (count_); }
+
+    /// \brief Returns the shortest recorded delay.
+    ///
+    /// \throw isc::InvalidOperation if no delays have been recorded.
+    /// \return delay in seconds.
+    double getMin() const;
+
+    /// \brief Returns the longest recorded delay.
+    ///
+    /// \throw isc::InvalidOperation if no delays have been recorded.
+    /// \return delay in seconds.
+    double getMax() const;
+
+    /// \brief Returns the percentile of the recorded delays.
+    ///
+    /// The returned value is the highest delay counted in the same bucket
+    /// as the delay at the given percentile (but not more than the longest
+    /// recorded delay).
+    ///
+    /// \param percentile percentile in the range of 0 to 100, e.g. 99.9.
+    /// \throw isc::BadValue if the percentile is out of range.
+    /// \throw isc::InvalidOperation if no delays have been recorded.
+    /// \return delay in seconds.
+    double getPercentile(const double percentile) const;
+
+    /// \brief Returns the index of the bucket counting the delay.
+    ///
+    /// \param delay delay in microseconds.
+    /// \return index of the bucket.
+    static int getBucketIndex(uint64_t delay);
+
+    /// \brief Returns the highest delay counted in the bucket.
+    ///
+    /// \param index index of the bucket.
+    /// \return delay in microseconds.
+    static uint64_t getBucketMax(const int index);
+
+private:
+    /// Number of delays in each bucket.
+    uint64_t buckets_[BUCKETS];
+    /// Number of recorded delays.
+    uint64_t count_;
+    /// Shortest recorded delay in microseconds.
+    uint64_t min_;
+    /// Longest recorded delay in microseconds.
+    uint64_t max_;
+};
+
+} // namespace perfdhcp
+} // namespace isc
+
+#endif // LATENCY_HISTOGRAM_H
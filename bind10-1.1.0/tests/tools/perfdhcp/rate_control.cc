@@ -0,0 +1,58 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <exceptions/exceptions.h>
+
+#include "rate_control.h"
+
+#include <time.h>
+
+namespace isc {
+namespace perfdhcp {
+
+RateControl::RateControl(const int rate, const int size)
+    : rate_(rate), size_(size), tokens_(1), last_refill_(currentTime()),
+      late_(false) {
+    if (size <= 0) {
+        isc_throw(isc::BadValue, "size of the token bucket must be positive");
+    }
+}
+
+uint64_t
+RateControl::getOutboundMessageCount() {
+    if (rate_ == 0) {
+        return (size_);
+    }
+    const uint64_t now = currentTime();
+    tokens_ += static_cast<double>(now - last_refill_) * rate_ / 1e9;
+    last_refill_ = now;
+    late_ = (tokens_ > size_);
+    if (late_) {
+        tokens_ = size_;
+    }
+    const uint64_t count = static_cast<uint64_t>(tokens_);
+    tokens_ -= count;
+    return (count);
+}
+
+uint64_t
+RateControl::currentTime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec);
+}
+
+} // namespace perfdhcp
+} // namespace isc
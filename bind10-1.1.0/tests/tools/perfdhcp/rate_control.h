@@ -0,0 +1,82 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef RATE_CONTROL_H
+#define RATE_CONTROL_H
+
+#include <stdint.h>
+
+namespace isc {
+namespace perfdhcp {
+
+/// \brief Token bucket controlling the rate of initiated exchanges.
+///
+/// The bucket is refilled with the number of tokens proportional to the
+/// time elapsed since the last refill, measured with the monotonic clock
+/// in nanoseconds. Each token allows initiating one exchange. The bucket
+/// holds at most the number of tokens equal to its size, which limits the
+/// number of exchanges initiated at once when perfdhcp didn't keep up
+/// with the rate.
+///
+/// Unlike the time based calculation done by the
+/// \ref TestControl::getNextExchangesNum, the fractions of tokens are
+/// carried over between calls, so the achieved rate doesn't depend on how
+/// often the bucket is checked.
+class RateControl {
+public:
+    /// \brief Constructor.
+    ///
+    /// \param rate number of exchanges per second, 0 if exchanges are to
+    /// be initiated as fast as possible.
+    /// \param size size of the bucket.
+    /// \throw isc::BadValue if the size is 0.
+    RateControl(const int rate, const int size);
+
+    /// \brief Returns the number of exchanges to be initiated now.
+    ///
+    /// Refills the bucket and takes all whole tokens out of it. If the
+    /// rate is not limited, the size of the bucket is returned.
+    ///
+    /// \return number of exchanges to be initiated.
+    uint64_t getOutboundMessageCount();
+
+    /// \brief Checks if the tokens overflowed the bucket.
+    ///
+    /// \return true if the last refill was capped by the size of the
+    /// bucket, i.e. exchanges were initiated later than due.
+    bool isLate() const { return (late_); }
+
+    /// \brief Returns the current time of the monotonic clock.
+    ///
+    /// \return time in nanoseconds.
+    static uint64_t currentTime();
+
+private:
+    /// Number of exchanges per second.
+    const int rate_;
+    /// Maximum number of tokens.
+    const int size_;
+    /// Number of tokens (including the fraction) in the bucket.
+    double tokens_;
+    /// Time of the last refill in nanoseconds.
+    uint64_t last_refill_;
+    /// Indicates that the last refill was capped.
+    bool late_;
+};
+
+} // namespace perfdhcp
+} // namespace isc
+
+#endif // RATE_CONTROL_H
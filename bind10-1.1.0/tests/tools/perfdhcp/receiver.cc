@@ -0,0 +1,313 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <config.h>
+
+#include <exceptions/exceptions.h>
+#include <util/threads/thread.h>
+
+#include "receiver.h"
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace isc::dhcp;
+using namespace isc::util::thread;
+
+namespace isc {
+namespace perfdhcp {
+
+const size_t Receiver::BATCH_SIZE;
+const size_t Receiver::QUEUE_SIZE;
+const size_t Receiver::MAX_PACKET_SIZE;
+
+namespace {
+
+/// Time after which the thread checks if it has been stopped (ms).
+const int POLL_TIMEOUT = 100;
+
+}
+
+/// \brief Receiving thread and the ring buffer of packets it received
+class Receiver::Worker {
+public:
+    /// \brief Constructor.
+    ///
+    /// \param socket descriptor of the socket.
+    /// \param family address family of the socket.
+    /// \param cpu CPU the thread is pinned to, -1 if not pinned.
+    /// \param running flag cleared when the thread is to terminate.
+    Worker(const int socket, const int family, const int cpu,
+           const volatile bool& running)
+        : socket_(socket), family_(family), cpu_(cpu), running_(running),
+          ring_(QUEUE_SIZE), head_(0), tail_(0),
+          buffers_(BATCH_SIZE, std::vector<uint8_t>(MAX_PACKET_SIZE)),
+          lengths_(BATCH_SIZE) {
+    }
+
+    /// \brief Starts the thread.
+    void start() {
+        thread_.reset(new Thread(boost::bind(&Worker::run, this)));
+    }
+
+    /// \brief Waits for the thread to terminate.
+    void wait() {
+        if (thread_) {
+            thread_->wait();
+            thread_.reset();
+        }
+    }
+
+    /// \brief Takes the oldest packet out of the ring.
+    ///
+    /// \param [out] pkt4 set to the DHCPv4 packet.
+    /// \param [out] pkt6 set to the DHCPv6 packet.
+    /// \return false if the ring is empty.
+    bool pop(Pkt4Ptr& pkt4, Pkt6Ptr& pkt6) {
+        if (head_ == tail_) {
+            return (false);
+        }
+        // Read the slot after the producer has filled it in.
+        __sync_synchronize();
+        Slot& slot = ring_[head_ & (QUEUE_SIZE - 1)];
+        pkt4.swap(slot.pkt4_);
+        pkt6.swap(slot.pkt6_);
+        slot.pkt4_.reset();
+        slot.pkt6_.reset();
+        // Release the slot after it has been emptied.
+        __sync_synchronize();
+        head_ = head_ + 1;
+        return (true);
+    }
+
+private:
+    /// \brief Packet held in the ring
+    struct Slot {
+        Pkt4Ptr pkt4_;
+        Pkt6Ptr pkt6_;
+    };
+
+    /// \brief Body of the thread.
+    void run() {
+        if (cpu_ >= 0) {
+            pin();
+        }
+        while (running_) {
+            struct pollfd pfd;
+            pfd.fd = socket_;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (poll(&pfd, 1, POLL_TIMEOUT) <= 0) {
+                continue;
+            }
+            const size_t count = receiveBatch();
+            for (size_t i = 0; i < count; ++i) {
+                push(i);
+            }
+        }
+    }
+
+    /// \brief Reads the available packets into the buffers.
+    ///
+    /// \return number of packets read.
+    size_t receiveBatch() {
+#if defined(OS_LINUX)
+        struct mmsghdr msgs[BATCH_SIZE];
+        struct iovec iovs[BATCH_SIZE];
+        memset(msgs, 0, sizeof(msgs));
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+            iovs[i].iov_base = &buffers_[i][0];
+            iovs[i].iov_len = MAX_PACKET_SIZE;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        const int result = recvmmsg(socket_, msgs, BATCH_SIZE, MSG_DONTWAIT,
+                                    NULL);
+        if (result <= 0) {
+            return (0);
+        }
+        for (int i = 0; i < result; ++i) {
+            lengths_[i] = msgs[i].msg_len;
+        }
+        return (result);
+#else
+        size_t count = 0;
+        for (; count < BATCH_SIZE; ++count) {
+            const ssize_t result = recv(socket_, &buffers_[count][0],
+                                        MAX_PACKET_SIZE, MSG_DONTWAIT);
+            if (result < 0) {
+                break;
+            }
+            lengths_[count] = result;
+        }
+        return (count);
+#endif
+    }
+
+    /// \brief Creates the packet from the buffer and puts it in the ring.
+    ///
+    /// Waits while the ring is full.
+    ///
+    /// \param index index of the buffer.
+    void push(const size_t index) {
+        Slot slot;
+        try {
+            if (family_ == AF_INET) {
+                slot.pkt4_.reset(new Pkt4(&buffers_[index][0],
+                                          lengths_[index]));
+                slot.pkt4_->updateTimestamp();
+            } else {
+                slot.pkt6_.reset(new Pkt6(&buffers_[index][0],
+                                          lengths_[index]));
+                slot.pkt6_->updateTimestamp();
+            }
+        } catch (const isc::Exception&) {
+            // The packet is too short to be the DHCP message, so it
+            // won't match any exchange.
+            return;
+        }
+        while (tail_ - head_ == QUEUE_SIZE) {
+            if (!running_) {
+                return;
+            }
+            sched_yield();
+        }
+        Slot& ring_slot = ring_[tail_ & (QUEUE_SIZE - 1)];
+        ring_slot.pkt4_.swap(slot.pkt4_);
+        ring_slot.pkt6_.swap(slot.pkt6_);
+        // Publish the slot after it has been filled in.
+        __sync_synchronize();
+        tail_ = tail_ + 1;
+    }
+
+    /// \brief Pins the calling thread to the CPU.
+    void pin() {
+#if defined(OS_LINUX)
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu_, &cpus);
+        // Failure is not fatal, the thread just runs on any CPU.
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+    }
+
+    /// Socket descriptor.
+    const int socket_;
+    /// Address family of the socket.
+    const int family_;
+    /// CPU the thread is pinned to.
+    const int cpu_;
+    /// Cleared when the thread is to terminate.
+    const volatile bool& running_;
+    /// Ring of the received packets.
+    std::vector<Slot> ring_;
+    /// Position of the next packet to be taken (updated by the consumer).
+    volatile size_t head_;
+    /// Position of the next packet to be stored (updated by the thread).
+    volatile size_t tail_;
+    /// Buffers the packets are read into.
+    std::vector<std::vector<uint8_t> > buffers_;
+    /// Lengths of the packets read into the buffers.
+    std::vector<size_t> lengths_;
+    /// The thread.
+    boost::scoped_ptr<Thread> thread_;
+};
+
+Receiver::Receiver(const int socket, const int family,
+                   const unsigned threads_num, const bool pin_threads)
+    : next_worker_(0), running_(false) {
+    if ((family != AF_INET) && (family != AF_INET6)) {
+        isc_throw(isc::BadValue, "invalid address family " << family);
+    }
+    if (threads_num == 0) {
+        isc_throw(isc::BadValue, "number of receiving threads must be "
+                  "positive");
+    }
+    const long cpus_num = sysconf(_SC_NPROCESSORS_ONLN);
+    for (unsigned i = 0; i < threads_num; ++i) {
+        // CPU 0 is left for the thread sending the packets.
+        const int cpu = (pin_threads && (cpus_num > 0)) ?
+            static_cast<int>((i + 1) % cpus_num) : -1;
+        workers_.push_back(WorkerPtr(new Worker(socket, family, cpu,
+                                                running_)));
+    }
+}
+
+Receiver::~Receiver() {
+    try {
+        stop();
+    } catch (...) {
+        // The exception thrown by the thread must not escape.
+    }
+}
+
+void
+Receiver::start() {
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->start();
+    }
+}
+
+void
+Receiver::stop() {
+    running_ = false;
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->wait();
+    }
+}
+
+Pkt4Ptr
+Receiver::getPkt4() {
+    Pkt4Ptr pkt4;
+    Pkt6Ptr pkt6;
+    pop(pkt4, pkt6);
+    return (pkt4);
+}
+
+Pkt6Ptr
+Receiver::getPkt6() {
+    Pkt4Ptr pkt4;
+    Pkt6Ptr pkt6;
+    pop(pkt4, pkt6);
+    return (pkt6);
+}
+
+bool
+Receiver::pop(Pkt4Ptr& pkt4, Pkt6Ptr& pkt6) {
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        Worker& worker = *workers_[next_worker_];
+        next_worker_ = (next_worker_ + 1) % workers_.size();
+        if (worker.pop(pkt4, pkt6)) {
+            return (true);
+        }
+    }
+    return (false);
+}
+
+} // namespace perfdhcp
+} // namespace isc
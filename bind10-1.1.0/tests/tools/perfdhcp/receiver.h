@@ -0,0 +1,125 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef RECEIVER_H
+#define RECEIVER_H
+
+#include <dhcp/pkt4.h>
+#include <dhcp/pkt6.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace isc {
+namespace perfdhcp {
+
+/// \brief Threads receiving packets from the server.
+///
+/// Each thread reads the packets from the socket in batches (using
+/// recvmmsg() where available), creates the packet objects and stamps them
+/// with the time of receipt. The packets are handed over to the thread
+/// which calls getPkt4() or getPkt6() through the ring buffer of the
+/// receiving thread. There is exactly one producer and one consumer of
+/// each ring, so the handoff doesn't need a lock and the statistics
+/// manager, which is updated by the consuming thread only, doesn't need
+/// one either.
+///
+/// The packets are not unpacked by the receiving threads, because the
+/// option factories registered by perfdhcp are not meant to be used
+/// concurrently.
+class Receiver : public boost::noncopyable {
+public:
+    /// Maximum number of packets read at once.
+    static const size_t BATCH_SIZE = 64;
+
+    /// Number of packets the ring buffer of a thread can hold.
+    static const size_t QUEUE_SIZE = 4096;
+
+    /// Maximum size of the received packet.
+    static const size_t MAX_PACKET_SIZE = 4096;
+
+    /// \brief Constructor.
+    ///
+    /// \param socket descriptor of the socket the packets are received
+    /// from.
+    /// \param family address family of the socket (AF_INET or AF_INET6).
+    /// \param threads_num number of receiving threads.
+    /// \param pin_threads pin the threads to CPUs 1..threads_num (modulo
+    /// the number of CPUs). This is supported on Linux only and ignored
+    /// elsewhere.
+    /// \throw isc::BadValue if the family is invalid or the number of
+    /// threads is 0.
+    Receiver(const int socket, const int family, const unsigned threads_num,
+             const bool pin_threads);
+
+    /// \brief Destructor.
+    ///
+    /// Stops the threads.
+    ~Receiver();
+
+    /// \brief Starts the receiving threads.
+    void start();
+
+    /// \brief Stops the receiving threads.
+    ///
+    /// The packets which haven't been taken from the ring buffers are
+    /// discarded.
+    void stop();
+
+    /// \brief Takes the next DHCPv4 packet received.
+    ///
+    /// The rings of the threads are checked in turn. The packet is not
+    /// unpacked.
+    ///
+    /// \return packet or NULL pointer if there are no packets.
+    dhcp::Pkt4Ptr getPkt4();
+
+    /// \brief Takes the next DHCPv6 packet received.
+    ///
+    /// \return packet or NULL pointer if there are no packets.
+    dhcp::Pkt6Ptr getPkt6();
+
+private:
+    class Worker;
+
+    /// \brief Takes the next packet from the rings of the threads.
+    ///
+    /// \param [out] pkt4 set to the DHCPv4 packet.
+    /// \param [out] pkt6 set to the DHCPv6 packet.
+    /// \return false if all rings are empty.
+    bool pop(dhcp::Pkt4Ptr& pkt4, dhcp::Pkt6Ptr& pkt6);
+
+    /// Pointer to the receiving thread.
+    typedef boost::shared_ptr<Worker> WorkerPtr;
+
+    /// Receiving threads.
+    std::vector<WorkerPtr> workers_;
+
+    /// Index of the thread the next packet is taken from.
+    size_t next_worker_;
+
+    /// Cleared when the threads are to terminate.
+    volatile bool running_;
+};
+
+/// Pointer to the Receiver.
+typedef boost::shared_ptr<Receiver> ReceiverPtr;
+
+} // namespace perfdhcp
+} // namespace isc
+
+#endif // RECEIVER_H
@@ -0,0 +1,125 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/iface_mgr.h>
+
+#include "sender.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <netinet/in.h>
+
+using namespace isc::dhcp;
+
+namespace isc {
+namespace perfdhcp {
+
+const size_t Sender::BATCH_SIZE;
+
+Sender::Sender(const int socket)
+    : socket_(socket), data_(BATCH_SIZE), addrs_(BATCH_SIZE),
+      addr_lens_(BATCH_SIZE), count_(0) {
+}
+
+void
+Sender::send(const Pkt4Ptr& pkt) {
+    struct sockaddr_in* addr =
+        reinterpret_cast<struct sockaddr_in*>(&addrs_[count_]);
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(pkt->getRemotePort());
+    addr->sin_addr.s_addr =
+        htonl(pkt->getRemoteAddr().getAddress().to_v4().to_ulong());
+    pkt->updateTimestamp();
+    queue(pkt->getBuffer(), sizeof(*addr));
+}
+
+void
+Sender::send(const Pkt6Ptr& pkt) {
+    struct sockaddr_in6* addr =
+        reinterpret_cast<struct sockaddr_in6*>(&addrs_[count_]);
+    memset(addr, 0, sizeof(*addr));
+    addr->sin6_family = AF_INET6;
+    addr->sin6_port = htons(pkt->getRemotePort());
+    const asio::ip::address_v6 remote =
+        pkt->getRemoteAddr().getAddress().to_v6();
+    const asio::ip::address_v6::bytes_type bytes = remote.to_bytes();
+    memcpy(&addr->sin6_addr, &bytes[0], bytes.size());
+    if (remote.is_link_local() || remote.is_multicast()) {
+        addr->sin6_scope_id = pkt->getIndex();
+    }
+    pkt->updateTimestamp();
+    queue(pkt->getBuffer(), sizeof(*addr));
+}
+
+void
+Sender::queue(const util::OutputBuffer& buf, const socklen_t addr_len) {
+    const uint8_t* data = static_cast<const uint8_t*>(buf.getData());
+    data_[count_].assign(data, data + buf.getLength());
+    addr_lens_[count_] = addr_len;
+    if (++count_ == BATCH_SIZE) {
+        flush();
+    }
+}
+
+void
+Sender::flush() {
+    size_t sent = 0;
+#if defined(OS_LINUX)
+    struct mmsghdr msgs[BATCH_SIZE];
+    struct iovec iovs[BATCH_SIZE];
+    memset(msgs, 0, sizeof(msgs));
+    for (size_t i = 0; i < count_; ++i) {
+        iovs[i].iov_base = &data_[i][0];
+        iovs[i].iov_len = data_[i].size();
+        msgs[i].msg_hdr.msg_name = &addrs_[i];
+        msgs[i].msg_hdr.msg_namelen = addr_lens_[i];
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    while (sent < count_) {
+        // The call may send only a part of the batch.
+        const int result = sendmmsg(socket_, msgs + sent, count_ - sent, 0);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        sent += result;
+    }
+#else
+    for (; sent < count_; ++sent) {
+        if (sendto(socket_, &data_[sent][0], data_[sent].size(), 0,
+                   reinterpret_cast<struct sockaddr*>(&addrs_[sent]),
+                   addr_lens_[sent]) < 0) {
+            break;
+        }
+    }
+#endif
+    const size_t queued = count_;
+    count_ = 0;
+    if (sent < queued) {
+        isc_throw(SocketWriteError, "failed to send " << (queued - sent)
+                  << " of " << queued << " packets: " << strerror(errno));
+    }
+}
+
+} // namespace perfdhcp
+} // namespace isc
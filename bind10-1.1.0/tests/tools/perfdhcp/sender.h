@@ -0,0 +1,105 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef SENDER_H
+#define SENDER_H
+
+#include <dhcp/pkt4.h>
+#include <dhcp/pkt6.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+#include <sys/socket.h>
+
+namespace isc {
+namespace perfdhcp {
+
+/// \brief Sends packets in batches.
+///
+/// The packets are packed by the caller and queued by send(). They are
+/// written to the socket with a single sendmmsg() system call when the
+/// batch is full or when flush() is called. On systems which don't provide
+/// sendmmsg(), each packet is written by a separate sendto() call.
+///
+/// The packets are sent directly through the socket descriptor, so the
+/// outgoing interface of the broadcast DHCPv4 messages is selected by the
+/// routing table. The interface index of the DHCPv6 packet is used as the
+/// scope of the link-local and multicast destination addresses.
+class Sender : public boost::noncopyable {
+public:
+    /// Maximum number of packets sent at once.
+    static const size_t BATCH_SIZE = 64;
+
+    /// \brief Constructor.
+    ///
+    /// \param socket descriptor of the socket the packets are sent through.
+    explicit Sender(const int socket);
+
+    /// \brief Queues DHCPv4 packet.
+    ///
+    /// The packet must be packed. Its timestamp is updated.
+    ///
+    /// \param pkt packet to be sent.
+    /// \throw isc::dhcp::SocketWriteError if the batch is full and
+    /// sending it failed.
+    void send(const dhcp::Pkt4Ptr& pkt);
+
+    /// \brief Queues DHCPv6 packet.
+    ///
+    /// The packet must be packed. Its timestamp is updated.
+    ///
+    /// \param pkt packet to be sent.
+    /// \throw isc::dhcp::SocketWriteError if the batch is full and
+    /// sending it failed.
+    void send(const dhcp::Pkt6Ptr& pkt);
+
+    /// \brief Sends all queued packets.
+    ///
+    /// \throw isc::dhcp::SocketWriteError if sending failed.
+    void flush();
+
+    /// \brief Returns number of queued packets.
+    size_t getQueuedNum() const { return (count_); }
+
+private:
+    /// \brief Copies the packet data and the destination to the batch.
+    ///
+    /// \param buf on-wire data of the packet.
+    /// \param addr_len length of the destination address held in
+    /// the addrs_[count_].
+    void queue(const util::OutputBuffer& buf, const socklen_t addr_len);
+
+    /// Socket descriptor.
+    int socket_;
+    /// Data of the queued packets.
+    std::vector<std::vector<uint8_t> > data_;
+    /// Destinations of the queued packets.
+    std::vector<struct sockaddr_storage> addrs_;
+    /// Lengths of the destination addresses.
+    std::vector<socklen_t> addr_lens_;
+    /// Number of queued packets.
+    size_t count_;
+};
+
+/// Pointer to the Sender.
+typedef boost::shared_ptr<Sender> SenderPtr;
+
+} // namespace perfdhcp
+} // namespace isc
+
+#endif // SENDER_H
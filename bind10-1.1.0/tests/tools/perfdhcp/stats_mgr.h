@@ -15,8 +15,11 @@
 #ifndef STATS_MGR_H
 #define STATS_MGR_H
 
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <sstream>
+#include <string>
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
@@ -29,6 +32,8 @@
 
 #include <exceptions/exceptions.h>
 
+#include "latency_histogram.h"
+
 namespace isc {
 namespace perfdhcp {
 
@@ -120,9 +125,34 @@ public:
         XCHG_DO,  ///< DHCPv4 DISCOVER-OFFER
         XCHG_RA,  ///< DHCPv4 REQUEST-ACK
         XCHG_SA,  ///< DHCPv6 SOLICIT-ADVERTISE
-        XCHG_RR   ///< DHCPv6 REQUEST-REPLY
+        XCHG_RR,  ///< DHCPv6 REQUEST-REPLY
+        XCHG_RN,  ///< DHCPv4 REQUEST-ACK / DHCPv6 RENEW-REPLY (renewing)
+        XCHG_RB,  ///< DHCPv4 REQUEST-ACK / DHCPv6 REBIND-REPLY (rebinding)
+        XCHG_RL,  ///< DHCPv6 RELEASE-REPLY
+        XCHG_DC   ///< DHCPv6 DECLINE-REPLY
     };
 
+    /// Number of percentiles of packet delays in the reports.
+    static const int PERCENTILES_NUM = 4;
+
+    /// \brief Return percentiles of packet delays in the reports.
+    ///
+    /// \return array of \ref PERCENTILES_NUM percentiles.
+    static const double* percentiles() {
+        static const double values[PERCENTILES_NUM] = { 50, 90, 99, 99.9 };
+        return(values);
+    }
+
+    /// \brief Return name of the percentile in the time series.
+    ///
+    /// \param index index of the percentile in \ref percentiles.
+    /// \return name of the percentile, e.g. p99.9_ms.
+    static std::string percentileName(const int index) {
+        std::ostringstream name;
+        name << "p" << percentiles()[index] << "_ms";
+        return(name.str());
+    }
+
     /// \brief Exchange Statistics.
     ///
     /// This class collects statistics for exchanges. Parent class
@@ -274,6 +304,8 @@ public:
               max_delay_(0.),
               sum_delay_(0.),
               sum_delay_squared_(0.),
+              delays_(),
+              interval_delays_(),
               orphans_(0),
               collected_(0),
               unordered_lookup_size_sum_(0),
@@ -364,6 +396,10 @@ public:
             // mean delays.
             sum_delay_ += delta;
             sum_delay_squared_ += delta * delta;
+            // Count the delay in the histograms from which the percentiles
+            // for the whole test and for the report interval are taken.
+            delays_.add(delta);
+            interval_delays_.add(delta);
         }
 
         /// \brief Match received packet with the corresponding sent packet.
@@ -530,6 +566,30 @@ public:
                         getAvgDelay() * getAvgDelay()));
         }
 
+        /// \brief Return histogram of packet delays.
+        ///
+        /// The histogram holds delays of all packets received since
+        /// the beginning of the test.
+        ///
+        /// \return histogram of packet delays.
+        const LatencyHistogram& getDelays() const { return(delays_); }
+
+        /// \brief Return histogram of packet delays in report interval.
+        ///
+        /// The histogram holds delays of packets received since the last
+        /// call to \ref resetInterval.
+        ///
+        /// \return histogram of packet delays.
+        const LatencyHistogram& getIntervalDelays() const {
+            return(interval_delays_);
+        }
+
+        /// \brief Start new report interval.
+        ///
+        /// Method removes delays from the histogram returned by
+        /// \ref getIntervalDelays.
+        void resetInterval() { interval_delays_.clear(); }
+
         /// \brief Return number of orphant packets.
         ///
         /// Method returns number of received packets that had no matching
@@ -632,8 +692,9 @@ public:
         ///
         /// Method prints round trip time packets statistics. Statistics
         /// includes minimum packet delay, maximum packet delay, average
-        /// packet delay and standard deviation of delays. Packet delay
-        /// is a duration between sending a packet to server and receiving
+        /// packet delay, standard deviation of delays and the 50th, 90th,
+        /// 99th and 99.9th percentiles of delays. Packet delay is a
+        /// duration between sending a packet to server and receiving
         /// response from server.
         void printRTTStats() const {
             using namespace std;
@@ -643,8 +704,18 @@ public:
                      << "avg delay: " << getAvgDelay() * 1e3 << " ms" << endl
                      << "max delay: " << getMaxDelay() * 1e3 << " ms" << endl
                      << "std deviation: " << getStdDevDelay() * 1e3 << " ms"
-                     << endl
-                     << "collected packets: " << getCollectedNum() << endl;
+                     << endl;
+                if (delays_.getCount() > 0) {
+                    cout << "p50 delay: " << delays_.getPercentile(50) * 1e3
+                         << " ms" << endl
+                         << "p90 delay: " << delays_.getPercentile(90) * 1e3
+                         << " ms" << endl
+                         << "p99 delay: " << delays_.getPercentile(99) * 1e3
+                         << " ms" << endl
+                         << "p99.9 delay: "
+                         << delays_.getPercentile(99.9) * 1e3 << " ms" << endl;
+                }
+                cout << "collected packets: " << getCollectedNum() << endl;
             } catch (const Exception& e) {
                 cout << "Delay summary unavailable! No packets received." << endl;
             }
@@ -786,6 +857,14 @@ public:
         double sum_delay_squared_;     ///< Squared sum of delays between
                                        ///< sent and recived packets.
 
+        /// Histogram of delays of all received packets. It is used to
+        /// calculate percentiles for the final report.
+        LatencyHistogram delays_;
+
+        /// Histogram of delays of packets received in the current report
+        /// interval.
+        LatencyHistogram interval_delays_;
+
         uint64_t orphans_;   ///< Number of orphant received packets.
 
         uint64_t collected_; ///< Number of garbage collected packets.
@@ -1013,6 +1092,36 @@ public:
         return(xchg_stats->getStdDevDelay());
     }
 
+    /// \brief Return percentile of packet delays.
+    ///
+    /// Method returns percentile of delays of all packets received
+    /// for specified exchange type.
+    ///
+    /// \param xchg_type exchange type.
+    /// \param percentile percentile in the range of 0 to 100.
+    /// \throw isc::BadValue if invalid exchange type or percentile
+    /// specified.
+    /// \throw isc::InvalidOperation if no packets have been received.
+    /// \return percentile of packet delays.
+    double getDelayPercentile(const ExchangeType xchg_type,
+                              const double percentile) const {
+        ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
+        return(xchg_stats->getDelays().getPercentile(percentile));
+    }
+
+    /// \brief Return number of packets received in report interval.
+    ///
+    /// Method returns number of packets received for specified exchange
+    /// type since the last call to \ref resetInterval.
+    ///
+    /// \param xchg_type exchange type.
+    /// \throw isc::BadValue if invalid exchange type specified.
+    /// \return number of received packets.
+    uint64_t getIntervalRcvdPacketsNum(const ExchangeType xchg_type) const {
+        ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
+        return(xchg_stats->getIntervalDelays().getCount());
+    }
+
     /// \brief Return number of orphant packets.
     ///
     /// Method returns number of orphant packets for specified
@@ -1157,6 +1266,14 @@ public:
             return("SOLICIT-ADVERTISE");
         case XCHG_RR:
             return("REQUEST-REPLY");
+        case XCHG_RN:
+            return("RENEW");
+        case XCHG_RB:
+            return("REBIND");
+        case XCHG_RL:
+            return("RELEASE-REPLY");
+        case XCHG_DC:
+            return("DECLINE-REPLY");
         default:
             return("Unknown exchange type");
         }
@@ -1197,11 +1314,13 @@ public:
     ///
     /// Method prints intermediate statistics for all exchanges.
     /// Statistics includes sent, received and dropped packets
-    /// counters.
+    /// counters and percentiles of delays of packets received in
+    /// the current report interval.
     void printIntermediateStats() const {
         std::ostringstream stream_sent;
         std::ostringstream stream_rcvd;
         std::ostringstream stream_drops;
+        std::ostringstream stream_percentiles[PERCENTILES_NUM];
         std::string sep("");
         for (ExchangesMapIterator it = exchanges_.begin();
              it != exchanges_.end(); ++it) {
@@ -1212,11 +1331,109 @@ public:
             stream_sent << sep << it->second->getSentPacketsNum();
             stream_rcvd << sep << it->second->getRcvdPacketsNum();
             stream_drops << sep << it->second->getDroppedPacketsNum();
+            const LatencyHistogram& delays = it->second->getIntervalDelays();
+            for (int i = 0; i < PERCENTILES_NUM; ++i) {
+                stream_percentiles[i] << sep;
+                if (delays.getCount() > 0) {
+                    stream_percentiles[i]
+                        << std::fixed << std::setprecision(3)
+                        << delays.getPercentile(percentiles()[i]) * 1e3;
+                } else {
+                    stream_percentiles[i] << "-";
+                }
+            }
         }
         std::cout << "sent: " << stream_sent.str()
                   << "; received: " << stream_rcvd.str()
-                  << "; drops: " << stream_drops.str()
-                  << std::endl;
+                  << "; drops: " << stream_drops.str();
+        for (int i = 0; i < PERCENTILES_NUM; ++i) {
+            std::cout << "; p" << percentiles()[i] << ": "
+                      << stream_percentiles[i].str() << " ms";
+        }
+        std::cout << std::endl;
+    }
+
+    /// \brief Start new report interval.
+    ///
+    /// Method discards delays of packets received in the current report
+    /// interval for all exchanges, so as the percentiles printed by
+    /// the next call to \ref printIntermediateStats or
+    /// \ref printTimeSeries are calculated from the new packets only.
+    void resetInterval() {
+        for (ExchangesMapIterator it = exchanges_.begin();
+             it != exchanges_.end(); ++it) {
+            it->second->resetInterval();
+        }
+    }
+
+    /// \brief Print header of the CSV time series.
+    ///
+    /// \param out stream the header is written to.
+    static void printTimeSeriesHeader(std::ostream& out) {
+        out << "time,exchange,sent,received,drops,interval_received";
+        for (int i = 0; i < PERCENTILES_NUM; ++i) {
+            out << "," << percentileName(i);
+        }
+        out << ",max_ms" << std::endl;
+    }
+
+    /// \brief Print statistics of the report interval.
+    ///
+    /// Method writes one record for each exchange type. The record holds
+    /// the time elapsed since the beginning of the test (in seconds),
+    /// the name of the exchange, total numbers of sent, received and
+    /// dropped packets, the number of packets received in the report
+    /// interval and the percentiles and maximum of their delays (in
+    /// milliseconds). The delays are left empty (CSV) or set to null
+    /// (JSON) if no packets have been received in the interval.
+    ///
+    /// The CSV records follow the header printed with
+    /// \ref printTimeSeriesHeader. In the JSON format each record is an
+    /// object printed on a separate line.
+    ///
+    /// \param out stream the records are written to.
+    /// \param json true if records are printed in the JSON format,
+    /// false if in the CSV format.
+    void printTimeSeries(std::ostream& out, const bool json) const {
+        const double elapsed =
+            getTestPeriod().length().total_microseconds() / 1e6;
+        const std::string sep(json ? ", " : ",");
+        for (ExchangesMapIterator it = exchanges_.begin();
+             it != exchanges_.end(); ++it) {
+            const ExchangeStatsPtr& xchg_stats = it->second;
+            const LatencyHistogram& delays = xchg_stats->getIntervalDelays();
+            const std::string empty(json ? "null" : "");
+            out << std::fixed << std::setprecision(3);
+            if (json) {
+                out << "{\"time\": " << elapsed
+                    << ", \"exchange\": \"" << exchangeToString(it->first)
+                    << "\", \"sent\": " << xchg_stats->getSentPacketsNum()
+                    << ", \"received\": " << xchg_stats->getRcvdPacketsNum()
+                    << ", \"drops\": " << xchg_stats->getDroppedPacketsNum()
+                    << ", \"interval_received\": " << delays.getCount();
+            } else {
+                out << elapsed << "," << exchangeToString(it->first)
+                    << "," << xchg_stats->getSentPacketsNum()
+                    << "," << xchg_stats->getRcvdPacketsNum()
+                    << "," << xchg_stats->getDroppedPacketsNum()
+                    << "," << delays.getCount();
+            }
+            for (int i = 0; i <= PERCENTILES_NUM; ++i) {
+                out << sep;
+                if (json) {
+                    out << "\"" << (i < PERCENTILES_NUM ? percentileName(i) :
+                                    "max_ms") << "\": ";
+                }
+                if (delays.getCount() == 0) {
+                    out << empty;
+                } else if (i < PERCENTILES_NUM) {
+                    out << delays.getPercentile(percentiles()[i]) * 1e3;
+                } else {
+                    out << delays.getMax() * 1e3;
+                }
+            }
+            out << (json ? "}" : "") << std::endl;
+        }
     }
 
     /// \brief Print timestamps of all packets.
@@ -19,21 +19,25 @@
 #include <dhcp/iface_mgr.h>
 #include <dhcp/dhcp4.h>
 #include <dhcp/option6_ia.h>
+#include <dhcp/option6_iaaddr.h>
 #include <util/unittests/check_valgrind.h>
 #include "test_control.h"
 #include "command_options.h"
 #include "perf_pkt4.h"
 #include "perf_pkt6.h"
 
+#include <algorithm>
 #include <fstream>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <sched.h>
 #include <signal.h>
 #include <sys/wait.h>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/scoped_ptr.hpp>
 
 using namespace std;
 using namespace boost::posix_time;
@@ -44,6 +48,37 @@ using namespace isc::asiolink;
 namespace isc {
 namespace perfdhcp {
 
+namespace {
+
+/// \brief Returns the value of the DHCPv4 option holding a time.
+///
+/// \param pkt4 packet holding the option.
+/// \param type type of the option.
+/// \return value of the option or 0 if there is no such option.
+uint32_t
+getTimeOption4(const Pkt4Ptr& pkt4, const uint16_t type) {
+    OptionPtr option = pkt4->getOption(type);
+    if (!option || (option->getData().size() < sizeof(uint32_t))) {
+        return (0);
+    }
+    return (option->getUint32());
+}
+
+/// \brief Chooses whether the simulated client keeps the new lease.
+///
+/// \param [out] decline set if the client declines the lease.
+/// \param [out] release set if the client releases the lease at T1.
+void
+chooseLeaseAction(bool& decline, bool& release) {
+    CommandOptions& options = CommandOptions::instance();
+    const double draw = 100.0 * random() / (RAND_MAX + 1.0);
+    decline = (draw < options.getDeclineRatio());
+    release = !decline &&
+        (draw < options.getDeclineRatio() + options.getReleaseRatio());
+}
+
+}
+
 bool TestControl::interrupted_ = false;
 
 TestControl::TestControlSocket::TestControlSocket(const int socket) :
@@ -97,6 +132,17 @@ TestControl::TestControl() {
     reset();
 }
 
+bool
+TestControl::acquireClient(uint32_t& client, const bool preload) {
+    if (!clients_->acquire(getClientTime(), client)) {
+        if (!preload) {
+            incrementCounter("noclient");
+        }
+        return (false);
+    }
+    return (true);
+}
+
 std::string
 TestControl::byte2Hex(const uint8_t b) const {
     const int b1 = b / 16;
@@ -115,7 +161,7 @@ TestControl::checkExitConditions() const {
     bool test_period_reached = false;
     // Check if test period passed.
     if (options.getPeriod() != 0) {
-        if (options.getIpVersion() == 4) {
+        if (options.isDhcp4()) {
             time_period period(stats_mgr4_->getTestPeriod());
             if (period.length().total_seconds() >= options.getPeriod()) {
                 test_period_reached = true;
@@ -137,7 +183,7 @@ TestControl::checkExitConditions() const {
     bool max_requests = false;
     // Check if we reached maximum number of DISCOVER/SOLICIT sent.
     if (options.getNumRequests().size() > 0) {
-        if (options.getIpVersion() == 4) {
+        if (options.isDhcp4()) {
             if (getSentPacketsNum(StatsMgr4::XCHG_DO) >=
                 options.getNumRequests()[0]) {
                 max_requests = true;
@@ -151,7 +197,7 @@ TestControl::checkExitConditions() const {
     }
     // Check if we reached maximum number REQUEST packets.
     if (options.getNumRequests().size() > 1) {
-        if (options.getIpVersion() == 4) {
+        if (options.isDhcp4()) {
             if (stats_mgr4_->getSentPacketsNum(StatsMgr4::XCHG_RA) >=
                 options.getNumRequests()[1]) {
                 max_requests = true;
@@ -173,7 +219,7 @@ TestControl::checkExitConditions() const {
     // Check if we reached maximum number of drops of OFFER/ADVERTISE packets.
     bool max_drops = false;
     if (options.getMaxDrop().size() > 0) {
-        if (options.getIpVersion() == 4) {
+        if (options.isDhcp4()) {
             if (stats_mgr4_->getDroppedPacketsNum(StatsMgr4::XCHG_DO) >=
                 options.getMaxDrop()[0]) {
                 max_drops = true;
@@ -187,7 +233,7 @@ TestControl::checkExitConditions() const {
     }
     // Check if we reached maximum number of drops of ACK/REPLY packets.
     if (options.getMaxDrop().size() > 1) {
-        if (options.getIpVersion() == 4) {
+        if (options.isDhcp4()) {
             if (stats_mgr4_->getDroppedPacketsNum(StatsMgr4::XCHG_RA) >=
                 options.getMaxDrop()[1]) {
                 max_drops = true;
@@ -209,7 +255,7 @@ TestControl::checkExitConditions() const {
     // Check if we reached maximum drops percentage of OFFER/ADVERTISE packets.
     bool max_pdrops = false;
     if (options.getMaxDropPercentage().size() > 0) {
-        if (options.getIpVersion() == 4) {
+        if (options.isDhcp4()) {
             if ((stats_mgr4_->getSentPacketsNum(StatsMgr4::XCHG_DO) > 10) &&
                 ((100. * stats_mgr4_->getDroppedPacketsNum(StatsMgr4::XCHG_DO) /
                  stats_mgr4_->getSentPacketsNum(StatsMgr4::XCHG_DO)) >=
@@ -228,7 +274,7 @@ TestControl::checkExitConditions() const {
     }
     // Check if we reached maximum drops percentage of ACK/REPLY packets.
     if (options.getMaxDropPercentage().size() > 1) {
-        if (options.getIpVersion() == 4) {
+        if (options.isDhcp4()) {
             if ((stats_mgr4_->getSentPacketsNum(StatsMgr4::XCHG_RA) > 10) &&
                 ((100. * stats_mgr4_->getDroppedPacketsNum(StatsMgr4::XCHG_RA) /
                  stats_mgr4_->getSentPacketsNum(StatsMgr4::XCHG_RA)) >=
@@ -380,9 +426,27 @@ TestControl::generateDuid(uint8_t& randomized) const {
     return (duid);
 }
 
+std::vector<uint8_t>
+TestControl::getClientDuid(const uint32_t client) const {
+    std::vector<uint8_t> duid(CommandOptions::instance().getDuidTemplate());
+    std::vector<uint8_t> mac_addr(clients_->getMacAddress(client));
+    if (duid.size() < mac_addr.size()) {
+        isc_throw(BadValue, "DUID template is too short to hold the MAC"
+                  " address of the client");
+    }
+    std::copy(mac_addr.begin(), mac_addr.end(),
+              duid.end() - mac_addr.size());
+    return (duid);
+}
+
+uint64_t
+TestControl::getClientTime() const {
+    return ((RateControl::currentTime() - clients_start_) / 1000000);
+}
+
 int
 TestControl::getElapsedTimeOffset() const {
-    int elp_offset = CommandOptions::instance().getIpVersion() == 4 ?
+    int elp_offset = CommandOptions::instance().isDhcp4() ?
         DHCPV4_ELAPSED_TIME_OFFSET : DHCPV6_ELAPSED_TIME_OFFSET;
     if (CommandOptions::instance().getElapsedTimeOffset() > 0) {
         elp_offset = CommandOptions::instance().getElapsedTimeOffset();
@@ -452,7 +516,7 @@ TestControl::getNextExchangesNum() const {
 
 int
 TestControl::getRandomOffset(const int arg_idx) const {
-    int rand_offset = CommandOptions::instance().getIpVersion() == 4 ?
+    int rand_offset = CommandOptions::instance().isDhcp4() ?
         DHCPV4_RANDOMIZATION_OFFSET : DHCPV6_RANDOMIZATION_OFFSET;
     if (CommandOptions::instance().getRandomOffset().size() > arg_idx) {
         rand_offset = CommandOptions::instance().getRandomOffset()[arg_idx];
@@ -462,7 +526,7 @@ TestControl::getRandomOffset(const int arg_idx) const {
 
 int
 TestControl::getRequestedIpOffset() const {
-    int rip_offset = CommandOptions::instance().getIpVersion() == 4 ?
+    int rip_offset = CommandOptions::instance().isDhcp4() ?
         DHCPV4_REQUESTED_IP_OFFSET : DHCPV6_IA_NA_OFFSET;
     if (CommandOptions::instance().getRequestedIpOffset() > 0) {
         rip_offset = CommandOptions::instance().getRequestedIpOffset();
@@ -472,8 +536,7 @@ TestControl::getRequestedIpOffset() const {
 
 uint64_t
 TestControl::getRcvdPacketsNum(const ExchangeType xchg_type) const {
-    uint8_t ip_version = CommandOptions::instance().getIpVersion();
-    if (ip_version == 4) {
+    if (CommandOptions::instance().isDhcp4()) {
         return (stats_mgr4_->getRcvdPacketsNum(xchg_type));
     }
     return (stats_mgr6_->
@@ -482,8 +545,7 @@ TestControl::getRcvdPacketsNum(const ExchangeType xchg_type) const {
 
 uint64_t
 TestControl::getSentPacketsNum(const ExchangeType xchg_type) const {
-    uint8_t ip_version = CommandOptions::instance().getIpVersion();
-    if (ip_version == 4) {
+    if (CommandOptions::instance().isDhcp4()) {
         return (stats_mgr4_->getSentPacketsNum(xchg_type));
     }
     return (stats_mgr6_->
@@ -492,7 +554,7 @@ TestControl::getSentPacketsNum(const ExchangeType xchg_type) const {
 
 int
 TestControl::getServerIdOffset() const {
-    int srvid_offset = CommandOptions::instance().getIpVersion() == 4 ?
+    int srvid_offset = CommandOptions::instance().isDhcp4() ?
         DHCPV4_SERVERID_OFFSET : DHCPV6_SERVERID_OFFSET;
     if (CommandOptions::instance().getServerIdOffset() > 0) {
         srvid_offset = CommandOptions::instance().getServerIdOffset();
@@ -510,7 +572,7 @@ TestControl::getTemplateBuffer(const size_t idx) const {
 
 int
 TestControl::getTransactionIdOffset(const int arg_idx) const {
-    int xid_offset = CommandOptions::instance().getIpVersion() == 4 ?
+    int xid_offset = CommandOptions::instance().isDhcp4() ?
         DHCPV4_TRANSID_OFFSET : DHCPV6_TRANSID_OFFSET;
     if (CommandOptions::instance().getTransactionIdOffset().size() > arg_idx) {
         xid_offset = CommandOptions::instance().getTransactionIdOffset()[arg_idx];
@@ -531,6 +593,15 @@ TestControl::handleInterrupt(int) {
     interrupted_ = true;
 }
 
+void
+TestControl::incrementCounter(const std::string& counter_key) {
+    if (CommandOptions::instance().isDhcp4()) {
+        stats_mgr4_->incrementCounter(counter_key);
+    } else {
+        stats_mgr6_->incrementCounter(counter_key);
+    }
+}
+
 void
 TestControl::initPacketTemplates() {
     template_packets_v4_.clear();
@@ -551,7 +622,7 @@ TestControl::initializeStatsMgr() {
     // requested diagnostics option -x t we have to enable
     // it so as StatsMgr preserves all packets.
     const bool archive_mode = testDiags('t') ? true : false;
-    if (options.getIpVersion() == 4) {
+    if (options.isDhcp4()) {
         stats_mgr4_.reset();
         stats_mgr4_ = StatsMgr4Ptr(new StatsMgr4(archive_mode));
         stats_mgr4_->addExchangeStats(StatsMgr4::XCHG_DO,
@@ -560,6 +631,12 @@ TestControl::initializeStatsMgr() {
             stats_mgr4_->addExchangeStats(StatsMgr4::XCHG_RA,
                                           options.getDropTime()[1]);
         }
+        if (options.isDhcp4o6()) {
+            stats_mgr4_->addCustomCounter("unexpected4o6",
+                                          "Unexpected DHCPv6 messages");
+            stats_mgr4_->addCustomCounter("badresp4o6",
+                                          "Malformed DHCPV4-RESPONSE messages");
+        }
 
     } else if (options.getIpVersion() == 6) {
         stats_mgr6_.reset();
@@ -571,8 +648,39 @@ TestControl::initializeStatsMgr() {
                                           options.getDropTime()[1]);
         }
     }
+    if (options.getSimulatedClientsNum() > 0) {
+        if (options.isDhcp4()) {
+            stats_mgr4_->addExchangeStats(StatsMgr4::XCHG_RN,
+                                          options.getDropTime()[1]);
+            stats_mgr4_->addExchangeStats(StatsMgr4::XCHG_RB,
+                                          options.getDropTime()[1]);
+            stats_mgr4_->addCustomCounter("noclient", "Exchanges not "
+                                          "initiated (no free clients)");
+            stats_mgr4_->addCustomCounter("release", "Released leases");
+            stats_mgr4_->addCustomCounter("decline", "Declined leases");
+            stats_mgr4_->addCustomCounter("expired", "Expired leases");
+            stats_mgr4_->addCustomCounter("timeout", "Abandoned exchanges");
+            stats_mgr4_->addCustomCounter("nak", "Refused leases");
+        } else {
+            stats_mgr6_->addExchangeStats(StatsMgr6::XCHG_RN,
+                                          options.getDropTime()[1]);
+            stats_mgr6_->addExchangeStats(StatsMgr6::XCHG_RB,
+                                          options.getDropTime()[1]);
+            stats_mgr6_->addExchangeStats(StatsMgr6::XCHG_RL,
+                                          options.getDropTime()[1]);
+            stats_mgr6_->addExchangeStats(StatsMgr6::XCHG_DC,
+                                          options.getDropTime()[1]);
+            stats_mgr6_->addCustomCounter("noclient", "Exchanges not "
+                                          "initiated (no free clients)");
+            stats_mgr6_->addCustomCounter("release", "Released leases");
+            stats_mgr6_->addCustomCounter("decline", "Declined leases");
+            stats_mgr6_->addCustomCounter("expired", "Expired leases");
+            stats_mgr6_->addCustomCounter("timeout", "Abandoned exchanges");
+            stats_mgr6_->addCustomCounter("nak", "Refused leases");
+        }
+    }
     if (testDiags('i')) {
-        if (options.getIpVersion() == 4) {
+        if (options.isDhcp4()) {
             stats_mgr4_->addCustomCounter("latesend", "Late sent packets");
             stats_mgr4_->addCustomCounter("shortwait", "Short waits for packets");
             stats_mgr4_->addCustomCounter("multircvd", "Multiple packets receives");
@@ -688,7 +796,7 @@ TestControl::sendPackets(const TestControlSocket& socket,
                          const bool preload /* = false */) {
     CommandOptions& options = CommandOptions::instance();
     for (uint64_t i = packets_num; i > 0; --i) {
-        if (options.getIpVersion() == 4) {
+        if (options.isDhcp4()) {
             // No template packets means that no -T option was specified.
             // We have to build packets ourselfs.
             if (template_buffers_.size() == 0) {
@@ -713,7 +821,7 @@ TestControl::sendPackets(const TestControlSocket& socket,
         if (!preload) {
             uint64_t latercvd = receivePackets(socket);
             if (testDiags('i')) {
-                if (options.getIpVersion() == 4) {
+                if (options.isDhcp4()) {
                     stats_mgr4_->incrementCounter("latercvd", latercvd);
                 } else if (options.getIpVersion() == 6) {
                     stats_mgr6_->incrementCounter("latercvd", latercvd);
@@ -742,7 +850,7 @@ void
 TestControl::printTemplate(const uint8_t packet_type) const {
     std::string hex_buf;
     int arg_idx = 0;
-    if (CommandOptions::instance().getIpVersion() == 4) {
+    if (CommandOptions::instance().isDhcp4()) {
         if (packet_type == DHCPREQUEST) {
             arg_idx = 1;
         }
@@ -798,7 +906,7 @@ TestControl::printTemplate(const uint8_t packet_type) const {
 void
 TestControl::printTemplates() const {
     CommandOptions& options = CommandOptions::instance();
-    if (options.getIpVersion() == 4) {
+    if (options.isDhcp4()) {
         printTemplate(DHCPDISCOVER);
         printTemplate(DHCPREQUEST);
     } else if (options.getIpVersion() == 6) {
@@ -811,7 +919,7 @@ void
 TestControl::printRate() const {
     double rate = 0;
     CommandOptions& options = CommandOptions::instance();
-    if (options.getIpVersion() == 4) {
+    if (options.isDhcp4()) {
         double duration =
             stats_mgr4_->getTestPeriod().length().total_nanoseconds() / 1e9;
         rate = stats_mgr4_->getRcvdPacketsNum(StatsMgr4::XCHG_DO) / duration;
@@ -836,26 +944,50 @@ TestControl::printIntermediateStats() {
     ptime now = microsec_clock::universal_time();
     time_period time_since_report(last_report_, now);
     if (time_since_report.length().total_seconds() >= delay) {
-        if (options.getIpVersion() == 4) {
+        if (options.isDhcp4()) {
             stats_mgr4_->printIntermediateStats();
         } else if (options.getIpVersion() == 6) {
             stats_mgr6_->printIntermediateStats();
         }
+        printTimeSeries();
+        // The next report includes delays of packets received from now.
+        if (options.isDhcp4()) {
+            stats_mgr4_->resetInterval();
+        } else if (options.getIpVersion() == 6) {
+            stats_mgr6_->resetInterval();
+        }
         last_report_ = now;
     }
 }
 
+void
+TestControl::printTimeSeries() {
+    if (!time_series_.is_open()) {
+        return;
+    }
+    CommandOptions& options = CommandOptions::instance();
+    const bool json = (options.getTimeSeriesFormat() == "json");
+    if (options.isDhcp4()) {
+        stats_mgr4_->printTimeSeries(time_series_, json);
+    } else if (options.getIpVersion() == 6) {
+        stats_mgr6_->printTimeSeries(time_series_, json);
+    }
+}
+
 void
 TestControl::printStats() const {
     printRate();
     CommandOptions& options = CommandOptions::instance();
-    if (options.getIpVersion() == 4) {
+    if (options.isDhcp4()) {
         if (!stats_mgr4_) {
             isc_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
                       "hasn't been initialized");
         }
+        if (options.isDhcp4o6()) {
+            std::cout << "***DHCPv4 exchanges over DHCPv6***" << std::endl;
+        }
         stats_mgr4_->printStats();
-        if (testDiags('i')) {
+        if (testDiags('i') || options.isDhcp4o6() || clients_) {
             stats_mgr4_->printCustomCounters();
         }
     } else if (options.getIpVersion() == 6) {
@@ -864,10 +996,18 @@ TestControl::printStats() const {
                       "hasn't been initialized");
         }
         stats_mgr6_->printStats();
-        if (testDiags('i')) {
+        if (testDiags('i') || clients_) {
             stats_mgr6_->printCustomCounters();
         }
     }
+    if (clients_) {
+        std::cout << "***Simulated clients***" << std::endl;
+        for (int i = 0; i < ClientPool::STATES_NUM; ++i) {
+            const ClientPool::State state = static_cast<ClientPool::State>(i);
+            std::cout << ClientPool::stateToString(state) << ": "
+                      << clients_->getCount(state) << std::endl;
+        }
+    }
 }
 
 std::string
@@ -934,6 +1074,171 @@ TestControl::readPacketTemplate(const std::string& file_name) {
     template_buffers_.push_back(binary_stream);
 }
 
+void
+TestControl::processClientEvents(const TestControlSocket& socket) {
+    if (!clients_) {
+        return;
+    }
+    const bool dhcp4 = CommandOptions::instance().isDhcp4();
+    client_events_.clear();
+    clients_->getEvents(getClientTime(), client_events_);
+    for (std::vector<std::pair<uint32_t, ClientPool::Event> >::const_iterator
+             it = client_events_.begin(); it != client_events_.end(); ++it) {
+        const uint32_t client = it->first;
+        switch (it->second) {
+        case ClientPool::RENEW:
+            if (dhcp4) {
+                sendRenew4(socket, client, false);
+            } else {
+                sendLease6(socket, client, DHCPV6_RENEW);
+            }
+            break;
+        case ClientPool::REBIND:
+            if (dhcp4) {
+                sendRenew4(socket, client, true);
+            } else {
+                sendLease6(socket, client, DHCPV6_REBIND);
+            }
+            break;
+        case ClientPool::RELEASE:
+            if (dhcp4) {
+                sendRelease4(socket, client, false);
+            } else {
+                sendLease6(socket, client, DHCPV6_RELEASE);
+            }
+            break;
+        case ClientPool::EXPIRE:
+            incrementCounter("expired");
+            break;
+        case ClientPool::TIMEOUT:
+        default:
+            incrementCounter("timeout");
+        }
+    }
+}
+
+void
+TestControl::processLease4(const TestControlSocket& socket,
+                           const Pkt4Ptr& pkt4) {
+    uint32_t client = 0;
+    HWAddrPtr hwaddr = pkt4->getHWAddr();
+    if (!hwaddr || !clients_->findClient(hwaddr->hwaddr_, client)) {
+        stats_mgr4_->passRcvdPacket(StatsMgr4::XCHG_RA, pkt4);
+        return;
+    }
+    // The response belongs to the exchange the client is engaged in. Late
+    // responses to the exchanges the client has given up on are only
+    // passed to the Statistics Manager.
+    const ClientPool::State state = clients_->getState(client);
+    StatsMgr4::ExchangeType xchg_type = StatsMgr4::XCHG_RA;
+    if (state == ClientPool::RENEWING) {
+        xchg_type = StatsMgr4::XCHG_RN;
+    } else if (state == ClientPool::REBINDING) {
+        xchg_type = StatsMgr4::XCHG_RB;
+    }
+    if (!stats_mgr4_->passRcvdPacket(xchg_type, pkt4) ||
+        ((state != ClientPool::REQUESTING) &&
+         (state != ClientPool::RENEWING) &&
+         (state != ClientPool::REBINDING))) {
+        return;
+    }
+
+    const uint64_t now = getClientTime();
+    const uint32_t valid = getTimeOption4(pkt4, DHO_DHCP_LEASE_TIME);
+    if ((pkt4->getType() == DHCPNAK) || (valid == 0)) {
+        clients_->setState(client, ClientPool::FREE, now);
+        incrementCounter("nak");
+        return;
+    }
+    OptionPtr opt_serverid = pkt4->getOption(DHO_DHCP_SERVER_IDENTIFIER);
+    if (opt_serverid) {
+        lease_serverid_ = opt_serverid->getData();
+    }
+    bool decline = false;
+    bool release = false;
+    if (state == ClientPool::REQUESTING) {
+        chooseLeaseAction(decline, release);
+    }
+    const std::vector<uint8_t> address = pkt4->getYiaddr().toBytes();
+    clients_->bind(client, &address[0],
+                   getTimeOption4(pkt4, DHO_DHCP_RENEWAL_TIME),
+                   getTimeOption4(pkt4, DHO_DHCP_REBINDING_TIME),
+                   valid, release, now);
+    if (decline) {
+        sendRelease4(socket, client, true);
+    }
+}
+
+void
+TestControl::processLease6(const TestControlSocket& socket,
+                           const Pkt6Ptr& pkt6) {
+    uint32_t client = 0;
+    OptionPtr opt_clientid = pkt6->getOption(D6O_CLIENTID);
+    if (!opt_clientid ||
+        !clients_->findClient(opt_clientid->getData(), client)) {
+        stats_mgr6_->passRcvdPacket(StatsMgr6::XCHG_RR, pkt6);
+        return;
+    }
+    StatsMgr6::ExchangeType xchg_type = StatsMgr6::XCHG_RR;
+    switch (clients_->getState(client)) {
+    case ClientPool::REQUESTING:
+        break;
+    case ClientPool::RENEWING:
+        xchg_type = StatsMgr6::XCHG_RN;
+        break;
+    case ClientPool::REBINDING:
+        xchg_type = StatsMgr6::XCHG_RB;
+        break;
+    case ClientPool::RELEASING:
+        xchg_type = StatsMgr6::XCHG_RL;
+        break;
+    case ClientPool::DECLINING:
+        xchg_type = StatsMgr6::XCHG_DC;
+        break;
+    default:
+        // Late response to the exchange the client has given up on.
+        stats_mgr6_->passRcvdPacket(StatsMgr6::XCHG_RR, pkt6);
+        return;
+    }
+    if (!stats_mgr6_->passRcvdPacket(xchg_type, pkt6)) {
+        return;
+    }
+
+    const uint64_t now = getClientTime();
+    if ((xchg_type == StatsMgr6::XCHG_RL) ||
+        (xchg_type == StatsMgr6::XCHG_DC)) {
+        clients_->setState(client, ClientPool::FREE, now);
+        return;
+    }
+    boost::shared_ptr<Option6IA> opt_ia_na =
+        boost::dynamic_pointer_cast<Option6IA>(pkt6->getOption(D6O_IA_NA));
+    boost::shared_ptr<Option6IAAddr> opt_iaaddr;
+    if (opt_ia_na) {
+        opt_iaaddr = boost::dynamic_pointer_cast<
+            Option6IAAddr>(opt_ia_na->getOption(D6O_IAADDR));
+    }
+    if (!opt_iaaddr || (opt_iaaddr->getValid() == 0)) {
+        clients_->setState(client, ClientPool::FREE, now);
+        incrementCounter("nak");
+        return;
+    }
+    OptionPtr opt_serverid = pkt6->getOption(D6O_SERVERID);
+    if (opt_serverid) {
+        lease_serverid_ = opt_serverid->getData();
+    }
+    bool decline = false;
+    bool release = false;
+    if (xchg_type == StatsMgr6::XCHG_RR) {
+        chooseLeaseAction(decline, release);
+    }
+    const std::vector<uint8_t> address = opt_iaaddr->getAddress().toBytes();
+    clients_->bind(client, &address[0], opt_ia_na->getT1(),
+                   opt_ia_na->getT2(), opt_iaaddr->getValid(), release, now);
+    if (decline) {
+        sendLease6(socket, client, DHCPV6_DECLINE);
+    }
+}
+
 void
 TestControl::processReceivedPacket4(const TestControlSocket& socket,
                             const Pkt4Ptr& pkt4) {
@@ -950,12 +1255,51 @@ TestControl::processReceivedPacket4(const TestControlSocket& socket,
                 // used to access template_buffers_.
                 sendRequest4(socket, template_buffers_[1], discover_pkt4, pkt4);
             }
+            uint32_t client = 0;
+            if (clients_ && pkt4->getHWAddr() &&
+                clients_->findClient(pkt4->getHWAddr()->hwaddr_, client) &&
+                (clients_->getState(client) == ClientPool::SELECTING)) {
+                clients_->setState(client, ClientPool::REQUESTING,
+                                   getClientTime());
+            }
         }
+    } else if (clients_ && ((pkt4->getType() == DHCPACK) ||
+                            (pkt4->getType() == DHCPNAK))) {
+        processLease4(socket, pkt4);
     } else if (pkt4->getType() == DHCPACK) {
         stats_mgr4_->passRcvdPacket(StatsMgr4::XCHG_RA, pkt4);
     }
 }
 
+void
+TestControl::processReceivedPacket4o6(const TestControlSocket& socket,
+                                      const Pkt6Ptr& pkt6) {
+    if (pkt6->getType() != DHCPV4_RESPONSE) {
+        stats_mgr4_->incrementCounter("unexpected4o6");
+        return;
+    }
+    // The DHCPv4 message is carried in the DHCPv4 Message option.
+    Pkt4Ptr pkt4;
+    OptionPtr opt_msg = pkt6->getOption(OPTION_DHCPV4_MSG);
+    if (opt_msg && !opt_msg->getData().empty()) {
+        const OptionBuffer& data = opt_msg->getData();
+        try {
+            pkt4.reset(new Pkt4(&data[0], data.size()));
+            // The latency is measured from the receipt of the DHCPv6
+            // message carrying the DHCPv4 one.
+            pkt4->updateTimestamp();
+            pkt4->unpack();
+        } catch (const Exception&) {
+            pkt4.reset();
+        }
+    }
+    if (!pkt4) {
+        stats_mgr4_->incrementCounter("badresp4o6");
+        return;
+    }
+    processReceivedPacket4(socket, pkt4);
+}
+
 void
 TestControl::processReceivedPacket6(const TestControlSocket& socket,
                             const Pkt6Ptr& pkt6) {
@@ -976,7 +1320,17 @@ TestControl::processReceivedPacket6(const TestControlSocket& socket,
                 // used to access template_buffers_.
                 sendRequest6(socket, template_buffers_[1], pkt6);
             }
+            uint32_t client = 0;
+            OptionPtr opt_clientid = pkt6->getOption(D6O_CLIENTID);
+            if (clients_ && opt_clientid &&
+                clients_->findClient(opt_clientid->getData(), client) &&
+                (clients_->getState(client) == ClientPool::SELECTING)) {
+                clients_->setState(client, ClientPool::REQUESTING,
+                                   getClientTime());
+            }
         }
+    } else if ((packet_type == DHCPV6_REPLY) && clients_) {
+        processLease6(socket, pkt6);
     } else if (packet_type == DHCPV6_REPLY) {
         stats_mgr6_->passRcvdPacket(StatsMgr6::XCHG_RR, pkt6);
     }
@@ -991,7 +1345,8 @@ TestControl::receivePackets(const TestControlSocket& socket) {
         if (CommandOptions::instance().getIpVersion() == 4) {
             Pkt4Ptr pkt4;
             try {
-                pkt4 = IfaceMgr::instance().receive4(timeout);
+                pkt4 = receiver_ ? receiver_->getPkt4() :
+                    IfaceMgr::instance().receive4(timeout);
             } catch (const Exception& e) {
                 std::cerr << "Failed to receive DHCPv4 packet: "
                           << e.what() <<  std::endl;
@@ -1009,7 +1364,8 @@ TestControl::receivePackets(const TestControlSocket& socket) {
         } else if (CommandOptions::instance().getIpVersion() == 6) {
             Pkt6Ptr pkt6;
             try {
-                pkt6 = IfaceMgr::instance().receive6(timeout);
+                pkt6 = receiver_ ? receiver_->getPkt6() :
+                    IfaceMgr::instance().receive6(timeout);
             } catch (const Exception& e) {
                 std::cerr << "Failed to receive DHCPv6 packet: "
                           << e.what() << std::endl;
@@ -1018,6 +1374,15 @@ TestControl::receivePackets(const TestControlSocket& socket) {
                 receiving  = false;
             } else {
                 ++received;
+                if (CommandOptions::instance().isDhcp4o6()) {
+                    if ((received > 1) && testDiags('i')) {
+                        stats_mgr4_->incrementCounter("multircvd");
+                    }
+                    if (pkt6->unpack()) {
+                        processReceivedPacket4o6(socket, pkt6);
+                    }
+                    continue;
+                }
                 if ((received > 1) && testDiags('i')) {
                     stats_mgr6_->incrementCounter("multircvd");
                 }
@@ -1093,6 +1458,10 @@ TestControl::registerOptionFactories() const {
         break;
     case 6:
         registerOptionFactories6();
+        // DHCPv4 messages are built in the DHCPv4-over-DHCPv6 mode too.
+        if (options.isDhcp4o6()) {
+            registerOptionFactories4();
+        }
         break;
     default:
         isc_throw(InvalidOperation, "command line options have to be parsed "
@@ -1106,11 +1475,19 @@ TestControl::reset() {
     last_sent_ = send_due_;
     last_report_ = send_due_;
     transid_gen_.reset();
+    receiver_.reset();
+    sender_.reset();
+    if (time_series_.is_open()) {
+        time_series_.close();
+    }
     // Actual generators will have to be set later on because we need to
     // get command line parameters first.
     setTransidGenerator(NumberGeneratorPtr());
     setMacAddrGenerator(NumberGeneratorPtr());
     first_packet_serverid_.clear();
+    clients_.reset();
+    clients_start_ = 0;
+    lease_serverid_.clear();
     interrupted_ = false;
 }
 
@@ -1160,6 +1537,18 @@ TestControl::run() {
     // If user interrupts the program we will exit gracefully.
     signal(SIGINT, TestControl::handleInterrupt);
 
+    // The preload exchanges are initiated by the simulated clients too.
+    if (options.getSimulatedClientsNum() > 0) {
+        const std::vector<double>& drop_time = options.getDropTime();
+        clients_.reset(new ClientPool(options.getSimulatedClientsNum(),
+                                      options.isDhcp4() ? 4 : 16,
+                                      options.getMacTemplate(),
+                                      static_cast<uint32_t>(1000 *
+                                          std::max(drop_time[0],
+                                                   drop_time[1]))));
+        clients_start_ = RateControl::currentTime();
+    }
+
     // Preload server with the number of packets.
     sendPackets(socket, options.getPreload(), true);
 
@@ -1170,14 +1559,54 @@ TestControl::run() {
 
     // Initialize Statistics Manager. Release previous if any.
     initializeStatsMgr();
+
+    if (!options.getTimeSeriesFile().empty()) {
+        time_series_.open(options.getTimeSeriesFile().c_str());
+        if (!time_series_.is_open()) {
+            isc_throw(BadValue, "unable to open time series file "
+                      << options.getTimeSeriesFile());
+        }
+        if (options.getTimeSeriesFormat() == "csv") {
+            StatsMgr4::printTimeSeriesHeader(time_series_);
+        }
+    }
+
+    // In the multi-threaded mode the responses are received by separate
+    // threads and the packets are sent in batches at the rate controlled
+    // by the token bucket.
+    boost::scoped_ptr<RateControl> rate_control;
+    if (options.getThreadsNum() > 0) {
+        rate_control.reset(new RateControl(options.getRate(),
+                                           options.getAggressivity()));
+        receiver_.reset(new Receiver(socket.sockfd_,
+                                     options.getIpVersion() == 4 ?
+                                     AF_INET : AF_INET6,
+                                     options.getThreadsNum(),
+                                     options.isPinThreads()));
+        sender_.reset(new Sender(socket.sockfd_));
+        receiver_->start();
+    }
+
     for (;;) {
-        // Calculate send due based on when last exchange was initiated.
-        updateSendDue();
-        // Calculate number of packets to be sent to stay
-        // catch up with rate.
-        uint64_t packets_due = getNextExchangesNum();
+        uint64_t packets_due = 0;
+        if (rate_control) {
+            packets_due = rate_control->getOutboundMessageCount();
+            if (rate_control->isLate() && testDiags('i')) {
+                if (options.isDhcp4()) {
+                    stats_mgr4_->incrementCounter("latesend");
+                } else if (options.getIpVersion() == 6) {
+                    stats_mgr6_->incrementCounter("latesend");
+                }
+            }
+        } else {
+            // Calculate send due based on when last exchange was initiated.
+            updateSendDue();
+            // Calculate number of packets to be sent to stay
+            // catch up with rate.
+            packets_due = getNextExchangesNum();
+        }
         if ((packets_due == 0) && testDiags('i')) {
-            if (options.getIpVersion() == 4) {
+            if (options.isDhcp4()) {
                 stats_mgr4_->incrementCounter("shortwait");
             } else if (options.getIpVersion() == 6) {
                 stats_mgr6_->incrementCounter("shortwait");
@@ -1186,7 +1615,11 @@ TestControl::run() {
 
         // @todo: set non-zero timeout for packets once we implement
         // microseconds timeout in IfaceMgr.
-        receivePackets(socket);
+        const uint64_t received = receivePackets(socket);
+        // Let the receiving threads run if there is nothing to do.
+        if (receiver_ && (packets_due == 0) && (received == 0)) {
+            sched_yield();
+        }
 
         // If test period finished, maximum number of packet drops
         // has been reached or test has been interrupted we have to
@@ -1197,6 +1630,11 @@ TestControl::run() {
 
         // Initiate new DHCP packet exchanges.
         sendPackets(socket, packets_due);
+        // Renew, rebind and release the leases of the simulated clients.
+        processClientEvents(socket);
+        if (sender_) {
+            sender_->flush();
+        }
 
         // Report delay means that user requested printing number
         // of sent/received/dropped packets repeatedly.
@@ -1204,6 +1642,14 @@ TestControl::run() {
             printIntermediateStats();
         }
     }
+    if (receiver_) {
+        receiver_->stop();
+    }
+    // Record the last (incomplete) report interval.
+    printTimeSeries();
+    if (time_series_.is_open()) {
+        time_series_.close();
+    }
     printStats();
 
     if (!options.getWrapped().empty()) {
@@ -1213,7 +1659,7 @@ TestControl::run() {
 
     // Print packet timestamps
     if (testDiags('t')) {
-        if (options.getIpVersion() == 4) {
+        if (options.isDhcp4()) {
             stats_mgr4_->printTimestamps();
         } else if (options.getIpVersion() == 6) {
             stats_mgr6_->printTimestamps();
@@ -1237,7 +1683,7 @@ TestControl::run() {
 
     int ret_code = 0;
     // Check if any packet drops occured.
-    if (options.getIpVersion() == 4) {
+    if (options.isDhcp4()) {
         ret_code = stats_mgr4_->droppedPackets() ? 3 : 0;
     } else if (options.getIpVersion() == 6)  {
         ret_code = stats_mgr6_->droppedPackets() ? 3 : 0;
@@ -1285,8 +1731,17 @@ TestControl::sendDiscover4(const TestControlSocket& socket,
                            const bool preload /*= false*/) {
     last_sent_ = microsec_clock::universal_time();
     // Generate the MAC address to be passed in the packet.
-    uint8_t randomized = 0;
-    std::vector<uint8_t> mac_address = generateMacAddress(randomized);
+    std::vector<uint8_t> mac_address;
+    if (clients_) {
+        uint32_t client = 0;
+        if (!acquireClient(client, preload)) {
+            return;
+        }
+        mac_address = clients_->getMacAddress(client);
+    } else {
+        uint8_t randomized = 0;
+        mac_address = generateMacAddress(randomized);
+    }
     // Generate trasnaction id to be set for the new exchange.
     const uint32_t transid = generateTransid();
     Pkt4Ptr pkt4(new Pkt4(DHCPDISCOVER, transid));
@@ -1305,15 +1760,10 @@ TestControl::sendDiscover4(const TestControlSocket& socket,
     pkt4->addOption(Option::factory(Option::V4,
                                     DHO_DHCP_PARAMETER_REQUEST_LIST));
 
-    // Set client's and server's ports as well as server's address,
-    // and local (relay) address.
-    setDefaults4(socket, pkt4);
-
     // Set hardware address
     pkt4->setHWAddr(HTYPE_ETHER, mac_address.size(), mac_address);
 
-    pkt4->pack();
-    IfaceMgr::instance().send(pkt4);
+    sendPacket4(socket, pkt4);
     if (!preload) {
         if (!stats_mgr4_) {
             isc_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
@@ -1365,7 +1815,7 @@ TestControl::sendDiscover4(const TestControlSocket& socket,
     // Pack the input packet buffer to output buffer so as it can
     // be sent to server.
     pkt4->rawPack();
-    IfaceMgr::instance().send(boost::static_pointer_cast<Pkt4>(pkt4));
+    transmitPacket(boost::static_pointer_cast<Pkt4>(pkt4));
     if (!preload) {
         if (!stats_mgr4_) {
             isc_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
@@ -1378,6 +1828,135 @@ TestControl::sendDiscover4(const TestControlSocket& socket,
     saveFirstPacket(pkt4);
 }
 
+void
+TestControl::transmitPacket(const Pkt4Ptr& pkt) {
+    if (sender_) {
+        sender_->send(pkt);
+    } else {
+        IfaceMgr::instance().send(pkt);
+    }
+}
+
+void
+TestControl::transmitPacket(const Pkt6Ptr& pkt) {
+    if (sender_) {
+        sender_->send(pkt);
+    } else {
+        IfaceMgr::instance().send(pkt);
+    }
+}
+
+void
+TestControl::sendLease6(const TestControlSocket& socket,
+                        const uint32_t client, const uint8_t msg_type) {
+    Pkt6Ptr pkt6(new Pkt6(msg_type, generateTransid()));
+    pkt6->addOption(Option::factory(Option::V6, D6O_ELAPSED_TIME));
+    pkt6->addOption(Option::factory(Option::V6, D6O_CLIENTID,
+                                    getClientDuid(client)));
+    if (msg_type != DHCPV6_REBIND) {
+        pkt6->addOption(Option::factory(Option::V6, D6O_SERVERID,
+                                        lease_serverid_));
+    }
+    // The IAID is the same as in the IA_NA sent in the SOLICIT.
+    boost::shared_ptr<Option6IA> opt_ia_na(new Option6IA(D6O_IA_NA, 1));
+    opt_ia_na->addOption(OptionPtr(new Option6IAAddr(D6O_IAADDR,
+        IOAddress::fromBytes(AF_INET6, clients_->getAddress(client)), 0, 0)));
+    pkt6->addOption(opt_ia_na);
+
+    setDefaults6(socket, pkt6);
+    pkt6->pack();
+    transmitPacket(pkt6);
+
+    const uint64_t now = getClientTime();
+    switch (msg_type) {
+    case DHCPV6_RENEW:
+        stats_mgr6_->passSentPacket(StatsMgr6::XCHG_RN, pkt6);
+        break;
+    case DHCPV6_REBIND:
+        stats_mgr6_->passSentPacket(StatsMgr6::XCHG_RB, pkt6);
+        break;
+    case DHCPV6_RELEASE:
+        stats_mgr6_->passSentPacket(StatsMgr6::XCHG_RL, pkt6);
+        clients_->setState(client, ClientPool::RELEASING, now);
+        incrementCounter("release");
+        break;
+    default:
+        stats_mgr6_->passSentPacket(StatsMgr6::XCHG_DC, pkt6);
+        clients_->setState(client, ClientPool::DECLINING, now);
+        incrementCounter("decline");
+    }
+}
+
+void
+TestControl::sendPacket4(const TestControlSocket& socket,
+                         const Pkt4Ptr& pkt4) {
+    if (!CommandOptions::instance().isDhcp4o6()) {
+        // Set client's and server's ports as well as server's address,
+        // and local (relay) address.
+        setDefaults4(socket, pkt4);
+        pkt4->pack();
+        transmitPacket(pkt4);
+        return;
+    }
+
+    // Encapsulate the DHCPv4 message in DHCPV4-QUERY. Transaction id of
+    // the DHCPv6 message is 24 bits long, so only the low order bits of
+    // the DHCPv4 transaction id are copied.
+    pkt4->pack();
+    const util::OutputBuffer& buf = pkt4->getBuffer();
+    const uint8_t* data = static_cast<const uint8_t*>(buf.getData());
+    Pkt6Ptr pkt6(new Pkt6(DHCPV4_QUERY, pkt4->getTransid() & 0x00FFFFFF));
+    pkt6->addOption(OptionPtr(new Option(Option::V6, OPTION_DHCPV4_MSG,
+                                         OptionBuffer(data, data +
+                                                      buf.getLength()))));
+    setDefaults6(socket, pkt6);
+    pkt6->pack();
+    transmitPacket(pkt6);
+    pkt4->updateTimestamp();
+}
+
+void
+TestControl::sendRelease4(const TestControlSocket& socket,
+                          const uint32_t client, const bool decline) {
+    Pkt4Ptr pkt4(new Pkt4(decline ? DHCPDECLINE : DHCPRELEASE,
+                          generateTransid()));
+    const IOAddress address =
+        IOAddress::fromBytes(AF_INET, clients_->getAddress(client));
+    if (decline) {
+        OptionPtr opt_requested_address =
+            OptionPtr(new Option(Option::V4, DHO_DHCP_REQUESTED_ADDRESS,
+                                 OptionBuffer()));
+        opt_requested_address->setUint32(static_cast<uint32_t>(address));
+        pkt4->addOption(opt_requested_address);
+    } else {
+        pkt4->setCiaddr(address);
+    }
+    pkt4->addOption(Option::factory(Option::V4, DHO_DHCP_SERVER_IDENTIFIER,
+                                    lease_serverid_));
+    const std::vector<uint8_t> mac_address = clients_->getMacAddress(client);
+    pkt4->setHWAddr(HTYPE_ETHER, mac_address.size(), mac_address);
+    sendPacket4(socket, pkt4);
+
+    // There is no response to wait for.
+    clients_->setState(client, ClientPool::FREE, getClientTime());
+    incrementCounter(decline ? "decline" : "release");
+}
+
+void
+TestControl::sendRenew4(const TestControlSocket& socket,
+                        const uint32_t client, const bool rebind) {
+    Pkt4Ptr pkt4(new Pkt4(DHCPREQUEST, generateTransid()));
+    pkt4->setCiaddr(IOAddress::fromBytes(AF_INET,
+                                         clients_->getAddress(client)));
+    pkt4->addOption(Option::factory(Option::V4,
+                                    DHO_DHCP_PARAMETER_REQUEST_LIST));
+    const std::vector<uint8_t> mac_address = clients_->getMacAddress(client);
+    pkt4->setHWAddr(HTYPE_ETHER, mac_address.size(), mac_address);
+    sendPacket4(socket, pkt4);
+    stats_mgr4_->passSentPacket(rebind ? StatsMgr4::XCHG_RB :
+                                StatsMgr4::XCHG_RN, pkt4);
+}
+
 void
 TestControl::sendRequest4(const TestControlSocket& socket,
                           const dhcp::Pkt4Ptr& discover_pkt4,
@@ -1418,18 +1997,13 @@ TestControl::sendRequest4(const TestControlSocket& socket,
     OptionPtr opt_parameter_list =
         Option::factory(Option::V4, DHO_DHCP_PARAMETER_REQUEST_LIST);
     pkt4->addOption(opt_parameter_list);
-    // Set client's and server's ports as well as server's address,
-    // and local (relay) address.
-    setDefaults4(socket, pkt4);
 
     // Set hardware address
     pkt4->setHWAddr(offer_pkt4->getHWAddr());
     // Set elapsed time.
     uint32_t elapsed_time = getElapsedTime<Pkt4Ptr>(discover_pkt4, offer_pkt4);
     pkt4->setSecs(static_cast<uint16_t>(elapsed_time / 1000));
-    // Prepare on wire data to send.
-    pkt4->pack();
-    IfaceMgr::instance().send(pkt4);
+    sendPacket4(socket, pkt4);
     if (!stats_mgr4_) {
         isc_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
                   "hasn't been initialized");
@@ -1534,7 +2108,7 @@ TestControl::sendRequest4(const TestControlSocket& socket,
     setDefaults4(socket, boost::static_pointer_cast<Pkt4>(pkt4));
     // Prepare on-wire data.
     pkt4->rawPack();
-    IfaceMgr::instance().send(boost::static_pointer_cast<Pkt4>(pkt4));
+    transmitPacket(boost::static_pointer_cast<Pkt4>(pkt4));
     if (!stats_mgr4_) {
         isc_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
                   "hasn't been initialized");
@@ -1589,7 +2163,7 @@ TestControl::sendRequest6(const TestControlSocket& socket,
     setDefaults6(socket, pkt6);
     // Prepare on-wire data.
     pkt6->pack();
-    IfaceMgr::instance().send(pkt6);
+    transmitPacket(pkt6);
     if (!stats_mgr6_) {
         isc_throw(InvalidOperation, "Statistics Manager for DHCPv6 "
                   "hasn't been initialized");
@@ -1694,7 +2268,7 @@ TestControl::sendRequest6(const TestControlSocket& socket,
     // Prepare on wire data.
     pkt6->rawPack();
     // Send packet.
-    IfaceMgr::instance().send(pkt6);
+    transmitPacket(pkt6);
     if (!stats_mgr6_) {
         isc_throw(InvalidOperation, "Statistics Manager for DHCPv6 "
                   "hasn't been initialized");
@@ -1718,8 +2292,17 @@ TestControl::sendSolicit6(const TestControlSocket& socket,
                           const bool preload /*= false*/) {
     last_sent_ = microsec_clock::universal_time();
     // Generate DUID to be passed to the packet
-    uint8_t randomized = 0;
-    std::vector<uint8_t> duid = generateDuid(randomized);
+    std::vector<uint8_t> duid;
+    if (clients_) {
+        uint32_t client = 0;
+        if (!acquireClient(client, preload)) {
+            return;
+        }
+        duid = getClientDuid(client);
+    } else {
+        uint8_t randomized = 0;
+        duid = generateDuid(randomized);
+    }
     // Generate trasnaction id to be set for the new exchange.
     const uint32_t transid = generateTransid();
     Pkt6Ptr pkt6(new Pkt6(DHCPV6_SOLICIT, transid));
@@ -1736,7 +2319,7 @@ TestControl::sendSolicit6(const TestControlSocket& socket,
 
     setDefaults6(socket, pkt6);
     pkt6->pack();
-    IfaceMgr::instance().send(pkt6);
+    transmitPacket(pkt6);
     if (!preload) {
         if (!stats_mgr6_) {
             isc_throw(InvalidOperation, "Statistics Manager for DHCPv6 "
@@ -1781,7 +2364,7 @@ TestControl::sendSolicit6(const TestControlSocket& socket,
     pkt6->rawPack();
     setDefaults6(socket, pkt6);
     // Send solicit packet.
-    IfaceMgr::instance().send(pkt6);
+    transmitPacket(pkt6);
     if (!preload) {
         if (!stats_mgr6_) {
             isc_throw(InvalidOperation, "Statistics Manager for DHCPv6 "
@@ -1882,7 +2465,7 @@ TestControl::updateSendDue() {
     // microsecond timeouts in IfaceMgr.
     if (now > send_due_) {
         if (testDiags('i')) {
-            if (options.getIpVersion() == 4) {
+            if (options.isDhcp4()) {
                 stats_mgr4_->incrementCounter("latesend");
             } else if (options.getIpVersion() == 6) {
                 stats_mgr6_->incrementCounter("latesend");
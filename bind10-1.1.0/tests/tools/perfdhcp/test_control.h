@@ -15,6 +15,7 @@
 #ifndef TEST_CONTROL_H
 #define TEST_CONTROL_H
 
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -28,6 +29,10 @@
 #include <dhcp/pkt4.h>
 #include <dhcp/pkt6.h>
 
+#include "client_pool.h"
+#include "rate_control.h"
+#include "receiver.h"
+#include "sender.h"
 #include "stats_mgr.h"
 
 namespace isc {
@@ -432,6 +437,25 @@ protected:
         return (transid_gen_->generate());
     }
 
+    /// \brief Returns the time of the simulated clients.
+    ///
+    /// \return milliseconds since the pool of simulated clients (-M)
+    /// was created.
+    uint64_t getClientTime() const;
+
+    /// \brief Takes a free simulated client to initiate an exchange.
+    ///
+    /// \param [out] client index of the client.
+    /// \param preload preload mode, the failure is not counted.
+    /// \return false if all simulated clients are busy or have leases.
+    bool acquireClient(uint32_t& client, const bool preload);
+
+    /// \brief Returns the DUID of the simulated client.
+    ///
+    /// \param client index of the client.
+    /// \return DUID template ending with the MAC address of the client.
+    std::vector<uint8_t> getClientDuid(const uint32_t client) const;
+
     /// \brief Returns number of exchanges to be started.
     ///
     /// Method returns number of new exchanges to be started as soon
@@ -463,6 +487,12 @@ protected:
     /// odd number of hexadecimal digits.
     void initPacketTemplates();
 
+    /// \brief Increments the custom counter of the Statistics Manager.
+    ///
+    /// \param counter_key key of the counter.
+    /// \throw isc::BadValue if the counter doesn't exist.
+    void incrementCounter(const std::string& counter_key);
+
     /// \brief Initializes Statistics Manager.
     ///
     /// This function initializes Statistics Manager. If there is
@@ -492,9 +522,16 @@ protected:
     /// \brief Print intermediate statistics.
     ///
     /// Print brief statistics regarding number of sent packets,
-    /// received packets and dropped packets so far.
+    /// received packets and dropped packets so far and percentiles
+    /// of packet delays since the previous report. The statistics
+    /// are also written to the time series file if specified.
     void printIntermediateStats();
 
+    /// \brief Write statistics of the report interval to time series.
+    ///
+    /// Method does nothing if the time series file is not open.
+    void printTimeSeries();
+
     /// \brief Print rate statistics.
     ///
     /// Method print packet exchange rate statistics.
@@ -524,6 +561,19 @@ protected:
     void processReceivedPacket4(const TestControlSocket& socket,
                                 const dhcp::Pkt4Ptr& pkt4);
 
+    /// \brief Process received DHCPV4-RESPONSE packet.
+    ///
+    /// Method extracts the DHCPv4 message from the DHCPv4 Message option
+    /// of the DHCPV4-RESPONSE and processes it as the DHCPv4 packet
+    /// received directly. Other DHCPv6 messages and responses which
+    /// don't carry the valid DHCPv4 message are counted by the
+    /// "unexpected4o6" and "badresp4o6" custom counters respectively.
+    ///
+    /// \param [in] socket socket to be used.
+    /// \param [in] pkt6 object representing DHCPv6 packet received.
+    void processReceivedPacket4o6(const TestControlSocket& socket,
+                                  const dhcp::Pkt6Ptr& pkt6);
+
     /// \brief Process received DHCPv6 packet.
     ///
     /// Method performs processing of the received DHCPv6 packet,
@@ -541,6 +591,38 @@ protected:
     void processReceivedPacket6(const TestControlSocket& socket,
                                 const dhcp::Pkt6Ptr& pkt6);
 
+    /// \brief Process the lifecycle events of the simulated clients.
+    ///
+    /// Sends the RENEW, REBIND and RELEASE messages (or REQUEST and
+    /// DHCPRELEASE in the DHCPv4 case) of the clients whose timers
+    /// expired and counts the expired leases and timed out exchanges.
+    ///
+    /// \param socket socket to be used to send the messages.
+    void processClientEvents(const TestControlSocket& socket);
+
+    /// \brief Process DHCPv4 ACK or NAK sent to the simulated client.
+    ///
+    /// The response is passed to the Statistics Manager as the response
+    /// to the exchange the client is engaged in. The lease is recorded,
+    /// or the client becomes free in the case of NAK. A client whose
+    /// lease is new may decline it immediately (-U<decline-ratio>) or
+    /// be chosen to release it at T1 (-u<release-ratio>).
+    ///
+    /// \param socket socket to be used to send DHCPDECLINE.
+    /// \param pkt4 ACK or NAK packet.
+    void processLease4(const TestControlSocket& socket,
+                       const dhcp::Pkt4Ptr& pkt4);
+
+    /// \brief Process DHCPv6 REPLY sent to the simulated client.
+    ///
+    /// The DHCPv6 counterpart of \ref processLease4. The REPLY to the
+    /// RELEASE or DECLINE makes the client free.
+    ///
+    /// \param socket socket to be used to send DECLINE.
+    /// \param pkt6 REPLY packet.
+    void processLease6(const TestControlSocket& socket,
+                       const dhcp::Pkt6Ptr& pkt6);
+
     /// \brief Receive DHCPv4 or DHCPv6 packets from the server.
     ///
     /// Method receives DHCPv4 or DHCPv6 packets from the server.
@@ -684,6 +766,65 @@ protected:
                      const uint64_t packets_num,
                      const bool preload = false);
 
+    /// \brief Send DHCPv4 packet built by perfdhcp.
+    ///
+    /// In the DHCPv4 mode, the method sets the addresses and ports of
+    /// the packet and sends it. In the DHCPv4-over-DHCPv6 mode, the
+    /// DHCPv4 packet is packed into the DHCPv4 Message option of the
+    /// DHCPV4-QUERY which is sent to the server instead. The timestamp
+    /// of the DHCPv4 packet is updated so as the exchange latency can
+    /// be calculated.
+    ///
+    /// \param socket socket to be used to send message.
+    /// \param pkt4 DHCPv4 packet to be sent.
+    ///
+    /// \throw isc::dhcp::SocketWriteError if failed to send the packet.
+    void sendPacket4(const TestControlSocket& socket,
+                     const dhcp::Pkt4Ptr& pkt4);
+
+    /// \brief Send packed DHCPv4 packet.
+    ///
+    /// In the multi-threaded mode (-g<threads>) the packet is queued to
+    /// be sent with the batch, otherwise it is sent immediately by the
+    /// Interface Manager.
+    ///
+    /// \param pkt packet to be sent.
+    /// \throw isc::dhcp::SocketWriteError if failed to send the packet.
+    void transmitPacket(const dhcp::Pkt4Ptr& pkt);
+
+    /// \brief Send packed DHCPv6 packet.
+    ///
+    /// \param pkt packet to be sent.
+    /// \throw isc::dhcp::SocketWriteError if failed to send the packet.
+    void transmitPacket(const dhcp::Pkt6Ptr& pkt);
+
+    /// \brief Send DHCPv4 DHCPRELEASE or DHCPDECLINE message.
+    ///
+    /// The message of the simulated client carries the leased address
+    /// and the server identifier. The server doesn't respond, so the
+    /// client becomes free immediately.
+    ///
+    /// \param socket socket to be used to send message.
+    /// \param client index of the simulated client.
+    /// \param decline send DHCPDECLINE instead of DHCPRELEASE.
+    ///
+    /// \throw isc::dhcp::SocketWriteError if failed to send the packet.
+    void sendRelease4(const TestControlSocket& socket, const uint32_t client,
+                      const bool decline);
+
+    /// \brief Send DHCPv4 REQUEST message renewing the lease.
+    ///
+    /// The REQUEST of the simulated client in the RENEWING or REBINDING
+    /// state carries the leased address in the ciaddr field.
+    ///
+    /// \param socket socket to be used to send message.
+    /// \param client index of the simulated client.
+    /// \param rebind the client is rebinding rather than renewing.
+    ///
+    /// \throw isc::dhcp::SocketWriteError if failed to send the packet.
+    void sendRenew4(const TestControlSocket& socket, const uint32_t client,
+                    const bool rebind);
+
     /// \brief Send DHCPv4 REQUEST message.
     ///
     /// Method creates and sends DHCPv4 REQUEST message to the server.
@@ -719,6 +860,23 @@ protected:
                       const dhcp::Pkt4Ptr& discover_pkt4,
                       const dhcp::Pkt4Ptr& offer_pkt4);
 
+    /// \brief Send DHCPv6 message concerning the lease.
+    ///
+    /// Method sends the RENEW, REBIND, RELEASE or DECLINE message of
+    /// the simulated client with the following options:
+    /// - D6O_ELAPSED_TIME
+    /// - D6O_CLIENTID
+    /// - D6O_SERVERID (except for REBIND)
+    /// - D6O_IA_NA holding the leased address.
+    ///
+    /// \param socket socket to be used to send message.
+    /// \param client index of the simulated client.
+    /// \param msg_type type of the message.
+    ///
+    /// \throw isc::dhcp::SocketWriteError if failed to send the packet.
+    void sendLease6(const TestControlSocket& socket, const uint32_t client,
+                    const uint8_t msg_type);
+
     /// \brief Send DHCPv6 REQUEST message.
     ///
     /// Method creates and sends DHCPv6 REQUEST message to the server
@@ -964,15 +1122,29 @@ private:
 
     boost::posix_time::ptime last_report_; ///< Last intermediate report time.
 
+    std::ofstream time_series_; ///< Time series file (-y<file>).
+
     StatsMgr4Ptr stats_mgr4_;  ///< Statistics Manager 4.
     StatsMgr6Ptr stats_mgr6_;  ///< Statistics Manager 6.
 
+    ReceiverPtr receiver_;     ///< Receiving threads (-g<threads>).
+    SenderPtr sender_;         ///< Batch sender (-g<threads>).
+
     NumberGeneratorPtr transid_gen_; ///< Transaction id generator.
     NumberGeneratorPtr macaddr_gen_; ///< Numbers generator for MAC address.
 
     /// Buffer holding server id received in first packet
     dhcp::OptionBuffer first_packet_serverid_;
 
+    /// Simulated clients (-M<clients>).
+    ClientPoolPtr clients_;
+    /// Time at which the simulated clients were created (nanoseconds).
+    uint64_t clients_start_;
+    /// Server id sent with the last lease, used by the simulated clients.
+    dhcp::OptionBuffer lease_serverid_;
+    /// Buffer for the lifecycle events of the simulated clients.
+    std::vector<std::pair<uint32_t, ClientPool::Event> > client_events_;
+
     /// Packet template buffers.
     TemplateBufferCollection template_buffers_;
 
@@ -0,0 +1,203 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <exceptions/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include "../client_pool.h"
+
+#include <utility>
+#include <vector>
+
+using namespace isc;
+using namespace isc::perfdhcp;
+
+namespace {
+
+/// \brief Test fixture holding a pool of ten DHCPv4 clients.
+class ClientPoolTest : public ::testing::Test {
+public:
+    ClientPoolTest() {
+        const uint8_t mac[] = { 0x00, 0x0C, 0x01, 0x02, 0x03, 0x04 };
+        mac_template_.assign(mac, mac + sizeof(mac));
+        pool_.reset(new ClientPool(10, 4, mac_template_, 1000));
+    }
+
+    /// \brief Collects the events due at the time.
+    void getEvents(const uint64_t now) {
+        events_.clear();
+        pool_->getEvents(now, events_);
+    }
+
+    std::vector<uint8_t> mac_template_;
+    ClientPoolPtr pool_;
+    std::vector<std::pair<uint32_t, ClientPool::Event> > events_;
+};
+
+// Checks that invalid parameters are rejected.
+TEST_F(ClientPoolTest, constructor) {
+    EXPECT_THROW(ClientPool(0, 4, mac_template_, 1000), isc::BadValue);
+    EXPECT_THROW(ClientPool(10, 6, mac_template_, 1000), isc::BadValue);
+    EXPECT_THROW(ClientPool(10, 4, std::vector<uint8_t>(3, 0), 1000),
+                 isc::BadValue);
+
+    EXPECT_EQ(10, pool_->getSize());
+    EXPECT_EQ(10, pool_->getCount(ClientPool::FREE));
+    EXPECT_EQ(0, pool_->getCount(ClientPool::BOUND));
+}
+
+// Checks that the client is found by its MAC address or DUID.
+TEST_F(ClientPoolTest, identity) {
+    std::vector<uint8_t> mac = pool_->getMacAddress(0);
+    EXPECT_EQ(mac_template_, mac);
+
+    ClientPool pool(100000, 16, mac_template_, 1000);
+    mac = pool.getMacAddress(70000);
+    EXPECT_EQ(0x02 + 0x01, mac[3]);
+    EXPECT_EQ(0x03 + 0x11, mac[4]);
+    EXPECT_EQ(0x04 + 0x70, mac[5]);
+
+    uint32_t index = 0;
+    ASSERT_TRUE(pool.findClient(mac, index));
+    EXPECT_EQ(70000, index);
+
+    // The DUID ends with the MAC address.
+    std::vector<uint8_t> duid(8, 0xFF);
+    duid.insert(duid.end(), mac.begin(), mac.end());
+    index = 0;
+    ASSERT_TRUE(pool.findClient(duid, index));
+    EXPECT_EQ(70000, index);
+
+    // Addresses not belonging to the clients.
+    mac[0] = 0x01;
+    EXPECT_FALSE(pool.findClient(mac, index));
+    EXPECT_FALSE(pool.findClient(std::vector<uint8_t>(4, 0), index));
+    EXPECT_FALSE(pool_->findClient(pool.getMacAddress(10), index));
+}
+
+// Checks that the free clients are taken and returned.
+TEST_F(ClientPoolTest, acquire) {
+    uint32_t index = 100;
+    for (uint32_t i = 0; i < 10; ++i) {
+        ASSERT_TRUE(pool_->acquire(0, index));
+        EXPECT_EQ(i, index);
+        EXPECT_EQ(ClientPool::SELECTING, pool_->getState(index));
+    }
+    EXPECT_FALSE(pool_->acquire(0, index));
+    EXPECT_EQ(10, pool_->getCount(ClientPool::SELECTING));
+
+    pool_->setState(3, ClientPool::FREE, 0);
+    // Setting the state twice doesn't make the client available twice.
+    pool_->setState(3, ClientPool::FREE, 0);
+    ASSERT_TRUE(pool_->acquire(0, index));
+    EXPECT_EQ(3, index);
+    EXPECT_FALSE(pool_->acquire(0, index));
+
+    // The client which left the free state is not taken.
+    pool_->setState(4, ClientPool::FREE, 0);
+    pool_->setState(4, ClientPool::REQUESTING, 0);
+    EXPECT_FALSE(pool_->acquire(0, index));
+}
+
+// Checks that the clients waiting for the response give up.
+TEST_F(ClientPoolTest, timeout) {
+    uint32_t index = 0;
+    ASSERT_TRUE(pool_->acquire(0, index));
+    getEvents(900);
+    EXPECT_TRUE(events_.empty());
+
+    // The timeout is restarted when the REQUEST is sent.
+    pool_->setState(index, ClientPool::REQUESTING, 500);
+    getEvents(1200);
+    EXPECT_TRUE(events_.empty());
+    getEvents(1600);
+    ASSERT_EQ(1, events_.size());
+    EXPECT_EQ(index, events_[0].first);
+    EXPECT_EQ(ClientPool::TIMEOUT, events_[0].second);
+    EXPECT_EQ(ClientPool::FREE, pool_->getState(index));
+}
+
+// Checks the lifecycle of the lease.
+TEST_F(ClientPoolTest, lifecycle) {
+    uint32_t index = 0;
+    ASSERT_TRUE(pool_->acquire(0, index));
+    pool_->setState(index, ClientPool::REQUESTING, 0);
+    const uint8_t address[] = { 192, 0, 2, 1 };
+    pool_->bind(index, address, 10, 20, 30, false, 0);
+    EXPECT_EQ(ClientPool::BOUND, pool_->getState(index));
+    EXPECT_EQ(1, pool_->getCount(ClientPool::BOUND));
+    EXPECT_TRUE(std::equal(address, address + 4, pool_->getAddress(index)));
+
+    // The timeout of the REQUEST doesn't fire for the bound client.
+    getEvents(9900);
+    EXPECT_TRUE(events_.empty());
+
+    getEvents(10000);
+    ASSERT_EQ(1, events_.size());
+    EXPECT_EQ(ClientPool::RENEW, events_[0].second);
+    EXPECT_EQ(ClientPool::RENEWING, pool_->getState(index));
+
+    getEvents(20000);
+    ASSERT_EQ(1, events_.size());
+    EXPECT_EQ(ClientPool::REBIND, events_[0].second);
+    EXPECT_EQ(ClientPool::REBINDING, pool_->getState(index));
+
+    // The lease is extended while rebinding, the default T1 and T2
+    // are used.
+    pool_->bind(index, address, 0, 0, 80, false, 25000);
+    getEvents(60000);
+    EXPECT_TRUE(events_.empty());
+    getEvents(65000);
+    ASSERT_EQ(1, events_.size());
+    EXPECT_EQ(ClientPool::RENEW, events_[0].second);
+    getEvents(95000);
+    ASSERT_EQ(1, events_.size());
+    EXPECT_EQ(ClientPool::REBIND, events_[0].second);
+    getEvents(105000);
+    ASSERT_EQ(1, events_.size());
+    EXPECT_EQ(ClientPool::EXPIRE, events_[0].second);
+    EXPECT_EQ(ClientPool::FREE, pool_->getState(index));
+    EXPECT_EQ(10, pool_->getCount(ClientPool::FREE));
+}
+
+// Checks that the client releasing the lease stays bound until the
+// RELEASE is sent.
+TEST_F(ClientPoolTest, release) {
+    uint32_t index = 0;
+    ASSERT_TRUE(pool_->acquire(0, index));
+    const uint8_t address[] = { 192, 0, 2, 1 };
+    pool_->bind(index, address, 10, 20, 30, true, 0);
+
+    getEvents(10000);
+    ASSERT_EQ(1, events_.size());
+    EXPECT_EQ(ClientPool::RELEASE, events_[0].second);
+    EXPECT_EQ(ClientPool::BOUND, pool_->getState(index));
+
+    pool_->setState(index, ClientPool::RELEASING, 10000);
+    getEvents(11100);
+    ASSERT_EQ(1, events_.size());
+    EXPECT_EQ(ClientPool::TIMEOUT, events_[0].second);
+    EXPECT_EQ(ClientPool::FREE, pool_->getState(index));
+}
+
+// Checks that the names of the states are defined.
+TEST_F(ClientPoolTest, stateToString) {
+    EXPECT_EQ("free", ClientPool::stateToString(ClientPool::FREE));
+    EXPECT_EQ("bound", ClientPool::stateToString(ClientPool::BOUND));
+    EXPECT_EQ("declining", ClientPool::stateToString(ClientPool::DECLINING));
+}
+
+}
@@ -181,6 +181,40 @@ TEST_F(CommandOptionsTest, IpVersion) {
     EXPECT_THROW(process("perfdhcp -c -l ethx all"), isc::InvalidParameter);
 }
 
+TEST_F(CommandOptionsTest, Dhcp4o6) {
+    CommandOptions& opt = CommandOptions::instance();
+    EXPECT_FALSE(opt.isDhcp4o6());
+    EXPECT_NO_THROW(process("perfdhcp -4o6 -l ethx all"));
+    EXPECT_TRUE(opt.isDhcp4o6());
+    EXPECT_TRUE(opt.isDhcp4());
+    // DHCPv4 messages are sent over IPv6.
+    EXPECT_EQ(6, opt.getIpVersion());
+    EXPECT_EQ(ALL_DHCP_RELAY_AGENTS_AND_SERVERS, opt.getServerName());
+
+    // Other options may follow -4o6.
+    EXPECT_NO_THROW(process("perfdhcp -l ethx -4o6 -R 10 all"));
+    EXPECT_TRUE(opt.isDhcp4o6());
+    EXPECT_EQ(10, opt.getClientsNum());
+
+    process("perfdhcp -6 -l ethx all");
+    EXPECT_FALSE(opt.isDhcp4o6());
+    EXPECT_FALSE(opt.isDhcp4());
+
+    // Negative test cases
+    EXPECT_THROW(process("perfdhcp -4o6 -4o6 -l ethx all"),
+                 isc::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -4o6 -6 -l ethx all"),
+                 isc::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -4 -4o6 -l ethx all"),
+                 isc::InvalidParameter);
+    // Rapid Commit is the DHCPv6 option.
+    EXPECT_THROW(process("perfdhcp -4o6 -c -l ethx all"),
+                 isc::InvalidParameter);
+    // Templates hold DHCPv4 or DHCPv6 packets sent directly.
+    EXPECT_THROW(process("perfdhcp -4o6 -T file.x -l ethx all"),
+                 isc::InvalidParameter);
+}
+
 TEST_F(CommandOptionsTest, Rate) {
     CommandOptions& opt = CommandOptions::instance();
     EXPECT_NO_THROW(process("perfdhcp -4 -r 10 -l ethx all"));
@@ -453,6 +487,89 @@ TEST_F(CommandOptionsTest, Wrapped) {
                  isc::InvalidParameter);
 }
 
+TEST_F(CommandOptionsTest, Threads) {
+    CommandOptions& opt = CommandOptions::instance();
+    EXPECT_NO_THROW(process("perfdhcp -l ethx all"));
+    EXPECT_EQ(0, opt.getThreadsNum());
+    EXPECT_FALSE(opt.isPinThreads());
+
+    EXPECT_NO_THROW(process("perfdhcp -g 2 -G -l ethx all"));
+    EXPECT_EQ(2, opt.getThreadsNum());
+    EXPECT_TRUE(opt.isPinThreads());
+
+    // Negative test cases
+    EXPECT_THROW(process("perfdhcp -g 0 -l ethx all"),
+                 isc::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -g -l ethx all"),
+                 isc::InvalidParameter);
+    // -G requires -g
+    EXPECT_THROW(process("perfdhcp -G -l ethx all"),
+                 isc::InvalidParameter);
+}
+
+TEST_F(CommandOptionsTest, TimeSeries) {
+    CommandOptions& opt = CommandOptions::instance();
+    EXPECT_NO_THROW(process("perfdhcp -l ethx all"));
+    EXPECT_TRUE(opt.getTimeSeriesFile().empty());
+    EXPECT_EQ("csv", opt.getTimeSeriesFormat());
+
+    EXPECT_NO_THROW(process("perfdhcp -r 10 -t 1 -y stats.csv -l ethx all"));
+    EXPECT_EQ("stats.csv", opt.getTimeSeriesFile());
+    EXPECT_EQ("csv", opt.getTimeSeriesFormat());
+
+    EXPECT_NO_THROW(process("perfdhcp -r 10 -t 1 -y stats.json -Y json"
+                            " -l ethx all"));
+    EXPECT_EQ("stats.json", opt.getTimeSeriesFile());
+    EXPECT_EQ("json", opt.getTimeSeriesFormat());
+
+    // Negative test cases
+    // -y requires -t
+    EXPECT_THROW(process("perfdhcp -r 10 -y stats.csv -l ethx all"),
+                 isc::InvalidParameter);
+    // Unknown format
+    EXPECT_THROW(process("perfdhcp -r 10 -t 1 -y stats.xml -Y xml"
+                         " -l ethx all"),
+                 isc::InvalidParameter);
+}
+
+TEST_F(CommandOptionsTest, SimulatedClients) {
+    CommandOptions& opt = CommandOptions::instance();
+    EXPECT_NO_THROW(process("perfdhcp -l ethx all"));
+    EXPECT_EQ(0, opt.getSimulatedClientsNum());
+    EXPECT_EQ(0, opt.getReleaseRatio());
+    EXPECT_EQ(0, opt.getDeclineRatio());
+
+    EXPECT_NO_THROW(process("perfdhcp -r 100 -M 1000000 -u 10 -U 2.5"
+                            " -l ethx all"));
+    EXPECT_EQ(1000000, opt.getSimulatedClientsNum());
+    EXPECT_EQ(10, opt.getReleaseRatio());
+    EXPECT_EQ(2.5, opt.getDeclineRatio());
+
+    EXPECT_NO_THROW(process("perfdhcp -6 -M 100 -l ethx all"));
+    EXPECT_EQ(100, opt.getSimulatedClientsNum());
+
+    // Negative test cases
+    // The number of clients must be positive
+    EXPECT_THROW(process("perfdhcp -M 0 -l ethx all"),
+                 isc::InvalidParameter);
+    // The ratios are percentages
+    EXPECT_THROW(process("perfdhcp -M 10 -u 101 -l ethx all"),
+                 isc::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -M 10 -U -1 -l ethx all"),
+                 isc::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -M 10 -u 60 -U 50 -l ethx all"),
+                 isc::InvalidParameter);
+    // The ratios require -M
+    EXPECT_THROW(process("perfdhcp -u 10 -l ethx all"),
+                 isc::InvalidParameter);
+    // The whole exchange is required
+    EXPECT_THROW(process("perfdhcp -M 10 -i -l ethx all"),
+                 isc::InvalidParameter);
+    // The clients are not generated from the range
+    EXPECT_THROW(process("perfdhcp -M 10 -R 10 -l ethx all"),
+                 isc::InvalidParameter);
+}
+
 TEST_F(CommandOptionsTest, Diagnostics) {
     CommandOptions& opt = CommandOptions::instance();
     EXPECT_NO_THROW(process("perfdhcp -l ethx -i -x asTe all"));
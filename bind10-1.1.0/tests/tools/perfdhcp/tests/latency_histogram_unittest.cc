@@ -0,0 +1,138 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <exceptions/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include "../latency_histogram.h"
+
+using namespace isc;
+using namespace isc::perfdhcp;
+
+namespace {
+
+// Checks that the buckets are contiguous and their width grows with the
+// magnitude of the delay.
+TEST(LatencyHistogramTest, buckets) {
+    // Short delays have buckets of their own.
+    EXPECT_EQ(0, LatencyHistogram::getBucketIndex(0));
+    EXPECT_EQ(127, LatencyHistogram::getBucketIndex(127));
+    EXPECT_EQ(127, LatencyHistogram::getBucketMax(127));
+    // Then each bucket is 2 us wide, then 4 us etc.
+    EXPECT_EQ(128, LatencyHistogram::getBucketIndex(128));
+    EXPECT_EQ(128, LatencyHistogram::getBucketIndex(129));
+    EXPECT_EQ(129, LatencyHistogram::getBucketMax(128));
+    EXPECT_EQ(192, LatencyHistogram::getBucketIndex(256));
+    EXPECT_EQ(259, LatencyHistogram::getBucketMax(192));
+
+    uint64_t previous_max = 0;
+    for (int i = 1; i < LatencyHistogram::BUCKETS; ++i) {
+        const uint64_t max = LatencyHistogram::getBucketMax(i);
+        ASSERT_GT(max, previous_max);
+        // The first delay and the last delay fall into the bucket.
+        ASSERT_EQ(i, LatencyHistogram::getBucketIndex(previous_max + 1));
+        ASSERT_EQ(i, LatencyHistogram::getBucketIndex(max));
+        // The relative width of the bucket is bounded.
+        ASSERT_LE(max - previous_max - 1, (previous_max + 1) / 64);
+        previous_max = max;
+    }
+    EXPECT_EQ(LatencyHistogram::MAX_DELAY, previous_max);
+    // Longer delays are counted in the last bucket.
+    EXPECT_EQ(LatencyHistogram::BUCKETS - 1,
+              LatencyHistogram::getBucketIndex(LatencyHistogram::MAX_DELAY +
+                                               1000));
+}
+
+// Checks the percentiles of the recorded delays.
+TEST(LatencyHistogramTest, percentiles) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(0, histogram.getCount());
+    EXPECT_THROW(histogram.getPercentile(50), InvalidOperation);
+    EXPECT_THROW(histogram.getMin(), InvalidOperation);
+    EXPECT_THROW(histogram.getMax(), InvalidOperation);
+
+    // Delays of 1 to 10000 us.
+    for (int i = 1; i <= 10000; ++i) {
+        histogram.add(i / 1e6);
+    }
+    EXPECT_EQ(10000, histogram.getCount());
+    EXPECT_DOUBLE_EQ(1e-6, histogram.getMin());
+    EXPECT_DOUBLE_EQ(1e-2, histogram.getMax());
+    EXPECT_DOUBLE_EQ(1e-6, histogram.getPercentile(0));
+    EXPECT_DOUBLE_EQ(1e-2, histogram.getPercentile(100));
+
+    const double percentiles[] = { 1, 50, 90, 99, 99.9 };
+    for (int i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+        // Compare the delays in microseconds.
+        const double expected = percentiles[i] * 100;
+        const double delay = histogram.getPercentile(percentiles[i]) * 1e6;
+        EXPECT_GE(delay + 0.5, expected);
+        EXPECT_LE(delay, expected * (1 + 1. / 64));
+    }
+
+    EXPECT_THROW(histogram.getPercentile(-1), BadValue);
+    EXPECT_THROW(histogram.getPercentile(100.1), BadValue);
+
+    histogram.clear();
+    EXPECT_EQ(0, histogram.getCount());
+    EXPECT_THROW(histogram.getPercentile(50), InvalidOperation);
+}
+
+// Checks that the tail of the distribution is reported.
+TEST(LatencyHistogramTest, tail) {
+    LatencyHistogram histogram;
+    // 998 fast responses, 2 slow ones.
+    for (int i = 0; i < 998; ++i) {
+        histogram.add(0.0001);
+    }
+    histogram.add(0.5);
+    histogram.add(3);
+    EXPECT_DOUBLE_EQ(0.0001, histogram.getPercentile(99));
+    const double p999 = histogram.getPercentile(99.9);
+    EXPECT_GE(p999, 0.5);
+    EXPECT_LE(p999, 0.5 * (1 + 1. / 64));
+    EXPECT_DOUBLE_EQ(3, histogram.getPercentile(100));
+
+    // Negative and too long delays are clamped.
+    histogram.add(-1);
+    EXPECT_DOUBLE_EQ(0, histogram.getMin());
+    histogram.add(1e9);
+    EXPECT_DOUBLE_EQ(LatencyHistogram::MAX_DELAY / 1e6, histogram.getMax());
+}
+
+// Checks that the histograms are merged.
+TEST(LatencyHistogramTest, merge) {
+    LatencyHistogram histogram1;
+    LatencyHistogram histogram2;
+    histogram1.add(0.001);
+    histogram2.add(0.002);
+    histogram2.add(0.003);
+
+    histogram1.add(histogram2);
+    EXPECT_EQ(3, histogram1.getCount());
+    EXPECT_DOUBLE_EQ(0.001, histogram1.getMin());
+    EXPECT_DOUBLE_EQ(0.003, histogram1.getMax());
+    const double p50 = histogram1.getPercentile(50);
+    EXPECT_GE(p50, 0.002);
+    EXPECT_LE(p50, 0.002 * (1 + 1. / 64));
+
+    // Merging an empty histogram changes nothing.
+    histogram1.add(LatencyHistogram());
+    EXPECT_EQ(3, histogram1.getCount());
+    EXPECT_DOUBLE_EQ(0.001, histogram1.getMin());
+}
+
+}
@@ -0,0 +1,80 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <exceptions/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include "../rate_control.h"
+
+#include <unistd.h>
+
+using namespace isc;
+using namespace isc::perfdhcp;
+
+namespace {
+
+// Checks that the tokens are added at the specified rate.
+TEST(RateControlTest, rate) {
+    RateControl rate_control(1000, 100);
+    // The bucket holds one token initially, so the first exchange is
+    // initiated immediately.
+    EXPECT_EQ(1, rate_control.getOutboundMessageCount());
+
+    // Get the tokens added during 50ms in several steps. The fractions of
+    // tokens must be carried over, so about 50 tokens are expected in
+    // total. Allow for the inaccuracy of the sleep.
+    const uint64_t start = RateControl::currentTime();
+    uint64_t count = 0;
+    for (int i = 0; i < 50; ++i) {
+        usleep(1000);
+        count += rate_control.getOutboundMessageCount();
+    }
+    const uint64_t elapsed_ms = (RateControl::currentTime() - start) / 1000000;
+    EXPECT_GE(count + 1, elapsed_ms);
+    EXPECT_LE(count, elapsed_ms + 1);
+    EXPECT_FALSE(rate_control.isLate());
+}
+
+// Checks that the number of tokens is limited by the size of the bucket.
+TEST(RateControlTest, size) {
+    RateControl rate_control(1000, 5);
+    usleep(20000);
+    EXPECT_EQ(5, rate_control.getOutboundMessageCount());
+    EXPECT_TRUE(rate_control.isLate());
+    // The bucket was emptied.
+    EXPECT_GE(1, rate_control.getOutboundMessageCount());
+}
+
+// Checks that the size of the bucket is returned when the rate is not
+// limited.
+TEST(RateControlTest, unlimited) {
+    RateControl rate_control(0, 10);
+    EXPECT_EQ(10, rate_control.getOutboundMessageCount());
+    EXPECT_EQ(10, rate_control.getOutboundMessageCount());
+    EXPECT_FALSE(rate_control.isLate());
+
+    EXPECT_THROW(RateControl(100, 0), isc::BadValue);
+}
+
+// Checks that the monotonic clock doesn't go back.
+TEST(RateControlTest, currentTime) {
+    const uint64_t first = RateControl::currentTime();
+    usleep(1000);
+    const uint64_t second = RateControl::currentTime();
+    EXPECT_LE(first + 1000000, second);
+}
+
+}
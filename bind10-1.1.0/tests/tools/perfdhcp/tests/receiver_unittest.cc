@@ -0,0 +1,120 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/pkt4.h>
+
+#include <gtest/gtest.h>
+
+#include "../receiver.h"
+#include "../rate_control.h"
+
+#include <cstring>
+#include <set>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace isc;
+using namespace isc::dhcp;
+using namespace isc::perfdhcp;
+
+namespace {
+
+class ReceiverTest : public ::testing::Test {
+public:
+    /// \brief Opens the socket bound to the ephemeral port of the
+    /// loopback address.
+    ReceiverTest() {
+        socket_ = socket(AF_INET, SOCK_DGRAM, 0);
+        memset(&addr_, 0, sizeof(addr_));
+        addr_.sin_family = AF_INET;
+        addr_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr_);
+        bound_ = (socket_ >= 0) &&
+            (bind(socket_, reinterpret_cast<struct sockaddr*>(&addr_),
+                  sizeof(addr_)) == 0) &&
+            (getsockname(socket_, reinterpret_cast<struct sockaddr*>(&addr_),
+                         &len) == 0);
+    }
+
+    ~ReceiverTest() {
+        close(socket_);
+    }
+
+    /// \brief Sends the OFFER to the socket.
+    void sendOffer(const uint32_t transid) {
+        Pkt4 pkt(DHCPOFFER, transid);
+        pkt.pack();
+        sendto(socket_, pkt.getBuffer().getData(), pkt.getBuffer().getLength(),
+               0, reinterpret_cast<struct sockaddr*>(&addr_), sizeof(addr_));
+    }
+
+    int socket_;
+    struct sockaddr_in addr_;
+    bool bound_;
+};
+
+// Checks that the packets received by several threads are all taken
+// by the consumer.
+TEST_F(ReceiverTest, receive) {
+    ASSERT_TRUE(bound_);
+    Receiver receiver(socket_, AF_INET, 2, false);
+    EXPECT_FALSE(receiver.getPkt4());
+    receiver.start();
+
+    // Send the packets in small bursts not to overflow the receive
+    // buffer of the socket.
+    const uint32_t packets_num = 200;
+    for (uint32_t transid = 1; transid <= packets_num; ++transid) {
+        sendOffer(transid);
+        if (transid % 10 == 0) {
+            usleep(1000);
+        }
+    }
+
+    // Wait up to 5 seconds for the packets to be received.
+    std::set<uint32_t> transids;
+    const uint64_t deadline = RateControl::currentTime() + 5000000000ULL;
+    while ((transids.size() < packets_num) &&
+           (RateControl::currentTime() < deadline)) {
+        Pkt4Ptr pkt = receiver.getPkt4();
+        if (!pkt) {
+            usleep(1000);
+            continue;
+        }
+        // The packet is not unpacked by the receiver.
+        EXPECT_EQ(0, pkt->getTransid());
+        ASSERT_NO_THROW(pkt->unpack());
+        EXPECT_EQ(DHCPOFFER, pkt->getType());
+        transids.insert(pkt->getTransid());
+    }
+    receiver.stop();
+    EXPECT_EQ(packets_num, transids.size());
+    EXPECT_EQ(1, *transids.begin());
+    EXPECT_EQ(packets_num, *transids.rbegin());
+}
+
+// Checks that the invalid arguments are rejected.
+TEST_F(ReceiverTest, invalid) {
+    EXPECT_THROW(Receiver(socket_, AF_UNIX, 1, false), isc::BadValue);
+    EXPECT_THROW(Receiver(socket_, AF_INET, 0, false), isc::BadValue);
+    // The receiver can be stopped without being started.
+    Receiver receiver(socket_, AF_INET6, 1, true);
+    EXPECT_NO_THROW(receiver.stop());
+}
+
+}
@@ -0,0 +1,129 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <asiolink/io_address.h>
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+#include <dhcp/iface_mgr.h>
+
+#include <gtest/gtest.h>
+
+#include "../sender.h"
+
+#include <cstring>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace isc::perfdhcp;
+
+namespace {
+
+class SenderTest : public ::testing::Test {
+public:
+    /// \brief Opens the socket bound to the ephemeral port of the
+    /// loopback address.
+    SenderTest() : port_(0) {
+        socket_ = socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if ((socket_ >= 0) &&
+            (bind(socket_, reinterpret_cast<struct sockaddr*>(&addr),
+                  sizeof(addr)) == 0) &&
+            (getsockname(socket_, reinterpret_cast<struct sockaddr*>(&addr),
+                         &len) == 0)) {
+            port_ = ntohs(addr.sin_port);
+        }
+    }
+
+    ~SenderTest() {
+        close(socket_);
+    }
+
+    /// \brief Creates packed DISCOVER sent to the socket.
+    Pkt4Ptr createDiscover(const uint32_t transid) const {
+        Pkt4Ptr pkt(new Pkt4(DHCPDISCOVER, transid));
+        pkt->setRemoteAddr(IOAddress("127.0.0.1"));
+        pkt->setRemotePort(port_);
+        pkt->pack();
+        return (pkt);
+    }
+
+    /// \brief Reads the transaction id of the next packet in the socket.
+    ///
+    /// \return transaction id or 0 if there is no packet.
+    uint32_t receiveTransid() const {
+        uint8_t buf[1500];
+        const ssize_t len = recv(socket_, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len <= 0) {
+            return (0);
+        }
+        Pkt4 pkt(buf, len);
+        pkt.unpack();
+        return (pkt.getTransid());
+    }
+
+    int socket_;
+    uint16_t port_;
+};
+
+// Checks that the packets are sent when the batch is flushed.
+TEST_F(SenderTest, flush) {
+    ASSERT_NE(0, port_);
+    Sender sender(socket_);
+    for (uint32_t transid = 1; transid <= 3; ++transid) {
+        ASSERT_NO_THROW(sender.send(createDiscover(transid)));
+    }
+    EXPECT_EQ(3, sender.getQueuedNum());
+    EXPECT_EQ(0, receiveTransid());
+
+    ASSERT_NO_THROW(sender.flush());
+    EXPECT_EQ(0, sender.getQueuedNum());
+    for (uint32_t transid = 1; transid <= 3; ++transid) {
+        EXPECT_EQ(transid, receiveTransid());
+    }
+    EXPECT_EQ(0, receiveTransid());
+}
+
+// Checks that the full batch is sent immediately.
+TEST_F(SenderTest, fullBatch) {
+    ASSERT_NE(0, port_);
+    Sender sender(socket_);
+    for (uint32_t transid = 1; transid <= Sender::BATCH_SIZE + 1; ++transid) {
+        ASSERT_NO_THROW(sender.send(createDiscover(transid)));
+    }
+    EXPECT_EQ(1, sender.getQueuedNum());
+    for (uint32_t transid = 1; transid <= Sender::BATCH_SIZE; ++transid) {
+        ASSERT_EQ(transid, receiveTransid());
+    }
+    EXPECT_EQ(0, receiveTransid());
+}
+
+// Checks that the failure to send is reported.
+TEST_F(SenderTest, error) {
+    Sender sender(-1);
+    ASSERT_NO_THROW(sender.send(createDiscover(1)));
+    EXPECT_THROW(sender.flush(), SocketWriteError);
+    EXPECT_EQ(0, sender.getQueuedNum());
+}
+
+}
@@ -24,6 +24,11 @@
 
 #include "../stats_mgr.h"
 
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
 using namespace std;
 using namespace isc;
 using namespace isc::dhcp;
@@ -411,6 +416,74 @@ TEST_F(StatsMgrTest, CustomCounters) {
 
 }
 
+TEST_F(StatsMgrTest, Percentiles) {
+    boost::shared_ptr<StatsMgr6> stats_mgr(new StatsMgr6());
+    stats_mgr->addExchangeStats(StatsMgr6::XCHG_SA);
+    stats_mgr->addExchangeStats(StatsMgr6::XCHG_RR);
+    EXPECT_THROW(stats_mgr->getDelayPercentile(StatsMgr6::XCHG_SA, 50),
+                 InvalidOperation);
+
+    const int packets_num = 10;
+    passMultiplePackets6(stats_mgr, StatsMgr6::XCHG_SA, DHCPV6_SOLICIT,
+                         packets_num);
+    passMultiplePackets6(stats_mgr, StatsMgr6::XCHG_SA, DHCPV6_ADVERTISE,
+                         packets_num, true);
+    EXPECT_EQ(packets_num,
+              stats_mgr->getIntervalRcvdPacketsNum(StatsMgr6::XCHG_SA));
+    EXPECT_EQ(0, stats_mgr->getIntervalRcvdPacketsNum(StatsMgr6::XCHG_RR));
+    double p50 = 0;
+    double p999 = 0;
+    ASSERT_NO_THROW(
+        p50 = stats_mgr->getDelayPercentile(StatsMgr6::XCHG_SA, 50)
+    );
+    ASSERT_NO_THROW(
+        p999 = stats_mgr->getDelayPercentile(StatsMgr6::XCHG_SA, 99.9)
+    );
+    EXPECT_LE(p50, p999);
+    EXPECT_LE(p999, stats_mgr->getMaxDelay(StatsMgr6::XCHG_SA));
+    EXPECT_THROW(stats_mgr->getDelayPercentile(StatsMgr6::XCHG_SA, 101),
+                 BadValue);
+    EXPECT_NO_THROW(stats_mgr->printIntermediateStats());
+
+    // The time series holds a record for each exchange. The delays are
+    // missing for the exchange without received packets.
+    std::ostringstream csv;
+    StatsMgr6::printTimeSeriesHeader(csv);
+    stats_mgr->printTimeSeries(csv, false);
+    std::vector<std::string> lines;
+    std::istringstream csv_input(csv.str());
+    for (std::string line; std::getline(csv_input, line); ) {
+        lines.push_back(line);
+    }
+    ASSERT_EQ(3, lines.size());
+    EXPECT_EQ("time,exchange,sent,received,drops,interval_received,"
+              "p50_ms,p90_ms,p99_ms,p99.9_ms,max_ms", lines[0]);
+    EXPECT_NE(std::string::npos,
+              lines[1].find(",SOLICIT-ADVERTISE,10,10,0,10,"));
+    EXPECT_EQ(std::string::npos, lines[1].find(",,"));
+    EXPECT_NE(std::string::npos,
+              lines[2].find(",REQUEST-REPLY,0,0,0,0,,,,,"));
+
+    // The delays of the new report interval are empty, but the percentiles
+    // for the whole test are still there.
+    stats_mgr->resetInterval();
+    EXPECT_EQ(0, stats_mgr->getIntervalRcvdPacketsNum(StatsMgr6::XCHG_SA));
+    EXPECT_DOUBLE_EQ(p50,
+                     stats_mgr->getDelayPercentile(StatsMgr6::XCHG_SA, 50));
+    EXPECT_NO_THROW(stats_mgr->printIntermediateStats());
+
+    std::ostringstream json;
+    stats_mgr->printTimeSeries(json, true);
+    const std::string text = json.str();
+    EXPECT_NE(std::string::npos,
+              text.find("\"exchange\": \"SOLICIT-ADVERTISE\", \"sent\": 10,"
+                        " \"received\": 10, \"drops\": 0,"
+                        " \"interval_received\": 0, \"p50_ms\": null,"
+                        " \"p90_ms\": null, \"p99_ms\": null,"
+                        " \"p99.9_ms\": null, \"max_ms\": null}\n"));
+    EXPECT_EQ(2, std::count(text.begin(), text.end(), '\n'));
+}
+
 TEST_F(StatsMgrTest, PrintStats) {
     std::cout << "This unit test is checking statistics printing "
               << "capabilities. It is expected that some counters "
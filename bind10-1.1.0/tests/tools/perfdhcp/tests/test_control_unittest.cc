@@ -82,6 +82,7 @@ public:
     using TestControl::initializeStatsMgr;
     using TestControl::openSocket;
     using TestControl::processReceivedPacket4;
+    using TestControl::processReceivedPacket4o6;
     using TestControl::processReceivedPacket6;
     using TestControl::registerOptionFactories;
     using TestControl::sendDiscover4;
@@ -466,6 +467,49 @@ public:
         }
     }
 
+    /// \brief Test DHCPv4 exchanges carried in DHCPv6 messages.
+    ///
+    /// Function simulates DHCPv4-over-DHCPv6 exchanges. The OFFER
+    /// messages are returned in DHCPV4-RESPONSE messages for the first
+    /// receive_num exchanges. For the remaining exchanges, the malformed
+    /// DHCPV4-RESPONSE message is returned, which must be counted as
+    /// the packet drop.
+    ///
+    /// \param iterations_num number of exchanges to simulate.
+    /// \param receive_num number of received OFFER packets.
+    /// \param iterations_performed actual number of iterations.
+    void testPkt4o6Exchange(int iterations_num,
+                            int receive_num,
+                            int& iterations_performed) const {
+        int sock_handle = 0;
+        NakedTestControl tc;
+        tc.initializeStatsMgr();
+
+        TestControl::NumberGeneratorPtr
+            generator(new NakedTestControl::IncrementalGenerator());
+        tc.setTransidGenerator(generator);
+        ASSERT_NO_THROW(sock_handle = tc.openSocket());
+        TestControl::TestControlSocket sock(sock_handle);
+        uint32_t transid = 0;
+        for (int i = 0; i < iterations_num; ++i) {
+            ASSERT_NO_THROW(tc.sendDiscover4(sock));
+            ++transid;
+            boost::shared_ptr<Pkt6> response;
+            if (i < receive_num) {
+                response = createResponsePkt4o6(createOfferPkt4(transid));
+                ++transid;
+            } else {
+                response.reset(new Pkt6(DHCPV4_RESPONSE, 0));
+            }
+            ASSERT_NO_THROW(tc.processReceivedPacket4o6(sock, response));
+            if (tc.checkExitConditions()) {
+                iterations_performed = i + 1;
+                break;
+            }
+            iterations_performed = i + 1;
+        }
+    }
+
     /// \brief Test DHCPv6 exchanges.
     ///
     /// Function simulates DHCPv6 exchanges. Function caller specifies
@@ -639,6 +683,23 @@ private:
         return (offer);
     }
 
+    /// \brief Create DHCPV4-RESPONSE packet carrying DHCPv4 message.
+    ///
+    /// \param pkt4 DHCPv4 message to be carried.
+    /// \return instance of the packet.
+    boost::shared_ptr<Pkt6>
+    createResponsePkt4o6(const boost::shared_ptr<Pkt4>& pkt4) const {
+        pkt4->pack();
+        const uint8_t* data =
+            static_cast<const uint8_t*>(pkt4->getBuffer().getData());
+        OptionBuffer buf(data, data + pkt4->getBuffer().getLength());
+        boost::shared_ptr<Pkt6> response(new Pkt6(DHCPV4_RESPONSE, 0));
+        response->addOption(OptionPtr(new Option(Option::V6,
+                                                 OPTION_DHCPV4_MSG, buf)));
+        response->updateTimestamp();
+        return (response);
+    }
+
     /// \brief Create DHCPv6 ADVERTISE packet.
     ///
     /// \param transid transaction id.
@@ -1000,6 +1061,32 @@ TEST_F(TestControlTest, Packet6Exchange) {
     EXPECT_EQ(6, iterations_performed);
 }
 
+TEST_F(TestControlTest, Packet4o6Exchange) {
+    std::string loopback_iface(getLocalLoopback());
+    if (loopback_iface.empty()) {
+        std::cout << "Unable to find the loopback interface. Skip test."
+                  << std::endl;
+        return;
+    }
+
+    const int iterations_num = 100;
+    // The DHCPv4 exchanges are matched by the transaction id of the
+    // encapsulated messages, so all 10 exchanges are completed.
+    processCmdLine("perfdhcp -l " + loopback_iface
+                   + " -4o6 -r 100 -n 10 -R 20 -L 10547 ::1");
+    int iterations_performed = 0;
+    testPkt4o6Exchange(iterations_num, iterations_num, iterations_performed);
+    EXPECT_EQ(10, iterations_performed);
+
+    // The responses which don't carry the DHCPv4 message don't complete
+    // the exchanges, so the test is interrupted when 3 packets are
+    // dropped.
+    processCmdLine("perfdhcp -l " + loopback_iface
+                   + " -4o6 -r 100 -n 10 -R 20 -D 3 -L 10547 ::1");
+    testPkt4o6Exchange(iterations_num, 3, iterations_performed);
+    EXPECT_EQ(6, iterations_performed);
+}
+
 TEST_F(TestControlTest, PacketTemplates) {
     std::vector<uint8_t> template1(256);
     std::string file1("test1.hex");
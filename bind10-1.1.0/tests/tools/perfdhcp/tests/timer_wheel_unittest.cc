@@ -0,0 +1,89 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <exceptions/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include "../timer_wheel.h"
+
+#include <vector>
+
+using namespace isc;
+using namespace isc::perfdhcp;
+
+namespace {
+
+// Checks that the timers expire at their due ticks.
+TEST(TimerWheelTest, expire) {
+    EXPECT_THROW(TimerWheel(0), isc::BadValue);
+
+    TimerWheel wheel(8);
+    EXPECT_EQ(3, wheel.schedule(1, 3));
+    EXPECT_EQ(5, wheel.schedule(2, 5));
+    // The timer due in the past expires at the next tick.
+    EXPECT_EQ(1, wheel.schedule(3, 0));
+    EXPECT_EQ(3, wheel.size());
+
+    std::vector<TimerWheel::Timer> expired;
+    wheel.advance(2, expired);
+    ASSERT_EQ(1, expired.size());
+    EXPECT_EQ(3, expired[0].id_);
+    EXPECT_EQ(2, wheel.getCurrent());
+
+    // Going back in time does nothing.
+    expired.clear();
+    wheel.advance(1, expired);
+    EXPECT_TRUE(expired.empty());
+    EXPECT_EQ(2, wheel.getCurrent());
+
+    wheel.advance(5, expired);
+    ASSERT_EQ(2, expired.size());
+    EXPECT_EQ(1, expired[0].id_);
+    EXPECT_EQ(3, expired[0].due_);
+    EXPECT_EQ(2, expired[1].id_);
+    EXPECT_EQ(5, expired[1].due_);
+    EXPECT_EQ(0, wheel.size());
+}
+
+// Checks that the timers due later than one turn of the wheel stay in
+// the wheel until they are due.
+TEST(TimerWheelTest, turnAround) {
+    TimerWheel wheel(8);
+    wheel.schedule(1, 4);
+    wheel.schedule(2, 12);
+    wheel.schedule(3, 100);
+
+    std::vector<TimerWheel::Timer> expired;
+    wheel.advance(4, expired);
+    ASSERT_EQ(1, expired.size());
+    EXPECT_EQ(1, expired[0].id_);
+
+    expired.clear();
+    wheel.advance(11, expired);
+    EXPECT_TRUE(expired.empty());
+    wheel.advance(12, expired);
+    ASSERT_EQ(1, expired.size());
+    EXPECT_EQ(2, expired[0].id_);
+
+    // Advancing by many turns at once inspects every slot.
+    expired.clear();
+    wheel.advance(1000, expired);
+    ASSERT_EQ(1, expired.size());
+    EXPECT_EQ(3, expired[0].id_);
+    EXPECT_EQ(0, wheel.size());
+}
+
+}
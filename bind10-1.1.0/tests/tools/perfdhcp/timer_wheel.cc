@@ -0,0 +1,71 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <exceptions/exceptions.h>
+
+#include "timer_wheel.h"
+
+namespace isc {
+namespace perfdhcp {
+
+TimerWheel::TimerWheel(const uint32_t slots)
+    : current_(0), size_(0) {
+    if (slots == 0) {
+        isc_throw(isc::BadValue, "number of timer wheel slots must be"
+                  " positive");
+    }
+    slots_.resize(slots);
+}
+
+uint32_t
+TimerWheel::schedule(const uint32_t id, const uint32_t due) {
+    Timer timer;
+    timer.id_ = id;
+    timer.due_ = (due > current_) ? due : current_ + 1;
+    slots_[timer.due_ % slots_.size()].push_back(timer);
+    ++size_;
+    return (timer.due_);
+}
+
+void
+TimerWheel::advance(const uint32_t now, std::vector<Timer>& expired) {
+    if (now <= current_) {
+        return;
+    }
+    // All slots are inspected at most once, even if the wheel turned
+    // around more than once since the last call.
+    uint32_t ticks = now - current_;
+    if (ticks > slots_.size()) {
+        ticks = slots_.size();
+    }
+    for (uint32_t tick = current_ + 1; ticks > 0; ++tick, --ticks) {
+        std::vector<Timer>& slot = slots_[tick % slots_.size()];
+        // Move the expired timers out and compact the remaining ones.
+        size_t kept = 0;
+        for (size_t i = 0; i < slot.size(); ++i) {
+            if (slot[i].due_ <= now) {
+                expired.push_back(slot[i]);
+                --size_;
+            } else {
+                slot[kept++] = slot[i];
+            }
+        }
+        slot.resize(kept);
+    }
+    current_ = now;
+}
+
+} // namespace perfdhcp
+} // namespace isc
@@ -0,0 +1,88 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace perfdhcp {
+
+/// \brief Hashed timer wheel.
+///
+/// The wheel schedules a large number of timers identified by numbers
+/// (e.g. indexes of the simulated clients). The time is measured in ticks
+/// and a timer due at the tick N is stored in the slot N modulo the number
+/// of slots. When the wheel is advanced, only the slots of the elapsed
+/// ticks are inspected, so the cost of scheduling and expiring a timer
+/// doesn't depend on the number of timers. Timers due later than the
+/// number of slots ahead stay in their slots until the wheel turns
+/// around enough times.
+///
+/// Timers can't be cancelled. The owner of the timers is expected to
+/// ignore expired timers it is no longer interested in (e.g. by
+/// comparing the due tick with the one it remembers).
+class TimerWheel {
+public:
+    /// \brief Timer stored in the wheel.
+    struct Timer {
+        /// Identifier of the timer.
+        uint32_t id_;
+        /// Tick at which the timer expires.
+        uint32_t due_;
+    };
+
+    /// \brief Constructor.
+    ///
+    /// \param slots number of slots.
+    /// \throw isc::BadValue if the number of slots is 0.
+    TimerWheel(const uint32_t slots);
+
+    /// \brief Schedules a timer.
+    ///
+    /// \param id identifier of the timer.
+    /// \param due tick at which the timer expires. Timers due at the
+    /// current tick or earlier expire at the next tick.
+    /// \return tick at which the timer will expire.
+    uint32_t schedule(const uint32_t id, const uint32_t due);
+
+    /// \brief Advances the wheel and collects expired timers.
+    ///
+    /// \param now current tick.
+    /// \param [out] expired vector the expired timers are appended to.
+    void advance(const uint32_t now, std::vector<Timer>& expired);
+
+    /// \brief Returns the tick the wheel has been advanced to.
+    uint32_t getCurrent() const { return (current_); }
+
+    /// \brief Returns the number of scheduled timers.
+    size_t size() const { return (size_); }
+
+private:
+    /// Timers stored in each slot.
+    std::vector<std::vector<Timer> > slots_;
+    /// Tick the wheel has been advanced to.
+    uint32_t current_;
+    /// Number of scheduled timers.
+    size_t size_;
+};
+
+} // namespace perfdhcp
+} // namespace isc
+
+#endif // TIMER_WHEEL_H